@@ -7,6 +7,7 @@
 //   bun bench.ts --quick            Timing only for AssemblyClaw static analysis (comparators still measured)
 //   bun bench.ts --no-export        Full suite without JSON export
 //   bun bench.ts --no-comparators   Benchmark AssemblyClaw only
+//   bun bench.ts --kernels          SIMD kernels only (runs on Linux x86-64 too)
 //
 // Optional env:
 //   CCLAW_REPO_URL=<git-url>        Override default CClaw upstream repo URL
@@ -29,6 +30,8 @@ const BENCH_KERNEL_JSON_JSON = "./build/bench.kernel.json.hyperfine.json";
 const BENCH_SITE_JSON = "./site/public/benchmarks.json";
 const BENCH_KERNEL_SRC = "./tests/bench_kernels.c";
 const BENCH_KERNEL_BIN = "./build/bench_kernels";
+const BENCH_KERNEL_X86_SRCS = ["./src/x86_64/string.S", "./src/x86_64/json.S"];
+const KERNEL_X86 = process.platform === "linux" && process.arch === "x64";
 
 const COMPARATOR_ROOT = "./build/comparators";
 const OPENCLAW_PKG_DIR = join(COMPARATOR_ROOT, "openclaw-pkg");
@@ -45,6 +48,7 @@ const targets = { binaryKB: 32, rssKB: 128, startupMs: 0.1 } as const;
 const quick = Bun.argv.includes("--quick");
 const doExport = !Bun.argv.includes("--no-export");
 const doComparators = !Bun.argv.includes("--no-comparators");
+const kernelsOnly = Bun.argv.includes("--kernels");
 
 const bold = (s: string) => `\x1b[1m${s}\x1b[0m`;
 const green = (s: string) => `\x1b[32m${s}\x1b[0m`;
@@ -514,6 +518,20 @@ async function prepareCClawComparator(): Promise<{
 }
 
 async function prepareKernelBenchHarness(): Promise<string> {
+  await $`mkdir -p build`.quiet();
+  if (KERNEL_X86) {
+    // SSE2/AVX2 ports; the scalar baselines are pinned to -O0 in the source
+    await runInherit([
+      "cc",
+      "-O3",
+      "-fno-tree-vectorize",
+      "-o",
+      BENCH_KERNEL_BIN,
+      BENCH_KERNEL_SRC,
+      ...BENCH_KERNEL_X86_SRCS,
+    ]);
+    return BENCH_KERNEL_BIN;
+  }
   await runInherit([
     "clang",
     "-arch",
@@ -530,9 +548,98 @@ async function prepareKernelBenchHarness(): Promise<string> {
   return BENCH_KERNEL_BIN;
 }
 
+let kernelStrlenSimdMs: number | null = null;
+let kernelStrlenScalarMs: number | null = null;
+let kernelStrlenSpeedup: number | null = null;
+let kernelJsonSimdMs: number | null = null;
+let kernelJsonScalarMs: number | null = null;
+let kernelJsonSpeedup: number | null = null;
+
+type KernelIsaResult = {
+  sse2: number | null;
+  avx2: number | null;
+  scalar: number | null;
+};
+const kernelIsaResults = new Map<string, KernelIsaResult>();
+
+async function runKernelBenchmarks() {
+  section("Assembly Kernel Benchmarks");
+  const kernelHarness = await prepareKernelBenchHarness();
+  metric("Harness", kernelHarness);
+
+  section("Kernel Throughput (strlen 32KB)");
+  await bench(
+    hyperfinePath,
+    [
+      { name: "strlen_simd", args: commandString([kernelHarness, "strlen-simd"]) },
+      { name: "strlen_scalar", args: commandString([kernelHarness, "strlen-scalar"]) },
+    ],
+    BENCH_KERNEL_STRLEN_JSON
+  );
+  const kernelStrlenMeans = await readHyperfineMeans(BENCH_KERNEL_STRLEN_JSON);
+  kernelStrlenSimdMs = kernelStrlenMeans.get("strlen_simd") ?? null;
+  kernelStrlenScalarMs = kernelStrlenMeans.get("strlen_scalar") ?? null;
+  kernelStrlenSpeedup = computeSpeedup(kernelStrlenScalarMs, kernelStrlenSimdMs);
+  metric("SIMD", formatNullableMs(kernelStrlenSimdMs));
+  metric("Scalar baseline", formatNullableMs(kernelStrlenScalarMs));
+  metric("Speedup", formatSpeedup(kernelStrlenSpeedup));
+
+  section("Kernel Throughput (json_find_key 4KB)");
+  await bench(
+    hyperfinePath,
+    [
+      { name: "json_simd", args: commandString([kernelHarness, "json-simd"]) },
+      { name: "json_scalar", args: commandString([kernelHarness, "json-scalar"]) },
+    ],
+    BENCH_KERNEL_JSON_JSON
+  );
+  const kernelJsonMeans = await readHyperfineMeans(BENCH_KERNEL_JSON_JSON);
+  kernelJsonSimdMs = kernelJsonMeans.get("json_simd") ?? null;
+  kernelJsonScalarMs = kernelJsonMeans.get("json_scalar") ?? null;
+  kernelJsonSpeedup = computeSpeedup(kernelJsonScalarMs, kernelJsonSimdMs);
+  metric("SIMD parser", formatNullableMs(kernelJsonSimdMs));
+  metric("Scalar baseline", formatNullableMs(kernelJsonScalarMs));
+  metric("Speedup", formatSpeedup(kernelJsonSpeedup));
+
+  if (KERNEL_X86) await runKernelIsaBenchmarks(kernelHarness);
+}
+
+// x86-64 only: each kernel per instruction set against the scalar baseline.
+// The harness exits 77 for an instruction set the CPU does not support.
+async function runKernelIsaBenchmarks(kernelHarness: string) {
+  const hasAvx2 = Bun.spawnSync([kernelHarness, "strlen-avx2"]).exitCode === 0;
+  for (const kernel of ["strlen", "strcmp", "memcpy", "json"]) {
+    const exportJson = `./build/bench.kernel.${kernel}.isa.hyperfine.json`;
+    const variants = hasAvx2 ? ["sse2", "avx2", "scalar"] : ["sse2", "scalar"];
+
+    section(`Kernel Instruction Sets (${kernel})`);
+    await bench(
+      hyperfinePath,
+      variants.map((variant) => ({
+        name: `${kernel}_${variant}`,
+        args: commandString([kernelHarness, `${kernel}-${variant}`]),
+      })),
+      exportJson
+    );
+    const means = await readHyperfineMeans(exportJson);
+    const result: KernelIsaResult = {
+      sse2: means.get(`${kernel}_sse2`) ?? null,
+      avx2: means.get(`${kernel}_avx2`) ?? null,
+      scalar: means.get(`${kernel}_scalar`) ?? null,
+    };
+    kernelIsaResults.set(kernel, result);
+    metric("SSE2", formatNullableMs(result.sse2));
+    if (hasAvx2) metric("AVX2", formatNullableMs(result.avx2));
+    else warn("AVX2", "not supported by this CPU");
+    metric("Scalar baseline", formatNullableMs(result.scalar));
+    metric("Speedup (SSE2)", formatSpeedup(computeSpeedup(result.scalar, result.sse2)));
+    if (hasAvx2) metric("Speedup (AVX2 vs SSE2)", formatSpeedup(computeSpeedup(result.sse2, result.avx2)));
+  }
+}
+
 const hyperfinePath = await findHyperfine();
 
-if (!(await Bun.file(BINARY).exists())) {
+if (!kernelsOnly && !(await Bun.file(BINARY).exists())) {
   console.log("Binary not found. Building...");
   await runInherit(["ninja"]);
 }
@@ -558,6 +665,11 @@ console.log(bold(`  ${arch} / ${cpu}`));
 console.log(bold(`  hyperfine ${hyperfineVersion}`));
 console.log(bold("═══════════════════════════════════════════════════════"));
 
+if (kernelsOnly) {
+  await runKernelBenchmarks();
+  process.exit(0);
+}
+
 section("Startup Time");
 console.log();
 await bench(hyperfinePath, [{ name: "assemblyclaw --help", args: `${BINARY} --help` }]);
@@ -682,50 +794,7 @@ let assemblyComparatorStartupMs: number | null = null;
 let assemblyComparatorVersionMs: number | null = null;
 let assemblyComparatorInvalidFlagMs: number | null = null;
 
-let kernelStrlenSimdMs: number | null = null;
-let kernelStrlenScalarMs: number | null = null;
-let kernelStrlenSpeedup: number | null = null;
-let kernelJsonSimdMs: number | null = null;
-let kernelJsonScalarMs: number | null = null;
-let kernelJsonSpeedup: number | null = null;
-
-section("Assembly Kernel Benchmarks");
-const kernelHarness = await prepareKernelBenchHarness();
-metric("Harness", kernelHarness);
-
-section("Kernel Throughput (strlen 32KB)");
-await bench(
-  hyperfinePath,
-  [
-    { name: "strlen_simd", args: commandString([kernelHarness, "strlen-simd"]) },
-    { name: "strlen_scalar", args: commandString([kernelHarness, "strlen-scalar"]) },
-  ],
-  BENCH_KERNEL_STRLEN_JSON
-);
-const kernelStrlenMeans = await readHyperfineMeans(BENCH_KERNEL_STRLEN_JSON);
-kernelStrlenSimdMs = kernelStrlenMeans.get("strlen_simd") ?? null;
-kernelStrlenScalarMs = kernelStrlenMeans.get("strlen_scalar") ?? null;
-kernelStrlenSpeedup = computeSpeedup(kernelStrlenScalarMs, kernelStrlenSimdMs);
-metric("SIMD", formatNullableMs(kernelStrlenSimdMs));
-metric("Scalar baseline", formatNullableMs(kernelStrlenScalarMs));
-metric("Speedup", formatSpeedup(kernelStrlenSpeedup));
-
-section("Kernel Throughput (json_find_key 4KB)");
-await bench(
-  hyperfinePath,
-  [
-    { name: "json_simd", args: commandString([kernelHarness, "json-simd"]) },
-    { name: "json_scalar", args: commandString([kernelHarness, "json-scalar"]) },
-  ],
-  BENCH_KERNEL_JSON_JSON
-);
-const kernelJsonMeans = await readHyperfineMeans(BENCH_KERNEL_JSON_JSON);
-kernelJsonSimdMs = kernelJsonMeans.get("json_simd") ?? null;
-kernelJsonScalarMs = kernelJsonMeans.get("json_scalar") ?? null;
-kernelJsonSpeedup = computeSpeedup(kernelJsonScalarMs, kernelJsonSimdMs);
-metric("SIMD parser", formatNullableMs(kernelJsonSimdMs));
-metric("Scalar baseline", formatNullableMs(kernelJsonScalarMs));
-metric("Speedup", formatSpeedup(kernelJsonSpeedup));
+await runKernelBenchmarks();
 
 if (doComparators) {
   section("Comparator Setup");
@@ -1072,6 +1141,7 @@ if (doExport) {
         scalar: kernelJsonScalarMs,
         speedup: kernelJsonSpeedup,
       },
+      kernel_isa_ms: kernelIsaResults.size > 0 ? Object.fromEntries(kernelIsaResults) : null,
     },
     status: {
       binary_target_met: assemblyBinaryKB <= targets.binaryKB,
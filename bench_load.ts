@@ -0,0 +1,575 @@
+#!/usr/bin/env bun
+// CClaw End-to-End Load Benchmark
+//
+// Starts a local OpenAI/Anthropic-compatible mock server, points cclaw at it
+// and drives N concurrent multi-turn conversations through the CLI channel
+// (one interactive `cclaw agent` process per conversation). Optionally drives
+// the webhook gateway as well.
+//
+// Usage:
+//   bun bench_load.ts                         Defaults: 8 conversations x 10 turns
+//   bun bench_load.ts --conversations 32      Concurrent conversations
+//   bun bench_load.ts --turns 20              Turns per conversation
+//   bun bench_load.ts --provider anthropic    Mock wire format (openai|anthropic)
+//   bun bench_load.ts --latency-ms 200        Mock time-to-first-byte per request
+//   bun bench_load.ts --token-ms 5            Mock delay between streamed tokens
+//   bun bench_load.ts --tokens 64             Tokens per mock reply
+//   bun bench_load.ts --tool-calls 2          Tool-call replies before final answer
+//   bun bench_load.ts --webhook-url <url>     Also load a running webhook gateway
+//   bun bench_load.ts --bin <path>            cclaw binary (default: context/cclaw-main/bin/cclaw)
+//   bun bench_load.ts --no-export             Skip JSON export
+//
+// Reports turns/sec, p50/p99 time to first token and turn latency, peak RSS
+// and allocations per turn (via tests/bench_alloc_shim.c, preloaded). The CLI
+// prints streamed replies as tokens arrive, so the reply header reaches
+// stdout with the first token. Providers that cannot stream (anthropic here)
+// print the reply at turn end, and their first token is the turn latency.
+// Each conversation gets its own HOME, so their memory and session stores do
+// not contend.
+
+import { $ } from "bun";
+import { join } from "node:path";
+
+const CCLAW_DIR = "./context/cclaw-main";
+const DEFAULT_BIN = join(CCLAW_DIR, "bin", "cclaw");
+const SHIM_SRC = "./tests/bench_alloc_shim.c";
+const SHIM_LIB = process.platform === "darwin" ? "./build/bench_alloc_shim.dylib" : "./build/bench_alloc_shim.so";
+const BENCH_LOAD_JSON = "./build/bench.load.json";
+
+// Matches print_user_prompt() / print_assistant_response() in runtime/agent_loop.c
+const PROMPT_MARKER = "\x1b[1m>\x1b[0m ";
+const REPLY_MARKER = "\x1b[32mAgent:\x1b[0m";
+
+const green = (s: string) => `\x1b[32m${s}\x1b[0m`;
+const yellow = (s: string) => `\x1b[33m${s}\x1b[0m`;
+const cyan = (s: string) => `\x1b[36m${s}\x1b[0m`;
+const dim = (s: string) => `\x1b[2m${s}\x1b[0m`;
+
+const section = (title: string) => console.log(`\n${cyan(`── ${title} ──`)}`);
+const metric = (label: string, value: string) =>
+  console.log(`  ${label.padEnd(30)} ${green(value)}`);
+const warn = (label: string, value: string) =>
+  console.log(`  ${label.padEnd(30)} ${yellow(value)}`);
+
+// ── Options ──
+
+function argValue(name: string): string | undefined {
+  const i = Bun.argv.indexOf(name);
+  return i >= 0 && i + 1 < Bun.argv.length ? Bun.argv[i + 1] : undefined;
+}
+
+function argInt(name: string, fallback: number): number {
+  const raw = argValue(name);
+  if (raw === undefined) return fallback;
+  const n = Number.parseInt(raw, 10);
+  if (!Number.isFinite(n) || n < 0) throw new Error(`invalid value for ${name}: ${raw}`);
+  return n;
+}
+
+type WireFormat = "openai" | "anthropic";
+
+const opts = {
+  conversations: argInt("--conversations", 8),
+  turns: argInt("--turns", 10),
+  provider: (argValue("--provider") ?? "openai") as WireFormat,
+  latencyMs: argInt("--latency-ms", 50),
+  tokenMs: argInt("--token-ms", 2),
+  tokens: argInt("--tokens", 32),
+  toolCalls: argInt("--tool-calls", 0),
+  webhookUrl: argValue("--webhook-url"),
+  bin: argValue("--bin") ?? DEFAULT_BIN,
+  exportJson: !Bun.argv.includes("--no-export"),
+};
+
+if (opts.provider !== "openai" && opts.provider !== "anthropic") {
+  throw new Error(`--provider must be openai or anthropic, got ${opts.provider}`);
+}
+
+// ── Stats ──
+
+function percentile(sorted: number[], p: number): number {
+  if (sorted.length === 0) return Number.NaN;
+  const idx = Math.min(sorted.length - 1, Math.max(0, Math.ceil((p / 100) * sorted.length) - 1));
+  return sorted[idx];
+}
+
+function summarize(samples: number[]) {
+  const sorted = [...samples].sort((a, b) => a - b);
+  const mean = sorted.reduce((acc, v) => acc + v, 0) / (sorted.length || 1);
+  return {
+    count: sorted.length,
+    mean: round(mean, 3),
+    p50: round(percentile(sorted, 50), 3),
+    p99: round(percentile(sorted, 99), 3),
+    max: round(sorted[sorted.length - 1] ?? Number.NaN, 3),
+  };
+}
+
+function round(value: number, places: number): number {
+  const factor = 10 ** places;
+  return Math.round(value * factor) / factor;
+}
+
+const sleep = (ms: number) => new Promise<void>((resolve) => setTimeout(resolve, ms));
+
+// ── Mock LLM server ──
+//
+// Speaks enough of the OpenAI chat/completions and Anthropic messages APIs for
+// cclaw's providers. Honors "stream": true with SSE. When --tool-calls is set,
+// the first K replies after each user message are tool calls, then a final
+// text answer, so multi-iteration agent turns can be exercised.
+
+type MockStats = { requests: number; streamed: number; toolCallReplies: number; bytesIn: number };
+
+function mockText(tokens: number, seq: number): string[] {
+  const words: string[] = [];
+  for (let i = 0; i < tokens; i++) words.push(i === 0 ? `reply-${seq}` : ` tok${i}`);
+  return words;
+}
+
+// Number of assistant tool-call replies since the last user message.
+function toolCallsSinceUser(messages: any[]): number {
+  let n = 0;
+  for (let i = messages.length - 1; i >= 0; i--) {
+    const m = messages[i];
+    if (m?.role === "user" && typeof m.content === "string") break;
+    if (m?.role === "assistant" && (m.tool_calls || (Array.isArray(m.content) && m.content.some((b: any) => b?.type === "tool_use")))) n++;
+  }
+  return n;
+}
+
+function openaiReply(model: string, seq: number, words: string[], toolCall: boolean) {
+  const message: Record<string, unknown> = { role: "assistant", content: toolCall ? null : words.join("") };
+  if (toolCall) {
+    message.tool_calls = [{
+      id: `call_${seq}`,
+      type: "function",
+      function: { name: "memory_recall", arguments: JSON.stringify({ query: `bench ${seq}`, limit: 5 }) },
+    }];
+  }
+  return {
+    id: `chatcmpl-${seq}`,
+    object: "chat.completion",
+    created: Math.floor(Date.now() / 1000),
+    model,
+    choices: [{ index: 0, message, finish_reason: toolCall ? "tool_calls" : "stop" }],
+    usage: { prompt_tokens: 16, completion_tokens: words.length, total_tokens: 16 + words.length },
+  };
+}
+
+function anthropicReply(model: string, seq: number, words: string[], toolCall: boolean) {
+  const content = toolCall
+    ? [{ type: "tool_use", id: `toolu_${seq}`, name: "memory_recall", input: { query: `bench ${seq}`, limit: 5 } }]
+    : [{ type: "text", text: words.join("") }];
+  return {
+    id: `msg_${seq}`,
+    type: "message",
+    role: "assistant",
+    model,
+    content,
+    stop_reason: toolCall ? "tool_use" : "end_turn",
+    usage: { input_tokens: 16, output_tokens: words.length },
+  };
+}
+
+function sseStream(format: WireFormat, model: string, seq: number, words: string[]): ReadableStream {
+  const enc = new TextEncoder();
+  return new ReadableStream({
+    async start(controller) {
+      await sleep(opts.latencyMs);
+      if (format === "anthropic") {
+        controller.enqueue(enc.encode(`event: message_start\ndata: ${JSON.stringify({ type: "message_start", message: { id: `msg_${seq}`, model } })}\n\n`));
+      }
+      for (const word of words) {
+        const payload = format === "openai"
+          ? { id: `chatcmpl-${seq}`, model, choices: [{ index: 0, delta: { content: word }, finish_reason: null }] }
+          : { type: "content_block_delta", index: 0, delta: { type: "text_delta", text: word } };
+        const prefix = format === "anthropic" ? "event: content_block_delta\n" : "";
+        controller.enqueue(enc.encode(`${prefix}data: ${JSON.stringify(payload)}\n\n`));
+        if (opts.tokenMs > 0) await sleep(opts.tokenMs);
+      }
+      if (format === "openai") {
+        controller.enqueue(enc.encode(`data: ${JSON.stringify({ id: `chatcmpl-${seq}`, model, choices: [{ index: 0, delta: {}, finish_reason: "stop" }] })}\n\n`));
+        controller.enqueue(enc.encode("data: [DONE]\n\n"));
+      } else {
+        controller.enqueue(enc.encode(`event: message_stop\ndata: ${JSON.stringify({ type: "message_stop" })}\n\n`));
+      }
+      controller.close();
+    },
+  });
+}
+
+function startMockServer(stats: MockStats) {
+  let seq = 0;
+  return Bun.serve({
+    port: 0,
+    hostname: "127.0.0.1",
+    async fetch(req) {
+      const url = new URL(req.url);
+      if (req.method === "GET" && url.pathname.endsWith("/models")) {
+        return Response.json({ object: "list", data: [{ id: "bench-model", object: "model" }] });
+      }
+
+      const isOpenAI = url.pathname.endsWith("/chat/completions");
+      const isAnthropic = url.pathname.endsWith("/messages");
+      if (req.method !== "POST" || (!isOpenAI && !isAnthropic)) {
+        return new Response("not found", { status: 404 });
+      }
+
+      const raw = await req.text();
+      stats.requests++;
+      stats.bytesIn += raw.length;
+      const body = JSON.parse(raw || "{}");
+      const id = ++seq;
+      const model = typeof body.model === "string" ? body.model : "bench-model";
+      const format: WireFormat = isOpenAI ? "openai" : "anthropic";
+      const messages = Array.isArray(body.messages) ? body.messages : [];
+      const toolCall = toolCallsSinceUser(messages) < opts.toolCalls;
+      const words = mockText(opts.tokens, id);
+
+      if (body.stream === true && !toolCall) {
+        stats.streamed++;
+        return new Response(sseStream(format, model, id, words), {
+          headers: { "Content-Type": "text/event-stream", "Cache-Control": "no-cache" },
+        });
+      }
+
+      if (toolCall) stats.toolCallReplies++;
+      // Non-streaming: simulate generation time for the whole reply.
+      await sleep(opts.latencyMs + opts.tokenMs * words.length);
+      return Response.json(format === "openai"
+        ? openaiReply(model, id, words, toolCall)
+        : anthropicReply(model, id, words, toolCall));
+    },
+  });
+}
+
+// ── Build prerequisites ──
+
+async function ensureCClaw(): Promise<string> {
+  if (!(await Bun.file(opts.bin).exists())) {
+    if (opts.bin !== DEFAULT_BIN) throw new Error(`cclaw binary not found: ${opts.bin}`);
+    console.log(dim("  cclaw binary not found — building..."));
+    await $`make`.cwd(CCLAW_DIR);
+  }
+  return opts.bin;
+}
+
+async function ensureAllocShim(): Promise<string | null> {
+  await $`mkdir -p ./build`.quiet();
+  const args = process.platform === "darwin"
+    ? ["cc", "-O2", "-dynamiclib", "-o", SHIM_LIB, SHIM_SRC]
+    : ["cc", "-O2", "-shared", "-fPIC", "-o", SHIM_LIB, SHIM_SRC];
+  const proc = Bun.spawnSync(args, { stdout: "pipe", stderr: "pipe" });
+  if (proc.exitCode !== 0) {
+    warn("Allocation shim", `build failed: ${new TextDecoder().decode(proc.stderr).trim()}`);
+    return null;
+  }
+  return SHIM_LIB;
+}
+
+// ── RSS sampling ──
+//
+// One timer and one `ps` per tick for every live process, rather than a
+// fork per conversation, so sampling does not add load of its own.
+
+class RssSampler {
+  private peaks = new Map<number, number>();
+  private live = new Set<number>();
+  private timer: ReturnType<typeof setInterval> | null = null;
+
+  constructor(private intervalMs: number) {}
+
+  add(pid: number) {
+    this.live.add(pid);
+    this.timer ??= setInterval(() => this.sample(), this.intervalMs);
+  }
+
+  // Takes a last sample, stops tracking pid and returns its peak in KB
+  remove(pid: number): number | null {
+    this.sample();
+    this.live.delete(pid);
+    if (this.live.size === 0 && this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+    return this.peaks.get(pid) ?? null;
+  }
+
+  private sample() {
+    if (this.live.size === 0) return;
+    const proc = Bun.spawnSync(["ps", "-o", "pid=,rss=", "-p", [...this.live].join(",")],
+      { stdout: "pipe", stderr: "ignore" });
+    for (const line of new TextDecoder().decode(proc.stdout).split("\n")) {
+      const [pid, kb] = line.trim().split(/\s+/).map((v) => Number.parseInt(v, 10));
+      if (!Number.isFinite(pid) || !Number.isFinite(kb) || !this.live.has(pid)) continue;
+      this.peaks.set(pid, Math.max(this.peaks.get(pid) ?? 0, kb));
+    }
+  }
+}
+
+// ── CLI channel driver ──
+
+type ConversationResult = {
+  ttftMs: number[];
+  turnMs: number[];
+  failedTurns: number;
+  peakRssKB: number | null;
+  allocs: { allocs: number; frees: number; bytes: number } | null;
+};
+
+class LineReader {
+  private buf = "";
+  private waiters: Array<() => void> = [];
+  private closed = false;
+
+  constructor(stream: ReadableStream<Uint8Array>) {
+    const decoder = new TextDecoder();
+    (async () => {
+      for await (const chunk of stream) {
+        this.buf += decoder.decode(chunk, { stream: true });
+        this.wake();
+      }
+      this.closed = true;
+      this.wake();
+    })();
+  }
+
+  private wake() {
+    const waiters = this.waiters;
+    this.waiters = [];
+    for (const w of waiters) w();
+  }
+
+  // Waits until `marker` appears; returns the text before it and consumes through it.
+  async until(marker: string, timeoutMs: number): Promise<string | null> {
+    const deadline = performance.now() + timeoutMs;
+    for (;;) {
+      const idx = this.buf.indexOf(marker);
+      if (idx >= 0) {
+        const before = this.buf.slice(0, idx);
+        this.buf = this.buf.slice(idx + marker.length);
+        return before;
+      }
+      if (this.closed || performance.now() > deadline) return null;
+      await Promise.race([
+        new Promise<void>((resolve) => this.waiters.push(resolve)),
+        sleep(Math.max(1, deadline - performance.now())),
+      ]);
+    }
+  }
+}
+
+function parseAllocReport(text: string) {
+  const m = text.match(/allocs=(\d+) frees=(\d+) reallocs=(\d+) bytes=(\d+)/);
+  if (!m) return null;
+  return { allocs: Number(m[1]), frees: Number(m[2]), bytes: Number(m[4]) };
+}
+
+async function runConversation(
+  bin: string,
+  index: number,
+  baseUrl: string,
+  shim: string | null,
+  sampler: RssSampler,
+  root: string,
+): Promise<ConversationResult> {
+  const home = join(root, `conversation-${index}`);
+  await $`mkdir -p ${home}`.quiet();
+  const allocOut = join(home, "alloc.txt");
+  const env: Record<string, string | undefined> = {
+    ...Bun.env,
+    HOME: home,
+    ZEROCLAW_API_KEY: "bench-key",
+    ZEROCLAW_PROVIDER: opts.provider,
+    ZEROCLAW_MODEL: "bench-model",
+    ZEROCLAW_API_URL: baseUrl,
+    ZEROCLAW_WORKSPACE: home,
+    BENCH_ALLOC_OUT: shim ? allocOut : undefined,
+  };
+  if (shim) {
+    if (process.platform === "darwin") env.DYLD_INSERT_LIBRARIES = shim;
+    else env.LD_PRELOAD = shim;
+  }
+
+  const proc = Bun.spawn([bin, "agent"], { env, stdin: "pipe", stdout: "pipe", stderr: "ignore" });
+  const reader = new LineReader(proc.stdout);
+  const result: ConversationResult = { ttftMs: [], turnMs: [], failedTurns: 0, peakRssKB: null, allocs: null };
+  sampler.add(proc.pid);
+
+  const turnTimeoutMs = 30_000 + (opts.latencyMs + opts.tokenMs * opts.tokens) * (opts.toolCalls + 1) * 4;
+
+  if ((await reader.until(PROMPT_MARKER, 10_000)) === null) {
+    proc.kill();
+    sampler.remove(proc.pid);
+    throw new Error(`conversation ${index}: cclaw did not show a prompt`);
+  }
+
+  for (let turn = 0; turn < opts.turns; turn++) {
+    const start = performance.now();
+    proc.stdin.write(`conversation ${index} turn ${turn}: summarize the previous answer\n`);
+    proc.stdin.flush();
+
+    // The reply header is written together with the first streamed token
+    const beforeReply = await reader.until(REPLY_MARKER, turnTimeoutMs);
+    const firstToken = performance.now();
+    const rest = await reader.until(PROMPT_MARKER, turnTimeoutMs);
+    const end = performance.now();
+
+    if (beforeReply === null && rest === null) {
+      result.failedTurns++;
+      break;
+    }
+    if (beforeReply === null) {
+      result.failedTurns++;
+      continue;
+    }
+    result.ttftMs.push(firstToken - start);
+    result.turnMs.push(end - start);
+  }
+
+  proc.stdin.write("/quit\n");
+  proc.stdin.end();
+  result.peakRssKB = sampler.remove(proc.pid);
+  await Promise.race([proc.exited, sleep(5_000)]);
+  proc.kill();
+
+  if (shim && (await Bun.file(allocOut).exists())) {
+    result.allocs = parseAllocReport(await Bun.file(allocOut).text());
+  }
+  return result;
+}
+
+// ── Webhook driver ──
+//
+// The webhook channel acknowledges immediately and hands the message to the
+// channel manager, so this measures gateway admission latency and throughput,
+// not model round-trips.
+
+async function runWebhookLoad(url: string) {
+  const latencies: number[] = [];
+  let failures = 0;
+  const start = performance.now();
+  await Promise.all(
+    Array.from({ length: opts.conversations }, async (_, c) => {
+      for (let t = 0; t < opts.turns; t++) {
+        const t0 = performance.now();
+        try {
+          const res = await fetch(url, {
+            method: "POST",
+            headers: { "Content-Type": "application/json" },
+            body: JSON.stringify({ sender: `bench-${c}`, text: `conversation ${c} turn ${t}` }),
+          });
+          await res.arrayBuffer();
+          if (!res.ok) failures++;
+          else latencies.push(performance.now() - t0);
+        } catch {
+          failures++;
+        }
+      }
+    }),
+  );
+  const elapsedMs = performance.now() - start;
+  return { elapsedMs, latencies, failures };
+}
+
+// ── Main ──
+
+section("Configuration");
+metric("Conversations", String(opts.conversations));
+metric("Turns per conversation", String(opts.turns));
+metric("Mock wire format", opts.provider);
+metric("Mock latency / token", `${opts.latencyMs} ms / ${opts.tokenMs} ms x ${opts.tokens}`);
+metric("Tool calls per turn", String(opts.toolCalls));
+
+const mockStats: MockStats = { requests: 0, streamed: 0, toolCallReplies: 0, bytesIn: 0 };
+const server = startMockServer(mockStats);
+const baseUrl = `http://127.0.0.1:${server.port}/v1`;
+
+const report: Record<string, unknown> = {
+  generatedAt: new Date().toISOString(),
+  options: { ...opts, bin: undefined },
+};
+
+try {
+  const bin = await ensureCClaw();
+  const shim = await ensureAllocShim();
+  const home = (await $`mktemp -d ${(Bun.env.TMPDIR ?? "/tmp") + "/cclaw-bench-load-XXXXXX"}`.text()).trim();
+  const sampler = new RssSampler(100);
+
+  section("CLI channel");
+  const start = performance.now();
+  const results = await Promise.all(
+    Array.from({ length: opts.conversations }, (_, i) => runConversation(bin, i, baseUrl, shim, sampler, home)),
+  );
+  const elapsedMs = performance.now() - start;
+
+  const ttftMs = results.flatMap((r) => r.ttftMs);
+  const turnMs = results.flatMap((r) => r.turnMs);
+  const failed = results.reduce((acc, r) => acc + r.failedTurns, 0);
+  const rss = results.map((r) => r.peakRssKB).filter((v): v is number => v != null);
+  const allocs = results.map((r) => r.allocs).filter((v): v is NonNullable<typeof v> => v != null);
+  const completed = turnMs.length;
+
+  const ttftStats = summarize(ttftMs);
+  const turnStats = summarize(turnMs);
+  const turnsPerSec = completed / (elapsedMs / 1000);
+  const peakRssKB = rss.length ? Math.max(...rss) : null;
+  const totalAllocs = allocs.reduce((acc, a) => acc + a.allocs, 0);
+  const totalAllocBytes = allocs.reduce((acc, a) => acc + a.bytes, 0);
+  const allocsPerTurn = allocs.length && completed ? totalAllocs / completed : null;
+  const allocBytesPerTurn = allocs.length && completed ? totalAllocBytes / completed : null;
+
+  metric("Completed turns", `${completed} (${failed} failed)`);
+  metric("Throughput", `${round(turnsPerSec, 2)} turns/sec`);
+  metric("Time to first token p50 / p99", `${ttftStats.p50} ms / ${ttftStats.p99} ms`);
+  metric("Turn latency p50 / p99", `${turnStats.p50} ms / ${turnStats.p99} ms`);
+  if (peakRssKB != null) metric("Peak RSS (per process)", `${peakRssKB} KB`);
+  else warn("Peak RSS (per process)", "unavailable");
+  if (allocsPerTurn != null) {
+    metric("Allocations per turn", `${round(allocsPerTurn, 1)} (${round((allocBytesPerTurn ?? 0) / 1024, 1)} KB)`);
+  } else {
+    warn("Allocations per turn", "unavailable (shim not loaded)");
+  }
+  metric("Mock requests", `${mockStats.requests} (${mockStats.toolCallReplies} tool-call replies, ${mockStats.streamed} streamed)`);
+
+  report.cli = {
+    elapsedMs: round(elapsedMs, 3),
+    completedTurns: completed,
+    failedTurns: failed,
+    turnsPerSec: round(turnsPerSec, 3),
+    ttftMs: ttftStats,
+    turnMs: turnStats,
+    peakRssKB,
+    allocsPerTurn: allocsPerTurn == null ? null : round(allocsPerTurn, 2),
+    allocBytesPerTurn: allocBytesPerTurn == null ? null : round(allocBytesPerTurn, 2),
+    mock: { ...mockStats },
+  };
+
+  if (opts.webhookUrl) {
+    section("Webhook channel");
+    const wh = await runWebhookLoad(opts.webhookUrl);
+    const whStats = summarize(wh.latencies);
+    const rps = wh.latencies.length / (wh.elapsedMs / 1000);
+    metric("Accepted requests", `${wh.latencies.length} (${wh.failures} failed)`);
+    metric("Throughput", `${round(rps, 2)} req/sec`);
+    metric("Latency p50 / p99", `${whStats.p50} ms / ${whStats.p99} ms`);
+    report.webhook = {
+      url: opts.webhookUrl,
+      elapsedMs: round(wh.elapsedMs, 3),
+      failures: wh.failures,
+      requestsPerSec: round(rps, 3),
+      latencyMs: whStats,
+    };
+  }
+
+  await $`rm -rf ${home}`.quiet();
+} finally {
+  server.stop(true);
+}
+
+if (opts.exportJson) {
+  await $`mkdir -p ./build`.quiet();
+  await Bun.write(BENCH_LOAD_JSON, JSON.stringify(report, null, 2) + "\n");
+  console.log(`\n  ${dim(`Exported ${BENCH_LOAD_JSON}`)}`);
+}
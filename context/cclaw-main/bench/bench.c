@@ -0,0 +1,216 @@
+// bench.c - Micro-benchmark harness and runner for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_RESULTS 128
+#define BENCH_MAX_SAMPLES 1000
+
+typedef struct bench_result_t {
+    char name[64];
+    uint64_t iterations;      // Operations per sample
+    uint32_t samples;
+    double min_ns;            // Per-operation statistics
+    double median_ns;
+    double mean_ns;
+    double p95_ns;
+    double stddev_ns;
+} bench_result_t;
+
+struct bench_t {
+    const char* filter;
+    uint32_t samples;
+    uint64_t warmup_ns;
+    uint64_t min_sample_ns;
+    bool quick;
+
+    bench_result_t results[BENCH_MAX_RESULTS];
+    uint32_t result_count;
+};
+
+// ============================================================================
+// Timing
+// ============================================================================
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+bool bench_selected(bench_t* bench, const char* name) {
+    return !bench->filter || strstr(name, bench->filter) != NULL;
+}
+
+bool bench_quick(bench_t* bench) {
+    return bench->quick;
+}
+
+void bench_run(bench_t* bench, const char* name, bench_fn_t fn, void* ctx) {
+    if (!bench_selected(bench, name)) return;
+    if (bench->result_count >= BENCH_MAX_RESULTS) return;
+
+    // Warm up caches and allocator, and calibrate the sample size
+    uint64_t iterations = 0;
+    uint64_t start = now_ns();
+    uint64_t elapsed = 0;
+    do {
+        fn(ctx);
+        iterations++;
+        elapsed = now_ns() - start;
+    } while (elapsed < bench->warmup_ns);
+
+    double op_ns = (double)elapsed / (double)iterations;
+    uint64_t per_sample = (uint64_t)((double)bench->min_sample_ns / op_ns);
+    if (per_sample < 1) per_sample = 1;
+
+    double samples[BENCH_MAX_SAMPLES];
+    uint32_t count = bench->samples < BENCH_MAX_SAMPLES ? bench->samples : BENCH_MAX_SAMPLES;
+
+    for (uint32_t s = 0; s < count; s++) {
+        uint64_t t0 = now_ns();
+        for (uint64_t i = 0; i < per_sample; i++) {
+            fn(ctx);
+        }
+        samples[s] = (double)(now_ns() - t0) / (double)per_sample;
+    }
+
+    qsort(samples, count, sizeof(double), compare_double);
+
+    double sum = 0.0;
+    for (uint32_t s = 0; s < count; s++) sum += samples[s];
+    double mean = sum / count;
+
+    double var = 0.0;
+    for (uint32_t s = 0; s < count; s++) var += (samples[s] - mean) * (samples[s] - mean);
+
+    bench_result_t* r = &bench->results[bench->result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->iterations = per_sample;
+    r->samples = count;
+    r->min_ns = samples[0];
+    r->median_ns = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+    r->mean_ns = mean;
+    r->p95_ns = samples[(uint32_t)((count - 1) * 0.95)];
+    r->stddev_ns = count > 1 ? sqrt(var / (count - 1)) : 0.0;
+
+    printf("%-40s %12.1f %12.1f %12.1f %8.1f%% %10llu\n",
+           r->name, r->median_ns, r->min_ns, r->p95_ns,
+           r->mean_ns > 0 ? 100.0 * r->stddev_ns / r->mean_ns : 0.0,
+           (unsigned long long)r->iterations);
+    fflush(stdout);
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+static int write_json(const bench_t* bench, const char* path, const char* commit) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "bench: cannot write %s\n", path);
+        return 1;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"commit\": \"%s\",\n", commit ? commit : "");
+    fprintf(f, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+#if defined(__clang__)
+    fprintf(f, "  \"compiler\": \"clang %d.%d\",\n", __clang_major__, __clang_minor__);
+#elif defined(__GNUC__)
+    fprintf(f, "  \"compiler\": \"gcc %d.%d\",\n", __GNUC__, __GNUC_MINOR__);
+#endif
+    fprintf(f, "  \"samples\": %u,\n", bench->samples);
+    fprintf(f, "  \"quick\": %s,\n", bench->quick ? "true" : "false");
+    fprintf(f, "  \"results\": [\n");
+
+    for (uint32_t i = 0; i < bench->result_count; i++) {
+        const bench_result_t* r = &bench->results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"iterations\": %llu, \"samples\": %u, "
+                   "\"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f, "
+                   "\"p95_ns\": %.1f, \"stddev_ns\": %.1f}%s\n",
+                r->name, (unsigned long long)r->iterations, r->samples,
+                r->min_ns, r->median_ns, r->mean_ns, r->p95_ns, r->stddev_ns,
+                i + 1 < bench->result_count ? "," : "");
+    }
+
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    printf("\nResults written to %s\n", path);
+    return 0;
+}
+
+static void print_usage(const char* argv0) {
+    printf("Usage: %s [options]\n", argv0);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --filter STR      Only run benchmarks whose name contains STR\n");
+    printf("  --samples N       Timed samples per benchmark (default 20)\n");
+    printf("  --warmup-ms N     Warmup time per benchmark (default 100)\n");
+    printf("  --sample-ms N     Minimum duration of one sample (default 10)\n");
+    printf("  --quick           Skip the largest fixtures\n");
+    printf("  --json PATH       Write results as JSON\n");
+    printf("  --commit REV      Revision recorded in the JSON output\n");
+}
+
+int main(int argc, char** argv) {
+    static bench_t bench = {
+        .samples = 20,
+        .warmup_ns = 100 * 1000000ull,
+        .min_sample_ns = 10 * 1000000ull,
+    };
+    const char* json_path = NULL;
+    const char* commit = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            bench.filter = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            bench.samples = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup-ms") == 0 && i + 1 < argc) {
+            bench.warmup_ns = (uint64_t)atoll(argv[++i]) * 1000000ull;
+        } else if (strcmp(argv[i], "--sample-ms") == 0 && i + 1 < argc) {
+            bench.min_sample_ns = (uint64_t)atoll(argv[++i]) * 1000000ull;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            bench.quick = true;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--commit") == 0 && i + 1 < argc) {
+            commit = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (bench.samples == 0) bench.samples = 1;
+
+    printf("CClaw Benchmarks\n");
+    printf("================\n\n");
+    printf("%-40s %12s %12s %12s %9s %10s\n",
+           "benchmark", "median ns", "min ns", "p95 ns", "cv", "iters");
+
+    bench_suite_string(&bench);
+    bench_suite_json(&bench);
+    bench_suite_provider(&bench);
+    bench_suite_agent(&bench);
+    bench_suite_memory(&bench);
+
+    if (json_path) return write_json(&bench, json_path, commit);
+    return 0;
+}
@@ -0,0 +1,48 @@
+// bench.h - Micro-benchmark harness for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_BENCH_H
+#define CCLAW_BENCH_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Each benchmark is warmed up, then timed over a fixed number of samples.
+// A sample runs the body enough times to last at least min_sample_ns, so
+// fast primitives are not dominated by clock overhead. Results are printed
+// as a table and optionally written as JSON for cross-commit comparison.
+
+typedef struct bench_t bench_t;
+
+// Body of a benchmark: perform exactly one operation
+typedef void (*bench_fn_t)(void* ctx);
+
+// Run and record a benchmark (skipped when it does not match the filter)
+void bench_run(bench_t* bench, const char* name, bench_fn_t fn, void* ctx);
+
+// Whether a benchmark passes the filter; lets suites skip expensive setup
+bool bench_selected(bench_t* bench, const char* name);
+
+// Large fixtures (100k rows) are skipped in quick mode
+bool bench_quick(bench_t* bench);
+
+// Keep the compiler from eliding a result
+static inline void bench_keep(const void* ptr) {
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+}
+
+// Synthetic conversation: system prompt then alternating user/assistant
+// turns of realistic length. Free with chat_message_array_free().
+chat_message_t* bench_conversation_create(uint32_t count);
+
+// Suites
+void bench_suite_string(bench_t* bench);
+void bench_suite_json(bench_t* bench);
+void bench_suite_provider(bench_t* bench);
+void bench_suite_agent(bench_t* bench);
+void bench_suite_memory(bench_t* bench);
+
+#endif // CCLAW_BENCH_H
@@ -0,0 +1,71 @@
+// bench_agent.c - Conversation tree benchmarks for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "core/agent.h"
+#include "providers/base.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Builds a linear conversation of `depth` turns from a synthetic transcript,
+// then hangs an abandoned 5-message branch off every 10th turn so the tree
+// looks like a session with edits and retries.
+static agent_message_t* build_tree(uint32_t depth, agent_message_t** out_leaf) {
+    chat_message_t* transcript = bench_conversation_create(depth + 1);
+    if (!transcript) return NULL;
+
+    agent_message_t* root = NULL;
+    agent_message_t* tail = NULL;
+    for (uint32_t i = 1; i <= depth; i++) {
+        agent_message_type_t type = transcript[i].role == CHAT_ROLE_USER ? AGENT_MSG_USER : AGENT_MSG_ASSISTANT;
+        agent_message_t* msg = agent_message_create(type, &transcript[i].content);
+        if (tail) agent_message_add_child(tail, msg);
+        else root = msg;
+        tail = msg;
+    }
+
+    agent_message_t* node = root;
+    for (uint32_t i = 0; node; i++) {
+        agent_message_t* next = node->child_count > 0 ? node->children[0] : NULL;
+        if (i % 10 == 0 && next) {
+            agent_message_t* branch = node;
+            for (uint32_t j = 0; j < 5; j++) {
+                agent_message_t* msg = agent_message_create(AGENT_MSG_USER, &transcript[1 + j % depth].content);
+                agent_message_add_child(branch, msg);
+                branch = msg;
+            }
+        }
+        node = next;
+    }
+
+    chat_message_array_free(transcript, depth + 1);
+    *out_leaf = tail;
+    return root;
+}
+
+static void bench_context(void* ctx) {
+    chat_message_t* messages = NULL;
+    uint32_t count = 0;
+    agent_session_to_chat_messages(ctx, &messages, &count);
+    bench_keep(messages);
+    chat_message_array_free(messages, count);
+}
+
+void bench_suite_agent(bench_t* bench) {
+    static const uint32_t depths[] = { 10, 100, 1000 };
+
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "build_context_messages/%u", depths[i]);
+        if (!bench_selected(bench, name)) continue;
+
+        agent_session_t session;
+        memset(&session, 0, sizeof(session));
+        session.root = build_tree(depths[i], &session.current);
+        if (!session.root) continue;
+
+        bench_run(bench, name, bench_context, &session);
+        agent_message_tree_free(session.root);
+    }
+}
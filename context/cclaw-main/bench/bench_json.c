@@ -0,0 +1,83 @@
+// bench_json.c - JSON parse/print benchmarks on provider payloads for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "providers/base.h"
+#include "json_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Captured shape of an OpenAI chat completion response
+static const char OPENAI_RESPONSE[] =
+    "{\"id\":\"chatcmpl-9xK2mPqR7sT1uV3wX5yZ\",\"object\":\"chat.completion\","
+    "\"created\":1718000000,\"model\":\"gpt-4o-2024-05-13\","
+    "\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\","
+    "\"content\":\"Here is the updated function:\\n\\n```c\\nstatic size_t write_callback(void* contents, "
+    "size_t size, size_t nmemb, void* userp) {\\n    size_t total = size * nmemb;\\n    "
+    "memory_buffer_t* mem = userp;\\n    if (!buffer_reserve(mem, total + 1)) return 0;\\n    "
+    "memcpy(mem->data + mem->size, contents, total);\\n    mem->size += total;\\n    "
+    "return total;\\n}\\n```\\n\\nThe growth policy doubles the capacity, so appends are "
+    "amortized O(1). Let me know if you want me to run the tests.\"},"
+    "\"logprobs\":null,\"finish_reason\":\"stop\"}],"
+    "\"usage\":{\"prompt_tokens\":1843,\"completion_tokens\":212,\"total_tokens\":2055},"
+    "\"system_fingerprint\":\"fp_3aa7262c27\"}";
+
+// Captured shape of an Anthropic messages response with a tool call
+static const char ANTHROPIC_RESPONSE[] =
+    "{\"id\":\"msg_01XFDUDYJgAACzvnptvVoYEL\",\"type\":\"message\",\"role\":\"assistant\","
+    "\"model\":\"claude-sonnet-4-20250514\",\"content\":["
+    "{\"type\":\"text\",\"text\":\"I'll read the file to see how the buffer grows.\"},"
+    "{\"type\":\"tool_use\",\"id\":\"toolu_01A09q90qw90lq917835lq9\",\"name\":\"file_read\","
+    "\"input\":{\"path\":\"src/utils/http.c\",\"offset\":0,\"limit\":200}}],"
+    "\"stop_reason\":\"tool_use\",\"stop_sequence\":null,"
+    "\"usage\":{\"input_tokens\":2095,\"output_tokens\":503,"
+    "\"cache_creation_input_tokens\":0,\"cache_read_input_tokens\":1536}}";
+
+typedef struct {
+    const char* text;
+    json_value_t* tree;
+} json_ctx_t;
+
+static void bench_parse(void* ctx) {
+    json_value_t* value = json_parse(((json_ctx_t*)ctx)->text);
+    bench_keep(value);
+    json_free(value);
+}
+
+static void bench_print(void* ctx) {
+    char* text = json_print(((json_ctx_t*)ctx)->tree, false);
+    bench_keep(text);
+    json_free_string(text);
+}
+
+static void run_payload(bench_t* bench, const char* label, const char* text) {
+    char parse_name[64];
+    char print_name[64];
+    snprintf(parse_name, sizeof(parse_name), "json_parse/%s", label);
+    snprintf(print_name, sizeof(print_name), "json_print/%s", label);
+
+    json_ctx_t ctx = { .text = text, .tree = json_parse(text) };
+    if (!ctx.tree) {
+        fprintf(stderr, "bench: %s payload does not parse\n", label);
+        return;
+    }
+
+    bench_run(bench, parse_name, bench_parse, &ctx);
+    bench_run(bench, print_name, bench_print, &ctx);
+    json_free(ctx.tree);
+}
+
+void bench_suite_json(bench_t* bench) {
+    run_payload(bench, "openai_response", OPENAI_RESPONSE);
+    run_payload(bench, "anthropic_response", ANTHROPIC_RESPONSE);
+
+    // A 100-turn request body as sent to the provider
+    if (bench_selected(bench, "json_parse/request_100") || bench_selected(bench, "json_print/request_100")) {
+        chat_message_t* messages = bench_conversation_create(100);
+        char* request = provider_build_chat_request(NULL, messages, 100, NULL, 0, "gpt-4o", 0.7, false);
+        if (request) run_payload(bench, "request_100", request);
+        json_free_string(request);
+        chat_message_array_free(messages, 100);
+    }
+}
@@ -0,0 +1,143 @@
+// bench_memory.c - Memory backend store/search benchmarks for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "core/memory.h"
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const TOPICS[] = {
+    "The user prefers tabs over spaces and wants clang-format applied before commits.",
+    "The HTTP client grows its receive buffer by doubling when a response exceeds capacity.",
+    "Deploys go out on Tuesdays; the staging database is refreshed nightly from backups.",
+    "The project builds with make and runs tests with make test on macOS and Linux.",
+    "OpenRouter requests are routed through the default model unless overridden per session.",
+};
+
+#define TOPIC_COUNT (sizeof(TOPICS) / sizeof(TOPICS[0]))
+
+typedef struct {
+    memory_t* memory;
+    uint64_t next_key;
+    str_t query;
+    memory_search_opts_t opts;
+} memory_ctx_t;
+
+static err_t store_entry(memory_t* memory, uint64_t n) {
+    char key[32];
+    char content[256];
+    snprintf(key, sizeof(key), "bench_%llu", (unsigned long long)n);
+    snprintf(content, sizeof(content), "%s (note %llu)", TOPICS[n % TOPIC_COUNT], (unsigned long long)n);
+
+    str_t k = STR_VIEW(key);
+    str_t c = STR_VIEW(content);
+    memory_entry_t* entry = memory_entry_create(&k, &c, (memory_category_t)(n % 3), NULL);
+    if (!entry) return ERR_OUT_OF_MEMORY;
+
+    err_t err = memory->vtable->store(memory, entry);
+    memory_entry_free(entry);
+    return err;
+}
+
+static memory_t* open_backend(const char* name, const char* data_dir, uint32_t rows) {
+    memory_config_t config = memory_config_default();
+    config.backend = STR_VIEW(name);
+    config.data_dir = data_dir ? STR_VIEW(data_dir) : STR_NULL;
+    config.max_entries = rows * 2;
+
+    memory_t* memory = NULL;
+    if (memory_create(name, &config, &memory) != ERR_OK) return NULL;
+    if (memory->vtable->init(memory) != ERR_OK) {
+        memory->vtable->destroy(memory);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < rows; i++) {
+        if (store_entry(memory, i) != ERR_OK) {
+            fprintf(stderr, "bench: %s prepopulate failed at row %u\n", name, i);
+            memory->vtable->cleanup(memory);
+            memory->vtable->destroy(memory);
+            return NULL;
+        }
+    }
+    return memory;
+}
+
+static void close_backend(memory_t* memory) {
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+}
+
+static void bench_store(void* ctx) {
+    memory_ctx_t* m = ctx;
+    store_entry(m->memory, m->next_key++);
+}
+
+static void bench_search(void* ctx) {
+    memory_ctx_t* m = ctx;
+    memory_entry_t* entries = NULL;
+    uint32_t count = 0;
+    m->memory->vtable->search(m->memory, &m->query, &m->opts, &entries, &count);
+    bench_keep(entries);
+    memory_entry_array_free(entries, count);
+}
+
+static int remove_entry(const char* path, const struct stat* sb, int flag, struct FTW* ftw) {
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+static void run_sqlite(bench_t* bench, uint32_t rows, const char* label) {
+    char store_name[64];
+    char search_name[64];
+    snprintf(store_name, sizeof(store_name), "sqlite.store/%s", label);
+    snprintf(search_name, sizeof(search_name), "sqlite.search/%s", label);
+    if (!bench_selected(bench, store_name) && !bench_selected(bench, search_name)) return;
+
+    // In-memory database so the numbers measure SQLite and FTS, not the disk
+    memory_ctx_t ctx = {
+        .memory = open_backend("sqlite", NULL, rows),
+        .next_key = rows,
+        .query = STR_LIT("buffer"),
+        .opts = memory_search_opts_default(),
+    };
+    if (!ctx.memory) return;
+
+    bench_run(bench, search_name, bench_search, &ctx);
+    bench_run(bench, store_name, bench_store, &ctx);
+    close_backend(ctx.memory);
+}
+
+static void run_markdown(bench_t* bench, uint32_t rows) {
+    if (!bench_selected(bench, "markdown.search")) return;
+
+    char dir[] = "/tmp/cclaw-bench-XXXXXX";
+    if (!mkdtemp(dir)) return;
+
+    memory_ctx_t ctx = {
+        .memory = open_backend("markdown", dir, rows),
+        .query = STR_LIT("buffer"),
+        .opts = memory_search_opts_default(),
+    };
+    if (ctx.memory) {
+        bench_run(bench, "markdown.search/1k", bench_search, &ctx);
+        close_backend(ctx.memory);
+    }
+
+    nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void bench_suite_memory(bench_t* bench) {
+    if (memory_registry_init() != ERR_OK) return;
+
+    run_sqlite(bench, 10000, "10k");
+    if (!bench_quick(bench)) {
+        run_sqlite(bench, 100000, "100k");
+    }
+    run_markdown(bench, 1000);
+
+    memory_registry_shutdown();
+}
@@ -0,0 +1,78 @@
+// bench_provider.c - Provider request building benchmarks for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "providers/base.h"
+#include "json_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const USER_TURNS[] = {
+    "Can you look at src/core/agent.c and explain how the context window is built?",
+    "Run the test suite and tell me which tests fail, with the relevant output.",
+    "Refactor the HTTP client so that it reuses connections between requests.",
+    "What does \"max_context_messages\" control?\nShow me where it is read.",
+};
+
+static const char* const ASSISTANT_TURNS[] = {
+    "The context is built by walking from the session root to the current message "
+    "and converting each node to a chat message. The system prompt is always first, "
+    "followed by the user and assistant turns in order. Tool results are sent with "
+    "the `tool` role so the model can associate them with the preceding call.",
+    "I ran `make test`. Two tests failed:\n\n```\ntest_memory: FAIL: results != NULL\n"
+    "test_channels: FAIL: err == ERR_OK\n```\n\nBoth failures come from the SQLite "
+    "backend not being initialized before use.",
+};
+
+chat_message_t* bench_conversation_create(uint32_t count) {
+    chat_message_t* messages = calloc(count, sizeof(chat_message_t));
+    if (!messages) return NULL;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const char* text;
+        if (i == 0) {
+            messages[i].role = CHAT_ROLE_SYSTEM;
+            text = "You are a helpful coding assistant working in the user's repository.";
+        } else if (i % 2 == 1) {
+            messages[i].role = CHAT_ROLE_USER;
+            text = USER_TURNS[(i / 2) % (sizeof(USER_TURNS) / sizeof(USER_TURNS[0]))];
+        } else {
+            messages[i].role = CHAT_ROLE_ASSISTANT;
+            text = ASSISTANT_TURNS[(i / 2) % (sizeof(ASSISTANT_TURNS) / sizeof(ASSISTANT_TURNS[0]))];
+        }
+        messages[i].content = str_dup_cstr(text, NULL);
+    }
+
+    return messages;
+}
+
+typedef struct {
+    chat_message_t* messages;
+    uint32_t count;
+} request_ctx_t;
+
+static void bench_build_request(void* ctx) {
+    request_ctx_t* req = ctx;
+    char* json = provider_build_chat_request(NULL, req->messages, req->count, NULL, 0,
+                                             "gpt-4o", 0.7, false);
+    bench_keep(json);
+    json_free_string(json);
+}
+
+void bench_suite_provider(bench_t* bench) {
+    static const uint32_t sizes[] = { 10, 100, 1000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "provider_build_chat_request/%u", sizes[i]);
+        if (!bench_selected(bench, name)) continue;
+
+        request_ctx_t ctx = { .messages = bench_conversation_create(sizes[i]), .count = sizes[i] };
+        if (!ctx.messages) continue;
+
+        bench_run(bench, name, bench_build_request, &ctx);
+        chat_message_array_free(ctx.messages, ctx.count);
+    }
+}
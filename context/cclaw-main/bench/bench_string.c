@@ -0,0 +1,34 @@
+// bench_string.c - String primitive benchmarks for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "core/types.h"
+
+#include <stdlib.h>
+
+static void bench_str_dup(void* ctx) {
+    str_t s = str_dup(*(str_t*)ctx, NULL);
+    bench_keep(s.data);
+    free((void*)s.data);
+}
+
+static void bench_str_format(void* ctx) {
+    (void)ctx;
+    str_t s = str_format(NULL, "%s/%s?id=%d&t=%.3f", "https://api.example.com", "v1/chat", 42, 0.7);
+    bench_keep(s.data);
+    free((void*)s.data);
+}
+
+void bench_suite_string(bench_t* bench) {
+    static char long_text[4096];
+    for (size_t i = 0; i < sizeof(long_text) - 1; i++) {
+        long_text[i] = (char)('a' + i % 26);
+    }
+
+    str_t short_str = STR_LIT("anthropic/claude-sonnet-4");
+    str_t long_str = { .data = long_text, .len = sizeof(long_text) - 1 };
+
+    bench_run(bench, "str_dup/short", bench_str_dup, &short_str);
+    bench_run(bench, "str_dup/4k", bench_str_dup, &long_str);
+    bench_run(bench, "str_format", bench_str_format, NULL);
+}
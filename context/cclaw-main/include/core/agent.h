@@ -8,9 +8,13 @@
 #include "core/types.h"
 #include "core/error.h"
 #include "core/tool.h"
+#include "core/prefetch.h"
+#include "core/tool_cache.h"
+#include "core/tool_output.h"
 #include "core/memory.h"
 #include "providers/base.h"
 #include "core/channel.h"
+#include "core/event_bus.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -40,9 +44,11 @@ struct agent_message_t {
     str_t content;               // Text content
 
     // For tool calls
-    str_t tool_name;
+    str_t tool_name;             // Interned
     str_t tool_args;             // JSON arguments
     str_t tool_result;           // Execution result
+    str_t tool_calls;            // Provider's tool_calls JSON (AGENT_MSG_TOOL_CALL)
+    str_t tool_call_id;          // Call this result answers (AGENT_MSG_TOOL_RESULT)
 
     // Tree structure (Pi's conversation branching)
     agent_message_t* parent;     // Parent message (NULL for root)
@@ -56,12 +62,14 @@ struct agent_message_t {
 
     // Metadata
     uint64_t timestamp;
-    str_t model;                 // Which model generated this
+    str_t model;                 // Which model generated this; interned
     uint32_t tokens_input;
     uint32_t tokens_output;
 
     // For partial/streaming content
     bool is_complete;
+
+    bool content_shared;         // content is a shared tool output (tool_cache.h)
 };
 
 // Agent session (Pi-style conversation tree)
@@ -84,13 +92,31 @@ struct agent_session_t {
     uint32_t total_messages;
     uint32_t total_tokens;
 
+    // Per-session limits, checked before each loop iteration (0 = none)
+    uint32_t token_budget;           // Stop once total_tokens reaches this
+    uint64_t deadline_ms;            // clock_monotonic_ms() value; 0 = none
+
+    // Results of read-only tool calls, created on first use
+    tool_cache_t* tool_cache;
+
+    // Tool outputs too large for the context, created on the first spill
+    tool_output_store_t* tool_outputs;
+
+    // Differential history (provider_supports_chaining). The provider has
+    // stored the conversation up to chain_head as chain_response_id, so
+    // only later messages are sent. Dropped once the current path no
+    // longer runs through chain_head.
+    bool chain_history;              // From agent_config_t.differential_history
+    str_t chain_response_id;
+    agent_message_t* chain_head;
+
     // Session state
     bool is_active;
     str_t working_directory;         // Current working directory for this session
 
     // Provider settings (per-session override)
     str_t provider_name;
-    str_t model;
+    str_t model;                     // Interned; set with str_intern(), never freed
     double temperature;
 };
 
@@ -119,8 +145,15 @@ struct agent_config_t {
     str_t extensions_dir;            // Where extensions are stored
     bool hot_reload_extensions;      // Auto-reload on file change
 
+    // Large tool outputs (tool_output.h)
+    uint32_t tool_output_spill_bytes; // Spill results larger than this (0 = never)
+    str_t tool_output_dir;           // Default ~/.cclaw/tool-outputs; one subdir per session
+
     // UI preferences
     bool stream_responses;           // Stream LLM output
+    bool speculative_tools;          // Run read-only tool calls while the reply streams
+    bool differential_history;       // Send only new messages when the provider keeps state
+                                     // (chained turns are neither streamed nor speculated)
     bool show_token_usage;           // Display token counts
     bool show_tool_calls;            // Display tool execution
 };
@@ -132,6 +165,8 @@ struct agent_context_t {
     memory_t* memory;
     tool_t** tools;
     uint32_t tool_count;
+    tool_prefetch_t* prefetch;       // Created on the first streamed turn
+    event_bus_t* events;             // Borrowed; turn and tool events go here when set
 
     // Session management
     agent_session_t** sessions;
@@ -207,6 +242,10 @@ struct agent_vtable_t {
 err_t agent_create(const agent_config_t* config, agent_t** out_agent);
 void agent_destroy(agent_t* agent);
 
+// Publish turn, token and tool events to bus (NULL to stop). The bus must
+// outlive the agent or be unset first.
+void agent_set_event_bus(agent_t* agent, event_bus_t* bus);
+
 // ============================================================================
 // Session Management
 // ============================================================================
@@ -286,6 +325,14 @@ err_t agent_session_to_chat_messages(agent_session_t* session,
                                      chat_message_t** out_messages,
                                      uint32_t* out_count);
 
+// Only the messages after since, which must be on the current path
+// (ERR_NOT_FOUND otherwise); since's own tool results are included. The
+// system prompt comes first either way.
+err_t agent_session_to_chat_messages_since(agent_session_t* session,
+                                           const agent_message_t* since,
+                                           chat_message_t** out_messages,
+                                           uint32_t* out_count);
+
 // ============================================================================
 // Configuration
 // ============================================================================
@@ -7,6 +7,8 @@
 #include "types.h"
 #include "error.h"
 
+#include <stdio.h>
+
 // Allocator interface (compatible with sp.h)
 typedef struct allocator_t allocator_t;
 
@@ -70,6 +72,38 @@ typedef struct scratch_allocator_t {
     size_t saved;
 } scratch_allocator_t;
 
+// Per-subsystem accounting. Each subsystem owns a tracking allocator backed by
+// the system heap; byte counts use the heap's usable size, so memory obtained
+// here may still be released with plain free() by code that does not know
+// about the allocator (the free is then simply not counted).
+typedef enum {
+    ALLOC_SUBSYS_PROVIDERS,
+    ALLOC_SUBSYS_HTTP,
+    ALLOC_SUBSYS_JSON,
+    ALLOC_SUBSYS_MEMORY,
+    ALLOC_SUBSYS_TOOLS,
+    ALLOC_SUBSYS_CHANNELS,
+    ALLOC_SUBSYS_TUI,
+    ALLOC_SUBSYS_COUNT
+} alloc_subsystem_t;
+
+// Point-in-time copy of a tracking allocator's counters
+typedef struct alloc_stats_t {
+    size_t total_allocated;
+    size_t total_freed;
+    size_t live_bytes;
+    size_t peak_bytes;
+    uint32_t allocation_count;
+    uint32_t live_count;
+} alloc_stats_t;
+
+// Periodic growth sampler (see alloc_sampler_tick)
+typedef struct alloc_sampler_t {
+    uint64_t interval_ms;
+    uint64_t last_sample_ms;
+    size_t last_live[ALLOC_SUBSYS_COUNT];
+} alloc_sampler_t;
+
 // Global allocators
 allocator_t* allocator_default(void);
 allocator_t* allocator_scratch(void);
@@ -92,6 +126,19 @@ void pool_destroy(pool_allocator_t* pool);
 tracking_allocator_t* tracking_create(allocator_t* backing);
 void tracking_destroy(tracking_allocator_t* tracker);
 void tracking_report(tracking_allocator_t* tracker);
+void tracking_get_stats(tracking_allocator_t* tracker, alloc_stats_t* out_stats);
+
+// Subsystem accounting
+allocator_t* allocator_subsystem(alloc_subsystem_t subsystem);
+const char* alloc_subsystem_name(alloc_subsystem_t subsystem);
+void alloc_subsystem_stats(alloc_subsystem_t subsystem, alloc_stats_t* out_stats);
+void alloc_subsystem_report(FILE* out);
+size_t alloc_subsystem_metrics(char* buffer, size_t size);
+
+// Logs subsystems whose live bytes grew since the previous sample. Returns
+// true when a sample was taken (at most once per interval).
+void alloc_sampler_init(alloc_sampler_t* sampler, uint64_t interval_ms, uint64_t now_ms);
+bool alloc_sampler_tick(alloc_sampler_t* sampler, uint64_t now_ms, FILE* log);
 
 // Scratch allocator
 scratch_allocator_t* scratch_create(size_t size);
@@ -104,6 +151,7 @@ void scratch_restore(scratch_allocator_t* scratch, size_t mark);
 // Allocation functions (use these instead of malloc/free directly)
 void* alloc(allocator_t* alloc, size_t size);
 void* alloc_aligned(allocator_t* alloc, size_t size, size_t alignment);
+void* alloc_zeroed(allocator_t* alloc, size_t size);
 void* realloc_ptr(allocator_t* alloc, void* ptr, size_t old_size, size_t new_size);
 void* realloc_aligned_ptr(allocator_t* alloc, void* ptr, size_t old_size, size_t new_size, size_t alignment);
 void free_ptr(allocator_t* alloc, void* ptr, size_t size);
@@ -6,6 +6,7 @@
 
 #include "core/types.h"
 #include "core/error.h"
+#include "core/event_bus.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -86,6 +87,11 @@ const channel_vtable_t* channel_telegram_get_vtable(void);
 const channel_vtable_t* channel_discord_get_vtable(void);
 const channel_vtable_t* channel_webhook_get_vtable(void);
 
+// Push agent turn, token and tool events from bus to WebSocket clients of
+// a webhook channel (GET /ws?session=<id>). Call before it starts listening.
+// cclaw agent does so when channels.webhook.stream_events is set.
+err_t channel_webhook_stream_events(channel_t* channel, event_bus_t* bus);
+
 // Channel creation helpers
 channel_t* channel_alloc(const channel_vtable_t* vtable);
 void channel_free(channel_t* channel);
@@ -94,6 +100,8 @@ void channel_free(channel_t* channel);
 channel_message_t* channel_message_create(const str_t* id, const str_t* sender,
                                          const str_t* content, const str_t* channel);
 void channel_message_free(channel_message_t* message);
+// Arrays of count messages, built like channel_message_create() builds one:
+// array and strings from the channels allocator, channel names interned
 void channel_message_array_free(channel_message_t* messages, uint32_t count);
 
 // Utility functions
@@ -116,4 +124,8 @@ err_t channel_manager_start_all(channel_manager_t* manager,
                                void* user_data);
 err_t channel_manager_stop_all(channel_manager_t* manager);
 
+// Start all channels with every incoming message published to bus as
+// EVENT_MESSAGE_RECEIVED, for agent workers subscribed there to pick up
+err_t channel_manager_start_publishing(channel_manager_t* manager, event_bus_t* bus);
+
 #endif // CCLAW_CORE_CHANNEL_H
\ No newline at end of file
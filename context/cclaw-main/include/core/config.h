@@ -17,6 +17,9 @@ typedef struct config_t {
     str_t api_key;
     str_t default_provider;
     str_t default_model;
+    str_t api_url;      // Overrides the provider's default base URL when set
+    bool response_chaining;     // api_url keeps responses for previous_response_id
+    bool differential_history;  // Send only new messages to a chaining provider
     double default_temperature;
 
     // Memory configuration
@@ -76,6 +79,11 @@ typedef struct config_t {
             str_t* allowed_workspace_roots;
             uint32_t allowed_workspace_roots_count;
         } docker;
+        // RUNTIME_KIND_SANDBOX reuses the docker limits, network and roots
+        struct {
+            str_t cgroup_dir;           // Delegated cgroup v2 directory; empty = rlimits
+            uint32_t max_processes;
+        } sandbox;
     } runtime;
 
     // Reliability configuration
@@ -129,6 +137,7 @@ typedef struct config_t {
         struct {
             uint16_t port;
             str_t secret;
+            bool stream_events;       // cclaw agent relays its events to /ws clients
         }* webhook;
         struct {
             str_t* allowed_contacts;
@@ -197,6 +206,18 @@ typedef struct config_t {
         str_t session_name;
     } browser;
 
+    // MCP servers, launched once at startup and kept running
+    struct {
+        str_t name;
+        str_t command;
+        str_t* args;
+        uint32_t args_count;
+        str_t* env;            // "KEY=value"
+        uint32_t env_count;
+        uint32_t timeout_ms;
+    }* mcp_servers;
+    uint32_t mcp_servers_count;
+
     // Composio configuration
     struct {
         bool enabled;
@@ -221,6 +242,8 @@ typedef struct config_t {
         str_t backend; // "none", "log", "prometheus", "otel"
         str_t otel_endpoint;
         str_t otel_service_name;
+        str_t trace_file;   // Span output file; empty disables tracing
+        str_t trace_format; // "chrome" or "otlp"
     } observability;
 
     // Allocator for dynamic data
@@ -0,0 +1,69 @@
+// delegate.h - Sub-agent delegation for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_DELEGATE_H
+#define CCLAW_CORE_DELEGATE_H
+
+#include "core/types.h"
+#include "core/error.h"
+#include "core/tool.h"
+#include "core/agent.h"
+#include "core/worker_pool.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A delegator runs child agents on behalf of a parent agent. Every task gets
+// a fresh session on its own child agent, so children never see the parent's
+// conversation or each other's. Children share the parent's memory and tools
+// (except "delegate" itself, so delegation is one level deep) and run
+// concurrently on a worker pool.
+//
+// HTTP clients are not thread-safe, so each worker owns a clone of the
+// parent's provider, created on first use and kept for the delegator's
+// lifetime. Concurrency is therefore bounded by the pool size.
+//
+// Budgets are enforced between loop iterations through the child session's
+// token_budget and deadline_ms; a provider call in flight is not interrupted.
+
+#define DELEGATE_MAX_TASKS 16
+#define DELEGATE_DEFAULT_CONCURRENCY 4
+#define DELEGATE_DEFAULT_MAX_ITERATIONS 8
+#define DELEGATE_DEFAULT_TIMEOUT_MS 120000
+#define DELEGATE_RESULT_MAX_CHARS 2000
+
+typedef struct delegator_t delegator_t;
+
+typedef struct delegate_task_t {
+    str_t name;                 // Label for the result; optional
+    str_t prompt;
+    uint32_t max_iterations;    // 0 = DELEGATE_DEFAULT_MAX_ITERATIONS
+    uint32_t token_budget;      // 0 = unlimited
+    uint32_t timeout_ms;        // 0 = DELEGATE_DEFAULT_TIMEOUT_MS
+} delegate_task_t;
+
+typedef struct delegate_result_t {
+    err_t status;               // ERR_TIMEOUT / ERR_CANCELLED for spent budgets
+    str_t output;               // Final answer or error text, truncated
+    bool truncated;
+    uint32_t tokens;
+    uint64_t elapsed_ms;
+} delegate_result_t;
+
+// concurrency 0 = DELEGATE_DEFAULT_CONCURRENCY. The parent must have a
+// provider and must outlive the delegator.
+err_t delegator_create(agent_t* parent, uint32_t concurrency, delegator_t** out_delegator);
+void delegator_destroy(delegator_t* delegator);
+
+// Runs every task and blocks until all have finished. out_results must hold
+// count entries; release them with delegate_results_free(). Fails only if
+// the tasks could not be started; per-task failures are in the results.
+err_t delegator_run(delegator_t* delegator, const delegate_task_t* tasks, uint32_t count,
+                    delegate_result_t* out_results);
+void delegate_results_free(delegate_result_t* results, uint32_t count);
+
+// Compact plain-text summary of a run, as handed back to the parent model
+str_t delegate_results_format(const delegate_task_t* tasks, const delegate_result_t* results,
+                              uint32_t count);
+
+#endif // CCLAW_CORE_DELEGATE_H
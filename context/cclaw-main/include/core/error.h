@@ -97,20 +97,20 @@ typedef struct error_ctx_t {
 } error_ctx_t;
 
 // Error creation macros
-#define ERR(code, msg) (error_ctx_t){ \
-    .code = (code), \
+#define ERR(err_code, msg) (error_ctx_t){ \
+    .code = (err_code), \
     .message = STR_LIT(msg), \
     .file = STR_LIT(__FILE__), \
     .line = __LINE__, \
     .cause = NULL \
 }
 
-#define ERR_WITH_CAUSE(code, msg, cause) (error_ctx_t){ \
-    .code = (code), \
+#define ERR_WITH_CAUSE(err_code, msg, err_cause) (error_ctx_t){ \
+    .code = (err_code), \
     .message = STR_LIT(msg), \
     .file = STR_LIT(__FILE__), \
     .line = __LINE__, \
-    .cause = (cause) \
+    .cause = (err_cause) \
 }
 
 // Error propagation macros
@@ -122,11 +122,13 @@ typedef struct error_ctx_t {
         } \
     } while (0)
 
+// Adds context to an error the callee may already have recorded: the
+// thread's most recent record becomes the cause when it carries the same code
 #define TRY_MSG(expr, msg) \
     do { \
         err_t __err = (expr); \
         if (__err != ERR_OK) { \
-            return error_set(__err, STR_LIT(msg), __FILE__, __LINE__); \
+            return error_propagate(__err, STR_LIT(msg), __FILE__, __LINE__); \
         } \
     } while (0)
 
@@ -145,21 +147,72 @@ typedef struct error_ctx_t {
         } \
     } while (0)
 
+// Record an error with a printf-style message. Arguments are captured by
+// value (strings are copied) and the message is only formatted when it is
+// read, so recording costs a few stores and no allocation.
+#define ERROR_SET(code, ...) error_setf((code), __FILE__, __LINE__, __VA_ARGS__)
+
+// Same, chaining the thread's most recent error as the cause
+#define ERROR_WRAP(code, ...) error_wrapf((code), __FILE__, __LINE__, __VA_ARGS__)
+
 // Error API functions
 err_t error_set(err_t code, str_t message, const char* file, uint32_t line);
 err_t error_set_with_cause(err_t code, str_t message, const char* file, uint32_t line, error_ctx_t* cause);
+err_t error_propagate(err_t code, str_t message, const char* file, uint32_t line);
+
+err_t error_setf(err_t code, const char* file, uint32_t line, const char* fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+err_t error_wrapf(err_t code, const char* file, uint32_t line, const char* fmt, ...)
+    __attribute__((format(printf, 4, 5)));
 
 const char* error_to_string(err_t code);
 str_t error_format(err_t code, str_t message);
 
+// Most recent error recorded on this thread, or NULL
+const error_ctx_t* error_last(void);
+
+// Message of an error, formatting a lazily recorded one on first use. The
+// view stays valid until the record is overwritten (see ERROR_RING_CAPACITY).
+str_t error_message(const error_ctx_t* error);
+
+// Render an error and its causes as "message (file:line): cause: ..." into
+// buf, truncating to fit. Returns the length that would have been written.
+size_t error_describe(const error_ctx_t* error, char* buf, size_t size);
+
 void error_print(error_ctx_t* error);
 void error_free(error_ctx_t* error);
 
-// Error context stack (thread-local)
+// Error context ring (thread-local). Each thread records into its own
+// fixed-capacity ring; once full, the oldest record is overwritten and any
+// cause link to it is cut. Pointers returned from the ring stay valid for
+// ERROR_RING_CAPACITY further records on the same thread.
+
+#define ERROR_RING_CAPACITY 16
+#define ERROR_MAX_ARGS 8
+#define ERROR_ARG_BYTES 160
+#define ERROR_MESSAGE_MAX 256
+
+typedef union error_arg_t {
+    long long i;
+    double d;
+    long double ld;
+    const void* p;
+} error_arg_t;
+
+typedef struct error_record_t {
+    error_ctx_t ctx;                      // Must stay first
+    const char* fmt;                      // NULL once formatted or for plain messages
+    error_arg_t args[ERROR_MAX_ARGS];
+    uint8_t arg_count;
+    uint16_t strings_used;
+    char strings[ERROR_ARG_BYTES];        // Copies of %s arguments
+    char text[ERROR_MESSAGE_MAX];         // Formatted message, built on demand
+} error_record_t;
+
 typedef struct error_stack_t {
-    error_ctx_t* errors;
-    uint32_t count;
-    uint32_t capacity;
+    error_record_t records[ERROR_RING_CAPACITY];
+    uint32_t head;                        // Next slot to write
+    uint32_t count;                       // Live records, at most ERROR_RING_CAPACITY
 } error_stack_t;
 
 error_stack_t* error_stack_get(void);
@@ -167,4 +220,4 @@ void error_stack_push(error_ctx_t error);
 error_ctx_t* error_stack_pop(void);
 void error_stack_clear(void);
 
-#endif // CCLAW_CORE_ERROR_H
\ No newline at end of file
+#endif // CCLAW_CORE_ERROR_H
@@ -0,0 +1,142 @@
+// event_bus.h - In-process event bus for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_EVENT_BUS_H
+#define CCLAW_CORE_EVENT_BUS_H
+
+#include "core/types.h"
+#include "core/error.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Typed events fanned out to subscribers. Each subscription has its own
+// bounded ring, lock-free for any number of publishers and consumers, so
+// several workers can share one subscription as a work queue while the
+// TUI and metrics each see every event on theirs. Publishing never takes
+// a lock; a consumer that runs dry may sleep, and publishers only touch
+// its mutex when someone is asleep.
+//
+// Events are immutable and reference counted: one copy is shared by every
+// subscription it reached. Consumers hand each event back with
+// event_release().
+
+#define EVENT_BUS_MAX_SUBSCRIBERS 32
+#define EVENT_BUS_DEFAULT_CAPACITY 1024
+#define EVENT_BUS_BLOCK_TIMEOUT_MS 100
+
+typedef enum event_type_t {
+    EVENT_MESSAGE_RECEIVED,     // source = channel, sender, text = message, session_id if bound
+    EVENT_TURN_STARTED,         // session_id, text = user input
+    EVENT_TOKEN_CHUNK,          // session_id, text = streamed reply text
+    EVENT_TOOL_FINISHED,        // session_id, source = tool, status, duration_ms, value = output bytes
+    EVENT_TURN_COMPLETED,       // session_id, text = reply, status, duration_ms, value = tokens used
+    EVENT_TYPE_COUNT
+} event_type_t;
+
+#define EVENT_TOPIC(type) (1u << (type))
+#define EVENT_TOPIC_ALL ((1u << EVENT_TYPE_COUNT) - 1)
+
+typedef struct event_t {
+    event_type_t type;
+    uint64_t sequence;          // Publish order across the bus; set by the bus
+    uint64_t timestamp_ms;      // Set by the bus
+    str_t session_id;
+    str_t source;
+    str_t sender;
+    str_t text;
+    err_t status;
+    uint64_t duration_ms;
+    uint64_t value;
+} event_t;
+
+// What a full subscription does with the next event
+typedef enum event_overflow_t {
+    EVENT_OVERFLOW_DROP_NEWEST, // Keep what is queued; the new event is lost
+    EVENT_OVERFLOW_DROP_OLDEST, // Make room by discarding the oldest event
+    EVENT_OVERFLOW_BLOCK,       // Publisher waits up to EVENT_BUS_BLOCK_TIMEOUT_MS
+} event_overflow_t;
+
+typedef struct event_bus_t event_bus_t;
+typedef struct event_subscription_t event_subscription_t;
+
+typedef struct event_subscription_stats_t {
+    uint64_t delivered;
+    uint64_t dropped;
+    uint32_t queued;
+} event_subscription_stats_t;
+
+err_t event_bus_create(event_bus_t** out_bus);
+
+// Subscriptions must be gone first
+void event_bus_destroy(event_bus_t* bus);
+
+// topics is a mask of EVENT_TOPIC() bits. capacity is rounded up to a
+// power of two; 0 = EVENT_BUS_DEFAULT_CAPACITY.
+err_t event_bus_subscribe(event_bus_t* bus, uint32_t topics, uint32_t capacity,
+                          event_overflow_t overflow, event_subscription_t** out_sub);
+
+// Waits for publishers still delivering to sub, then releases whatever it
+// holds. Consumers must have stopped.
+void event_bus_unsubscribe(event_bus_t* bus, event_subscription_t* sub);
+
+// Replaces the topics of sub, e.g. to take per-token chunks only while
+// someone downstream wants them. Events already queued stay queued.
+void event_bus_set_topics(event_bus_t* bus, event_subscription_t* sub, uint32_t topics);
+
+// Whether anyone listens to type. Lets producers skip building events
+// nobody wants, such as per-token chunks.
+bool event_bus_wants(const event_bus_t* bus, event_type_t type);
+
+// Copies event (strings included) and queues it on every matching
+// subscription. ERR_RATE_LIMITED when a full subscription lost it.
+err_t event_bus_publish(event_bus_t* bus, const event_t* event);
+
+// Up to max events without waiting; returns how many
+uint32_t event_bus_poll(event_subscription_t* sub, event_t** out_events, uint32_t max);
+
+// As poll, but waits up to timeout_ms (negative = forever) for the first
+// event. Returns 0 on timeout or after event_bus_wake().
+uint32_t event_bus_wait(event_subscription_t* sub, event_t** out_events, uint32_t max,
+                        int32_t timeout_ms);
+
+// Wake consumers waiting on sub, e.g. to shut them down
+void event_bus_wake(event_subscription_t* sub);
+
+void event_bus_stats(const event_subscription_t* sub, event_subscription_stats_t* out_stats);
+
+event_t* event_retain(event_t* event);
+void event_release(event_t* event);
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+// Process-wide totals kept by a consumer thread on a subscription of its
+// own, so producers never wait on them. Token chunks are not counted, and
+// so are not built for the metrics alone.
+typedef struct event_metrics_t {
+    uint64_t messages_received;
+    uint64_t turns_started;
+    uint64_t turns_completed;
+    uint64_t turns_failed;
+    uint64_t turn_duration_ms;      // Sum over completed turns
+    uint64_t tokens;
+    uint64_t tool_calls;
+    uint64_t tool_failures;
+    uint64_t tool_duration_ms;      // Sum over tool calls
+    uint64_t dropped;               // Events the metrics subscription lost
+} event_metrics_t;
+
+// One consumer per process; ERR_ALREADY_EXISTS while one runs
+err_t event_metrics_start(event_bus_t* bus);
+
+// Joins the consumer after counting what is queued; before the bus goes
+void event_metrics_stop(void);
+
+void event_metrics_get(event_metrics_t* out_metrics);
+
+// Prometheus text, as memory_cache_metrics()
+size_t event_metrics_format(char* buffer, size_t size);
+
+#endif // CCLAW_CORE_EVENT_BUS_H
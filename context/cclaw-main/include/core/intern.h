@@ -0,0 +1,46 @@
+// intern.h - Global string interner for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_INTERN_H
+#define CCLAW_CORE_INTERN_H
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Interned strings are stored once for the life of the process (or until
+// str_intern_shutdown()) and never freed by callers. Two interned strings
+// are equal exactly when their data pointers are equal, so repeated
+// identifiers -- model, tool, role and channel names -- cost no allocation
+// after first use and compare in O(1). Nothing is ever removed, so only
+// intern strings drawn from a small closed set; per-session or per-user
+// values such as session ids and senders would grow the table forever.
+//
+// The table is split into independently locked shards; lookups of strings
+// that are already present take only a shared (read) lock.
+
+typedef struct intern_stats_t {
+    uint64_t lookups;
+    uint64_t inserts;
+    uint32_t strings;
+    size_t bytes;           // String storage, including terminators
+} intern_stats_t;
+
+// Canonical copy of s (NUL-terminated). STR_NULL on allocation failure;
+// the empty string interns to a static "".
+str_t str_intern(str_t s);
+str_t str_intern_cstr(const char* s);
+
+// Pointer comparison; only meaningful for interned strings
+static inline bool str_interned_equal(str_t a, str_t b) {
+    return a.data == b.data;
+}
+
+void str_intern_stats(intern_stats_t* out_stats);
+
+// Free every interned string. Only for process teardown and tests: any
+// str_t obtained from str_intern() dangles afterwards.
+void str_intern_shutdown(void);
+
+#endif // CCLAW_CORE_INTERN_H
@@ -0,0 +1,98 @@
+// mcp.h - Model Context Protocol client for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_MCP_H
+#define CCLAW_CORE_MCP_H
+
+#include "core/types.h"
+#include "core/error.h"
+#include "core/tool.h"
+#include "core/config.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Each configured MCP server is launched once and kept running as a child
+// process speaking newline-delimited JSON-RPC 2.0 over its stdin/stdout.
+// A reader thread per server routes responses to waiting callers by id, so
+// any number of requests can be in flight on one pipe. tools/list results
+// are cached until the server sends notifications/tools/list_changed.
+//
+// Remote tools are bridged into the tool registry as "mcp_<server>_<tool>",
+// each with its own generated tool_vtable_t drawn from a fixed pool of
+// MCP_MAX_TOOL_SLOTS.
+
+#define MCP_MAX_SERVERS 8
+#define MCP_MAX_TOOL_SLOTS 32
+#define MCP_DEFAULT_TIMEOUT_MS 30000
+#define MCP_PROTOCOL_VERSION "2024-11-05"
+
+typedef struct mcp_client_t mcp_client_t;
+
+typedef struct mcp_server_config_t {
+    str_t name;                 // Used in registered tool names
+    str_t command;              // Resolved through PATH
+    const str_t* args;
+    uint32_t args_count;
+    const str_t* env;           // "KEY=value", added to a minimal inherited set
+    uint32_t env_count;
+    uint32_t timeout_ms;        // Per request; 0 = MCP_DEFAULT_TIMEOUT_MS
+} mcp_server_config_t;
+
+// Tool definition as advertised by tools/list
+typedef struct mcp_tool_def_t {
+    str_t name;
+    str_t description;
+    str_t input_schema;         // JSON
+} mcp_tool_def_t;
+
+// Client lifecycle. start spawns the server and completes the initialize
+// handshake; stop unregisters the client's tools and reaps the process.
+// Bridged tool calls still in flight when it stops return an error (or
+// the server's answer, if it finishes them while exiting) and release the
+// client last.
+err_t mcp_client_start(const mcp_server_config_t* config, mcp_client_t** out_client);
+void mcp_client_stop(mcp_client_t* client);
+
+str_t mcp_client_name(const mcp_client_t* client);
+bool mcp_client_is_alive(mcp_client_t* client);
+
+// Raw JSON-RPC call. params is a JSON value (STR_NULL to omit); on success
+// out_result receives the "result" member as JSON (free with free()).
+// Safe to call from several threads at once.
+err_t mcp_client_request(mcp_client_t* client, const char* method, str_t params, str_t* out_result);
+
+// Remote tools, served from the cache when it is current. The returned
+// array is a copy; release it with mcp_tool_defs_free().
+err_t mcp_client_list_tools(mcp_client_t* client, mcp_tool_def_t** out_tools, uint32_t* out_count);
+void mcp_tool_defs_free(mcp_tool_def_t* tools, uint32_t count);
+
+// tools/call; text content is joined into the result, isError maps to a
+// failed result
+err_t mcp_client_call_tool(mcp_client_t* client, str_t name, str_t args_json, tool_result_t* out_result);
+
+// Register every remote tool not registered yet. Not thread-safe with
+// respect to the tool registry, like tool_register().
+err_t mcp_client_register_tools(mcp_client_t* client, uint32_t* out_registered);
+
+// After notifications/tools/list_changed, bring a client's registered
+// tools in line with its current list: removed tools are unregistered,
+// new ones registered, and the rest keep working with updated description
+// and schema. Instances of removed tools report themselves unavailable.
+// *out_changed tells whether the list was fetched again. Does nothing for
+// clients whose tools were never registered. Same registry rules as
+// mcp_client_register_tools(): call it between turns.
+err_t mcp_client_refresh_tools(mcp_client_t* client, bool* out_changed);
+
+// Start every server in config->mcp_servers and register its tools.
+// Servers that fail to start are reported on stderr and skipped.
+err_t mcp_start_configured(const config_t* config);
+// mcp_client_refresh_tools() on each; true if any changed, in which case
+// tool instances created before the call should be recreated. The agent
+// runtime does this at the start of each turn.
+bool mcp_refresh_tools(void);
+// Also frees the tool strings retired by refreshes, so nothing may still
+// hold what a bridged tool's get_name() or get_description() returned
+void mcp_stop_all(void);
+
+#endif // CCLAW_CORE_MCP_H
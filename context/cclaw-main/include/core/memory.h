@@ -21,7 +21,10 @@ typedef struct memory_config_t {
     str_t data_dir;         // Directory for memory storage
     uint32_t max_entries;   // Maximum number of entries to store
     bool compression;       // Enable compression
+    str_t compression_codec; // "deflate" or "zstd" (zstd builds only); empty = deflate
     uint32_t retention_days; // Days to keep entries
+    uint32_t cache_entries;  // Recall-by-key cache capacity (0 = disabled)
+    uint32_t reader_connections; // SQLite read-only connections (0 = reads share the writer)
 } memory_config_t;
 
 // Memory search options
@@ -79,6 +82,8 @@ struct memory_t {
     memory_config_t config;
     void* impl_data;           // Backend-specific data
     bool initialized;
+    uint64_t generation;       // Write counter, see memory_generation()
+    memory_t* wrapped;         // Decorators: the memory they wrap
 };
 
 // Helper macros for memory backend implementation
@@ -101,6 +106,30 @@ const memory_vtable_t* memory_null_get_vtable(void);  // Null backend for testin
 memory_t* memory_alloc(const memory_vtable_t* vtable);
 void memory_free(memory_t* memory);
 
+// Changes whenever entries may have changed, for callers caching what they
+// recalled. Backends bump it after every write, restore included, so it
+// moves whoever writes. The counter belongs to the backend: both calls
+// follow decorators down to the memory they wrap.
+uint64_t memory_generation(const memory_t* memory);
+void memory_bump_generation(memory_t* memory);
+
+// Decorators (take ownership of the wrapped backend)
+err_t memory_traced_wrap(memory_t* inner, memory_t** out_memory);
+err_t memory_cached_wrap(memory_t* inner, uint32_t capacity, memory_t** out_memory);
+
+// Read-cache counters, aggregated over every cached backend in the process
+typedef struct memory_cache_stats_t {
+    uint64_t hits;              // Recalls answered with a cached entry
+    uint64_t negative_hits;     // Recalls answered with a cached ERR_NOT_FOUND
+    uint64_t misses;            // Recalls forwarded to the backend
+    uint64_t evictions;
+    uint64_t invalidations;
+} memory_cache_stats_t;
+
+void memory_cache_stats(memory_cache_stats_t* out_stats);
+double memory_cache_hit_rate(const memory_cache_stats_t* stats);
+size_t memory_cache_metrics(char* buffer, size_t size);
+
 // Entry helpers
 memory_entry_t* memory_entry_create(const str_t* key, const str_t* content,
                                     memory_category_t category, const str_t* session_id);
@@ -124,5 +153,7 @@ memory_config_t memory_config_default(void);
 // Default retention period (30 days)
 #define MEMORY_RETENTION_DAYS_DEFAULT 30
 #define MEMORY_MAX_ENTRIES_DEFAULT 10000
+#define MEMORY_CACHE_ENTRIES_DEFAULT 256
+#define MEMORY_READER_CONNECTIONS_DEFAULT 4
 
 #endif // CCLAW_CORE_MEMORY_H
\ No newline at end of file
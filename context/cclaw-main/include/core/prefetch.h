@@ -0,0 +1,55 @@
+// prefetch.h - Speculative execution of read-only tool calls for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_PREFETCH_H
+#define CCLAW_CORE_PREFETCH_H
+
+#include "core/tool.h"
+#include "core/error.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// While a reply streams, each tool call is known as soon as its arguments
+// are complete. Calls to read-only tools are started right away on a
+// background thread so they overlap with the rest of the generation; once
+// the response is final the agent takes the results of the calls it
+// confirms and the rest are thrown away.
+//
+// Speculative calls run one at a time, in the order offered. The caller
+// must not execute tools itself while any are running (see
+// tool_prefetch_wait()), so tools never see concurrent calls.
+
+#define TOOL_PREFETCH_MAX_CALLS 16
+
+typedef struct tool_prefetch_t tool_prefetch_t;
+
+typedef struct tool_prefetch_stats_t {
+    uint32_t started;
+    uint32_t used;
+    uint32_t discarded;         // Ran, or were queued, but never taken
+} tool_prefetch_stats_t;
+
+err_t tool_prefetch_create(tool_prefetch_t** out_prefetch);
+
+// Waits for a running call; queued ones are dropped
+void tool_prefetch_destroy(tool_prefetch_t* prefetch);
+
+// Queue tool(arguments) if the tool is read-only and the same call is not
+// already pending. Returns whether it was queued.
+bool tool_prefetch_offer(tool_prefetch_t* prefetch, tool_t* tool, str_t arguments);
+
+// Block until every queued call has finished
+void tool_prefetch_wait(tool_prefetch_t* prefetch);
+
+// Hand over the outcome of a speculative call to tool with exactly these
+// arguments, waiting for it if needed. out_result takes ownership of the
+// strings. Returns false if there is no such call.
+bool tool_prefetch_take(tool_prefetch_t* prefetch, const tool_t* tool, str_t arguments,
+                        err_t* out_err, tool_result_t* out_result);
+
+// Cancel what has not started, wait for what has, and drop every result
+// not taken. out_stats (may be NULL) covers the calls since the last reset.
+void tool_prefetch_reset(tool_prefetch_t* prefetch, tool_prefetch_stats_t* out_stats);
+
+#endif // CCLAW_CORE_PREFETCH_H
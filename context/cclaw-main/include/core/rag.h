@@ -0,0 +1,114 @@
+// rag.h - Workspace retrieval index for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_RAG_H
+#define CCLAW_CORE_RAG_H
+
+#include "core/types.h"
+#include "core/error.h"
+#include "core/config.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Text files under the workspace are split into line-aligned chunks of about
+// chunk_max_tokens, embedded, and stored in a flat index file that is mapped
+// read-only for search. Vectors are int8 with a per-chunk scale, a quarter
+// of the float size, and queries are scored against every chunk.
+//
+// Updates are incremental: files whose size, mtime and inode match the index
+// keep their chunks and vectors; only new or changed files are re-embedded.
+// On Linux an inotify watch on each indexed directory tells search when a
+// rescan is needed at all; elsewhere every search does a stat-only rescan.
+//
+// Chunk text is not stored. Hits are read back from the file at search time.
+
+#define RAG_INDEX_DIR ".cclaw/rag"
+#define RAG_INDEX_FILE "index.bin"
+#define RAG_HASH_DIMENSIONS 512
+#define RAG_DEFAULT_CHUNK_TOKENS 512
+#define RAG_MAX_FILE_SIZE (1024 * 1024)
+#define RAG_MAX_FILES 20000
+#define RAG_MAX_RESULTS 20
+#define RAG_SNIPPET_MAX_BYTES 1500
+#define RAG_EMBED_BATCH 32
+
+// ============================================================================
+// Embedders
+// ============================================================================
+
+typedef struct rag_embedder_t rag_embedder_t;
+
+struct rag_embedder_t {
+    str_t name;                 // Recorded in the index; a change forces a rebuild
+    uint32_t dimensions;
+
+    // Writes count * dimensions floats
+    err_t (*embed)(rag_embedder_t* embedder, const str_t* texts, uint32_t count, float* out_vectors);
+    void (*destroy)(rag_embedder_t* embedder);
+    void* impl_data;
+};
+
+// Offline feature-hashing embedder over identifiers and their sub-words.
+// Deterministic and free; good for code search, weak on paraphrase.
+rag_embedder_t* rag_hash_embedder_create(uint32_t dimensions);
+
+// OpenAI-compatible POST {base_url}/embeddings
+rag_embedder_t* rag_http_embedder_create(str_t base_url, str_t api_key, str_t model, uint32_t dimensions);
+
+// From config->memory.embedding_*: "openai", "custom:<base url>", or
+// anything else for the hashing embedder
+err_t rag_embedder_create_configured(const config_t* config, rag_embedder_t** out_embedder);
+
+void rag_embedder_free(rag_embedder_t* embedder);
+
+// ============================================================================
+// Index
+// ============================================================================
+
+typedef struct rag_index_t rag_index_t;
+
+typedef struct rag_update_stats_t {
+    uint32_t files;             // Indexed after the update
+    uint32_t files_embedded;    // New or changed
+    uint32_t files_reused;
+    uint32_t files_removed;
+    uint32_t chunks;
+} rag_update_stats_t;
+
+typedef struct rag_hit_t {
+    str_t path;                 // Relative to the workspace
+    uint32_t start_line;        // 1-based, inclusive
+    uint32_t end_line;
+    float score;                // Cosine similarity
+    str_t snippet;              // Current file contents for the line range
+    bool stale;                 // File changed since it was indexed
+} rag_hit_t;
+
+// Takes ownership of embedder. Loads an existing index from
+// <root>/RAG_INDEX_DIR when it was built with the same embedder and chunk
+// size; nothing is scanned until the first update or search.
+err_t rag_index_open(str_t root, uint32_t chunk_max_tokens, rag_embedder_t* embedder,
+                     rag_index_t** out_index);
+void rag_index_close(rag_index_t* index);
+
+// Rescan the workspace and rewrite the index file. out_stats may be NULL.
+err_t rag_index_update(rag_index_t* index, rag_update_stats_t* out_stats);
+
+// Top hits for query, refreshing the index first if files changed.
+// path_prefix (may be empty) restricts results to a subtree. Safe to call
+// from several threads; calls are serialized.
+err_t rag_index_search(rag_index_t* index, str_t query, uint32_t limit, str_t path_prefix,
+                       rag_hit_t** out_hits, uint32_t* out_count);
+void rag_hits_free(rag_hit_t* hits, uint32_t count);
+
+// Remember the workspace and embedding settings from config (copied) for
+// rag_index_open_configured(), which the workspace_search tool uses. Without
+// a configuration the hashing embedder and default chunk size are used.
+void rag_configure(const config_t* config);
+void rag_shutdown(void);
+
+// root may be empty to use the configured workspace
+err_t rag_index_open_configured(str_t root, rag_index_t** out_index);
+
+#endif // CCLAW_CORE_RAG_H
@@ -0,0 +1,84 @@
+// sandbox.h - Namespace sandbox for tool execution in CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_SANDBOX_H
+#define CCLAW_CORE_SANDBOX_H
+
+#include "core/types.h"
+#include "core/error.h"
+#include "core/config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Isolation is set up once: sandbox_create() forks a zygote that enters
+// new user, mount, pid, ipc and uts namespaces (and a network namespace
+// unless networking is allowed). Inside it pivots into a fresh root where
+// only the system directories (read-only) and the workspace roots
+// (read-write) are bind mounted, then locks itself down with
+// no_new_privs, an empty capability set and a seccomp filter.
+// Each call forks a worker from the zygote in a few milliseconds; the
+// worker inherits all of that and talks to the caller over a socket of
+// its own, so calls run concurrently.
+//
+// Resource limits go to a cgroup when a delegated cgroup v2 directory is
+// configured, and fall back to per-process rlimits otherwise.
+//
+// The zygote is a fork of the calling process, so create the sandbox
+// before starting threads that may hold locks other than libc's.
+
+#define SANDBOX_MAX_ARG_LEN (60 * 1024)     // Command or path sent to the zygote
+
+typedef struct sandbox_t sandbox_t;
+
+typedef struct sandbox_config_t {
+    str_t workspace_dir;            // Bound read-write; working directory of commands
+    const str_t* extra_roots;       // Also bound read-write at the same paths
+    uint32_t extra_root_count;
+    bool home_writable;             // $HOME is bound read-write as well
+    bool read_only_rootfs;          // / is read-only (system directories always are)
+    bool network;                   // false = empty network namespace
+    uint64_t memory_limit_mb;       // 0 = unlimited
+    double cpu_limit;               // CPUs; 0 = unlimited (cgroup only)
+    uint32_t max_processes;         // 0 = 256 (cgroup only)
+    str_t cgroup_dir;               // Delegated cgroup v2 directory; empty = rlimits
+} sandbox_config_t;
+
+typedef struct sandbox_result_t {
+    int exit_code;                  // -1 when killed by a signal
+    int term_signal;
+    bool timed_out;
+    bool truncated;                 // Output beyond max_output was discarded
+    char* output;                   // stdout and stderr, NUL terminated
+    size_t output_len;
+} sandbox_result_t;
+
+// Limits from config.runtime.docker, cgroup from config.runtime.sandbox,
+// roots from allowed_workspace_roots, and the home directory too unless
+// autonomy.workspace_only is set. Strings are borrowed from config.
+sandbox_config_t sandbox_config_from(const config_t* config, str_t workspace_dir);
+
+// ERR_SANDBOX_FAILED when the kernel refuses namespaces (e.g. unprivileged
+// user namespaces disabled); the error message says which step failed.
+// ERR_NOT_IMPLEMENTED outside Linux on x86-64 and aarch64.
+err_t sandbox_create(const sandbox_config_t* config, sandbox_t** out_sandbox);
+void sandbox_destroy(sandbox_t* sandbox);
+
+// Whether limits are enforced by a cgroup rather than rlimits
+bool sandbox_uses_cgroup(const sandbox_t* sandbox);
+
+// Runs command with /bin/sh -c in the workspace. A non-zero exit is not an
+// error; ERR_OK means the command ran and out_result says how it ended.
+err_t sandbox_exec(sandbox_t* sandbox, const char* command, uint32_t timeout_ms,
+                   size_t max_output, sandbox_result_t* out_result);
+void sandbox_result_free(sandbox_result_t* result);
+
+// File access as seen from inside the sandbox. Relative paths are taken
+// from the caller's working directory.
+err_t sandbox_read_file(sandbox_t* sandbox, const char* path, size_t max_size,
+                        char** out_data, size_t* out_len);
+err_t sandbox_write_file(sandbox_t* sandbox, const char* path, const char* data, size_t len,
+                         bool allow_overwrite);
+
+#endif // CCLAW_CORE_SANDBOX_H
@@ -0,0 +1,75 @@
+// str_builder.h - Allocator-aware string builder for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_STR_BUILDER_H
+#define CCLAW_CORE_STR_BUILDER_H
+
+#include "types.h"
+#include "alloc.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Builds a string in place instead of formatting into a temporary and
+// copying. A builder can start on a caller-supplied (typically stack)
+// buffer and only moves to the heap once it outgrows it; finishing copies
+// the result exactly once, into whichever allocator should own it (often
+// an arena).
+//
+// Allocation failure is sticky: appends after a failure are ignored and
+// str_builder_finish() returns STR_NULL, so call sites can append freely
+// and check once at the end.
+
+typedef struct str_builder_t {
+    allocator_t* alloc;     // Growth allocator; NULL means the system heap
+    char* data;             // Always NUL-terminated when cap > 0
+    size_t len;
+    size_t cap;
+    bool owns_data;         // false while still on the caller's buffer
+    bool failed;
+} str_builder_t;
+
+// Start empty; the first append allocates from alloc
+void str_builder_init(str_builder_t* sb, allocator_t* alloc);
+
+// Start on buf (not owned); grows into alloc when buf is too small
+void str_builder_init_buffer(str_builder_t* sb, allocator_t* alloc, char* buf, size_t size);
+
+// Ensure room for extra more bytes (plus the terminator)
+bool str_builder_reserve(str_builder_t* sb, size_t extra);
+
+void str_builder_append(str_builder_t* sb, str_t s);
+void str_builder_append_cstr(str_builder_t* sb, const char* s);
+void str_builder_append_bytes(str_builder_t* sb, const char* data, size_t len);
+void str_builder_append_char(str_builder_t* sb, char c);
+void str_builder_append_int(str_builder_t* sb, int64_t value);
+void str_builder_append_uint(str_builder_t* sb, uint64_t value);
+
+// Shortest of %.15g / %.17g that round-trips
+void str_builder_append_float(str_builder_t* sb, double value);
+
+// Contents of a JSON string literal (no surrounding quotes)
+void str_builder_append_json_escaped(str_builder_t* sb, str_t s);
+
+// Formats straight into the builder; vsnprintf runs a second time only
+// when the output did not fit the space already reserved
+void str_builder_appendf(str_builder_t* sb, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+void str_builder_vappendf(str_builder_t* sb, const char* fmt, va_list args);
+
+// View of the current contents; valid until the next append
+str_t str_builder_view(const str_builder_t* sb);
+
+// Drop the contents, keeping the buffer
+void str_builder_reset(str_builder_t* sb);
+
+// Copy the contents into out_alloc (NULL = system heap, releasable with
+// free()) and release the builder. STR_NULL after an allocation failure.
+str_t str_builder_finish(str_builder_t* sb, allocator_t* out_alloc);
+
+// Release the builder without producing a string
+void str_builder_free(str_builder_t* sb);
+
+#endif // CCLAW_CORE_STR_BUILDER_H
@@ -14,6 +14,7 @@
 // Forward declarations
 typedef struct tool_t tool_t;
 typedef struct tool_vtable_t tool_vtable_t;
+typedef struct sandbox_t sandbox_t;
 
 // Tool result structure
 typedef struct tool_result_t {
@@ -27,6 +28,7 @@ typedef struct tool_context_t {
     void* user_data;           // User-provided context
     memory_t* memory;          // Memory system for memory tools
     str_t workspace_dir;       // Current workspace directory
+    sandbox_t* sandbox;        // Borrowed; shell and file tools run inside it when set
     // Add other context fields as needed
 } tool_context_t;
 
@@ -56,6 +58,15 @@ struct tool_vtable_t {
 
     // Whether this tool is allowed in autonomous mode
     bool (*allowed_in_autonomous)(autonomy_level_t level);
+
+    // Whether execute() has no side effects, so a call may run early or be
+    // thrown away. Optional; see tool_is_read_only().
+    bool (*is_read_only)(void);
+
+    // A value that changes whenever the result of execute(args) may have,
+    // such as a file's mtime and size. Optional; false (or no callback)
+    // means the call is not cached.
+    bool (*cache_validator)(tool_t* tool, const str_t* args, uint64_t* out_validator);
 };
 
 // Tool instance structure
@@ -70,6 +81,7 @@ struct tool_t {
 err_t tool_registry_init(void);
 void tool_registry_shutdown(void);
 err_t tool_register(const char* name, const tool_vtable_t* vtable);
+err_t tool_unregister(const char* name);
 err_t tool_create(const char* name, tool_t** out_tool);
 err_t tool_registry_list(const char*** out_names, uint32_t* out_count);
 
@@ -80,11 +92,18 @@ const tool_vtable_t* file_write_tool_get_vtable(void);
 const tool_vtable_t* memory_store_tool_get_vtable(void);
 const tool_vtable_t* memory_recall_tool_get_vtable(void);
 const tool_vtable_t* memory_forget_tool_get_vtable(void);
+const tool_vtable_t* delegate_tool_get_vtable(void);   // user_data = parent agent_t
+const tool_vtable_t* workspace_search_tool_get_vtable(void);
+const tool_vtable_t* tool_output_read_tool_get_vtable(void);
 
 // Tool creation helpers
 tool_t* tool_alloc(const tool_vtable_t* vtable);
 void tool_free(tool_t* tool);
 
+// is_read_only() when the tool has one, otherwise whether it is allowed at
+// AUTONOMY_LEVEL_READONLY
+bool tool_is_read_only(const tool_t* tool);
+
 // Result helpers
 tool_result_t tool_result_create(void);
 void tool_result_free(tool_result_t* result);
@@ -95,6 +114,7 @@ void tool_result_set_error(tool_result_t* result, const str_t* error_message);
 tool_context_t tool_context_default(void);
 err_t tool_context_set_memory(tool_context_t* context, memory_t* memory);
 err_t tool_context_set_workspace(tool_context_t* context, const str_t* workspace_dir);
+err_t tool_context_set_sandbox(tool_context_t* context, sandbox_t* sandbox);
 
 // Helper macros for tool implementation
 #define TOOL_IMPLEMENT(name, vtable_ptr) \
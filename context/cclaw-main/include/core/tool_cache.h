@@ -0,0 +1,82 @@
+// tool_cache.h - Per-session tool result cache for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_TOOL_CACHE_H
+#define CCLAW_CORE_TOOL_CACHE_H
+
+#include "core/tool.h"
+#include "core/error.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Results of read-only tool calls are kept per session, keyed on the tool
+// name and the arguments with object keys sorted and whitespace dropped, so
+// {"path": "a"} and {"path":"a"} hit the same entry. Each entry records the
+// tool's cache_validator() at the time of the call and is only served while
+// the validator still matches. A call with side effects drops the entries
+// it may have affected: memory writers drop memory tool results, anything
+// else drops everything.
+//
+// Outputs are immutable and reference counted. Every tool message that
+// repeats a cached result points at the same bytes.
+
+#define TOOL_CACHE_MAX_ENTRIES 64
+#define TOOL_CACHE_MAX_BYTES (8 * 1024 * 1024)
+
+// ============================================================================
+// Shared outputs
+// ============================================================================
+
+// Copy content into a new shared output with one reference
+str_t tool_output_share(str_t content);
+str_t tool_output_retain(str_t shared);
+void tool_output_release(str_t shared);
+
+// ============================================================================
+// Cache
+// ============================================================================
+
+typedef struct tool_cache_t tool_cache_t;
+
+typedef struct tool_cache_key_t {
+    const tool_t* tool;
+    str_t text;                 // name NUL canonical args; owned
+    uint64_t hash;
+    uint64_t validator;
+} tool_cache_key_t;
+
+typedef struct tool_cache_stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stale;             // Found, but the validator had moved
+    uint64_t invalidations;
+    uint32_t entries;
+    size_t bytes;
+} tool_cache_stats_t;
+
+err_t tool_cache_create(tool_cache_t** out_cache);
+void tool_cache_destroy(tool_cache_t* cache);
+
+// Sorted keys, no insignificant whitespace. Arguments that are not JSON
+// are returned as they are. Heap copy.
+str_t tool_cache_canonical_args(str_t args);
+
+// Build the key for tool(args), taking the validator now. False when the
+// tool is not cacheable or the validator is unavailable.
+bool tool_cache_key_init(tool_cache_key_t* key, tool_t* tool, str_t args);
+void tool_cache_key_free(tool_cache_key_t* key);
+
+// A new reference to the cached output, or false
+bool tool_cache_get(tool_cache_t* cache, const tool_cache_key_t* key, str_t* out_shared);
+
+// Keep a reference to shared under key. Outputs over a quarter of
+// TOOL_CACHE_MAX_BYTES are not kept.
+void tool_cache_put(tool_cache_t* cache, const tool_cache_key_t* key, str_t shared);
+
+// After writer ran
+void tool_cache_invalidate(tool_cache_t* cache, const tool_t* writer);
+
+void tool_cache_stats(const tool_cache_t* cache, tool_cache_stats_t* out_stats);
+
+#endif // CCLAW_CORE_TOOL_CACHE_H
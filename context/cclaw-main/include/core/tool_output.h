@@ -0,0 +1,59 @@
+// tool_output.h - Spill store for large tool outputs in CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_TOOL_OUTPUT_H
+#define CCLAW_CORE_TOOL_OUTPUT_H
+
+#include "core/types.h"
+#include "core/error.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A tool output over the spill threshold does not go into the context. It
+// is written once to a per-session directory, named by its SHA-256, and
+// the context gets its head and tail plus the handle. The model pages
+// through the rest with the tool_output_read tool. Equal outputs share one
+// file; the directory is removed with the session.
+
+#define TOOL_OUTPUT_SPILL_BYTES (32 * 1024)
+#define TOOL_OUTPUT_HEAD_BYTES (4 * 1024)
+#define TOOL_OUTPUT_TAIL_BYTES (2 * 1024)
+#define TOOL_OUTPUT_PAGE_BYTES (16 * 1024)
+#define TOOL_OUTPUT_HANDLE_LEN 16          // Hex digits of the digest kept
+
+typedef struct tool_output_store_t tool_output_store_t;
+
+typedef struct tool_output_handle_t {
+    char hex[TOOL_OUTPUT_HANDLE_LEN + 1];
+} tool_output_handle_t;
+
+// Create dir (and its parents) with mode 0700
+err_t tool_output_store_open(const char* dir, tool_output_store_t** out_store);
+
+// remove deletes the blobs and the directory
+void tool_output_store_close(tool_output_store_t* store, bool remove);
+
+// Write content unless a blob with the same digest is already there
+err_t tool_output_store_put(tool_output_store_t* store, str_t content,
+                            tool_output_handle_t* out_handle);
+
+// Up to max bytes from offset of a blob in store. out is a heap copy;
+// out_total is the blob size. ERR_NOT_FOUND for unknown handles or a NULL
+// store, so one session can never page through another's outputs.
+err_t tool_output_read(const tool_output_store_t* store, str_t handle, uint64_t offset,
+                       uint32_t max, str_t* out, uint64_t* out_total);
+
+// Tools are shared by every session of an agent, so the agent binds the
+// calling session's store to the thread for the length of a tool call and
+// the tool_output_read tool reads from the bound one. bind returns the
+// previous binding for the caller to restore.
+tool_output_store_t* tool_output_bind(tool_output_store_t* store);
+tool_output_store_t* tool_output_bound(void);
+
+// What goes into the context instead of content: a header naming the size
+// and handle, then the head and tail cut at line breaks. handle may be NULL
+// when the spill failed; the content is still cut. Heap copy.
+str_t tool_output_excerpt(str_t content, const tool_output_handle_t* handle);
+
+#endif // CCLAW_CORE_TOOL_OUTPUT_H
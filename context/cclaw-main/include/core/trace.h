@@ -0,0 +1,75 @@
+// trace.h - Lightweight tracing spans for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_TRACE_H
+#define CCLAW_CORE_TRACE_H
+
+#include "types.h"
+#include "error.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Spans are recorded into per-thread ring buffers (lock-free, single producer)
+// and drained by a background flusher thread. When tracing is disabled every
+// TRACE_* macro costs one relaxed atomic load.
+
+typedef enum {
+    TRACE_FORMAT_CHROME = 0,  // Chrome trace-event JSON (chrome://tracing, Perfetto)
+    TRACE_FORMAT_OTLP,        // OTLP-JSON, one ExportTraceServiceRequest per line
+} trace_format_t;
+
+typedef struct trace_config_t {
+    const char* path;             // Output file
+    trace_format_t format;
+    const char* service_name;     // OTLP resource service.name
+    uint32_t ring_capacity;       // Events per thread, rounded up to a power of two
+    uint32_t flush_interval_ms;   // Background flush period
+} trace_config_t;
+
+#define TRACE_MAX_DEPTH 32
+#define TRACE_MAX_ARGS 4
+#define TRACE_NAME_MAX 48
+
+extern atomic_bool g_trace_enabled;
+
+static inline bool trace_enabled(void) {
+    return atomic_load_explicit(&g_trace_enabled, memory_order_relaxed);
+}
+
+// Lifecycle
+trace_config_t trace_config_default(void);
+err_t trace_init(const trace_config_t* config);
+void trace_shutdown(void);
+void trace_flush(void);
+
+// Monotonic clock in nanoseconds
+uint64_t trace_now_ns(void);
+
+// Span API. Names are copied; categories and arg keys must be string literals.
+void trace_span_begin_impl(const char* name, const char* category);
+void trace_span_begin_str_impl(str_t name, const char* category);
+void trace_span_end_impl(void);
+void trace_span_arg_impl(const char* key, int64_t value);
+
+// Record an already-finished span as a child of the current open span.
+void trace_span_record_impl(const char* name, const char* category,
+                            uint64_t start_ns, uint64_t end_ns);
+
+// Statistics
+uint64_t trace_dropped_events(void);
+
+#define TRACE_BEGIN(name, category) \
+    do { if (trace_enabled()) trace_span_begin_impl((name), (category)); } while (0)
+
+#define TRACE_BEGIN_STR(name, category) \
+    do { if (trace_enabled()) trace_span_begin_str_impl((name), (category)); } while (0)
+
+#define TRACE_END() \
+    do { if (trace_enabled()) trace_span_end_impl(); } while (0)
+
+#define TRACE_ARG(key, value) \
+    do { if (trace_enabled()) trace_span_arg_impl((key), (int64_t)(value)); } while (0)
+
+#endif // CCLAW_CORE_TRACE_H
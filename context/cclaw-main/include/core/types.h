@@ -61,7 +61,8 @@ typedef enum {
 typedef enum {
     RUNTIME_KIND_NATIVE,
     RUNTIME_KIND_DOCKER,
-    RUNTIME_KIND_WASM
+    RUNTIME_KIND_WASM,
+    RUNTIME_KIND_SANDBOX        // Namespace sandbox, see core/sandbox.h
 } runtime_kind_t;
 
 // Provider types
@@ -163,6 +164,7 @@ typedef struct channel_message_t {
     str_t sender;
     str_t content;
     str_t channel;
+    str_t session_id;   // Borrowed; set by channels that know the conversation
     uint64_t timestamp;
 } channel_message_t;
 
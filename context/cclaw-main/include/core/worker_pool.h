@@ -0,0 +1,54 @@
+// worker_pool.h - Fixed-size worker thread pool for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_CORE_WORKER_POOL_H
+#define CCLAW_CORE_WORKER_POOL_H
+
+#include "core/error.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// A fixed set of threads draining a bounded FIFO of jobs. Each job is told
+// the index of the worker running it, so callers can keep per-worker state
+// (such as a provider connection) in a plain array without locking.
+//
+// Completion is tracked with a worker_group_t: add jobs through
+// worker_group_submit() and block in worker_group_wait() until all of them
+// have run.
+
+#define WORKER_POOL_MAX_THREADS 64
+#define WORKER_POOL_DEFAULT_QUEUE 256
+
+typedef struct worker_pool_t worker_pool_t;
+
+typedef void (*worker_job_fn)(void* arg, uint32_t worker_index);
+
+// queue_capacity 0 = WORKER_POOL_DEFAULT_QUEUE
+err_t worker_pool_create(uint32_t threads, uint32_t queue_capacity, worker_pool_t** out_pool);
+
+// Runs every job already queued, then joins the threads
+void worker_pool_destroy(worker_pool_t* pool);
+
+uint32_t worker_pool_size(const worker_pool_t* pool);
+
+// Fails with ERR_RATE_LIMITED when the queue is full and ERR_INVALID_STATE
+// once the pool is shutting down. Never blocks.
+err_t worker_pool_submit(worker_pool_t* pool, worker_job_fn fn, void* arg);
+
+// Completion group. Lives wherever the caller likes (usually its stack);
+// it must not be destroyed while jobs submitted through it are pending.
+typedef struct worker_group_t {
+    worker_pool_t* pool;
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    uint32_t pending;
+} worker_group_t;
+
+void worker_group_init(worker_group_t* group, worker_pool_t* pool);
+void worker_group_destroy(worker_group_t* group);
+err_t worker_group_submit(worker_group_t* group, worker_job_fn fn, void* arg);
+void worker_group_wait(worker_group_t* group);
+
+#endif // CCLAW_CORE_WORKER_POOL_H
@@ -6,6 +6,8 @@
 
 #include "core/types.h"
 #include "core/error.h"
+#include "core/alloc.h"
+#include "core/str_builder.h"
 #include "utils/http.h"
 
 #include <stdint.h>
@@ -19,6 +21,9 @@ typedef struct provider_config_t provider_config_t;
 
 // chat_role_t and chat_message_t are defined in core/types.h
 
+// Chat responses and their strings are accounted to the providers subsystem
+#define PROVIDER_ALLOC allocator_subsystem(ALLOC_SUBSYS_PROVIDERS)
+
 // Tool definition for function calling
 typedef struct tool_def_t {
     str_t name;
@@ -35,8 +40,18 @@ typedef struct chat_response_t {
     uint32_t completion_tokens;
     uint32_t total_tokens;
     str_t tool_calls;      // JSON array if tools were called
+    str_t response_id;     // Stored server-side; chain the next turn on it (chat_continue)
 } chat_response_t;
 
+// Callbacks for chat_stream_tools(). Either may be NULL. on_tool_call fires
+// once per call, as soon as its arguments form a complete JSON value, which
+// is usually well before the response ends.
+typedef struct chat_stream_handler_t {
+    void (*on_content)(const char* chunk, void* user_data);
+    void (*on_tool_call)(uint32_t index, str_t name, str_t arguments, void* user_data);
+    void* user_data;
+} chat_stream_handler_t;
+
 // Provider configuration
 typedef struct provider_config_t {
     str_t name;                    // Provider name (e.g., "openrouter", "deepseek")
@@ -47,6 +62,7 @@ typedef struct provider_config_t {
     uint32_t max_tokens;
     uint32_t timeout_ms;
     bool stream;                   // Enable streaming responses
+    bool response_chaining;        // Endpoint keeps responses for previous_response_id
     // Retry configuration
     uint32_t max_retries;
     uint32_t retry_delay_ms;
@@ -86,6 +102,35 @@ struct provider_vtable_t {
                          void (*on_chunk)(const char* chunk, void* user_data),
                          void* user_data);
 
+    // Stream chat with tool calling. Reports content and tool calls through
+    // handler as they arrive, then fills out_response as chat() would.
+    // Optional; callers fall back to chat() when NULL.
+    err_t (*chat_stream_tools)(provider_t* provider,
+                               const chat_message_t* messages,
+                               uint32_t message_count,
+                               const tool_def_t* tools,
+                               uint32_t tool_count,
+                               const char* model,
+                               double temperature,
+                               const chat_stream_handler_t* handler,
+                               chat_response_t** out_response);
+
+    // Chat on top of a response the server has stored. messages holds only
+    // what came after previous_id (plus the system prompt, which is never
+    // carried over); a NULL previous_id starts a new chain with the whole
+    // history. out_response->response_id names the new response. Fails with
+    // ERR_NOT_FOUND when the server no longer has previous_id. Optional, and
+    // only used when provider_supports_chaining().
+    err_t (*chat_continue)(provider_t* provider,
+                           const char* previous_id,
+                           const chat_message_t* messages,
+                           uint32_t message_count,
+                           const tool_def_t* tools,
+                           uint32_t tool_count,
+                           const char* model,
+                           double temperature,
+                           chat_response_t** out_response);
+
     // Model management
     err_t (*list_models)(provider_t* provider, str_t** out_models, uint32_t* out_count);
     bool (*supports_model)(provider_t* provider, const char* model);
@@ -146,6 +191,9 @@ err_t provider_chat_with_retry(provider_t* provider,
                                uint64_t retry_delay_ms,
                                chat_response_t** out_response);
 
+// Whether chat_continue() can be used with this provider's endpoint
+bool provider_supports_chaining(const provider_t* provider);
+
 // Response helpers
 chat_response_t* chat_response_create(void);
 void chat_response_free(chat_response_t* response);
@@ -161,6 +209,48 @@ tool_def_t* tool_def_create(const char* name, const char* description, const cha
 void tool_def_free(tool_def_t* tool);
 void tool_def_array_free(tool_def_t* tools, uint32_t count);
 
+// Add an OpenAI-style "tools" array for tools to a request object
+struct json_value_t;
+typedef struct json_value_t json_value_t;
+void provider_add_tools_json(json_value_t* request, const tool_def_t* tools, uint32_t tool_count);
+
+// Add an OpenAI-style message's tool_calls and tool_call_id, when set
+void provider_add_message_tool_fields(json_value_t* msg_obj, const chat_message_t* message);
+
+// Streamed tool call assembly (common helper). Tool calls arrive as
+// fragments keyed by index: id and name first, then the arguments in
+// pieces. The assembler joins them and reports each call to the handler
+// once its arguments are complete.
+#define STREAM_TOOL_CALLS_MAX 64
+
+typedef struct stream_tool_call_t {
+    str_builder_t id;
+    str_builder_t name;
+    str_builder_t arguments;
+    size_t scanned;            // Bytes of arguments checked for completeness
+    uint32_t depth;
+    bool in_string;
+    bool escaped;
+    bool announced;
+} stream_tool_call_t;
+
+typedef struct stream_tool_calls_t {
+    stream_tool_call_t calls[STREAM_TOOL_CALLS_MAX];
+    uint32_t count;
+} stream_tool_calls_t;
+
+void stream_tool_calls_init(stream_tool_calls_t* acc);
+void stream_tool_calls_free(stream_tool_calls_t* acc);
+
+// Any of id, name and arguments may be NULL. Indexes past
+// STREAM_TOOL_CALLS_MAX are ignored.
+void stream_tool_calls_add(stream_tool_calls_t* acc, uint32_t index,
+                           const char* id, const char* name, const char* arguments,
+                           const chat_stream_handler_t* handler);
+
+// OpenAI-style tool_calls array in PROVIDER_ALLOC; STR_NULL when empty
+str_t stream_tool_calls_to_json(const stream_tool_calls_t* acc);
+
 // Parse chat response from JSON (common helper)
 err_t provider_parse_chat_response(const char* json_str, chat_response_t* out_response);
 
@@ -8,6 +8,8 @@
 #include "core/error.h"
 #include "core/config.h"
 #include "core/agent.h"
+#include "core/alloc.h"
+#include "core/event_bus.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -99,6 +101,12 @@ struct daemon_t {
     int health_fd;            // Unix socket for health checks
     str_t health_socket_path;
 
+    // Logs per-subsystem allocation growth
+    alloc_sampler_t alloc_sampler;
+
+    // Carries the agent's events to the metrics consumer behind /metrics
+    event_bus_t* bus;
+
     // Reference to agent
     agent_t* agent;
 };
@@ -169,6 +177,10 @@ err_t daemon_health_get(daemon_t* daemon, health_status_t* out_status);
 err_t daemon_health_server_start(daemon_t* daemon);
 void daemon_health_server_stop(daemon_t* daemon);
 
+// Answer pending health-socket connections without blocking. Speaks minimal
+// HTTP: "GET /metrics" returns Prometheus text, anything else a status line.
+void daemon_health_server_poll(daemon_t* daemon);
+
 // ============================================================================
 // Signal Handling
 // ============================================================================
@@ -200,6 +212,7 @@ uint64_t daemon_get_uptime_ms(daemon_t* daemon);
 #define DAEMON_LOG_FILE_DEFAULT "/var/log/cclaw.log"
 #define DAEMON_LOG_FILE_USER "~/.cclaw/daemon.log"
 #define DAEMON_HEALTH_SOCKET "/tmp/cclaw-health.sock"
+#define DAEMON_ALLOC_SAMPLE_INTERVAL_MS 60000
 
 #define DAEMON_CONFIG_CRON_FILE ".cclaw/crontab"
 
@@ -0,0 +1,26 @@
+// clock.h - Millisecond clocks for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_UTILS_CLOCK_H
+#define CCLAW_UTILS_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Deadlines, timeouts and durations use the monotonic clock so a wall
+// clock step cannot expire or stretch them. The real-time clock is only
+// for timestamps shown to users or sent to clients.
+
+static inline uint64_t clock_monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static inline uint64_t clock_realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+#endif // CCLAW_UTILS_CLOCK_H
@@ -0,0 +1,86 @@
+// compress.h - Content compression codecs for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_UTILS_COMPRESS_H
+#define CCLAW_UTILS_COMPRESS_H
+
+#include "core/types.h"
+#include "core/error.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Compressed payloads are framed so they can sit next to plain text in the
+// same column or file: a leading NUL byte (never present in stored text),
+// a magic byte, the codec id, the dictionary id and the little-endian
+// uncompressed length, followed by the codec's own stream.
+//
+//   [0x00]['Z'][codec][dict][len:u32 le][stream...]
+
+#define COMPRESS_FRAME_HEADER 8
+#define COMPRESS_FRAME_MAGIC 'Z'
+
+// Inputs shorter than this are stored as-is; frame overhead eats the gain
+#define COMPRESS_MIN_INPUT 96
+
+// Largest payload a frame can describe
+#define COMPRESS_MAX_INPUT ((size_t)UINT32_MAX)
+
+typedef enum compress_codec_id_t {
+    COMPRESS_CODEC_NONE = 0,
+    COMPRESS_CODEC_DEFLATE = 1,
+    COMPRESS_CODEC_ZSTD = 2,
+} compress_codec_id_t;
+
+// Preset dictionaries primed with phrasing common to stored memories. Small
+// entries compress poorly on their own; a shared dictionary lets them
+// back-reference text they never contained.
+typedef enum compress_dict_id_t {
+    COMPRESS_DICT_NONE = 0,
+    COMPRESS_DICT_MEMORY_V1 = 1,
+} compress_dict_id_t;
+
+// Codec operations. compress() returns ERR_OK with *out_len set, or
+// ERR_FAILED when the output would not fit in dst_cap.
+typedef struct compress_codec_t {
+    compress_codec_id_t id;
+    const char* name;
+    size_t (*bound)(size_t src_len);
+    err_t (*compress)(const void* src, size_t src_len,
+                      const void* dict, size_t dict_len,
+                      void* dst, size_t dst_cap, size_t* out_len);
+    err_t (*decompress)(const void* src, size_t src_len,
+                        const void* dict, size_t dict_len,
+                        void* dst, size_t dst_len);
+} compress_codec_t;
+
+// Codec lookup; NULL when the codec was not compiled in
+const compress_codec_t* compress_codec_get(compress_codec_id_t id);
+const compress_codec_t* compress_codec_by_name(const char* name);
+
+// Codec used unless configuration names another. Always deflate, so data
+// written by one build stays readable by builds without zstd.
+const compress_codec_t* compress_codec_default(void);
+
+// Codec named by a configuration value, the default when name is empty.
+// NULL when the named codec was not compiled in.
+const compress_codec_t* compress_codec_select(str_t name);
+
+// True when data starts with a compression frame header
+bool compress_is_frame(const void* data, size_t len);
+
+// Uncompressed length recorded in a frame header
+err_t compress_frame_length(const void* data, size_t len, size_t* out_len);
+
+// Compress src into a malloc'd frame. When the input is too small or does
+// not shrink, returns ERR_OK with *out_frame set to NULL and the caller
+// stores the plain text instead.
+err_t compress_frame(const compress_codec_t* codec, const void* src, size_t src_len,
+                     void** out_frame, size_t* out_frame_len);
+
+// Decompress a frame into a malloc'd, NUL-terminated buffer
+err_t decompress_frame(const void* frame, size_t frame_len,
+                       char** out_data, size_t* out_len);
+
+#endif // CCLAW_UTILS_COMPRESS_H
@@ -0,0 +1,29 @@
+// sha256.h - SHA-256 digest for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_UTILS_SHA256_H
+#define CCLAW_UTILS_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Plain FIPS 180-4 SHA-256 for content addressing. Not constant time and
+// not meant for secrets; use libsodium for anything keyed.
+
+#define SHA256_DIGEST_SIZE 32
+
+typedef struct sha256_ctx_t {
+    uint32_t state[8];
+    uint64_t length;            // Bytes hashed so far
+    uint8_t block[64];
+    size_t block_len;
+} sha256_ctx_t;
+
+void sha256_init(sha256_ctx_t* ctx);
+void sha256_update(sha256_ctx_t* ctx, const void* data, size_t len);
+void sha256_final(sha256_ctx_t* ctx, uint8_t out[SHA256_DIGEST_SIZE]);
+
+// One-shot
+void sha256(const void* data, size_t len, uint8_t out[SHA256_DIGEST_SIZE]);
+
+#endif // CCLAW_UTILS_SHA256_H
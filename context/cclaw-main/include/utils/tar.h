@@ -0,0 +1,56 @@
+// tar.h - Streaming tar archives for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_UTILS_TAR_H
+#define CCLAW_UTILS_TAR_H
+
+#include "core/types.h"
+#include "core/error.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// POSIX ustar, written and read one entry at a time so archives of any
+// size go through a fixed buffer. Names longer than the 100 byte header
+// field are carried in a pax extended header. No links, devices or
+// sparse files: the memory backups only hold directories and files.
+
+#define TAR_BLOCK_SIZE 512
+#define TAR_MAX_NAME 1024
+
+typedef enum tar_type_t {
+    TAR_TYPE_FILE,
+    TAR_TYPE_DIRECTORY,
+    TAR_TYPE_OTHER,             // Anything else; its data is skipped by readers
+} tar_type_t;
+
+typedef struct tar_entry_t {
+    char name[TAR_MAX_NAME + 1];
+    tar_type_t type;
+    uint64_t size;
+    uint32_t mode;
+    uint64_t mtime;
+} tar_entry_t;
+
+// Writes a directory entry
+err_t tar_write_directory(FILE* out, const char* name, uint32_t mode, uint64_t mtime);
+
+// Writes a file entry whose content is the next size bytes of fd. Fails
+// with ERR_IO if fd ends early; the archive is then unusable.
+err_t tar_write_file(FILE* out, const char* name, int fd, uint64_t size, uint32_t mode,
+                     uint64_t mtime);
+
+// Two zero blocks mark the end of the archive
+err_t tar_write_end(FILE* out);
+
+// Reads the next entry header. *out_end is set at the end of the archive.
+// The entry's data must then be consumed with tar_read_data().
+err_t tar_read_header(FILE* in, tar_entry_t* out_entry, bool* out_end);
+
+// Copies the entry's data to out, or skips it when out is NULL, and moves
+// past the padding to the next header
+err_t tar_read_data(FILE* in, const tar_entry_t* entry, FILE* out);
+
+#endif // CCLAW_UTILS_TAR_H
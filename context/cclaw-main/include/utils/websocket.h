@@ -0,0 +1,69 @@
+// websocket.h - WebSocket framing for CClaw
+// SPDX-License-Identifier: MIT
+
+#ifndef CCLAW_UTILS_WEBSOCKET_H
+#define CCLAW_UTILS_WEBSOCKET_H
+
+#include "core/types.h"
+#include "core/error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// RFC 6455 codec with no I/O: the opening handshake key, frame headers,
+// masking and incremental frame parsing. The transport lives with its
+// user (the webhook channel's libuv listener).
+
+#define WS_ACCEPT_KEY_LEN 28        // base64 of a SHA-1 digest
+#define WS_MAX_HEADER_LEN 14        // 2 + 8 byte length + 4 byte mask
+
+typedef enum ws_opcode_t {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA,
+} ws_opcode_t;
+
+// Close status codes used by the server
+#define WS_CLOSE_NORMAL 1000
+#define WS_CLOSE_GOING_AWAY 1001
+#define WS_CLOSE_PROTOCOL_ERROR 1002
+#define WS_CLOSE_UNSUPPORTED 1003
+#define WS_CLOSE_POLICY 1008
+#define WS_CLOSE_TOO_BIG 1009
+
+typedef struct ws_frame_t {
+    ws_opcode_t opcode;
+    bool fin;
+    uint8_t* payload;           // Points into the parsed buffer, unmasked
+    uint64_t length;
+} ws_frame_t;
+
+static inline bool ws_opcode_is_control(ws_opcode_t opcode) {
+    return (opcode & 0x8) != 0;
+}
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key. The key must be
+// the base64 form of 16 bytes.
+err_t ws_accept_key(str_t client_key, char out[WS_ACCEPT_KEY_LEN + 1]);
+
+// Writes a frame header for a payload of length bytes; returns its size.
+// With a mask the payload must be masked separately with ws_mask().
+size_t ws_frame_header(uint8_t out[WS_MAX_HEADER_LEN], ws_opcode_t opcode, bool fin,
+                       uint64_t length, const uint8_t mask[4]);
+
+// XOR data with mask, as if data started offset bytes into the payload
+void ws_mask(uint8_t* data, size_t len, const uint8_t mask[4], size_t offset);
+
+// Parses one frame from the front of data, unmasking it in place.
+// *out_consumed is 0 while the frame is incomplete. Clients must mask
+// their frames, so servers pass require_mask. Frames whose payload is
+// over max_payload fail with ERR_FILE_TOO_LARGE; protocol violations
+// with ERR_INVALID_ARGUMENT.
+err_t ws_frame_parse(uint8_t* data, size_t len, bool require_mask, uint64_t max_payload,
+                     ws_frame_t* out_frame, size_t* out_consumed);
+
+#endif // CCLAW_UTILS_WEBSOCKET_H
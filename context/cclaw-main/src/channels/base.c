@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: MIT
 
 #include "core/channel.h"
+#include "core/alloc.h"
+#include "core/intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -107,30 +109,29 @@ void channel_free(channel_t* channel) {
     }
 }
 
-// Message helpers
+// Message helpers. Messages built here are accounted to the channels subsystem;
+// channel names come from a small fixed set, so they are interned.
+#define CHANNEL_ALLOC allocator_subsystem(ALLOC_SUBSYS_CHANNELS)
+
 channel_message_t* channel_message_create(const str_t* id, const str_t* sender,
                                          const str_t* content, const str_t* channel) {
-    channel_message_t* msg = calloc(1, sizeof(channel_message_t));
+    channel_message_t* msg = alloc_zeroed(CHANNEL_ALLOC, sizeof(channel_message_t));
     if (!msg) return NULL;
 
     if (id && !str_empty(*id)) {
-        msg->id.data = strdup(id->data);
-        msg->id.len = id->len;
+        msg->id = alloc_str(CHANNEL_ALLOC, *id);
     }
 
     if (sender && !str_empty(*sender)) {
-        msg->sender.data = strdup(sender->data);
-        msg->sender.len = sender->len;
+        msg->sender = alloc_str(CHANNEL_ALLOC, *sender);
     }
 
     if (content && !str_empty(*content)) {
-        msg->content.data = strdup(content->data);
-        msg->content.len = content->len;
+        msg->content = alloc_str(CHANNEL_ALLOC, *content);
     }
 
     if (channel && !str_empty(*channel)) {
-        msg->channel.data = strdup(channel->data);
-        msg->channel.len = channel->len;
+        msg->channel = str_intern(*channel);
     }
 
     msg->timestamp = channel_get_current_timestamp();
@@ -141,25 +142,24 @@ channel_message_t* channel_message_create(const str_t* id, const str_t* sender,
 void channel_message_free(channel_message_t* message) {
     if (!message) return;
 
-    free((void*)message->id.data);
-    free((void*)message->sender.data);
-    free((void*)message->content.data);
-    free((void*)message->channel.data);
+    free_str(CHANNEL_ALLOC, message->id);
+    free_str(CHANNEL_ALLOC, message->sender);
+    free_str(CHANNEL_ALLOC, message->content);
 
-    free(message);
+    free_ptr(CHANNEL_ALLOC, message, sizeof(channel_message_t));
 }
 
 void channel_message_array_free(channel_message_t* messages, uint32_t count) {
     if (!messages) return;
 
+    // Channel names are interned and stay
     for (uint32_t i = 0; i < count; i++) {
-        free((void*)messages[i].id.data);
-        free((void*)messages[i].sender.data);
-        free((void*)messages[i].content.data);
-        free((void*)messages[i].channel.data);
+        free_str(CHANNEL_ALLOC, messages[i].id);
+        free_str(CHANNEL_ALLOC, messages[i].sender);
+        free_str(CHANNEL_ALLOC, messages[i].content);
     }
 
-    free(messages);
+    FREE_ARRAY(CHANNEL_ALLOC, messages, channel_message_t, count);
 }
 
 // Utility functions
@@ -343,6 +343,23 @@ err_t channel_manager_start_all(channel_manager_t* manager,
     return last_error;
 }
 
+static void publish_channel_message(channel_message_t* msg, void* user_data) {
+    event_bus_t* bus = user_data;
+    event_t event = {
+        .type = EVENT_MESSAGE_RECEIVED,
+        .session_id = msg->session_id,
+        .source = msg->channel,
+        .sender = msg->sender,
+        .text = msg->content,
+    };
+    event_bus_publish(bus, &event);
+}
+
+err_t channel_manager_start_publishing(channel_manager_t* manager, event_bus_t* bus) {
+    if (!manager || !bus) return ERR_INVALID_ARGUMENT;
+    return channel_manager_start_all(manager, publish_channel_message, bus);
+}
+
 err_t channel_manager_stop_all(channel_manager_t* manager) {
     if (!manager) return ERR_INVALID_ARGUMENT;
 
@@ -8,8 +8,18 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <pthread.h>
 
+// Input is framed over a growable buffer. A burst of complete lines (a
+// paste) is delivered as one message once stdin has been quiet for
+// CLI_PASTE_SETTLE_MS; a typed line arrives alone and goes out after the
+// same short delay. With nothing buffered the thread sleeps in poll()
+// without a timeout until stdin or the stop pipe becomes readable.
+#define CLI_READ_CHUNK 4096
+#define CLI_PASTE_SETTLE_MS 15
+#define CLI_NOMEM_BACKOFF_MS 100
+
 // CLI channel instance data
 typedef struct cli_channel_t {
     pthread_t listener_thread;      // Thread for listening to stdin
@@ -17,6 +27,9 @@ typedef struct cli_channel_t {
     void (*on_message_callback)(channel_message_t* msg, void* user_data);
     void* user_data;
     int pipe_fds[2];                // Pipe for thread communication
+    char* input;                    // Bytes read but not yet delivered
+    size_t input_len;
+    size_t input_cap;
 } cli_channel_t;
 
 // Forward declarations for vtable
@@ -61,79 +74,124 @@ const channel_vtable_t* channel_cli_get_vtable(void) {
     return &cli_vtable;
 }
 
+static void cli_deliver(channel_t* channel, const char* data, size_t len) {
+    cli_channel_t* cli_data = (cli_channel_t*)channel->impl_data;
+
+    // Trim the final line terminator only; interior newlines are content
+    while (len > 0 && (data[len - 1] == '\n' || data[len - 1] == '\r')) {
+        len--;
+    }
+    if (len == 0 || len > UINT32_MAX) return;
+
+    str_t content = { .data = data, .len = (uint32_t)len };
+    str_t sender = STR_LIT("user");
+    str_t channel_name = channel->config.name;
+
+    if (str_empty(channel_name)) {
+        channel_name = STR_LIT("cli");
+    }
+
+    channel_message_t* msg = channel_message_create(NULL, &sender, &content, &channel_name);
+    if (msg && cli_data->on_message_callback) {
+        cli_data->on_message_callback(msg, cli_data->user_data);
+    }
+    channel_message_free(msg);
+}
+
+// Deliver every complete line buffered so far as a single message. With
+// at_eof the unterminated tail goes too.
+static void cli_flush_input(channel_t* channel, bool at_eof) {
+    cli_channel_t* cli_data = (cli_channel_t*)channel->impl_data;
+
+    size_t end = cli_data->input_len;
+    if (!at_eof) {
+        while (end > 0 && cli_data->input[end - 1] != '\n') end--;
+    }
+    if (end == 0) return;
+
+    cli_deliver(channel, cli_data->input, end);
+
+    memmove(cli_data->input, cli_data->input + end, cli_data->input_len - end);
+    cli_data->input_len -= end;
+}
+
+static bool cli_has_complete_line(const cli_channel_t* cli_data) {
+    return cli_data->input_len > 0 && memchr(cli_data->input, '\n', cli_data->input_len) != NULL;
+}
+
+// Make room for at least one more read chunk. The buffer grows by doubling
+// so large pastes cost O(n) copying overall.
+static bool cli_reserve_input(cli_channel_t* cli_data) {
+    if (cli_data->input_cap - cli_data->input_len >= CLI_READ_CHUNK) return true;
+
+    size_t cap = cli_data->input_cap ? cli_data->input_cap * 2 : CLI_READ_CHUNK * 2;
+    while (cap - cli_data->input_len < CLI_READ_CHUNK) cap *= 2;
+
+    char* grown = realloc(cli_data->input, cap);
+    if (!grown) return false;
+
+    cli_data->input = grown;
+    cli_data->input_cap = cap;
+    return true;
+}
+
 // Listener thread function
 static void* cli_listener_thread(void* arg) {
     channel_t* channel = (channel_t*)arg;
     cli_channel_t* cli_data = (cli_channel_t*)channel->impl_data;
 
-    char buffer[4096];
-    fd_set read_fds;
+    struct pollfd fds[2] = {
+        { .fd = cli_data->pipe_fds[0], .events = POLLIN },
+        { .fd = STDIN_FILENO, .events = POLLIN },
+    };
 
     while (!cli_data->stop_listening) {
-        FD_ZERO(&read_fds);
-        FD_SET(STDIN_FILENO, &read_fds);
-        FD_SET(cli_data->pipe_fds[0], &read_fds);
-
-        int max_fd = (STDIN_FILENO > cli_data->pipe_fds[0]) ? STDIN_FILENO : cli_data->pipe_fds[0];
-
-        // Wait for input with timeout (100ms)
-        struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
-        int result = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
+        // Sleep indefinitely unless complete lines are waiting to settle
+        int timeout = cli_has_complete_line(cli_data) ? CLI_PASTE_SETTLE_MS : -1;
+        int result = poll(fds, 2, timeout);
 
         if (result < 0) {
-            // Error
             if (errno == EINTR) continue;
             break;
         }
 
         if (result == 0) {
-            // Timeout, check stop flag
+            // Input went quiet: the burst is complete
+            cli_flush_input(channel, false);
             continue;
         }
 
         // Check pipe first (for stop signal)
-        if (FD_ISSET(cli_data->pipe_fds[0], &read_fds)) {
+        if (fds[0].revents & POLLIN) {
             char dummy;
-            read(cli_data->pipe_fds[0], &dummy, 1);
+            (void)read(cli_data->pipe_fds[0], &dummy, 1);
             break;
         }
 
-        // Check stdin
-        if (FD_ISSET(STDIN_FILENO, &read_fds)) {
-            ssize_t bytes_read = read(STDIN_FILENO, buffer, sizeof(buffer) - 1);
-            if (bytes_read > 0) {
-                // Null-terminate and trim newline
-                buffer[bytes_read] = '\0';
-                if (bytes_read > 0 && buffer[bytes_read - 1] == '\n') {
-                    buffer[bytes_read - 1] = '\0';
-                    bytes_read--;
-                }
-                if (bytes_read > 0 && buffer[bytes_read - 1] == '\r') {
-                    buffer[bytes_read - 1] = '\0';
-                    bytes_read--;
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (!cli_reserve_input(cli_data)) {
+                // Out of memory: hand over what we have rather than drop it.
+                // With nothing buffered stdin stays readable, so wait for
+                // memory (or the stop signal) instead of spinning on poll().
+                if (cli_data->input_len > 0) {
+                    cli_flush_input(channel, true);
+                } else {
+                    poll(fds, 1, CLI_NOMEM_BACKOFF_MS);
                 }
+                continue;
+            }
 
-                if (bytes_read > 0) {
-                    // Create message
-                    str_t content = { .data = buffer, .len = (uint32_t)bytes_read };
-                    str_t sender = STR_LIT("user");
-                    str_t channel_name = channel->config.name;
-
-                    if (str_empty(channel_name)) {
-                        channel_name = STR_LIT("cli");
-                    }
-
-                    channel_message_t* msg = channel_message_create(NULL, &sender, &content, &channel_name);
-                    if (msg && cli_data->on_message_callback) {
-                        cli_data->on_message_callback(msg, cli_data->user_data);
-                    }
-                    channel_message_free(msg);
-                }
+            ssize_t bytes_read = read(STDIN_FILENO, cli_data->input + cli_data->input_len,
+                                      cli_data->input_cap - cli_data->input_len);
+            if (bytes_read > 0) {
+                cli_data->input_len += (size_t)bytes_read;
             } else if (bytes_read == 0) {
-                // EOF (stdin closed)
+                // EOF (stdin closed): deliver any unterminated last line
+                cli_flush_input(channel, true);
+                break;
+            } else if (errno != EINTR && errno != EAGAIN) {
                 break;
             }
-            // else error, continue
         }
     }
 
@@ -213,6 +271,8 @@ static void cli_destroy(channel_t* channel) {
     close(cli_data->pipe_fds[0]);
     close(cli_data->pipe_fds[1]);
 
+    free(cli_data->input);
+
     // Free configuration strings
     free((void*)channel->config.name.data);
     free((void*)channel->config.type.data);
@@ -223,7 +283,8 @@ static void cli_destroy(channel_t* channel) {
     free(cli_data);
     channel->impl_data = NULL;
 
-    channel_free(channel);
+    // channel_free() would dispatch back into this destroy
+    free(channel);
 }
 
 static err_t cli_init(channel_t* channel) {
@@ -288,6 +349,11 @@ static err_t cli_start_listening(channel_t* channel,
     cli_data->user_data = user_data;
     cli_data->stop_listening = false;
 
+    // A stop signal left unread by a listener that ended on EOF would
+    // otherwise end the new one immediately
+    char stale;
+    while (read(cli_data->pipe_fds[0], &stale, 1) > 0) {}
+
     // Create listener thread
     int result = pthread_create(&cli_data->listener_thread, NULL,
                                 cli_listener_thread, channel);
@@ -316,9 +382,9 @@ static err_t cli_stop_listening(channel_t* channel) {
     // Signal thread to stop
     cli_data->stop_listening = true;
 
-    // Write to pipe to wake up select
+    // Write to pipe to wake up poll
     char dummy = 0;
-    write(cli_data->pipe_fds[1], &dummy, 1);
+    (void)write(cli_data->pipe_fds[1], &dummy, 1);
 
     // Wait for thread to finish
     if (cli_data->listener_thread) {
@@ -2,9 +2,12 @@
 // SPDX-License-Identifier: MIT
 
 #include "core/channel.h"
+#include "core/str_builder.h"
 #include "utils/http.h"
+#include "utils/websocket.h"
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <time.h>
@@ -14,6 +17,18 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <netinet/in.h>
+
+// WebSocket clients on the listener
+#define WEBHOOK_WS_PATH "/ws"
+#define WEBHOOK_WS_MAX_MESSAGE (1024 * 1024)
+#define WEBHOOK_WS_MAX_QUEUED (4 * 1024 * 1024)    // Unsent bytes before a client is dropped
+#define WEBHOOK_WS_PING_INTERVAL_MS 30000
+#define WEBHOOK_RELAY_CAPACITY 4096
+#define WEBHOOK_RELAY_TOPICS (EVENT_TOPIC(EVENT_TURN_STARTED) | EVENT_TOPIC(EVENT_TOOL_FINISHED) | \
+                              EVENT_TOPIC(EVENT_TURN_COMPLETED))
+
+typedef struct connection_context_t connection_context_t;
+
 // Webhook channel instance data
 typedef struct webhook_channel_t {
     // Configuration
@@ -31,6 +46,24 @@ typedef struct webhook_channel_t {
     void (*on_message_callback)(channel_message_t* msg, void* user_data);
     void* user_data;
 
+    // Loop thread only, apart from uv_async_send() on wakeup
+    uv_async_t wakeup;              // Stop requests and relayed events
+    uv_timer_t ping_timer;
+    connection_context_t* connections;
+    uint32_t active_connections;
+    uint32_t websocket_clients;     // Token chunks are relayed only while there are any
+
+    // Agent events pushed to WebSocket clients. The relay thread waits on
+    // the subscription and hands batches to the loop.
+    event_bus_t* events;            // Borrowed
+    event_subscription_t* subscription;
+    pthread_t relay_thread;
+    bool stop_relay;
+    pthread_mutex_t relay_lock;
+    event_t** relayed;
+    uint32_t relayed_count;
+    uint32_t relayed_capacity;
+
     // State
     uint32_t messages_sent;
     uint32_t messages_received;
@@ -39,6 +72,10 @@ typedef struct webhook_channel_t {
 
 // Forward declarations
 static void* listener_thread_func(void* arg);
+static void* relay_thread_func(void* arg);
+static void on_connection(uv_stream_t* server, int status);
+static void on_wakeup(uv_async_t* handle);
+static void on_ping_timer(uv_timer_t* handle);
 
 // Forward declarations for vtable
 static str_t webhook_get_name(void);
@@ -223,6 +260,7 @@ static err_t webhook_create(const channel_config_t* config, channel_t** out_chan
     webhook_data->messages_sent = 0;
     webhook_data->messages_received = 0;
     webhook_data->listening = false;
+    pthread_mutex_init(&webhook_data->relay_lock, NULL);
 
     // Copy configuration
     channel->config = *config;
@@ -283,6 +321,7 @@ static void webhook_destroy(channel_t* channel) {
         free((void*)channel->config.host.data);
     }
 
+    pthread_mutex_destroy(&webhook_data->relay_lock);
     free(webhook_data);
     channel->impl_data = NULL;
 
@@ -391,6 +430,29 @@ static err_t webhook_send_message(channel_t* channel, const channel_message_t* m
     return ERR_OK;
 }
 
+// Closes every handle on a loop that is not running and frees it
+static void close_loop(webhook_channel_t* webhook_data) {
+    uv_close((uv_handle_t*)&webhook_data->wakeup, NULL);
+    uv_close((uv_handle_t*)&webhook_data->ping_timer, NULL);
+    uv_close((uv_handle_t*)&webhook_data->server, NULL);
+    uv_run(webhook_data->loop, UV_RUN_DEFAULT);
+    uv_loop_close(webhook_data->loop);
+    free(webhook_data->loop);
+    webhook_data->loop = NULL;
+}
+
+static void release_relayed(webhook_channel_t* webhook_data) {
+    pthread_mutex_lock(&webhook_data->relay_lock);
+    for (uint32_t i = 0; i < webhook_data->relayed_count; i++) {
+        event_release(webhook_data->relayed[i]);
+    }
+    free(webhook_data->relayed);
+    webhook_data->relayed = NULL;
+    webhook_data->relayed_count = 0;
+    webhook_data->relayed_capacity = 0;
+    pthread_mutex_unlock(&webhook_data->relay_lock);
+}
+
 static err_t webhook_start_listening(channel_t* channel,
                                     void (*on_message)(channel_message_t* msg, void* user_data),
                                     void* user_data) {
@@ -408,14 +470,64 @@ static err_t webhook_start_listening(channel_t* channel,
     webhook_data->on_message_callback = on_message;
     webhook_data->user_data = user_data;
 
-    // Reset stop flag
+    // Reset stop flags
     webhook_data->stop_listening = false;
+    webhook_data->stop_relay = false;
+
+    // The loop and its handles are set up here, so a port that cannot be
+    // bound fails the call and uv_async_send() is safe from the start
+    webhook_data->loop = (uv_loop_t*)malloc(sizeof(uv_loop_t));
+    if (!webhook_data->loop) return ERR_OUT_OF_MEMORY;
+    uv_loop_init(webhook_data->loop);
+
+    uv_async_init(webhook_data->loop, &webhook_data->wakeup, on_wakeup);
+    webhook_data->wakeup.data = webhook_data;
+    uv_timer_init(webhook_data->loop, &webhook_data->ping_timer);
+    webhook_data->ping_timer.data = webhook_data;
+
+    struct sockaddr_in addr;
+    uv_ip4_addr("0.0.0.0", channel->config.port, &addr);
+
+    uv_tcp_init(webhook_data->loop, &webhook_data->server);
+    webhook_data->server.data = channel; // Store channel_t pointer for callbacks
+    int r = uv_tcp_bind(&webhook_data->server, (const struct sockaddr*)&addr, 0);
+    if (r == 0) r = uv_listen((uv_stream_t*)&webhook_data->server, 128, on_connection);
+    if (r) {
+        fprintf(stderr, "[Webhook] Listen error: %s\n", uv_strerror(r));
+        close_loop(webhook_data);
+        return ERR_NETWORK;
+    }
+    uv_timer_start(&webhook_data->ping_timer, on_ping_timer,
+                   WEBHOOK_WS_PING_INTERVAL_MS, WEBHOOK_WS_PING_INTERVAL_MS);
+
+    if (webhook_data->events) {
+        err_t sub_err = event_bus_subscribe(webhook_data->events, WEBHOOK_RELAY_TOPICS,
+                                            WEBHOOK_RELAY_CAPACITY, EVENT_OVERFLOW_DROP_OLDEST,
+                                            &webhook_data->subscription);
+        if (sub_err == ERR_OK &&
+            pthread_create(&webhook_data->relay_thread, NULL, relay_thread_func, webhook_data) != 0) {
+            event_bus_unsubscribe(webhook_data->events, webhook_data->subscription);
+            webhook_data->subscription = NULL;
+        }
+        if (!webhook_data->subscription) {
+            fprintf(stderr, "[Webhook] Live events unavailable; WebSocket clients get none\n");
+        }
+    }
 
     // Start listener thread
     int err = pthread_create(&webhook_data->listener_thread, NULL,
                             listener_thread_func, channel);
     if (err != 0) {
         fprintf(stderr, "[Webhook] Failed to start listener thread: %d\n", err);
+        if (webhook_data->subscription) {
+            __atomic_store_n(&webhook_data->stop_relay, true, __ATOMIC_RELEASE);
+            event_bus_wake(webhook_data->subscription);
+            pthread_join(webhook_data->relay_thread, NULL);
+            event_bus_unsubscribe(webhook_data->events, webhook_data->subscription);
+            webhook_data->subscription = NULL;
+            release_relayed(webhook_data);
+        }
+        close_loop(webhook_data);
         return ERR_FAILED;
     }
 
@@ -438,8 +550,16 @@ static err_t webhook_stop_listening(channel_t* channel) {
         return ERR_OK; // Not listening
     }
 
-    // Set stop flag to signal listener thread to exit
-    webhook_data->stop_listening = true;
+    // The relay goes first: it wakes the loop
+    if (webhook_data->subscription) {
+        __atomic_store_n(&webhook_data->stop_relay, true, __ATOMIC_RELEASE);
+        event_bus_wake(webhook_data->subscription);
+        pthread_join(webhook_data->relay_thread, NULL);
+    }
+
+    // Set stop flag and wake the loop, which closes everything and returns
+    __atomic_store_n(&webhook_data->stop_listening, true, __ATOMIC_RELEASE);
+    uv_async_send(&webhook_data->wakeup);
 
     // Wait for thread to finish
     if (webhook_data->listener_thread) {
@@ -447,6 +567,16 @@ static err_t webhook_stop_listening(channel_t* channel) {
         webhook_data->listener_thread = 0;
     }
 
+    if (webhook_data->subscription) {
+        event_bus_unsubscribe(webhook_data->events, webhook_data->subscription);
+        webhook_data->subscription = NULL;
+    }
+    release_relayed(webhook_data);
+
+    uv_loop_close(webhook_data->loop);
+    free(webhook_data->loop);
+    webhook_data->loop = NULL;
+
     printf("[Webhook] Webhook HTTP server stopped\n");
 
     channel->listening = false;
@@ -455,6 +585,19 @@ static err_t webhook_stop_listening(channel_t* channel) {
     return ERR_OK;
 }
 
+err_t channel_webhook_stream_events(channel_t* channel, event_bus_t* bus) {
+    if (!channel || !channel->impl_data || channel->vtable != &webhook_vtable) {
+        return ERR_INVALID_ARGUMENT;
+    }
+    if (channel->listening) {
+        return ERROR_SET(ERR_INVALID_STATE, "webhook channel is already listening");
+    }
+
+    webhook_channel_t* webhook_data = (webhook_channel_t*)channel->impl_data;
+    webhook_data->events = bus;
+    return ERR_OK;
+}
+
 static bool webhook_is_listening(channel_t* channel) {
     if (!channel || !channel->impl_data || !channel->initialized) {
         return false;
@@ -484,7 +627,9 @@ static err_t webhook_get_stats(channel_t* channel, uint32_t* messages_sent,
 
     if (messages_sent) *messages_sent = webhook_data->messages_sent;
     if (messages_received) *messages_received = webhook_data->messages_received;
-    if (active_connections) *active_connections = webhook_data->listening ? 1 : 0;
+    if (active_connections) {
+        *active_connections = __atomic_load_n(&webhook_data->active_connections, __ATOMIC_RELAXED);
+    }
 
     return ERR_OK;
 }
@@ -499,24 +644,138 @@ typedef struct {
     size_t len;
 } http_buffer_t;
 
-// HTTP connection context
-typedef struct {
-    uv_tcp_t* handle;
+// HTTP connection context. A request on WEBHOOK_WS_PATH may upgrade the
+// connection to a WebSocket, which then stays open and receives the
+// events of the session it asked for.
+struct connection_context_t {
+    uv_tcp_t handle;
     webhook_channel_t* channel;
+    connection_context_t* next;
     http_buffer_t buffer;
-    bool request_complete;
-} connection_context_t;
+    bool closing;
+
+    // WebSocket state
+    bool websocket;
+    char session[128];              // Events of this session are pushed; "" = none
+    uint8_t* frames;                // Received, not yet parsed
+    size_t frames_len;
+    size_t frames_cap;
+    str_builder_t message;          // Fragmented text message being assembled
+    bool in_message;
+    size_t queued_bytes;            // Written but not yet sent
+    uint64_t last_seen_ms;
+};
+
+// A write owns its bytes until libuv is done with them
+typedef struct write_req_t {
+    uv_write_t req;
+    connection_context_t* context;
+    size_t len;
+    bool close_after;
+    uint8_t data[];
+} write_req_t;
+
+// The agent builds no token chunks for the relay while nobody would see them
+static void websocket_clients_changed(webhook_channel_t* channel, bool joined) {
+    uint32_t before = channel->websocket_clients;
+    channel->websocket_clients = joined ? before + 1 : before - 1;
+    if (!channel->subscription || (before > 0) == (channel->websocket_clients > 0)) return;
+
+    uint32_t topics = WEBHOOK_RELAY_TOPICS;
+    if (channel->websocket_clients > 0) topics |= EVENT_TOPIC(EVENT_TOKEN_CHUNK);
+    event_bus_set_topics(channel->events, channel->subscription, topics);
+}
+
+static void on_connection_closed(uv_handle_t* handle) {
+    connection_context_t* context = (connection_context_t*)handle->data;
+    webhook_channel_t* channel = context->channel;
+    if (context->websocket) websocket_clients_changed(channel, false);
+
+    for (connection_context_t** link = &channel->connections; *link; link = &(*link)->next) {
+        if (*link == context) {
+            *link = context->next;
+            break;
+        }
+    }
+    __atomic_sub_fetch(&channel->active_connections, 1, __ATOMIC_RELAXED);
+
+    free(context->frames);
+    str_builder_free(&context->message);
+    free(context);
+}
+
+static void close_connection(connection_context_t* context) {
+    if (context->closing) return;
+    context->closing = true;
+    uv_close((uv_handle_t*)&context->handle, on_connection_closed);
+}
+
+static void on_write_done(uv_write_t* req, int status) {
+    write_req_t* write = (write_req_t*)req;
+    connection_context_t* context = write->context;
+
+    context->queued_bytes -= write->len;
+    if (status < 0 || write->close_after) {
+        close_connection(context);
+    }
+    free(write);
+}
+
+static bool queue_write(connection_context_t* context, write_req_t* write) {
+    if (context->closing) {
+        free(write);
+        return false;
+    }
+
+    context->queued_bytes += write->len;
+    uv_buf_t buf = uv_buf_init((char*)write->data, (unsigned int)write->len);
+    if (uv_write(&write->req, (uv_stream_t*)&context->handle, &buf, 1, on_write_done) != 0) {
+        context->queued_bytes -= write->len;
+        free(write);
+        close_connection(context);
+        return false;
+    }
+    return true;
+}
+
+static write_req_t* write_req_alloc(connection_context_t* context, size_t len) {
+    write_req_t* write = malloc(sizeof(write_req_t) + len);
+    if (!write) return NULL;
+    write->context = context;
+    write->len = len;
+    write->close_after = false;
+    return write;
+}
 
 // Allocate buffer for reading
 static void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
     connection_context_t* context = (connection_context_t*)handle->data;
-    if (context && context->buffer.len < sizeof(context->buffer.data)) {
-        size_t available = sizeof(context->buffer.data) - context->buffer.len;
+    buf->base = NULL;
+    buf->len = 0;
+    if (!context) return;
+
+    if (context->websocket) {
+        size_t limit = WEBHOOK_WS_MAX_MESSAGE + WS_MAX_HEADER_LEN;
+        if (context->frames_cap - context->frames_len < suggested_size &&
+            context->frames_cap < limit) {
+            size_t cap = context->frames_cap ? context->frames_cap * 2 : suggested_size;
+            while (cap - context->frames_len < suggested_size && cap < limit) cap *= 2;
+            if (cap > limit) cap = limit;
+            uint8_t* frames = realloc(context->frames, cap);
+            if (!frames) return;
+            context->frames = frames;
+            context->frames_cap = cap;
+        }
+        buf->base = (char*)context->frames + context->frames_len;
+        buf->len = context->frames_cap - context->frames_len;
+        return;
+    }
+
+    // One byte is kept for the terminator
+    if (context->buffer.len + 1 < sizeof(context->buffer.data)) {
+        size_t available = sizeof(context->buffer.data) - context->buffer.len - 1;
         buf->base = context->buffer.data + context->buffer.len;
         buf->len = available > suggested_size ? suggested_size : available;
-    } else {
-        buf->base = NULL;
-        buf->len = 0;
     }
 }
 
@@ -532,7 +791,7 @@ static bool parse_http_request(const char* data, size_t len,
     if (!end_of_line) return false;
 
     // Parse method and path
-    int scanned = sscanf(data, "%s %s", method, path);
+    int scanned = sscanf(data, "%15s %255s", method, path);
     if (scanned != 2) return false;
 
     // Find body (after \r\n\r\n)
@@ -553,8 +812,89 @@ static bool parse_http_request(const char* data, size_t len,
     return true;
 }
 
-// Send HTTP response
-static void send_http_response(uv_stream_t* stream, int status_code, const char* status_text,
+// Value of a request header (case-insensitive name), trimmed
+static bool find_header(const char* request, const char* name, char* out, size_t out_size) {
+    size_t name_len = strlen(name);
+    const char* line = strstr(request, "\r\n");
+    while (line && line[2] != '\r' && line[2] != '\0') {
+        line += 2;
+        const char* end = strstr(line, "\r\n");
+        if (!end) return false;
+
+        if ((size_t)(end - line) > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char* value = line + name_len + 1;
+            while (value < end && (*value == ' ' || *value == '\t')) value++;
+            const char* value_end = end;
+            while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t')) value_end--;
+
+            size_t len = (size_t)(value_end - value);
+            if (len >= out_size) return false;
+            memcpy(out, value, len);
+            out[len] = '\0';
+            return true;
+        }
+        line = end;
+    }
+    return false;
+}
+
+// Whether a comma separated header value lists token
+static bool header_has_token(const char* value, const char* token) {
+    size_t token_len = strlen(token);
+    const char* p = value;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        const char* start = p;
+        while (*p && *p != ',') p++;
+        const char* end = p;
+        while (end > start && end[-1] == ' ') end--;
+        if ((size_t)(end - start) == token_len && strncasecmp(start, token, token_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Percent-decoded query parameter; false if absent or too long
+static bool find_query_param(const char* path, const char* name, char* out, size_t out_size) {
+    const char* query = strchr(path, '?');
+    if (!query) return false;
+
+    size_t name_len = strlen(name);
+    const char* p = query + 1;
+    while (*p) {
+        const char* end = strchr(p, '&');
+        if (!end) end = p + strlen(p);
+
+        if ((size_t)(end - p) > name_len && p[name_len] == '=' && strncmp(p, name, name_len) == 0) {
+            size_t n = 0;
+            for (const char* c = p + name_len + 1; c < end; c++) {
+                if (n + 1 >= out_size) return false;
+                if (*c == '%' && end - c > 2 && hex_digit(c[1]) >= 0 && hex_digit(c[2]) >= 0) {
+                    out[n++] = (char)(hex_digit(c[1]) << 4 | hex_digit(c[2]));
+                    c += 2;
+                } else {
+                    out[n++] = *c == '+' ? ' ' : *c;
+                }
+            }
+            out[n] = '\0';
+            return true;
+        }
+        p = *end ? end + 1 : end;
+    }
+    return false;
+}
+
+// Send HTTP response; the connection closes once it is written
+static void send_http_response(connection_context_t* context, int status_code, const char* status_text,
                               const char* content_type, const char* body) {
     char response[1024];
     int len = snprintf(response, sizeof(response),
@@ -567,11 +907,509 @@ static void send_http_response(uv_stream_t* stream, int status_code, const char*
                       status_code, status_text, content_type,
                       body ? strlen(body) : 0, body ? body : "");
 
+    write_req_t* write = NULL;
     if (len > 0 && len < (int)sizeof(response)) {
-        uv_buf_t buf = uv_buf_init(response, len);
-        uv_write_t* req = (uv_write_t*)malloc(sizeof(uv_write_t));
-        uv_write(req, stream, &buf, 1, NULL); // We don't handle write completion
+        write = write_req_alloc(context, (size_t)len);
+    }
+    if (!write) {
+        close_connection(context);
+        return;
+    }
+    memcpy(write->data, response, (size_t)len);
+    write->close_after = true;
+    queue_write(context, write);
+}
+
+// ============================================================================
+// WebSocket connections
+// ============================================================================
+
+// A client that cannot keep up is dropped rather than buffered without end
+static bool ws_send(connection_context_t* context, ws_opcode_t opcode,
+                    const void* payload, size_t len, bool close_after) {
+    if (context->closing) return false;
+    if (context->queued_bytes + len > WEBHOOK_WS_MAX_QUEUED) {
+        close_connection(context);
+        return false;
+    }
+
+    uint8_t header[WS_MAX_HEADER_LEN];
+    size_t header_len = ws_frame_header(header, opcode, true, len, NULL);
+    write_req_t* write = write_req_alloc(context, header_len + len);
+    if (!write) {
+        close_connection(context);
+        return false;
+    }
+    memcpy(write->data, header, header_len);
+    if (len > 0) memcpy(write->data + header_len, payload, len);
+    write->close_after = close_after;
+    return queue_write(context, write);
+}
+
+static void ws_close(connection_context_t* context, uint16_t code) {
+    uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+    ws_send(context, WS_OP_CLOSE, payload, sizeof(payload), true);
+}
+
+static void ws_send_text(connection_context_t* context, const char* text) {
+    ws_send(context, WS_OP_TEXT, text, strlen(text), false);
+}
+
+// A complete text message is handled like a webhook POST body, in the
+// session the connection follows
+static void ws_deliver(connection_context_t* context, const char* data, size_t len) {
+    channel_message_t message = {0};
+    if (parse_webhook_payload(data, len, &message) != ERR_OK) {
+        ws_send_text(context, "{\"type\":\"error\",\"error\":\"Invalid JSON payload\"}");
+        return;
+    }
+    message.session_id = STR_VIEW(context->session);
+
+    webhook_channel_t* channel = context->channel;
+    channel->messages_received++;
+    if (channel->on_message_callback) {
+        channel->on_message_callback(&message, channel->user_data);
+    }
+
+    free((void*)message.id.data);
+    free((void*)message.content.data);
+    free((void*)message.sender.data);
+    free((void*)message.channel.data);
+}
+
+static void ws_handle_frame(connection_context_t* context, const ws_frame_t* frame) {
+    switch (frame->opcode) {
+        case WS_OP_PING:
+            ws_send(context, WS_OP_PONG, frame->payload, (size_t)frame->length, false);
+            break;
+
+        case WS_OP_PONG:
+            break;
+
+        case WS_OP_CLOSE: {
+            uint16_t code = WS_CLOSE_NORMAL;
+            if (frame->length >= 2) code = (uint16_t)(frame->payload[0] << 8 | frame->payload[1]);
+            ws_close(context, code);
+            break;
+        }
+
+        case WS_OP_BINARY:
+            ws_close(context, WS_CLOSE_UNSUPPORTED);
+            break;
+
+        case WS_OP_TEXT:
+            if (context->in_message) {
+                ws_close(context, WS_CLOSE_PROTOCOL_ERROR);
+            } else if (frame->fin) {
+                ws_deliver(context, (const char*)frame->payload, (size_t)frame->length);
+            } else {
+                str_builder_reset(&context->message);
+                str_builder_append_bytes(&context->message, (const char*)frame->payload,
+                                         (size_t)frame->length);
+                context->in_message = true;
+            }
+            break;
+
+        case WS_OP_CONTINUATION:
+            if (!context->in_message) {
+                ws_close(context, WS_CLOSE_PROTOCOL_ERROR);
+                break;
+            }
+            if (context->message.len + frame->length > WEBHOOK_WS_MAX_MESSAGE) {
+                ws_close(context, WS_CLOSE_TOO_BIG);
+                break;
+            }
+            str_builder_append_bytes(&context->message, (const char*)frame->payload,
+                                     (size_t)frame->length);
+            if (frame->fin) {
+                context->in_message = false;
+                str_t message = str_builder_view(&context->message);
+                ws_deliver(context, message.data, message.len);
+                str_builder_reset(&context->message);
+            }
+            break;
+    }
+}
+
+static void ws_process_frames(connection_context_t* context) {
+    size_t offset = 0;
+    while (!context->closing && offset < context->frames_len) {
+        ws_frame_t frame;
+        size_t consumed = 0;
+        err_t err = ws_frame_parse(context->frames + offset, context->frames_len - offset, true,
+                                   WEBHOOK_WS_MAX_MESSAGE, &frame, &consumed);
+        if (err != ERR_OK) {
+            ws_close(context, err == ERR_FILE_TOO_LARGE ? WS_CLOSE_TOO_BIG : WS_CLOSE_PROTOCOL_ERROR);
+            break;
+        }
+        if (consumed == 0) break;
+
+        offset += consumed;
+        context->last_seen_ms = uv_now(context->channel->loop);
+        ws_handle_frame(context, &frame);
+    }
+
+    if (offset > 0 && offset <= context->frames_len) {
+        memmove(context->frames, context->frames + offset, context->frames_len - offset);
+        context->frames_len -= offset;
+    }
+}
+
+// Completes the opening handshake for a GET on WEBHOOK_WS_PATH carrying
+// "Upgrade: websocket". With a secret configured the client proves it
+// with ?token= (browsers cannot set headers) or a bearer token.
+static void ws_upgrade(connection_context_t* context, const char* path) {
+    webhook_channel_t* channel = context->channel;
+    const char* request = context->buffer.data;
+
+    char key[64];
+    char version[8];
+    if (!find_header(request, "Sec-WebSocket-Key", key, sizeof(key)) ||
+        !find_header(request, "Sec-WebSocket-Version", version, sizeof(version)) ||
+        strcmp(version, "13") != 0) {
+        send_http_response(context, 400, "Bad Request", "application/json",
+                          "{\"error\":\"Unsupported WebSocket handshake\"}");
+        return;
+    }
+
+    if (!str_empty(channel->secret)) {
+        char token[256] = "";
+        char authorization[300];
+        if (!find_query_param(path, "token", token, sizeof(token)) &&
+            find_header(request, "Authorization", authorization, sizeof(authorization)) &&
+            strncasecmp(authorization, "Bearer ", 7) == 0) {
+            snprintf(token, sizeof(token), "%s", authorization + 7);
+        }
+        if (strlen(token) != channel->secret.len ||
+            sodium_memcmp(token, channel->secret.data, channel->secret.len) != 0) {
+            send_http_response(context, 401, "Unauthorized", "application/json",
+                              "{\"error\":\"Invalid token\"}");
+            return;
+        }
+    }
+
+    char accept[WS_ACCEPT_KEY_LEN + 1];
+    if (ws_accept_key(STR_VIEW(key), accept) != ERR_OK) {
+        send_http_response(context, 400, "Bad Request", "application/json",
+                          "{\"error\":\"Invalid Sec-WebSocket-Key\"}");
+        return;
+    }
+    if (find_query_param(path, "session", context->session, sizeof(context->session)) == false) {
+        context->session[0] = '\0';
+    }
+
+    char response[256];
+    int len = snprintf(response, sizeof(response),
+                      "HTTP/1.1 101 Switching Protocols\r\n"
+                      "Upgrade: websocket\r\n"
+                      "Connection: Upgrade\r\n"
+                      "Sec-WebSocket-Accept: %s\r\n"
+                      "\r\n", accept);
+    write_req_t* write = write_req_alloc(context, (size_t)len);
+    if (!write) {
+        close_connection(context);
+        return;
+    }
+    memcpy(write->data, response, (size_t)len);
+    if (!queue_write(context, write)) return;
+
+    context->websocket = true;
+    websocket_clients_changed(channel, true);
+    context->last_seen_ms = uv_now(channel->loop);
+    str_builder_init(&context->message, NULL);
+
+    // Frames the client sent straight after the handshake
+    const char* rest = strstr(request, "\r\n\r\n") + 4;
+    size_t rest_len = context->buffer.len - (size_t)(rest - request);
+    if (rest_len > 0) {
+        context->frames = malloc(rest_len);
+        if (!context->frames) {
+            close_connection(context);
+            return;
+        }
+        memcpy(context->frames, rest, rest_len);
+        context->frames_len = rest_len;
+        context->frames_cap = rest_len;
+        ws_process_frames(context);
+    }
+}
+
+// ============================================================================
+// Live events
+// ============================================================================
+
+static void append_event_json(str_builder_t* sb, const event_t* event, str_t text) {
+    str_builder_append_cstr(sb, "{\"type\":\"");
+    switch (event->type) {
+        case EVENT_TURN_STARTED: str_builder_append_cstr(sb, "turn_started"); break;
+        case EVENT_TOKEN_CHUNK: str_builder_append_cstr(sb, "token"); break;
+        case EVENT_TOOL_FINISHED: str_builder_append_cstr(sb, "tool"); break;
+        case EVENT_TURN_COMPLETED: str_builder_append_cstr(sb, "turn_completed"); break;
+        default: str_builder_append_cstr(sb, "event"); break;
+    }
+    str_builder_append_cstr(sb, "\",\"session\":\"");
+    str_builder_append_json_escaped(sb, event->session_id);
+    str_builder_append_char(sb, '"');
+
+    switch (event->type) {
+        case EVENT_TOKEN_CHUNK:
+            str_builder_append_cstr(sb, ",\"text\":\"");
+            str_builder_append_json_escaped(sb, text);
+            str_builder_append_char(sb, '"');
+            break;
+        case EVENT_TOOL_FINISHED:
+            str_builder_append_cstr(sb, ",\"tool\":\"");
+            str_builder_append_json_escaped(sb, event->source);
+            str_builder_appendf(sb, "\",\"ok\":%s,\"duration_ms\":%lu,\"bytes\":%lu",
+                                event->status == ERR_OK ? "true" : "false",
+                                (unsigned long)event->duration_ms, (unsigned long)event->value);
+            break;
+        case EVENT_TURN_COMPLETED:
+            str_builder_append_cstr(sb, ",\"text\":\"");
+            str_builder_append_json_escaped(sb, event->text);
+            str_builder_appendf(sb, "\",\"ok\":%s,\"duration_ms\":%lu,\"tokens\":%lu",
+                                event->status == ERR_OK ? "true" : "false",
+                                (unsigned long)event->duration_ms, (unsigned long)event->value);
+            break;
+        default:
+            break;
+    }
+    str_builder_append_char(sb, '}');
+}
+
+static void push_to_session(webhook_channel_t* webhook_data, str_t session, str_t json) {
+    connection_context_t* context = webhook_data->connections;
+    while (context) {
+        // ws_send may close the connection, but it is only freed later
+        connection_context_t* next = context->next;
+        if (context->websocket && !context->closing && str_equal_cstr(session, context->session)) {
+            ws_send(context, WS_OP_TEXT, json.data, json.len, false);
+        }
+        context = next;
+    }
+}
+
+static bool session_has_clients(webhook_channel_t* webhook_data, str_t session) {
+    for (connection_context_t* c = webhook_data->connections; c; c = c->next) {
+        if (c->websocket && !c->closing && str_equal_cstr(session, c->session)) return true;
+    }
+    return false;
+}
+
+// Runs of token chunks for the same session go out as one message
+static void push_events(webhook_channel_t* webhook_data, event_t** events, uint32_t count) {
+    str_builder_t json;
+    str_builder_t text;
+    str_builder_init(&json, NULL);
+    str_builder_init(&text, NULL);
+
+    for (uint32_t i = 0; i < count; i++) {
+        event_t* event = events[i];
+        if (!session_has_clients(webhook_data, event->session_id)) continue;
+
+        str_t chunk = event->text;
+        if (event->type == EVENT_TOKEN_CHUNK) {
+            str_builder_reset(&text);
+            str_builder_append(&text, event->text);
+            while (i + 1 < count && events[i + 1]->type == EVENT_TOKEN_CHUNK &&
+                   str_equal(events[i + 1]->session_id, event->session_id)) {
+                str_builder_append(&text, events[++i]->text);
+            }
+            chunk = str_builder_view(&text);
+        }
+
+        str_builder_reset(&json);
+        append_event_json(&json, event, chunk);
+        if (!json.failed) push_to_session(webhook_data, event->session_id, str_builder_view(&json));
+    }
+
+    str_builder_free(&text);
+    str_builder_free(&json);
+}
+
+static void* relay_thread_func(void* arg) {
+    webhook_channel_t* webhook_data = (webhook_channel_t*)arg;
+    event_t* events[64];
+
+    while (!__atomic_load_n(&webhook_data->stop_relay, __ATOMIC_ACQUIRE)) {
+        // The timeout covers a stop requested just before the wait
+        uint32_t count = event_bus_wait(webhook_data->subscription, events, 64, 1000);
+        if (count == 0) continue;
+
+        pthread_mutex_lock(&webhook_data->relay_lock);
+        uint32_t needed = webhook_data->relayed_count + count;
+        if (needed > webhook_data->relayed_capacity) {
+            uint32_t capacity = webhook_data->relayed_capacity ? webhook_data->relayed_capacity : 64;
+            while (capacity < needed) capacity *= 2;
+            event_t** relayed = realloc(webhook_data->relayed, capacity * sizeof(event_t*));
+            if (relayed) {
+                webhook_data->relayed = relayed;
+                webhook_data->relayed_capacity = capacity;
+            }
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            if (webhook_data->relayed_count < webhook_data->relayed_capacity) {
+                webhook_data->relayed[webhook_data->relayed_count++] = events[i];
+            } else {
+                event_release(events[i]);
+            }
+        }
+        pthread_mutex_unlock(&webhook_data->relay_lock);
+
+        uv_async_send(&webhook_data->wakeup);
+    }
+    return NULL;
+}
+
+// Closes everything so uv_run() returns
+static void shutdown_server(webhook_channel_t* webhook_data) {
+    static const uint8_t going_away[] = { 0x88, 0x02, WS_CLOSE_GOING_AWAY >> 8, WS_CLOSE_GOING_AWAY & 0xFF };
+
+    for (connection_context_t* c = webhook_data->connections; c; c = c->next) {
+        if (c->websocket && !c->closing) {
+            uv_buf_t buf = uv_buf_init((char*)going_away, sizeof(going_away));
+            uv_try_write((uv_stream_t*)&c->handle, &buf, 1);
+        }
+        close_connection(c);
+    }
+    uv_close((uv_handle_t*)&webhook_data->server, NULL);
+    uv_close((uv_handle_t*)&webhook_data->ping_timer, NULL);
+    uv_close((uv_handle_t*)&webhook_data->wakeup, NULL);
+}
+
+static void on_wakeup(uv_async_t* handle) {
+    webhook_channel_t* webhook_data = (webhook_channel_t*)handle->data;
+
+    if (__atomic_load_n(&webhook_data->stop_listening, __ATOMIC_ACQUIRE)) {
+        shutdown_server(webhook_data);
+        return;
     }
+
+    pthread_mutex_lock(&webhook_data->relay_lock);
+    event_t** events = webhook_data->relayed;
+    uint32_t count = webhook_data->relayed_count;
+    webhook_data->relayed = NULL;
+    webhook_data->relayed_count = 0;
+    webhook_data->relayed_capacity = 0;
+    pthread_mutex_unlock(&webhook_data->relay_lock);
+
+    push_events(webhook_data, events, count);
+    for (uint32_t i = 0; i < count; i++) event_release(events[i]);
+    free(events);
+}
+
+// Pings idle clients and drops those that stopped answering
+static void on_ping_timer(uv_timer_t* handle) {
+    webhook_channel_t* webhook_data = (webhook_channel_t*)handle->data;
+    uint64_t now = uv_now(webhook_data->loop);
+
+    connection_context_t* context = webhook_data->connections;
+    while (context) {
+        connection_context_t* next = context->next;
+        if (context->websocket && !context->closing) {
+            if (now - context->last_seen_ms > 2 * WEBHOOK_WS_PING_INTERVAL_MS) {
+                close_connection(context);
+            } else {
+                ws_send(context, WS_OP_PING, NULL, 0, false);
+            }
+        }
+        context = next;
+    }
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+static void handle_http_request(connection_context_t* context) {
+    char method[16];
+    char path[256];
+    char body[2048];
+    size_t body_len = sizeof(body);
+
+    if (!parse_http_request(context->buffer.data, context->buffer.len,
+                           method, sizeof(method),
+                           path, sizeof(path),
+                           body, &body_len)) {
+        send_http_response(context, 400, "Bad Request",
+                          "application/json",
+                          "{\"error\":\"Invalid HTTP request\"}");
+        return;
+    }
+
+    char upgrade[32];
+    size_t ws_path_len = strlen(WEBHOOK_WS_PATH);
+    if (strcmp(method, "GET") == 0 &&
+        strncmp(path, WEBHOOK_WS_PATH, ws_path_len) == 0 &&
+        (path[ws_path_len] == '\0' || path[ws_path_len] == '?') &&
+        find_header(context->buffer.data, "Upgrade", upgrade, sizeof(upgrade)) &&
+        header_has_token(upgrade, "websocket")) {
+        char connection[128];
+        if (!find_header(context->buffer.data, "Connection", connection, sizeof(connection)) ||
+            !header_has_token(connection, "upgrade")) {
+            send_http_response(context, 400, "Bad Request", "application/json",
+                              "{\"error\":\"Missing Connection: Upgrade\"}");
+            return;
+        }
+        ws_upgrade(context, path);
+        return;
+    }
+
+    // Only handle POST requests to /webhook or /
+    if (strcmp(method, "POST") != 0 ||
+        (strcmp(path, "/webhook") != 0 && strcmp(path, "/") != 0)) {
+        send_http_response(context, 404, "Not Found",
+                          "application/json",
+                          "{\"error\":\"Not Found\"}");
+        return;
+    }
+
+    // Parse webhook payload
+    channel_message_t message = {0};
+    err_t parse_err = parse_webhook_payload(body, body_len, &message);
+    if (parse_err != ERR_OK) {
+        send_http_response(context, 400, "Bad Request",
+                          "application/json",
+                          "{\"error\":\"Invalid JSON payload\"}");
+        return;
+    }
+
+    // Verify signature if configured
+    webhook_channel_t* channel = context->channel;
+    bool signature_valid = true;
+
+    if (channel->verify_signature && !str_empty(channel->secret)) {
+        // Extract signature from headers (simplified)
+        // In real implementation, extract from X-Signature header
+        signature_valid = false; // Default to false for now
+
+        // TODO: Parse headers and verify signature
+        // For now, accept all requests for testing
+        signature_valid = true;
+    }
+
+    if (signature_valid) {
+        channel->messages_received++;
+
+        // Call the callback if set
+        if (channel->on_message_callback) {
+            channel->on_message_callback(&message, channel->user_data);
+        }
+
+        send_http_response(context, 200, "OK",
+                          "application/json",
+                          "{\"status\":\"ok\"}");
+    } else {
+        send_http_response(context, 401, "Unauthorized",
+                          "application/json",
+                          "{\"error\":\"Invalid signature\"}");
+    }
+
+    // Free message strings
+    free((void*)message.id.data);
+    free((void*)message.content.data);
+    free((void*)message.sender.data);
+    free((void*)message.channel.data);
 }
 
 // Handle incoming data
@@ -579,93 +1417,36 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
     connection_context_t* context = (connection_context_t*)stream->data;
     if (!context) return;
 
-    if (nread > 0) {
-        context->buffer.len += nread;
-        context->buffer.data[context->buffer.len] = '\0';
-
-        // Check if we have a complete request (ends with \r\n\r\n)
-        if (strstr(context->buffer.data, "\r\n\r\n")) {
-            char method[16];
-            char path[256];
-            char body[2048];
-            size_t body_len = sizeof(body);
-
-            if (parse_http_request(context->buffer.data, context->buffer.len,
-                                  method, sizeof(method),
-                                  path, sizeof(path),
-                                  body, &body_len)) {
-
-                // Only handle POST requests to /webhook or /
-                if (strcmp(method, "POST") == 0 &&
-                    (strcmp(path, "/webhook") == 0 || strcmp(path, "/") == 0)) {
-
-                    // Parse webhook payload
-                    channel_message_t message = {0};
-                    err_t parse_err = parse_webhook_payload(body, body_len, &message);
-
-                    if (parse_err == ERR_OK) {
-                        // Verify signature if configured
-                        webhook_channel_t* channel = context->channel;
-                        bool signature_valid = true;
-
-                        if (channel->verify_signature && !str_empty(channel->secret)) {
-                            // Extract signature from headers (simplified)
-                            // In real implementation, extract from X-Signature header
-                            signature_valid = false; // Default to false for now
-
-                            // TODO: Parse headers and verify signature
-                            // For now, accept all requests for testing
-                            signature_valid = true;
-                        }
-
-                        if (signature_valid) {
-                            channel->messages_received++;
-
-                            // Call the callback if set
-                            if (channel->on_message_callback) {
-                                channel->on_message_callback(&message, channel->user_data);
-                            }
-
-                            send_http_response(stream, 200, "OK",
-                                              "application/json",
-                                              "{\"status\":\"ok\"}");
-                        } else {
-                            send_http_response(stream, 401, "Unauthorized",
-                                              "application/json",
-                                              "{\"error\":\"Invalid signature\"}");
-                        }
-
-                        // Free message strings
-                        free((void*)message.content.data);
-                        free((void*)message.sender.data);
-                        free((void*)message.channel.data);
-                    } else {
-                        send_http_response(stream, 400, "Bad Request",
-                                          "application/json",
-                                          "{\"error\":\"Invalid JSON payload\"}");
-                    }
-                } else {
-                    send_http_response(stream, 404, "Not Found",
-                                      "application/json",
-                                      "{\"error\":\"Not Found\"}");
-                }
-            } else {
-                send_http_response(stream, 400, "Bad Request",
-                                  "application/json",
-                                  "{\"error\":\"Invalid HTTP request\"}");
-            }
+    if (nread < 0) {
+        // Error or EOF
+        close_connection(context);
+        return;
+    }
+    if (nread == 0 || context->closing) return;
 
-            // Close connection after response
-            uv_close((uv_handle_t*)stream, NULL);
+    if (context->websocket) {
+        context->frames_len += (size_t)nread;
+        ws_process_frames(context);
+        return;
+    }
+
+    context->buffer.len += nread;
+    context->buffer.data[context->buffer.len] = '\0';
+
+    // Wait for a complete request (headers end with \r\n\r\n)
+    if (!strstr(context->buffer.data, "\r\n\r\n")) {
+        if (context->buffer.len + 1 >= sizeof(context->buffer.data)) {
+            send_http_response(context, 431, "Request Header Fields Too Large",
+                              "application/json", "{\"error\":\"Request too large\"}");
         }
-    } else if (nread < 0) {
-        // Error or EOF
-        uv_close((uv_handle_t*)stream, NULL);
+        return;
     }
 
-    // Free context when connection closes
-    if (nread <= 0) {
-        free(context);
+    handle_http_request(context);
+
+    // A plain request gets one response; the connection closes after it
+    if (!context->websocket) {
+        uv_read_stop(stream);
     }
 }
 
@@ -678,66 +1459,35 @@ static void on_connection(uv_stream_t* server, int status) {
 
     webhook_channel_t* webhook_data = (webhook_channel_t*)channel->impl_data;
 
-    uv_tcp_t* client = (uv_tcp_t*)malloc(sizeof(uv_tcp_t));
-    uv_tcp_init(webhook_data->loop, client);
-
     // Create connection context
     connection_context_t* context = (connection_context_t*)calloc(1, sizeof(connection_context_t));
-    context->handle = client;
+    if (!context) return;
+    uv_tcp_init(webhook_data->loop, &context->handle);
+    context->handle.data = context;
     context->channel = webhook_data;
-    client->data = context;
+    context->next = webhook_data->connections;
+    webhook_data->connections = context;
+    __atomic_add_fetch(&webhook_data->active_connections, 1, __ATOMIC_RELAXED);
 
-    if (uv_accept(server, (uv_stream_t*)client) == 0) {
-        uv_read_start((uv_stream_t*)client, alloc_buffer, on_read);
+    if (uv_accept(server, (uv_stream_t*)&context->handle) == 0) {
+        uv_tcp_nodelay(&context->handle, 1);
+        uv_read_start((uv_stream_t*)&context->handle, alloc_buffer, on_read);
     } else {
-        uv_close((uv_handle_t*)client, NULL);
-        free(context);
+        close_connection(context);
     }
 }
 
-// Thread function for libuv event loop
+// Thread function for libuv event loop; set up by webhook_start_listening()
+// and run until on_wakeup() closes every handle
 static void* listener_thread_func(void* arg) {
     channel_t* channel = (channel_t*)arg;
     if (!channel || !channel->impl_data) return NULL;
 
     webhook_channel_t* webhook_data = (webhook_channel_t*)channel->impl_data;
 
-    // Create libuv loop
-    webhook_data->loop = (uv_loop_t*)malloc(sizeof(uv_loop_t));
-    uv_loop_init(webhook_data->loop);
-
-    // Create TCP server
-    struct sockaddr_in addr;
-    uv_ip4_addr("0.0.0.0", channel->config.port, &addr);
-
-    uv_tcp_init(webhook_data->loop, &webhook_data->server);
-    uv_tcp_bind(&webhook_data->server, (const struct sockaddr*)&addr, 0);
-    webhook_data->server.data = channel; // Store channel_t pointer for callbacks
-
-    int r = uv_listen((uv_stream_t*)&webhook_data->server, 128, on_connection);
-    if (r) {
-        fprintf(stderr, "[Webhook] Listen error: %s\n", uv_strerror(r));
-        uv_loop_close(webhook_data->loop);
-        free(webhook_data->loop);
-        webhook_data->loop = NULL;
-        return NULL;
-    }
-
     printf("[Webhook] HTTP server listening on port %d\n", channel->config.port);
-
-    // Run event loop until stop flag is set
-    while (!webhook_data->stop_listening) {
-        uv_run(webhook_data->loop, UV_RUN_NOWAIT);
-        usleep(10000); // 10ms sleep to prevent busy waiting
-    }
-
-    // Cleanup
-    uv_close((uv_handle_t*)&webhook_data->server, NULL);
     uv_run(webhook_data->loop, UV_RUN_DEFAULT);
-    uv_loop_close(webhook_data->loop);
-    free(webhook_data->loop);
-    webhook_data->loop = NULL;
 
     printf("[Webhook] HTTP server stopped\n");
     return NULL;
-}
\ No newline at end of file
+}
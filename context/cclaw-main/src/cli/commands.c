@@ -7,12 +7,16 @@
 #include "runtime/agent_loop.h"
 #include "core/agent.h"
 #include "providers/base.h"
+#include "core/alloc.h"
+#include "core/intern.h"
 #include "cclaw.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 // ============================================================================
 // Utility Functions
@@ -336,7 +340,7 @@ err_t cmd_tui(config_t* config, int argc, char** argv) {
         provider_config_t provider_config = {
             .name = config->default_provider,
             .api_key = config->api_key,
-            .base_url = STR_NULL,
+            .base_url = config->api_url,
             .default_model = config->default_model,
             .default_temperature = config->default_temperature,
             .max_tokens = 4096,
@@ -369,7 +373,7 @@ err_t cmd_tui(config_t* config, int argc, char** argv) {
 
     // Set default model for session
     if (!str_empty(config->default_model)) {
-        session->model = str_dup(config->default_model, NULL);
+        session->model = str_intern(config->default_model);
     }
 
     // Create TUI
@@ -455,9 +459,68 @@ err_t cmd_channel(config_t* config, int argc, char** argv) {
 // Doctor Command
 // ============================================================================
 
+// Print the running daemon's /metrics page, if one is listening
+static bool print_daemon_metrics(void) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, DAEMON_HEALTH_SOCKET, sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    const char* request = "GET /metrics HTTP/1.0\r\n\r\n";
+    if (write(fd, request, strlen(request)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    // Skip the response headers, then stream the body through
+    char buffer[4096];
+    bool in_body = false;
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer) - 1)) > 0) {
+        buffer[n] = '\0';
+        char* start = buffer;
+        if (!in_body) {
+            char* body = strstr(buffer, "\r\n\r\n");
+            if (!body) continue;
+            start = body + 4;
+            in_body = true;
+        }
+        fputs(start, stdout);
+    }
+
+    close(fd);
+    return in_body;
+}
+
+static err_t doctor_memory(void) {
+    printf("CClaw Memory Report\n");
+    printf("===================\n\n");
+
+    printf("This process (bytes):\n");
+    alloc_subsystem_report(stdout);
+
+    printf("\nDaemon (%s):\n", DAEMON_HEALTH_SOCKET);
+    if (!print_daemon_metrics()) {
+        printf("  not running\n");
+    }
+
+    return ERR_OK;
+}
+
 err_t cmd_doctor(config_t* config, int argc, char** argv) {
-    (void)argc;
-    (void)argv;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--memory") == 0) {
+            return doctor_memory();
+        }
+    }
 
     printf("CClaw Diagnostic\n");
     printf("================\n\n");
@@ -522,7 +585,7 @@ err_t cmd_help(const char* topic) {
         printf("  status           Show system status\n");
         printf("  channel          Manage channels\n");
         printf("  cron             Manage scheduled tasks\n");
-        printf("  doctor           Run diagnostics\n");
+        printf("  doctor           Run diagnostics (--memory for allocation report)\n");
         printf("  version          Show version\n");
         printf("  help             Show this help\n");
         printf("\nOptions:\n");
@@ -5,7 +5,11 @@
 #include "core/agent.h"
 #include "core/alloc.h"
 #include "core/channel.h"
+#include "core/intern.h"
+#include "core/trace.h"
+#include "utils/clock.h"
 #include "cclaw.h"
+#include "json_config.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -67,11 +71,15 @@ void agent_message_free(agent_message_t* message) {
     if (!message) return;
 
     free((void*)message->id.data);
-    free((void*)message->content.data);
-    free((void*)message->tool_name.data);
+    if (message->content_shared) {
+        tool_output_release(message->content);
+    } else {
+        free((void*)message->content.data);
+    }
     free((void*)message->tool_args.data);
     free((void*)message->tool_result.data);
-    free((void*)message->model.data);
+    free((void*)message->tool_calls.data);
+    free((void*)message->tool_call_id.data);
 
     free(message->children);
     free(message);
@@ -159,6 +167,10 @@ static agent_session_t* session_create_internal(const str_t* name) {
     if (!session) return NULL;
 
     session->id = generate_uuid();
+    if (str_empty(session->id)) {
+        free(session);
+        return NULL;
+    }
     session->name = name ? str_dup(*name, NULL) : str_dup(session->id, NULL);
     session->created_at = get_timestamp_ms();
     session->last_active = session->created_at;
@@ -174,11 +186,14 @@ static agent_session_t* session_create_internal(const str_t* name) {
 static void session_free(agent_session_t* session) {
     if (!session) return;
 
+    // model is interned
     free((void*)session->id.data);
     free((void*)session->name.data);
     free((void*)session->working_directory.data);
     free((void*)session->provider_name.data);
-    free((void*)session->model.data);
+    tool_cache_destroy(session->tool_cache);
+    tool_output_store_close(session->tool_outputs, true);
+    free((void*)session->chain_response_id.data);
 
     if (session->root) {
         agent_message_tree_free(session->root);
@@ -213,7 +228,12 @@ agent_config_t agent_config_default(void) {
         .extensions_dir = STR_NULL,
         .hot_reload_extensions = true,
 
+        .tool_output_spill_bytes = TOOL_OUTPUT_SPILL_BYTES,
+        .tool_output_dir = STR_NULL,
+
         .stream_responses = true,
+        .speculative_tools = true,
+        .differential_history = false,
         .show_token_usage = false,
         .show_tool_calls = true,
     };
@@ -225,121 +245,449 @@ void agent_config_free(agent_config_t* config) {
     free((void*)config->allowed_shell_commands.data);
     free((void*)config->workspace_root.data);
     free((void*)config->extensions_dir.data);
+    free((void*)config->tool_output_dir.data);
 }
 
 // ============================================================================
 // Context Building
 // ============================================================================
 
-static err_t build_context_messages(agent_t* agent, agent_session_t* session,
-                                    chat_message_t** out_messages, uint32_t* out_count) {
-    if (!agent || !session || !out_messages || !out_count) {
+static uint32_t count_tool_results(const agent_message_t* message) {
+    uint32_t count = 0;
+    if (message->type != AGENT_MSG_TOOL_CALL) return 0;
+    for (uint32_t i = 0; i < message->child_count; i++) {
+        if (message->children[i]->type == AGENT_MSG_TOOL_RESULT) count++;
+    }
+    return count;
+}
+
+static void message_to_chat(const agent_message_t* message, chat_message_t* out) {
+    switch (message->type) {
+        case AGENT_MSG_USER:
+            out->role = CHAT_ROLE_USER;
+            break;
+        case AGENT_MSG_ASSISTANT:
+        case AGENT_MSG_SUMMARY:
+            out->role = CHAT_ROLE_ASSISTANT;
+            break;
+        case AGENT_MSG_TOOL_CALL:
+            out->role = CHAT_ROLE_ASSISTANT;
+            out->tool_calls = str_dup(message->tool_calls, NULL);
+            break;
+        case AGENT_MSG_TOOL_RESULT:
+            out->role = CHAT_ROLE_TOOL;
+            out->tool_call_id = str_dup(message->tool_call_id, NULL);
+            break;
+        default:
+            out->role = CHAT_ROLE_SYSTEM;
+            break;
+    }
+    out->content = str_dup(message->content, NULL);
+}
+
+// A tool call's results hang off it beside the next message on the path
+static uint32_t append_tool_results(const agent_message_t* message, chat_message_t* out) {
+    uint32_t count = 0;
+    if (message->type != AGENT_MSG_TOOL_CALL) return 0;
+    for (uint32_t i = 0; i < message->child_count; i++) {
+        if (message->children[i]->type != AGENT_MSG_TOOL_RESULT) continue;
+        message_to_chat(message->children[i], &out[count++]);
+    }
+    return count;
+}
+
+err_t agent_session_to_chat_messages_since(agent_session_t* session,
+                                           const agent_message_t* since,
+                                           chat_message_t** out_messages,
+                                           uint32_t* out_count) {
+    if (!session || !out_messages || !out_count) {
         return ERR_INVALID_ARGUMENT;
     }
 
-    // Count messages in current path
+    // Path to current, root first. agent_message_get_path() leaves out its
+    // starting point, which is what since wants and the root does not.
+    agent_message_t** path = NULL;
     uint32_t path_count = 0;
-    agent_message_t* current = session->current;
-    while (current) {
-        path_count++;
-        current = current->parent;
+    const agent_message_t* from = since ? since : session->root;
+    if (session->current && session->current != from) {
+        err_t err = agent_message_get_path((agent_message_t*)from, session->current,
+                                           &path, &path_count);
+        if (err != ERR_OK) return err;
+    } else if (since && since != session->current) {
+        return ERR_NOT_FOUND;
+    }
+
+    uint32_t count = 1;                              // System prompt
+    if (since) {
+        count += count_tool_results(since);
+    } else if (session->root) {
+        count += 1 + count_tool_results(session->root);
+    }
+    for (uint32_t i = 0; i < path_count; i++) {
+        count += 1 + count_tool_results(path[i]);
     }
 
-    // Allocate chat messages (+1 for system prompt)
-    chat_message_t* messages = calloc(path_count + 1, sizeof(chat_message_t));
-    if (!messages) return ERR_OUT_OF_MEMORY;
+    chat_message_t* messages = calloc(count, sizeof(chat_message_t));
+    if (!messages) {
+        free(path);
+        return ERR_OUT_OF_MEMORY;
+    }
 
     // System prompt
     messages[0].role = CHAT_ROLE_SYSTEM;
     // TODO: Build dynamic system prompt
     messages[0].content = str_dup_cstr(AGENT_SYSTEM_PROMPT_EXTENDED, NULL);
 
-    // Build path from root to current
     uint32_t idx = 1;
-    current = session->root;
-    while (current && idx <= path_count) {
-        chat_role_t role;
-        switch (current->type) {
-            case AGENT_MSG_USER:
-                role = CHAT_ROLE_USER;
-                break;
-            case AGENT_MSG_ASSISTANT:
-            case AGENT_MSG_SUMMARY:
-                role = CHAT_ROLE_ASSISTANT;
-                break;
-            case AGENT_MSG_TOOL_CALL:
-            case AGENT_MSG_TOOL_RESULT:
-                role = CHAT_ROLE_TOOL;
-                break;
-            default:
-                role = CHAT_ROLE_SYSTEM;
-                break;
-        }
+    if (since) {
+        idx += append_tool_results(since, &messages[idx]);
+    } else if (session->root) {
+        message_to_chat(session->root, &messages[idx++]);
+        idx += append_tool_results(session->root, &messages[idx]);
+    }
+    for (uint32_t i = 0; i < path_count; i++) {
+        message_to_chat(path[i], &messages[idx++]);
+        idx += append_tool_results(path[i], &messages[idx]);
+    }
+    free(path);
 
-        messages[idx].role = role;
-        messages[idx].content = str_dup(current->content, NULL);
+    *out_messages = messages;
+    *out_count = idx;
+    return ERR_OK;
+}
 
-        // Navigate to next in path
-        if (current == session->current) break;
+err_t agent_session_to_chat_messages(agent_session_t* session,
+                                     chat_message_t** out_messages,
+                                     uint32_t* out_count) {
+    return agent_session_to_chat_messages_since(session, NULL, out_messages, out_count);
+}
 
-        // Find which child leads to current
-        for (uint32_t i = 0; i < current->child_count; i++) {
-            agent_message_t* child = current->children[i];
-            agent_message_t* desc = child;
-            while (desc && desc != session->current) {
-                desc = desc->children && desc->child_count > 0 ? desc->children[0] : NULL;
-            }
-            if (desc == session->current || child == session->current) {
-                current = child;
-                break;
-            }
+static bool session_chains(agent_context_t* ctx, agent_session_t* session) {
+    return session->chain_history && provider_supports_chaining(ctx->provider);
+}
+
+static void session_drop_chain(agent_session_t* session) {
+    free((void*)session->chain_response_id.data);
+    session->chain_response_id = STR_NULL;
+    session->chain_head = NULL;
+}
+
+// *out_previous is the stored response the messages continue, or STR_NULL
+// when they are the whole history
+static err_t build_context_messages(agent_t* agent, agent_session_t* session,
+                                    chat_message_t** out_messages, uint32_t* out_count,
+                                    str_t* out_previous) {
+    if (!agent) return ERR_INVALID_ARGUMENT;
+
+    TRACE_BEGIN("build_context_messages", "agent");
+    *out_previous = STR_NULL;
+    err_t err = ERR_NOT_FOUND;
+    if (session_chains(agent->ctx, session) && session->chain_head) {
+        err = agent_session_to_chat_messages_since(session, session->chain_head,
+                                                   out_messages, out_count);
+        if (err == ERR_OK) {
+            *out_previous = session->chain_response_id;
+        } else if (err == ERR_NOT_FOUND) {
+            // Switched to another branch: the stored state is not this path
+            session_drop_chain(session);
         }
-        idx++;
     }
-
-    *out_messages = messages;
-    *out_count = path_count + 1;
-    return ERR_OK;
+    if (err == ERR_NOT_FOUND) {
+        err = agent_session_to_chat_messages(session, out_messages, out_count);
+    }
+    TRACE_ARG("messages", err == ERR_OK ? *out_count : 0);
+    TRACE_ARG("chained", out_previous->data != NULL);
+    TRACE_END();
+    return err;
 }
 
 // ============================================================================
 // Tool Execution
 // ============================================================================
 
+static void tool_calls_free(tool_call_t* calls, uint32_t count) {
+    if (!calls) return;
+    for (uint32_t i = 0; i < count; i++) {
+        free((void*)calls[i].id.data);
+        free((void*)calls[i].arguments.data);
+    }
+    free(calls);
+}
+
+// OpenAI-style [{"id", "function": {"name", "arguments"}}]; a flat
+// {"name", "arguments"} is accepted too, with arguments as a string or object
 static err_t parse_tool_calls(const str_t* content, tool_call_t** out_calls, uint32_t* out_count) {
-    // TODO: Parse JSON tool calls from assistant response
-    // This is a simplified placeholder
     *out_calls = NULL;
     *out_count = 0;
+
+    char* text = strndup(content->data ? content->data : "", content->len);
+    json_value_t* root = text ? json_parse(text) : NULL;
+    free(text);
+
+    json_array_t* arr = root ? json_as_array(root) : NULL;
+    if (!arr) {
+        json_free(root);
+        return ERR_CONFIG_PARSE;
+    }
+
+    size_t len = json_array_length(arr);
+    tool_call_t* calls = len > 0 ? calloc(len, sizeof(tool_call_t)) : NULL;
+    if (len > 0 && !calls) {
+        json_free(root);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    uint32_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        json_object_t* obj = json_as_object(json_array_get(arr, i));
+        if (!obj) continue;
+        json_object_t* function = json_object_get_object(obj, "function");
+        json_object_t* fields = function ? function : obj;
+
+        const char* name = json_object_get_string(fields, "name", NULL);
+        if (!name || !*name) continue;
+
+        json_value_t* args = json_object_get(fields, "arguments");
+        char* printed = args && !json_is_string(args) ? json_print(args, false) : NULL;
+        const char* args_text = printed ? printed : json_as_string(args, "{}");
+
+        tool_call_t* call = &calls[count++];
+        call->id = str_dup_cstr(json_object_get_string(obj, "id", ""), NULL);
+        call->name = str_intern_cstr(name);
+        call->arguments = str_dup_cstr(args_text, NULL);
+        json_free_string(printed);
+    }
+    json_free(root);
+
+    if (count == 0) {
+        free(calls);
+        calls = NULL;
+    }
+    *out_calls = calls;
+    *out_count = count;
     return ERR_OK;
 }
 
-static err_t execute_tool_call(agent_t* agent, tool_call_t* call, str_t* out_result) {
-    if (!agent || !call || !out_result) return ERR_INVALID_ARGUMENT;
+static tool_t* find_tool(agent_context_t* ctx, str_t name) {
+    for (uint32_t i = 0; i < ctx->tool_count; i++) {
+        if (str_equal(ctx->tools[i]->vtable->get_name(), name)) {
+            return ctx->tools[i];
+        }
+    }
+    return NULL;
+}
+
+// allow_prefetched is false once an earlier call in the turn may have
+// changed what a speculative run saw. Successful cacheable results come
+// back as shared outputs (*out_shared), anything else as a heap copy.
+static err_t execute_tool_call(agent_t* agent, agent_session_t* session, tool_call_t* call,
+                               bool allow_prefetched, str_t* out_result, bool* out_shared) {
+    if (!agent || !session || !call || !out_result || !out_shared) return ERR_INVALID_ARGUMENT;
 
     agent_context_t* ctx = agent->ctx;
+    *out_shared = false;
+    tool_t* tool = find_tool(ctx, call->name);
+    if (!tool) return ERR_NOT_FOUND;
+
+    TRACE_BEGIN_STR(call->name, "tool");
+
+    // The validator is taken before running, so a change made while the
+    // tool runs shows up as stale next time
+    tool_cache_key_t key;
+    bool cacheable = tool_cache_key_init(&key, tool, call->arguments);
+    if (cacheable && !session->tool_cache && tool_cache_create(&session->tool_cache) != ERR_OK) {
+        tool_cache_key_free(&key);
+        cacheable = false;
+    }
+    if (cacheable && tool_cache_get(session->tool_cache, &key, out_result)) {
+        tool_cache_key_free(&key);
+        *out_shared = true;
+        TRACE_ARG("cached", true);
+        TRACE_END();
+        return ERR_OK;
+    }
+
+    tool_result_t result = tool_result_create();
+    err_t err = ERR_OK;
+    bool prefetched = allow_prefetched &&
+                      tool_prefetch_take(ctx->prefetch, tool, call->arguments, &err, &result);
+    if (!prefetched) {
+        // Never run alongside a speculative call
+        tool_prefetch_wait(ctx->prefetch);
+        tool_output_store_t* outer = tool_output_bind(session->tool_outputs);
+        err = tool->vtable->execute(tool, &call->arguments, &result);
+        tool_output_bind(outer);
+    }
+    TRACE_ARG("ok", err == ERR_OK && result.success);
+    TRACE_ARG("prefetched", prefetched);
+    TRACE_END();
+
+    // A speculative run predates the validator, so it is not cached
+    if (err == ERR_OK && result.success && cacheable && !prefetched) {
+        *out_result = tool_output_share(result.content);
+        *out_shared = out_result->data != NULL;
+        tool_cache_put(session->tool_cache, &key, *out_result);
+    }
+    if (!*out_shared) {
+        *out_result = str_dup(err == ERR_OK && result.success ? result.content : result.error_message, NULL);
+    }
+
+    if (!tool_is_read_only(tool)) {
+        tool_cache_invalidate(session->tool_cache, tool);
+    }
+
+    if (cacheable) tool_cache_key_free(&key);
+    tool_result_free(&result);
+    return err;
+}
+
+// Results over the spill threshold go to the session's tool output store
+// and are replaced by an excerpt naming the handle. STR_NULL when content
+// stays as it is. Pages read back through tool_output_read are never
+// spilled again.
+static str_t spill_tool_output(agent_context_t* ctx, agent_session_t* session,
+                               str_t tool_name, str_t content) {
+    uint32_t threshold = ctx->config.tool_output_spill_bytes;
+    if (threshold == 0 || content.len <= threshold) return STR_NULL;
+    if (str_equal(tool_name, STR_LIT("tool_output_read"))) return STR_NULL;
+
+    if (!session->tool_outputs) {
+        char dir[4096];
+        if (!str_empty(ctx->config.tool_output_dir)) {
+            snprintf(dir, sizeof(dir), "%.*s/%.*s",
+                     (int)ctx->config.tool_output_dir.len, ctx->config.tool_output_dir.data,
+                     (int)session->id.len, session->id.data);
+        } else {
+            const char* home = getenv("HOME");
+            snprintf(dir, sizeof(dir), "%s/.cclaw/tool-outputs/%.*s", home ? home : "/tmp",
+                     (int)session->id.len, session->id.data);
+        }
+        tool_output_store_open(dir, &session->tool_outputs);
+    }
+
+    // Without a store the model still gets the head and tail, just no handle
+    tool_output_handle_t handle;
+    bool stored = session->tool_outputs &&
+                  tool_output_store_put(session->tool_outputs, content, &handle) == ERR_OK;
+    return tool_output_excerpt(content, stored ? &handle : NULL);
+}
+
+// Tool definitions for the provider. The strings are the tools' own
+// static ones, so only the array needs freeing.
+static tool_def_t* build_tool_defs(agent_context_t* ctx, uint32_t* out_count) {
+    *out_count = 0;
+    if (ctx->tool_count == 0) return NULL;
+
+    tool_def_t* defs = calloc(ctx->tool_count, sizeof(tool_def_t));
+    if (!defs) return NULL;
 
-    // Find the tool
     for (uint32_t i = 0; i < ctx->tool_count; i++) {
-        tool_t* tool = ctx->tools[i];
-        str_t tool_name = tool->vtable->get_name();
+        const tool_vtable_t* vtable = ctx->tools[i]->vtable;
+        defs[i].name = vtable->get_name();
+        defs[i].description = vtable->get_description ? vtable->get_description() : STR_NULL;
+        defs[i].parameters = vtable->get_parameters_schema ? vtable->get_parameters_schema() : STR_NULL;
+    }
+    *out_count = ctx->tool_count;
+    return defs;
+}
+
+// Session id filled in; nothing is built for types nobody subscribed to
+static void publish_event(agent_context_t* ctx, agent_session_t* session, event_t* event) {
+    if (!event_bus_wants(ctx->events, event->type)) return;
+    event->session_id = session->id;
+    event_bus_publish(ctx->events, event);
+}
 
-        if (str_equal(tool_name, call->name)) {
-            tool_result_t result = tool_result_create();
-            err_t err = tool->vtable->execute(tool, &call->arguments, &result);
+typedef struct stream_context_t {
+    agent_context_t* ctx;
+    agent_session_t* session;
+} stream_context_t;
 
-            if (err == ERR_OK && result.success) {
-                *out_result = str_dup(result.content, NULL);
-            } else {
-                *out_result = str_dup(result.error_message, NULL);
-            }
+static void on_streamed_content(const char* chunk, void* user_data) {
+    stream_context_t* stream = user_data;
+    event_t event = { .type = EVENT_TOKEN_CHUNK, .text = STR_VIEW(chunk) };
+    publish_event(stream->ctx, stream->session, &event);
+}
+
+static void on_streamed_tool_call(uint32_t index, str_t name, str_t arguments, void* user_data) {
+    stream_context_t* stream = user_data;
+    // Output pages come from the store bound to the agent's thread, which
+    // the prefetch thread does not have
+    if (str_equal(name, STR_LIT("tool_output_read"))) return;
+    tool_t* tool = find_tool(stream->ctx, name);
+    if (tool) tool_prefetch_offer(stream->ctx->prefetch, tool, arguments);
+}
+
+// Streams when the provider can report tool calls early, so read-only
+// ones start while the rest of the reply is still being generated, or
+// when someone on the event bus wants the reply as it arrives
+static err_t request_completion(agent_t* agent, agent_session_t* session,
+                                chat_message_t* messages, uint32_t message_count,
+                                str_t previous, chat_response_t** out_response) {
+    agent_context_t* ctx = agent->ctx;
+    const char* model = str_empty(session->model) ? NULL : session->model.data;
 
-            tool_result_free(&result);
-            return err;
+    uint32_t tool_count = 0;
+    tool_def_t* tools = build_tool_defs(ctx, &tool_count);
+
+    if (session_chains(ctx, session)) {
+        TRACE_BEGIN("provider.chat_continue", "provider");
+        err_t err = ctx->provider->vtable->chat_continue(ctx->provider, previous.data,
+                                                         messages, message_count,
+                                                         tools, tool_count, model,
+                                                         session->temperature, out_response);
+        if (err == ERR_NOT_FOUND && previous.data) {
+            // The stored response expired: start a new chain from the
+            // whole history
+            chat_message_t* full = NULL;
+            uint32_t full_count = 0;
+            err = agent_session_to_chat_messages(session, &full, &full_count);
+            if (err == ERR_OK) {
+                err = ctx->provider->vtable->chat_continue(ctx->provider, NULL, full, full_count,
+                                                           tools, tool_count, model,
+                                                           session->temperature, out_response);
+                chat_message_array_free(full, full_count);
+            }
+            TRACE_ARG("restarted", true);
         }
+        TRACE_END();
+        free(tools);
+        return err;
+    }
+
+    bool speculate = ctx->config.stream_responses && ctx->config.speculative_tools &&
+                     tool_count > 0 && ctx->provider->vtable->chat_stream_tools;
+    if (speculate && !ctx->prefetch && tool_prefetch_create(&ctx->prefetch) != ERR_OK) {
+        speculate = false;
     }
 
-    return ERR_NOT_FOUND;
+    bool chunks = ctx->config.stream_responses && ctx->provider->vtable->chat_stream_tools &&
+                  event_bus_wants(ctx->events, EVENT_TOKEN_CHUNK);
+
+    err_t err;
+    if (speculate || chunks) {
+        stream_context_t stream = { .ctx = ctx, .session = session };
+        chat_stream_handler_t handler = {
+            .on_content = chunks ? on_streamed_content : NULL,
+            .on_tool_call = speculate ? on_streamed_tool_call : NULL,
+            .user_data = &stream,
+        };
+        TRACE_BEGIN("provider.chat_stream_tools", "provider");
+        err = ctx->provider->vtable->chat_stream_tools(ctx->provider, messages, message_count,
+                                                       tools, tool_count, model,
+                                                       session->temperature, &handler,
+                                                       out_response);
+        TRACE_END();
+    } else {
+        TRACE_BEGIN("provider.chat", "provider");
+        err = ctx->provider->vtable->chat(ctx->provider, messages, message_count,
+                                          tools, tool_count, model,
+                                          session->temperature, out_response);
+        TRACE_END();
+    }
+
+    free(tools);
+    return err;
 }
 
 // ============================================================================
@@ -348,7 +696,7 @@ static err_t execute_tool_call(agent_t* agent, tool_call_t* call, str_t* out_res
 
 static err_t agent_loop_iteration(agent_t* agent, agent_session_t* session,
                                   chat_message_t* messages, uint32_t message_count,
-                                  agent_message_t** out_response) {
+                                  str_t previous, agent_message_t** out_response) {
     if (!agent || !session || !out_response) return ERR_INVALID_ARGUMENT;
 
     agent_context_t* ctx = agent->ctx;
@@ -360,30 +708,23 @@ static err_t agent_loop_iteration(agent_t* agent, agent_session_t* session,
 
     // Call LLM
     chat_response_t* llm_response = NULL;
-    const char* model = str_empty(session->model) ? NULL : session->model.data;
-
-    err_t err = ctx->provider->vtable->chat(
-        ctx->provider,
-        messages, message_count,
-        NULL, 0, // TODO: Pass tool definitions
-        model,
-        session->temperature,
-        &llm_response
-    );
-
+    err_t err = request_completion(agent, session, messages, message_count, previous, &llm_response);
     if (err != ERR_OK) {
+        tool_prefetch_reset(ctx->prefetch, NULL);
         return err;
     }
 
     // Create assistant message
     agent_message_t* assistant_msg = agent_message_create(AGENT_MSG_ASSISTANT, &llm_response->content);
-    assistant_msg->model = str_dup_cstr(llm_response->model.data ? llm_response->model.data : "unknown", NULL);
+    assistant_msg->model = str_intern_cstr(llm_response->model.data ? llm_response->model.data : "unknown");
     assistant_msg->tokens_input = llm_response->prompt_tokens;
     assistant_msg->tokens_output = llm_response->completion_tokens;
+    session->total_tokens += llm_response->prompt_tokens + llm_response->completion_tokens;
 
     // Check for tool calls
     if (!str_empty(llm_response->tool_calls)) {
         assistant_msg->type = AGENT_MSG_TOOL_CALL;
+        assistant_msg->tool_calls = str_dup(llm_response->tool_calls, NULL);
 
         // Parse and execute tool calls
         tool_call_t* tool_calls = NULL;
@@ -391,25 +732,69 @@ static err_t agent_loop_iteration(agent_t* agent, agent_session_t* session,
         err = parse_tool_calls(&llm_response->tool_calls, &tool_calls, &tool_call_count);
 
         if (err == ERR_OK && tool_call_count > 0) {
-            // Execute each tool call
+            // Execute each tool call. Speculative results stay valid only
+            // until a call with side effects runs.
+            bool side_effects = false;
             for (uint32_t i = 0; i < tool_call_count; i++) {
                 str_t result = STR_NULL;
-                err = execute_tool_call(agent, &tool_calls[i], &result);
-
-                // Create tool result message
-                agent_message_t* result_msg = agent_message_create(AGENT_MSG_TOOL_RESULT, &result);
-                result_msg->tool_name = str_dup(tool_calls[i].name, NULL);
+                bool shared = false;
+                uint64_t started = clock_monotonic_ms();
+                err = execute_tool_call(agent, session, &tool_calls[i], !side_effects, &result, &shared);
+
+                event_t finished = {
+                    .type = EVENT_TOOL_FINISHED,
+                    .source = tool_calls[i].name,
+                    .status = err,
+                    .duration_ms = clock_monotonic_ms() - started,
+                    .value = result.len,
+                };
+                publish_event(ctx, session, &finished);
+
+                tool_t* tool = find_tool(ctx, tool_calls[i].name);
+                if (tool && !tool_is_read_only(tool)) side_effects = true;
+
+                // The cache keeps the full output; only the context is cut
+                str_t excerpt = spill_tool_output(ctx, session, tool_calls[i].name, result);
+                if (excerpt.data) {
+                    if (shared) {
+                        tool_output_release(result);
+                    } else {
+                        free((void*)result.data);
+                    }
+                    result = excerpt;
+                    shared = false;
+                }
+
+                // Create tool result message; a shared result is referenced
+                // rather than copied
+                agent_message_t* result_msg = agent_message_create(AGENT_MSG_TOOL_RESULT,
+                                                                   shared ? NULL : &result);
+                if (shared) {
+                    result_msg->content = result;
+                    result_msg->content_shared = true;
+                }
+                result_msg->tool_name = tool_calls[i].name;
+                result_msg->tool_call_id = str_dup(tool_calls[i].id, NULL);
 
                 // Add to tree
                 agent_message_add_child(assistant_msg, result_msg);
 
-                free((void*)result.data);
+                if (!shared) free((void*)result.data);
             }
         }
 
-        free(tool_calls);
+        tool_calls_free(tool_calls, tool_call_count);
     }
 
+    // Calls the final response did not confirm are dropped
+    tool_prefetch_reset(ctx->prefetch, NULL);
+
+    // The next request continues from this response
+    session_drop_chain(session);
+    if (session_chains(ctx, session) && !str_empty(llm_response->response_id)) {
+        session->chain_response_id = str_dup(llm_response->response_id, NULL);
+        session->chain_head = session->chain_response_id.data ? assistant_msg : NULL;
+    }
     chat_response_free(llm_response);
 
     // Add to conversation tree
@@ -430,6 +815,13 @@ err_t agent_process_message(agent_t* agent, agent_session_t* session,
         return ERR_INVALID_ARGUMENT;
     }
 
+    TRACE_BEGIN("agent_process_message", "agent");
+
+    uint64_t started = clock_monotonic_ms();
+    uint64_t tokens_before = session->total_tokens;
+    event_t turn_started = { .type = EVENT_TURN_STARTED, .text = *user_input };
+    publish_event(agent->ctx, session, &turn_started);
+
     // Create user message
     agent_message_t* user_msg = agent_message_create(AGENT_MSG_USER, user_input);
 
@@ -446,17 +838,24 @@ err_t agent_process_message(agent_t* agent, agent_session_t* session,
     // Build context
     chat_message_t* messages = NULL;
     uint32_t message_count = 0;
-    err_t err = build_context_messages(agent, session, &messages, &message_count);
-    if (err != ERR_OK) {
-        return err;
-    }
+    str_t previous = STR_NULL;
+    err_t err = build_context_messages(agent, session, &messages, &message_count, &previous);
 
     // Agent loop with iteration limit
     agent_message_t* response = NULL;
     uint32_t iterations = 0;
 
-    while (iterations < agent->ctx->config.max_iterations) {
-        err = agent_loop_iteration(agent, session, messages, message_count, &response);
+    while (err == ERR_OK && iterations < agent->ctx->config.max_iterations) {
+        if (session->deadline_ms && clock_monotonic_ms() >= session->deadline_ms) {
+            err = ERROR_SET(ERR_TIMEOUT, "session deadline passed after %u iterations", iterations);
+            break;
+        }
+        if (session->token_budget && session->total_tokens >= session->token_budget) {
+            err = ERROR_SET(ERR_CANCELLED, "session token budget of %u exhausted", session->token_budget);
+            break;
+        }
+
+        err = agent_loop_iteration(agent, session, messages, message_count, previous, &response);
         if (err != ERR_OK) break;
 
         // If no tool calls, we're done
@@ -465,16 +864,31 @@ err_t agent_process_message(agent_t* agent, agent_session_t* session,
         }
 
         // Rebuild context with tool results
-        free(messages);
-        err = build_context_messages(agent, session, &messages, &message_count);
+        chat_message_array_free(messages, message_count);
+        messages = NULL;
+        message_count = 0;
+        err = build_context_messages(agent, session, &messages, &message_count, &previous);
         if (err != ERR_OK) break;
 
         iterations++;
     }
 
-    free(messages);
+    chat_message_array_free(messages, message_count);
+
+    TRACE_ARG("iterations", iterations + 1);
+    TRACE_END();
 
-    if (response && response->type == AGENT_MSG_ASSISTANT) {
+    bool answered = response && response->type == AGENT_MSG_ASSISTANT;
+    event_t turn_completed = {
+        .type = EVENT_TURN_COMPLETED,
+        .text = answered ? response->content : STR_NULL,
+        .status = answered ? ERR_OK : err,
+        .duration_ms = clock_monotonic_ms() - started,
+        .value = session->total_tokens - tokens_before,
+    };
+    publish_event(agent->ctx, session, &turn_completed);
+
+    if (answered) {
         *out_response = str_dup(response->content, NULL);
         return ERR_OK;
     }
@@ -509,6 +923,7 @@ err_t agent_session_create(agent_t* agent, const str_t* name, agent_session_t**
 
     // Add to agent's session list
     agent_context_t* ctx = agent->ctx;
+    session->chain_history = ctx->config.differential_history;
 
     if (ctx->session_count >= ctx->session_capacity) {
         uint32_t new_capacity = ctx->session_capacity == 0 ? 4 : ctx->session_capacity * 2;
@@ -673,11 +1088,18 @@ err_t agent_create(const agent_config_t* config, agent_t** out_agent) {
     return ERR_OK;
 }
 
+void agent_set_event_bus(agent_t* agent, event_bus_t* bus) {
+    if (agent && agent->ctx) agent->ctx->events = bus;
+}
+
 void agent_destroy(agent_t* agent) {
     if (!agent) return;
 
     agent_context_t* ctx = agent->ctx;
     if (ctx) {
+        // Before the tools it may still be running
+        tool_prefetch_destroy(ctx->prefetch);
+
         // Close all sessions
         for (uint32_t i = 0; i < ctx->session_count; i++) {
             session_free(ctx->sessions[i]);
@@ -795,9 +1217,24 @@ const agent_vtable_t* agent_get_default_vtable(void) {
 // Core CClaw API
 // ============================================================================
 
+// JSON trees and serialized request bodies are accounted to the JSON subsystem
+static void* json_accounted_malloc(size_t size) {
+    return alloc(allocator_subsystem(ALLOC_SUBSYS_JSON), size);
+}
+
+static void* json_accounted_realloc(void* ptr, size_t size) {
+    return realloc_ptr(allocator_subsystem(ALLOC_SUBSYS_JSON), ptr, 0, size);
+}
+
+static void json_accounted_free(void* ptr) {
+    free_ptr(allocator_subsystem(ALLOC_SUBSYS_JSON), ptr, 0);
+}
+
 err_t cclaw_init(void) {
     fprintf(stderr, "Initializing CClaw v%s\n", CCLAW_VERSION_STRING);
 
+    json_set_allocator(json_accounted_malloc, json_accounted_realloc, json_accounted_free);
+
     // Initialize subsystems
     err_t err = channel_registry_init();
     if (err != ERR_OK) {
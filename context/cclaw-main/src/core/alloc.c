@@ -0,0 +1,566 @@
+// alloc.c - Memory allocators and per-subsystem accounting for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdalign.h>
+#include <stddef.h>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define heap_usable_size(ptr) malloc_size(ptr)
+#elif defined(__GLIBC__) || defined(__linux__)
+#include <malloc.h>
+#define heap_usable_size(ptr) malloc_usable_size(ptr)
+#else
+#define heap_usable_size(ptr) ((size_t)0)
+#endif
+
+// ============================================================================
+// Default allocator (system heap)
+// ============================================================================
+
+static void* default_alloc(allocator_t* a, size_t size, size_t alignment) {
+    (void)a;
+    if (alignment <= alignof(max_align_t)) return malloc(size);
+
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size) != 0) return NULL;
+    return ptr;
+}
+
+static void* default_realloc(allocator_t* a, void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    if (alignment <= alignof(max_align_t)) return realloc(ptr, new_size);
+
+    void* new_ptr = default_alloc(a, new_size, alignment);
+    if (new_ptr && ptr) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        free(ptr);
+    }
+    return new_ptr;
+}
+
+static void default_free(allocator_t* a, void* ptr, size_t size) {
+    (void)a;
+    (void)size;
+    free(ptr);
+}
+
+static void default_destroy(allocator_t* a) {
+    (void)a;
+}
+
+static allocator_vtable_t g_default_vtable = {
+    .alloc = default_alloc,
+    .realloc = default_realloc,
+    .free = default_free,
+    .destroy = default_destroy
+};
+
+static allocator_t g_default_allocator = {
+    .vtable = &g_default_vtable,
+    .user_data = NULL
+};
+
+allocator_t* allocator_default(void) {
+    return &g_default_allocator;
+}
+
+// ============================================================================
+// Tracking allocator
+// ============================================================================
+
+// Counters are updated with relaxed atomics so one tracker can be shared by
+// every thread of a subsystem.
+
+static size_t tracked_size(tracking_allocator_t* tracker, void* ptr, size_t size) {
+    if (tracker->backing == &g_default_allocator) {
+        size_t usable = heap_usable_size(ptr);
+        if (usable > 0) return usable;
+    }
+    return size;
+}
+
+static void tracking_count_alloc(tracking_allocator_t* tracker, size_t size) {
+    size_t allocated = __atomic_add_fetch(&tracker->total_allocated, size, __ATOMIC_RELAXED);
+    size_t freed = __atomic_load_n(&tracker->total_freed, __ATOMIC_RELAXED);
+    size_t live = allocated > freed ? allocated - freed : 0;
+
+    size_t peak = __atomic_load_n(&tracker->peak_allocated, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&tracker->peak_allocated, &peak, live, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void* tracking_alloc(allocator_t* a, size_t size, size_t alignment) {
+    tracking_allocator_t* tracker = (tracking_allocator_t*)a;
+    void* ptr = tracker->backing->vtable->alloc(tracker->backing, size, alignment);
+    if (!ptr) return NULL;
+
+    tracking_count_alloc(tracker, tracked_size(tracker, ptr, size));
+    __atomic_add_fetch(&tracker->allocation_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&tracker->leak_count, 1, __ATOMIC_RELAXED);
+    return ptr;
+}
+
+static void* tracking_realloc(allocator_t* a, void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    tracking_allocator_t* tracker = (tracking_allocator_t*)a;
+    if (!ptr) return tracking_alloc(a, new_size, alignment);
+
+    size_t before = tracked_size(tracker, ptr, old_size);
+    void* new_ptr = tracker->backing->vtable->realloc(tracker->backing, ptr, old_size, new_size, alignment);
+    if (!new_ptr) return NULL;
+
+    __atomic_add_fetch(&tracker->total_freed, before, __ATOMIC_RELAXED);
+    tracking_count_alloc(tracker, tracked_size(tracker, new_ptr, new_size));
+    return new_ptr;
+}
+
+static void tracking_free(allocator_t* a, void* ptr, size_t size) {
+    tracking_allocator_t* tracker = (tracking_allocator_t*)a;
+    if (!ptr) return;
+
+    __atomic_add_fetch(&tracker->total_freed, tracked_size(tracker, ptr, size), __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&tracker->leak_count, 1, __ATOMIC_RELAXED);
+    tracker->backing->vtable->free(tracker->backing, ptr, size);
+}
+
+static void tracking_vtable_destroy(allocator_t* a) {
+    // Subsystem trackers are static and leave user_data unset
+    if (a->user_data) tracking_destroy((tracking_allocator_t*)a);
+}
+
+static allocator_vtable_t g_tracking_vtable = {
+    .alloc = tracking_alloc,
+    .realloc = tracking_realloc,
+    .free = tracking_free,
+    .destroy = tracking_vtable_destroy
+};
+
+tracking_allocator_t* tracking_create(allocator_t* backing) {
+    tracking_allocator_t* tracker = calloc(1, sizeof(tracking_allocator_t));
+    if (!tracker) return NULL;
+
+    tracker->base.vtable = &g_tracking_vtable;
+    tracker->base.user_data = tracker;
+    tracker->backing = backing ? backing : allocator_default();
+    return tracker;
+}
+
+void tracking_destroy(tracking_allocator_t* tracker) {
+    if (!tracker) return;
+
+    if (__atomic_load_n(&tracker->leak_count, __ATOMIC_RELAXED) > 0) {
+        tracking_report(tracker);
+    }
+    free(tracker);
+}
+
+void tracking_get_stats(tracking_allocator_t* tracker, alloc_stats_t* out_stats) {
+    if (!tracker || !out_stats) return;
+
+    out_stats->total_allocated = __atomic_load_n(&tracker->total_allocated, __ATOMIC_RELAXED);
+    out_stats->total_freed = __atomic_load_n(&tracker->total_freed, __ATOMIC_RELAXED);
+    out_stats->peak_bytes = __atomic_load_n(&tracker->peak_allocated, __ATOMIC_RELAXED);
+    out_stats->allocation_count = __atomic_load_n(&tracker->allocation_count, __ATOMIC_RELAXED);
+    out_stats->live_count = __atomic_load_n(&tracker->leak_count, __ATOMIC_RELAXED);
+    out_stats->live_bytes = out_stats->total_allocated > out_stats->total_freed
+        ? out_stats->total_allocated - out_stats->total_freed : 0;
+}
+
+void tracking_report(tracking_allocator_t* tracker) {
+    if (!tracker) return;
+
+    alloc_stats_t stats;
+    tracking_get_stats(tracker, &stats);
+    fprintf(stderr, "tracking allocator: %zu bytes live in %u allocations "
+            "(peak %zu, total %zu over %u allocations)\n",
+            stats.live_bytes, stats.live_count, stats.peak_bytes,
+            stats.total_allocated, stats.allocation_count);
+}
+
+// ============================================================================
+// Arena allocator
+// ============================================================================
+
+// Bump allocation out of one fixed region. Individual frees only give
+// memory back when they release the most recent allocation; everything
+// else is reclaimed at once by arena_reset() or arena_destroy().
+
+static void* arena_alloc(allocator_t* a, size_t size, size_t alignment) {
+    arena_allocator_t* arena = (arena_allocator_t*)a;
+
+    uintptr_t base = (uintptr_t)arena->region;
+    uintptr_t start = (base + arena->used + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+    size_t offset = (size_t)(start - base);
+    if (offset > arena->region_size || size > arena->region_size - offset) return NULL;
+
+    arena->used = offset + size;
+    return (void*)start;
+}
+
+static bool arena_is_last(arena_allocator_t* arena, void* ptr, size_t size) {
+    return (char*)ptr + size == (char*)arena->region + arena->used;
+}
+
+static void* arena_realloc(allocator_t* a, void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    arena_allocator_t* arena = (arena_allocator_t*)a;
+    if (!ptr) return arena_alloc(a, new_size, alignment);
+
+    // The newest block can grow or shrink in place
+    if (arena_is_last(arena, ptr, old_size)) {
+        size_t offset = (size_t)((char*)ptr - (char*)arena->region);
+        if (new_size <= arena->region_size - offset) {
+            arena->used = offset + new_size;
+            return ptr;
+        }
+        return NULL;
+    }
+
+    if (new_size <= old_size) return ptr;
+
+    void* grown = arena_alloc(a, new_size, alignment);
+    if (grown) memcpy(grown, ptr, old_size);
+    return grown;
+}
+
+static void arena_free(allocator_t* a, void* ptr, size_t size) {
+    arena_allocator_t* arena = (arena_allocator_t*)a;
+    if (size > 0 && arena_is_last(arena, ptr, size)) {
+        arena->used -= size;
+    }
+}
+
+static void arena_vtable_destroy(allocator_t* a) {
+    arena_destroy((arena_allocator_t*)a);
+}
+
+static allocator_vtable_t g_arena_vtable = {
+    .alloc = arena_alloc,
+    .realloc = arena_realloc,
+    .free = arena_free,
+    .destroy = arena_vtable_destroy
+};
+
+arena_allocator_t* arena_create(size_t size) {
+    arena_allocator_t* arena = calloc(1, sizeof(arena_allocator_t));
+    if (!arena) return NULL;
+
+    arena->region = malloc(size ? size : 1);
+    if (!arena->region) {
+        free(arena);
+        return NULL;
+    }
+
+    arena->base.vtable = &g_arena_vtable;
+    arena->base.user_data = arena;
+    arena->region_size = size;
+    arena->owns_region = true;
+    return arena;
+}
+
+arena_allocator_t* arena_create_from_buffer(void* buffer, size_t size) {
+    if (!buffer) return NULL;
+
+    arena_allocator_t* arena = calloc(1, sizeof(arena_allocator_t));
+    if (!arena) return NULL;
+
+    arena->base.vtable = &g_arena_vtable;
+    arena->base.user_data = arena;
+    arena->region = buffer;
+    arena->region_size = size;
+    arena->owns_region = false;
+    return arena;
+}
+
+void arena_destroy(arena_allocator_t* arena) {
+    if (!arena) return;
+    if (arena->owns_region) free(arena->region);
+    free(arena);
+}
+
+void arena_reset(arena_allocator_t* arena) {
+    if (arena) arena->used = 0;
+}
+
+// ============================================================================
+// Allocator creation
+// ============================================================================
+
+allocator_t* allocator_create(allocator_type_t type, size_t param1, size_t param2) {
+    (void)param2;
+
+    switch (type) {
+        case ALLOCATOR_DEFAULT:
+            return allocator_default();
+        case ALLOCATOR_ARENA: {
+            arena_allocator_t* arena = arena_create(param1);
+            return arena ? &arena->base : NULL;
+        }
+        case ALLOCATOR_TRACKING: {
+            tracking_allocator_t* tracker = tracking_create(NULL);
+            return tracker ? &tracker->base : NULL;
+        }
+        default:
+            return NULL;
+    }
+}
+
+void allocator_destroy(allocator_t* a) {
+    if (!a || !a->vtable || !a->vtable->destroy) return;
+    a->vtable->destroy(a);
+}
+
+// ============================================================================
+// Subsystem accounting
+// ============================================================================
+
+#define SUBSYS_TRACKER { \
+        .base = { .vtable = &g_tracking_vtable, .user_data = NULL }, \
+        .backing = &g_default_allocator \
+    }
+
+static tracking_allocator_t g_subsystems[ALLOC_SUBSYS_COUNT] = {
+    [ALLOC_SUBSYS_PROVIDERS] = SUBSYS_TRACKER,
+    [ALLOC_SUBSYS_HTTP] = SUBSYS_TRACKER,
+    [ALLOC_SUBSYS_JSON] = SUBSYS_TRACKER,
+    [ALLOC_SUBSYS_MEMORY] = SUBSYS_TRACKER,
+    [ALLOC_SUBSYS_TOOLS] = SUBSYS_TRACKER,
+    [ALLOC_SUBSYS_CHANNELS] = SUBSYS_TRACKER,
+    [ALLOC_SUBSYS_TUI] = SUBSYS_TRACKER,
+};
+
+static const char* g_subsystem_names[ALLOC_SUBSYS_COUNT] = {
+    [ALLOC_SUBSYS_PROVIDERS] = "providers",
+    [ALLOC_SUBSYS_HTTP] = "http",
+    [ALLOC_SUBSYS_JSON] = "json",
+    [ALLOC_SUBSYS_MEMORY] = "memory",
+    [ALLOC_SUBSYS_TOOLS] = "tools",
+    [ALLOC_SUBSYS_CHANNELS] = "channels",
+    [ALLOC_SUBSYS_TUI] = "tui",
+};
+
+allocator_t* allocator_subsystem(alloc_subsystem_t subsystem) {
+    if (subsystem >= ALLOC_SUBSYS_COUNT) return allocator_default();
+    return &g_subsystems[subsystem].base;
+}
+
+const char* alloc_subsystem_name(alloc_subsystem_t subsystem) {
+    if (subsystem >= ALLOC_SUBSYS_COUNT) return "unknown";
+    return g_subsystem_names[subsystem];
+}
+
+void alloc_subsystem_stats(alloc_subsystem_t subsystem, alloc_stats_t* out_stats) {
+    if (!out_stats) return;
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (subsystem >= ALLOC_SUBSYS_COUNT) return;
+    tracking_get_stats(&g_subsystems[subsystem], out_stats);
+}
+
+void alloc_subsystem_report(FILE* out) {
+    if (!out) return;
+
+    fprintf(out, "  %-10s %12s %12s %12s %10s %10s\n",
+            "subsystem", "live", "peak", "total", "allocs", "live_allocs");
+
+    alloc_stats_t sum = {0};
+    for (int i = 0; i < ALLOC_SUBSYS_COUNT; i++) {
+        alloc_stats_t stats;
+        alloc_subsystem_stats((alloc_subsystem_t)i, &stats);
+        fprintf(out, "  %-10s %12zu %12zu %12zu %10u %10u\n",
+                g_subsystem_names[i], stats.live_bytes, stats.peak_bytes,
+                stats.total_allocated, stats.allocation_count, stats.live_count);
+
+        sum.live_bytes += stats.live_bytes;
+        sum.total_allocated += stats.total_allocated;
+        sum.allocation_count += stats.allocation_count;
+        sum.live_count += stats.live_count;
+    }
+
+    fprintf(out, "  %-10s %12zu %12s %12zu %10u %10u\n",
+            "total", sum.live_bytes, "-", sum.total_allocated,
+            sum.allocation_count, sum.live_count);
+}
+
+// Prometheus text exposition; returns the length written (truncated to size)
+size_t alloc_subsystem_metrics(char* buffer, size_t size) {
+    if (!buffer || size == 0) return 0;
+
+    static const struct {
+        const char* name;
+        const char* type;
+        const char* help;
+    } metrics[] = {
+        { "cclaw_alloc_live_bytes", "gauge", "Bytes currently allocated" },
+        { "cclaw_alloc_peak_bytes", "gauge", "Peak bytes allocated" },
+        { "cclaw_alloc_bytes_total", "counter", "Bytes allocated since start" },
+        { "cclaw_alloc_count_total", "counter", "Allocations since start" },
+        { "cclaw_alloc_live_count", "gauge", "Allocations currently live" },
+    };
+
+    alloc_stats_t stats[ALLOC_SUBSYS_COUNT];
+    for (int i = 0; i < ALLOC_SUBSYS_COUNT; i++) {
+        alloc_subsystem_stats((alloc_subsystem_t)i, &stats[i]);
+    }
+
+    size_t pos = 0;
+    buffer[0] = '\0';
+
+    for (size_t m = 0; m < sizeof(metrics) / sizeof(metrics[0]); m++) {
+        int n = snprintf(buffer + pos, size - pos, "# HELP %s %s\n# TYPE %s %s\n",
+                         metrics[m].name, metrics[m].help, metrics[m].name, metrics[m].type);
+        if (n < 0 || (size_t)n >= size - pos) return size - 1;
+        pos += (size_t)n;
+
+        for (int i = 0; i < ALLOC_SUBSYS_COUNT; i++) {
+            uint64_t value = 0;
+            switch (m) {
+                case 0: value = stats[i].live_bytes; break;
+                case 1: value = stats[i].peak_bytes; break;
+                case 2: value = stats[i].total_allocated; break;
+                case 3: value = stats[i].allocation_count; break;
+                default: value = stats[i].live_count; break;
+            }
+
+            n = snprintf(buffer + pos, size - pos, "%s{subsystem=\"%s\"} %llu\n",
+                         metrics[m].name, g_subsystem_names[i], (unsigned long long)value);
+            if (n < 0 || (size_t)n >= size - pos) return size - 1;
+            pos += (size_t)n;
+        }
+    }
+
+    return pos;
+}
+
+void alloc_sampler_init(alloc_sampler_t* sampler, uint64_t interval_ms, uint64_t now_ms) {
+    if (!sampler) return;
+
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->interval_ms = interval_ms;
+    sampler->last_sample_ms = now_ms;
+
+    for (int i = 0; i < ALLOC_SUBSYS_COUNT; i++) {
+        alloc_stats_t stats;
+        alloc_subsystem_stats((alloc_subsystem_t)i, &stats);
+        sampler->last_live[i] = stats.live_bytes;
+    }
+}
+
+bool alloc_sampler_tick(alloc_sampler_t* sampler, uint64_t now_ms, FILE* log) {
+    if (!sampler || sampler->interval_ms == 0) return false;
+    if (now_ms - sampler->last_sample_ms < sampler->interval_ms) return false;
+
+    uint64_t elapsed_ms = now_ms - sampler->last_sample_ms;
+    sampler->last_sample_ms = now_ms;
+
+    for (int i = 0; i < ALLOC_SUBSYS_COUNT; i++) {
+        alloc_stats_t stats;
+        alloc_subsystem_stats((alloc_subsystem_t)i, &stats);
+
+        if (log && stats.live_bytes > sampler->last_live[i]) {
+            fprintf(log, "[alloc] %s grew by %zu bytes in %llums (live %zu, peak %zu)\n",
+                    g_subsystem_names[i], stats.live_bytes - sampler->last_live[i],
+                    (unsigned long long)elapsed_ms, stats.live_bytes, stats.peak_bytes);
+        }
+        sampler->last_live[i] = stats.live_bytes;
+    }
+
+    if (log) fflush(log);
+    return true;
+}
+
+// ============================================================================
+// Allocation functions
+// ============================================================================
+
+void* alloc(allocator_t* a, size_t size) {
+    if (!a) a = allocator_default();
+    return a->vtable->alloc(a, size, alignof(max_align_t));
+}
+
+void* alloc_aligned(allocator_t* a, size_t size, size_t alignment) {
+    if (!a) a = allocator_default();
+    return a->vtable->alloc(a, size, alignment);
+}
+
+void* alloc_zeroed(allocator_t* a, size_t size) {
+    void* ptr = alloc(a, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+void* realloc_ptr(allocator_t* a, void* ptr, size_t old_size, size_t new_size) {
+    if (!a) a = allocator_default();
+    return a->vtable->realloc(a, ptr, old_size, new_size, alignof(max_align_t));
+}
+
+void* realloc_aligned_ptr(allocator_t* a, void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    if (!a) a = allocator_default();
+    return a->vtable->realloc(a, ptr, old_size, new_size, alignment);
+}
+
+void free_ptr(allocator_t* a, void* ptr, size_t size) {
+    if (!ptr) return;
+    if (!a) a = allocator_default();
+    a->vtable->free(a, ptr, size);
+}
+
+str_t alloc_str(allocator_t* a, str_t src) {
+    if (str_empty(src)) return STR_NULL;
+
+    char* data = alloc(a, src.len + 1);
+    if (!data) return STR_NULL;
+
+    memcpy(data, src.data, src.len);
+    data[src.len] = '\0';
+    return (str_t){ .data = data, .len = src.len };
+}
+
+str_t alloc_str_cstr(allocator_t* a, const char* src) {
+    if (!src) return STR_NULL;
+    return alloc_str(a, (str_t){ .data = src, .len = (uint32_t)strlen(src) });
+}
+
+void free_str(allocator_t* a, str_t str) {
+    if (str.data) free_ptr(a, (void*)str.data, str.len + 1);
+}
+
+// Array memory is zero-initialized, like calloc()
+void* alloc_array(allocator_t* a, size_t element_size, size_t count) {
+    if (count && element_size > SIZE_MAX / count) return NULL;
+    return alloc_zeroed(a, element_size * count);
+}
+
+void* realloc_array(allocator_t* a, void* ptr, size_t element_size, size_t old_count, size_t new_count) {
+    if (new_count && element_size > SIZE_MAX / new_count) return NULL;
+
+    char* data = realloc_ptr(a, ptr, element_size * old_count, element_size * new_count);
+    if (data && new_count > old_count) {
+        memset(data + element_size * old_count, 0, element_size * (new_count - old_count));
+    }
+    return data;
+}
+
+// ============================================================================
+// Memory utilities
+// ============================================================================
+
+void zero_memory(void* ptr, size_t size) {
+    if (ptr) memset(ptr, 0, size);
+}
+
+void copy_memory(void* dst, const void* src, size_t size) {
+    memcpy(dst, src, size);
+}
+
+void move_memory(void* dst, const void* src, size_t size) {
+    memmove(dst, src, size);
+}
+
+bool compare_memory(const void* a, const void* b, size_t size) {
+    return memcmp(a, b, size) == 0;
+}
@@ -3,6 +3,7 @@
 
 #include "core/config.h"
 #include "core/error.h"
+#include "core/alloc.h"
 #include "json_config.h"
 
 #include <stdlib.h>
@@ -20,39 +21,15 @@
 #define DEFAULT_HOST "127.0.0.1"
 #define DEFAULT_MEMORY_BACKEND "sqlite"
 
-typedef struct allocator_t {
-    void* (*alloc)(size_t size);
-    void (*free)(void* ptr);
-    void* (*realloc)(void* ptr, size_t size);
-} allocator_t;
-
-// Global default allocator using stdlib
-static void* default_alloc(size_t size) {
-    return malloc(size);
-}
-
-static void default_free(void* ptr) {
-    free(ptr);
-}
-
-static void* default_realloc(void* ptr, size_t size) {
-    return realloc(ptr, size);
-}
-
-static allocator_t g_default_allocator = {
-    .alloc = default_alloc,
-    .free = default_free,
-    .realloc = default_realloc
-};
-
-allocator_t* allocator_default(void) {
-    return &g_default_allocator;
+// alloc() itself is shadowed by the allocator parameters below
+static void* config_mem_alloc(allocator_t* a, size_t size) {
+    return alloc(a, size);
 }
 
 static str_t str_dup_impl(str_t s, allocator_t* alloc) {
     if (str_empty(s)) return STR_NULL;
 
-    char* data = alloc->alloc(s.len + 1);
+    char* data = config_mem_alloc(alloc, s.len + 1);
     if (!data) return STR_NULL;
 
     memcpy(data, s.data, s.len);
@@ -63,7 +40,7 @@ static str_t str_dup_impl(str_t s, allocator_t* alloc) {
 
 static void str_free_impl(str_t s, allocator_t* alloc) {
     if (s.data) {
-        alloc->free((void*)s.data);
+        free_ptr(alloc, (void*)s.data, 0);
     }
 }
 
@@ -71,7 +48,7 @@ static void str_free_impl(str_t s, allocator_t* alloc) {
 config_t* config_create(allocator_t* alloc) {
     if (!alloc) alloc = allocator_default();
 
-    config_t* config = alloc->alloc(sizeof(config_t));
+    config_t* config = config_mem_alloc(alloc, sizeof(config_t));
     if (!config) return NULL;
 
     memset(config, 0, sizeof(config_t));
@@ -93,6 +70,7 @@ void config_destroy(config_t* config) {
     str_free_impl(config->api_key, alloc);
     str_free_impl(config->default_provider, alloc);
     str_free_impl(config->default_model, alloc);
+    str_free_impl(config->api_url, alloc);
 
     // Free memory configuration strings
     str_free_impl(config->memory.backend, alloc);
@@ -105,7 +83,7 @@ void config_destroy(config_t* config) {
         for (uint32_t i = 0; i < config->gateway.paired_tokens_count; i++) {
             str_free_impl(config->gateway.paired_tokens[i], alloc);
         }
-        alloc->free(config->gateway.paired_tokens);
+        free_ptr(alloc, config->gateway.paired_tokens, 0);
     }
 
     // Free autonomy configuration arrays
@@ -113,13 +91,13 @@ void config_destroy(config_t* config) {
         for (uint32_t i = 0; i < config->autonomy.allowed_commands_count; i++) {
             str_free_impl(config->autonomy.allowed_commands[i], alloc);
         }
-        alloc->free(config->autonomy.allowed_commands);
+        free_ptr(alloc, config->autonomy.allowed_commands, 0);
     }
     if (config->autonomy.forbidden_paths) {
         for (uint32_t i = 0; i < config->autonomy.forbidden_paths_count; i++) {
             str_free_impl(config->autonomy.forbidden_paths[i], alloc);
         }
-        alloc->free(config->autonomy.forbidden_paths);
+        free_ptr(alloc, config->autonomy.forbidden_paths, 0);
     }
 
     // Free runtime configuration
@@ -129,11 +107,42 @@ void config_destroy(config_t* config) {
         for (uint32_t i = 0; i < config->runtime.docker.allowed_workspace_roots_count; i++) {
             str_free_impl(config->runtime.docker.allowed_workspace_roots[i], alloc);
         }
-        alloc->free(config->runtime.docker.allowed_workspace_roots);
+        free_ptr(alloc, config->runtime.docker.allowed_workspace_roots, 0);
+    }
+    str_free_impl(config->runtime.sandbox.cgroup_dir, alloc);
+
+    // Free observability configuration
+    str_free_impl(config->observability.backend, alloc);
+    str_free_impl(config->observability.otel_endpoint, alloc);
+    str_free_impl(config->observability.otel_service_name, alloc);
+    str_free_impl(config->observability.trace_file, alloc);
+    str_free_impl(config->observability.trace_format, alloc);
+
+    // Free channel configuration
+    if (config->channels.webhook) {
+        str_free_impl(config->channels.webhook->secret, alloc);
+        free_ptr(alloc, config->channels.webhook, 0);
+    }
+
+    // Free MCP server configuration
+    if (config->mcp_servers) {
+        for (uint32_t i = 0; i < config->mcp_servers_count; i++) {
+            str_free_impl(config->mcp_servers[i].name, alloc);
+            str_free_impl(config->mcp_servers[i].command, alloc);
+            for (uint32_t j = 0; j < config->mcp_servers[i].args_count; j++) {
+                str_free_impl(config->mcp_servers[i].args[j], alloc);
+            }
+            free_ptr(alloc, config->mcp_servers[i].args, 0);
+            for (uint32_t j = 0; j < config->mcp_servers[i].env_count; j++) {
+                str_free_impl(config->mcp_servers[i].env[j], alloc);
+            }
+            free_ptr(alloc, config->mcp_servers[i].env, 0);
+        }
+        free_ptr(alloc, config->mcp_servers, 0);
     }
 
     // Free the config itself
-    alloc->free(config);
+    free_ptr(alloc, config, 0);
 }
 
 // Create a default configuration
@@ -186,7 +195,7 @@ config_t* config_default(allocator_t* alloc) {
         "echo", "pwd", "wc", "head", "tail"
     };
     config->autonomy.allowed_commands_count = sizeof(default_commands) / sizeof(default_commands[0]);
-    config->autonomy.allowed_commands = alloc->alloc(sizeof(str_t) * config->autonomy.allowed_commands_count);
+    config->autonomy.allowed_commands = config_mem_alloc(alloc, sizeof(str_t) * config->autonomy.allowed_commands_count);
     for (uint32_t i = 0; i < config->autonomy.allowed_commands_count; i++) {
         config->autonomy.allowed_commands[i] = str_dup_impl(STR_VIEW(default_commands[i]), alloc);
     }
@@ -198,7 +207,7 @@ config_t* config_default(allocator_t* alloc) {
         "/var", "/tmp", "~/.ssh", "~/.gnupg", "~/.aws", "~/.config"
     };
     config->autonomy.forbidden_paths_count = sizeof(default_forbidden) / sizeof(default_forbidden[0]);
-    config->autonomy.forbidden_paths = alloc->alloc(sizeof(str_t) * config->autonomy.forbidden_paths_count);
+    config->autonomy.forbidden_paths = config_mem_alloc(alloc, sizeof(str_t) * config->autonomy.forbidden_paths_count);
     for (uint32_t i = 0; i < config->autonomy.forbidden_paths_count; i++) {
         config->autonomy.forbidden_paths[i] = str_dup_impl(STR_VIEW(default_forbidden[i]), alloc);
     }
@@ -245,6 +254,7 @@ config_t* config_default(allocator_t* alloc) {
 
     // Observability configuration
     config->observability.backend = str_dup_impl(STR_LIT("none"), alloc);
+    config->observability.trace_format = str_dup_impl(STR_LIT("chrome"), alloc);
 
     return config;
 }
@@ -259,7 +269,7 @@ static str_t* load_string_array(json_array_t* arr, uint32_t* count, allocator_t*
         return NULL;
     }
 
-    str_t* strings = alloc->alloc(sizeof(str_t) * len);
+    str_t* strings = config_mem_alloc(alloc, sizeof(str_t) * len);
     if (!strings) return NULL;
 
     for (size_t i = 0; i < len; i++) {
@@ -393,6 +403,13 @@ err_t config_from_json_str(json_value_t* json, allocator_t* alloc, config_t** ou
         config->default_model = str_dup_impl(STR_VIEW(model), alloc);
     }
 
+    const char* api_url = json_object_get_string(root, "api_url", NULL);
+    if (api_url) {
+        config->api_url = str_dup_impl(STR_VIEW(api_url), alloc);
+    }
+    config->response_chaining = json_object_get_bool(root, "response_chaining", false);
+    config->differential_history = json_object_get_bool(root, "differential_history", false);
+
     config->default_temperature = json_object_get_number(root, "default_temperature", DEFAULT_TEMPERATURE);
 
     // Workspace directory
@@ -438,6 +455,126 @@ err_t config_from_json_str(json_value_t* json, allocator_t* alloc, config_t** ou
         config->autonomy.max_actions_per_hour = (uint32_t)json_object_get_number(autonomy, "max_actions_per_hour", 20);
     }
 
+    // Runtime configuration
+    json_object_t* runtime = json_object_get_object(root, "runtime");
+    if (runtime) {
+        config->runtime.kind = (runtime_kind_t)json_object_get_number(runtime, "kind", RUNTIME_KIND_NATIVE);
+
+        json_object_t* docker = json_object_get_object(runtime, "docker");
+        if (docker) {
+            const char* network = json_object_get_string(docker, "network", NULL);
+            if (network) {
+                str_free_impl(config->runtime.docker.network, alloc);
+                config->runtime.docker.network = str_dup_impl(STR_VIEW(network), alloc);
+            }
+            config->runtime.docker.memory_limit_mb = (uint64_t)json_object_get_number(docker, "memory_limit_mb", 512);
+            config->runtime.docker.cpu_limit = json_object_get_number(docker, "cpu_limit", 1.0);
+            config->runtime.docker.read_only_rootfs = json_object_get_bool(docker, "read_only_rootfs", true);
+            json_array_t* roots = json_object_get_array(docker, "allowed_workspace_roots");
+            if (roots) {
+                config->runtime.docker.allowed_workspace_roots = load_string_array(
+                    roots, &config->runtime.docker.allowed_workspace_roots_count, alloc);
+            }
+        }
+
+        json_object_t* sandbox = json_object_get_object(runtime, "sandbox");
+        if (sandbox) {
+            const char* cgroup_dir = json_object_get_string(sandbox, "cgroup_dir", NULL);
+            if (cgroup_dir) config->runtime.sandbox.cgroup_dir = str_dup_impl(STR_VIEW(cgroup_dir), alloc);
+            config->runtime.sandbox.max_processes = (uint32_t)json_object_get_number(sandbox, "max_processes", 0);
+        }
+    }
+
+    // Observability configuration
+    json_object_t* observability = json_object_get_object(root, "observability");
+    if (observability) {
+        const char* trace_file = json_object_get_string(observability, "trace_file", NULL);
+        if (trace_file) {
+            str_free_impl(config->observability.trace_file, alloc);
+            config->observability.trace_file = str_dup_impl(STR_VIEW(trace_file), alloc);
+        }
+        const char* trace_format = json_object_get_string(observability, "trace_format", NULL);
+        if (trace_format) {
+            str_free_impl(config->observability.trace_format, alloc);
+            config->observability.trace_format = str_dup_impl(STR_VIEW(trace_format), alloc);
+        }
+    }
+
+    // Channel configuration
+    json_object_t* channels = json_object_get_object(root, "channels");
+    json_object_t* webhook = channels ? json_object_get_object(channels, "webhook") : NULL;
+    if (webhook) {
+        config->channels.webhook = config_mem_alloc(alloc, sizeof(*config->channels.webhook));
+        if (!config->channels.webhook) {
+            config_destroy(config);
+            return ERR_OUT_OF_MEMORY;
+        }
+        memset(config->channels.webhook, 0, sizeof(*config->channels.webhook));
+        config->channels.webhook->port = (uint16_t)json_object_get_number(webhook, "port", DEFAULT_PORT);
+        const char* secret = json_object_get_string(webhook, "secret", NULL);
+        if (secret) config->channels.webhook->secret = str_dup_impl(STR_VIEW(secret), alloc);
+        config->channels.webhook->stream_events = json_object_get_bool(webhook, "stream_events", false);
+    }
+
+    // MCP servers, keyed by name:
+    // "mcp_servers": { "fs": { "command": "...", "args": [...], "env": { "K": "v" } } }
+    json_object_t* mcp_servers = json_object_get_object(root, "mcp_servers");
+    if (mcp_servers) {
+        uint32_t count = 0;
+        for (json_entry_t* e = mcp_servers->entries; e; e = e->next) count++;
+
+        if (count > 0) {
+            config->mcp_servers = config_mem_alloc(alloc, sizeof(*config->mcp_servers) * count);
+            if (!config->mcp_servers) {
+                config_destroy(config);
+                return ERR_OUT_OF_MEMORY;
+            }
+            memset(config->mcp_servers, 0, sizeof(*config->mcp_servers) * count);
+        }
+
+        for (json_entry_t* e = mcp_servers->entries; e; e = e->next) {
+            json_object_t* server = json_as_object(&e->value);
+            const char* command = server ? json_object_get_string(server, "command", NULL) : NULL;
+            if (!command) continue;
+
+            uint32_t n = config->mcp_servers_count++;
+            config->mcp_servers[n].name = str_dup_impl(STR_VIEW(e->key), alloc);
+            config->mcp_servers[n].command = str_dup_impl(STR_VIEW(command), alloc);
+            config->mcp_servers[n].timeout_ms = (uint32_t)json_object_get_number(server, "timeout_ms", 0);
+
+            json_array_t* args = json_object_get_array(server, "args");
+            size_t args_count = json_array_length(args);
+            if (args_count > 0) {
+                config->mcp_servers[n].args = config_mem_alloc(alloc, sizeof(str_t) * args_count);
+                for (size_t i = 0; config->mcp_servers[n].args && i < args_count; i++) {
+                    const char* arg = json_as_string(json_array_get(args, i), NULL);
+                    if (arg) {
+                        config->mcp_servers[n].args[config->mcp_servers[n].args_count++] =
+                            str_dup_impl(STR_VIEW(arg), alloc);
+                    }
+                }
+            }
+
+            json_object_t* env = json_object_get_object(server, "env");
+            uint32_t env_count = 0;
+            for (json_entry_t* v = env ? env->entries : NULL; v; v = v->next) env_count++;
+            if (env_count > 0) {
+                config->mcp_servers[n].env = config_mem_alloc(alloc, sizeof(str_t) * env_count);
+                for (json_entry_t* v = env->entries; config->mcp_servers[n].env && v; v = v->next) {
+                    const char* value = json_as_string(&v->value, NULL);
+                    if (!value) continue;
+                    // Sized to fit: env often carries long tokens
+                    str_t pair = str_format(alloc, "%s=%s", v->key, value);
+                    if (!pair.data) {
+                        config_destroy(config);
+                        return ERR_OUT_OF_MEMORY;
+                    }
+                    config->mcp_servers[n].env[config->mcp_servers[n].env_count++] = pair;
+                }
+            }
+        }
+    }
+
     *out_config = config;
     return ERR_OK;
 }
@@ -501,6 +638,15 @@ err_t config_save(config_t* config, str_t path) {
     }
     json_object_set_string(json, "default_provider", str_empty(config->default_provider) ? DEFAULT_PROVIDER : config->default_provider.data);
     json_object_set_string(json, "default_model", str_empty(config->default_model) ? DEFAULT_MODEL : config->default_model.data);
+    if (!str_empty(config->api_url)) {
+        json_object_set_string(json, "api_url", config->api_url.data);
+    }
+    if (config->response_chaining) {
+        json_object_set_bool(json, "response_chaining", true);
+    }
+    if (config->differential_history) {
+        json_object_set_bool(json, "differential_history", true);
+    }
     json_object_set_number(json, "default_temperature", config->default_temperature);
 
     // Memory configuration
@@ -555,6 +701,12 @@ err_t config_save(config_t* config, str_t path) {
     json_object_set_bool(docker, "read_only_rootfs", config->runtime.docker.read_only_rootfs);
     json_object_set_bool(docker, "mount_workspace", config->runtime.docker.mount_workspace);
     json_object_set(runtime, "docker", docker);
+    json_value_t* sandbox = json_create_object();
+    if (!str_empty(config->runtime.sandbox.cgroup_dir)) {
+        json_object_set_string(sandbox, "cgroup_dir", config->runtime.sandbox.cgroup_dir.data);
+    }
+    json_object_set_number(sandbox, "max_processes", config->runtime.sandbox.max_processes);
+    json_object_set(runtime, "sandbox", sandbox);
     json_object_set(json, "runtime", runtime);
 
     // Reliability configuration
@@ -571,6 +723,53 @@ err_t config_save(config_t* config, str_t path) {
     json_object_set_number(heartbeat, "interval_minutes", config->heartbeat.interval_minutes);
     json_object_set(json, "heartbeat", heartbeat);
 
+    // Channel configuration
+    if (config->channels.webhook) {
+        json_value_t* channels = json_create_object();
+        json_value_t* webhook = json_create_object();
+        json_object_set_number(webhook, "port", config->channels.webhook->port);
+        if (!str_empty(config->channels.webhook->secret)) {
+            json_object_set_string(webhook, "secret", config->channels.webhook->secret.data);
+        }
+        json_object_set_bool(webhook, "stream_events", config->channels.webhook->stream_events);
+        json_object_set(channels, "webhook", webhook);
+        json_object_set(json, "channels", channels);
+    }
+
+    // MCP servers
+    if (config->mcp_servers_count > 0) {
+        json_value_t* mcp_servers = json_create_object();
+        for (uint32_t i = 0; i < config->mcp_servers_count; i++) {
+            json_value_t* server = json_create_object();
+            json_object_set_string(server, "command", config->mcp_servers[i].command.data);
+
+            json_value_t* args = json_create_array();
+            for (uint32_t j = 0; j < config->mcp_servers[i].args_count; j++) {
+                json_array_append(args, json_create_string(config->mcp_servers[i].args[j].data));
+            }
+            json_object_set(server, "args", args);
+
+            json_value_t* env = json_create_object();
+            for (uint32_t j = 0; j < config->mcp_servers[i].env_count; j++) {
+                // Split in place; only the key needs a copy of its own
+                str_t pair = config->mcp_servers[i].env[j];
+                const char* eq = pair.data ? memchr(pair.data, '=', pair.len) : NULL;
+                if (!eq) continue;
+                char* key = strndup(pair.data, (size_t)(eq - pair.data));
+                if (!key) continue;
+                json_object_set_string(env, key, eq + 1);
+                free(key);
+            }
+            json_object_set(server, "env", env);
+
+            if (config->mcp_servers[i].timeout_ms > 0) {
+                json_object_set_number(server, "timeout_ms", config->mcp_servers[i].timeout_ms);
+            }
+            json_object_set(mcp_servers, config->mcp_servers[i].name.data, server);
+        }
+        json_object_set(json, "mcp_servers", mcp_servers);
+    }
+
     // Print to string
     char* json_str = json_print(json, true);
     json_free(json);
@@ -583,13 +782,13 @@ err_t config_save(config_t* config, str_t path) {
 
     FILE* file = fopen(temp_path, "w");
     if (!file) {
-        free(json_str);
+        json_free_string(json_str);
         return ERR_IO;
     }
 
     fprintf(file, "%s\n", json_str);
     fclose(file);
-    free(json_str);
+    json_free_string(json_str);
 
     // Atomic rename
     if (rename(temp_path, config_path) != 0) {
@@ -653,6 +852,25 @@ void config_apply_env_overrides(config_t* config) {
         config->default_model = str_dup_impl(STR_VIEW(model), alloc);
     }
 
+    // ZEROCLAW_API_URL
+    const char* api_url = getenv("ZEROCLAW_API_URL");
+    if (api_url && *api_url) {
+        str_free_impl(config->api_url, alloc);
+        config->api_url = str_dup_impl(STR_VIEW(api_url), alloc);
+    }
+
+    // ZEROCLAW_TRACE_FILE / ZEROCLAW_TRACE_FORMAT
+    const char* trace_file = getenv("ZEROCLAW_TRACE_FILE");
+    if (trace_file && *trace_file) {
+        str_free_impl(config->observability.trace_file, alloc);
+        config->observability.trace_file = str_dup_impl(STR_VIEW(trace_file), alloc);
+    }
+    const char* trace_format = getenv("ZEROCLAW_TRACE_FORMAT");
+    if (trace_format && *trace_format) {
+        str_free_impl(config->observability.trace_format, alloc);
+        config->observability.trace_format = str_dup_impl(STR_VIEW(trace_format), alloc);
+    }
+
     // ZEROCLAW_WORKSPACE
     const char* workspace = getenv("ZEROCLAW_WORKSPACE");
     if (workspace && *workspace) {
@@ -3,6 +3,9 @@
 
 #include "core/error.h"
 
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -81,60 +84,489 @@ const char* error_to_string(err_t code) {
     return "Unknown error";
 }
 
+// ============================================================================
+// Thread-local error ring
+// ============================================================================
+
+// Nothing here runs on the success path. Recording an error copies the
+// code, location and message arguments into the calling thread's ring; the
+// printf-style message is only built when someone reads it.
+
+static _Thread_local error_stack_t t_error_stack;
+
+static bool record_in_ring(const error_stack_t* stack, const error_ctx_t* ctx) {
+    const char* p = (const char*)ctx;
+    const char* begin = (const char*)stack->records;
+    const char* end = (const char*)(stack->records + ERROR_RING_CAPACITY);
+    return p >= begin && p < end &&
+           (size_t)(p - begin) % sizeof(error_record_t) == 0;
+}
+
+static error_record_t* ring_top(error_stack_t* stack) {
+    if (stack->count == 0) return NULL;
+    uint32_t slot = (stack->head + ERROR_RING_CAPACITY - 1) % ERROR_RING_CAPACITY;
+    return &stack->records[slot];
+}
+
+// Claim the next slot, overwriting the oldest record once the ring is full
+static error_record_t* record_begin(err_t code, const char* file, uint32_t line) {
+    error_stack_t* stack = &t_error_stack;
+    error_record_t* rec = &stack->records[stack->head];
+
+    if (stack->count == ERROR_RING_CAPACITY) {
+        for (uint32_t i = 0; i < ERROR_RING_CAPACITY; i++) {
+            if (stack->records[i].ctx.cause == &rec->ctx) {
+                stack->records[i].ctx.cause = NULL;
+            }
+        }
+    } else {
+        stack->count++;
+    }
+    stack->head = (stack->head + 1) % ERROR_RING_CAPACITY;
+
+    rec->ctx.code = code;
+    rec->ctx.message = STR_NULL;
+    rec->ctx.file = file ? STR_VIEW(file) : STR_NULL;
+    rec->ctx.line = line;
+    rec->ctx.cause = NULL;
+    rec->fmt = NULL;
+    rec->arg_count = 0;
+    rec->strings_used = 0;
+    rec->text[0] = '\0';
+    return rec;
+}
+
+// Messages handed in as str_t may live in caller buffers, so keep a copy
+static void record_copy_message(error_record_t* rec, str_t message) {
+    size_t len = message.len < ERROR_MESSAGE_MAX - 1 ? message.len : ERROR_MESSAGE_MAX - 1;
+    if (len > 0) memcpy(rec->text, message.data, len);
+    rec->text[len] = '\0';
+    rec->ctx.message = (str_t){ .data = rec->text, .len = (uint32_t)len };
+}
+
+// Causes from outside the ring (ERR() values on a caller's stack) are
+// copied in so the chain never points at memory the ring does not own
+static error_ctx_t* record_adopt(error_ctx_t* cause) {
+    if (!cause) return NULL;
+    if (record_in_ring(&t_error_stack, cause)) return cause;
+
+    error_record_t* rec = record_begin(cause->code, NULL, cause->line);
+    rec->ctx.file = cause->file;
+    record_copy_message(rec, cause->message);
+    return &rec->ctx;
+}
+
+// ----------------------------------------------------------------------------
+// Lazy formatting
+// ----------------------------------------------------------------------------
+
+typedef enum {
+    ARG_INT,        // int-sized (%c, '*' width/precision)
+    ARG_LLONG,      // any integer conversion, widened
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_POINTER,    // %p
+    ARG_STRING,     // %s, points into rec->strings
+} arg_kind_t;
+
+typedef struct {
+    const char* start;      // '%'
+    const char* end;        // one past the conversion character
+    int stars;              // '*' width/precision count
+    bool has_precision;
+    bool star_precision;
+    int precision;          // when given as digits
+    char length[3];
+    char conv;
+} fmt_spec_t;
+
+// Parse one conversion at fmt (which points at '%'). Returns false for
+// anything the lazy path does not handle.
+static bool parse_spec(const char* fmt, fmt_spec_t* spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->start = fmt;
+    const char* p = fmt + 1;
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == '.') {
+        spec->has_precision = true;
+        p++;
+        if (*p == '*') {
+            spec->stars++;
+            spec->star_precision = true;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                spec->precision = spec->precision * 10 + (*p - '0');
+                p++;
+            }
+        }
+    }
+
+    size_t n = 0;
+    while (*p && strchr("hljztLq", *p) && n < 2) {
+        spec->length[n++] = *p++;
+    }
+    spec->length[n] = '\0';
+
+    if (!*p || !strchr("diouxXcspfFeEgGaA%", *p)) return false;
+    // Wide characters and strings (%lc, %ls) are formatted eagerly
+    if ((*p == 'c' || *p == 's') && n > 0) return false;
+    spec->conv = *p;
+    spec->end = p + 1;
+    return true;
+}
+
+static error_arg_t* capture_slot(error_record_t* rec) {
+    if (rec->arg_count >= ERROR_MAX_ARGS) return NULL;
+    return &rec->args[rec->arg_count++];
+}
+
+static const char* capture_string(error_record_t* rec, const char* s, int precision) {
+    if (!s) s = "(null)";
+
+    size_t len = precision >= 0 ? strnlen(s, (size_t)precision) : strlen(s);
+    size_t room = ERROR_ARG_BYTES - rec->strings_used;
+    if (room == 0) return "";
+    if (len > room - 1) len = room - 1;
+
+    char* copy = rec->strings + rec->strings_used;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    rec->strings_used = (uint16_t)(rec->strings_used + len + 1);
+    return copy;
+}
+
+static bool is_integer_conv(char conv) {
+    return conv && strchr("diouxX", conv) != NULL;
+}
+
+static bool is_unsigned_conv(char conv) {
+    return conv && strchr("ouxX", conv) != NULL;
+}
+
+// Pull one integer of the spec's length out of the va_list
+static long long va_integer(va_list* ap, const fmt_spec_t* spec) {
+    const char* l = spec->length;
+    bool is_unsigned = is_unsigned_conv(spec->conv);
+
+    if (strcmp(l, "ll") == 0 || strcmp(l, "q") == 0) {
+        return is_unsigned ? (long long)va_arg(*ap, unsigned long long) : va_arg(*ap, long long);
+    }
+    if (strcmp(l, "l") == 0) {
+        return is_unsigned ? (long long)va_arg(*ap, unsigned long) : va_arg(*ap, long);
+    }
+    if (strcmp(l, "z") == 0) return (long long)va_arg(*ap, size_t);
+    if (strcmp(l, "j") == 0) {
+        return is_unsigned ? (long long)va_arg(*ap, uintmax_t) : (long long)va_arg(*ap, intmax_t);
+    }
+    if (strcmp(l, "t") == 0) return (long long)va_arg(*ap, ptrdiff_t);
+
+    // int and narrower are promoted to int
+    int v = va_arg(*ap, int);
+    if (strcmp(l, "hh") == 0) return is_unsigned ? (long long)(unsigned char)v : (long long)(signed char)v;
+    if (strcmp(l, "h") == 0) return is_unsigned ? (long long)(unsigned short)v : (long long)(short)v;
+    return is_unsigned ? (long long)(unsigned int)v : (long long)v;
+}
+
+// Copy the arguments fmt refers to into rec. Returns false when the format
+// needs more slots than the record has, or uses something unsupported.
+static bool capture_args(error_record_t* rec, const char* fmt, va_list* ap) {
+    for (const char* p = fmt; *p; p++) {
+        if (*p != '%') continue;
+
+        fmt_spec_t spec;
+        if (!parse_spec(p, &spec)) return false;
+        p = spec.end - 1;
+        if (spec.conv == '%') continue;
+
+        int star_values[2] = { 0, 0 };
+        for (int i = 0; i < spec.stars; i++) {
+            error_arg_t* star = capture_slot(rec);
+            if (!star) return false;
+            star_values[i] = va_arg(*ap, int);
+            star->i = star_values[i];
+        }
+
+        error_arg_t* arg = capture_slot(rec);
+        if (!arg) return false;
+
+        if (is_integer_conv(spec.conv)) {
+            arg->i = va_integer(ap, &spec);
+        } else if (spec.conv == 'c') {
+            arg->i = va_arg(*ap, int);
+        } else if (spec.conv == 's') {
+            int precision = -1;
+            if (spec.star_precision) {
+                precision = star_values[spec.stars - 1];
+            } else if (spec.has_precision) {
+                precision = spec.precision;
+            }
+            arg->p = capture_string(rec, va_arg(*ap, const char*), precision);
+        } else if (spec.conv == 'p') {
+            arg->p = va_arg(*ap, const void*);
+        } else if (strcmp(spec.length, "L") == 0) {
+            arg->ld = va_arg(*ap, long double);
+        } else {
+            arg->d = va_arg(*ap, double);
+        }
+    }
+    return true;
+}
+
+// Format one conversion with its captured arguments. Integers were widened
+// at capture time, so their length modifier is rewritten to "ll".
+static int render_spec(char* out, size_t size, const fmt_spec_t* spec, const error_arg_t* args) {
+    char conv_fmt[48];
+    size_t body_len = (size_t)(spec->end - spec->start) - 1 - strlen(spec->length);
+    if (body_len + 4 > sizeof(conv_fmt)) return 0;
+
+    // Everything up to the length modifier: '%', flags, width, precision
+    memcpy(conv_fmt, spec->start, body_len);
+    size_t n = body_len;
+
+    arg_kind_t kind;
+    if (is_integer_conv(spec->conv)) {
+        conv_fmt[n++] = 'l';
+        conv_fmt[n++] = 'l';
+        kind = ARG_LLONG;
+    } else if (spec->conv == 'c') {
+        kind = ARG_INT;
+    } else if (spec->conv == 's') {
+        kind = ARG_STRING;
+    } else if (spec->conv == 'p') {
+        kind = ARG_POINTER;
+    } else if (strcmp(spec->length, "L") == 0) {
+        conv_fmt[n++] = 'L';
+        kind = ARG_LDOUBLE;
+    } else {
+        kind = ARG_DOUBLE;
+    }
+    conv_fmt[n++] = spec->conv;
+    conv_fmt[n] = '\0';
+
+    const error_arg_t* v = args + spec->stars;
+    int w0 = spec->stars > 0 ? (int)args[0].i : 0;
+    int w1 = spec->stars > 1 ? (int)args[1].i : 0;
+
+#define RENDER(value) \
+    (spec->stars == 0 ? snprintf(out, size, conv_fmt, value) : \
+     spec->stars == 1 ? snprintf(out, size, conv_fmt, w0, value) : \
+                        snprintf(out, size, conv_fmt, w0, w1, value))
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    int written;
+    switch (kind) {
+        case ARG_INT:     written = RENDER((int)v->i); break;
+        case ARG_LLONG:   written = RENDER(v->i); break;
+        case ARG_DOUBLE:  written = RENDER(v->d); break;
+        case ARG_LDOUBLE: written = RENDER(v->ld); break;
+        case ARG_POINTER: written = RENDER(v->p); break;
+        case ARG_STRING:  written = RENDER((const char*)v->p); break;
+        default:          written = 0; break;
+    }
+#pragma GCC diagnostic pop
+#undef RENDER
+
+    return written < 0 ? 0 : written;
+}
+
+// Build the deferred message into rec->text (truncating) and drop the format
+static void record_render(error_record_t* rec) {
+    size_t used = 0;
+    size_t cap = sizeof(rec->text);
+    const error_arg_t* arg = rec->args;
+
+    for (const char* p = rec->fmt; *p && used < cap - 1; p++) {
+        if (*p != '%') {
+            rec->text[used++] = *p;
+            continue;
+        }
+
+        fmt_spec_t spec;
+        if (!parse_spec(p, &spec)) break;
+        p = spec.end - 1;
+
+        if (spec.conv == '%') {
+            rec->text[used++] = '%';
+            continue;
+        }
+
+        size_t written = (size_t)render_spec(rec->text + used, cap - used, &spec, arg);
+        used += written < cap - used ? written : cap - used - 1;
+        arg += spec.stars + 1;
+    }
+
+    rec->text[used] = '\0';
+    rec->ctx.message = (str_t){ .data = rec->text, .len = (uint32_t)used };
+    rec->fmt = NULL;
+}
+
+static err_t record_formatted(err_t code, const char* file, uint32_t line,
+                              error_ctx_t* cause, const char* fmt, va_list ap) {
+    error_record_t* rec = record_begin(code, file, line);
+    rec->ctx.cause = cause;
+    if (!fmt) return code;
+
+    va_list scan;
+    va_copy(scan, ap);
+    bool captured = capture_args(rec, fmt, &scan);
+    va_end(scan);
+
+    if (captured) {
+        rec->fmt = fmt;
+    } else {
+        // Too many or unusual arguments: format now rather than lose them
+        int n = vsnprintf(rec->text, sizeof(rec->text), fmt, ap);
+        size_t len = n < 0 ? 0 : (size_t)n;
+        if (len >= sizeof(rec->text)) len = sizeof(rec->text) - 1;
+        rec->ctx.message = (str_t){ .data = rec->text, .len = (uint32_t)len };
+    }
+    return code;
+}
+
+// ----------------------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------------------
+
 err_t error_set(err_t code, str_t message, const char* file, uint32_t line) {
-    (void)message;
-    (void)file;
-    (void)line;
+    error_record_t* rec = record_begin(code, file, line);
+    record_copy_message(rec, message);
     return code;
 }
 
 err_t error_set_with_cause(err_t code, str_t message, const char* file, uint32_t line, error_ctx_t* cause) {
-    (void)message;
-    (void)file;
-    (void)line;
-    (void)cause;
+    // Adopt first: it may take a slot, and the new record must be newer
+    error_ctx_t* adopted = record_adopt(cause);
+    error_record_t* rec = record_begin(code, file, line);
+    record_copy_message(rec, message);
+    rec->ctx.cause = adopted;
     return code;
 }
 
-str_t error_format(err_t code, str_t message) {
-    const char* code_str = error_to_string(code);
-    size_t code_len = strlen(code_str);
-    size_t message_len = message.len;
+err_t error_propagate(err_t code, str_t message, const char* file, uint32_t line) {
+    // A record with another code is a stale, already handled error, not
+    // the one being propagated
+    error_record_t* top = ring_top(&t_error_stack);
+    error_ctx_t* cause = (top && top->ctx.code == code) ? &top->ctx : NULL;
+    return error_set_with_cause(code, message, file, line, cause);
+}
+
+err_t error_setf(err_t code, const char* file, uint32_t line, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    record_formatted(code, file, line, NULL, fmt, ap);
+    va_end(ap);
+    return code;
+}
+
+err_t error_wrapf(err_t code, const char* file, uint32_t line, const char* fmt, ...) {
+    error_record_t* top = ring_top(&t_error_stack);
+
+    va_list ap;
+    va_start(ap, fmt);
+    record_formatted(code, file, line, top ? &top->ctx : NULL, fmt, ap);
+    va_end(ap);
+    return code;
+}
 
-    // Simple implementation - just return the message
+str_t error_format(err_t code, str_t message) {
+    // Code strings are static, so there is nothing to build
     if (!str_empty(message)) {
         return message;
     }
+    return STR_VIEW(error_to_string(code));
+}
+
+const error_ctx_t* error_last(void) {
+    error_record_t* top = ring_top(&t_error_stack);
+    return top ? &top->ctx : NULL;
+}
+
+str_t error_message(const error_ctx_t* error) {
+    if (!error) return STR_NULL;
+
+    if (record_in_ring(&t_error_stack, error)) {
+        error_record_t* rec = (error_record_t*)error;
+        if (rec->fmt) record_render(rec);
+    }
+    return error->message;
+}
+
+size_t error_describe(const error_ctx_t* error, char* buf, size_t size) {
+    size_t total = 0;
+    const error_ctx_t* e = error;
+
+    // Bounded walk: the ring cannot hold a longer chain
+    for (uint32_t depth = 0; e && depth < ERROR_RING_CAPACITY; depth++, e = e->cause) {
+        str_t message = error_message(e);
+        const char* code_str = error_to_string(e->code);
+        size_t room = total < size ? size - total : 0;
+        char* out = room ? buf + total : NULL;
+
+        int n = snprintf(out, room, "%s%s%s%.*s",
+                         depth ? "; caused by: " : "", code_str,
+                         str_empty(message) ? "" : ": ",
+                         (int)message.len, message.data ? message.data : "");
+        if (n > 0) total += (size_t)n;
+
+        if (!str_empty(e->file)) {
+            room = total < size ? size - total : 0;
+            out = room ? buf + total : NULL;
+            n = snprintf(out, room, " (%.*s:%u)", (int)e->file.len, e->file.data, e->line);
+            if (n > 0) total += (size_t)n;
+        }
+    }
 
-    // Otherwise return a string with the error code
-    static char buffer[256];
-    snprintf(buffer, sizeof(buffer), "%s", code_str);
-    return STR_VIEW(buffer);
+    if (size > 0 && total == 0) buf[0] = '\0';
+    return total;
 }
 
 void error_print(error_ctx_t* error) {
     if (!error) return;
-    fprintf(stderr, "Error: %s\n", error_to_string(error->code));
+
+    char buf[1024];
+    error_describe(error, buf, sizeof(buf));
+    fprintf(stderr, "Error: %s\n", buf);
 }
 
 void error_free(error_ctx_t* error) {
+    // Records live in the thread's ring and are reused, never freed
     (void)error;
 }
 
-// Error context stack (simplified)
-static error_stack_t g_error_stack = {0};
-
 error_stack_t* error_stack_get(void) {
-    return &g_error_stack;
+    return &t_error_stack;
 }
 
 void error_stack_push(error_ctx_t error) {
-    (void)error;
+    error_set_with_cause(error.code, error.message, NULL, error.line, error.cause);
+
+    // Keep the caller's file view; __FILE__ literals are static
+    error_record_t* top = ring_top(&t_error_stack);
+    top->ctx.file = error.file;
 }
 
 error_ctx_t* error_stack_pop(void) {
-    return NULL;
+    error_stack_t* stack = &t_error_stack;
+    error_record_t* top = ring_top(stack);
+    if (!top) return NULL;
+
+    // The slot is reused by the next record on this thread
+    stack->head = (stack->head + ERROR_RING_CAPACITY - 1) % ERROR_RING_CAPACITY;
+    stack->count--;
+    error_message(&top->ctx);
+    return &top->ctx;
 }
 
 void error_stack_clear(void) {
-}
\ No newline at end of file
+    t_error_stack.head = 0;
+    t_error_stack.count = 0;
+}
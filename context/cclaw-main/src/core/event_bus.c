@@ -0,0 +1,657 @@
+// event_bus.c - In-process event bus for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/event_bus.h"
+#include "utils/clock.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+
+// ============================================================================
+// Events
+// ============================================================================
+
+typedef struct bus_event_t {
+    uint32_t refs;
+    event_t event;
+    char strings[];
+} bus_event_t;
+
+static bus_event_t* bus_event_of(event_t* event) {
+    return (bus_event_t*)((char*)event - offsetof(bus_event_t, event));
+}
+
+event_t* event_retain(event_t* event) {
+    if (event) __atomic_add_fetch(&bus_event_of(event)->refs, 1, __ATOMIC_RELAXED);
+    return event;
+}
+
+void event_release(event_t* event) {
+    if (!event) return;
+    bus_event_t* header = bus_event_of(event);
+    if (__atomic_sub_fetch(&header->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(header);
+    }
+}
+
+static str_t copy_into(char** cursor, str_t s) {
+    if (!s.data || s.len == 0) return STR_NULL;
+    char* dst = *cursor;
+    memcpy(dst, s.data, s.len);
+    dst[s.len] = '\0';
+    *cursor += s.len + 1;
+    return (str_t){ .data = dst, .len = s.len };
+}
+
+// One allocation for the event and its strings
+static event_t* event_copy(const event_t* src, uint64_t sequence) {
+    size_t strings = (size_t)src->session_id.len + src->source.len + src->sender.len +
+                     src->text.len + 4;
+    bus_event_t* header = malloc(sizeof(bus_event_t) + strings);
+    if (!header) return NULL;
+
+    header->refs = 1;
+    event_t* event = &header->event;
+    *event = *src;
+    event->sequence = sequence;
+    event->timestamp_ms = clock_realtime_ms();
+
+    char* cursor = header->strings;
+    event->session_id = copy_into(&cursor, src->session_id);
+    event->source = copy_into(&cursor, src->source);
+    event->sender = copy_into(&cursor, src->sender);
+    event->text = copy_into(&cursor, src->text);
+    return event;
+}
+
+// ============================================================================
+// Bounded MPMC ring (Vyukov). Each cell's sequence says whose turn it is:
+// equal to a position, the cell is free for the producer claiming that
+// position; one past it, it holds that position's event for a consumer.
+// ============================================================================
+
+typedef struct ring_cell_t {
+    uint64_t sequence;
+    event_t* event;
+} ring_cell_t;
+
+typedef struct ring_t {
+    ring_cell_t* cells;
+    uint64_t mask;
+    uint64_t enqueue_pos __attribute__((aligned(CACHE_LINE)));
+    uint64_t dequeue_pos __attribute__((aligned(CACHE_LINE)));
+} ring_t;
+
+static bool ring_init(ring_t* ring, uint32_t capacity) {
+    uint64_t size = 2;
+    while (size < capacity) size <<= 1;
+
+    ring->cells = calloc(size, sizeof(ring_cell_t));
+    if (!ring->cells) return false;
+    for (uint64_t i = 0; i < size; i++) ring->cells[i].sequence = i;
+    ring->mask = size - 1;
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+    return true;
+}
+
+static bool ring_push(ring_t* ring, event_t* event) {
+    uint64_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    ring_cell_t* cell;
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        uint64_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;       // Full
+        } else {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->event = event;
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static event_t* ring_pop(ring_t* ring) {
+    uint64_t pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+    ring_cell_t* cell;
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        uint64_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->dequeue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL;        // Empty
+        } else {
+            pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    event_t* event = cell->event;
+    __atomic_store_n(&cell->sequence, pos + ring->mask + 1, __ATOMIC_RELEASE);
+    return event;
+}
+
+static uint32_t ring_count(const ring_t* ring) {
+    uint64_t enqueued = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    uint64_t dequeued = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+    return enqueued > dequeued ? (uint32_t)(enqueued - dequeued) : 0;
+}
+
+// ============================================================================
+// Subscriptions
+// ============================================================================
+
+struct event_subscription_t {
+    ring_t ring;
+    uint32_t topics;
+    event_overflow_t overflow;
+    uint32_t slot;
+
+    // Sleeping consumers; publishers look before touching the mutex
+    uint32_t sleepers;
+    uint64_t wakeups;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+
+    uint64_t delivered;
+    uint64_t dropped;
+};
+
+// A publisher holds users while it delivers to the slot's subscription, so
+// unsubscribing can wait it out without publishers taking a lock
+typedef struct bus_slot_t {
+    event_subscription_t* sub;
+    uint32_t users;
+} __attribute__((aligned(CACHE_LINE))) bus_slot_t;
+
+struct event_bus_t {
+    bus_slot_t slots[EVENT_BUS_MAX_SUBSCRIBERS];
+    uint32_t topic_subscribers[EVENT_TYPE_COUNT];
+    uint64_t next_sequence;
+    pthread_mutex_t subscribe_lock;     // Subscribe and unsubscribe only
+};
+
+err_t event_bus_create(event_bus_t** out_bus) {
+    if (!out_bus) return ERR_INVALID_ARGUMENT;
+
+    event_bus_t* bus = aligned_alloc(CACHE_LINE, sizeof(event_bus_t));
+    if (!bus) return ERR_OUT_OF_MEMORY;
+    memset(bus, 0, sizeof(*bus));
+    pthread_mutex_init(&bus->subscribe_lock, NULL);
+
+    *out_bus = bus;
+    return ERR_OK;
+}
+
+void event_bus_destroy(event_bus_t* bus) {
+    if (!bus) return;
+    pthread_mutex_destroy(&bus->subscribe_lock);
+    free(bus);
+}
+
+err_t event_bus_subscribe(event_bus_t* bus, uint32_t topics, uint32_t capacity,
+                          event_overflow_t overflow, event_subscription_t** out_sub) {
+    if (!bus || !out_sub || (topics & EVENT_TOPIC_ALL) == 0) return ERR_INVALID_ARGUMENT;
+
+    event_subscription_t* sub = aligned_alloc(CACHE_LINE, sizeof(event_subscription_t));
+    if (!sub) return ERR_OUT_OF_MEMORY;
+    memset(sub, 0, sizeof(*sub));
+    if (!ring_init(&sub->ring, capacity ? capacity : EVENT_BUS_DEFAULT_CAPACITY)) {
+        free(sub);
+        return ERR_OUT_OF_MEMORY;
+    }
+    sub->topics = topics & EVENT_TOPIC_ALL;
+    sub->overflow = overflow;
+    pthread_mutex_init(&sub->lock, NULL);
+    pthread_cond_init(&sub->ready, NULL);
+
+    pthread_mutex_lock(&bus->subscribe_lock);
+    uint32_t slot = EVENT_BUS_MAX_SUBSCRIBERS;
+    for (uint32_t i = 0; i < EVENT_BUS_MAX_SUBSCRIBERS && slot == EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        if (!bus->slots[i].sub) slot = i;
+    }
+    if (slot < EVENT_BUS_MAX_SUBSCRIBERS) {
+        sub->slot = slot;
+        for (uint32_t type = 0; type < EVENT_TYPE_COUNT; type++) {
+            if (sub->topics & EVENT_TOPIC(type)) {
+                __atomic_add_fetch(&bus->topic_subscribers[type], 1, __ATOMIC_RELAXED);
+            }
+        }
+        __atomic_store_n(&bus->slots[slot].sub, sub, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&bus->subscribe_lock);
+
+    if (slot == EVENT_BUS_MAX_SUBSCRIBERS) {
+        pthread_cond_destroy(&sub->ready);
+        pthread_mutex_destroy(&sub->lock);
+        free(sub->ring.cells);
+        free(sub);
+        return ERROR_SET(ERR_RATE_LIMITED, "event bus has %d subscribers already",
+                         EVENT_BUS_MAX_SUBSCRIBERS);
+    }
+
+    *out_sub = sub;
+    return ERR_OK;
+}
+
+void event_bus_unsubscribe(event_bus_t* bus, event_subscription_t* sub) {
+    if (!bus || !sub) return;
+
+    pthread_mutex_lock(&bus->subscribe_lock);
+    bus_slot_t* slot = &bus->slots[sub->slot];
+    __atomic_store_n(&slot->sub, NULL, __ATOMIC_SEQ_CST);
+    for (uint32_t type = 0; type < EVENT_TYPE_COUNT; type++) {
+        if (sub->topics & EVENT_TOPIC(type)) {
+            __atomic_sub_fetch(&bus->topic_subscribers[type], 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    // A publisher that saw the subscription before it was cleared may
+    // still be pushing to it
+    while (__atomic_load_n(&slot->users, __ATOMIC_SEQ_CST) > 0) {
+        sched_yield();
+    }
+    pthread_mutex_unlock(&bus->subscribe_lock);
+
+    event_t* event;
+    while ((event = ring_pop(&sub->ring)) != NULL) {
+        event_release(event);
+    }
+    pthread_cond_destroy(&sub->ready);
+    pthread_mutex_destroy(&sub->lock);
+    free(sub->ring.cells);
+    free(sub);
+}
+
+void event_bus_set_topics(event_bus_t* bus, event_subscription_t* sub, uint32_t topics) {
+    if (!bus || !sub) return;
+    topics &= EVENT_TOPIC_ALL;
+
+    pthread_mutex_lock(&bus->subscribe_lock);
+    uint32_t old_topics = sub->topics;
+    for (uint32_t type = 0; type < EVENT_TYPE_COUNT; type++) {
+        uint32_t topic = EVENT_TOPIC(type);
+        if ((topics & topic) && !(old_topics & topic)) {
+            __atomic_add_fetch(&bus->topic_subscribers[type], 1, __ATOMIC_RELAXED);
+        } else if (!(topics & topic) && (old_topics & topic)) {
+            __atomic_sub_fetch(&bus->topic_subscribers[type], 1, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_store_n(&sub->topics, topics, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&bus->subscribe_lock);
+}
+
+bool event_bus_wants(const event_bus_t* bus, event_type_t type) {
+    if (!bus || type >= EVENT_TYPE_COUNT) return false;
+    return __atomic_load_n(&bus->topic_subscribers[type], __ATOMIC_RELAXED) > 0;
+}
+
+// ============================================================================
+// Publishing
+// ============================================================================
+
+static void wake_sleepers(event_subscription_t* sub) {
+    // Pairs with the fence in event_bus_wait(): either the consumer sees
+    // the event on its re-check, or we see it asleep
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sub->sleepers, __ATOMIC_RELAXED) == 0) return;
+
+    pthread_mutex_lock(&sub->lock);
+    pthread_cond_signal(&sub->ready);
+    pthread_mutex_unlock(&sub->lock);
+}
+
+static bool deliver(event_subscription_t* sub, event_t* event) {
+    event_retain(event);
+    if (ring_push(&sub->ring, event)) goto delivered;
+
+    switch (sub->overflow) {
+        case EVENT_OVERFLOW_DROP_NEWEST:
+            break;
+
+        case EVENT_OVERFLOW_DROP_OLDEST:
+            // Another publisher may refill the room first; a few tries
+            // are enough before giving up on this one
+            for (int attempt = 0; attempt < 8; attempt++) {
+                event_t* oldest = ring_pop(&sub->ring);
+                if (oldest) {
+                    event_release(oldest);
+                    __atomic_add_fetch(&sub->dropped, 1, __ATOMIC_RELAXED);
+                }
+                if (ring_push(&sub->ring, event)) goto delivered;
+            }
+            break;
+
+        case EVENT_OVERFLOW_BLOCK: {
+            uint64_t deadline = clock_monotonic_ms() + EVENT_BUS_BLOCK_TIMEOUT_MS;
+            for (uint32_t spins = 0; ; spins++) {
+                if (ring_push(&sub->ring, event)) goto delivered;
+                if (spins < 64) {
+                    sched_yield();
+                    continue;
+                }
+                if (clock_monotonic_ms() >= deadline) break;
+                struct timespec pause = { .tv_sec = 0, .tv_nsec = 50 * 1000 };
+                nanosleep(&pause, NULL);
+            }
+            break;
+        }
+    }
+
+    event_release(event);
+    __atomic_add_fetch(&sub->dropped, 1, __ATOMIC_RELAXED);
+    return false;
+
+delivered:
+    __atomic_add_fetch(&sub->delivered, 1, __ATOMIC_RELAXED);
+    wake_sleepers(sub);
+    return true;
+}
+
+err_t event_bus_publish(event_bus_t* bus, const event_t* event) {
+    if (!bus || !event || event->type >= EVENT_TYPE_COUNT) return ERR_INVALID_ARGUMENT;
+    if (!event_bus_wants(bus, event->type)) return ERR_OK;
+
+    uint64_t sequence = __atomic_fetch_add(&bus->next_sequence, 1, __ATOMIC_RELAXED);
+    event_t* copy = event_copy(event, sequence);
+    if (!copy) return ERR_OUT_OF_MEMORY;
+
+    uint32_t topic = EVENT_TOPIC(event->type);
+    bool lost = false;
+    for (uint32_t i = 0; i < EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        bus_slot_t* slot = &bus->slots[i];
+        if (!__atomic_load_n(&slot->sub, __ATOMIC_RELAXED)) continue;
+
+        __atomic_add_fetch(&slot->users, 1, __ATOMIC_SEQ_CST);
+        event_subscription_t* sub = __atomic_load_n(&slot->sub, __ATOMIC_SEQ_CST);
+        if (sub && (__atomic_load_n(&sub->topics, __ATOMIC_RELAXED) & topic) &&
+            !deliver(sub, copy)) {
+            lost = true;
+        }
+        __atomic_sub_fetch(&slot->users, 1, __ATOMIC_RELEASE);
+    }
+
+    event_release(copy);
+    return lost ? ERR_RATE_LIMITED : ERR_OK;
+}
+
+// ============================================================================
+// Consuming
+// ============================================================================
+
+uint32_t event_bus_poll(event_subscription_t* sub, event_t** out_events, uint32_t max) {
+    if (!sub || !out_events) return 0;
+
+    uint32_t count = 0;
+    while (count < max) {
+        event_t* event = ring_pop(&sub->ring);
+        if (!event) break;
+        out_events[count++] = event;
+    }
+    return count;
+}
+
+uint32_t event_bus_wait(event_subscription_t* sub, event_t** out_events, uint32_t max,
+                        int32_t timeout_ms) {
+    if (!sub || !out_events || max == 0) return 0;
+
+    uint32_t count = event_bus_poll(sub, out_events, max);
+    if (count > 0 || timeout_ms == 0) return count;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeout_ms > 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&sub->lock);
+    uint64_t wakeups = sub->wakeups;
+    __atomic_add_fetch(&sub->sleepers, 1, __ATOMIC_RELAXED);
+    for (;;) {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        count = event_bus_poll(sub, out_events, max);
+        if (count > 0 || sub->wakeups != wakeups) break;
+
+        int rc = timeout_ms < 0 ? pthread_cond_wait(&sub->ready, &sub->lock)
+                                : pthread_cond_timedwait(&sub->ready, &sub->lock, &deadline);
+        if (rc == ETIMEDOUT) {
+            count = event_bus_poll(sub, out_events, max);
+            break;
+        }
+    }
+    __atomic_sub_fetch(&sub->sleepers, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&sub->lock);
+
+    // Others may be asleep behind us with events still queued
+    if (count == max) wake_sleepers(sub);
+    return count;
+}
+
+void event_bus_wake(event_subscription_t* sub) {
+    if (!sub) return;
+
+    pthread_mutex_lock(&sub->lock);
+    sub->wakeups++;
+    pthread_cond_broadcast(&sub->ready);
+    pthread_mutex_unlock(&sub->lock);
+}
+
+void event_bus_stats(const event_subscription_t* sub, event_subscription_stats_t* out_stats) {
+    if (!out_stats) return;
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (!sub) return;
+
+    out_stats->delivered = __atomic_load_n(&sub->delivered, __ATOMIC_RELAXED);
+    out_stats->dropped = __atomic_load_n(&sub->dropped, __ATOMIC_RELAXED);
+    out_stats->queued = ring_count(&sub->ring);
+}
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+#define METRICS_BATCH 64
+#define METRICS_WAIT_MS 1000         // Bounds a stop that raced the wait
+
+static struct {
+    pthread_mutex_t lock;           // Serializes start and stop
+    event_bus_t* bus;
+    event_subscription_t* subscription;
+    pthread_t thread;
+    bool stopping;
+    event_metrics_t totals;         // Written by the consumer only
+    uint64_t dropped_before;        // By subscriptions already gone
+} g_metrics = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void metrics_add(uint64_t* counter, uint64_t amount) {
+    __atomic_add_fetch(counter, amount, __ATOMIC_RELAXED);
+}
+
+static void metrics_count(const event_t* event) {
+    event_metrics_t* totals = &g_metrics.totals;
+    switch (event->type) {
+        case EVENT_MESSAGE_RECEIVED:
+            metrics_add(&totals->messages_received, 1);
+            break;
+        case EVENT_TURN_STARTED:
+            metrics_add(&totals->turns_started, 1);
+            break;
+        case EVENT_TURN_COMPLETED:
+            metrics_add(event->status == ERR_OK ? &totals->turns_completed : &totals->turns_failed, 1);
+            metrics_add(&totals->turn_duration_ms, event->duration_ms);
+            metrics_add(&totals->tokens, event->value);
+            break;
+        case EVENT_TOOL_FINISHED:
+            metrics_add(&totals->tool_calls, 1);
+            if (event->status != ERR_OK) metrics_add(&totals->tool_failures, 1);
+            metrics_add(&totals->tool_duration_ms, event->duration_ms);
+            break;
+        default:
+            break;
+    }
+}
+
+static void* metrics_thread_func(void* arg) {
+    event_subscription_t* sub = arg;
+    event_t* events[METRICS_BATCH];
+
+    while (!__atomic_load_n(&g_metrics.stopping, __ATOMIC_ACQUIRE)) {
+        uint32_t count = event_bus_wait(sub, events, METRICS_BATCH, METRICS_WAIT_MS);
+        for (uint32_t i = 0; i < count; i++) {
+            metrics_count(events[i]);
+            event_release(events[i]);
+        }
+    }
+
+    // What was published before the stop still counts
+    uint32_t count;
+    while ((count = event_bus_poll(sub, events, METRICS_BATCH)) > 0) {
+        for (uint32_t i = 0; i < count; i++) {
+            metrics_count(events[i]);
+            event_release(events[i]);
+        }
+    }
+    return NULL;
+}
+
+err_t event_metrics_start(event_bus_t* bus) {
+    if (!bus) return ERR_INVALID_ARGUMENT;
+
+    pthread_mutex_lock(&g_metrics.lock);
+    if (g_metrics.subscription) {
+        pthread_mutex_unlock(&g_metrics.lock);
+        return ERR_ALREADY_EXISTS;
+    }
+
+    uint32_t topics = EVENT_TOPIC_ALL & ~EVENT_TOPIC(EVENT_TOKEN_CHUNK);
+    event_subscription_t* sub = NULL;
+    err_t err = event_bus_subscribe(bus, topics, 0, EVENT_OVERFLOW_DROP_NEWEST, &sub);
+    if (err != ERR_OK) {
+        pthread_mutex_unlock(&g_metrics.lock);
+        return err;
+    }
+
+    __atomic_store_n(&g_metrics.stopping, false, __ATOMIC_RELEASE);
+    if (pthread_create(&g_metrics.thread, NULL, metrics_thread_func, sub) != 0) {
+        event_bus_unsubscribe(bus, sub);
+        pthread_mutex_unlock(&g_metrics.lock);
+        return ERR_FAILED;
+    }
+    g_metrics.bus = bus;
+    g_metrics.subscription = sub;
+    pthread_mutex_unlock(&g_metrics.lock);
+    return ERR_OK;
+}
+
+void event_metrics_stop(void) {
+    pthread_mutex_lock(&g_metrics.lock);
+    event_subscription_t* sub = g_metrics.subscription;
+    if (!sub) {
+        pthread_mutex_unlock(&g_metrics.lock);
+        return;
+    }
+
+    __atomic_store_n(&g_metrics.stopping, true, __ATOMIC_RELEASE);
+    event_bus_wake(sub);
+    pthread_join(g_metrics.thread, NULL);
+
+    event_subscription_stats_t stats;
+    event_bus_stats(sub, &stats);
+    metrics_add(&g_metrics.dropped_before, stats.dropped);
+
+    g_metrics.subscription = NULL;
+    event_bus_unsubscribe(g_metrics.bus, sub);
+    g_metrics.bus = NULL;
+    pthread_mutex_unlock(&g_metrics.lock);
+}
+
+void event_metrics_get(event_metrics_t* out_metrics) {
+    if (!out_metrics) return;
+
+    const event_metrics_t* totals = &g_metrics.totals;
+    out_metrics->messages_received = __atomic_load_n(&totals->messages_received, __ATOMIC_RELAXED);
+    out_metrics->turns_started = __atomic_load_n(&totals->turns_started, __ATOMIC_RELAXED);
+    out_metrics->turns_completed = __atomic_load_n(&totals->turns_completed, __ATOMIC_RELAXED);
+    out_metrics->turns_failed = __atomic_load_n(&totals->turns_failed, __ATOMIC_RELAXED);
+    out_metrics->turn_duration_ms = __atomic_load_n(&totals->turn_duration_ms, __ATOMIC_RELAXED);
+    out_metrics->tokens = __atomic_load_n(&totals->tokens, __ATOMIC_RELAXED);
+    out_metrics->tool_calls = __atomic_load_n(&totals->tool_calls, __ATOMIC_RELAXED);
+    out_metrics->tool_failures = __atomic_load_n(&totals->tool_failures, __ATOMIC_RELAXED);
+    out_metrics->tool_duration_ms = __atomic_load_n(&totals->tool_duration_ms, __ATOMIC_RELAXED);
+
+    // The live subscription's drops, if any, are read under the lock so
+    // it cannot be unsubscribed in between
+    out_metrics->dropped = 0;
+    pthread_mutex_lock(&g_metrics.lock);
+    if (g_metrics.subscription) {
+        event_subscription_stats_t stats;
+        event_bus_stats(g_metrics.subscription, &stats);
+        out_metrics->dropped = stats.dropped;
+    }
+    out_metrics->dropped += __atomic_load_n(&g_metrics.dropped_before, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&g_metrics.lock);
+}
+
+size_t event_metrics_format(char* buffer, size_t size) {
+    if (!buffer || size == 0) return 0;
+
+    event_metrics_t m;
+    event_metrics_get(&m);
+
+    int n = snprintf(buffer, size,
+        "# HELP cclaw_channel_messages_total Messages received from channels\n"
+        "# TYPE cclaw_channel_messages_total counter\n"
+        "cclaw_channel_messages_total %llu\n"
+        "# HELP cclaw_agent_turns_total Agent turns by outcome\n"
+        "# TYPE cclaw_agent_turns_total counter\n"
+        "cclaw_agent_turns_total{result=\"started\"} %llu\n"
+        "cclaw_agent_turns_total{result=\"completed\"} %llu\n"
+        "cclaw_agent_turns_total{result=\"failed\"} %llu\n"
+        "# HELP cclaw_agent_turn_duration_ms_total Time spent in finished turns\n"
+        "# TYPE cclaw_agent_turn_duration_ms_total counter\n"
+        "cclaw_agent_turn_duration_ms_total %llu\n"
+        "# HELP cclaw_agent_tokens_total Tokens used by turns\n"
+        "# TYPE cclaw_agent_tokens_total counter\n"
+        "cclaw_agent_tokens_total %llu\n"
+        "# HELP cclaw_tool_calls_total Tool calls by outcome\n"
+        "# TYPE cclaw_tool_calls_total counter\n"
+        "cclaw_tool_calls_total{result=\"ok\"} %llu\n"
+        "cclaw_tool_calls_total{result=\"failed\"} %llu\n"
+        "# HELP cclaw_tool_duration_ms_total Time spent in tool calls\n"
+        "# TYPE cclaw_tool_duration_ms_total counter\n"
+        "cclaw_tool_duration_ms_total %llu\n"
+        "# HELP cclaw_metrics_events_dropped_total Events the metrics consumer fell behind on\n"
+        "# TYPE cclaw_metrics_events_dropped_total counter\n"
+        "cclaw_metrics_events_dropped_total %llu\n",
+        (unsigned long long)m.messages_received,
+        (unsigned long long)m.turns_started, (unsigned long long)m.turns_completed,
+        (unsigned long long)m.turns_failed, (unsigned long long)m.turn_duration_ms,
+        (unsigned long long)m.tokens,
+        (unsigned long long)(m.tool_calls - m.tool_failures), (unsigned long long)m.tool_failures,
+        (unsigned long long)m.tool_duration_ms, (unsigned long long)m.dropped);
+    if (n < 0) return 0;
+    return (size_t)n >= size ? size - 1 : (size_t)n;
+}
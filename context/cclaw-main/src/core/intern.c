@@ -0,0 +1,207 @@
+// intern.c - Global string interner for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/intern.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Each shard is an open-addressing table of pointers into append-only
+// storage chunks. Strings never move once interned, which is what lets
+// readers hand out views after dropping the shard lock.
+
+#define INTERN_SHARDS 16
+#define INTERN_INITIAL_SLOTS 64
+#define INTERN_CHUNK_SIZE (16 * 1024)
+
+typedef struct {
+    uint64_t hash;
+    const char* data;       // NULL marks an empty slot
+    uint32_t len;
+} intern_slot_t;
+
+typedef struct intern_chunk_t {
+    struct intern_chunk_t* next;
+    size_t used;
+    size_t cap;
+    char data[];
+} intern_chunk_t;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    intern_slot_t* slots;
+    uint32_t slot_count;    // Power of two
+    uint32_t count;
+    intern_chunk_t* chunks; // Newest first
+} intern_shard_t;
+
+static intern_shard_t g_shards[INTERN_SHARDS];
+static pthread_once_t g_intern_once = PTHREAD_ONCE_INIT;
+
+// Process-wide counters, updated with relaxed atomics
+static intern_stats_t g_intern_stats;
+
+#define STAT_ADD(field, n) __atomic_add_fetch(&g_intern_stats.field, (n), __ATOMIC_RELAXED)
+
+static void intern_init_shards(void) {
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        pthread_rwlock_init(&g_shards[i].lock, NULL);
+    }
+}
+
+// FNV-1a, 64-bit
+static uint64_t intern_hash(const char* data, size_t len) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Slot holding s, or the empty slot where it would go
+static intern_slot_t* shard_probe(intern_shard_t* shard, uint64_t hash, str_t s) {
+    uint32_t mask = shard->slot_count - 1;
+    for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask) {
+        intern_slot_t* slot = &shard->slots[i];
+        if (!slot->data) return slot;
+        if (slot->hash == hash && slot->len == s.len && memcmp(slot->data, s.data, s.len) == 0) {
+            return slot;
+        }
+    }
+}
+
+static bool shard_grow(intern_shard_t* shard) {
+    uint32_t slot_count = shard->slot_count ? shard->slot_count * 2 : INTERN_INITIAL_SLOTS;
+    intern_slot_t* slots = calloc(slot_count, sizeof(intern_slot_t));
+    if (!slots) return false;
+
+    intern_slot_t* old = shard->slots;
+    uint32_t old_count = shard->slot_count;
+    shard->slots = slots;
+    shard->slot_count = slot_count;
+
+    for (uint32_t i = 0; i < old_count; i++) {
+        if (!old[i].data) continue;
+        uint32_t mask = slot_count - 1;
+        uint32_t j = (uint32_t)old[i].hash & mask;
+        while (slots[j].data) j = (j + 1) & mask;
+        slots[j] = old[i];
+    }
+
+    free(old);
+    return true;
+}
+
+static const char* shard_store(intern_shard_t* shard, str_t s) {
+    size_t need = (size_t)s.len + 1;
+    intern_chunk_t* chunk = shard->chunks;
+
+    if (!chunk || chunk->cap - chunk->used < need) {
+        // Oversized strings get a chunk of their own
+        size_t cap = need > INTERN_CHUNK_SIZE ? need : INTERN_CHUNK_SIZE;
+        chunk = malloc(sizeof(intern_chunk_t) + cap);
+        if (!chunk) return NULL;
+        chunk->used = 0;
+        chunk->cap = cap;
+        chunk->next = shard->chunks;
+        shard->chunks = chunk;
+    }
+
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, s.data, s.len);
+    copy[s.len] = '\0';
+    chunk->used += need;
+    return copy;
+}
+
+str_t str_intern(str_t s) {
+    if (s.len == 0) return (str_t){ .data = "", .len = 0 };
+    if (!s.data) return STR_NULL;
+
+    pthread_once(&g_intern_once, intern_init_shards);
+    STAT_ADD(lookups, 1);
+
+    uint64_t hash = intern_hash(s.data, s.len);
+    intern_shard_t* shard = &g_shards[hash >> 60];
+
+    pthread_rwlock_rdlock(&shard->lock);
+    if (shard->slot_count > 0) {
+        intern_slot_t* slot = shard_probe(shard, hash, s);
+        if (slot->data) {
+            str_t found = { .data = slot->data, .len = slot->len };
+            pthread_rwlock_unlock(&shard->lock);
+            return found;
+        }
+    }
+    pthread_rwlock_unlock(&shard->lock);
+
+    // Miss: retake exclusively, since another thread may have won the race
+    pthread_rwlock_wrlock(&shard->lock);
+
+    str_t result = STR_NULL;
+    intern_slot_t* slot = shard->slot_count > 0 ? shard_probe(shard, hash, s) : NULL;
+    if (slot && slot->data) {
+        result = (str_t){ .data = slot->data, .len = slot->len };
+    } else {
+        // Keep the load factor at or below 1/2
+        bool room = (shard->count + 1) * 2 <= shard->slot_count || shard_grow(shard);
+        const char* copy = room ? shard_store(shard, s) : NULL;
+        if (copy) {
+            slot = shard_probe(shard, hash, s);
+            slot->hash = hash;
+            slot->data = copy;
+            slot->len = s.len;
+            shard->count++;
+
+            STAT_ADD(inserts, 1);
+            STAT_ADD(strings, 1);
+            STAT_ADD(bytes, (size_t)s.len + 1);
+            result = (str_t){ .data = copy, .len = s.len };
+        }
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+    return result;
+}
+
+str_t str_intern_cstr(const char* s) {
+    if (!s) return STR_NULL;
+    return str_intern(STR_VIEW(s));
+}
+
+void str_intern_stats(intern_stats_t* out_stats) {
+    if (!out_stats) return;
+
+    out_stats->lookups = __atomic_load_n(&g_intern_stats.lookups, __ATOMIC_RELAXED);
+    out_stats->inserts = __atomic_load_n(&g_intern_stats.inserts, __ATOMIC_RELAXED);
+    out_stats->strings = __atomic_load_n(&g_intern_stats.strings, __ATOMIC_RELAXED);
+    out_stats->bytes = __atomic_load_n(&g_intern_stats.bytes, __ATOMIC_RELAXED);
+}
+
+void str_intern_shutdown(void) {
+    pthread_once(&g_intern_once, intern_init_shards);
+
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        intern_shard_t* shard = &g_shards[i];
+        pthread_rwlock_wrlock(&shard->lock);
+
+        intern_chunk_t* chunk = shard->chunks;
+        while (chunk) {
+            intern_chunk_t* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        free(shard->slots);
+        shard->slots = NULL;
+        shard->slot_count = 0;
+        shard->count = 0;
+        shard->chunks = NULL;
+
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    __atomic_store_n(&g_intern_stats.strings, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_intern_stats.bytes, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,200 @@
+// prefetch.c - Speculative execution of read-only tool calls for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/prefetch.h"
+#include "core/worker_pool.h"
+#include "core/trace.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    SLOT_QUEUED,
+    SLOT_RUNNING,
+    SLOT_DONE,
+    SLOT_TAKEN,
+    SLOT_CANCELLED
+} slot_state_t;
+
+typedef struct prefetch_slot_t {
+    tool_prefetch_t* owner;
+    tool_t* tool;
+    str_t arguments;            // Owned copy
+    slot_state_t state;
+    err_t err;
+    tool_result_t result;
+} prefetch_slot_t;
+
+struct tool_prefetch_t {
+    worker_pool_t* pool;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint32_t pending;           // Submitted jobs that have not returned
+    prefetch_slot_t slots[TOOL_PREFETCH_MAX_CALLS];
+    uint32_t slot_count;
+    tool_prefetch_stats_t stats;
+};
+
+err_t tool_prefetch_create(tool_prefetch_t** out_prefetch) {
+    if (!out_prefetch) return ERR_INVALID_ARGUMENT;
+
+    tool_prefetch_t* prefetch = calloc(1, sizeof(tool_prefetch_t));
+    if (!prefetch) return ERR_OUT_OF_MEMORY;
+
+    // One thread: calls stay ordered and tools are never entered twice
+    err_t err = worker_pool_create(1, TOOL_PREFETCH_MAX_CALLS, &prefetch->pool);
+    if (err != ERR_OK) {
+        free(prefetch);
+        return err;
+    }
+
+    pthread_mutex_init(&prefetch->lock, NULL);
+    pthread_cond_init(&prefetch->changed, NULL);
+
+    *out_prefetch = prefetch;
+    return ERR_OK;
+}
+
+void tool_prefetch_destroy(tool_prefetch_t* prefetch) {
+    if (!prefetch) return;
+
+    tool_prefetch_reset(prefetch, NULL);
+    worker_pool_destroy(prefetch->pool);
+    pthread_cond_destroy(&prefetch->changed);
+    pthread_mutex_destroy(&prefetch->lock);
+    free(prefetch);
+}
+
+static void prefetch_job(void* arg, uint32_t worker_index) {
+    prefetch_slot_t* slot = arg;
+    tool_prefetch_t* prefetch = slot->owner;
+
+    pthread_mutex_lock(&prefetch->lock);
+    bool cancelled = slot->state == SLOT_CANCELLED;
+    if (!cancelled) slot->state = SLOT_RUNNING;
+    pthread_mutex_unlock(&prefetch->lock);
+
+    err_t err = ERR_OK;
+    tool_result_t result = tool_result_create();
+    if (!cancelled) {
+        TRACE_BEGIN_STR(slot->tool->vtable->get_name(), "tool.prefetch");
+        err = slot->tool->vtable->execute(slot->tool, &slot->arguments, &result);
+        TRACE_END();
+    }
+
+    pthread_mutex_lock(&prefetch->lock);
+    if (!cancelled) {
+        slot->err = err;
+        slot->result = result;
+        slot->state = SLOT_DONE;
+    }
+    prefetch->pending--;
+    pthread_cond_broadcast(&prefetch->changed);
+    pthread_mutex_unlock(&prefetch->lock);
+}
+
+static prefetch_slot_t* find_slot(tool_prefetch_t* prefetch, const tool_t* tool, str_t arguments) {
+    for (uint32_t i = 0; i < prefetch->slot_count; i++) {
+        prefetch_slot_t* slot = &prefetch->slots[i];
+        if (slot->tool == tool && slot->state != SLOT_TAKEN && slot->state != SLOT_CANCELLED &&
+            str_equal(slot->arguments, arguments)) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+bool tool_prefetch_offer(tool_prefetch_t* prefetch, tool_t* tool, str_t arguments) {
+    if (!prefetch || !tool || !tool->initialized || !tool_is_read_only(tool)) return false;
+
+    pthread_mutex_lock(&prefetch->lock);
+    if (prefetch->slot_count >= TOOL_PREFETCH_MAX_CALLS || find_slot(prefetch, tool, arguments)) {
+        pthread_mutex_unlock(&prefetch->lock);
+        return false;
+    }
+
+    prefetch_slot_t* slot = &prefetch->slots[prefetch->slot_count];
+    *slot = (prefetch_slot_t){
+        .owner = prefetch,
+        .tool = tool,
+        .arguments = str_dup(arguments, NULL),
+        .state = SLOT_QUEUED,
+    };
+    if (!slot->arguments.data) {
+        pthread_mutex_unlock(&prefetch->lock);
+        return false;
+    }
+
+    // The job takes the lock first thing, so it cannot run ahead of this
+    prefetch->pending++;
+    if (worker_pool_submit(prefetch->pool, prefetch_job, slot) != ERR_OK) {
+        prefetch->pending--;
+        free((void*)slot->arguments.data);
+        pthread_mutex_unlock(&prefetch->lock);
+        return false;
+    }
+    prefetch->slot_count++;
+    prefetch->stats.started++;
+    pthread_mutex_unlock(&prefetch->lock);
+    return true;
+}
+
+void tool_prefetch_wait(tool_prefetch_t* prefetch) {
+    if (!prefetch) return;
+
+    pthread_mutex_lock(&prefetch->lock);
+    while (prefetch->pending > 0) {
+        pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+    }
+    pthread_mutex_unlock(&prefetch->lock);
+}
+
+bool tool_prefetch_take(tool_prefetch_t* prefetch, const tool_t* tool, str_t arguments,
+                        err_t* out_err, tool_result_t* out_result) {
+    if (!prefetch || !tool || !out_result) return false;
+
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch_slot_t* slot = find_slot(prefetch, tool, arguments);
+    if (!slot) {
+        pthread_mutex_unlock(&prefetch->lock);
+        return false;
+    }
+    while (slot->state != SLOT_DONE) {
+        pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+    }
+
+    if (out_err) *out_err = slot->err;
+    *out_result = slot->result;
+    slot->result = tool_result_create();
+    slot->state = SLOT_TAKEN;
+    prefetch->stats.used++;
+    pthread_mutex_unlock(&prefetch->lock);
+    return true;
+}
+
+void tool_prefetch_reset(tool_prefetch_t* prefetch, tool_prefetch_stats_t* out_stats) {
+    if (!prefetch) return;
+
+    pthread_mutex_lock(&prefetch->lock);
+    for (uint32_t i = 0; i < prefetch->slot_count; i++) {
+        if (prefetch->slots[i].state == SLOT_QUEUED) {
+            prefetch->slots[i].state = SLOT_CANCELLED;
+        }
+    }
+    while (prefetch->pending > 0) {
+        pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+    }
+
+    for (uint32_t i = 0; i < prefetch->slot_count; i++) {
+        prefetch_slot_t* slot = &prefetch->slots[i];
+        if (slot->state != SLOT_TAKEN) prefetch->stats.discarded++;
+        tool_result_free(&slot->result);
+        free((void*)slot->arguments.data);
+    }
+    prefetch->slot_count = 0;
+
+    if (out_stats) *out_stats = prefetch->stats;
+    memset(&prefetch->stats, 0, sizeof(prefetch->stats));
+    pthread_mutex_unlock(&prefetch->lock);
+}
@@ -0,0 +1,1267 @@
+// rag.c - Workspace retrieval index for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/rag.h"
+#include "core/str_builder.h"
+#include "providers/base.h"
+#include "utils/http.h"
+#include "json_config.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#if defined(__APPLE__)
+#define stat_mtime_spec(st) ((st)->st_mtimespec)
+#else
+#define stat_mtime_spec(st) ((st)->st_mtim)
+#endif
+
+static uint64_t fnv1a(const char* data, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void normalize(float* vec, uint32_t dims) {
+    double sum = 0;
+    for (uint32_t i = 0; i < dims; i++) sum += (double)vec[i] * vec[i];
+    if (sum <= 0) return;
+
+    float inv = (float)(1.0 / sqrt(sum));
+    for (uint32_t i = 0; i < dims; i++) vec[i] *= inv;
+}
+
+// ============================================================================
+// Hashing embedder
+// ============================================================================
+
+#define HASH_MAX_WORD 64
+
+static const char* const g_stopwords[] = {
+    "the", "and", "for", "how", "what", "where", "which", "does", "this", "that",
+    "with", "from", "are", "was", "is", "in", "of", "to", "it", "be", "do", "an",
+    "or", "on", "by", "at", "as", "if",
+};
+
+static bool is_stopword(const char* word, size_t len) {
+    for (size_t i = 0; i < sizeof(g_stopwords) / sizeof(g_stopwords[0]); i++) {
+        if (strlen(g_stopwords[i]) == len && memcmp(g_stopwords[i], word, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void hash_feature(float* vec, uint32_t dims, const char* word, size_t len, float weight) {
+    if (len < 2 || is_stopword(word, len)) return;
+
+    // Signed hashing, so collisions cancel out on average
+    uint64_t hash = fnv1a(word, len);
+    vec[hash % dims] += (hash >> 63) ? -weight : weight;
+}
+
+static bool is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// A sub-word boundary falls before i in snake_case, camelCase, HTTPServer
+// and name42 style identifiers
+static bool subword_boundary(const char* s, size_t len, size_t i) {
+    unsigned char prev = (unsigned char)s[i - 1], cur = (unsigned char)s[i];
+    if (cur == '_' || prev == '_') return true;
+    if (islower(prev) && isupper(cur)) return true;
+    if (isupper(prev) && isupper(cur) && i + 1 < len && islower((unsigned char)s[i + 1])) return true;
+    return !isdigit(prev) != !isdigit(cur);
+}
+
+static void hash_word(float* vec, uint32_t dims, const char* word, size_t len) {
+    if (len > HASH_MAX_WORD) len = HASH_MAX_WORD;
+
+    char lower[HASH_MAX_WORD];
+    bool digits_only = true;
+    for (size_t i = 0; i < len; i++) {
+        lower[i] = (char)tolower((unsigned char)word[i]);
+        if (!isdigit((unsigned char)word[i])) digits_only = false;
+    }
+    if (digits_only) return;
+
+    hash_feature(vec, dims, lower, len, 1.0f);
+
+    // Parts of compound identifiers count for half, so "retry_backoff" also
+    // matches a query for "backoff"
+    size_t start = 0;
+    for (size_t i = 1; i <= len; i++) {
+        if (i < len && !subword_boundary(word, len, i)) continue;
+        if ((start > 0 || i < len) && word[start] != '_') {
+            hash_feature(vec, dims, lower + start, i - start, 0.5f);
+        }
+        start = i;
+    }
+}
+
+static void hash_embed_text(str_t text, float* vec, uint32_t dims) {
+    memset(vec, 0, sizeof(float) * dims);
+
+    size_t i = 0;
+    while (i < text.len) {
+        if (!is_word_char(text.data[i])) {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < text.len && is_word_char(text.data[i])) i++;
+        hash_word(vec, dims, text.data + start, i - start);
+    }
+
+    // Dampen repeated terms
+    for (uint32_t d = 0; d < dims; d++) {
+        vec[d] = copysignf(sqrtf(fabsf(vec[d])), vec[d]);
+    }
+    normalize(vec, dims);
+}
+
+static err_t hash_embed(rag_embedder_t* embedder, const str_t* texts, uint32_t count, float* out_vectors) {
+    for (uint32_t i = 0; i < count; i++) {
+        hash_embed_text(texts[i], out_vectors + (size_t)i * embedder->dimensions, embedder->dimensions);
+    }
+    return ERR_OK;
+}
+
+static void hash_destroy(rag_embedder_t* embedder) {
+    free(embedder);
+}
+
+rag_embedder_t* rag_hash_embedder_create(uint32_t dimensions) {
+    rag_embedder_t* embedder = calloc(1, sizeof(rag_embedder_t));
+    if (!embedder) return NULL;
+
+    embedder->name = STR_LIT("hash-v1");
+    embedder->dimensions = dimensions ? dimensions : RAG_HASH_DIMENSIONS;
+    embedder->embed = hash_embed;
+    embedder->destroy = hash_destroy;
+    return embedder;
+}
+
+// ============================================================================
+// HTTP embedder
+// ============================================================================
+
+typedef struct http_embedder_t {
+    http_client_t* http;
+    char* url;
+    char* model;
+    char* name;                 // "<model>@<base url>"
+} http_embedder_t;
+
+static err_t http_embed(rag_embedder_t* embedder, const str_t* texts, uint32_t count, float* out_vectors) {
+    http_embedder_t* impl = embedder->impl_data;
+
+    str_builder_t body;
+    str_builder_init(&body, NULL);
+    str_builder_append_cstr(&body, "{\"model\":\"");
+    str_builder_append_json_escaped(&body, STR_VIEW(impl->model));
+    str_builder_append_cstr(&body, "\",\"input\":[");
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) str_builder_append_char(&body, ',');
+        str_builder_append_char(&body, '"');
+        str_builder_append_json_escaped(&body, texts[i]);
+        str_builder_append_char(&body, '"');
+    }
+    str_builder_append_char(&body, ']');
+    if (strncmp(impl->model, "text-embedding-3", 16) == 0) {
+        str_builder_appendf(&body, ",\"dimensions\":%u", embedder->dimensions);
+    }
+    str_builder_append_char(&body, '}');
+
+    str_t request = str_builder_finish(&body, NULL);
+    if (str_empty(request)) return ERR_OUT_OF_MEMORY;
+
+    http_response_t* response = NULL;
+    err_t err = http_post_json(impl->http, impl->url, request.data, &response);
+    free((void*)request.data);
+    if (err != ERR_OK) return err;
+
+    if (!http_response_is_success(response)) {
+        err = ERROR_SET(ERR_EMBEDDING_FAILED, "embeddings request failed with HTTP %u",
+                        response->status_code);
+        http_response_free(response);
+        return err;
+    }
+
+    json_value_t* root = json_parse(response->body.data);
+    http_response_free(response);
+
+    json_array_t* data = root && json_is_object(root)
+        ? json_object_get_array(json_as_object(root), "data") : NULL;
+    err = data && json_array_length(data) == count ? ERR_OK : ERR_EMBEDDING_FAILED;
+
+    for (uint32_t i = 0; err == ERR_OK && i < count; i++) {
+        json_object_t* item = json_as_object(json_array_get(data, i));
+        json_array_t* values = item ? json_object_get_array(item, "embedding") : NULL;
+        double index = item ? json_object_get_number(item, "index", i) : i;
+        if (!values || json_array_length(values) != embedder->dimensions ||
+            index < 0 || index >= count) {
+            err = ERR_EMBEDDING_FAILED;
+            break;
+        }
+
+        float* out = out_vectors + (size_t)index * embedder->dimensions;
+        for (uint32_t d = 0; d < embedder->dimensions; d++) {
+            out[d] = (float)json_as_number(json_array_get(values, d), 0);
+        }
+    }
+
+    json_free(root);
+    if (err != ERR_OK) {
+        return ERROR_SET(err, "unexpected embeddings response shape");
+    }
+    return ERR_OK;
+}
+
+static void http_embedder_destroy(rag_embedder_t* embedder) {
+    http_embedder_t* impl = embedder->impl_data;
+    if (impl) {
+        http_client_destroy(impl->http);
+        free(impl->url);
+        free(impl->model);
+        free(impl->name);
+        free(impl);
+    }
+    free(embedder);
+}
+
+rag_embedder_t* rag_http_embedder_create(str_t base_url, str_t api_key, str_t model, uint32_t dimensions) {
+    if (str_empty(base_url) || str_empty(model) || dimensions == 0) return NULL;
+
+    rag_embedder_t* embedder = calloc(1, sizeof(rag_embedder_t));
+    http_embedder_t* impl = calloc(1, sizeof(http_embedder_t));
+    if (!embedder || !impl) {
+        free(embedder);
+        free(impl);
+        return NULL;
+    }
+    embedder->impl_data = impl;
+    embedder->dimensions = dimensions;
+    embedder->embed = http_embed;
+    embedder->destroy = http_embedder_destroy;
+
+    size_t url_len = base_url.len;
+    while (url_len > 0 && base_url.data[url_len - 1] == '/') url_len--;
+
+    http_client_config_t http_config = http_client_default_config();
+    impl->http = http_client_create(&http_config);
+    impl->model = strndup(model.data, model.len);
+    if (asprintf(&impl->url, "%.*s/embeddings", (int)url_len, base_url.data) < 0) impl->url = NULL;
+    if (asprintf(&impl->name, "%s@%.*s", impl->model ? impl->model : "", (int)url_len,
+                 base_url.data) < 0) impl->name = NULL;
+    if (!impl->http || !impl->model || !impl->url || !impl->name) {
+        http_embedder_destroy(embedder);
+        return NULL;
+    }
+    embedder->name = STR_VIEW(impl->name);
+
+    if (!str_empty(api_key)) {
+        char auth[512];
+        snprintf(auth, sizeof(auth), "Bearer %.*s", (int)api_key.len, api_key.data);
+        http_client_add_header(impl->http, "Authorization", auth);
+    }
+    return embedder;
+}
+
+void rag_embedder_free(rag_embedder_t* embedder) {
+    if (embedder && embedder->destroy) embedder->destroy(embedder);
+}
+
+static err_t embedder_create(str_t provider, str_t model, str_t api_key, uint32_t dimensions,
+                             rag_embedder_t** out_embedder) {
+    rag_embedder_t* embedder = NULL;
+
+    if (str_equal_cstr(provider, "openai")) {
+        embedder = rag_http_embedder_create(STR_LIT(OPENAI_BASE_URL), api_key, model, dimensions);
+    } else if (provider.len > 7 && strncmp(provider.data, "custom:", 7) == 0) {
+        str_t base = { .data = provider.data + 7, .len = provider.len - 7 };
+        embedder = rag_http_embedder_create(base, api_key, model, dimensions);
+    } else {
+        embedder = rag_hash_embedder_create(RAG_HASH_DIMENSIONS);
+    }
+
+    if (!embedder) {
+        return ERROR_SET(ERR_CONFIG_INVALID, "cannot create embedder for provider '%.*s'",
+                         (int)provider.len, provider.data ? provider.data : "");
+    }
+    *out_embedder = embedder;
+    return ERR_OK;
+}
+
+err_t rag_embedder_create_configured(const config_t* config, rag_embedder_t** out_embedder) {
+    if (!config || !out_embedder) return ERR_INVALID_ARGUMENT;
+
+    str_t provider = config->memory.embedding_provider;
+    str_t api_key = config_get_api_key_for_provider((config_t*)config, provider);
+    if (str_empty(api_key)) api_key = config->api_key;
+
+    return embedder_create(provider, config->memory.embedding_model, api_key,
+                           config->memory.embedding_dimensions, out_embedder);
+}
+
+// ============================================================================
+// Index file format
+// ============================================================================
+//
+// header | files[file_count] | chunks[chunk_count] | pad to 64 |
+// vectors[chunk_count][dimensions] (int8) | strings (NUL-terminated paths)
+//
+// Files are sorted by path so the previous index can be searched by binary
+// search during an update. Native byte order; the file is a cache and is
+// rebuilt whenever the header does not match.
+
+#define RAG_MAGIC "CCRAGIX1"
+#define RAG_VERSION 1
+
+typedef struct rag_file_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t dimensions;
+    uint32_t chunk_tokens;
+    uint32_t file_count;
+    uint32_t chunk_count;
+    uint32_t strings_size;
+    uint64_t embedder_hash;
+} rag_file_header_t;
+
+typedef struct rag_file_rec_t {
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t inode;
+    uint32_t path_offset;
+    uint32_t path_len;
+    uint32_t first_chunk;
+    uint32_t chunk_count;
+} rag_file_rec_t;
+
+typedef struct rag_chunk_rec_t {
+    uint32_t file;
+    uint32_t start_line;
+    uint32_t end_line;
+    float scale;                // Dequantization factor for the int8 vector
+} rag_chunk_rec_t;
+
+typedef struct rag_layout_t {
+    size_t files;
+    size_t chunks;
+    size_t vectors;
+    size_t strings;
+    size_t total;
+} rag_layout_t;
+
+static rag_layout_t layout_for(uint32_t file_count, uint32_t chunk_count, uint32_t dimensions,
+                               uint32_t strings_size) {
+    rag_layout_t layout;
+    layout.files = sizeof(rag_file_header_t);
+    layout.chunks = layout.files + sizeof(rag_file_rec_t) * file_count;
+    layout.vectors = (layout.chunks + sizeof(rag_chunk_rec_t) * chunk_count + 63) & ~(size_t)63;
+    layout.strings = layout.vectors + (size_t)dimensions * chunk_count;
+    layout.total = layout.strings + strings_size;
+    return layout;
+}
+
+struct rag_index_t {
+    pthread_mutex_t lock;
+    char* root;
+    char* dir;
+    char* path;
+    rag_embedder_t* embedder;
+    uint32_t chunk_tokens;
+    uint64_t embedder_hash;
+
+    // Current index file, mapped read-only; all NULL while empty
+    void* map;
+    size_t map_size;
+    const rag_file_header_t* header;
+    const rag_file_rec_t* files;
+    const rag_chunk_rec_t* chunks;
+    const int8_t* vectors;
+    const char* strings;
+
+    bool scanned;               // Updated at least once since open
+    int watch_fd;               // inotify, -1 when unavailable
+};
+
+static void index_unmap(rag_index_t* index) {
+    if (index->map) munmap(index->map, index->map_size);
+    index->map = NULL;
+    index->map_size = 0;
+    index->header = NULL;
+    index->files = NULL;
+    index->chunks = NULL;
+    index->vectors = NULL;
+    index->strings = NULL;
+}
+
+// The header only sizes the sections. Every offset and count in the records
+// is checked against them too, so a damaged file is rebuilt rather than
+// read out of bounds.
+static bool index_records_valid(const rag_file_header_t* header, const rag_file_rec_t* files,
+                                const rag_chunk_rec_t* chunks, const char* strings) {
+    for (uint32_t f = 0; f < header->file_count; f++) {
+        const rag_file_rec_t* file = &files[f];
+        uint64_t path_end = (uint64_t)file->path_offset + file->path_len;
+        if (path_end >= header->strings_size || strings[path_end] != '\0') return false;
+        if ((uint64_t)file->first_chunk + file->chunk_count > header->chunk_count) return false;
+    }
+    for (uint32_t c = 0; c < header->chunk_count; c++) {
+        if (chunks[c].file >= header->file_count) return false;
+    }
+    return true;
+}
+
+// Map the index file if it exists and was built with the same settings
+static void index_map(rag_index_t* index) {
+    index_unmap(index);
+
+    int fd = open(index->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(rag_file_header_t)) {
+        close(fd);
+        return;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return;
+
+    const rag_file_header_t* header = map;
+    rag_layout_t layout = layout_for(header->file_count, header->chunk_count,
+                                     header->dimensions, header->strings_size);
+    if (memcmp(header->magic, RAG_MAGIC, 8) != 0 || header->version != RAG_VERSION ||
+        header->dimensions != index->embedder->dimensions ||
+        header->chunk_tokens != index->chunk_tokens ||
+        header->embedder_hash != index->embedder_hash ||
+        layout.total != (size_t)st.st_size ||
+        !index_records_valid(header, (const rag_file_rec_t*)((const char*)map + layout.files),
+                             (const rag_chunk_rec_t*)((const char*)map + layout.chunks),
+                             (const char*)map + layout.strings)) {
+        munmap(map, (size_t)st.st_size);
+        return;
+    }
+
+    index->map = map;
+    index->map_size = (size_t)st.st_size;
+    index->header = header;
+    index->files = (const rag_file_rec_t*)((const char*)map + layout.files);
+    index->chunks = (const rag_chunk_rec_t*)((const char*)map + layout.chunks);
+    index->vectors = (const int8_t*)((const char*)map + layout.vectors);
+    index->strings = (const char*)map + layout.strings;
+}
+
+static const char* indexed_path(const rag_index_t* index, const rag_file_rec_t* file) {
+    return index->strings + file->path_offset;
+}
+
+static int64_t stat_mtime_ns(const struct stat* st) {
+    return (int64_t)stat_mtime_spec(st).tv_sec * 1000000000LL + stat_mtime_spec(st).tv_nsec;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+err_t rag_index_open(str_t root, uint32_t chunk_max_tokens, rag_embedder_t* embedder,
+                     rag_index_t** out_index) {
+    if (str_empty(root) || !embedder || !out_index) {
+        rag_embedder_free(embedder);
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    rag_index_t* index = calloc(1, sizeof(rag_index_t));
+    if (!index) {
+        rag_embedder_free(embedder);
+        return ERR_OUT_OF_MEMORY;
+    }
+    pthread_mutex_init(&index->lock, NULL);
+
+    size_t root_len = root.len;
+    while (root_len > 1 && root.data[root_len - 1] == '/') root_len--;
+
+    index->embedder = embedder;
+    index->chunk_tokens = chunk_max_tokens ? chunk_max_tokens : RAG_DEFAULT_CHUNK_TOKENS;
+    index->embedder_hash = fnv1a(embedder->name.data, embedder->name.len);
+    index->watch_fd = -1;
+    index->root = strndup(root.data, root_len);
+    if (index->root && asprintf(&index->dir, "%s/%s", index->root, RAG_INDEX_DIR) < 0) {
+        index->dir = NULL;
+    }
+    if (index->dir && asprintf(&index->path, "%s/%s", index->dir, RAG_INDEX_FILE) < 0) {
+        index->path = NULL;
+    }
+    if (!index->path) {
+        rag_index_close(index);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+#ifdef __linux__
+    index->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
+    index_map(index);
+
+    *out_index = index;
+    return ERR_OK;
+}
+
+void rag_index_close(rag_index_t* index) {
+    if (!index) return;
+
+    index_unmap(index);
+    if (index->watch_fd >= 0) close(index->watch_fd);
+    pthread_mutex_destroy(&index->lock);
+    rag_embedder_free(index->embedder);
+    free(index->root);
+    free(index->dir);
+    free(index->path);
+    free(index);
+}
+
+// ============================================================================
+// Workspace scan
+// ============================================================================
+
+typedef struct scan_entry_t {
+    char* path;                 // Relative
+    struct stat st;
+} scan_entry_t;
+
+typedef struct scan_list_t {
+    scan_entry_t* entries;
+    uint32_t count;
+    uint32_t capacity;
+} scan_list_t;
+
+static const char* const g_skip_dirs[] = {
+    "node_modules", "target", "build", "dist", "__pycache__", "vendor",
+};
+
+static bool skip_dir(const char* name) {
+    for (size_t i = 0; i < sizeof(g_skip_dirs) / sizeof(g_skip_dirs[0]); i++) {
+        if (strcmp(name, g_skip_dirs[i]) == 0) return true;
+    }
+    return false;
+}
+
+static void watch_dir(rag_index_t* index, const char* full_path) {
+#ifdef __linux__
+    if (index->watch_fd < 0) return;
+
+    uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                    IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+    if (inotify_add_watch(index->watch_fd, full_path, mask) < 0) {
+        // Out of watches: fall back to rescanning on every search
+        close(index->watch_fd);
+        index->watch_fd = -1;
+    }
+#else
+    (void)index;
+    (void)full_path;
+#endif
+}
+
+static void scan_dir(rag_index_t* index, const char* rel, scan_list_t* list) {
+    char full[4096];
+    if (*rel) {
+        snprintf(full, sizeof(full), "%s/%s", index->root, rel);
+    } else {
+        snprintf(full, sizeof(full), "%s", index->root);
+    }
+
+    DIR* dir = opendir(full);
+    if (!dir) return;
+    watch_dir(index, full);
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && list->count < RAG_MAX_FILES) {
+        const char* name = entry->d_name;
+        if (name[0] == '.') continue;    // Hidden files, VCS metadata, the index itself
+
+        char child_rel[4096];
+        int n = *rel ? snprintf(child_rel, sizeof(child_rel), "%s/%s", rel, name)
+                     : snprintf(child_rel, sizeof(child_rel), "%s", name);
+        if (n < 0 || (size_t)n >= sizeof(child_rel)) continue;
+
+        char child_full[4096];
+        n = snprintf(child_full, sizeof(child_full), "%s/%s", index->root, child_rel);
+        if (n < 0 || (size_t)n >= sizeof(child_full)) continue;
+
+        struct stat st;
+        if (lstat(child_full, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            if (!skip_dir(name)) scan_dir(index, child_rel, list);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size > RAG_MAX_FILE_SIZE) continue;
+
+        if (list->count == list->capacity) {
+            uint32_t capacity = list->capacity ? list->capacity * 2 : 256;
+            scan_entry_t* grown = realloc(list->entries, sizeof(scan_entry_t) * capacity);
+            if (!grown) break;
+            list->entries = grown;
+            list->capacity = capacity;
+        }
+        char* path = strdup(child_rel);
+        if (!path) break;
+        list->entries[list->count++] = (scan_entry_t){ .path = path, .st = st };
+    }
+
+    closedir(dir);
+}
+
+static int scan_entry_compare(const void* a, const void* b) {
+    return strcmp(((const scan_entry_t*)a)->path, ((const scan_entry_t*)b)->path);
+}
+
+static void scan_list_free(scan_list_t* list) {
+    for (uint32_t i = 0; i < list->count; i++) free(list->entries[i].path);
+    free(list->entries);
+}
+
+static const rag_file_rec_t* find_indexed(const rag_index_t* index, const char* path) {
+    if (!index->header) return NULL;
+
+    uint32_t lo = 0, hi = index->header->file_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(indexed_path(index, &index->files[mid]), path);
+        if (cmp == 0) return &index->files[mid];
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+static bool read_file(const char* path, char** out_data, size_t* out_len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || st.st_size > RAG_MAX_FILE_SIZE) {
+        fclose(f);
+        return false;
+    }
+
+    char* data = malloc((size_t)st.st_size + 1);
+    size_t len = data ? fread(data, 1, (size_t)st.st_size, f) : 0;
+    fclose(f);
+    if (!data) return false;
+
+    data[len] = '\0';
+    *out_data = data;
+    *out_len = len;
+    return true;
+}
+
+// ============================================================================
+// Index builder
+// ============================================================================
+
+typedef struct rag_builder_t {
+    rag_index_t* index;
+    uint32_t dims;
+
+    rag_file_rec_t* files;
+    uint32_t file_count;
+    uint32_t file_capacity;
+
+    rag_chunk_rec_t* chunks;
+    int8_t* vectors;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+
+    str_builder_t strings;
+
+    // Chunk texts waiting for the embedder, cut across files
+    str_t pending[RAG_EMBED_BATCH];
+    uint32_t pending_chunk[RAG_EMBED_BATCH];
+    uint32_t pending_count;
+    float* scratch;
+} rag_builder_t;
+
+static err_t builder_add_file(rag_builder_t* b, const char* path, const struct stat* st) {
+    if (b->file_count == b->file_capacity) {
+        uint32_t capacity = b->file_capacity ? b->file_capacity * 2 : 256;
+        rag_file_rec_t* grown = realloc(b->files, sizeof(rag_file_rec_t) * capacity);
+        if (!grown) return ERR_OUT_OF_MEMORY;
+        b->files = grown;
+        b->file_capacity = capacity;
+    }
+
+    size_t path_len = strlen(path);
+    b->files[b->file_count++] = (rag_file_rec_t){
+        .size = (uint64_t)st->st_size,
+        .mtime_ns = stat_mtime_ns(st),
+        .inode = (uint64_t)st->st_ino,
+        .path_offset = (uint32_t)b->strings.len,
+        .path_len = (uint32_t)path_len,
+        .first_chunk = b->chunk_count,
+        .chunk_count = 0,
+    };
+    str_builder_append_bytes(&b->strings, path, path_len + 1);
+    return b->strings.failed ? ERR_OUT_OF_MEMORY : ERR_OK;
+}
+
+static err_t builder_add_chunk(rag_builder_t* b, uint32_t start_line, uint32_t end_line,
+                               uint32_t* out_chunk) {
+    if (b->chunk_count == b->chunk_capacity) {
+        uint32_t capacity = b->chunk_capacity ? b->chunk_capacity * 2 : 1024;
+        rag_chunk_rec_t* chunks = realloc(b->chunks, sizeof(rag_chunk_rec_t) * capacity);
+        if (!chunks) return ERR_OUT_OF_MEMORY;
+        b->chunks = chunks;
+        int8_t* vectors = realloc(b->vectors, (size_t)b->dims * capacity);
+        if (!vectors) return ERR_OUT_OF_MEMORY;
+        b->vectors = vectors;
+        b->chunk_capacity = capacity;
+    }
+
+    b->chunks[b->chunk_count] = (rag_chunk_rec_t){
+        .file = b->file_count - 1,
+        .start_line = start_line,
+        .end_line = end_line,
+    };
+    b->files[b->file_count - 1].chunk_count++;
+    *out_chunk = b->chunk_count++;
+    return ERR_OK;
+}
+
+static void quantize(const float* vec, uint32_t dims, int8_t* out, float* out_scale) {
+    float max = 0;
+    for (uint32_t d = 0; d < dims; d++) {
+        if (fabsf(vec[d]) > max) max = fabsf(vec[d]);
+    }
+
+    float scale = max > 0 ? max / 127.0f : 1.0f;
+    for (uint32_t d = 0; d < dims; d++) {
+        out[d] = (int8_t)lrintf(vec[d] / scale);
+    }
+    *out_scale = scale;
+}
+
+static err_t builder_flush(rag_builder_t* b) {
+    if (b->pending_count == 0) return ERR_OK;
+
+    rag_embedder_t* embedder = b->index->embedder;
+    err_t err = embedder->embed(embedder, b->pending, b->pending_count, b->scratch);
+
+    for (uint32_t i = 0; i < b->pending_count; i++) {
+        if (err == ERR_OK) {
+            float* vec = b->scratch + (size_t)i * b->dims;
+            uint32_t chunk = b->pending_chunk[i];
+            normalize(vec, b->dims);
+            quantize(vec, b->dims, b->vectors + (size_t)chunk * b->dims, &b->chunks[chunk].scale);
+        }
+        free((void*)b->pending[i].data);
+    }
+    b->pending_count = 0;
+    return err;
+}
+
+static err_t builder_queue_text(rag_builder_t* b, uint32_t chunk, const char* path,
+                                const char* text, size_t len) {
+    // The path is embedded too, so file and directory names are searchable
+    str_t embedded = str_format(NULL, "%s\n%.*s", path, (int)len, text);
+    if (str_empty(embedded)) return ERR_OUT_OF_MEMORY;
+
+    b->pending[b->pending_count] = embedded;
+    b->pending_chunk[b->pending_count] = chunk;
+    if (++b->pending_count == RAG_EMBED_BATCH) {
+        return builder_flush(b);
+    }
+    return ERR_OK;
+}
+
+static bool is_blank(const char* s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!isspace((unsigned char)s[i])) return false;
+    }
+    return true;
+}
+
+static err_t builder_emit(rag_builder_t* b, const char* path, const char* text, size_t len,
+                          uint32_t start_line, uint32_t end_line) {
+    if (len == 0 || is_blank(text, len)) return ERR_OK;
+
+    uint32_t chunk;
+    err_t err = builder_add_chunk(b, start_line, end_line, &chunk);
+    if (err != ERR_OK) return err;
+    return builder_queue_text(b, chunk, path, text, len);
+}
+
+// Split on line boundaries into pieces of at most max_bytes, preferring to
+// end a piece at a blank line once it is half full. Tokens are estimated at
+// four bytes each.
+static err_t chunk_and_queue(rag_builder_t* b, const char* path, const char* data, size_t len) {
+    size_t max_bytes = (size_t)b->index->chunk_tokens * 4;
+
+    size_t chunk_start = 0;
+    uint32_t chunk_line = 1;
+    uint32_t line = 1;
+    size_t pos = 0;
+    err_t err = ERR_OK;
+
+    while (pos < len && err == ERR_OK) {
+        const char* nl = memchr(data + pos, '\n', len - pos);
+        size_t line_end = nl ? (size_t)(nl - data) + 1 : len;
+        size_t line_len = line_end - pos;
+
+        if (line_len > max_bytes) {
+            // Over-long line: flush, then cut it into pieces of its own
+            err = builder_emit(b, path, data + chunk_start, pos - chunk_start, chunk_line, line - 1);
+            for (size_t off = pos; off < line_end && err == ERR_OK; off += max_bytes) {
+                size_t piece = line_end - off < max_bytes ? line_end - off : max_bytes;
+                err = builder_emit(b, path, data + off, piece, line, line);
+            }
+            chunk_start = line_end;
+            chunk_line = line + 1;
+        } else if (pos - chunk_start + line_len > max_bytes) {
+            err = builder_emit(b, path, data + chunk_start, pos - chunk_start, chunk_line, line - 1);
+            chunk_start = pos;
+            chunk_line = line;
+        }
+
+        pos = line_end;
+        if (err == ERR_OK && chunk_start < pos && is_blank(data + pos - line_len, line_len) &&
+            pos - chunk_start >= max_bytes / 2) {
+            err = builder_emit(b, path, data + chunk_start, pos - chunk_start, chunk_line, line);
+            chunk_start = pos;
+            chunk_line = line + 1;
+        }
+        line++;
+    }
+
+    if (err == ERR_OK && chunk_start < len) {
+        err = builder_emit(b, path, data + chunk_start, len - chunk_start, chunk_line, line - 1);
+    }
+    return err;
+}
+
+static err_t builder_embed_file(rag_builder_t* b, const char* path) {
+    char full[4096];
+    snprintf(full, sizeof(full), "%s/%s", b->index->root, path);
+
+    char* data = NULL;
+    size_t len = 0;
+    if (!read_file(full, &data, &len)) return ERR_OK;   // Vanished since the scan
+
+    // Binary files stay in the index with no chunks so they are not re-read
+    size_t probe = len < 4096 ? len : 4096;
+    err_t err = memchr(data, '\0', probe) ? ERR_OK : chunk_and_queue(b, path, data, len);
+    free(data);
+    return err;
+}
+
+static err_t builder_reuse(rag_builder_t* b, const rag_file_rec_t* old) {
+    const rag_index_t* index = b->index;
+
+    for (uint32_t i = 0; i < old->chunk_count; i++) {
+        uint32_t chunk;
+        err_t err = builder_add_chunk(b, 0, 0, &chunk);
+        if (err != ERR_OK) return err;
+
+        const rag_chunk_rec_t* src = &index->chunks[old->first_chunk + i];
+        b->chunks[chunk] = *src;
+        b->chunks[chunk].file = b->file_count - 1;
+        memcpy(b->vectors + (size_t)chunk * b->dims,
+               index->vectors + (size_t)(old->first_chunk + i) * b->dims, b->dims);
+    }
+    return ERR_OK;
+}
+
+static bool write_all(int fd, const void* data, size_t len) {
+    const char* p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static err_t builder_write(rag_builder_t* b) {
+    rag_index_t* index = b->index;
+
+    mkdir(index->root, 0755);
+    char cclaw_dir[4096];
+    snprintf(cclaw_dir, sizeof(cclaw_dir), "%s/.cclaw", index->root);
+    mkdir(cclaw_dir, 0755);
+    mkdir(index->dir, 0755);
+
+    rag_file_header_t header = {
+        .version = RAG_VERSION,
+        .dimensions = b->dims,
+        .chunk_tokens = index->chunk_tokens,
+        .file_count = b->file_count,
+        .chunk_count = b->chunk_count,
+        .strings_size = (uint32_t)b->strings.len,
+        .embedder_hash = index->embedder_hash,
+    };
+    memcpy(header.magic, RAG_MAGIC, 8);
+    rag_layout_t layout = layout_for(b->file_count, b->chunk_count, b->dims, header.strings_size);
+
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", index->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return ERROR_SET(ERR_IO, "cannot write %s: %s", tmp, strerror(errno));
+    }
+
+    static const char zeros[64];
+    size_t chunks_end = layout.chunks + sizeof(rag_chunk_rec_t) * b->chunk_count;
+    bool ok = write_all(fd, &header, sizeof(header)) &&
+              write_all(fd, b->files, sizeof(rag_file_rec_t) * b->file_count) &&
+              write_all(fd, b->chunks, sizeof(rag_chunk_rec_t) * b->chunk_count) &&
+              write_all(fd, zeros, layout.vectors - chunks_end) &&
+              write_all(fd, b->vectors, (size_t)b->dims * b->chunk_count) &&
+              write_all(fd, b->strings.data, b->strings.len);
+    ok = close(fd) == 0 && ok;
+
+    // The rename replaces the file under the old mapping, which stays valid
+    if (!ok || rename(tmp, index->path) != 0) {
+        unlink(tmp);
+        return ERROR_SET(ERR_WRITE_FAILED, "cannot write %s", index->path);
+    }
+    return ERR_OK;
+}
+
+static void builder_free(rag_builder_t* b) {
+    for (uint32_t i = 0; i < b->pending_count; i++) free((void*)b->pending[i].data);
+    free(b->files);
+    free(b->chunks);
+    free(b->vectors);
+    free(b->scratch);
+    str_builder_free(&b->strings);
+}
+
+static err_t index_update_locked(rag_index_t* index, rag_update_stats_t* out_stats) {
+    scan_list_t list = {0};
+    scan_dir(index, "", &list);
+    qsort(list.entries, list.count, sizeof(scan_entry_t), scan_entry_compare);
+
+    rag_builder_t b = { .index = index, .dims = index->embedder->dimensions };
+    str_builder_init(&b.strings, NULL);
+    b.scratch = malloc(sizeof(float) * b.dims * RAG_EMBED_BATCH);
+
+    rag_update_stats_t stats = {0};
+    err_t err = b.scratch ? ERR_OK : ERR_OUT_OF_MEMORY;
+    uint32_t matched = 0;
+
+    for (uint32_t i = 0; i < list.count && err == ERR_OK; i++) {
+        const scan_entry_t* entry = &list.entries[i];
+        const rag_file_rec_t* old = find_indexed(index, entry->path);
+
+        err = builder_add_file(&b, entry->path, &entry->st);
+        if (err != ERR_OK) break;
+
+        if (old) matched++;
+        if (old && old->size == (uint64_t)entry->st.st_size &&
+            old->mtime_ns == stat_mtime_ns(&entry->st) &&
+            old->inode == (uint64_t)entry->st.st_ino) {
+            err = builder_reuse(&b, old);
+            stats.files_reused++;
+        } else {
+            err = builder_embed_file(&b, entry->path);
+            stats.files_embedded++;
+        }
+    }
+    if (err == ERR_OK) err = builder_flush(&b);
+
+    stats.files = b.file_count;
+    stats.chunks = b.chunk_count;
+    stats.files_removed = (index->header ? index->header->file_count : 0) - matched;
+
+    // Nothing changed: keep the current file rather than rewrite it
+    bool unchanged = index->header && stats.files_embedded == 0 && stats.files_removed == 0;
+    if (err == ERR_OK && !unchanged) {
+        err = builder_write(&b);
+        if (err == ERR_OK) index_map(index);
+    }
+
+    builder_free(&b);
+    scan_list_free(&list);
+
+    if (err == ERR_OK) {
+        index->scanned = true;
+        if (out_stats) *out_stats = stats;
+    }
+    return err;
+}
+
+err_t rag_index_update(rag_index_t* index, rag_update_stats_t* out_stats) {
+    if (!index) return ERR_INVALID_ARGUMENT;
+
+    pthread_mutex_lock(&index->lock);
+    err_t err = index_update_locked(index, out_stats);
+    pthread_mutex_unlock(&index->lock);
+    return err;
+}
+
+// ============================================================================
+// Search
+// ============================================================================
+
+// Drain pending inotify events; true if anything under the workspace changed
+static bool workspace_changed(rag_index_t* index) {
+    if (!index->scanned || index->watch_fd < 0) return true;
+
+#ifdef __linux__
+    bool changed = false;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t n = read(index->watch_fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        changed = true;
+    }
+    return changed;
+#else
+    return true;
+#endif
+}
+
+static str_t read_lines(const char* data, size_t len, uint32_t start_line, uint32_t end_line) {
+    uint32_t line = 1;
+    size_t pos = 0;
+    while (line < start_line && pos < len) {
+        const char* nl = memchr(data + pos, '\n', len - pos);
+        if (!nl) return STR_NULL;
+        pos = (size_t)(nl - data) + 1;
+        line++;
+    }
+
+    size_t end = pos;
+    while (line <= end_line && end < len) {
+        const char* nl = memchr(data + end, '\n', len - end);
+        size_t next = nl ? (size_t)(nl - data) + 1 : len;
+        if (next - pos > RAG_SNIPPET_MAX_BYTES && end > pos) break;
+        end = next;
+        line++;
+    }
+    if (end - pos > RAG_SNIPPET_MAX_BYTES) {
+        // Back off continuation bytes so the cut does not split a character
+        end = pos + RAG_SNIPPET_MAX_BYTES;
+        while (end > pos && ((unsigned char)data[end] & 0xC0) == 0x80) end--;
+    }
+
+    return str_dup((str_t){ .data = data + pos, .len = (uint32_t)(end - pos) }, NULL);
+}
+
+static void fill_hit(const rag_index_t* index, uint32_t chunk, float score, rag_hit_t* hit) {
+    const rag_chunk_rec_t* rec = &index->chunks[chunk];
+    const rag_file_rec_t* file = &index->files[rec->file];
+    const char* path = indexed_path(index, file);
+
+    hit->path = str_dup_cstr(path, NULL);
+    hit->start_line = rec->start_line;
+    hit->end_line = rec->end_line;
+    hit->score = score;
+    hit->stale = true;
+
+    char full[4096];
+    snprintf(full, sizeof(full), "%s/%s", index->root, path);
+
+    struct stat st;
+    if (stat(full, &st) == 0) {
+        hit->stale = (uint64_t)st.st_size != file->size || stat_mtime_ns(&st) != file->mtime_ns;
+    }
+
+    char* data = NULL;
+    size_t len = 0;
+    if (read_file(full, &data, &len)) {
+        hit->snippet = read_lines(data, len, rec->start_line, rec->end_line);
+        free(data);
+    }
+}
+
+err_t rag_index_search(rag_index_t* index, str_t query, uint32_t limit, str_t path_prefix,
+                       rag_hit_t** out_hits, uint32_t* out_count) {
+    if (!index || !out_hits || !out_count) return ERR_INVALID_ARGUMENT;
+    if (str_empty(query)) return ERROR_SET(ERR_INVALID_ARGUMENT, "empty search query");
+
+    if (limit == 0) limit = 5;
+    if (limit > RAG_MAX_RESULTS) limit = RAG_MAX_RESULTS;
+    *out_hits = NULL;
+    *out_count = 0;
+
+    pthread_mutex_lock(&index->lock);
+
+    err_t err = ERR_OK;
+    if (workspace_changed(index)) {
+        err = index_update_locked(index, NULL);
+    }
+    if (err != ERR_OK || !index->header || index->header->chunk_count == 0) {
+        pthread_mutex_unlock(&index->lock);
+        return err;
+    }
+
+    uint32_t dims = index->embedder->dimensions;
+    float* q = malloc(sizeof(float) * dims);
+    bool* in_scope = calloc(index->header->file_count, sizeof(bool));
+    if (!q || !in_scope) {
+        free(q);
+        free(in_scope);
+        pthread_mutex_unlock(&index->lock);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    err = index->embedder->embed(index->embedder, &query, 1, q);
+    if (err == ERR_OK) normalize(q, dims);
+
+    for (uint32_t f = 0; f < index->header->file_count; f++) {
+        in_scope[f] = str_empty(path_prefix) ||
+            strncmp(indexed_path(index, &index->files[f]), path_prefix.data, path_prefix.len) == 0;
+    }
+
+    // Brute-force scan keeping the best `limit` chunks in descending order
+    uint32_t best[RAG_MAX_RESULTS];
+    float best_score[RAG_MAX_RESULTS];
+    uint32_t found = 0;
+
+    for (uint32_t c = 0; err == ERR_OK && c < index->header->chunk_count; c++) {
+        const rag_chunk_rec_t* rec = &index->chunks[c];
+        if (!in_scope[rec->file]) continue;
+
+        const int8_t* v = index->vectors + (size_t)c * dims;
+        float dot = 0;
+        for (uint32_t d = 0; d < dims; d++) dot += q[d] * v[d];
+        float score = dot * rec->scale;
+
+        if (found == limit && score <= best_score[found - 1]) continue;
+
+        uint32_t pos = found < limit ? found++ : limit - 1;
+        while (pos > 0 && best_score[pos - 1] < score) {
+            best[pos] = best[pos - 1];
+            best_score[pos] = best_score[pos - 1];
+            pos--;
+        }
+        best[pos] = c;
+        best_score[pos] = score;
+    }
+
+    rag_hit_t* hits = NULL;
+    if (err == ERR_OK && found > 0) {
+        hits = calloc(found, sizeof(rag_hit_t));
+        if (!hits) err = ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; err == ERR_OK && i < found; i++) {
+        fill_hit(index, best[i], best_score[i], &hits[i]);
+    }
+
+    pthread_mutex_unlock(&index->lock);
+    free(q);
+    free(in_scope);
+
+    if (err != ERR_OK) {
+        rag_hits_free(hits, found);
+        return err;
+    }
+    *out_hits = hits;
+    *out_count = found;
+    return ERR_OK;
+}
+
+void rag_hits_free(rag_hit_t* hits, uint32_t count) {
+    if (!hits) return;
+
+    for (uint32_t i = 0; i < count; i++) {
+        free((void*)hits[i].path.data);
+        free((void*)hits[i].snippet.data);
+    }
+    free(hits);
+}
+
+// ============================================================================
+// Configured defaults
+// ============================================================================
+
+static struct {
+    pthread_mutex_t lock;
+    str_t workspace;
+    str_t provider;
+    str_t model;
+    str_t api_key;
+    uint32_t dimensions;
+    uint32_t chunk_tokens;
+} g_rag = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void settings_clear(void) {
+    free((void*)g_rag.workspace.data);
+    free((void*)g_rag.provider.data);
+    free((void*)g_rag.model.data);
+    free((void*)g_rag.api_key.data);
+    g_rag.workspace = g_rag.provider = g_rag.model = g_rag.api_key = STR_NULL;
+    g_rag.dimensions = 0;
+    g_rag.chunk_tokens = 0;
+}
+
+void rag_configure(const config_t* config) {
+    if (!config) return;
+
+    str_t api_key = config_get_api_key_for_provider((config_t*)config, config->memory.embedding_provider);
+    if (str_empty(api_key)) api_key = config->api_key;
+
+    pthread_mutex_lock(&g_rag.lock);
+    settings_clear();
+    g_rag.workspace = str_dup(config->workspace_dir, NULL);
+    g_rag.provider = str_dup(config->memory.embedding_provider, NULL);
+    g_rag.model = str_dup(config->memory.embedding_model, NULL);
+    g_rag.api_key = str_dup(api_key, NULL);
+    g_rag.dimensions = config->memory.embedding_dimensions;
+    g_rag.chunk_tokens = config->memory.chunk_max_tokens;
+    pthread_mutex_unlock(&g_rag.lock);
+}
+
+void rag_shutdown(void) {
+    pthread_mutex_lock(&g_rag.lock);
+    settings_clear();
+    pthread_mutex_unlock(&g_rag.lock);
+}
+
+err_t rag_index_open_configured(str_t root, rag_index_t** out_index) {
+    if (!out_index) return ERR_INVALID_ARGUMENT;
+
+    pthread_mutex_lock(&g_rag.lock);
+    rag_embedder_t* embedder = NULL;
+    err_t err = embedder_create(g_rag.provider, g_rag.model, g_rag.api_key, g_rag.dimensions,
+                                &embedder);
+    str_t workspace = str_dup(str_empty(root) ? g_rag.workspace : root, NULL);
+    uint32_t chunk_tokens = g_rag.chunk_tokens;
+    pthread_mutex_unlock(&g_rag.lock);
+
+    if (err == ERR_OK && str_empty(workspace)) {
+        rag_embedder_free(embedder);
+        err = ERROR_SET(ERR_CONFIG_MISSING, "no workspace directory to index");
+    } else if (err == ERR_OK) {
+        err = rag_index_open(workspace, chunk_tokens, embedder, out_index);
+    }
+    free((void*)workspace.data);
+    return err;
+}
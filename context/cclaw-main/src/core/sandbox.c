@@ -0,0 +1,1241 @@
+// sandbox.c - Namespace sandbox for tool execution in CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/sandbox.h"
+#include "core/str_builder.h"
+#include "utils/clock.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// Namespaces, pivot_root and seccomp are Linux-only, and the seccomp filter
+// is written for the syscall tables of these two architectures. Elsewhere
+// sandbox_create() fails and tools keep running in-process.
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SANDBOX_SUPPORTED 1
+#else
+#define SANDBOX_SUPPORTED 0
+#endif
+
+#if SANDBOX_SUPPORTED
+
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <net/if.h>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <linux/audit.h>
+#include <linux/capability.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+#define SANDBOX_HOSTNAME "cclaw-sandbox"
+#define SANDBOX_DEFAULT_PIDS 256
+#define SANDBOX_CHUNK 16384
+#define SANDBOX_READY_TIMEOUT_MS 10000
+#define SANDBOX_FILE_TIMEOUT_MS 30000
+#define SANDBOX_GRACE_MS 2000       // Past a command's timeout before the caller gives up
+#define SANDBOX_STOP_GRACE_MS 500
+#define SANDBOX_ENV_PATH "PATH=/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin"
+
+#if defined(__x86_64__)
+#define SANDBOX_AUDIT_ARCH AUDIT_ARCH_X86_64
+#elif defined(__aarch64__)
+#define SANDBOX_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#endif
+
+#ifndef SECCOMP_RET_KILL_PROCESS
+#define SECCOMP_RET_KILL_PROCESS SECCOMP_RET_KILL
+#endif
+
+// System directories bound read-only into the new root. Missing ones are
+// skipped and symlinks (merged /usr) are recreated as symlinks.
+static const char* const g_system_dirs[] = {
+    "/usr", "/bin", "/sbin", "/lib", "/lib32", "/lib64", "/libx32", "/etc",
+};
+
+static const char* const g_device_nodes[] = {
+    "/dev/null", "/dev/zero", "/dev/full", "/dev/random", "/dev/urandom",
+};
+
+typedef enum sandbox_op_t {
+    SANDBOX_OP_EXEC = 1,
+    SANDBOX_OP_READ,
+    SANDBOX_OP_WRITE,
+} sandbox_op_t;
+
+// One message on the control socket: the argument (command or path)
+// follows, and the caller's end of a fresh socketpair rides along as
+// SCM_RIGHTS. Everything else about the call goes over that socket.
+typedef struct sandbox_request_t {
+    uint32_t op;
+    uint32_t timeout_ms;
+    uint64_t max_bytes;             // Output or file size limit
+    uint32_t allow_overwrite;
+    uint32_t arg_len;
+} sandbox_request_t;
+
+// The per-call socket carries records: a header, then len bytes. Workers
+// send any number of DATA records and end with one STATUS record.
+enum { RECORD_DATA = 1, RECORD_STATUS = 2 };
+
+typedef struct record_header_t {
+    uint32_t type;
+    uint32_t len;
+} record_header_t;
+
+typedef struct sandbox_status_t {
+    int32_t err;
+    int32_t exit_code;
+    int32_t term_signal;
+    uint8_t timed_out;
+    uint8_t truncated;
+} sandbox_status_t;
+
+// Sent once by the zygote, when it is ready for requests or has given up
+typedef struct sandbox_ready_t {
+    int32_t err;
+    uint8_t cgroup;
+    char message[160];
+} sandbox_ready_t;
+
+// Everything the zygote needs, resolved before fork()
+typedef struct zygote_plan_t {
+    const sandbox_config_t* config;
+    char root[PATH_MAX];            // Empty directory the new root is mounted on
+    char workspace[PATH_MAX];
+    char home[PATH_MAX];            // Empty unless config->home_writable
+    char** roots;                   // Resolved extra roots
+    uint32_t root_count;
+    char cgroup[PATH_MAX];          // Empty when limits fall back to rlimits
+    uid_t uid;
+    gid_t gid;
+    pid_t parent;
+} zygote_plan_t;
+
+struct sandbox_t {
+    pid_t pid;                      // Outer zygote process
+    int control;                    // SOCK_SEQPACKET; atomic messages, so no lock
+    bool cgroup;
+    char cgroup_path[PATH_MAX];     // Removed on destroy
+    char workspace[PATH_MAX];
+};
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+// -1 (wait forever) for UINT64_MAX
+static int remaining_ms(uint64_t deadline) {
+    if (deadline == UINT64_MAX) return -1;
+    uint64_t now = clock_monotonic_ms();
+    return now >= deadline ? 0 : (int)(deadline - now);
+}
+
+static bool send_all(int fd, const void* data, size_t len) {
+    const char* p = data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Reads exactly len bytes unless EOF or the deadline comes first; returns
+// the number of bytes read, or -1 on error or timeout
+static ssize_t recv_exact(int fd, void* data, size_t len, uint64_t deadline) {
+    char* p = data;
+    size_t got = 0;
+    while (got < len) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, remaining_ms(deadline));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return -1;
+
+        ssize_t n = recv(fd, p + got, len - got, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+static bool send_record(int fd, uint32_t type, const void* data, uint32_t len) {
+    record_header_t header = { .type = type, .len = len };
+    return send_all(fd, &header, sizeof(header)) && (len == 0 || send_all(fd, data, len));
+}
+
+static bool send_status(int fd, const sandbox_status_t* status) {
+    return send_record(fd, RECORD_STATUS, status, sizeof(*status));
+}
+
+static err_t err_from_errno(int error) {
+    switch (error) {
+        case ENOENT: case ENOTDIR: return ERR_FILE_NOT_FOUND;
+        case EACCES: case EPERM: return ERR_PERMISSION_DENIED;
+        case EROFS: return ERR_READ_ONLY;
+        case EEXIST: return ERR_FILE_EXISTS;
+        case EFBIG: return ERR_FILE_TOO_LARGE;
+        case ENOSPC: case EDQUOT: return ERR_WRITE_FAILED;
+        default: return ERR_IO;
+    }
+}
+
+// Writes a short string to a /proc or cgroup file
+static bool write_text(const char* path, const char* text) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    size_t len = strlen(text);
+    bool ok = write(fd, text, len) == (ssize_t)len;
+    close(fd);
+    return ok;
+}
+
+static bool mkdir_p(const char* path, mode_t mode) {
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s", path) >= (int)sizeof(tmp)) return false;
+
+    for (char* p = tmp + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(tmp, mode) != 0 && errno != EEXIST) return false;
+        *p = '/';
+    }
+    return mkdir(tmp, mode) == 0 || errno == EEXIST;
+}
+
+// ============================================================================
+// Zygote: namespaces, the new root and the lockdown
+// ============================================================================
+
+static void zygote_fail(int control, const char* step) {
+    sandbox_ready_t ready = { .err = ERR_SANDBOX_FAILED };
+    snprintf(ready.message, sizeof(ready.message), "%s: %s", step, strerror(errno));
+    send(control, &ready, sizeof(ready), MSG_NOSIGNAL);
+    _exit(1);
+}
+
+// Keep only stdio (pointed at /dev/null) and the control socket, as fd 3
+static int isolate_fds(int control) {
+    if (control != 3) {
+        if (dup2(control, 3) < 0) return -1;
+        control = 3;
+    }
+    if (syscall(SYS_close_range, 4U, ~0U, 0) != 0) {
+        for (int fd = 4; fd < 1024; fd++) close(fd);
+    }
+
+    int devnull = open("/dev/null", O_RDWR | O_CLOEXEC);
+    if (devnull >= 0) {
+        dup2(devnull, STDIN_FILENO);
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        if (devnull > 3) close(devnull);
+    }
+    return control;
+}
+
+// Moves the zygote into its own cgroup; every worker inherits it
+static bool join_cgroup(const zygote_plan_t* plan) {
+    const sandbox_config_t* config = plan->config;
+    char path[PATH_MAX + 32];
+    char value[64];
+
+    if (mkdir(plan->cgroup, 0755) != 0 && errno != EEXIST) return false;
+
+    if (config->memory_limit_mb) {
+        snprintf(value, sizeof(value), "%llu", (unsigned long long)config->memory_limit_mb << 20);
+        snprintf(path, sizeof(path), "%s/memory.max", plan->cgroup);
+        if (!write_text(path, value)) return false;
+    }
+    if (config->cpu_limit > 0) {
+        snprintf(value, sizeof(value), "%lld 100000", (long long)(config->cpu_limit * 100000));
+        snprintf(path, sizeof(path), "%s/cpu.max", plan->cgroup);
+        if (!write_text(path, value)) return false;
+    }
+    snprintf(value, sizeof(value), "%u",
+             config->max_processes ? config->max_processes : SANDBOX_DEFAULT_PIDS);
+    snprintf(path, sizeof(path), "%s/pids.max", plan->cgroup);
+    if (!write_text(path, value)) return false;
+
+    snprintf(path, sizeof(path), "%s/cgroup.procs", plan->cgroup);
+    return write_text(path, "0");
+}
+
+static bool map_ids(const zygote_plan_t* plan) {
+    char map[64];
+    if (!write_text("/proc/self/setgroups", "deny") && errno != ENOENT) return false;
+    snprintf(map, sizeof(map), "%u %u 1", (unsigned)plan->uid, (unsigned)plan->uid);
+    if (!write_text("/proc/self/uid_map", map)) return false;
+    snprintf(map, sizeof(map), "%u %u 1", (unsigned)plan->gid, (unsigned)plan->gid);
+    return write_text("/proc/self/gid_map", map);
+}
+
+// Bind mount and remount with the wanted flags. Flags locked by the outer
+// mount (nosuid, nodev, noexec, atime) have to be carried over or the
+// remount is refused inside a user namespace.
+static bool bind_path(const char* source, const char* target, bool read_only) {
+    if (mount(source, target, NULL, MS_BIND | MS_REC, NULL) != 0) return false;
+
+    struct statvfs vfs;
+    if (statvfs(target, &vfs) != 0) return false;
+
+    unsigned long flags = MS_BIND | MS_REMOUNT | MS_NOSUID;
+    if (read_only || (vfs.f_flag & ST_RDONLY)) flags |= MS_RDONLY;
+    if (vfs.f_flag & ST_NODEV) flags |= MS_NODEV;
+    if (vfs.f_flag & ST_NOEXEC) flags |= MS_NOEXEC;
+    if (vfs.f_flag & ST_NOATIME) flags |= MS_NOATIME;
+    if (vfs.f_flag & ST_NODIRATIME) flags |= MS_NODIRATIME;
+    if (vfs.f_flag & ST_RELATIME) flags |= MS_RELATIME;
+    return mount(NULL, target, NULL, flags, NULL) == 0;
+}
+
+static bool bind_system_dir(const char* root, const char* dir) {
+    char target[PATH_MAX];
+    snprintf(target, sizeof(target), "%s%s", root, dir);
+
+    struct stat st;
+    if (lstat(dir, &st) != 0) return true;
+
+    if (S_ISLNK(st.st_mode)) {
+        char link[PATH_MAX];
+        ssize_t n = readlink(dir, link, sizeof(link) - 1);
+        if (n < 0) return false;
+        link[n] = '\0';
+        return symlink(link, target) == 0;
+    }
+    if (!S_ISDIR(st.st_mode)) return true;
+    return mkdir_p(target, 0755) && bind_path(dir, target, true);
+}
+
+static bool populate_dev(const char* root) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/dev", root);
+    if (mkdir(path, 0755) != 0) return false;
+
+    for (size_t i = 0; i < sizeof(g_device_nodes) / sizeof(g_device_nodes[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", root, g_device_nodes[i]);
+        int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+        if (fd < 0) return false;
+        close(fd);
+        if (mount(g_device_nodes[i], path, NULL, MS_BIND, NULL) != 0) return false;
+    }
+
+    static const char* const links[][2] = {
+        { "/proc/self/fd", "/dev/fd" },
+        { "/proc/self/fd/0", "/dev/stdin" },
+        { "/proc/self/fd/1", "/dev/stdout" },
+        { "/proc/self/fd/2", "/dev/stderr" },
+    };
+    for (size_t i = 0; i < sizeof(links) / sizeof(links[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", root, links[i][1]);
+        if (symlink(links[i][0], path) != 0) return false;
+    }
+    return true;
+}
+
+static void loopback_up(void) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return;
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "lo");
+    if (ioctl(fd, SIOCGIFFLAGS, &ifr) == 0) {
+        ifr.ifr_flags |= IFF_UP;
+        ioctl(fd, SIOCSIFFLAGS, &ifr);
+    }
+    close(fd);
+}
+
+// Builds the new root on a tmpfs and pivots into it. Returns the failing
+// step, or NULL.
+static const char* build_root(const zygote_plan_t* plan) {
+    const char* root = plan->root;
+    char path[PATH_MAX];
+
+    if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) != 0) return "make mounts private";
+    if (mount("tmpfs", root, "tmpfs", MS_NOSUID | MS_NODEV, "mode=0755,size=16m") != 0) {
+        return "mount root tmpfs";
+    }
+
+    for (size_t i = 0; i < sizeof(g_system_dirs) / sizeof(g_system_dirs[0]); i++) {
+        if (!bind_system_dir(root, g_system_dirs[i])) return "bind system directory";
+    }
+    if (!populate_dev(root)) return "populate /dev";
+
+    // Without /proc most commands still work, so a kernel that refuses a
+    // fresh procfs (masked paths in an outer container) is not fatal
+    snprintf(path, sizeof(path), "%s/proc", root);
+    if (mkdir(path, 0555) != 0) return "create /proc";
+    mount("proc", path, "proc", MS_NOSUID | MS_NODEV | MS_NOEXEC, NULL);
+
+    snprintf(path, sizeof(path), "%s/tmp", root);
+    if (mkdir(path, 01777) != 0 ||
+        mount("tmpfs", path, "tmpfs", MS_NOSUID | MS_NODEV, "mode=1777,size=256m") != 0) {
+        return "mount /tmp";
+    }
+
+    // Workspace roots last, so they land on top of /tmp and the system
+    // directories when nested inside them. The home directory goes first,
+    // since the workspace usually lies inside it.
+    if (plan->home[0]) {
+        snprintf(path, sizeof(path), "%s%s", root, plan->home);
+        if (!mkdir_p(path, 0755) || !bind_path(plan->home, path, false)) return "bind home";
+    }
+    for (uint32_t i = 0; i <= plan->root_count; i++) {
+        const char* source = i == 0 ? plan->workspace : plan->roots[i - 1];
+        snprintf(path, sizeof(path), "%s%s", root, source);
+        if (!mkdir_p(path, 0755) || !bind_path(source, path, false)) return "bind workspace";
+    }
+
+    snprintf(path, sizeof(path), "%s/.old_root", root);
+    if (mkdir(path, 0700) != 0) return "create old root";
+    if (syscall(SYS_pivot_root, root, path) != 0) return "pivot_root";
+    if (chdir("/") != 0) return "chdir /";
+    if (umount2("/.old_root", MNT_DETACH) != 0) return "detach old root";
+    rmdir("/.old_root");
+
+    if (plan->config->read_only_rootfs &&
+        mount(NULL, "/", NULL, MS_BIND | MS_REMOUNT | MS_RDONLY | MS_NOSUID | MS_NODEV, NULL) != 0) {
+        return "remount root read-only";
+    }
+    if (chdir(plan->workspace) != 0) return "chdir workspace";
+    return NULL;
+}
+
+// Denies the syscalls that could undo the isolation or reach the host
+// kernel's more exposed interfaces
+static bool install_seccomp(void) {
+#ifdef SANDBOX_AUDIT_ARCH
+    static const int denied[] = {
+        __NR_mount, __NR_umount2, __NR_pivot_root, __NR_chroot, __NR_unshare, __NR_setns,
+        __NR_ptrace, __NR_process_vm_readv, __NR_process_vm_writev,
+        __NR_kexec_load, __NR_init_module, __NR_finit_module, __NR_delete_module,
+        __NR_bpf, __NR_perf_event_open, __NR_keyctl, __NR_add_key, __NR_request_key,
+        __NR_swapon, __NR_swapoff, __NR_reboot, __NR_acct, __NR_syslog,
+        __NR_open_by_handle_at, __NR_name_to_handle_at, __NR_userfaultfd,
+        __NR_settimeofday, __NR_clock_settime, __NR_quotactl,
+#ifdef __NR_kexec_file_load
+        __NR_kexec_file_load,
+#endif
+#ifdef __NR_fsopen
+        __NR_fsopen, __NR_fsconfig, __NR_fsmount, __NR_fspick, __NR_move_mount, __NR_open_tree,
+#endif
+#ifdef __NR_mount_setattr
+        __NR_mount_setattr,
+#endif
+#ifdef __NR_iopl
+        __NR_iopl, __NR_ioperm,
+#endif
+    };
+    const uint32_t ns_flags = CLONE_NEWNS | CLONE_NEWUSER | CLONE_NEWPID | CLONE_NEWNET |
+                              CLONE_NEWIPC | CLONE_NEWUTS | CLONE_NEWCGROUP;
+    enum { DENIED = sizeof(denied) / sizeof(denied[0]) };
+
+    struct sock_filter filter[DENIED * 2 + 16];
+    size_t n = 0;
+
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                                               offsetof(struct seccomp_data, arch));
+    filter[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SANDBOX_AUDIT_ARCH, 1, 0);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                                               offsetof(struct seccomp_data, nr));
+#ifdef __x86_64__
+    // The x32 ABI numbers every syscall again; nothing here uses it
+    filter[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, 0x40000000, 0, 1);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS);
+#endif
+    for (size_t i = 0; i < DENIED; i++) {
+        filter[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)denied[i], 0, 1);
+        filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EPERM);
+    }
+#ifdef __NR_clone3
+    // clone3 keeps its flags in memory where the filter cannot see them;
+    // ENOSYS makes libc fall back to clone
+    filter[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_clone3, 0, 1);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS);
+#endif
+    // clone is fine unless it asks for new namespaces (low word of arg 0)
+    filter[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_clone, 0, 3);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                                               offsetof(struct seccomp_data, args[0]));
+    filter[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, ns_flags, 0, 1);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EPERM);
+    filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+
+    struct sock_fprog program = { .len = (unsigned short)n, .filter = filter };
+    return prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program, 0, 0) == 0;
+#else
+    return true;
+#endif
+}
+
+// No privileges survive into workers: no_new_privs, an empty bounding set
+// (so even uid 0 inside gains nothing on exec), seccomp, then no
+// capabilities at all
+static const char* lock_down(void) {
+    if (sethostname(SANDBOX_HOSTNAME, sizeof(SANDBOX_HOSTNAME) - 1) != 0) return "sethostname";
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) return "no_new_privs";
+    for (int cap = 0; cap <= 63; cap++) {
+        if (prctl(PR_CAPBSET_DROP, cap, 0, 0, 0) != 0 && errno == EINVAL) break;
+    }
+    if (!install_seccomp()) return "seccomp";
+
+    struct __user_cap_header_struct header = { .version = _LINUX_CAPABILITY_VERSION_3 };
+    struct __user_cap_data_struct data[2];
+    memset(data, 0, sizeof(data));
+    if (syscall(SYS_capset, &header, data) != 0) return "drop capabilities";
+    return NULL;
+}
+
+// ============================================================================
+// Workers: one fork of the zygote per call
+// ============================================================================
+
+static void apply_rlimits(const zygote_plan_t* plan, uint32_t timeout_ms) {
+    struct rlimit limit = { 0, 0 };
+    setrlimit(RLIMIT_CORE, &limit);
+
+    if (timeout_ms) {
+        limit.rlim_cur = timeout_ms / 1000 + 1;
+        limit.rlim_max = limit.rlim_cur + 1;
+        setrlimit(RLIMIT_CPU, &limit);
+    }
+    if (!plan->cgroup[0] && plan->config->memory_limit_mb) {
+        limit.rlim_cur = limit.rlim_max = (rlim_t)plan->config->memory_limit_mb << 20;
+        setrlimit(RLIMIT_AS, &limit);
+    }
+}
+
+// Runs the command in its own process group, streaming its output back
+// until it exits or the timeout kills the whole group
+static void worker_exec(const zygote_plan_t* plan, int conn, const sandbox_request_t* request,
+                        const char* command) {
+    sandbox_status_t status = { .err = ERR_OK, .exit_code = -1 };
+    int out[2];
+    if (pipe2(out, O_CLOEXEC) != 0) {
+        status.err = ERR_IO;
+        send_status(conn, &status);
+        return;
+    }
+
+    char home[PATH_MAX + 8];
+    snprintf(home, sizeof(home), "HOME=%s", plan->workspace);
+    char* const envp[] = { SANDBOX_ENV_PATH, home, "LANG=C.UTF-8", "TERM=dumb", "TMPDIR=/tmp", NULL };
+
+    pid_t child = fork();
+    if (child == 0) {
+        setpgid(0, 0);
+        int devnull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (devnull >= 0) dup2(devnull, STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(out[1], STDERR_FILENO);
+        apply_rlimits(plan, request->timeout_ms);
+        execle("/bin/sh", "sh", "-c", command, (char*)NULL, envp);
+        _exit(127);
+    }
+    close(out[1]);
+    if (child < 0) {
+        close(out[0]);
+        status.err = ERR_FAILED;
+        send_status(conn, &status);
+        return;
+    }
+    setpgid(child, child);
+
+    uint64_t deadline = request->timeout_ms ? clock_monotonic_ms() + request->timeout_ms : UINT64_MAX;
+    uint64_t sent = 0;
+    char buffer[SANDBOX_CHUNK];
+    bool caller_gone = false;
+
+    for (;;) {
+        struct pollfd fds[2] = {
+            { .fd = out[0], .events = POLLIN },
+            { .fd = conn, .events = 0 },        // POLLHUP once the caller gives up
+        };
+        int ready = poll(fds, 2, remaining_ms(deadline));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) {
+            status.timed_out = 1;
+            break;
+        }
+        if (ready < 0 || (fds[1].revents & (POLLHUP | POLLERR))) {
+            caller_gone = true;
+            break;
+        }
+
+        ssize_t n = read(out[0], buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        // Past the limit the output is drained and dropped, so the
+        // command does not block on a full pipe
+        size_t keep = (size_t)n;
+        if (sent + keep > request->max_bytes) {
+            keep = (size_t)(request->max_bytes - sent);
+            status.truncated = 1;
+        }
+        if (keep > 0 && !send_record(conn, RECORD_DATA, buffer, (uint32_t)keep)) {
+            caller_gone = true;
+            break;
+        }
+        sent += keep;
+    }
+    close(out[0]);
+
+    // The shell may be gone while something it started still runs
+    int wstatus = 0;
+    if (status.timed_out || caller_gone) kill(-child, SIGKILL);
+    while (waitpid(child, &wstatus, WNOHANG) == 0) {
+        if (!status.timed_out && remaining_ms(deadline) == 0) {
+            status.timed_out = 1;
+            kill(-child, SIGKILL);
+        }
+        usleep(1000);
+    }
+    kill(-child, SIGKILL);
+    if (caller_gone) return;
+
+    if (WIFEXITED(wstatus)) {
+        status.exit_code = WEXITSTATUS(wstatus);
+    } else if (WIFSIGNALED(wstatus)) {
+        status.term_signal = WTERMSIG(wstatus);
+    }
+    send_status(conn, &status);
+}
+
+static void worker_read(int conn, const sandbox_request_t* request, const char* path) {
+    sandbox_status_t status = { .err = ERR_OK };
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        status.err = err_from_errno(errno);
+    } else if (!S_ISREG(st.st_mode)) {
+        status.err = ERR_INVALID_ARGUMENT;
+    } else if ((uint64_t)st.st_size > request->max_bytes) {
+        status.err = ERR_FILE_TOO_LARGE;
+    } else {
+        char buffer[SANDBOX_CHUNK];
+        uint64_t total = 0;
+        for (;;) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                status.err = ERR_IO;
+                break;
+            }
+            if (n == 0) break;
+            total += (uint64_t)n;
+            if (total > request->max_bytes) {
+                status.err = ERR_FILE_TOO_LARGE;    // Grew while being read
+                break;
+            }
+            if (!send_record(conn, RECORD_DATA, buffer, (uint32_t)n)) return;
+        }
+    }
+    if (fd >= 0) close(fd);
+    send_status(conn, &status);
+}
+
+// Same as the native tool: a temporary file next to the target, renamed
+// over it once all content has arrived
+static void worker_write(int conn, const sandbox_request_t* request, const char* path) {
+    sandbox_status_t status = { .err = ERR_OK };
+    char temp_path[PATH_MAX + 8];
+
+    if (!request->allow_overwrite && access(path, F_OK) == 0) {
+        status.err = ERR_FILE_EXISTS;
+        send_status(conn, &status);
+        return;
+    }
+    if (snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", path) >= (int)sizeof(temp_path)) {
+        status.err = ERR_INVALID_ARGUMENT;
+        send_status(conn, &status);
+        return;
+    }
+
+    int fd = mkstemp(temp_path);
+    if (fd < 0) {
+        status.err = err_from_errno(errno);
+        send_status(conn, &status);
+        return;
+    }
+
+    char buffer[SANDBOX_CHUNK];
+    uint64_t total = 0;
+    uint64_t deadline = clock_monotonic_ms() + SANDBOX_FILE_TIMEOUT_MS;
+    for (;;) {
+        ssize_t n = recv_exact(conn, buffer, sizeof(buffer), deadline);
+        if (n < 0) {
+            status.err = ERR_IO;
+            break;
+        }
+        if (n == 0) break;
+        total += (uint64_t)n;
+        if (total > request->max_bytes) {
+            status.err = ERR_FILE_TOO_LARGE;
+            break;
+        }
+        if (write(fd, buffer, (size_t)n) != n) {
+            status.err = err_from_errno(errno);
+            break;
+        }
+        if ((size_t)n < sizeof(buffer)) break;
+    }
+
+    if (close(fd) != 0 && status.err == ERR_OK) status.err = ERR_IO;
+    if (status.err == ERR_OK && rename(temp_path, path) != 0) status.err = err_from_errno(errno);
+    if (status.err != ERR_OK) unlink(temp_path);
+    send_status(conn, &status);
+}
+
+// ============================================================================
+// Zygote main loop
+// ============================================================================
+
+static void zygote_serve(const zygote_plan_t* plan, int control) {
+    static char message[sizeof(sandbox_request_t) + SANDBOX_MAX_ARG_LEN + 1];
+
+    for (;;) {
+        struct pollfd pfd = { .fd = control, .events = POLLIN };
+        int ready = poll(&pfd, 1, 1000);
+
+        // As pid 1 of the namespace the zygote also reaps orphans
+        while (waitpid(-1, NULL, WNOHANG) > 0) {}
+        if (ready <= 0) continue;
+
+        char cmsg_buffer[CMSG_SPACE(sizeof(int))];
+        struct iovec iov = { .iov_base = message, .iov_len = sizeof(message) - 1 };
+        struct msghdr msg = {
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = cmsg_buffer,
+            .msg_controllen = sizeof(cmsg_buffer),
+        };
+        ssize_t n = recvmsg(control, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) _exit(0);       // Caller closed the sandbox or died
+
+        int conn = -1;
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&conn, CMSG_DATA(cmsg), sizeof(int));
+        }
+        if (conn < 0) continue;
+
+        sandbox_request_t request;
+        if ((size_t)n < sizeof(request)) {
+            close(conn);
+            continue;
+        }
+        memcpy(&request, message, sizeof(request));
+        if (request.arg_len != (size_t)n - sizeof(request)) {
+            close(conn);
+            continue;
+        }
+        char* arg = message + sizeof(request);
+        arg[request.arg_len] = '\0';
+
+        pid_t worker = fork();
+        if (worker == 0) {
+            close(control);
+            switch (request.op) {
+                case SANDBOX_OP_EXEC: worker_exec(plan, conn, &request, arg); break;
+                case SANDBOX_OP_READ: worker_read(conn, &request, arg); break;
+                case SANDBOX_OP_WRITE: worker_write(conn, &request, arg); break;
+                default: {
+                    sandbox_status_t status = { .err = ERR_INVALID_ARGUMENT };
+                    send_status(conn, &status);
+                }
+            }
+            _exit(0);
+        }
+        if (worker < 0) {
+            sandbox_status_t status = { .err = ERR_FAILED };
+            send_status(conn, &status);
+        }
+        close(conn);
+    }
+}
+
+// Runs in the fork of the caller: enters the namespaces, then forks again
+// so the zygote is pid 1 of the new pid namespace
+static void zygote_main(const zygote_plan_t* plan, int control) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+    if (getppid() != plan->parent) _exit(1);
+    setsid();
+    control = isolate_fds(control);
+    if (control < 0) _exit(1);
+
+    bool cgroup = plan->cgroup[0] && join_cgroup(plan);
+
+    int flags = CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWPID | CLONE_NEWIPC | CLONE_NEWUTS;
+    if (!plan->config->network) flags |= CLONE_NEWNET;
+    if (unshare(flags) != 0) zygote_fail(control, "unshare");
+    if (!map_ids(plan)) zygote_fail(control, "write id maps");
+
+    pid_t zygote = fork();
+    if (zygote < 0) zygote_fail(control, "fork");
+    if (zygote > 0) {
+        close(control);
+        int status = 0;
+        while (waitpid(zygote, &status, 0) < 0 && errno == EINTR) {}
+        _exit(0);
+    }
+
+    prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+    const char* step = build_root(plan);
+    if (step) zygote_fail(control, step);
+    if (!plan->config->network) loopback_up();
+    step = lock_down();
+    if (step) zygote_fail(control, step);
+
+    sandbox_ready_t ready = { .err = ERR_OK, .cgroup = cgroup };
+    if (send(control, &ready, sizeof(ready), MSG_NOSIGNAL) != sizeof(ready)) _exit(1);
+    zygote_serve(plan, control);
+    _exit(0);
+}
+
+#endif // SANDBOX_SUPPORTED
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+sandbox_config_t sandbox_config_from(const config_t* config, str_t workspace_dir) {
+    sandbox_config_t sandbox_config = {
+        .workspace_dir = workspace_dir,
+        .read_only_rootfs = true,
+    };
+    if (!config) return sandbox_config;
+
+    sandbox_config.extra_roots = config->runtime.docker.allowed_workspace_roots;
+    sandbox_config.extra_root_count = config->runtime.docker.allowed_workspace_roots_count;
+    sandbox_config.home_writable = !config->autonomy.workspace_only;
+    sandbox_config.read_only_rootfs = config->runtime.docker.read_only_rootfs;
+    sandbox_config.network = !str_empty(config->runtime.docker.network) &&
+                             !str_equal_cstr(config->runtime.docker.network, "none");
+    sandbox_config.memory_limit_mb = config->runtime.docker.memory_limit_mb;
+    sandbox_config.cpu_limit = config->runtime.docker.cpu_limit;
+    sandbox_config.max_processes = config->runtime.sandbox.max_processes;
+    sandbox_config.cgroup_dir = config->runtime.sandbox.cgroup_dir;
+    return sandbox_config;
+}
+
+#if SANDBOX_SUPPORTED
+
+static err_t resolve_dir(str_t dir, char out[PATH_MAX]) {
+    char path[PATH_MAX];
+    if (str_empty(dir) || dir.len >= sizeof(path)) return ERR_INVALID_ARGUMENT;
+    memcpy(path, dir.data, dir.len);
+    path[dir.len] = '\0';
+
+    struct stat st;
+    if (!realpath(path, out) || stat(out, &st) != 0) {
+        return ERROR_SET(ERR_NOT_FOUND, "sandbox: %s: %s", path, strerror(errno));
+    }
+    if (!S_ISDIR(st.st_mode)) return ERROR_SET(ERR_INVALID_ARGUMENT, "sandbox: %s is not a directory", path);
+    return ERR_OK;
+}
+
+static void plan_free(zygote_plan_t* plan) {
+    for (uint32_t i = 0; i < plan->root_count; i++) free(plan->roots[i]);
+    free(plan->roots);
+    if (plan->root[0]) rmdir(plan->root);
+    free(plan);
+}
+
+static err_t plan_create(const sandbox_config_t* config, zygote_plan_t** out_plan) {
+    static uint32_t counter;
+
+    zygote_plan_t* plan = calloc(1, sizeof(zygote_plan_t));
+    if (!plan) return ERR_OUT_OF_MEMORY;
+    plan->config = config;
+    plan->uid = getuid();
+    plan->gid = getgid();
+    plan->parent = getpid();
+
+    err_t err = resolve_dir(config->workspace_dir, plan->workspace);
+    const char* home = getenv("HOME");
+    if (err == ERR_OK && config->home_writable && home && *home) {
+        err = resolve_dir(STR_VIEW(home), plan->home);
+    }
+    if (err == ERR_OK && config->extra_root_count > 0) {
+        plan->roots = calloc(config->extra_root_count, sizeof(char*));
+        if (!plan->roots) err = ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; err == ERR_OK && i < config->extra_root_count; i++) {
+        plan->roots[i] = malloc(PATH_MAX);
+        if (!plan->roots[i]) {
+            err = ERR_OUT_OF_MEMORY;
+            break;
+        }
+        plan->root_count++;
+        err = resolve_dir(config->extra_roots[i], plan->roots[i]);
+    }
+
+    if (err == ERR_OK) {
+        const char* tmp = getenv("TMPDIR");
+        snprintf(plan->root, sizeof(plan->root), "%s/cclaw-sandbox-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+        if (!mkdtemp(plan->root)) {
+            plan->root[0] = '\0';
+            err = ERROR_SET(ERR_IO, "sandbox: cannot create root mount point: %s", strerror(errno));
+        }
+    }
+
+    if (err == ERR_OK && !str_empty(config->cgroup_dir)) {
+        uint32_t id = __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+        snprintf(plan->cgroup, sizeof(plan->cgroup), "%.*s/cclaw-sandbox-%d-%u",
+                 (int)config->cgroup_dir.len, config->cgroup_dir.data, (int)plan->parent, id);
+    }
+
+    if (err != ERR_OK) {
+        plan_free(plan);
+        return err;
+    }
+    *out_plan = plan;
+    return ERR_OK;
+}
+
+// Wait up to timeout_ms for the zygote to exit by itself
+static bool reap_within(pid_t pid, uint32_t timeout_ms) {
+    for (uint32_t waited = 0;; waited += 10) {
+        pid_t r = waitpid(pid, NULL, WNOHANG);
+        if (r == pid || (r < 0 && errno != EINTR)) return true;
+        if (waited >= timeout_ms) return false;
+        usleep(10 * 1000);
+    }
+}
+
+err_t sandbox_create(const sandbox_config_t* config, sandbox_t** out_sandbox) {
+    if (!config || !out_sandbox || str_empty(config->workspace_dir)) return ERR_INVALID_ARGUMENT;
+
+    zygote_plan_t* plan = NULL;
+    err_t err = plan_create(config, &plan);
+    if (err != ERR_OK) return err;
+
+    sandbox_t* sandbox = calloc(1, sizeof(sandbox_t));
+    int sv[2] = { -1, -1 };
+    if (!sandbox) {
+        plan_free(plan);
+        return ERR_OUT_OF_MEMORY;
+    }
+    sandbox->pid = -1;
+    sandbox->control = -1;
+    snprintf(sandbox->cgroup_path, sizeof(sandbox->cgroup_path), "%s", plan->cgroup);
+    snprintf(sandbox->workspace, sizeof(sandbox->workspace), "%s", plan->workspace);
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) != 0) {
+        err = ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: socketpair: %s", strerror(errno));
+    }
+
+    if (err == ERR_OK) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(sv[0]);
+            zygote_main(plan, sv[1]);
+            _exit(1);
+        }
+        if (pid < 0) {
+            err = ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: fork: %s", strerror(errno));
+        } else {
+            sandbox->pid = pid;
+            sandbox->control = sv[0];
+            sv[0] = -1;
+        }
+        close(sv[1]);
+    }
+
+    if (err == ERR_OK) {
+        sandbox_ready_t ready;
+        memset(&ready, 0, sizeof(ready));
+        struct pollfd pfd = { .fd = sandbox->control, .events = POLLIN };
+        int n = poll(&pfd, 1, SANDBOX_READY_TIMEOUT_MS);
+        ssize_t got = n > 0 ? recv(sandbox->control, &ready, sizeof(ready), 0) : -1;
+        if (got != sizeof(ready)) {
+            err = ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: zygote did not start");
+        } else if (ready.err != ERR_OK) {
+            ready.message[sizeof(ready.message) - 1] = '\0';
+            err = ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: %s", ready.message);
+        } else {
+            sandbox->cgroup = ready.cgroup != 0;
+        }
+    }
+
+    // The mount point is only used inside the zygote's mount namespace;
+    // here it is an empty directory again
+    plan_free(plan);
+    if (!sandbox->cgroup && sandbox->cgroup_path[0]) {
+        rmdir(sandbox->cgroup_path);
+        sandbox->cgroup_path[0] = '\0';
+    }
+
+    if (err != ERR_OK) {
+        if (sv[0] >= 0) close(sv[0]);
+        sandbox_destroy(sandbox);
+        return err;
+    }
+    *out_sandbox = sandbox;
+    return ERR_OK;
+}
+
+void sandbox_destroy(sandbox_t* sandbox) {
+    if (!sandbox) return;
+
+    // EOF on the control socket stops the zygote; pid 1 exiting takes
+    // every worker in the namespace with it
+    if (sandbox->control >= 0) close(sandbox->control);
+    if (sandbox->pid > 0 && !reap_within(sandbox->pid, SANDBOX_STOP_GRACE_MS)) {
+        kill(sandbox->pid, SIGKILL);
+        waitpid(sandbox->pid, NULL, 0);
+    }
+    if (sandbox->cgroup_path[0]) {
+        for (int i = 0; i < 50 && rmdir(sandbox->cgroup_path) != 0 && errno == EBUSY; i++) {
+            usleep(10 * 1000);
+        }
+    }
+    free(sandbox);
+}
+
+bool sandbox_uses_cgroup(const sandbox_t* sandbox) {
+    return sandbox && sandbox->cgroup;
+}
+
+// One call: hands the zygote a request and a socket, streams data in,
+// collects DATA records into out_data and returns the final status
+static err_t sandbox_call(sandbox_t* sandbox, sandbox_op_t op, const char* arg,
+                          uint32_t timeout_ms, uint64_t max_bytes, bool allow_overwrite,
+                          const char* data, size_t data_len,
+                          str_builder_t* out_data, sandbox_status_t* out_status) {
+    size_t arg_len = strlen(arg);
+    if (arg_len > SANDBOX_MAX_ARG_LEN) return ERR_INVALID_ARGUMENT;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) return ERR_IO;
+
+    sandbox_request_t request = {
+        .op = op,
+        .timeout_ms = timeout_ms,
+        .max_bytes = max_bytes,
+        .allow_overwrite = allow_overwrite,
+        .arg_len = (uint32_t)arg_len,
+    };
+    struct iovec iov[2] = {
+        { .iov_base = &request, .iov_len = sizeof(request) },
+        { .iov_base = (void*)arg, .iov_len = arg_len },
+    };
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = 2,
+        .msg_control = control.buffer,
+        .msg_controllen = sizeof(control.buffer),
+    };
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fds[1], sizeof(int));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(sandbox->control, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    close(fds[1]);
+    if (sent < 0) {
+        close(fds[0]);
+        return ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: zygote is gone: %s", strerror(errno));
+    }
+
+    // A worker that refuses early (file exists) closes without reading;
+    // its status is still waiting in the socket
+    if (data) {
+        send_all(fds[0], data, data_len);
+        shutdown(fds[0], SHUT_WR);
+    }
+
+    // Commands without a timeout are waited for as long as they run
+    uint64_t deadline = timeout_ms ? clock_monotonic_ms() + timeout_ms + SANDBOX_GRACE_MS
+                      : op == SANDBOX_OP_EXEC ? UINT64_MAX
+                      : clock_monotonic_ms() + SANDBOX_FILE_TIMEOUT_MS;
+    err_t err = ERR_OK;
+    char buffer[SANDBOX_CHUNK];
+    for (;;) {
+        record_header_t header;
+        ssize_t n = recv_exact(fds[0], &header, sizeof(header), deadline);
+        if (n != sizeof(header)) {
+            err = n < 0 && remaining_ms(deadline) == 0
+                ? ERR_TIMEOUT
+                : ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: worker exited without a status");
+            break;
+        }
+        if (header.type == RECORD_STATUS && header.len == sizeof(*out_status)) {
+            if (recv_exact(fds[0], out_status, sizeof(*out_status), deadline) != sizeof(*out_status)) {
+                err = ERR_SANDBOX_FAILED;
+            }
+            break;
+        }
+        if (header.type != RECORD_DATA || header.len > sizeof(buffer)) {
+            err = ERROR_SET(ERR_SANDBOX_FAILED, "sandbox: malformed worker record");
+            break;
+        }
+        if (recv_exact(fds[0], buffer, header.len, deadline) != (ssize_t)header.len) {
+            err = ERR_SANDBOX_FAILED;
+            break;
+        }
+        if (out_data) str_builder_append_bytes(out_data, buffer, header.len);
+    }
+
+    close(fds[0]);
+    if (err == ERR_OK && out_data && out_data->failed) err = ERR_OUT_OF_MEMORY;
+    return err;
+}
+
+err_t sandbox_exec(sandbox_t* sandbox, const char* command, uint32_t timeout_ms,
+                   size_t max_output, sandbox_result_t* out_result) {
+    if (!sandbox || !command || !out_result) return ERR_INVALID_ARGUMENT;
+    memset(out_result, 0, sizeof(*out_result));
+
+    str_builder_t output;
+    str_builder_init(&output, NULL);
+    sandbox_status_t status = { .err = ERR_OK };
+    err_t err = sandbox_call(sandbox, SANDBOX_OP_EXEC, command, timeout_ms, max_output, false,
+                             NULL, 0, &output, &status);
+    if (err == ERR_OK) err = (err_t)status.err;
+
+    if (err != ERR_OK) {
+        str_builder_free(&output);
+        return err;
+    }
+
+    str_t text = str_builder_finish(&output, NULL);
+    if (!text.data) return ERR_OUT_OF_MEMORY;
+    out_result->output = (char*)text.data;
+    out_result->output_len = text.len;
+    out_result->exit_code = status.term_signal ? -1 : status.exit_code;
+    out_result->term_signal = status.term_signal;
+    out_result->timed_out = status.timed_out != 0;
+    out_result->truncated = status.truncated != 0;
+    return ERR_OK;
+}
+
+// Paths inside the sandbox are the same as outside, except that the
+// zygote's working directory is the workspace
+static err_t absolute_path(const char* path, char out[PATH_MAX]) {
+    if (path[0] == '/') {
+        return snprintf(out, PATH_MAX, "%s", path) < PATH_MAX ? ERR_OK : ERR_INVALID_ARGUMENT;
+    }
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) return ERR_IO;
+    return snprintf(out, PATH_MAX, "%s/%s", cwd, path) < PATH_MAX ? ERR_OK : ERR_INVALID_ARGUMENT;
+}
+
+err_t sandbox_read_file(sandbox_t* sandbox, const char* path, size_t max_size,
+                        char** out_data, size_t* out_len) {
+    if (!sandbox || !path || !out_data || !out_len) return ERR_INVALID_ARGUMENT;
+
+    char absolute[PATH_MAX];
+    err_t err = absolute_path(path, absolute);
+    if (err != ERR_OK) return err;
+
+    str_builder_t data;
+    str_builder_init(&data, NULL);
+    sandbox_status_t status = { .err = ERR_OK };
+    err = sandbox_call(sandbox, SANDBOX_OP_READ, absolute, 0, max_size, false, NULL, 0, &data, &status);
+    if (err == ERR_OK) err = (err_t)status.err;
+    if (err != ERR_OK) {
+        str_builder_free(&data);
+        return err;
+    }
+
+    str_t text = str_builder_finish(&data, NULL);
+    if (!text.data) return ERR_OUT_OF_MEMORY;
+    *out_data = (char*)text.data;
+    *out_len = text.len;
+    return ERR_OK;
+}
+
+err_t sandbox_write_file(sandbox_t* sandbox, const char* path, const char* data, size_t len,
+                         bool allow_overwrite) {
+    if (!sandbox || !path || (!data && len > 0)) return ERR_INVALID_ARGUMENT;
+
+    char absolute[PATH_MAX];
+    err_t err = absolute_path(path, absolute);
+    if (err != ERR_OK) return err;
+
+    sandbox_status_t status = { .err = ERR_OK };
+    err = sandbox_call(sandbox, SANDBOX_OP_WRITE, absolute, 0, len, allow_overwrite,
+                       data ? data : "", len, NULL, &status);
+    return err == ERR_OK ? (err_t)status.err : err;
+}
+
+#else // !SANDBOX_SUPPORTED
+
+err_t sandbox_create(const sandbox_config_t* config, sandbox_t** out_sandbox) {
+    if (!config || !out_sandbox) return ERR_INVALID_ARGUMENT;
+    *out_sandbox = NULL;
+    return ERROR_SET(ERR_NOT_IMPLEMENTED, "sandbox: not supported on this platform");
+}
+
+void sandbox_destroy(sandbox_t* sandbox) {
+    (void)sandbox;
+}
+
+bool sandbox_uses_cgroup(const sandbox_t* sandbox) {
+    (void)sandbox;
+    return false;
+}
+
+err_t sandbox_exec(sandbox_t* sandbox, const char* command, uint32_t timeout_ms,
+                   size_t max_output, sandbox_result_t* out_result) {
+    return ERR_NOT_IMPLEMENTED;
+}
+
+err_t sandbox_read_file(sandbox_t* sandbox, const char* path, size_t max_size,
+                        char** out_data, size_t* out_len) {
+    return ERR_NOT_IMPLEMENTED;
+}
+
+err_t sandbox_write_file(sandbox_t* sandbox, const char* path, const char* data, size_t len,
+                         bool allow_overwrite) {
+    return ERR_NOT_IMPLEMENTED;
+}
+
+#endif // SANDBOX_SUPPORTED
+
+void sandbox_result_free(sandbox_result_t* result) {
+    if (!result) return;
+    free(result->output);
+    memset(result, 0, sizeof(*result));
+}
@@ -0,0 +1,247 @@
+// str_builder.c - Allocator-aware string builder for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/str_builder.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STR_BUILDER_MIN_CAP 64
+
+// alloc() itself is shadowed by the allocator parameters below
+static void* builder_mem_alloc(allocator_t* a, size_t size) {
+    return alloc(a, size);
+}
+
+void str_builder_init(str_builder_t* sb, allocator_t* a) {
+    sb->alloc = a;
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    sb->owns_data = false;
+    sb->failed = false;
+}
+
+void str_builder_init_buffer(str_builder_t* sb, allocator_t* a, char* buf, size_t size) {
+    str_builder_init(sb, a);
+    if (buf && size > 0) {
+        sb->data = buf;
+        sb->cap = size;
+        buf[0] = '\0';
+    }
+}
+
+bool str_builder_reserve(str_builder_t* sb, size_t extra) {
+    if (sb->failed) return false;
+    if (extra >= SIZE_MAX - sb->len) {
+        sb->failed = true;
+        return false;
+    }
+
+    size_t needed = sb->len + extra + 1;
+    if (needed <= sb->cap) return true;
+
+    size_t cap = sb->cap < STR_BUILDER_MIN_CAP ? STR_BUILDER_MIN_CAP : sb->cap;
+    while (cap < needed) {
+        cap = cap > SIZE_MAX / 2 ? needed : cap * 2;
+    }
+
+    char* grown;
+    if (sb->owns_data) {
+        grown = realloc_ptr(sb->alloc, sb->data, sb->cap, cap);
+    } else {
+        // Leaving the caller's buffer (or starting out): copy what is there
+        grown = builder_mem_alloc(sb->alloc, cap);
+        if (grown && sb->len > 0) memcpy(grown, sb->data, sb->len);
+    }
+    if (!grown) {
+        sb->failed = true;
+        return false;
+    }
+
+    sb->data = grown;
+    sb->data[sb->len] = '\0';
+    sb->cap = cap;
+    sb->owns_data = true;
+    return true;
+}
+
+void str_builder_append_bytes(str_builder_t* sb, const char* data, size_t len) {
+    if (len == 0 || !str_builder_reserve(sb, len)) return;
+
+    memcpy(sb->data + sb->len, data, len);
+    sb->len += len;
+    sb->data[sb->len] = '\0';
+}
+
+void str_builder_append(str_builder_t* sb, str_t s) {
+    if (s.data) str_builder_append_bytes(sb, s.data, s.len);
+}
+
+void str_builder_append_cstr(str_builder_t* sb, const char* s) {
+    if (s) str_builder_append_bytes(sb, s, strlen(s));
+}
+
+void str_builder_append_char(str_builder_t* sb, char c) {
+    if (!str_builder_reserve(sb, 1)) return;
+
+    sb->data[sb->len++] = c;
+    sb->data[sb->len] = '\0';
+}
+
+void str_builder_append_uint(str_builder_t* sb, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    if (!str_builder_reserve(sb, n)) return;
+
+    char* out = sb->data + sb->len;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    sb->len += n;
+    sb->data[sb->len] = '\0';
+}
+
+void str_builder_append_int(str_builder_t* sb, int64_t value) {
+    if (value < 0) {
+        str_builder_append_char(sb, '-');
+        // Negate in unsigned space so INT64_MIN does not overflow
+        str_builder_append_uint(sb, (uint64_t)0 - (uint64_t)value);
+    } else {
+        str_builder_append_uint(sb, (uint64_t)value);
+    }
+}
+
+void str_builder_append_float(str_builder_t* sb, double value) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.15g", value);
+    if (isfinite(value) && strtod(buf, NULL) != value) {
+        n = snprintf(buf, sizeof(buf), "%.17g", value);
+    }
+    if (n > 0) str_builder_append_bytes(sb, buf, (size_t)n);
+}
+
+void str_builder_append_json_escaped(str_builder_t* sb, str_t s) {
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+
+    for (size_t i = 0; i < s.len; i++) {
+        unsigned char c = (unsigned char)s.data[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Copy the clean run in one go, then the escape
+        str_builder_append_bytes(sb, s.data + run, i - run);
+        run = i + 1;
+
+        char esc[6] = { '\\', 0 };
+        size_t esc_len = 2;
+        switch (c) {
+            case '"':  esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xf];
+                esc_len = 6;
+                break;
+        }
+        str_builder_append_bytes(sb, esc, esc_len);
+    }
+
+    str_builder_append_bytes(sb, s.data + run, s.len - run);
+}
+
+void str_builder_vappendf(str_builder_t* sb, const char* fmt, va_list args) {
+    if (sb->failed) return;
+
+    // Make sure there is some room so short outputs take a single pass
+    if (!str_builder_reserve(sb, STR_BUILDER_MIN_CAP / 2)) return;
+
+    va_list retry;
+    va_copy(retry, args);
+
+    size_t room = sb->cap - sb->len;
+    int n = vsnprintf(sb->data + sb->len, room, fmt, args);
+    if (n < 0) {
+        sb->data[sb->len] = '\0';
+        va_end(retry);
+        return;
+    }
+
+    if ((size_t)n >= room) {
+        if (!str_builder_reserve(sb, (size_t)n)) {
+            sb->data[sb->len] = '\0';
+            va_end(retry);
+            return;
+        }
+        vsnprintf(sb->data + sb->len, sb->cap - sb->len, fmt, retry);
+    }
+    va_end(retry);
+
+    sb->len += (size_t)n;
+}
+
+void str_builder_appendf(str_builder_t* sb, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    str_builder_vappendf(sb, fmt, args);
+    va_end(args);
+}
+
+str_t str_builder_view(const str_builder_t* sb) {
+    if (!sb->data) return (str_t){ .data = "", .len = 0 };
+    return (str_t){ .data = sb->data, .len = (uint32_t)sb->len };
+}
+
+void str_builder_reset(str_builder_t* sb) {
+    sb->len = 0;
+    sb->failed = false;
+    if (sb->data) sb->data[0] = '\0';
+}
+
+str_t str_builder_finish(str_builder_t* sb, allocator_t* out_alloc) {
+    str_t result = STR_NULL;
+
+    if (!sb->failed && sb->len <= UINT32_MAX) {
+        if (sb->owns_data && out_alloc == sb->alloc) {
+            // Already in the right allocator: hand the buffer over
+            result = (str_t){ .data = sb->data, .len = (uint32_t)sb->len };
+            sb->owns_data = false;
+            sb->data = NULL;
+        } else {
+            char* copy = builder_mem_alloc(out_alloc, sb->len + 1);
+            if (copy) {
+                if (sb->len > 0) memcpy(copy, sb->data, sb->len);
+                copy[sb->len] = '\0';
+                result = (str_t){ .data = copy, .len = (uint32_t)sb->len };
+            }
+        }
+    }
+
+    str_builder_free(sb);
+    return result;
+}
+
+void str_builder_free(str_builder_t* sb) {
+    if (sb->owns_data) {
+        free_ptr(sb->alloc, sb->data, sb->cap);
+    }
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    sb->owns_data = false;
+}
@@ -3,20 +3,30 @@
 
 #include "core/types.h"
 #include "core/alloc.h"
+#include "core/str_builder.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
 
+// Results come from the given allocator. With NULL they come from the
+// system heap, so existing callers can keep releasing them with free().
+
+// Short results are formatted on the stack and copied out once
+#define STR_FORMAT_STACK 256
+
+// alloc() itself is shadowed by the allocator parameters below
+static void* string_mem_alloc(allocator_t* a, size_t size) {
+    return alloc(a, size);
+}
+
 // String duplication
 str_t str_dup(str_t s, allocator_t* alloc) {
-    (void)alloc; // TODO: Use allocator when implemented
-
     if (str_empty(s)) {
         return STR_NULL;
     }
 
-    char* data = malloc(s.len + 1);
+    char* data = string_mem_alloc(alloc, (size_t)s.len + 1);
     if (!data) {
         return STR_NULL;
     }
@@ -28,14 +38,16 @@ str_t str_dup(str_t s, allocator_t* alloc) {
 }
 
 str_t str_dup_cstr(const char* s, allocator_t* alloc) {
-    (void)alloc; // TODO: Use allocator when implemented
-
     if (!s) {
         return STR_NULL;
     }
 
     size_t len = strlen(s);
-    char* data = malloc(len + 1);
+    if (len > UINT32_MAX) {
+        return STR_NULL;
+    }
+
+    char* data = string_mem_alloc(alloc, len + 1);
     if (!data) {
         return STR_NULL;
     }
@@ -46,34 +58,17 @@ str_t str_dup_cstr(const char* s, allocator_t* alloc) {
     return (str_t){ .data = data, .len = (uint32_t)len };
 }
 
-// String formatting (allocates memory)
+// String formatting (allocates memory). One vsnprintf pass for results
+// that fit the stack buffer; longer ones format a second time in place.
 str_t str_format(allocator_t* alloc, const char* fmt, ...) {
-    (void)alloc; // TODO: Use allocator when implemented
+    char stack[STR_FORMAT_STACK];
+    str_builder_t sb;
+    str_builder_init_buffer(&sb, alloc, stack, sizeof(stack));
 
     va_list args;
     va_start(args, fmt);
-
-    // Determine required size
-    va_list args_copy;
-    va_copy(args_copy, args);
-    int size = vsnprintf(NULL, 0, fmt, args_copy);
-    va_end(args_copy);
-
-    if (size < 0) {
-        va_end(args);
-        return STR_NULL;
-    }
-
-    // Allocate buffer
-    char* buffer = malloc((size_t)size + 1);
-    if (!buffer) {
-        va_end(args);
-        return STR_NULL;
-    }
-
-    // Format string
-    vsnprintf(buffer, (size_t)size + 1, fmt, args);
+    str_builder_vappendf(&sb, fmt, args);
     va_end(args);
 
-    return (str_t){ .data = buffer, .len = (uint32_t)size };
-}
\ No newline at end of file
+    return str_builder_finish(&sb, alloc);
+}
@@ -0,0 +1,328 @@
+// tool_cache.c - Per-session tool result cache for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/tool_cache.h"
+#include "core/str_builder.h"
+#include "json_config.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Shared outputs
+// ============================================================================
+
+typedef struct shared_header_t {
+    uint32_t refs;
+    uint32_t len;
+    char data[];
+} shared_header_t;
+
+static shared_header_t* shared_header(str_t shared) {
+    return (shared_header_t*)(shared.data - offsetof(shared_header_t, data));
+}
+
+str_t tool_output_share(str_t content) {
+    shared_header_t* header = malloc(sizeof(shared_header_t) + content.len + 1);
+    if (!header) return STR_NULL;
+
+    header->refs = 1;
+    header->len = content.len;
+    if (content.len > 0) memcpy(header->data, content.data, content.len);
+    header->data[content.len] = '\0';
+    return (str_t){ .data = header->data, .len = content.len };
+}
+
+str_t tool_output_retain(str_t shared) {
+    if (shared.data) __atomic_add_fetch(&shared_header(shared)->refs, 1, __ATOMIC_RELAXED);
+    return shared;
+}
+
+void tool_output_release(str_t shared) {
+    if (!shared.data) return;
+    shared_header_t* header = shared_header(shared);
+    if (__atomic_sub_fetch(&header->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(header);
+    }
+}
+
+// ============================================================================
+// Canonical arguments
+// ============================================================================
+
+static int compare_entries(const void* a, const void* b) {
+    const json_entry_t* ea = *(const json_entry_t* const*)a;
+    const json_entry_t* eb = *(const json_entry_t* const*)b;
+    return strcmp(ea->key, eb->key);
+}
+
+static void append_canonical(str_builder_t* sb, const json_value_t* value) {
+    switch (value->type) {
+        case JSON_NULL:
+            str_builder_append_cstr(sb, "null");
+            break;
+        case JSON_BOOL:
+            str_builder_append_cstr(sb, value->boolean ? "true" : "false");
+            break;
+        case JSON_NUMBER:
+            // 1, 1.0 and 1e0 are the same argument
+            if (value->number == floor(value->number) && fabs(value->number) < 9e15) {
+                str_builder_append_int(sb, (int64_t)value->number);
+            } else {
+                str_builder_appendf(sb, "%.17g", value->number);
+            }
+            break;
+        case JSON_STRING:
+            str_builder_append_char(sb, '"');
+            str_builder_append_json_escaped(sb, STR_VIEW(value->string ? value->string : ""));
+            str_builder_append_char(sb, '"');
+            break;
+        case JSON_ARRAY: {
+            str_builder_append_char(sb, '[');
+            bool first = true;
+            for (const json_array_t* item = value->array; item; item = item->next) {
+                if (!first) str_builder_append_char(sb, ',');
+                append_canonical(sb, &item->value);
+                first = false;
+            }
+            str_builder_append_char(sb, ']');
+            break;
+        }
+        case JSON_OBJECT: {
+            size_t count = 0;
+            for (json_entry_t* e = value->object ? value->object->entries : NULL; e; e = e->next) {
+                count++;
+            }
+
+            json_entry_t** sorted = count > 0 ? malloc(count * sizeof(json_entry_t*)) : NULL;
+            if (count > 0 && !sorted) {
+                sb->failed = true;
+                return;
+            }
+            size_t n = 0;
+            for (json_entry_t* e = value->object ? value->object->entries : NULL; e; e = e->next) {
+                sorted[n++] = e;
+            }
+            if (count > 1) qsort(sorted, count, sizeof(json_entry_t*), compare_entries);
+
+            str_builder_append_char(sb, '{');
+            for (size_t i = 0; i < count; i++) {
+                if (i > 0) str_builder_append_char(sb, ',');
+                str_builder_append_char(sb, '"');
+                str_builder_append_json_escaped(sb, STR_VIEW(sorted[i]->key));
+                str_builder_append_cstr(sb, "\":");
+                append_canonical(sb, &sorted[i]->value);
+            }
+            str_builder_append_char(sb, '}');
+            free(sorted);
+            break;
+        }
+    }
+}
+
+str_t tool_cache_canonical_args(str_t args) {
+    char* text = strndup(args.data ? args.data : "", args.len);
+    json_value_t* root = text ? json_parse(text) : NULL;
+    free(text);
+    if (!root) return str_dup(args, NULL);
+
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    append_canonical(&sb, root);
+    json_free(root);
+    return str_builder_finish(&sb, NULL);
+}
+
+// ============================================================================
+// Keys
+// ============================================================================
+
+static uint64_t hash_bytes(const char* data, size_t len) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool tool_cache_key_init(tool_cache_key_t* key, tool_t* tool, str_t args) {
+    if (!key || !tool || !tool->vtable) return false;
+    memset(key, 0, sizeof(*key));
+
+    if (!tool->vtable->cache_validator || !tool_is_read_only(tool)) return false;
+    if (!tool->vtable->cache_validator(tool, &args, &key->validator)) return false;
+
+    str_t canonical = tool_cache_canonical_args(args);
+    if (!canonical.data) return false;
+
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    str_builder_append(&sb, tool->vtable->get_name());
+    str_builder_append_char(&sb, '\0');
+    str_builder_append(&sb, canonical);
+    free((void*)canonical.data);
+
+    key->text = str_builder_finish(&sb, NULL);
+    if (!key->text.data) return false;
+
+    key->tool = tool;
+    key->hash = hash_bytes(key->text.data, key->text.len);
+    return true;
+}
+
+void tool_cache_key_free(tool_cache_key_t* key) {
+    if (!key) return;
+    free((void*)key->text.data);
+    memset(key, 0, sizeof(*key));
+}
+
+// ============================================================================
+// Cache
+// ============================================================================
+
+typedef struct cache_entry_t {
+    str_t key;                  // Owned; STR_NULL when the slot is free
+    uint64_t hash;
+    uint64_t validator;
+    bool memory_tool;
+    str_t output;               // Shared reference
+    uint64_t last_used;
+} cache_entry_t;
+
+struct tool_cache_t {
+    cache_entry_t entries[TOOL_CACHE_MAX_ENTRIES];
+    uint64_t tick;
+    tool_cache_stats_t stats;
+};
+
+err_t tool_cache_create(tool_cache_t** out_cache) {
+    if (!out_cache) return ERR_INVALID_ARGUMENT;
+
+    tool_cache_t* cache = calloc(1, sizeof(tool_cache_t));
+    if (!cache) return ERR_OUT_OF_MEMORY;
+
+    *out_cache = cache;
+    return ERR_OK;
+}
+
+static void entry_clear(tool_cache_t* cache, cache_entry_t* entry) {
+    if (!entry->key.data) return;
+
+    cache->stats.entries--;
+    cache->stats.bytes -= entry->output.len;
+    free((void*)entry->key.data);
+    tool_output_release(entry->output);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void tool_cache_destroy(tool_cache_t* cache) {
+    if (!cache) return;
+
+    for (uint32_t i = 0; i < TOOL_CACHE_MAX_ENTRIES; i++) {
+        entry_clear(cache, &cache->entries[i]);
+    }
+    free(cache);
+}
+
+static cache_entry_t* find_entry(tool_cache_t* cache, const tool_cache_key_t* key) {
+    for (uint32_t i = 0; i < TOOL_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t* entry = &cache->entries[i];
+        if (entry->key.data && entry->hash == key->hash && str_equal(entry->key, key->text)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+bool tool_cache_get(tool_cache_t* cache, const tool_cache_key_t* key, str_t* out_shared) {
+    if (!cache || !key || !key->text.data || !out_shared) return false;
+
+    cache_entry_t* entry = find_entry(cache, key);
+    if (!entry) {
+        cache->stats.misses++;
+        return false;
+    }
+    if (entry->validator != key->validator) {
+        cache->stats.stale++;
+        cache->stats.misses++;
+        entry_clear(cache, entry);
+        return false;
+    }
+
+    entry->last_used = ++cache->tick;
+    cache->stats.hits++;
+    *out_shared = tool_output_retain(entry->output);
+    return true;
+}
+
+static cache_entry_t* least_recently_used(tool_cache_t* cache) {
+    cache_entry_t* oldest = NULL;
+    for (uint32_t i = 0; i < TOOL_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t* entry = &cache->entries[i];
+        if (!entry->key.data) continue;
+        if (!oldest || entry->last_used < oldest->last_used) oldest = entry;
+    }
+    return oldest;
+}
+
+void tool_cache_put(tool_cache_t* cache, const tool_cache_key_t* key, str_t shared) {
+    if (!cache || !key || !key->text.data || !shared.data) return;
+    if (shared.len > TOOL_CACHE_MAX_BYTES / 4) return;
+
+    cache_entry_t* entry = find_entry(cache, key);
+    if (entry) entry_clear(cache, entry);
+
+    while (cache->stats.bytes + shared.len > TOOL_CACHE_MAX_BYTES) {
+        entry_clear(cache, least_recently_used(cache));
+    }
+
+    entry = NULL;
+    for (uint32_t i = 0; i < TOOL_CACHE_MAX_ENTRIES && !entry; i++) {
+        if (!cache->entries[i].key.data) entry = &cache->entries[i];
+    }
+    if (!entry) {
+        entry = least_recently_used(cache);
+        entry_clear(cache, entry);
+    }
+
+    str_t key_copy = str_dup(key->text, NULL);
+    if (!key_copy.data) return;
+
+    const tool_vtable_t* vtable = key->tool->vtable;
+    *entry = (cache_entry_t){
+        .key = key_copy,
+        .hash = key->hash,
+        .validator = key->validator,
+        .memory_tool = vtable->requires_memory && vtable->requires_memory(),
+        .output = tool_output_retain(shared),
+        .last_used = ++cache->tick,
+    };
+    cache->stats.entries++;
+    cache->stats.bytes += shared.len;
+}
+
+void tool_cache_invalidate(tool_cache_t* cache, const tool_t* writer) {
+    if (!cache || !writer || !writer->vtable) return;
+
+    // Memory writers leave files alone; anything else (a shell command in
+    // particular) may have touched whatever a cached read saw
+    bool memory_only = writer->vtable->requires_memory && writer->vtable->requires_memory();
+
+    for (uint32_t i = 0; i < TOOL_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t* entry = &cache->entries[i];
+        if (!entry->key.data || (memory_only && !entry->memory_tool)) continue;
+        entry_clear(cache, entry);
+        cache->stats.invalidations++;
+    }
+}
+
+void tool_cache_stats(const tool_cache_t* cache, tool_cache_stats_t* out_stats) {
+    if (!out_stats) return;
+    if (!cache) {
+        memset(out_stats, 0, sizeof(*out_stats));
+        return;
+    }
+    *out_stats = cache->stats;
+}
@@ -0,0 +1,271 @@
+// tool_output.c - Spill store for large tool outputs in CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/tool_output.h"
+#include "core/str_builder.h"
+#include "utils/sha256.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct tool_output_store_t {
+    char* dir;
+};
+
+static _Thread_local tool_output_store_t* t_bound = NULL;
+
+// ============================================================================
+// Store
+// ============================================================================
+
+static int mkdir_parents(const char* dir) {
+    char path[PATH_MAX];
+    size_t len = strlen(dir);
+    if (len == 0 || len >= sizeof(path)) return -1;
+    memcpy(path, dir, len + 1);
+
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+err_t tool_output_store_open(const char* dir, tool_output_store_t** out_store) {
+    if (!dir || !*dir || !out_store) return ERR_INVALID_ARGUMENT;
+
+    if (mkdir_parents(dir) != 0) {
+        return ERROR_SET(ERR_IO, "cannot create %s: %s", dir, strerror(errno));
+    }
+
+    tool_output_store_t* store = calloc(1, sizeof(tool_output_store_t));
+    if (!store) return ERR_OUT_OF_MEMORY;
+    store->dir = strdup(dir);
+    if (!store->dir) {
+        free(store);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    *out_store = store;
+    return ERR_OK;
+}
+
+static bool valid_handle(str_t handle) {
+    if (handle.len != TOOL_OUTPUT_HANDLE_LEN || !handle.data) return false;
+    for (uint32_t i = 0; i < handle.len; i++) {
+        char c = handle.data[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+static void remove_blobs(const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) return;
+
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        // Blobs, and temporaries left by a failed write
+        if (strncmp(entry->d_name, ".tmp-", 5) != 0 &&
+            !valid_handle(STR_VIEW(entry->d_name))) {
+            continue;
+        }
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        unlink(path);
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+void tool_output_store_close(tool_output_store_t* store, bool remove) {
+    if (!store) return;
+
+    if (remove) remove_blobs(store->dir);
+    free(store->dir);
+    free(store);
+}
+
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+err_t tool_output_store_put(tool_output_store_t* store, str_t content,
+                            tool_output_handle_t* out_handle) {
+    if (!store || !out_handle) return ERR_INVALID_ARGUMENT;
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256(content.data ? content.data : "", content.len, digest);
+    for (int i = 0; i < TOOL_OUTPUT_HANDLE_LEN / 2; i++) {
+        snprintf(out_handle->hex + i * 2, 3, "%02x", digest[i]);
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", store->dir, out_handle->hex);
+
+    // Same digest, same bytes: the earlier write stands
+    struct stat st;
+    if (stat(path, &st) == 0 && st.st_size == (off_t)content.len) return ERR_OK;
+
+    // Readers never see a partial blob
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s/.tmp-%s", store->dir, out_handle->hex);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return ERROR_SET(ERR_IO, "cannot write %s: %s", tmp, strerror(errno));
+    }
+    bool ok = write_all(fd, content.data, content.len);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        int saved = errno;
+        unlink(tmp);
+        return ERROR_SET(ERR_IO, "cannot write %s: %s", path, strerror(saved));
+    }
+    return ERR_OK;
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+tool_output_store_t* tool_output_bind(tool_output_store_t* store) {
+    tool_output_store_t* previous = t_bound;
+    t_bound = store;
+    return previous;
+}
+
+tool_output_store_t* tool_output_bound(void) {
+    return t_bound;
+}
+
+static int open_blob(const tool_output_store_t* store, str_t handle) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%.*s", store->dir, (int)handle.len, handle.data);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+err_t tool_output_read(const tool_output_store_t* store, str_t handle, uint64_t offset,
+                       uint32_t max, str_t* out, uint64_t* out_total) {
+    if (!out || !out_total) return ERR_INVALID_ARGUMENT;
+    *out = STR_NULL;
+    *out_total = 0;
+    if (!store || !valid_handle(handle)) return ERR_NOT_FOUND;
+
+    int fd = open_blob(store, handle);
+    if (fd < 0) return ERR_NOT_FOUND;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return ERR_IO;
+    }
+    *out_total = (uint64_t)st.st_size;
+
+    uint64_t len = offset < *out_total ? *out_total - offset : 0;
+    if (len > max) len = max;
+
+    char* buffer = malloc(len + 1);
+    if (!buffer) {
+        close(fd);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, buffer + done, len - done, (off_t)(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    close(fd);
+
+    buffer[done] = '\0';
+    *out = (str_t){ .data = buffer, .len = (uint32_t)done };
+    return ERR_OK;
+}
+
+// ============================================================================
+// Excerpts
+// ============================================================================
+
+// Back off to the start of a UTF-8 sequence
+static size_t utf8_floor(const char* data, size_t pos) {
+    while (pos > 0 && ((uint8_t)data[pos] & 0xC0) == 0x80) pos--;
+    return pos;
+}
+
+// End of the head: just past the last newline in the second half of the
+// window, otherwise the window itself
+static size_t head_end(str_t content, size_t window) {
+    for (size_t i = window; i > window / 2; i--) {
+        if (content.data[i - 1] == '\n') return i;
+    }
+    return utf8_floor(content.data, window);
+}
+
+// Start of the tail: just past the first newline in the first half of the
+// window, otherwise the window itself
+static size_t tail_start(str_t content, size_t window) {
+    size_t start = content.len - window;
+    for (size_t i = start; i < start + window / 2; i++) {
+        if (content.data[i] == '\n') return i + 1;
+    }
+    return utf8_floor(content.data, start);
+}
+
+str_t tool_output_excerpt(str_t content, const tool_output_handle_t* handle) {
+    size_t lines = 0;
+    for (uint32_t i = 0; i < content.len; i++) {
+        if (content.data[i] == '\n') lines++;
+    }
+    if (content.len > 0 && content.data[content.len - 1] != '\n') lines++;
+
+    size_t head = 0;
+    size_t tail = content.len;
+    if (content.len > TOOL_OUTPUT_HEAD_BYTES + TOOL_OUTPUT_TAIL_BYTES) {
+        head = head_end(content, TOOL_OUTPUT_HEAD_BYTES);
+        tail = tail_start(content, TOOL_OUTPUT_TAIL_BYTES);
+    } else {
+        head = content.len;
+    }
+
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    str_builder_appendf(&sb, "[Output too large for context: %u bytes, %zu lines. ",
+                        content.len, lines);
+    if (handle) {
+        str_builder_appendf(&sb, "Stored as tool output %s; read more with tool_output_read.]\n",
+                            handle->hex);
+    } else {
+        str_builder_append_cstr(&sb, "Only the start and end are shown.]\n");
+    }
+
+    str_builder_append(&sb, (str_t){ .data = content.data, .len = (uint32_t)head });
+    if (tail > head) {
+        if (head > 0 && content.data[head - 1] != '\n') str_builder_append_char(&sb, '\n');
+        str_builder_appendf(&sb, "...[%zu bytes omitted]...\n", tail - head);
+        str_builder_append(&sb, (str_t){ .data = content.data + tail,
+                                         .len = content.len - (uint32_t)tail });
+    }
+
+    return str_builder_finish(&sb, NULL);
+}
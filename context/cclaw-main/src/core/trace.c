@@ -0,0 +1,546 @@
+// trace.c - Lightweight tracing spans for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// Internal Types
+// ============================================================================
+
+typedef struct trace_event_t {
+    char name[TRACE_NAME_MAX];
+    const char* category;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint64_t trace_hi;
+    uint64_t trace_lo;
+    uint64_t span_id;
+    uint64_t parent_id;
+    const char* arg_keys[TRACE_MAX_ARGS];
+    int64_t arg_values[TRACE_MAX_ARGS];
+    uint32_t arg_count;
+} trace_event_t;
+
+// Per-thread state: open span stack plus an SPSC ring of finished spans.
+// The owning thread is the only producer, the flusher the only consumer.
+typedef struct trace_thread_t {
+    trace_event_t* ring;
+    uint32_t mask;
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    uint32_t tid;
+
+    trace_event_t stack[TRACE_MAX_DEPTH];
+    uint32_t depth;
+    uint32_t overflow;
+
+    atomic_bool idle;           // Owner exited; another thread may adopt it
+
+    struct trace_thread_t* next;
+} trace_thread_t;
+
+atomic_bool g_trace_enabled = false;
+
+static struct {
+    trace_config_t config;
+    char* path;
+    char* service_name;
+    FILE* out;
+    bool wrote_event;
+
+    pthread_mutex_t lock;       // Guards threads list and output file
+    pthread_cond_t wake;
+    pthread_t flusher;
+    bool flusher_running;
+    bool stop;
+
+    // Thread states are never freed: a traced thread may be between its
+    // trace_enabled() check and the ring push when trace_shutdown() runs.
+    // States of exited threads are handed to new threads instead.
+    trace_thread_t* threads;
+    uint32_t thread_count;
+    pthread_key_t exit_key;
+
+    uint64_t origin_ns;         // Monotonic time at init (Chrome ts origin)
+    uint64_t wall_offset_ns;    // Realtime - monotonic (OTLP timestamps)
+    int pid;
+
+    _Atomic uint64_t trace_seed; // High half of root trace ids; read by writers
+
+    _Atomic uint64_t next_span_id;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t generation;
+} g_trace = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+// t_trace_generation tells a thread that its open span stack belongs to a
+// previous trace_init() and must be discarded.
+static _Thread_local trace_thread_t* t_trace = NULL;
+static _Thread_local uint64_t t_trace_generation = 0;
+
+static pthread_once_t g_trace_key_once = PTHREAD_ONCE_INIT;
+
+static trace_thread_t* trace_thread_current(void) {
+    uint64_t generation = atomic_load_explicit(&g_trace.generation, memory_order_acquire);
+    return t_trace_generation == generation ? t_trace : NULL;
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static uint32_t round_up_pow2(uint32_t v) {
+    if (v < 2) return 2;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return v + 1;
+}
+
+static void copy_name(char* dst, const char* src, size_t len) {
+    if (len >= TRACE_NAME_MAX) len = TRACE_NAME_MAX - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static void trace_thread_exit(void* arg) {
+    trace_thread_t* t = arg;
+    atomic_store_explicit(&t->idle, true, memory_order_release);
+}
+
+static void trace_key_create(void) {
+    pthread_key_create(&g_trace.exit_key, trace_thread_exit);
+}
+
+// Takes over the state of an exited thread. Caller holds g_trace.lock.
+static trace_thread_t* adopt_idle_locked(void) {
+    for (trace_thread_t* t = g_trace.threads; t; t = t->next) {
+        if (atomic_load_explicit(&t->idle, memory_order_acquire)) {
+            atomic_store_explicit(&t->idle, false, memory_order_relaxed);
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static trace_thread_t* trace_thread_get(void) {
+    uint64_t generation = atomic_load_explicit(&g_trace.generation, memory_order_acquire);
+    if (t_trace && t_trace_generation == generation) return t_trace;
+
+    trace_thread_t* t = t_trace;
+    if (!t) {
+        pthread_once(&g_trace_key_once, trace_key_create);
+
+        pthread_mutex_lock(&g_trace.lock);
+        t = adopt_idle_locked();
+        pthread_mutex_unlock(&g_trace.lock);
+    }
+
+    if (!t) {
+        t = calloc(1, sizeof(trace_thread_t));
+        if (!t) return NULL;
+
+        // The ring keeps the capacity of the session that created it
+        uint32_t capacity = round_up_pow2(g_trace.config.ring_capacity);
+        t->ring = calloc(capacity, sizeof(trace_event_t));
+        if (!t->ring) {
+            free(t);
+            return NULL;
+        }
+        t->mask = capacity - 1;
+
+        pthread_mutex_lock(&g_trace.lock);
+        t->tid = ++g_trace.thread_count;
+        t->next = g_trace.threads;
+        g_trace.threads = t;
+        pthread_mutex_unlock(&g_trace.lock);
+    }
+
+    if (t != t_trace) {
+        pthread_setspecific(g_trace.exit_key, t);
+        t_trace = t;
+    }
+
+    // Spans left open by a previous session are dropped
+    t->depth = 0;
+    t->overflow = 0;
+    t_trace_generation = generation;
+    return t;
+}
+
+static void ring_push(trace_thread_t* t, const trace_event_t* event) {
+    uint64_t head = atomic_load_explicit(&t->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&t->tail, memory_order_acquire);
+    if (head - tail > t->mask) {
+        // Never block the traced thread; count the loss instead
+        atomic_fetch_add_explicit(&g_trace.dropped, 1, memory_order_relaxed);
+        return;
+    }
+    t->ring[head & t->mask] = *event;
+    atomic_store_explicit(&t->head, head + 1, memory_order_release);
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+static void write_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; s && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void write_chrome_event(FILE* f, const trace_event_t* ev, uint32_t tid) {
+    double ts_us = (double)(ev->start_ns - g_trace.origin_ns) / 1000.0;
+    double dur_us = (double)(ev->end_ns - ev->start_ns) / 1000.0;
+
+    fputs(g_trace.wrote_event ? ",\n" : "\n", f);
+    g_trace.wrote_event = true;
+
+    fputs("{\"name\":", f);
+    write_json_string(f, ev->name);
+    fputs(",\"cat\":", f);
+    write_json_string(f, ev->category ? ev->category : "cclaw");
+    fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{",
+            ts_us, dur_us, g_trace.pid, tid);
+    for (uint32_t i = 0; i < ev->arg_count; i++) {
+        if (i > 0) fputc(',', f);
+        write_json_string(f, ev->arg_keys[i]);
+        fprintf(f, ":%lld", (long long)ev->arg_values[i]);
+    }
+    fputs("}}", f);
+}
+
+static void write_otlp_span(FILE* f, const trace_event_t* ev, bool first) {
+    if (!first) fputc(',', f);
+
+    fprintf(f, "{\"traceId\":\"%016llx%016llx\",\"spanId\":\"%016llx\"",
+            (unsigned long long)ev->trace_hi, (unsigned long long)ev->trace_lo,
+            (unsigned long long)ev->span_id);
+    if (ev->parent_id) {
+        fprintf(f, ",\"parentSpanId\":\"%016llx\"", (unsigned long long)ev->parent_id);
+    }
+    fputs(",\"name\":", f);
+    write_json_string(f, ev->name);
+    fprintf(f, ",\"kind\":1,\"startTimeUnixNano\":\"%llu\",\"endTimeUnixNano\":\"%llu\"",
+            (unsigned long long)(ev->start_ns + g_trace.wall_offset_ns),
+            (unsigned long long)(ev->end_ns + g_trace.wall_offset_ns));
+    fputs(",\"attributes\":[{\"key\":\"cclaw.category\",\"value\":{\"stringValue\":", f);
+    write_json_string(f, ev->category ? ev->category : "cclaw");
+    fputs("}}", f);
+    for (uint32_t i = 0; i < ev->arg_count; i++) {
+        fputs(",{\"key\":", f);
+        write_json_string(f, ev->arg_keys[i]);
+        fprintf(f, ",\"value\":{\"intValue\":\"%lld\"}}", (long long)ev->arg_values[i]);
+    }
+    fputs("]}", f);
+}
+
+// Drain every thread ring into the output file. Caller holds g_trace.lock.
+static void drain_locked(void) {
+    FILE* f = g_trace.out;
+    if (!f) return;
+
+    bool otlp = g_trace.config.format == TRACE_FORMAT_OTLP;
+    bool batch_open = false;
+
+    for (trace_thread_t* t = g_trace.threads; t; t = t->next) {
+        uint64_t tail = atomic_load_explicit(&t->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&t->head, memory_order_acquire);
+
+        for (; tail < head; tail++) {
+            const trace_event_t* ev = &t->ring[tail & t->mask];
+            if (otlp) {
+                if (!batch_open) {
+                    fputs("{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\","
+                          "\"value\":{\"stringValue\":", f);
+                    write_json_string(f, g_trace.service_name ? g_trace.service_name : "cclaw");
+                    fputs("}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"cclaw\"},\"spans\":[", f);
+                }
+                write_otlp_span(f, ev, !batch_open);
+                batch_open = true;
+            } else {
+                write_chrome_event(f, ev, t->tid);
+            }
+        }
+
+        atomic_store_explicit(&t->tail, tail, memory_order_release);
+    }
+
+    if (batch_open) {
+        fputs("]}]}]}\n", f);
+    }
+    fflush(f);
+}
+
+static void* flusher_thread(void* arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_trace.lock);
+    while (!g_trace.stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)g_trace.config.flush_interval_ms * 1000000ULL;
+        deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+        deadline.tv_nsec = (long)(ns % 1000000000ULL);
+
+        pthread_cond_timedwait(&g_trace.wake, &g_trace.lock, &deadline);
+        drain_locked();
+    }
+    pthread_mutex_unlock(&g_trace.lock);
+    return NULL;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+trace_config_t trace_config_default(void) {
+    return (trace_config_t){
+        .path = "cclaw-trace.json",
+        .format = TRACE_FORMAT_CHROME,
+        .service_name = "cclaw",
+        .ring_capacity = 4096,
+        .flush_interval_ms = 250
+    };
+}
+
+err_t trace_init(const trace_config_t* config) {
+    if (!config || !config->path) return ERR_INVALID_ARGUMENT;
+    if (trace_enabled()) return ERR_ALREADY_EXISTS;
+
+    FILE* out = fopen(config->path, "w");
+    if (!out) return ERR_IO;
+
+    pthread_mutex_lock(&g_trace.lock);
+
+    g_trace.config = *config;
+    if (g_trace.config.ring_capacity == 0) g_trace.config.ring_capacity = 4096;
+    if (g_trace.config.flush_interval_ms == 0) g_trace.config.flush_interval_ms = 250;
+    g_trace.path = strdup(config->path);
+    g_trace.service_name = config->service_name ? strdup(config->service_name) : NULL;
+    g_trace.config.path = g_trace.path;
+    g_trace.config.service_name = g_trace.service_name;
+
+    g_trace.out = out;
+    g_trace.wrote_event = false;
+    g_trace.stop = false;
+    g_trace.pid = (int)getpid();
+    g_trace.origin_ns = trace_now_ns();
+    g_trace.wall_offset_ns = realtime_ns() - g_trace.origin_ns;
+    atomic_store_explicit(&g_trace.trace_seed,
+                          splitmix64(((uint64_t)g_trace.pid << 32) ^ g_trace.wall_offset_ns),
+                          memory_order_relaxed);
+    atomic_store(&g_trace.dropped, 0);
+    atomic_fetch_add(&g_trace.generation, 1);
+
+    // Discard spans pushed by threads that raced the previous shutdown
+    for (trace_thread_t* t = g_trace.threads; t; t = t->next) {
+        uint64_t head = atomic_load_explicit(&t->head, memory_order_acquire);
+        atomic_store_explicit(&t->tail, head, memory_order_release);
+    }
+
+    if (g_trace.config.format == TRACE_FORMAT_CHROME) {
+        fputs("{\"traceEvents\":[", out);
+    }
+
+    g_trace.flusher_running = pthread_create(&g_trace.flusher, NULL, flusher_thread, NULL) == 0;
+
+    pthread_mutex_unlock(&g_trace.lock);
+
+    atomic_store_explicit(&g_trace_enabled, true, memory_order_release);
+    return ERR_OK;
+}
+
+void trace_flush(void) {
+    pthread_mutex_lock(&g_trace.lock);
+    drain_locked();
+    pthread_mutex_unlock(&g_trace.lock);
+}
+
+void trace_shutdown(void) {
+    if (!trace_enabled()) return;
+    atomic_store_explicit(&g_trace_enabled, false, memory_order_release);
+
+    pthread_mutex_lock(&g_trace.lock);
+    g_trace.stop = true;
+    pthread_cond_signal(&g_trace.wake);
+    pthread_mutex_unlock(&g_trace.lock);
+
+    if (g_trace.flusher_running) {
+        pthread_join(g_trace.flusher, NULL);
+        g_trace.flusher_running = false;
+    }
+
+    pthread_mutex_lock(&g_trace.lock);
+    drain_locked();
+
+    if (g_trace.out) {
+        if (g_trace.config.format == TRACE_FORMAT_CHROME) {
+            fprintf(g_trace.out, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%llu}}\n",
+                    (unsigned long long)atomic_load(&g_trace.dropped));
+        }
+        fclose(g_trace.out);
+        g_trace.out = NULL;
+    }
+
+    // Thread states stay alive for writers still inside a TRACE_* macro;
+    // the generation bump makes their open spans stale
+    atomic_fetch_add(&g_trace.generation, 1);
+
+    free(g_trace.path);
+    free(g_trace.service_name);
+    g_trace.path = NULL;
+    g_trace.service_name = NULL;
+
+    pthread_mutex_unlock(&g_trace.lock);
+}
+
+uint64_t trace_dropped_events(void) {
+    return atomic_load_explicit(&g_trace.dropped, memory_order_relaxed);
+}
+
+// ============================================================================
+// Span API
+// ============================================================================
+
+static void span_begin(const char* name, size_t name_len, const char* category) {
+    trace_thread_t* t = trace_thread_get();
+    if (!t) return;
+
+    if (t->depth >= TRACE_MAX_DEPTH) {
+        t->overflow++;
+        return;
+    }
+
+    trace_event_t* frame = &t->stack[t->depth];
+    copy_name(frame->name, name, name_len);
+    frame->category = category;
+    frame->arg_count = 0;
+    frame->span_id = atomic_fetch_add_explicit(&g_trace.next_span_id, 1, memory_order_relaxed) + 1;
+
+    if (t->depth > 0) {
+        const trace_event_t* parent = &t->stack[t->depth - 1];
+        frame->parent_id = parent->span_id;
+        frame->trace_hi = parent->trace_hi;
+        frame->trace_lo = parent->trace_lo;
+    } else {
+        frame->parent_id = 0;
+        frame->trace_hi = atomic_load_explicit(&g_trace.trace_seed, memory_order_relaxed);
+        frame->trace_lo = splitmix64(frame->span_id ^ trace_now_ns());
+    }
+
+    t->depth++;
+    frame->start_ns = trace_now_ns();
+}
+
+void trace_span_begin_impl(const char* name, const char* category) {
+    if (!name) name = "span";
+    span_begin(name, strlen(name), category);
+}
+
+void trace_span_begin_str_impl(str_t name, const char* category) {
+    if (str_empty(name)) {
+        span_begin("span", 4, category);
+        return;
+    }
+    span_begin(name.data, name.len, category);
+}
+
+void trace_span_end_impl(void) {
+    uint64_t end = trace_now_ns();
+
+    trace_thread_t* t = trace_thread_current();
+    if (!t) return;
+
+    if (t->overflow > 0) {
+        t->overflow--;
+        return;
+    }
+    if (t->depth == 0) return;
+
+    trace_event_t* frame = &t->stack[--t->depth];
+    frame->end_ns = end;
+    ring_push(t, frame);
+}
+
+void trace_span_arg_impl(const char* key, int64_t value) {
+    trace_thread_t* t = trace_thread_current();
+    if (!t || t->depth == 0 || t->overflow > 0) return;
+
+    trace_event_t* frame = &t->stack[t->depth - 1];
+    if (frame->arg_count >= TRACE_MAX_ARGS) return;
+
+    frame->arg_keys[frame->arg_count] = key;
+    frame->arg_values[frame->arg_count] = value;
+    frame->arg_count++;
+}
+
+void trace_span_record_impl(const char* name, const char* category,
+                            uint64_t start_ns, uint64_t end_ns) {
+    if (!trace_enabled() || end_ns < start_ns) return;
+
+    trace_thread_t* t = trace_thread_get();
+    if (!t) return;
+
+    trace_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    copy_name(ev.name, name ? name : "span", name ? strlen(name) : 4);
+    ev.category = category;
+    ev.start_ns = start_ns;
+    ev.end_ns = end_ns;
+    ev.span_id = atomic_fetch_add_explicit(&g_trace.next_span_id, 1, memory_order_relaxed) + 1;
+
+    if (t->depth > 0 && t->overflow == 0) {
+        const trace_event_t* parent = &t->stack[t->depth - 1];
+        ev.parent_id = parent->span_id;
+        ev.trace_hi = parent->trace_hi;
+        ev.trace_lo = parent->trace_lo;
+    } else {
+        ev.trace_hi = atomic_load_explicit(&g_trace.trace_seed, memory_order_relaxed);
+        ev.trace_lo = splitmix64(ev.span_id ^ start_ns);
+    }
+
+    ring_push(t, &ev);
+}
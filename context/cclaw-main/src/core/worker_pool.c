@@ -0,0 +1,200 @@
+// worker_pool.c - Fixed-size worker thread pool for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/worker_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct worker_job_t {
+    worker_job_fn fn;
+    void* arg;
+    worker_group_t* group;
+} worker_job_t;
+
+typedef struct worker_slot_t {
+    worker_pool_t* pool;
+    uint32_t index;
+} worker_slot_t;
+
+struct worker_pool_t {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+
+    // Ring buffer of queued jobs
+    worker_job_t* jobs;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+
+    pthread_t* threads;
+    worker_slot_t* slots;
+    uint32_t thread_count;
+    bool stopping;
+};
+
+static void group_job_done(worker_group_t* group) {
+    pthread_mutex_lock(&group->lock);
+    if (--group->pending == 0) {
+        pthread_cond_broadcast(&group->done);
+    }
+    pthread_mutex_unlock(&group->lock);
+}
+
+static void* worker_main(void* arg) {
+    worker_slot_t* slot = arg;
+    worker_pool_t* pool = slot->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->count == 0 && !pool->stopping) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+        if (pool->count == 0) break;   // Stopping and drained
+
+        worker_job_t job = pool->jobs[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pthread_mutex_unlock(&pool->lock);
+
+        job.fn(job.arg, slot->index);
+        if (job.group) group_job_done(job.group);
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+err_t worker_pool_create(uint32_t threads, uint32_t queue_capacity, worker_pool_t** out_pool) {
+    if (!out_pool || threads == 0 || threads > WORKER_POOL_MAX_THREADS) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    worker_pool_t* pool = calloc(1, sizeof(worker_pool_t));
+    if (!pool) return ERR_OUT_OF_MEMORY;
+
+    pool->capacity = queue_capacity ? queue_capacity : WORKER_POOL_DEFAULT_QUEUE;
+    pool->jobs = calloc(pool->capacity, sizeof(worker_job_t));
+    pool->threads = calloc(threads, sizeof(pthread_t));
+    pool->slots = calloc(threads, sizeof(worker_slot_t));
+    if (!pool->jobs || !pool->threads || !pool->slots) {
+        free(pool->jobs);
+        free(pool->threads);
+        free(pool->slots);
+        free(pool);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+
+    for (uint32_t i = 0; i < threads; i++) {
+        pool->slots[i].pool = pool;
+        pool->slots[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->slots[i]) != 0) {
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count < threads) {
+        worker_pool_destroy(pool);
+        return ERR_FAILED;
+    }
+
+    *out_pool = pool;
+    return ERR_OK;
+}
+
+void worker_pool_destroy(worker_pool_t* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->jobs);
+    free(pool->threads);
+    free(pool->slots);
+    free(pool);
+}
+
+uint32_t worker_pool_size(const worker_pool_t* pool) {
+    return pool ? pool->thread_count : 0;
+}
+
+static err_t pool_enqueue(worker_pool_t* pool, worker_job_fn fn, void* arg, worker_group_t* group) {
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->stopping) {
+        pthread_mutex_unlock(&pool->lock);
+        return ERR_INVALID_STATE;
+    }
+    if (pool->count == pool->capacity) {
+        pthread_mutex_unlock(&pool->lock);
+        return ERR_RATE_LIMITED;
+    }
+
+    uint32_t tail = (pool->head + pool->count) % pool->capacity;
+    pool->jobs[tail] = (worker_job_t){ .fn = fn, .arg = arg, .group = group };
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+
+    pthread_mutex_unlock(&pool->lock);
+    return ERR_OK;
+}
+
+err_t worker_pool_submit(worker_pool_t* pool, worker_job_fn fn, void* arg) {
+    if (!pool || !fn) return ERR_INVALID_ARGUMENT;
+    return pool_enqueue(pool, fn, arg, NULL);
+}
+
+// ============================================================================
+// Completion groups
+// ============================================================================
+
+void worker_group_init(worker_group_t* group, worker_pool_t* pool) {
+    group->pool = pool;
+    group->pending = 0;
+    pthread_mutex_init(&group->lock, NULL);
+    pthread_cond_init(&group->done, NULL);
+}
+
+void worker_group_destroy(worker_group_t* group) {
+    if (!group) return;
+    pthread_cond_destroy(&group->done);
+    pthread_mutex_destroy(&group->lock);
+}
+
+err_t worker_group_submit(worker_group_t* group, worker_job_fn fn, void* arg) {
+    if (!group || !group->pool || !fn) return ERR_INVALID_ARGUMENT;
+
+    // Count the job before it can possibly finish
+    pthread_mutex_lock(&group->lock);
+    group->pending++;
+    pthread_mutex_unlock(&group->lock);
+
+    err_t err = pool_enqueue(group->pool, fn, arg, group);
+    if (err != ERR_OK) {
+        group_job_done(group);
+    }
+    return err;
+}
+
+void worker_group_wait(worker_group_t* group) {
+    if (!group) return;
+
+    pthread_mutex_lock(&group->lock);
+    while (group->pending > 0) {
+        pthread_cond_wait(&group->done, &group->lock);
+    }
+    pthread_mutex_unlock(&group->lock);
+}
@@ -9,6 +9,7 @@
 #include "core/config.h"
 #include "core/alloc.h"
 #include "core/channel.h"
+#include "core/trace.h"
 #include "cli/commands.h"
 
 #include <stdio.h>
@@ -30,6 +31,7 @@ static void print_help(void);
 static void print_version(void);
 static err_t parse_args(int argc, char** argv, cli_args_t* args);
 static err_t handle_command(cli_args_t* args, config_t* config);
+static void start_tracing(const config_t* config);
 
 // Main entry point
 int main(int argc, char** argv) {
@@ -81,8 +83,12 @@ int main(int argc, char** argv) {
     // Apply environment variable overrides
     config_apply_env_overrides(config);
 
+    // Tracing is opt-in via observability.trace_file / ZEROCLAW_TRACE_FILE
+    start_tracing(config);
+
     // Handle the command
     err = handle_command(&args, config);
+    trace_shutdown();
     if (err != ERR_OK) {
         if (err != ERR_OK) {  // Don't print error for help/version
             fprintf(stderr, "Command failed: %s\n", error_to_string(err));
@@ -131,6 +137,26 @@ static void print_help(void) {
     printf("\n");
 }
 
+// Start span tracing if a trace file is configured
+static void start_tracing(const config_t* config) {
+    if (str_empty(config->observability.trace_file)) return;
+
+    char* path = strndup(config->observability.trace_file.data, config->observability.trace_file.len);
+    if (!path) return;
+
+    trace_config_t trace_config = trace_config_default();
+    trace_config.path = path;
+    if (str_equal_cstr(config->observability.trace_format, "otlp")) {
+        trace_config.format = TRACE_FORMAT_OTLP;
+    }
+
+    err_t err = trace_init(&trace_config);
+    if (err != ERR_OK) {
+        fprintf(stderr, "Warning: Failed to start tracing to '%s': %s\n", path, error_to_string(err));
+    }
+    free(path);
+}
+
 // Print version information
 static void print_version(void) {
     cmd_version();
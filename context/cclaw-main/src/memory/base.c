@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "core/memory.h"
+#include "core/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -120,7 +121,22 @@ err_t memory_create(const char* name, const memory_config_t* config, memory_t**
 
     for (uint32_t i = 0; i < g_backend_count; i++) {
         if (strcmp(g_registry[i].name, name) == 0) {
-            return g_registry[i].vtable->create(config, out_memory);
+            err_t err = g_registry[i].vtable->create(config, out_memory);
+            if (err != ERR_OK) return err;
+
+            if (config->cache_entries > 0) {
+                memory_t* cached = NULL;
+                if (memory_cached_wrap(*out_memory, config->cache_entries, &cached) == ERR_OK) {
+                    *out_memory = cached;
+                }
+            }
+            if (!trace_enabled()) return ERR_OK;
+
+            memory_t* traced = NULL;
+            if (memory_traced_wrap(*out_memory, &traced) == ERR_OK) {
+                *out_memory = traced;
+            }
+            return ERR_OK;
         }
     }
 
@@ -160,6 +176,18 @@ void memory_free(memory_t* memory) {
     }
 }
 
+uint64_t memory_generation(const memory_t* memory) {
+    if (!memory) return 0;
+    while (memory->wrapped) memory = memory->wrapped;
+    return __atomic_load_n(&memory->generation, __ATOMIC_ACQUIRE);
+}
+
+void memory_bump_generation(memory_t* memory) {
+    if (!memory) return;
+    while (memory->wrapped) memory = memory->wrapped;
+    __atomic_add_fetch(&memory->generation, 1, __ATOMIC_RELEASE);
+}
+
 // String utilities
 str_t memory_generate_id(void) {
     // Simple timestamp-based ID generation
@@ -231,6 +259,9 @@ memory_config_t memory_config_default(void) {
         .data_dir = STR_NULL,
         .max_entries = MEMORY_MAX_ENTRIES_DEFAULT,
         .compression = false,
-        .retention_days = MEMORY_RETENTION_DAYS_DEFAULT
+        .compression_codec = STR_NULL,
+        .retention_days = MEMORY_RETENTION_DAYS_DEFAULT,
+        .cache_entries = MEMORY_CACHE_ENTRIES_DEFAULT,
+        .reader_connections = MEMORY_READER_CONNECTIONS_DEFAULT
     };
 }
\ No newline at end of file
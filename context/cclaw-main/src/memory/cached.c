@@ -0,0 +1,495 @@
+// cached.c - Read-cache decorator for memory backends in CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/memory.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Wraps another memory_t and caches recall-by-key results, including
+// misses, in a sharded LRU. store/store_multiple/forget invalidate the
+// affected keys after reaching the backend; operations that cannot be
+// mapped to keys (forget_by_id, forget_old, restore) drop the whole cache.
+// impl_data is a memory_cache_t, which owns the wrapped backend.
+
+#define CACHE_SHARDS 8
+#define CACHE_BUCKETS_PER_SHARD 64
+
+typedef struct cache_node_t {
+    struct cache_node_t* hash_next;
+    struct cache_node_t* lru_prev;
+    struct cache_node_t* lru_next;
+    uint64_t hash;
+    str_t key;
+    bool negative;              // Backend reported ERR_NOT_FOUND
+    memory_entry_t entry;       // Owned copy when !negative
+} cache_node_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    cache_node_t* buckets[CACHE_BUCKETS_PER_SHARD];
+    cache_node_t* lru_head;     // Most recently used
+    cache_node_t* lru_tail;     // Eviction candidate
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t generation;        // Bumped on every invalidation
+} cache_shard_t;
+
+typedef struct {
+    memory_t* inner;
+    cache_shard_t shards[CACHE_SHARDS];
+} memory_cache_t;
+
+// Process-wide counters, updated with relaxed atomics
+static memory_cache_stats_t g_cache_stats;
+
+#define STAT_INC(field) __atomic_add_fetch(&g_cache_stats.field, 1, __ATOMIC_RELAXED)
+
+// Forward declarations for vtable
+static str_t cached_get_name(void);
+static str_t cached_get_version(void);
+static err_t cached_create(const memory_config_t* config, memory_t** out_memory);
+static void cached_destroy(memory_t* memory);
+static err_t cached_init(memory_t* memory);
+static void cached_cleanup(memory_t* memory);
+static err_t cached_store(memory_t* memory, const memory_entry_t* entry);
+static err_t cached_store_multiple(memory_t* memory, const memory_entry_t* entries, uint32_t count);
+static err_t cached_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry);
+static err_t cached_recall_by_id(memory_t* memory, const str_t* id, memory_entry_t* out_entry);
+static err_t cached_search(memory_t* memory, const str_t* query, const memory_search_opts_t* opts,
+                           memory_entry_t** out_entries, uint32_t* out_count);
+static err_t cached_forget(memory_t* memory, const str_t* key);
+static err_t cached_forget_by_id(memory_t* memory, const str_t* id);
+static err_t cached_forget_old(memory_t* memory, uint64_t cutoff_timestamp);
+static err_t cached_get_stats(memory_t* memory, uint32_t* total_entries, uint32_t* by_category_counts);
+static err_t cached_backup(memory_t* memory, const str_t* backup_path);
+static err_t cached_restore(memory_t* memory, const str_t* backup_path);
+
+// VTable definition
+static const memory_vtable_t cached_vtable = {
+    .get_name = cached_get_name,
+    .get_version = cached_get_version,
+    .create = cached_create,
+    .destroy = cached_destroy,
+    .init = cached_init,
+    .cleanup = cached_cleanup,
+    .store = cached_store,
+    .store_multiple = cached_store_multiple,
+    .recall = cached_recall,
+    .recall_by_id = cached_recall_by_id,
+    .search = cached_search,
+    .forget = cached_forget,
+    .forget_by_id = cached_forget_by_id,
+    .forget_old = cached_forget_old,
+    .get_stats = cached_get_stats,
+    .backup = cached_backup,
+    .restore = cached_restore
+};
+
+#define CACHE(memory) ((memory_cache_t*)(memory)->impl_data)
+#define INNER(memory) (CACHE(memory)->inner)
+
+// Forward a vtable call to the wrapped backend unchanged
+#define CACHED_FORWARD(memory, slot, ...) \
+    do { \
+        memory_t* inner_ = INNER(memory); \
+        if (!inner_->vtable->slot) return ERR_NOT_IMPLEMENTED; \
+        return inner_->vtable->slot(inner_, __VA_ARGS__); \
+    } while (0)
+
+// FNV-1a
+static uint64_t key_hash(const str_t* key) {
+    uint64_t h = 1469598103934665603ULL;
+    for (uint32_t i = 0; i < key->len; i++) {
+        h ^= (uint8_t)key->data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static cache_shard_t* shard_for(memory_cache_t* cache, uint64_t hash) {
+    return &cache->shards[hash % CACHE_SHARDS];
+}
+
+static uint32_t bucket_for(uint64_t hash) {
+    return (uint32_t)((hash / CACHE_SHARDS) % CACHE_BUCKETS_PER_SHARD);
+}
+
+static void entry_copy(memory_entry_t* dst, const memory_entry_t* src) {
+    dst->id = str_dup(src->id, NULL);
+    dst->key = str_dup(src->key, NULL);
+    dst->content = str_dup(src->content, NULL);
+    dst->category = src->category;
+    dst->timestamp = str_dup(src->timestamp, NULL);
+    dst->session_id = str_dup(src->session_id, NULL);
+    dst->score = src->score;
+}
+
+static void entry_release(memory_entry_t* entry) {
+    free((void*)entry->id.data);
+    free((void*)entry->key.data);
+    free((void*)entry->content.data);
+    free((void*)entry->timestamp.data);
+    free((void*)entry->session_id.data);
+}
+
+static void node_free(cache_node_t* node) {
+    free((void*)node->key.data);
+    if (!node->negative) entry_release(&node->entry);
+    free(node);
+}
+
+static void lru_unlink(cache_shard_t* shard, cache_node_t* node) {
+    if (node->lru_prev) node->lru_prev->lru_next = node->lru_next;
+    else shard->lru_head = node->lru_next;
+    if (node->lru_next) node->lru_next->lru_prev = node->lru_prev;
+    else shard->lru_tail = node->lru_prev;
+    node->lru_prev = node->lru_next = NULL;
+}
+
+static void lru_push_front(cache_shard_t* shard, cache_node_t* node) {
+    node->lru_prev = NULL;
+    node->lru_next = shard->lru_head;
+    if (shard->lru_head) shard->lru_head->lru_prev = node;
+    shard->lru_head = node;
+    if (!shard->lru_tail) shard->lru_tail = node;
+}
+
+// Find the node for key; when unlink is set, also remove it from the table
+static cache_node_t* shard_find(cache_shard_t* shard, uint64_t hash, const str_t* key, bool unlink) {
+    cache_node_t** link = &shard->buckets[bucket_for(hash)];
+    while (*link) {
+        cache_node_t* node = *link;
+        if (node->hash == hash && str_equal(node->key, *key)) {
+            if (unlink) {
+                *link = node->hash_next;
+                lru_unlink(shard, node);
+                shard->count--;
+            }
+            return node;
+        }
+        link = &node->hash_next;
+    }
+    return NULL;
+}
+
+static void shard_clear(cache_shard_t* shard) {
+    cache_node_t* node = shard->lru_head;
+    while (node) {
+        cache_node_t* next = node->lru_next;
+        node_free(node);
+        node = next;
+    }
+    memset(shard->buckets, 0, sizeof(shard->buckets));
+    shard->lru_head = shard->lru_tail = NULL;
+    shard->count = 0;
+}
+
+// Caller holds the shard lock
+static void shard_evict_lru(cache_shard_t* shard) {
+    cache_node_t* victim = shard->lru_tail;
+    if (!victim) return;
+    shard_find(shard, victim->hash, &victim->key, true);
+    node_free(victim);
+    STAT_INC(evictions);
+}
+
+// Insert a recall result unless the key was invalidated since generation
+static void cache_insert(memory_cache_t* cache, uint64_t hash, const str_t* key,
+                         const memory_entry_t* entry, uint64_t generation) {
+    cache_node_t* node = calloc(1, sizeof(cache_node_t));
+    if (!node) return;
+    node->hash = hash;
+    node->key = str_dup(*key, NULL);
+    node->negative = entry == NULL;
+    if (entry) entry_copy(&node->entry, entry);
+
+    cache_shard_t* shard = shard_for(cache, hash);
+    pthread_mutex_lock(&shard->lock);
+
+    if (shard->generation != generation || str_empty(node->key)) {
+        // A store/forget raced with the backend read; drop the stale result
+        pthread_mutex_unlock(&shard->lock);
+        node_free(node);
+        return;
+    }
+
+    cache_node_t* old = shard_find(shard, hash, key, true);
+    if (old) node_free(old);
+    while (shard->count >= shard->capacity) shard_evict_lru(shard);
+
+    uint32_t bucket = bucket_for(hash);
+    node->hash_next = shard->buckets[bucket];
+    shard->buckets[bucket] = node;
+    lru_push_front(shard, node);
+    shard->count++;
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+static void cache_invalidate_key(memory_cache_t* cache, const str_t* key) {
+    uint64_t hash = key_hash(key);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    shard->generation++;
+    cache_node_t* node = shard_find(shard, hash, key, true);
+    pthread_mutex_unlock(&shard->lock);
+
+    if (node) node_free(node);
+    STAT_INC(invalidations);
+}
+
+static void cache_invalidate_all(memory_cache_t* cache) {
+    for (uint32_t i = 0; i < CACHE_SHARDS; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        shard->generation++;
+        shard_clear(shard);
+        pthread_mutex_unlock(&shard->lock);
+    }
+    STAT_INC(invalidations);
+}
+
+err_t memory_cached_wrap(memory_t* inner, uint32_t capacity, memory_t** out_memory) {
+    if (!inner || !out_memory || capacity == 0) return ERR_INVALID_ARGUMENT;
+
+    memory_cache_t* cache = calloc(1, sizeof(memory_cache_t));
+    if (!cache) return ERR_OUT_OF_MEMORY;
+
+    uint32_t per_shard = (capacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+    for (uint32_t i = 0; i < CACHE_SHARDS; i++) {
+        pthread_mutex_init(&cache->shards[i].lock, NULL);
+        cache->shards[i].capacity = per_shard;
+    }
+    cache->inner = inner;
+
+    memory_t* memory = memory_alloc(&cached_vtable);
+    if (!memory) {
+        free(cache);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    memory->config = inner->config;
+    memory->impl_data = cache;
+    memory->wrapped = inner;
+    memory->initialized = inner->initialized;
+
+    *out_memory = memory;
+    return ERR_OK;
+}
+
+void memory_cache_stats(memory_cache_stats_t* out_stats) {
+    if (!out_stats) return;
+    out_stats->hits = __atomic_load_n(&g_cache_stats.hits, __ATOMIC_RELAXED);
+    out_stats->negative_hits = __atomic_load_n(&g_cache_stats.negative_hits, __ATOMIC_RELAXED);
+    out_stats->misses = __atomic_load_n(&g_cache_stats.misses, __ATOMIC_RELAXED);
+    out_stats->evictions = __atomic_load_n(&g_cache_stats.evictions, __ATOMIC_RELAXED);
+    out_stats->invalidations = __atomic_load_n(&g_cache_stats.invalidations, __ATOMIC_RELAXED);
+}
+
+double memory_cache_hit_rate(const memory_cache_stats_t* stats) {
+    if (!stats) return 0.0;
+    uint64_t hits = stats->hits + stats->negative_hits;
+    uint64_t total = hits + stats->misses;
+    return total ? (double)hits / (double)total : 0.0;
+}
+
+// Prometheus text exposition; returns the length written (truncated to size)
+size_t memory_cache_metrics(char* buffer, size_t size) {
+    if (!buffer || size == 0) return 0;
+
+    memory_cache_stats_t stats;
+    memory_cache_stats(&stats);
+
+    int n = snprintf(buffer, size,
+        "# HELP cclaw_memory_cache_hits_total Recalls served from the memory cache\n"
+        "# TYPE cclaw_memory_cache_hits_total counter\n"
+        "cclaw_memory_cache_hits_total{result=\"found\"} %llu\n"
+        "cclaw_memory_cache_hits_total{result=\"not_found\"} %llu\n"
+        "# HELP cclaw_memory_cache_misses_total Recalls forwarded to the backend\n"
+        "# TYPE cclaw_memory_cache_misses_total counter\n"
+        "cclaw_memory_cache_misses_total %llu\n"
+        "# HELP cclaw_memory_cache_evictions_total LRU evictions\n"
+        "# TYPE cclaw_memory_cache_evictions_total counter\n"
+        "cclaw_memory_cache_evictions_total %llu\n"
+        "# HELP cclaw_memory_cache_invalidations_total Write-through invalidations\n"
+        "# TYPE cclaw_memory_cache_invalidations_total counter\n"
+        "cclaw_memory_cache_invalidations_total %llu\n"
+        "# HELP cclaw_memory_cache_hit_ratio Fraction of recalls served from cache\n"
+        "# TYPE cclaw_memory_cache_hit_ratio gauge\n"
+        "cclaw_memory_cache_hit_ratio %.4f\n",
+        (unsigned long long)stats.hits, (unsigned long long)stats.negative_hits,
+        (unsigned long long)stats.misses, (unsigned long long)stats.evictions,
+        (unsigned long long)stats.invalidations, memory_cache_hit_rate(&stats));
+    if (n < 0) return 0;
+    return (size_t)n >= size ? size - 1 : (size_t)n;
+}
+
+static str_t cached_get_name(void) {
+    return STR_LIT("cached");
+}
+
+static str_t cached_get_version(void) {
+    return STR_LIT("1.0.0");
+}
+
+static err_t cached_create(const memory_config_t* config, memory_t** out_memory) {
+    (void)config;
+    (void)out_memory;
+    // Decorators are built with memory_cached_wrap()
+    return ERR_NOT_IMPLEMENTED;
+}
+
+static void cached_destroy(memory_t* memory) {
+    if (!memory) return;
+
+    memory_cache_t* cache = CACHE(memory);
+    if (cache) {
+        for (uint32_t i = 0; i < CACHE_SHARDS; i++) {
+            shard_clear(&cache->shards[i]);
+            pthread_mutex_destroy(&cache->shards[i].lock);
+        }
+        memory_free(cache->inner);
+        free(cache);
+    }
+    free(memory);
+}
+
+static err_t cached_init(memory_t* memory) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    err_t err = inner->vtable->init(inner);
+    memory->initialized = inner->initialized;
+    return err;
+}
+
+static void cached_cleanup(memory_t* memory) {
+    if (!memory || !memory->impl_data) return;
+
+    memory_t* inner = INNER(memory);
+    inner->vtable->cleanup(inner);
+    cache_invalidate_all(CACHE(memory));
+    memory->initialized = inner->initialized;
+}
+
+static err_t cached_store(memory_t* memory, const memory_entry_t* entry) {
+    if (!memory || !memory->impl_data || !entry) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    err_t err = inner->vtable->store(inner, entry);
+    cache_invalidate_key(CACHE(memory), &entry->key);
+    return err;
+}
+
+static err_t cached_store_multiple(memory_t* memory, const memory_entry_t* entries, uint32_t count) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    if (!inner->vtable->store_multiple) return ERR_NOT_IMPLEMENTED;
+    err_t err = inner->vtable->store_multiple(inner, entries, count);
+    for (uint32_t i = 0; entries && i < count; i++) {
+        cache_invalidate_key(CACHE(memory), &entries[i].key);
+    }
+    return err;
+}
+
+static err_t cached_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry) {
+    if (!memory || !memory->impl_data || !key || !out_entry) return ERR_INVALID_ARGUMENT;
+
+    memory_cache_t* cache = CACHE(memory);
+    uint64_t hash = key_hash(key);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    cache_node_t* node = shard_find(shard, hash, key, false);
+    if (node) {
+        lru_unlink(shard, node);
+        lru_push_front(shard, node);
+        bool negative = node->negative;
+        if (!negative) entry_copy(out_entry, &node->entry);
+        pthread_mutex_unlock(&shard->lock);
+
+        if (negative) {
+            STAT_INC(negative_hits);
+            return ERR_NOT_FOUND;
+        }
+        STAT_INC(hits);
+        return ERR_OK;
+    }
+    uint64_t generation = shard->generation;
+    pthread_mutex_unlock(&shard->lock);
+
+    STAT_INC(misses);
+    memory_t* inner = INNER(memory);
+    err_t err = inner->vtable->recall(inner, key, out_entry);
+    if (err == ERR_OK) {
+        cache_insert(cache, hash, key, out_entry, generation);
+    } else if (err == ERR_NOT_FOUND) {
+        cache_insert(cache, hash, key, NULL, generation);
+    }
+    return err;
+}
+
+static err_t cached_recall_by_id(memory_t* memory, const str_t* id, memory_entry_t* out_entry) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    CACHED_FORWARD(memory, recall_by_id, id, out_entry);
+}
+
+static err_t cached_search(memory_t* memory, const str_t* query, const memory_search_opts_t* opts,
+                           memory_entry_t** out_entries, uint32_t* out_count) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    CACHED_FORWARD(memory, search, query, opts, out_entries, out_count);
+}
+
+static err_t cached_forget(memory_t* memory, const str_t* key) {
+    if (!memory || !memory->impl_data || !key) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    if (!inner->vtable->forget) return ERR_NOT_IMPLEMENTED;
+    err_t err = inner->vtable->forget(inner, key);
+    cache_invalidate_key(CACHE(memory), key);
+    return err;
+}
+
+static err_t cached_forget_by_id(memory_t* memory, const str_t* id) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    if (!inner->vtable->forget_by_id) return ERR_NOT_IMPLEMENTED;
+    err_t err = inner->vtable->forget_by_id(inner, id);
+    cache_invalidate_all(CACHE(memory));
+    return err;
+}
+
+static err_t cached_forget_old(memory_t* memory, uint64_t cutoff_timestamp) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    if (!inner->vtable->forget_old) return ERR_NOT_IMPLEMENTED;
+    err_t err = inner->vtable->forget_old(inner, cutoff_timestamp);
+    cache_invalidate_all(CACHE(memory));
+    return err;
+}
+
+static err_t cached_get_stats(memory_t* memory, uint32_t* total_entries, uint32_t* by_category_counts) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    CACHED_FORWARD(memory, get_stats, total_entries, by_category_counts);
+}
+
+static err_t cached_backup(memory_t* memory, const str_t* backup_path) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    CACHED_FORWARD(memory, backup, backup_path);
+}
+
+static err_t cached_restore(memory_t* memory, const str_t* backup_path) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    if (!inner->vtable->restore) return ERR_NOT_IMPLEMENTED;
+    err_t err = inner->vtable->restore(inner, backup_path);
+    cache_invalidate_all(CACHE(memory));
+    return err;
+}
@@ -3,18 +3,24 @@
 
 #include "core/memory.h"
 #include "core/alloc.h"
+#include "utils/compress.h"
+#include "utils/tar.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <time.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 // Markdown memory instance data
 typedef struct markdown_memory_t {
     char* base_dir;
     bool use_compression;
     bool use_categories;  // Store in separate category directories
+    const compress_codec_t* codec;
 } markdown_memory_t;
 
 // Forward declarations for vtable
@@ -159,6 +165,12 @@ static str_t markdown_get_version(void) {
 static err_t markdown_create(const memory_config_t* config, memory_t** out_memory) {
     if (!config || !out_memory) return ERR_INVALID_ARGUMENT;
 
+    const compress_codec_t* codec = NULL;
+    if (config->compression) {
+        codec = compress_codec_select(config->compression_codec);
+        if (!codec) return ERR_NOT_IMPLEMENTED;
+    }
+
     memory_t* memory = memory_alloc(&markdown_vtable);
     if (!memory) return ERR_OUT_OF_MEMORY;
 
@@ -191,6 +203,7 @@ static err_t markdown_create(const memory_config_t* config, memory_t** out_memor
     }
 
     md_mem->use_compression = config->compression;
+    md_mem->codec = codec;
     md_mem->use_categories = true; // Always use categories for markdown
 
     memory->impl_data = md_mem;
@@ -261,12 +274,40 @@ static err_t markdown_store(memory_t* memory, const memory_entry_t* entry) {
     char* filepath = get_entry_filepath(md_mem, entry);
     if (!filepath) return ERR_OUT_OF_MEMORY;
 
-    // Create Markdown content
-    FILE* f = fopen(filepath, "w");
+    // Compressed bodies are written as a raw compress.h frame after the
+    // frontmatter; the encoding line tells readers to inflate it
+    void* frame = NULL;
+    size_t frame_len = 0;
+    if (md_mem->codec) {
+        err_t err = compress_frame(md_mem->codec, entry->content.data, entry->content.len,
+                                   &frame, &frame_len);
+        if (err != ERR_OK) {
+            free(filepath);
+            return err;
+        }
+    }
+
+    // Written to a temporary file and renamed over the entry, so readers
+    // and backups only ever see a complete file
+    size_t tmp_len = strlen(filepath) + 16;
+    char* tmp_path = malloc(tmp_len);
+    int fd = -1;
+    if (tmp_path) {
+        snprintf(tmp_path, tmp_len, "%s.tmp-XXXXXX", filepath);
+        fd = mkstemp(tmp_path);
+    }
+    FILE* f = fd >= 0 ? fdopen(fd, "wb") : NULL;
     if (!f) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        free(tmp_path);
+        free(frame);
         free(filepath);
-        return ERR_IO;
+        return tmp_path ? ERR_IO : ERR_OUT_OF_MEMORY;
     }
+    fchmod(fd, 0644);
 
     // Write metadata as YAML frontmatter
     fprintf(f, "---\n");
@@ -278,14 +319,27 @@ static err_t markdown_store(memory_t* memory, const memory_entry_t* entry) {
         fprintf(f, "session_id: %.*s\n", (int)entry->session_id.len, entry->session_id.data);
     }
     fprintf(f, "score: %f\n", entry->score);
+    if (frame) {
+        fprintf(f, "encoding: %s\n", md_mem->codec->name);
+    }
     fprintf(f, "---\n\n");
 
     // Write content
-    fprintf(f, "%.*s\n", (int)entry->content.len, entry->content.data);
+    if (frame) {
+        fwrite(frame, 1, frame_len, f);
+    } else {
+        fprintf(f, "%.*s\n", (int)entry->content.len, entry->content.data);
+    }
 
-    fclose(f);
+    bool failed = ferror(f) != 0;
+    if (fclose(f) != 0) failed = true;
+    if (!failed && rename(tmp_path, filepath) != 0) failed = true;
+    if (failed) unlink(tmp_path);
+    memory_bump_generation(memory);
+    free(tmp_path);
+    free(frame);
     free(filepath);
-    return ERR_OK;
+    return failed ? ERR_WRITE_FAILED : ERR_OK;
 }
 
 static err_t markdown_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry) {
@@ -312,23 +366,117 @@ static err_t markdown_recall_by_id(memory_t* memory, const str_t* id, memory_ent
     return ERR_NOT_IMPLEMENTED;
 }
 
-static bool file_matches_query(const char* filepath, const char* query) {
-    FILE* f = fopen(filepath, "r");
-    if (!f) return false;
+// Read a whole entry file into a NUL-terminated buffer
+static char* read_file(const char* filepath, size_t* out_len) {
+    FILE* f = fopen(filepath, "rb");
+    if (!f) return NULL;
 
-    // Simple check: read file and search for query substring
-    char buffer[4096];
-    bool found = false;
-    size_t query_len = strlen(query);
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || st.st_size < 0) {
+        fclose(f);
+        return NULL;
+    }
 
-    while (fgets(buffer, sizeof(buffer), f) && !found) {
-        if (strstr(buffer, query) != NULL) {
-            found = true;
-        }
+    size_t size = (size_t)st.st_size;
+    char* data = malloc(size + 1);
+    if (!data) {
+        fclose(f);
+        return NULL;
     }
 
+    size_t got = fread(data, 1, size, f);
     fclose(f);
-    return found;
+
+    data[got] = '\0';
+    *out_len = got;
+    return data;
+}
+
+static str_t dup_field(const char* value, size_t len) {
+    char* copy = strndup(value, len);
+    return copy ? (str_t){ .data = copy, .len = (uint32_t)len } : STR_NULL;
+}
+
+// Parse an entry file written by markdown_store(): YAML-ish frontmatter, a
+// blank line, then the body as plain text or as a compression frame. The
+// body is only inflated here, once the file is actually being returned or
+// matched; the frontmatter stays readable either way.
+static err_t parse_entry_file(const char* data, size_t len, memory_entry_t* out) {
+    memset(out, 0, sizeof(*out));
+    out->category = MEMORY_CATEGORY_CUSTOM;
+    out->score = 1.0;
+
+    if (len < 4 || strncmp(data, "---\n", 4) != 0) return ERR_MEMORY_CORRUPT;
+
+    const char* p = data + 4;
+    const char* end = data + len;
+    bool compressed = false;
+
+    while (p < end) {
+        const char* eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) return ERR_MEMORY_CORRUPT;
+
+        size_t line_len = (size_t)(eol - p);
+        if (line_len == 3 && strncmp(p, "---", 3) == 0) {
+            p = eol + 1;
+            break;
+        }
+
+        const char* colon = memchr(p, ':', line_len);
+        if (colon && colon + 1 < eol && colon[1] == ' ') {
+            size_t name_len = (size_t)(colon - p);
+            const char* value = colon + 2;
+            size_t value_len = (size_t)(eol - value);
+
+            if (name_len == 2 && strncmp(p, "id", 2) == 0) {
+                out->id = dup_field(value, value_len);
+            } else if (name_len == 3 && strncmp(p, "key", 3) == 0) {
+                out->key = dup_field(value, value_len);
+            } else if (name_len == 8 && strncmp(p, "category", 8) == 0) {
+                out->category = (memory_category_t)atoi(value);
+            } else if (name_len == 9 && strncmp(p, "timestamp", 9) == 0) {
+                out->timestamp = dup_field(value, value_len);
+            } else if (name_len == 10 && strncmp(p, "session_id", 10) == 0) {
+                out->session_id = dup_field(value, value_len);
+            } else if (name_len == 5 && strncmp(p, "score", 5) == 0) {
+                out->score = strtod(value, NULL);
+            } else if (name_len == 8 && strncmp(p, "encoding", 8) == 0) {
+                compressed = true;
+            }
+        }
+        p = eol + 1;
+    }
+
+    if (p < end && *p == '\n') p++;
+    size_t body_len = (size_t)(end - p);
+
+    if (compressed) {
+        char* text = NULL;
+        size_t text_len = 0;
+        err_t err = decompress_frame(p, body_len, &text, &text_len);
+        if (err != ERR_OK) return err;
+        out->content.data = text;
+        out->content.len = (uint32_t)text_len;
+    } else {
+        // Plain bodies carry the trailing newline markdown_store() appended
+        if (body_len > 0 && p[body_len - 1] == '\n') body_len--;
+        out->content = dup_field(p, body_len);
+    }
+
+    return out->content.data ? ERR_OK : ERR_OUT_OF_MEMORY;
+}
+
+static void entry_fields_free(memory_entry_t* entry) {
+    free((void*)entry->id.data);
+    free((void*)entry->key.data);
+    free((void*)entry->content.data);
+    free((void*)entry->timestamp.data);
+    free((void*)entry->session_id.data);
+}
+
+static bool entry_matches_query(const memory_entry_t* entry, const char* query) {
+    if (entry->key.data && strstr(entry->key.data, query)) return true;
+    return entry->content.data && strstr(entry->content.data, query);
 }
 
 static err_t scan_directory(const char* dirpath, const char* query,
@@ -355,19 +503,26 @@ static err_t scan_directory(const char* dirpath, const char* query,
         char filepath[1024];
         snprintf(filepath, sizeof(filepath), "%s/%s", dirpath, entry->d_name);
 
-        if (!file_matches_query(filepath, query)) {
+        size_t data_len = 0;
+        char* data = read_file(filepath, &data_len);
+        if (!data) continue;
+
+        // There is no index to consult, so matching needs the plain text;
+        // entries that fail to parse are skipped rather than failing the scan
+        memory_entry_t parsed;
+        err_t parse_err = parse_entry_file(data, data_len, &parsed);
+        free(data);
+        if (parse_err != ERR_OK || !entry_matches_query(&parsed, query)) {
+            entry_fields_free(&parsed);
             continue;
         }
 
-        // Read file and parse entry
-        FILE* f = fopen(filepath, "r");
-        if (!f) continue;
-
         // Resize entries array if needed
         if (count >= capacity) {
             capacity = capacity ? capacity * 2 : 16;
             memory_entry_t* new_entries = realloc(entries, capacity * sizeof(memory_entry_t));
             if (!new_entries) {
+                entry_fields_free(&parsed);
                 closedir(dir);
                 memory_entry_array_free(entries, count);
                 return ERR_OUT_OF_MEMORY;
@@ -375,30 +530,15 @@ static err_t scan_directory(const char* dirpath, const char* query,
             entries = new_entries;
         }
 
-        // Simple parsing - in reality would need proper YAML frontmatter parsing
-        // For now, just create a minimal entry
-        memory_entry_t* mem_entry = &entries[count];
-
-        // Extract key from filename (remove .md extension)
-        char* key = strndup(entry->d_name, name_len - 3);
-        if (key) {
-            // TODO: decode safe_key back to original key
-            mem_entry->key.data = key;
-            mem_entry->key.len = strlen(key);
-        } else {
-            mem_entry->key = STR_NULL;
+        // Files written before the frontmatter carried every field fall
+        // back to the filename (still hex-encoded) as the key
+        if (!parsed.key.data) {
+            parsed.key = dup_field(entry->d_name, name_len - 3);
         }
+        if (!parsed.id.data) parsed.id = str_dup_cstr("markdown-entry", NULL);
+        if (!parsed.timestamp.data) parsed.timestamp = str_dup_cstr("", NULL);
 
-        // TODO: Parse actual content from file
-        mem_entry->content = STR_LIT("[Content would be parsed from file]");
-        mem_entry->id = STR_LIT("markdown-entry");
-        mem_entry->category = MEMORY_CATEGORY_CUSTOM; // Would parse from frontmatter
-        mem_entry->timestamp = STR_LIT("2025-01-01 00:00:00");
-        mem_entry->session_id = STR_NULL;
-        mem_entry->score = 1.0;
-
-        fclose(f);
-        count++;
+        entries[count++] = parsed;
     }
 
     closedir(dir);
@@ -537,15 +677,259 @@ static err_t markdown_get_stats(memory_t* memory, uint32_t* total_entries, uint3
     return ERR_OK;
 }
 
+// ============================================================================
+// Backup and restore
+// ============================================================================
+
+// A backup is a tar archive of the category directories, streamed one file
+// at a time so its size does not depend on how many memories there are.
+// Stores replace entry files by rename, so every file read here is whole.
+// Restores unpack into a staging directory under base_dir and then swap
+// each category directory in with two renames.
+
+static const char* const markdown_category_dirs[] = {"core", "daily", "conversation", "custom"};
+#define MARKDOWN_CATEGORY_COUNT (sizeof(markdown_category_dirs) / sizeof(markdown_category_dirs[0]))
+
+static bool is_entry_file_name(const char* name) {
+    size_t len = strlen(name);
+    return len >= 4 && len <= 255 && name[0] != '.' && !strchr(name, '/') &&
+           strcmp(name + len - 3, ".md") == 0;
+}
+
+// snprintf into a path buffer; false when the path would be cut short
+__attribute__((format(printf, 3, 4)))
+static bool format_path(char* out, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out, size, format, args);
+    va_end(args);
+    return n >= 0 && (size_t)n < size;
+}
+
+static bool is_category_dir(const char* name, size_t len) {
+    for (size_t i = 0; i < MARKDOWN_CATEGORY_COUNT; i++) {
+        if (strlen(markdown_category_dirs[i]) == len &&
+            memcmp(markdown_category_dirs[i], name, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static err_t backup_category(FILE* out, const char* base_dir, const char* category) {
+    char dirpath[1024];
+    if (!format_path(dirpath, sizeof(dirpath), "%s/%s", base_dir, category)) return ERR_INVALID_ARGUMENT;
+
+    DIR* dir = opendir(dirpath);
+    if (!dir) return ERR_IO;
+
+    struct stat st;
+    err_t err = fstat(dirfd(dir), &st) == 0 ? ERR_OK : ERR_IO;
+    if (err == ERR_OK) err = tar_write_directory(out, category, 0755, (uint64_t)st.st_mtime);
+
+    struct dirent* entry;
+    while (err == ERR_OK && (entry = readdir(dir)) != NULL) {
+        if (!is_entry_file_name(entry->d_name)) continue;
+
+        int fd = openat(dirfd(dir), entry->d_name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) continue;    // Removed since the listing
+
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            char name[TAR_MAX_NAME];
+            err = format_path(name, sizeof(name), "%s/%s", category, entry->d_name)
+                      ? tar_write_file(out, name, fd, (uint64_t)st.st_size, st.st_mode & 0777,
+                                       (uint64_t)st.st_mtime)
+                      : ERR_INVALID_ARGUMENT;
+        }
+        close(fd);
+    }
+
+    closedir(dir);
+    return err;
+}
+
 static err_t markdown_backup(memory_t* memory, const str_t* backup_path) {
-    // For markdown backend, backup is just copying files
-    (void)memory;
-    (void)backup_path;
-    return ERR_NOT_IMPLEMENTED;
+    if (!memory || !memory->impl_data || !memory->initialized ||
+        !backup_path || str_empty(*backup_path)) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    markdown_memory_t* md_mem = (markdown_memory_t*)memory->impl_data;
+
+    char path[4096];
+    char tmp_path[4096 + 8];
+    if (backup_path->len >= sizeof(path)) return ERR_INVALID_ARGUMENT;
+    snprintf(path, sizeof(path), "%.*s", (int)backup_path->len, backup_path->data);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* out = fopen(tmp_path, "wb");
+    if (!out) return ERR_IO;
+
+    err_t err = ERR_OK;
+    for (size_t i = 0; err == ERR_OK && i < MARKDOWN_CATEGORY_COUNT; i++) {
+        err = backup_category(out, md_mem->base_dir, markdown_category_dirs[i]);
+    }
+    if (err == ERR_OK) err = tar_write_end(out);
+    if (err == ERR_OK && (fflush(out) != 0 || fsync(fileno(out)) != 0)) err = ERR_WRITE_FAILED;
+    if (fclose(out) != 0 && err == ERR_OK) err = ERR_WRITE_FAILED;
+
+    if (err == ERR_OK && rename(tmp_path, path) != 0) err = ERR_IO;
+    if (err != ERR_OK) unlink(tmp_path);
+    return err;
+}
+
+// Removes a category directory and the entry files in it
+static void remove_category_tree(const char* dirpath) {
+    DIR* dir = opendir(dirpath);
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                unlinkat(dirfd(dir), entry->d_name, 0);
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(dirpath);
+}
+
+static void remove_staging(const char* staging) {
+    for (size_t i = 0; i < MARKDOWN_CATEGORY_COUNT; i++) {
+        char dirpath[1024];
+        if (format_path(dirpath, sizeof(dirpath), "%s/%s", staging, markdown_category_dirs[i])) {
+            remove_category_tree(dirpath);
+        }
+        if (format_path(dirpath, sizeof(dirpath), "%s/%s.old", staging, markdown_category_dirs[i])) {
+            remove_category_tree(dirpath);
+        }
+    }
+    rmdir(staging);
+}
+
+// Only "<category>/" and "<category>/<name>.md" are accepted, so nothing
+// in the archive can land outside the staging directory
+static err_t extract_entry(FILE* in, const tar_entry_t* entry, const char* staging) {
+    const char* slash = strchr(entry->name, '/');
+    if (!slash || !is_category_dir(entry->name, (size_t)(slash - entry->name))) {
+        return ERR_MEMORY_CORRUPT;
+    }
+
+    if (entry->type == TAR_TYPE_DIRECTORY) {
+        if (slash[1] != '\0') return ERR_MEMORY_CORRUPT;
+        return tar_read_data(in, entry, NULL);
+    }
+    if (entry->type != TAR_TYPE_FILE || !is_entry_file_name(slash + 1)) {
+        return ERR_MEMORY_CORRUPT;
+    }
+
+    char filepath[2048];
+    if (!format_path(filepath, sizeof(filepath), "%s/%s", staging, entry->name)) return ERR_IO;
+    int fd = open(filepath, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+    FILE* out = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!out) {
+        if (fd >= 0) close(fd);
+        return ERR_IO;
+    }
+
+    err_t err = tar_read_data(in, entry, out);
+    if (fclose(out) != 0 && err == ERR_OK) err = ERR_WRITE_FAILED;
+    return err;
+}
+
+// Where one category lives, is unpacked to, and is moved aside to
+typedef struct category_swap_t {
+    char live[1024];
+    char restored[1024];
+    char old[1024];
+} category_swap_t;
+
+static bool category_swap_paths(category_swap_t* swap, const char* base_dir,
+                                const char* staging, const char* category) {
+    return format_path(swap->live, sizeof(swap->live), "%s/%s", base_dir, category) &&
+           format_path(swap->restored, sizeof(swap->restored), "%s/%s", staging, category) &&
+           format_path(swap->old, sizeof(swap->old), "%s/%s.old", staging, category);
 }
 
 static err_t markdown_restore(memory_t* memory, const str_t* backup_path) {
-    (void)memory;
-    (void)backup_path;
-    return ERR_NOT_IMPLEMENTED;
-}
\ No newline at end of file
+    if (!memory || !memory->impl_data || !memory->initialized ||
+        !backup_path || str_empty(*backup_path)) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    markdown_memory_t* md_mem = (markdown_memory_t*)memory->impl_data;
+
+    char path[4096];
+    if (backup_path->len >= sizeof(path)) return ERR_INVALID_ARGUMENT;
+    snprintf(path, sizeof(path), "%.*s", (int)backup_path->len, backup_path->data);
+
+    char staging[1024];
+    if (!format_path(staging, sizeof(staging), "%s/.restore-XXXXXX", md_mem->base_dir)) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    FILE* in = fopen(path, "rb");
+    if (!in) return ERR_FILE_NOT_FOUND;
+
+    if (!mkdtemp(staging)) {
+        fclose(in);
+        return ERR_IO;
+    }
+
+    category_swap_t swaps[MARKDOWN_CATEGORY_COUNT];
+    err_t err = ERR_OK;
+    for (size_t i = 0; err == ERR_OK && i < MARKDOWN_CATEGORY_COUNT; i++) {
+        if (!category_swap_paths(&swaps[i], md_mem->base_dir, staging, markdown_category_dirs[i])) {
+            err = ERR_INVALID_ARGUMENT;
+        } else if (mkdir(swaps[i].restored, 0755) != 0) {
+            err = ERR_IO;
+        }
+    }
+    if (err != ERR_OK) {
+        fclose(in);
+        remove_staging(staging);
+        return err;
+    }
+
+    // The whole archive is unpacked and checked before anything is replaced
+    bool end = false;
+    while (err == ERR_OK) {
+        tar_entry_t entry;
+        err = tar_read_header(in, &entry, &end);
+        if (err != ERR_OK || end) break;
+        err = extract_entry(in, &entry, staging);
+    }
+    fclose(in);
+    if (err == ERR_INVALID_ARGUMENT) err = ERR_MEMORY_CORRUPT;
+
+    size_t swapped = 0;
+    while (err == ERR_OK && swapped < MARKDOWN_CATEGORY_COUNT) {
+        category_swap_t* swap = &swaps[swapped];
+        if (rename(swap->live, swap->old) != 0) {
+            err = ERR_IO;
+        } else if (rename(swap->restored, swap->live) != 0) {
+            rename(swap->old, swap->live);
+            err = ERR_IO;
+        } else {
+            swapped++;
+        }
+    }
+
+    // A failed swap puts back the categories already swapped, so the
+    // store is never half restored. What cannot be put back stays in
+    // staging rather than being removed with it.
+    bool rolled_back = true;
+    while (err != ERR_OK && swapped > 0) {
+        category_swap_t* swap = &swaps[--swapped];
+        if (rename(swap->live, swap->restored) != 0 || rename(swap->old, swap->live) != 0) {
+            rolled_back = false;
+        }
+    }
+
+    if (rolled_back) {
+        remove_staging(staging);
+    } else {
+        err = ERROR_SET(ERR_IO, "restore failed; earlier entries are left in %s", staging);
+    }
+    memory_bump_generation(memory);
+    return err;
+}
@@ -2,26 +2,56 @@
 // SPDX-License-Identifier: MIT
 
 #include "core/memory.h"
+#include "core/alloc.h"
+#include "utils/compress.h"
 #include <sqlite3.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
-// SQLite memory instance data
-typedef struct sqlite_memory_t {
+// One connection and the statements prepared on it. Connections are
+// opened with SQLITE_OPEN_NOMUTEX, so each is used by one thread at a time:
+// the writer under writer_lock, readers while checked out of the pool.
+typedef struct sqlite_conn_t {
     sqlite3* db;
-    sqlite3_stmt* stmt_insert;
+    sqlite3_stmt* stmt_insert;          // Writer only
     sqlite3_stmt* stmt_select_by_key;
     sqlite3_stmt* stmt_select_by_id;
     sqlite3_stmt* stmt_search;
-    sqlite3_stmt* stmt_delete_by_key;
-    sqlite3_stmt* stmt_delete_by_id;
-    sqlite3_stmt* stmt_delete_old;
+    sqlite3_stmt* stmt_delete_by_key;   // Writer only
+    sqlite3_stmt* stmt_delete_by_id;    // Writer only
+    sqlite3_stmt* stmt_delete_old;      // Writer only
+    sqlite3_stmt* stmt_rows_by_key;     // Writer only, rows a delete will remove
+    sqlite3_stmt* stmt_rows_by_id;      // Writer only
+    sqlite3_stmt* stmt_rows_old;        // Writer only
+    sqlite3_stmt* stmt_fts_insert;      // Writer only
+    sqlite3_stmt* stmt_fts_delete;      // Writer only
     sqlite3_stmt* stmt_count_total;
     sqlite3_stmt* stmt_count_by_category;
+    struct sqlite_conn_t* next_free;
+} sqlite_conn_t;
+
+// SQLite memory instance data
+typedef struct sqlite_memory_t {
+    sqlite_conn_t writer;
+    pthread_mutex_t writer_lock;
+
+    // Read-only connections for recall, search and stats. In WAL mode they
+    // read the last committed state without waiting for the writer. Empty
+    // for in-memory databases, which cannot be shared between connections;
+    // reads then go through the writer.
+    sqlite_conn_t* readers;
+    uint32_t reader_count;
+    sqlite_conn_t* free_readers;
+    pthread_mutex_t pool_lock;
+    pthread_cond_t reader_returned;
+
     char* db_path;
     bool use_compression;
+    const compress_codec_t* codec;
 } sqlite_memory_t;
 
 // Forward declarations for vtable
@@ -86,16 +116,49 @@ static const char* get_table_schema(void) {
            "CREATE INDEX IF NOT EXISTS idx_memories_key ON memories(key);"
            "CREATE INDEX IF NOT EXISTS idx_memories_category ON memories(category);"
            "CREATE INDEX IF NOT EXISTS idx_memories_created_at ON memories(created_at);"
-           "CREATE VIRTUAL TABLE IF NOT EXISTS memories_fts USING fts5(key, content, tokenize='porter');"
-           "CREATE TRIGGER IF NOT EXISTS memories_ai AFTER INSERT ON memories BEGIN "
-           "  INSERT INTO memories_fts(rowid, key, content) VALUES (new.rowid, new.key, new.content);"
-           "END;"
-           "CREATE TRIGGER IF NOT EXISTS memories_ad AFTER DELETE ON memories BEGIN "
-           "  DELETE FROM memories_fts WHERE rowid = old.rowid;"
-           "END;";
+           // Contentless: the index keeps only tokens, not a second plain
+           // copy of every row. Rows are added and removed by the store and
+           // forget paths, which have the uncompressed text at hand.
+           "CREATE VIRTUAL TABLE IF NOT EXISTS memories_fts USING fts5(key, content, content='', tokenize='porter');"
+           // Left over from databases that filled the index through triggers
+           "DROP TRIGGER IF EXISTS memories_ai;"
+           "DROP TRIGGER IF EXISTS memories_ad;";
+}
+
+// ============================================================================
+// Content compression
+// ============================================================================
+
+// With compression enabled, content is stored as a BLOB holding a compress.h
+// frame; short or incompressible entries stay TEXT. Rows are decoded by type,
+// so a database can mix both and the config flag can be flipped freely.
+// Content is inflated when a row is turned into a memory_entry_t, and when
+// a row is removed from the full-text index, which needs the text it was
+// indexed with.
+
+static err_t column_content(sqlite3_stmt* stmt, int col, str_t* out) {
+    if (sqlite3_column_type(stmt, col) == SQLITE_BLOB) {
+        const void* blob = sqlite3_column_blob(stmt, col);
+        size_t blob_len = (size_t)sqlite3_column_bytes(stmt, col);
+        if (compress_is_frame(blob, blob_len)) {
+            char* text = NULL;
+            size_t text_len = 0;
+            err_t err = decompress_frame(blob, blob_len, &text, &text_len);
+            if (err != ERR_OK) return err;
+            out->data = text;
+            out->len = (uint32_t)text_len;
+            return ERR_OK;
+        }
+    }
+
+    const char* text = (const char*)sqlite3_column_text(stmt, col);
+    out->data = strdup(text ? text : "");
+    if (!out->data) return ERR_OUT_OF_MEMORY;
+    out->len = (uint32_t)strlen(out->data);
+    return ERR_OK;
 }
 
-static err_t prepare_statements(sqlite_memory_t* sqlite_mem) {
+static err_t prepare_statements(sqlite_conn_t* conn, bool writer) {
     const char* insert_sql = "INSERT INTO memories (id, key, content, category, timestamp, session_id, score) "
                              "VALUES (?, ?, ?, ?, ?, ?, ?);";
     const char* select_by_key_sql = "SELECT * FROM memories WHERE key = ? ORDER BY created_at DESC LIMIT 1;";
@@ -106,50 +169,172 @@ static err_t prepare_statements(sqlite_memory_t* sqlite_mem) {
     const char* delete_by_key_sql = "DELETE FROM memories WHERE key = ?;";
     const char* delete_by_id_sql = "DELETE FROM memories WHERE id = ?;";
     const char* delete_old_sql = "DELETE FROM memories WHERE created_at < ?;";
+    const char* rows_by_key_sql = "SELECT rowid, key, content FROM memories WHERE key = ?;";
+    const char* rows_by_id_sql = "SELECT rowid, key, content FROM memories WHERE id = ?;";
+    const char* rows_old_sql = "SELECT rowid, key, content FROM memories WHERE created_at < ?;";
+    const char* fts_insert_sql = "INSERT INTO memories_fts(rowid, key, content) VALUES (?, ?, ?);";
+    // A contentless index drops a row given the exact text it was indexed with
+    const char* fts_delete_sql = "INSERT INTO memories_fts(memories_fts, rowid, key, content) "
+                                 "VALUES ('delete', ?, ?, ?);";
     const char* count_total_sql = "SELECT COUNT(*) FROM memories;";
     const char* count_by_category_sql = "SELECT category, COUNT(*) FROM memories GROUP BY category;";
 
     int rc;
-    rc = sqlite3_prepare_v2(sqlite_mem->db, insert_sql, -1, &sqlite_mem->stmt_insert, NULL);
+    rc = sqlite3_prepare_v2(conn->db, select_by_key_sql, -1, &conn->stmt_select_by_key, NULL);
+    if (rc != SQLITE_OK) return ERR_MEMORY;
+
+    rc = sqlite3_prepare_v2(conn->db, select_by_id_sql, -1, &conn->stmt_select_by_id, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, select_by_key_sql, -1, &sqlite_mem->stmt_select_by_key, NULL);
+    rc = sqlite3_prepare_v2(conn->db, search_sql, -1, &conn->stmt_search, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, select_by_id_sql, -1, &sqlite_mem->stmt_select_by_id, NULL);
+    rc = sqlite3_prepare_v2(conn->db, count_total_sql, -1, &conn->stmt_count_total, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, search_sql, -1, &sqlite_mem->stmt_search, NULL);
+    rc = sqlite3_prepare_v2(conn->db, count_by_category_sql, -1, &conn->stmt_count_by_category, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, delete_by_key_sql, -1, &sqlite_mem->stmt_delete_by_key, NULL);
+    if (!writer) return ERR_OK;
+
+    rc = sqlite3_prepare_v2(conn->db, insert_sql, -1, &conn->stmt_insert, NULL);
+    if (rc != SQLITE_OK) return ERR_MEMORY;
+
+    rc = sqlite3_prepare_v2(conn->db, delete_by_key_sql, -1, &conn->stmt_delete_by_key, NULL);
+    if (rc != SQLITE_OK) return ERR_MEMORY;
+
+    rc = sqlite3_prepare_v2(conn->db, delete_by_id_sql, -1, &conn->stmt_delete_by_id, NULL);
+    if (rc != SQLITE_OK) return ERR_MEMORY;
+
+    rc = sqlite3_prepare_v2(conn->db, delete_old_sql, -1, &conn->stmt_delete_old, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, delete_by_id_sql, -1, &sqlite_mem->stmt_delete_by_id, NULL);
+    rc = sqlite3_prepare_v2(conn->db, rows_by_key_sql, -1, &conn->stmt_rows_by_key, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, delete_old_sql, -1, &sqlite_mem->stmt_delete_old, NULL);
+    rc = sqlite3_prepare_v2(conn->db, rows_by_id_sql, -1, &conn->stmt_rows_by_id, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, count_total_sql, -1, &sqlite_mem->stmt_count_total, NULL);
+    rc = sqlite3_prepare_v2(conn->db, rows_old_sql, -1, &conn->stmt_rows_old, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
-    rc = sqlite3_prepare_v2(sqlite_mem->db, count_by_category_sql, -1, &sqlite_mem->stmt_count_by_category, NULL);
+    rc = sqlite3_prepare_v2(conn->db, fts_insert_sql, -1, &conn->stmt_fts_insert, NULL);
+    if (rc != SQLITE_OK) return ERR_MEMORY;
+
+    rc = sqlite3_prepare_v2(conn->db, fts_delete_sql, -1, &conn->stmt_fts_delete, NULL);
     if (rc != SQLITE_OK) return ERR_MEMORY;
 
     return ERR_OK;
 }
 
-static void finalize_statements(sqlite_memory_t* sqlite_mem) {
-    if (sqlite_mem->stmt_insert) sqlite3_finalize(sqlite_mem->stmt_insert);
-    if (sqlite_mem->stmt_select_by_key) sqlite3_finalize(sqlite_mem->stmt_select_by_key);
-    if (sqlite_mem->stmt_select_by_id) sqlite3_finalize(sqlite_mem->stmt_select_by_id);
-    if (sqlite_mem->stmt_search) sqlite3_finalize(sqlite_mem->stmt_search);
-    if (sqlite_mem->stmt_delete_by_key) sqlite3_finalize(sqlite_mem->stmt_delete_by_key);
-    if (sqlite_mem->stmt_delete_by_id) sqlite3_finalize(sqlite_mem->stmt_delete_by_id);
-    if (sqlite_mem->stmt_delete_old) sqlite3_finalize(sqlite_mem->stmt_delete_old);
-    if (sqlite_mem->stmt_count_total) sqlite3_finalize(sqlite_mem->stmt_count_total);
-    if (sqlite_mem->stmt_count_by_category) sqlite3_finalize(sqlite_mem->stmt_count_by_category);
+// Finalizes the statements and closes the connection; safe on a
+// partially opened one
+static void close_connection(sqlite_conn_t* conn) {
+    if (conn->stmt_insert) sqlite3_finalize(conn->stmt_insert);
+    if (conn->stmt_select_by_key) sqlite3_finalize(conn->stmt_select_by_key);
+    if (conn->stmt_select_by_id) sqlite3_finalize(conn->stmt_select_by_id);
+    if (conn->stmt_search) sqlite3_finalize(conn->stmt_search);
+    if (conn->stmt_delete_by_key) sqlite3_finalize(conn->stmt_delete_by_key);
+    if (conn->stmt_delete_by_id) sqlite3_finalize(conn->stmt_delete_by_id);
+    if (conn->stmt_delete_old) sqlite3_finalize(conn->stmt_delete_old);
+    if (conn->stmt_rows_by_key) sqlite3_finalize(conn->stmt_rows_by_key);
+    if (conn->stmt_rows_by_id) sqlite3_finalize(conn->stmt_rows_by_id);
+    if (conn->stmt_rows_old) sqlite3_finalize(conn->stmt_rows_old);
+    if (conn->stmt_fts_insert) sqlite3_finalize(conn->stmt_fts_insert);
+    if (conn->stmt_fts_delete) sqlite3_finalize(conn->stmt_fts_delete);
+    if (conn->stmt_count_total) sqlite3_finalize(conn->stmt_count_total);
+    if (conn->stmt_count_by_category) sqlite3_finalize(conn->stmt_count_by_category);
+    if (conn->db) sqlite3_close(conn->db);
+    memset(conn, 0, sizeof(*conn));
+}
+
+// ============================================================================
+// Full-text index
+// ============================================================================
+
+// memories_fts is contentless, so SQLite cannot see what a row was indexed
+// with. Every change to memories goes through the writer in a transaction
+// that also updates the index: inserts add the plain text, deletes first
+// read the doomed rows back and hand the same text to FTS5's 'delete'
+// command. Rows written by other SQLite clients are not indexed.
+
+static err_t fts_write(sqlite3_stmt* stmt, sqlite3_int64 rowid, const char* key, const char* content) {
+    sqlite3_bind_int64(stmt, 1, rowid);
+    sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, content, -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return rc == SQLITE_DONE ? ERR_OK : ERR_MEMORY;
+}
+
+// Feeds each (rowid, key, content) row of a query to an index statement
+static err_t fts_apply_rows(sqlite3_stmt* rows, sqlite3_stmt* fts) {
+    err_t err = ERR_OK;
+    int rc;
+    while ((rc = sqlite3_step(rows)) == SQLITE_ROW) {
+        str_t content = STR_NULL;
+        err = column_content(rows, 2, &content);
+        if (err != ERR_OK) break;
+
+        err = fts_write(fts, sqlite3_column_int64(rows, 0),
+                        (const char*)sqlite3_column_text(rows, 1), content.data);
+        free((void*)content.data);
+        if (err != ERR_OK) break;
+    }
+    if (err == ERR_OK && rc != SQLITE_DONE) err = ERR_MEMORY;
+
+    sqlite3_reset(rows);
+    return err;
+}
+
+// Indexes every row; used when an old index is replaced and after a restore
+static err_t fts_index_all(sqlite_conn_t* writer) {
+    sqlite3_stmt* rows = NULL;
+    if (sqlite3_prepare_v2(writer->db, "SELECT rowid, key, content FROM memories;",
+                           -1, &rows, NULL) != SQLITE_OK) {
+        return ERR_MEMORY;
+    }
+    err_t err = fts_apply_rows(rows, writer->stmt_fts_insert);
+    sqlite3_finalize(rows);
+    return err;
+}
+
+// Databases from before the contentless index keep a full copy of the text
+// in memories_fts and fill it through a trigger
+static bool fts_is_contentless(sqlite3* db) {
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(db, "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = 'memories_fts';",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        return false;
+    }
+    bool contentless = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* sql = (const char*)sqlite3_column_text(stmt, 0);
+        contentless = sql && strstr(sql, "content=''") != NULL;
+    }
+    sqlite3_finalize(stmt);
+    return contentless;
+}
+
+// Removes the rows selected by `rows` from the index, then runs `del`, in
+// one transaction. The caller binds both statements and holds writer_lock.
+static err_t delete_indexed(sqlite_conn_t* writer, sqlite3_stmt* rows, sqlite3_stmt* del) {
+    err_t err = ERR_OK;
+    if (sqlite3_exec(writer->db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK) {
+        err = ERR_MEMORY;
+    }
+    if (err == ERR_OK) err = fts_apply_rows(rows, writer->stmt_fts_delete);
+    if (err == ERR_OK && sqlite3_step(del) != SQLITE_DONE) err = ERR_MEMORY;
+    sqlite3_reset(rows);
+    sqlite3_reset(del);
+
+    if (err == ERR_OK && sqlite3_exec(writer->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        err = ERR_MEMORY;
+    }
+    if (err != ERR_OK) sqlite3_exec(writer->db, "ROLLBACK;", NULL, NULL, NULL);
+    return err;
 }
 
 static str_t sqlite_get_name(void) {
@@ -160,9 +345,179 @@ static str_t sqlite_get_version(void) {
     return STR_LIT("1.0.0");
 }
 
+// ============================================================================
+// SQLite heap accounting
+// ============================================================================
+
+// SQLite's own heap is routed through the memory subsystem allocator. Each
+// block carries an 8-byte size prefix so xSize does not depend on the
+// platform's malloc introspection.
+
+#define SQLITE_ALLOC allocator_subsystem(ALLOC_SUBSYS_MEMORY)
+#define SQLITE_ALLOC_HEADER 8
+
+static void* sqlite_mem_malloc(int size) {
+    if (size <= 0) return NULL;
+    sqlite3_int64* block = alloc(SQLITE_ALLOC, (size_t)size + SQLITE_ALLOC_HEADER);
+    if (!block) return NULL;
+    block[0] = size;
+    return block + 1;
+}
+
+static void sqlite_mem_free(void* ptr) {
+    if (!ptr) return;
+    sqlite3_int64* block = (sqlite3_int64*)ptr - 1;
+    free_ptr(SQLITE_ALLOC, block, (size_t)block[0] + SQLITE_ALLOC_HEADER);
+}
+
+static void* sqlite_mem_realloc(void* ptr, int size) {
+    if (!ptr) return sqlite_mem_malloc(size);
+
+    sqlite3_int64* block = (sqlite3_int64*)ptr - 1;
+    sqlite3_int64* grown = realloc_ptr(SQLITE_ALLOC, block,
+                                       (size_t)block[0] + SQLITE_ALLOC_HEADER,
+                                       (size_t)size + SQLITE_ALLOC_HEADER);
+    if (!grown) return NULL;
+    grown[0] = size;
+    return grown + 1;
+}
+
+static int sqlite_mem_size(void* ptr) {
+    return ptr ? (int)((sqlite3_int64*)ptr)[-1] : 0;
+}
+
+static int sqlite_mem_roundup(int size) {
+    return (size + 7) & ~7;
+}
+
+static int sqlite_mem_init(void* app_data) {
+    (void)app_data;
+    return SQLITE_OK;
+}
+
+static void sqlite_mem_shutdown(void* app_data) {
+    (void)app_data;
+}
+
+static pthread_once_t g_sqlite_mem_once = PTHREAD_ONCE_INIT;
+
+static void sqlite_install_allocator(void) {
+    static const sqlite3_mem_methods methods = {
+        .xMalloc = sqlite_mem_malloc,
+        .xFree = sqlite_mem_free,
+        .xRealloc = sqlite_mem_realloc,
+        .xSize = sqlite_mem_size,
+        .xRoundup = sqlite_mem_roundup,
+        .xInit = sqlite_mem_init,
+        .xShutdown = sqlite_mem_shutdown,
+        .pAppData = NULL
+    };
+
+    // Fails with SQLITE_MISUSE if the library was already initialized by
+    // someone else; SQLite then keeps its default heap, which is harmless.
+    sqlite3_config(SQLITE_CONFIG_MALLOC, &methods);
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+// Every connection maps the database file so readers share the OS page
+// cache, and keeps a private page cache on top of it
+#define SQLITE_MMAP_SIZE (256LL * 1024 * 1024)
+#define SQLITE_CACHE_KIB 8192
+#define SQLITE_BUSY_TIMEOUT_MS 5000
+
+static err_t open_connection(const char* path, int flags, sqlite_conn_t* conn) {
+    memset(conn, 0, sizeof(*conn));
+
+    int rc = sqlite3_open_v2(path, &conn->db, flags | SQLITE_OPEN_NOMUTEX, NULL);
+    if (rc == SQLITE_OK) rc = sqlite3_busy_timeout(conn->db, SQLITE_BUSY_TIMEOUT_MS);
+    if (rc == SQLITE_OK) {
+        char pragmas[96];
+        snprintf(pragmas, sizeof(pragmas), "PRAGMA mmap_size=%lld; PRAGMA cache_size=-%d;",
+                 SQLITE_MMAP_SIZE, SQLITE_CACHE_KIB);
+        rc = sqlite3_exec(conn->db, pragmas, NULL, NULL, NULL);
+    }
+    if (rc != SQLITE_OK) {
+        close_connection(conn);
+        return ERR_MEMORY;
+    }
+    return ERR_OK;
+}
+
+// Readers are opened once the writer has created the schema
+static err_t open_readers(sqlite_memory_t* sqlite_mem) {
+    if (sqlite_mem->reader_count == 0) return ERR_OK;
+
+    sqlite_mem->readers = calloc(sqlite_mem->reader_count, sizeof(sqlite_conn_t));
+    if (!sqlite_mem->readers) return ERR_OUT_OF_MEMORY;
+
+    for (uint32_t i = 0; i < sqlite_mem->reader_count; i++) {
+        sqlite_conn_t* reader = &sqlite_mem->readers[i];
+        err_t err = open_connection(sqlite_mem->db_path, SQLITE_OPEN_READONLY, reader);
+        if (err == ERR_OK) err = prepare_statements(reader, false);
+        if (err != ERR_OK) return err;
+
+        reader->next_free = sqlite_mem->free_readers;
+        sqlite_mem->free_readers = reader;
+    }
+    return ERR_OK;
+}
+
+static void close_readers(sqlite_memory_t* sqlite_mem) {
+    if (!sqlite_mem->readers) return;
+
+    for (uint32_t i = 0; i < sqlite_mem->reader_count; i++) {
+        close_connection(&sqlite_mem->readers[i]);
+    }
+    free(sqlite_mem->readers);
+    sqlite_mem->readers = NULL;
+    sqlite_mem->free_readers = NULL;
+}
+
+// Takes a reader for one operation, waiting if all are in use. Without a
+// pool the writer is lent out instead, under its lock.
+static sqlite_conn_t* checkout_reader(sqlite_memory_t* sqlite_mem) {
+    if (!sqlite_mem->readers) {
+        pthread_mutex_lock(&sqlite_mem->writer_lock);
+        return &sqlite_mem->writer;
+    }
+
+    pthread_mutex_lock(&sqlite_mem->pool_lock);
+    while (!sqlite_mem->free_readers) {
+        pthread_cond_wait(&sqlite_mem->reader_returned, &sqlite_mem->pool_lock);
+    }
+    sqlite_conn_t* reader = sqlite_mem->free_readers;
+    sqlite_mem->free_readers = reader->next_free;
+    pthread_mutex_unlock(&sqlite_mem->pool_lock);
+    return reader;
+}
+
+static void checkin_reader(sqlite_memory_t* sqlite_mem, sqlite_conn_t* conn) {
+    if (conn == &sqlite_mem->writer) {
+        pthread_mutex_unlock(&sqlite_mem->writer_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&sqlite_mem->pool_lock);
+    conn->next_free = sqlite_mem->free_readers;
+    sqlite_mem->free_readers = conn;
+    pthread_cond_signal(&sqlite_mem->reader_returned);
+    pthread_mutex_unlock(&sqlite_mem->pool_lock);
+}
+
 static err_t sqlite_create(const memory_config_t* config, memory_t** out_memory) {
     if (!config || !out_memory) return ERR_INVALID_ARGUMENT;
 
+    const compress_codec_t* codec = NULL;
+    if (config->compression) {
+        codec = compress_codec_select(config->compression_codec);
+        if (!codec) return ERR_NOT_IMPLEMENTED;
+    }
+
+    pthread_once(&g_sqlite_mem_once, sqlite_install_allocator);
+
     memory_t* memory = memory_alloc(&sqlite_vtable);
     if (!memory) return ERR_OUT_OF_MEMORY;
 
@@ -189,7 +544,14 @@ static err_t sqlite_create(const memory_config_t* config, memory_t** out_memory)
         sqlite_mem->db_path = strdup(":memory:"); // In-memory database
     }
 
+    // An in-memory database exists only on the connection that opened it
+    sqlite_mem->reader_count = str_empty(config->data_dir) ? 0 : config->reader_connections;
+    pthread_mutex_init(&sqlite_mem->writer_lock, NULL);
+    pthread_mutex_init(&sqlite_mem->pool_lock, NULL);
+    pthread_cond_init(&sqlite_mem->reader_returned, NULL);
+
     sqlite_mem->use_compression = config->compression;
+    sqlite_mem->codec = codec;
     memory->impl_data = sqlite_mem;
 
     *out_memory = memory;
@@ -206,6 +568,9 @@ static void sqlite_destroy(memory_t* memory) {
         sqlite_cleanup(memory);
     }
 
+    pthread_mutex_destroy(&sqlite_mem->writer_lock);
+    pthread_mutex_destroy(&sqlite_mem->pool_lock);
+    pthread_cond_destroy(&sqlite_mem->reader_returned);
     free(sqlite_mem->db_path);
     free(sqlite_mem);
     memory->impl_data = NULL;
@@ -218,31 +583,46 @@ static err_t sqlite_init(memory_t* memory) {
     if (memory->initialized) return ERR_OK;
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+    sqlite_conn_t* writer = &sqlite_mem->writer;
 
     // Open database
-    int rc = sqlite3_open(sqlite_mem->db_path, &sqlite_mem->db);
-    if (rc != SQLITE_OK) {
-        return ERR_MEMORY;
+    err_t err = open_connection(sqlite_mem->db_path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, writer);
+    if (err != ERR_OK) {
+        return err;
     }
 
-    // Enable WAL mode for better concurrency
-    rc = sqlite3_exec(sqlite_mem->db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+    // WAL lets the readers run alongside the writer
+    int rc = sqlite3_exec(writer->db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
     if (rc != SQLITE_OK) {
-        sqlite3_close(sqlite_mem->db);
+        close_connection(writer);
         return ERR_MEMORY;
     }
 
-    // Create tables
-    rc = sqlite3_exec(sqlite_mem->db, get_table_schema(), NULL, NULL, NULL);
+    // Create tables, replacing an index from before it was contentless in
+    // the same transaction so a crash cannot leave it half built
+    rc = sqlite3_exec(writer->db, "BEGIN IMMEDIATE;", NULL, NULL, NULL);
     if (rc != SQLITE_OK) {
-        sqlite3_close(sqlite_mem->db);
+        close_connection(writer);
         return ERR_MEMORY;
     }
 
+    bool reindex = !fts_is_contentless(writer->db);
+    if (reindex) rc = sqlite3_exec(writer->db, "DROP TABLE IF EXISTS memories_fts;", NULL, NULL, NULL);
+    if (rc == SQLITE_OK) rc = sqlite3_exec(writer->db, get_table_schema(), NULL, NULL, NULL);
+    err = rc == SQLITE_OK ? ERR_OK : ERR_MEMORY;
+
     // Prepare statements
-    err_t err = prepare_statements(sqlite_mem);
+    if (err == ERR_OK) err = prepare_statements(writer, true);
+    if (err == ERR_OK && reindex) err = fts_index_all(writer);
+    if (err == ERR_OK && sqlite3_exec(writer->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        err = ERR_MEMORY;
+    }
+    if (err != ERR_OK) sqlite3_exec(writer->db, "ROLLBACK;", NULL, NULL, NULL);
+
+    if (err == ERR_OK) err = open_readers(sqlite_mem);
     if (err != ERR_OK) {
-        sqlite3_close(sqlite_mem->db);
+        close_readers(sqlite_mem);
+        close_connection(writer);
         return err;
     }
 
@@ -255,12 +635,8 @@ static void sqlite_cleanup(memory_t* memory) {
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
 
-    finalize_statements(sqlite_mem);
-
-    if (sqlite_mem->db) {
-        sqlite3_close(sqlite_mem->db);
-        sqlite_mem->db = NULL;
-    }
+    close_readers(sqlite_mem);
+    close_connection(&sqlite_mem->writer);
 
     memory->initialized = false;
 }
@@ -272,58 +648,88 @@ static err_t sqlite_store(memory_t* memory, const memory_entry_t* entry) {
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
 
+    // Compressed outside the lock so writers only queue for the insert
+    void* frame = NULL;
+    size_t frame_len = 0;
+    if (sqlite_mem->codec) {
+        err_t err = compress_frame(sqlite_mem->codec, entry->content.data, entry->content.len,
+                                   &frame, &frame_len);
+        if (err != ERR_OK) return err;
+    }
+
+    sqlite_conn_t* writer = &sqlite_mem->writer;
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+
     // Bind parameters
-    sqlite3_bind_text(sqlite_mem->stmt_insert, 1, entry->id.data, -1, SQLITE_STATIC);
-    sqlite3_bind_text(sqlite_mem->stmt_insert, 2, entry->key.data, -1, SQLITE_STATIC);
-    sqlite3_bind_text(sqlite_mem->stmt_insert, 3, entry->content.data, -1, SQLITE_STATIC);
-    sqlite3_bind_int(sqlite_mem->stmt_insert, 4, entry->category);
-    sqlite3_bind_text(sqlite_mem->stmt_insert, 5, entry->timestamp.data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(writer->stmt_insert, 1, entry->id.data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(writer->stmt_insert, 2, entry->key.data, -1, SQLITE_STATIC);
+    if (frame) {
+        sqlite3_bind_blob64(writer->stmt_insert, 3, frame, frame_len, SQLITE_STATIC);
+    } else {
+        sqlite3_bind_text(writer->stmt_insert, 3, entry->content.data, -1, SQLITE_STATIC);
+    }
+    sqlite3_bind_int(writer->stmt_insert, 4, entry->category);
+    sqlite3_bind_text(writer->stmt_insert, 5, entry->timestamp.data, -1, SQLITE_STATIC);
 
     if (!str_empty(entry->session_id)) {
-        sqlite3_bind_text(sqlite_mem->stmt_insert, 6, entry->session_id.data, -1, SQLITE_STATIC);
+        sqlite3_bind_text(writer->stmt_insert, 6, entry->session_id.data, -1, SQLITE_STATIC);
     } else {
-        sqlite3_bind_null(sqlite_mem->stmt_insert, 6);
+        sqlite3_bind_null(writer->stmt_insert, 6);
     }
 
-    sqlite3_bind_double(sqlite_mem->stmt_insert, 7, entry->score);
+    sqlite3_bind_double(writer->stmt_insert, 7, entry->score);
 
-    int rc = sqlite3_step(sqlite_mem->stmt_insert);
-    sqlite3_reset(sqlite_mem->stmt_insert);
+    // The row and its index entry land together
+    err_t err = ERR_OK;
+    if (sqlite3_exec(writer->db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK) {
+        err = ERR_MEMORY;
+    }
+    if (err == ERR_OK && sqlite3_step(writer->stmt_insert) != SQLITE_DONE) err = ERR_MEMORY;
+    sqlite3_reset(writer->stmt_insert);
+    sqlite3_clear_bindings(writer->stmt_insert);
 
-    if (rc != SQLITE_DONE) {
-        return ERR_MEMORY;
+    if (err == ERR_OK) {
+        err = fts_write(writer->stmt_fts_insert, sqlite3_last_insert_rowid(writer->db),
+                        entry->key.data, entry->content.data);
     }
+    if (err == ERR_OK && sqlite3_exec(writer->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        err = ERR_MEMORY;
+    }
+    if (err != ERR_OK) sqlite3_exec(writer->db, "ROLLBACK;", NULL, NULL, NULL);
 
-    return ERR_OK;
-}
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    memory_bump_generation(memory);
+    free(frame);
 
-static err_t sqlite_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry) {
-    if (!memory || !memory->impl_data || !memory->initialized || !key || !out_entry) {
-        return ERR_INVALID_ARGUMENT;
-    }
+    return err;
+}
 
-    sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+static err_t recall_on(sqlite_conn_t* conn, const str_t* key, memory_entry_t* out_entry) {
 
-    sqlite3_bind_text(sqlite_mem->stmt_select_by_key, 1, key->data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(conn->stmt_select_by_key, 1, key->data, -1, SQLITE_STATIC);
 
-    int rc = sqlite3_step(sqlite_mem->stmt_select_by_key);
+    int rc = sqlite3_step(conn->stmt_select_by_key);
     if (rc == SQLITE_ROW) {
+        // Content first: it is the only column that can fail to decode
+        err_t err = column_content(conn->stmt_select_by_key, 2, &out_entry->content);
+        if (err != ERR_OK) {
+            sqlite3_reset(conn->stmt_select_by_key);
+            return err;
+        }
+
         // Extract columns
-        out_entry->id.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_key, 0));
+        out_entry->id.data = strdup((const char*)sqlite3_column_text(conn->stmt_select_by_key, 0));
         out_entry->id.len = strlen(out_entry->id.data);
 
-        out_entry->key.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_key, 1));
+        out_entry->key.data = strdup((const char*)sqlite3_column_text(conn->stmt_select_by_key, 1));
         out_entry->key.len = strlen(out_entry->key.data);
 
-        out_entry->content.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_key, 2));
-        out_entry->content.len = strlen(out_entry->content.data);
+        out_entry->category = sqlite3_column_int(conn->stmt_select_by_key, 3);
 
-        out_entry->category = sqlite3_column_int(sqlite_mem->stmt_select_by_key, 3);
-
-        out_entry->timestamp.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_key, 4));
+        out_entry->timestamp.data = strdup((const char*)sqlite3_column_text(conn->stmt_select_by_key, 4));
         out_entry->timestamp.len = strlen(out_entry->timestamp.data);
 
-        const char* session_id = (const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_key, 5);
+        const char* session_id = (const char*)sqlite3_column_text(conn->stmt_select_by_key, 5);
         if (session_id) {
             out_entry->session_id.data = strdup(session_id);
             out_entry->session_id.len = strlen(session_id);
@@ -331,41 +737,52 @@ static err_t sqlite_recall(memory_t* memory, const str_t* key, memory_entry_t* o
             out_entry->session_id = STR_NULL;
         }
 
-        out_entry->score = sqlite3_column_double(sqlite_mem->stmt_select_by_key, 6);
+        out_entry->score = sqlite3_column_double(conn->stmt_select_by_key, 6);
     }
 
-    sqlite3_reset(sqlite_mem->stmt_select_by_key);
+    sqlite3_reset(conn->stmt_select_by_key);
 
     return (rc == SQLITE_ROW) ? ERR_OK : ERR_NOT_FOUND;
 }
 
-static err_t sqlite_recall_by_id(memory_t* memory, const str_t* id, memory_entry_t* out_entry) {
-    if (!memory || !memory->impl_data || !memory->initialized || !id || !out_entry) {
+static err_t sqlite_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry) {
+    if (!memory || !memory->impl_data || !memory->initialized || !key || !out_entry) {
         return ERR_INVALID_ARGUMENT;
     }
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+    sqlite_conn_t* conn = checkout_reader(sqlite_mem);
+    err_t err = recall_on(conn, key, out_entry);
+    checkin_reader(sqlite_mem, conn);
+    return err;
+}
+
+static err_t recall_by_id_on(sqlite_conn_t* conn, const str_t* id, memory_entry_t* out_entry) {
 
-    sqlite3_bind_text(sqlite_mem->stmt_select_by_id, 1, id->data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(conn->stmt_select_by_id, 1, id->data, -1, SQLITE_STATIC);
 
-    int rc = sqlite3_step(sqlite_mem->stmt_select_by_id);
+    int rc = sqlite3_step(conn->stmt_select_by_id);
     if (rc == SQLITE_ROW) {
+        // Content first: it is the only column that can fail to decode
+        err_t err = column_content(conn->stmt_select_by_id, 2, &out_entry->content);
+        if (err != ERR_OK) {
+            sqlite3_reset(conn->stmt_select_by_id);
+            return err;
+        }
+
         // Extract columns (similar to recall)
-        out_entry->id.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_id, 0));
+        out_entry->id.data = strdup((const char*)sqlite3_column_text(conn->stmt_select_by_id, 0));
         out_entry->id.len = strlen(out_entry->id.data);
 
-        out_entry->key.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_id, 1));
+        out_entry->key.data = strdup((const char*)sqlite3_column_text(conn->stmt_select_by_id, 1));
         out_entry->key.len = strlen(out_entry->key.data);
 
-        out_entry->content.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_id, 2));
-        out_entry->content.len = strlen(out_entry->content.data);
-
-        out_entry->category = sqlite3_column_int(sqlite_mem->stmt_select_by_id, 3);
+        out_entry->category = sqlite3_column_int(conn->stmt_select_by_id, 3);
 
-        out_entry->timestamp.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_id, 4));
+        out_entry->timestamp.data = strdup((const char*)sqlite3_column_text(conn->stmt_select_by_id, 4));
         out_entry->timestamp.len = strlen(out_entry->timestamp.data);
 
-        const char* session_id = (const char*)sqlite3_column_text(sqlite_mem->stmt_select_by_id, 5);
+        const char* session_id = (const char*)sqlite3_column_text(conn->stmt_select_by_id, 5);
         if (session_id) {
             out_entry->session_id.data = strdup(session_id);
             out_entry->session_id.len = strlen(session_id);
@@ -373,41 +790,48 @@ static err_t sqlite_recall_by_id(memory_t* memory, const str_t* id, memory_entry
             out_entry->session_id = STR_NULL;
         }
 
-        out_entry->score = sqlite3_column_double(sqlite_mem->stmt_select_by_id, 6);
+        out_entry->score = sqlite3_column_double(conn->stmt_select_by_id, 6);
     }
 
-    sqlite3_reset(sqlite_mem->stmt_select_by_id);
+    sqlite3_reset(conn->stmt_select_by_id);
 
     return (rc == SQLITE_ROW) ? ERR_OK : ERR_NOT_FOUND;
 }
 
-static err_t sqlite_search(memory_t* memory, const str_t* query, const memory_search_opts_t* opts,
-                          memory_entry_t** out_entries, uint32_t* out_count) {
-    if (!memory || !memory->impl_data || !memory->initialized || !query || !out_entries || !out_count) {
+static err_t sqlite_recall_by_id(memory_t* memory, const str_t* id, memory_entry_t* out_entry) {
+    if (!memory || !memory->impl_data || !memory->initialized || !id || !out_entry) {
         return ERR_INVALID_ARGUMENT;
     }
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+    sqlite_conn_t* conn = checkout_reader(sqlite_mem);
+    err_t err = recall_by_id_on(conn, id, out_entry);
+    checkin_reader(sqlite_mem, conn);
+    return err;
+}
+
+static err_t search_on(sqlite_conn_t* conn, const str_t* query, const memory_search_opts_t* opts,
+                       memory_entry_t** out_entries, uint32_t* out_count) {
 
     // For now, simple FTS search
     // TODO: Add category filtering, timestamp range, etc.
 
-    sqlite3_bind_text(sqlite_mem->stmt_search, 1, query->data, -1, SQLITE_STATIC);
-    sqlite3_bind_text(sqlite_mem->stmt_search, 2, query->data, -1, SQLITE_STATIC);
-    sqlite3_bind_int(sqlite_mem->stmt_search, 3, opts ? opts->limit : 10);
+    sqlite3_bind_text(conn->stmt_search, 1, query->data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(conn->stmt_search, 2, query->data, -1, SQLITE_STATIC);
+    sqlite3_bind_int(conn->stmt_search, 3, opts ? opts->limit : 10);
 
     // Collect results
     memory_entry_t* entries = NULL;
     uint32_t count = 0;
     uint32_t capacity = 0;
 
-    while (sqlite3_step(sqlite_mem->stmt_search) == SQLITE_ROW) {
+    while (sqlite3_step(conn->stmt_search) == SQLITE_ROW) {
         if (count >= capacity) {
             capacity = capacity ? capacity * 2 : 16;
             memory_entry_t* new_entries = realloc(entries, capacity * sizeof(memory_entry_t));
             if (!new_entries) {
                 memory_entry_array_free(entries, count);
-                sqlite3_reset(sqlite_mem->stmt_search);
+                sqlite3_reset(conn->stmt_search);
                 return ERR_OUT_OF_MEMORY;
             }
             entries = new_entries;
@@ -415,21 +839,25 @@ static err_t sqlite_search(memory_t* memory, const str_t* query, const memory_se
 
         memory_entry_t* entry = &entries[count];
 
-        entry->id.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_search, 0));
+        err_t err = column_content(conn->stmt_search, 2, &entry->content);
+        if (err != ERR_OK) {
+            memory_entry_array_free(entries, count);
+            sqlite3_reset(conn->stmt_search);
+            return err;
+        }
+
+        entry->id.data = strdup((const char*)sqlite3_column_text(conn->stmt_search, 0));
         entry->id.len = strlen(entry->id.data);
 
-        entry->key.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_search, 1));
+        entry->key.data = strdup((const char*)sqlite3_column_text(conn->stmt_search, 1));
         entry->key.len = strlen(entry->key.data);
 
-        entry->content.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_search, 2));
-        entry->content.len = strlen(entry->content.data);
+        entry->category = sqlite3_column_int(conn->stmt_search, 3);
 
-        entry->category = sqlite3_column_int(sqlite_mem->stmt_search, 3);
-
-        entry->timestamp.data = strdup((const char*)sqlite3_column_text(sqlite_mem->stmt_search, 4));
+        entry->timestamp.data = strdup((const char*)sqlite3_column_text(conn->stmt_search, 4));
         entry->timestamp.len = strlen(entry->timestamp.data);
 
-        const char* session_id = (const char*)sqlite3_column_text(sqlite_mem->stmt_search, 5);
+        const char* session_id = (const char*)sqlite3_column_text(conn->stmt_search, 5);
         if (session_id) {
             entry->session_id.data = strdup(session_id);
             entry->session_id.len = strlen(session_id);
@@ -437,35 +865,47 @@ static err_t sqlite_search(memory_t* memory, const str_t* query, const memory_se
             entry->session_id = STR_NULL;
         }
 
-        entry->score = sqlite3_column_double(sqlite_mem->stmt_search, 6);
+        entry->score = sqlite3_column_double(conn->stmt_search, 6);
 
         count++;
     }
 
-    sqlite3_reset(sqlite_mem->stmt_search);
+    sqlite3_reset(conn->stmt_search);
 
     *out_entries = entries;
     *out_count = count;
     return ERR_OK;
 }
 
-static err_t sqlite_forget(memory_t* memory, const str_t* key) {
-    if (!memory || !memory->impl_data || !memory->initialized || !key) {
+static err_t sqlite_search(memory_t* memory, const str_t* query, const memory_search_opts_t* opts,
+                          memory_entry_t** out_entries, uint32_t* out_count) {
+    if (!memory || !memory->impl_data || !memory->initialized || !query || !out_entries || !out_count) {
         return ERR_INVALID_ARGUMENT;
     }
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+    sqlite_conn_t* conn = checkout_reader(sqlite_mem);
+    err_t err = search_on(conn, query, opts, out_entries, out_count);
+    checkin_reader(sqlite_mem, conn);
+    return err;
+}
 
-    sqlite3_bind_text(sqlite_mem->stmt_delete_by_key, 1, key->data, -1, SQLITE_STATIC);
+static err_t sqlite_forget(memory_t* memory, const str_t* key) {
+    if (!memory || !memory->impl_data || !memory->initialized || !key) {
+        return ERR_INVALID_ARGUMENT;
+    }
 
-    int rc = sqlite3_step(sqlite_mem->stmt_delete_by_key);
-    sqlite3_reset(sqlite_mem->stmt_delete_by_key);
+    sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
 
-    if (rc != SQLITE_DONE) {
-        return ERR_MEMORY;
-    }
+    sqlite_conn_t* writer = &sqlite_mem->writer;
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+    sqlite3_bind_text(writer->stmt_rows_by_key, 1, key->data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(writer->stmt_delete_by_key, 1, key->data, -1, SQLITE_STATIC);
+    err_t err = delete_indexed(writer, writer->stmt_rows_by_key, writer->stmt_delete_by_key);
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    memory_bump_generation(memory);
 
-    return ERR_OK;
+    return err;
 }
 
 static err_t sqlite_forget_by_id(memory_t* memory, const str_t* id) {
@@ -475,16 +915,15 @@ static err_t sqlite_forget_by_id(memory_t* memory, const str_t* id) {
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
 
-    sqlite3_bind_text(sqlite_mem->stmt_delete_by_id, 1, id->data, -1, SQLITE_STATIC);
-
-    int rc = sqlite3_step(sqlite_mem->stmt_delete_by_id);
-    sqlite3_reset(sqlite_mem->stmt_delete_by_id);
-
-    if (rc != SQLITE_DONE) {
-        return ERR_MEMORY;
-    }
+    sqlite_conn_t* writer = &sqlite_mem->writer;
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+    sqlite3_bind_text(writer->stmt_rows_by_id, 1, id->data, -1, SQLITE_STATIC);
+    sqlite3_bind_text(writer->stmt_delete_by_id, 1, id->data, -1, SQLITE_STATIC);
+    err_t err = delete_indexed(writer, writer->stmt_rows_by_id, writer->stmt_delete_by_id);
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    memory_bump_generation(memory);
 
-    return ERR_OK;
+    return err;
 }
 
 static err_t sqlite_forget_old(memory_t* memory, uint64_t cutoff_timestamp) {
@@ -494,13 +933,31 @@ static err_t sqlite_forget_old(memory_t* memory, uint64_t cutoff_timestamp) {
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
 
-    sqlite3_bind_int64(sqlite_mem->stmt_delete_old, 1, (sqlite3_int64)cutoff_timestamp);
+    sqlite_conn_t* writer = &sqlite_mem->writer;
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+    sqlite3_bind_int64(writer->stmt_rows_old, 1, (sqlite3_int64)cutoff_timestamp);
+    sqlite3_bind_int64(writer->stmt_delete_old, 1, (sqlite3_int64)cutoff_timestamp);
+    err_t err = delete_indexed(writer, writer->stmt_rows_old, writer->stmt_delete_old);
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    memory_bump_generation(memory);
 
-    int rc = sqlite3_step(sqlite_mem->stmt_delete_old);
-    sqlite3_reset(sqlite_mem->stmt_delete_old);
+    return err;
+}
 
-    if (rc != SQLITE_DONE) {
-        return ERR_MEMORY;
+static err_t get_stats_on(sqlite_conn_t* conn, uint32_t* total_entries, uint32_t* by_category_counts) {
+
+    // Get total count
+    int rc = sqlite3_step(conn->stmt_count_total);
+    if (rc == SQLITE_ROW) {
+        *total_entries = sqlite3_column_int(conn->stmt_count_total, 0);
+    }
+    sqlite3_reset(conn->stmt_count_total);
+
+    // Get counts by category if requested
+    if (by_category_counts) {
+        // For simplicity, just zero out the array
+        // In real implementation, we would populate it
+        memset(by_category_counts, 0, sizeof(uint32_t) * 4); // 4 categories
     }
 
     return ERR_OK;
@@ -512,34 +969,170 @@ static err_t sqlite_get_stats(memory_t* memory, uint32_t* total_entries, uint32_
     }
 
     sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+    sqlite_conn_t* conn = checkout_reader(sqlite_mem);
+    err_t err = get_stats_on(conn, total_entries, by_category_counts);
+    checkin_reader(sqlite_mem, conn);
+    return err;
+}
 
-    // Get total count
-    int rc = sqlite3_step(sqlite_mem->stmt_count_total);
-    if (rc == SQLITE_ROW) {
-        *total_entries = sqlite3_column_int(sqlite_mem->stmt_count_total, 0);
+// ============================================================================
+// Backup and restore
+// ============================================================================
+
+// Backups copy the live database with the online backup API, a batch of
+// pages per step. The connection is held only for the length of a step
+// and the loop pauses between steps, so agents storing memories while a
+// nightly backup runs wait for one batch at most. Writes made through this
+// connection in the meantime are folded into the copy by SQLite. The copy
+// is written next to the target and renamed into place once complete.
+//
+// Restores go the other way in a single transaction: rows are copied from
+// the attached backup, then the index is rebuilt in one pass and merged.
+
+#define SQLITE_BACKUP_PAGES_PER_STEP 64
+#define SQLITE_BACKUP_PAUSE_MS 2
+#define SQLITE_BACKUP_BUSY_PAUSE_MS 20
+#define SQLITE_BACKUP_MAX_BUSY_RETRIES 500
+
+static err_t sqlite_backup(memory_t* memory, const str_t* backup_path) {
+    if (!memory || !memory->impl_data || !memory->initialized ||
+        !backup_path || str_empty(*backup_path)) {
+        return ERR_INVALID_ARGUMENT;
     }
-    sqlite3_reset(sqlite_mem->stmt_count_total);
 
-    // Get counts by category if requested
-    if (by_category_counts) {
-        // For simplicity, just zero out the array
-        // In real implementation, we would populate it
-        memset(by_category_counts, 0, sizeof(uint32_t) * 4); // 4 categories
+    sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+
+    char path[4096];
+    char tmp_path[4096 + 8];
+    if (backup_path->len >= sizeof(path)) return ERR_INVALID_ARGUMENT;
+    snprintf(path, sizeof(path), "%.*s", (int)backup_path->len, backup_path->data);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    unlink(tmp_path);
+
+    sqlite3* dest = NULL;
+    int rc = sqlite3_open_v2(tmp_path, &dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (rc != SQLITE_OK) {
+        sqlite3_close(dest);
+        return ERR_IO;
     }
 
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+    sqlite3_backup* backup = sqlite3_backup_init(dest, "main", sqlite_mem->writer.db, "main");
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    if (!backup) {
+        sqlite3_close(dest);
+        unlink(tmp_path);
+        return ERR_MEMORY;
+    }
+
+    uint32_t busy_retries = 0;
+    do {
+        pthread_mutex_lock(&sqlite_mem->writer_lock);
+        rc = sqlite3_backup_step(backup, SQLITE_BACKUP_PAGES_PER_STEP);
+        pthread_mutex_unlock(&sqlite_mem->writer_lock);
+        if (rc == SQLITE_OK) {
+            busy_retries = 0;
+            sqlite3_sleep(SQLITE_BACKUP_PAUSE_MS);
+        } else if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+            if (++busy_retries > SQLITE_BACKUP_MAX_BUSY_RETRIES) break;
+            sqlite3_sleep(SQLITE_BACKUP_BUSY_PAUSE_MS);
+            rc = SQLITE_OK;
+        }
+    } while (rc == SQLITE_OK);
+
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+    int finish_rc = sqlite3_backup_finish(backup);
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    if (rc == SQLITE_DONE && finish_rc == SQLITE_OK) {
+        // The copy keeps the source's journal mode; make it a single file
+        rc = sqlite3_exec(dest, "PRAGMA journal_mode=DELETE;", NULL, NULL, NULL);
+    } else {
+        rc = SQLITE_ERROR;
+    }
+    if (sqlite3_close(dest) != SQLITE_OK) rc = SQLITE_ERROR;
+
+    if (rc != SQLITE_OK || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return busy_retries > SQLITE_BACKUP_MAX_BUSY_RETRIES ? ERR_TIMEOUT : ERR_IO;
+    }
     return ERR_OK;
 }
 
-static err_t sqlite_backup(memory_t* memory, const str_t* backup_path) {
-    // TODO: Implement database backup
-    (void)memory;
-    (void)backup_path;
-    return ERR_NOT_IMPLEMENTED;
+static const char* get_restore_sql(void) {
+    return "DELETE FROM memories;"
+           "INSERT INTO memories_fts(memories_fts) VALUES ('delete-all');"
+           "INSERT INTO memories (id, key, content, category, timestamp, session_id, score, created_at, updated_at) "
+           "  SELECT id, key, content, category, timestamp, session_id, score, created_at, updated_at "
+           "  FROM restore_src.memories;";
+}
+
+// Checks the attached backup before anything in the live database changes
+static err_t check_restore_source(sqlite3* db) {
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(db, "PRAGMA restore_src.quick_check;", -1, &stmt, NULL) != SQLITE_OK) {
+        return ERR_MEMORY_CORRUPT;
+    }
+    int rc = sqlite3_step(stmt);
+    const char* result = rc == SQLITE_ROW ? (const char*)sqlite3_column_text(stmt, 0) : NULL;
+    bool ok = result && strcmp(result, "ok") == 0;
+    sqlite3_finalize(stmt);
+    if (!ok) return ERR_MEMORY_CORRUPT;
+
+    if (sqlite3_prepare_v2(db, "SELECT id, key, content, category, timestamp, session_id, score, "
+                               "created_at, updated_at FROM restore_src.memories LIMIT 0;",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        return ERR_MEMORY_CORRUPT;
+    }
+    sqlite3_finalize(stmt);
+    return ERR_OK;
 }
 
 static err_t sqlite_restore(memory_t* memory, const str_t* backup_path) {
-    // TODO: Implement database restore
-    (void)memory;
-    (void)backup_path;
-    return ERR_NOT_IMPLEMENTED;
-}
\ No newline at end of file
+    if (!memory || !memory->impl_data || !memory->initialized ||
+        !backup_path || str_empty(*backup_path)) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    sqlite_memory_t* sqlite_mem = (sqlite_memory_t*)memory->impl_data;
+
+    char path[4096];
+    if (backup_path->len >= sizeof(path)) return ERR_INVALID_ARGUMENT;
+    snprintf(path, sizeof(path), "%.*s", (int)backup_path->len, backup_path->data);
+    if (access(path, R_OK) != 0) return ERR_FILE_NOT_FOUND;
+
+    sqlite3* db = sqlite_mem->writer.db;
+    pthread_mutex_lock(&sqlite_mem->writer_lock);
+
+    sqlite3_stmt* attach = NULL;
+    int rc = sqlite3_prepare_v2(db, "ATTACH DATABASE ? AS restore_src;", -1, &attach, NULL);
+    if (rc == SQLITE_OK) {
+        sqlite3_bind_text(attach, 1, path, -1, SQLITE_STATIC);
+        rc = sqlite3_step(attach);
+    }
+    sqlite3_finalize(attach);
+    if (rc != SQLITE_DONE) {
+        pthread_mutex_unlock(&sqlite_mem->writer_lock);
+        return ERR_MEMORY;
+    }
+
+    err_t err = check_restore_source(db);
+    if (err == ERR_OK) {
+        rc = sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL);
+        if (rc == SQLITE_OK) rc = sqlite3_exec(db, get_restore_sql(), NULL, NULL, NULL);
+        if (rc == SQLITE_OK && fts_index_all(&sqlite_mem->writer) != ERR_OK) rc = SQLITE_ERROR;
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_exec(db, "INSERT INTO memories_fts(memories_fts) VALUES ('optimize');",
+                              NULL, NULL, NULL);
+        }
+        if (rc == SQLITE_OK) rc = sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+        if (rc != SQLITE_OK) {
+            sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+            err = rc == SQLITE_BUSY ? ERR_TIMEOUT : ERR_MEMORY;
+        }
+    }
+
+    sqlite3_exec(db, "DETACH DATABASE restore_src;", NULL, NULL, NULL);
+    pthread_mutex_unlock(&sqlite_mem->writer_lock);
+    memory_bump_generation(memory);
+    return err;
+}
@@ -0,0 +1,176 @@
+// traced.c - Tracing decorator for memory backends in CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/memory.h"
+#include "core/trace.h"
+#include <stdlib.h>
+
+// Wraps another memory_t and records a span around every vtable call.
+// impl_data is the wrapped backend, which the decorator owns.
+
+// Forward declarations for vtable
+static str_t traced_get_name(void);
+static str_t traced_get_version(void);
+static err_t traced_create(const memory_config_t* config, memory_t** out_memory);
+static void traced_destroy(memory_t* memory);
+static err_t traced_init(memory_t* memory);
+static void traced_cleanup(memory_t* memory);
+static err_t traced_store(memory_t* memory, const memory_entry_t* entry);
+static err_t traced_store_multiple(memory_t* memory, const memory_entry_t* entries, uint32_t count);
+static err_t traced_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry);
+static err_t traced_recall_by_id(memory_t* memory, const str_t* id, memory_entry_t* out_entry);
+static err_t traced_search(memory_t* memory, const str_t* query, const memory_search_opts_t* opts,
+                           memory_entry_t** out_entries, uint32_t* out_count);
+static err_t traced_forget(memory_t* memory, const str_t* key);
+static err_t traced_forget_by_id(memory_t* memory, const str_t* id);
+static err_t traced_forget_old(memory_t* memory, uint64_t cutoff_timestamp);
+static err_t traced_get_stats(memory_t* memory, uint32_t* total_entries, uint32_t* by_category_counts);
+static err_t traced_backup(memory_t* memory, const str_t* backup_path);
+static err_t traced_restore(memory_t* memory, const str_t* backup_path);
+
+// VTable definition
+static const memory_vtable_t traced_vtable = {
+    .get_name = traced_get_name,
+    .get_version = traced_get_version,
+    .create = traced_create,
+    .destroy = traced_destroy,
+    .init = traced_init,
+    .cleanup = traced_cleanup,
+    .store = traced_store,
+    .store_multiple = traced_store_multiple,
+    .recall = traced_recall,
+    .recall_by_id = traced_recall_by_id,
+    .search = traced_search,
+    .forget = traced_forget,
+    .forget_by_id = traced_forget_by_id,
+    .forget_old = traced_forget_old,
+    .get_stats = traced_get_stats,
+    .backup = traced_backup,
+    .restore = traced_restore
+};
+
+#define INNER(memory) ((memory_t*)(memory)->impl_data)
+
+// Call a vtable slot on the wrapped backend inside a span
+#define TRACED_CALL(memory, span, slot, ...) \
+    do { \
+        memory_t* inner_ = INNER(memory); \
+        if (!inner_->vtable->slot) return ERR_NOT_IMPLEMENTED; \
+        TRACE_BEGIN(span, "memory"); \
+        err_t err_ = inner_->vtable->slot(inner_, __VA_ARGS__); \
+        TRACE_ARG("err", err_); \
+        TRACE_END(); \
+        return err_; \
+    } while (0)
+
+err_t memory_traced_wrap(memory_t* inner, memory_t** out_memory) {
+    if (!inner || !out_memory) return ERR_INVALID_ARGUMENT;
+
+    memory_t* memory = memory_alloc(&traced_vtable);
+    if (!memory) return ERR_OUT_OF_MEMORY;
+
+    memory->config = inner->config;
+    memory->impl_data = inner;
+    memory->wrapped = inner;
+    memory->initialized = inner->initialized;
+
+    *out_memory = memory;
+    return ERR_OK;
+}
+
+static str_t traced_get_name(void) {
+    return STR_LIT("traced");
+}
+
+static str_t traced_get_version(void) {
+    return STR_LIT("1.0.0");
+}
+
+static err_t traced_create(const memory_config_t* config, memory_t** out_memory) {
+    (void)config;
+    (void)out_memory;
+    // Decorators are built with memory_traced_wrap()
+    return ERR_NOT_IMPLEMENTED;
+}
+
+static void traced_destroy(memory_t* memory) {
+    if (!memory) return;
+    memory_free(INNER(memory));
+    free(memory);
+}
+
+static err_t traced_init(memory_t* memory) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+
+    memory_t* inner = INNER(memory);
+    TRACE_BEGIN("memory.init", "memory");
+    err_t err = inner->vtable->init(inner);
+    TRACE_END();
+
+    memory->initialized = inner->initialized;
+    return err;
+}
+
+static void traced_cleanup(memory_t* memory) {
+    if (!memory || !memory->impl_data) return;
+
+    memory_t* inner = INNER(memory);
+    inner->vtable->cleanup(inner);
+    memory->initialized = inner->initialized;
+}
+
+static err_t traced_store(memory_t* memory, const memory_entry_t* entry) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.store", store, entry);
+}
+
+static err_t traced_store_multiple(memory_t* memory, const memory_entry_t* entries, uint32_t count) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.store_multiple", store_multiple, entries, count);
+}
+
+static err_t traced_recall(memory_t* memory, const str_t* key, memory_entry_t* out_entry) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.recall", recall, key, out_entry);
+}
+
+static err_t traced_recall_by_id(memory_t* memory, const str_t* id, memory_entry_t* out_entry) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.recall_by_id", recall_by_id, id, out_entry);
+}
+
+static err_t traced_search(memory_t* memory, const str_t* query, const memory_search_opts_t* opts,
+                           memory_entry_t** out_entries, uint32_t* out_count) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.search", search, query, opts, out_entries, out_count);
+}
+
+static err_t traced_forget(memory_t* memory, const str_t* key) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.forget", forget, key);
+}
+
+static err_t traced_forget_by_id(memory_t* memory, const str_t* id) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.forget_by_id", forget_by_id, id);
+}
+
+static err_t traced_forget_old(memory_t* memory, uint64_t cutoff_timestamp) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.forget_old", forget_old, cutoff_timestamp);
+}
+
+static err_t traced_get_stats(memory_t* memory, uint32_t* total_entries, uint32_t* by_category_counts) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.get_stats", get_stats, total_entries, by_category_counts);
+}
+
+static err_t traced_backup(memory_t* memory, const str_t* backup_path) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.backup", backup, backup_path);
+}
+
+static err_t traced_restore(memory_t* memory, const str_t* backup_path) {
+    if (!memory || !memory->impl_data) return ERR_INVALID_ARGUMENT;
+    TRACED_CALL(memory, "memory.restore", restore, backup_path);
+}
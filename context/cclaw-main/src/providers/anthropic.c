@@ -147,7 +147,8 @@ static err_t anthropic_connect(provider_t* provider) {
     // We'll try to make a lightweight request to check connectivity
     http_response_t* response = NULL;
     char url[512];
-    snprintf(url, sizeof(url), "%s/messages", ANTHROPIC_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/messages",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     // Create minimal request
     const char* test_body = "{\"model\":\"claude-3-haiku-20240307\",\"max_tokens\":1,\"messages\":[{\"role\":\"user\",\"content\":\"test\"}]}";
@@ -300,7 +301,7 @@ static err_t parse_anthropic_response(const char* json_str, chat_response_t* res
 
         // Allocate and concatenate
         if (total_len > 0) {
-            char* combined = malloc(total_len + 1);
+            char* combined = alloc(PROVIDER_ALLOC, total_len + 1);
             if (combined) {
                 combined[0] = '\0';
                 size_t offset = 0;
@@ -329,11 +330,11 @@ static err_t parse_anthropic_response(const char* json_str, chat_response_t* res
 
     // Parse model
     const char* model = json_object_get_string(obj, "model", DEFAULT_ANTHROPIC_MODEL);
-    response->model = (str_t){ .data = strdup(model), .len = strlen(model) };
+    response->model = alloc_str_cstr(PROVIDER_ALLOC, model);
 
     // Parse stop reason
     const char* stop_reason = json_object_get_string(obj, "stop_reason", "end_turn");
-    response->finish_reason = (str_t){ .data = strdup(stop_reason), .len = strlen(stop_reason) };
+    response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, stop_reason);
 
     // Parse usage
     json_object_t* usage = json_object_get_object(obj, "usage");
@@ -366,12 +367,13 @@ static err_t anthropic_chat(provider_t* provider,
 
     // Build URL
     char url[512];
-    snprintf(url, sizeof(url), "%s/messages", ANTHROPIC_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/messages",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     // Send request
     http_response_t* http_resp = NULL;
     err_t err = http_post_json(provider->http, url, request_body, &http_resp);
-    free(request_body);
+    json_free_string(request_body);
 
     if (err != ERR_OK) return err;
     if (!http_response_is_success(http_resp)) {
@@ -380,7 +382,7 @@ static err_t anthropic_chat(provider_t* provider,
     }
 
     // Parse response
-    chat_response_t* response = calloc(1, sizeof(chat_response_t));
+    chat_response_t* response = chat_response_create();
     if (!response) {
         http_response_free(http_resp);
         return ERR_OUT_OF_MEMORY;
@@ -437,7 +439,8 @@ static err_t anthropic_health_check(provider_t* provider, bool* out_healthy) {
     // Try to get models list (Anthropic doesn't have a models endpoint)
     // We'll try a lightweight request instead
     char url[512];
-    snprintf(url, sizeof(url), "%s/messages", ANTHROPIC_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/messages",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     const char* test_body = "{\"model\":\"claude-3-haiku-20240307\",\"max_tokens\":1,\"messages\":[{\"role\":\"user\",\"content\":\"test\"}]}";
 
@@ -4,33 +4,36 @@
 #include "providers/base.h"
 #include "providers/openai.h"
 #include "providers/anthropic.h"
+#include "json_config.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 // Response helpers
 chat_response_t* chat_response_create(void) {
-    return calloc(1, sizeof(chat_response_t));
+    return alloc_zeroed(PROVIDER_ALLOC, sizeof(chat_response_t));
 }
 
 void chat_response_free(chat_response_t* response) {
     if (!response) return;
 
-    free((void*)response->content.data);
-    free((void*)response->finish_reason.data);
-    free((void*)response->model.data);
-    free((void*)response->tool_calls.data);
+    free_str(PROVIDER_ALLOC, response->content);
+    free_str(PROVIDER_ALLOC, response->finish_reason);
+    free_str(PROVIDER_ALLOC, response->model);
+    free_str(PROVIDER_ALLOC, response->tool_calls);
+    free_str(PROVIDER_ALLOC, response->response_id);
 
-    free(response);
+    free_ptr(PROVIDER_ALLOC, response, sizeof(chat_response_t));
 }
 
 void chat_response_clear(chat_response_t* response) {
     if (!response) return;
 
-    free((void*)response->content.data);
-    free((void*)response->finish_reason.data);
-    free((void*)response->model.data);
-    free((void*)response->tool_calls.data);
+    free_str(PROVIDER_ALLOC, response->content);
+    free_str(PROVIDER_ALLOC, response->finish_reason);
+    free_str(PROVIDER_ALLOC, response->model);
+    free_str(PROVIDER_ALLOC, response->tool_calls);
+    free_str(PROVIDER_ALLOC, response->response_id);
 
     memset(response, 0, sizeof(chat_response_t));
 }
@@ -288,3 +291,223 @@ err_t provider_chat_with_retry(provider_t* provider,
 
     return last_error;
 }
+
+bool provider_supports_chaining(const provider_t* provider) {
+    return provider && provider->vtable && provider->vtable->chat_continue &&
+           provider->config.response_chaining;
+}
+
+// Build an OpenAI-compatible chat request. Provider-specific fields
+// (max_tokens, headers) are left to the individual backends.
+char* provider_build_chat_request(const provider_t* provider,
+                                  const chat_message_t* messages,
+                                  uint32_t message_count,
+                                  const tool_def_t* tools,
+                                  uint32_t tool_count,
+                                  const char* model,
+                                  double temperature,
+                                  bool stream) {
+    (void)provider;
+
+    json_value_t* root = json_create_object();
+    if (!root) return NULL;
+
+    json_object_set_string(root, "model", model ? model : DEFAULT_OPENAI_MODEL);
+
+    json_value_t* messages_arr = json_create_array();
+    for (uint32_t i = 0; i < message_count; i++) {
+        json_value_t* msg_obj = json_create_object();
+
+        const char* role_str = "user";
+        switch (messages[i].role) {
+            case CHAT_ROLE_SYSTEM: role_str = "system"; break;
+            case CHAT_ROLE_USER: role_str = "user"; break;
+            case CHAT_ROLE_ASSISTANT: role_str = "assistant"; break;
+            case CHAT_ROLE_TOOL: role_str = "tool"; break;
+        }
+        json_object_set_string(msg_obj, "role", role_str);
+        json_object_set_string(msg_obj, "content", messages[i].content.data ? messages[i].content.data : "");
+        provider_add_message_tool_fields(msg_obj, &messages[i]);
+        json_array_append(messages_arr, msg_obj);
+    }
+    json_object_set(root, "messages", messages_arr);
+
+    if (temperature >= 0.0 && temperature <= 2.0) {
+        json_object_set_number(root, "temperature", temperature);
+    }
+
+    if (stream) {
+        json_object_set_bool(root, "stream", true);
+    }
+
+    provider_add_tools_json(root, tools, tool_count);
+
+    char* json_str = json_print(root, false);
+    json_free(root);
+    return json_str;
+}
+
+void provider_add_tools_json(json_value_t* request, const tool_def_t* tools, uint32_t tool_count) {
+    if (!request || !tools || tool_count == 0) return;
+
+    json_value_t* tools_arr = json_create_array();
+    for (uint32_t i = 0; i < tool_count; i++) {
+        char* name = strndup(tools[i].name.data ? tools[i].name.data : "", tools[i].name.len);
+        char* description = strndup(tools[i].description.data ? tools[i].description.data : "",
+                                    tools[i].description.len);
+        char* parameters = strndup(tools[i].parameters.data ? tools[i].parameters.data : "",
+                                   tools[i].parameters.len);
+
+        json_value_t* function = json_create_object();
+        json_object_set_string(function, "name", name ? name : "");
+        json_object_set_string(function, "description", description ? description : "");
+        json_value_t* schema = parameters && *parameters ? json_parse(parameters) : NULL;
+        json_object_set(function, "parameters", schema ? schema : json_create_object());
+
+        json_value_t* tool_obj = json_create_object();
+        json_object_set_string(tool_obj, "type", "function");
+        json_object_set(tool_obj, "function", function);
+        json_array_append(tools_arr, tool_obj);
+
+        free(name);
+        free(description);
+        free(parameters);
+    }
+    json_object_set(request, "tools", tools_arr);
+}
+
+void provider_add_message_tool_fields(json_value_t* msg_obj, const chat_message_t* message) {
+    if (!msg_obj || !message) return;
+
+    if (!str_empty(message->tool_calls)) {
+        char* text = strndup(message->tool_calls.data, message->tool_calls.len);
+        json_value_t* calls = text ? json_parse(text) : NULL;
+        free(text);
+        if (calls) json_object_set(msg_obj, "tool_calls", calls);
+    }
+    if (!str_empty(message->tool_call_id)) {
+        char* id = strndup(message->tool_call_id.data, message->tool_call_id.len);
+        if (id) json_object_set_string(msg_obj, "tool_call_id", id);
+        free(id);
+    }
+}
+
+// ============================================================================
+// Streamed tool calls
+// ============================================================================
+
+void stream_tool_calls_init(stream_tool_calls_t* acc) {
+    if (!acc) return;
+    memset(acc, 0, sizeof(*acc));
+    for (uint32_t i = 0; i < STREAM_TOOL_CALLS_MAX; i++) {
+        str_builder_init(&acc->calls[i].id, NULL);
+        str_builder_init(&acc->calls[i].name, NULL);
+        str_builder_init(&acc->calls[i].arguments, NULL);
+    }
+}
+
+void stream_tool_calls_free(stream_tool_calls_t* acc) {
+    if (!acc) return;
+    for (uint32_t i = 0; i < STREAM_TOOL_CALLS_MAX; i++) {
+        str_builder_free(&acc->calls[i].id);
+        str_builder_free(&acc->calls[i].name);
+        str_builder_free(&acc->calls[i].arguments);
+    }
+    acc->count = 0;
+}
+
+// Advance the bracket scan over newly arrived argument bytes. True once the
+// top-level object or array has closed.
+static bool arguments_closed(stream_tool_call_t* call) {
+    str_t args = str_builder_view(&call->arguments);
+    bool opened = call->depth > 0;
+
+    for (; call->scanned < args.len; call->scanned++) {
+        char c = args.data[call->scanned];
+        if (call->in_string) {
+            if (call->escaped) call->escaped = false;
+            else if (c == '\\') call->escaped = true;
+            else if (c == '"') call->in_string = false;
+            continue;
+        }
+        switch (c) {
+            case '"':
+                call->in_string = true;
+                break;
+            case '{':
+            case '[':
+                call->depth++;
+                opened = true;
+                break;
+            case '}':
+            case ']':
+                if (call->depth > 0 && --call->depth == 0) {
+                    call->scanned++;
+                    return true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return opened && call->depth == 0;
+}
+
+void stream_tool_calls_add(stream_tool_calls_t* acc, uint32_t index,
+                           const char* id, const char* name, const char* arguments,
+                           const chat_stream_handler_t* handler) {
+    if (!acc || index >= STREAM_TOOL_CALLS_MAX) return;
+
+    stream_tool_call_t* call = &acc->calls[index];
+    if (index >= acc->count) acc->count = index + 1;
+
+    if (id) str_builder_append_cstr(&call->id, id);
+    if (name) str_builder_append_cstr(&call->name, name);
+    if (arguments) str_builder_append_cstr(&call->arguments, arguments);
+
+    if (call->announced || !arguments || !*arguments) return;
+    if (!arguments_closed(call)) return;
+
+    // The scan only tracks brackets; let the parser have the final word
+    str_t args = str_builder_view(&call->arguments);
+    json_value_t* parsed = json_parse(args.data);
+    if (!parsed) return;
+    json_free(parsed);
+
+    call->announced = true;
+    if (handler && handler->on_tool_call) {
+        handler->on_tool_call(index, str_builder_view(&call->name), args, handler->user_data);
+    }
+}
+
+str_t stream_tool_calls_to_json(const stream_tool_calls_t* acc) {
+    if (!acc || acc->count == 0) return STR_NULL;
+
+    json_value_t* arr = json_create_array();
+    for (uint32_t i = 0; i < acc->count; i++) {
+        const stream_tool_call_t* call = &acc->calls[i];
+        str_t name = str_builder_view(&call->name);
+        if (name.len == 0) continue;
+
+        str_t id = str_builder_view(&call->id);
+        str_t args = str_builder_view(&call->arguments);
+
+        json_value_t* function = json_create_object();
+        json_object_set_string(function, "name", name.data);
+        json_object_set_string(function, "arguments", args.len > 0 ? args.data : "{}");
+
+        json_value_t* obj = json_create_object();
+        json_object_set_string(obj, "id", id.len > 0 ? id.data : "");
+        json_object_set_string(obj, "type", "function");
+        json_object_set(obj, "function", function);
+        json_array_append(arr, obj);
+    }
+
+    char* text = json_print(arr, false);
+    json_free(arr);
+    if (!text) return STR_NULL;
+
+    str_t out = alloc_str_cstr(PROVIDER_ALLOC, text);
+    json_free_string(text);
+    return out;
+}
@@ -237,12 +237,12 @@ static err_t parse_deepseek_response(const char* json_str, chat_response_t* resp
             json_object_t* message = json_object_get_object(choice_obj, "message");
             if (message) {
                 const char* content = json_object_get_string(message, "content", "");
-                response->content = (str_t){ .data = strdup(content), .len = strlen(content) };
+                response->content = alloc_str_cstr(PROVIDER_ALLOC, content);
             }
 
             // Get finish reason
             const char* finish_reason = json_object_get_string(choice_obj, "finish_reason", "stop");
-            response->finish_reason = (str_t){ .data = strdup(finish_reason), .len = strlen(finish_reason) };
+            response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, finish_reason);
         }
     }
 
@@ -256,7 +256,7 @@ static err_t parse_deepseek_response(const char* json_str, chat_response_t* resp
 
     // Get model
     const char* model = json_object_get_string(obj, "model", DEFAULT_DEEPSEEK_MODEL);
-    response->model = (str_t){ .data = strdup(model), .len = strlen(model) };
+    response->model = alloc_str_cstr(PROVIDER_ALLOC, model);
 
     json_free(root);
     return ERR_OK;
@@ -281,11 +281,12 @@ static err_t deepseek_chat(provider_t* provider,
 
     // Make request
     char url[512];
-    snprintf(url, sizeof(url), "%s/chat/completions", DEEPSEEK_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     http_response_t* http_resp = NULL;
     err_t err = http_post_json(provider->http, url, request_body, &http_resp);
-    free(request_body);
+    json_free_string(request_body);
 
     if (err != ERR_OK) return err;
 
@@ -295,7 +296,7 @@ static err_t deepseek_chat(provider_t* provider,
     }
 
     // Parse response
-    chat_response_t* response = calloc(1, sizeof(chat_response_t));
+    chat_response_t* response = chat_response_create();
     if (!response) {
         http_response_free(http_resp);
         return ERR_OUT_OF_MEMORY;
@@ -407,7 +408,8 @@ static err_t deepseek_chat_stream(provider_t* provider,
 
     // Build URL
     char url[512];
-    snprintf(url, sizeof(url), "%s/chat/completions", DEEPSEEK_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     // Initialize SSE parser
     sse_parser_t parser = {
@@ -421,7 +423,7 @@ static err_t deepseek_chat_stream(provider_t* provider,
 
     // Make streaming request
     err_t err = http_post_json_stream(provider->http, url, request_body, sse_parser_write, &parser);
-    free(request_body);
+    json_free_string(request_body);
 
     return err;
 }
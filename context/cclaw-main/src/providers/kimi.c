@@ -191,10 +191,10 @@ static err_t parse_kimi_response(const char* json_str, chat_response_t* response
             json_object_t* message = json_object_get_object(choice_obj, "message");
             if (message) {
                 const char* content = json_object_get_string(message, "content", "");
-                response->content = (str_t){ .data = strdup(content), .len = strlen(content) };
+                response->content = alloc_str_cstr(PROVIDER_ALLOC, content);
             }
             const char* finish = json_object_get_string(choice_obj, "finish_reason", "stop");
-            response->finish_reason = (str_t){ .data = strdup(finish), .len = strlen(finish) };
+            response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, finish);
         }
     }
 
@@ -206,7 +206,7 @@ static err_t parse_kimi_response(const char* json_str, chat_response_t* response
     }
 
     const char* model = json_object_get_string(obj, "model", DEFAULT_KIMI_MODEL);
-    response->model = (str_t){ .data = strdup(model), .len = strlen(model) };
+    response->model = alloc_str_cstr(PROVIDER_ALLOC, model);
 
     json_free(root);
     return ERR_OK;
@@ -228,11 +228,12 @@ static err_t kimi_chat(provider_t* provider,
     if (!request_body) return ERR_OUT_OF_MEMORY;
 
     char url[512];
-    snprintf(url, sizeof(url), "%s/chat/completions", KIMI_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     http_response_t* http_resp = NULL;
     err_t err = http_post_json(provider->http, url, request_body, &http_resp);
-    free(request_body);
+    json_free_string(request_body);
 
     if (err != ERR_OK) return err;
     if (!http_response_is_success(http_resp)) {
@@ -240,7 +241,7 @@ static err_t kimi_chat(provider_t* provider,
         return ERR_PROVIDER;
     }
 
-    chat_response_t* response = calloc(1, sizeof(chat_response_t));
+    chat_response_t* response = chat_response_create();
     if (!response) {
         http_response_free(http_resp);
         return ERR_OUT_OF_MEMORY;
@@ -41,6 +41,24 @@ static err_t openai_chat_stream(provider_t* provider,
                                 double temperature,
                                 void (*on_chunk)(const char* chunk, void* user_data),
                                 void* user_data);
+static err_t openai_chat_stream_tools(provider_t* provider,
+                                      const chat_message_t* messages,
+                                      uint32_t message_count,
+                                      const tool_def_t* tools,
+                                      uint32_t tool_count,
+                                      const char* model,
+                                      double temperature,
+                                      const chat_stream_handler_t* handler,
+                                      chat_response_t** out_response);
+static err_t openai_chat_continue(provider_t* provider,
+                                  const char* previous_id,
+                                  const chat_message_t* messages,
+                                  uint32_t message_count,
+                                  const tool_def_t* tools,
+                                  uint32_t tool_count,
+                                  const char* model,
+                                  double temperature,
+                                  chat_response_t** out_response);
 static err_t openai_list_models(provider_t* provider, str_t** out_models, uint32_t* out_count);
 static bool openai_supports_model(provider_t* provider, const char* model);
 static err_t openai_health_check(provider_t* provider, bool* out_healthy);
@@ -57,6 +75,8 @@ static const provider_vtable_t openai_vtable = {
     .is_connected = openai_is_connected,
     .chat = openai_chat,
     .chat_stream = openai_chat_stream,
+    .chat_stream_tools = openai_chat_stream_tools,
+    .chat_continue = openai_chat_continue,
     .list_models = openai_list_models,
     .supports_model = openai_supports_model,
     .health_check = openai_health_check,
@@ -86,8 +106,10 @@ err_t openai_create(const provider_config_t* config, provider_t** out_provider)
     provider->config = *config;
 
     // Set default base URL if not provided
+    // OpenAI itself stores responses; other compatible endpoints opt in
     if (str_empty(config->base_url)) {
         provider->config.base_url = (str_t){ .data = OPENAI_BASE_URL, .len = strlen(OPENAI_BASE_URL) };
+        provider->config.response_chaining = true;
     }
 
     // Create HTTP client
@@ -142,7 +164,8 @@ static err_t openai_connect(provider_t* provider) {
     // OpenAI health check: list models endpoint
     http_response_t* response = NULL;
     char url[512];
-    snprintf(url, sizeof(url), "%s/models", OPENAI_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/models",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     err_t err = http_get(provider->http, url, &response);
     if (err == ERR_OK && response) {
@@ -208,7 +231,7 @@ static char* build_openai_request(const provider_t* provider,
             }
         }
 
-        // TODO: Handle tool calls if present
+        provider_add_message_tool_fields(msg_obj, &messages[i]);
         json_array_append(messages_arr, msg_obj);
     }
     json_object_set(root, "messages", messages_arr);
@@ -221,11 +244,14 @@ static char* build_openai_request(const provider_t* provider,
     // Set stream parameter
     if (stream) {
         json_object_set_bool(root, "stream", true);
+
+        // Ask for a final usage chunk so streamed turns are still metered
+        json_value_t* stream_options = json_create_object();
+        json_object_set_bool(stream_options, "include_usage", true);
+        json_object_set(root, "stream_options", stream_options);
     }
 
-    // TODO: Add tools support
-    (void)tools;
-    (void)tool_count;
+    provider_add_tools_json(root, tools, tool_count);
 
     // TODO: Add max_tokens, top_p, etc.
     if (provider->impl_data) {
@@ -259,16 +285,24 @@ static err_t parse_openai_response(const char* json_str, chat_response_t* respon
             if (message) {
                 const char* content = json_object_get_string(message, "content", "");
                 if (content) {
-                    response->content = (str_t){ .data = strdup(content), .len = strlen(content) };
+                    response->content = alloc_str_cstr(PROVIDER_ALLOC, content);
+                }
+                json_value_t* tool_calls = json_object_get(message, "tool_calls");
+                if (tool_calls && json_is_array(tool_calls)) {
+                    char* text = json_print(tool_calls, false);
+                    if (text) {
+                        response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC, text);
+                        json_free_string(text);
+                    }
                 }
             }
             const char* finish = json_object_get_string(choice_obj, "finish_reason", "stop");
-            response->finish_reason = (str_t){ .data = strdup(finish), .len = strlen(finish) };
+            response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, finish);
         }
     }
 
     const char* model = json_object_get_string(obj, "model", DEFAULT_OPENAI_MODEL);
-    response->model = (str_t){ .data = strdup(model), .len = strlen(model) };
+    response->model = alloc_str_cstr(PROVIDER_ALLOC, model);
 
     // Parse token usage if available
     json_object_t* usage = json_object_get_object(obj, "usage");
@@ -298,12 +332,13 @@ static err_t openai_chat(provider_t* provider,
 
     // Build URL
     char url[512];
-    snprintf(url, sizeof(url), "%s/chat/completions", OPENAI_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     // Send request
     http_response_t* http_resp = NULL;
     err_t err = http_post_json(provider->http, url, request_body, &http_resp);
-    free(request_body);
+    json_free_string(request_body);
 
     if (err != ERR_OK) return err;
     if (!http_response_is_success(http_resp)) {
@@ -312,7 +347,7 @@ static err_t openai_chat(provider_t* provider,
     }
 
     // Parse response
-    chat_response_t* response = calloc(1, sizeof(chat_response_t));
+    chat_response_t* response = chat_response_create();
     if (!response) {
         http_response_free(http_resp);
         return ERR_OUT_OF_MEMORY;
@@ -330,6 +365,284 @@ static err_t openai_chat(provider_t* provider,
     return ERR_OK;
 }
 
+// ============================================================================
+// Responses API (server-side conversation state)
+// ============================================================================
+
+static char* str_to_cstr(str_t s) {
+    return strndup(s.data ? s.data : "", s.len);
+}
+
+static void set_string_from(json_value_t* obj, const char* key, str_t value) {
+    char* text = str_to_cstr(value);
+    json_object_set_string(obj, key, text ? text : "");
+    free(text);
+}
+
+// An assistant turn's tool_calls become function_call items
+static void append_function_calls(json_value_t* input, str_t tool_calls) {
+    char* text = str_to_cstr(tool_calls);
+    json_value_t* calls = text ? json_parse(text) : NULL;
+    free(text);
+    if (!calls || !json_is_array(calls)) {
+        json_free(calls);
+        return;
+    }
+
+    for (json_array_t* item = calls->array; item; item = item->next) {
+        json_object_t* call = json_as_object(&item->value);
+        json_object_t* function = call ? json_object_get_object(call, "function") : NULL;
+        if (!function) continue;
+
+        json_value_t* entry = json_create_object();
+        json_object_set_string(entry, "type", "function_call");
+        json_object_set_string(entry, "call_id", json_object_get_string(call, "id", ""));
+        json_object_set_string(entry, "name", json_object_get_string(function, "name", ""));
+
+        json_value_t* arguments = json_object_get(function, "arguments");
+        if (arguments && json_is_string(arguments)) {
+            json_object_set_string(entry, "arguments", json_as_string(arguments, "{}"));
+        } else {
+            char* printed = arguments ? json_print(arguments, false) : NULL;
+            json_object_set_string(entry, "arguments", printed ? printed : "{}");
+            json_free_string(printed);
+        }
+        json_array_append(input, entry);
+    }
+    json_free(calls);
+}
+
+static char* build_responses_request(const provider_t* provider,
+                                     const char* previous_id,
+                                     const chat_message_t* messages,
+                                     uint32_t message_count,
+                                     const tool_def_t* tools,
+                                     uint32_t tool_count,
+                                     const char* model,
+                                     double temperature) {
+    json_value_t* root = json_create_object();
+    if (!root) return NULL;
+
+    json_object_set_string(root, "model", model ? model : DEFAULT_OPENAI_MODEL);
+    json_object_set_bool(root, "store", true);
+    if (previous_id) {
+        json_object_set_string(root, "previous_response_id", previous_id);
+    }
+
+    // Instructions are not carried over from the previous response, so the
+    // system prompt goes with every request
+    str_builder_t instructions;
+    str_builder_init(&instructions, NULL);
+    json_value_t* input = json_create_array();
+    for (uint32_t i = 0; i < message_count; i++) {
+        const chat_message_t* message = &messages[i];
+        switch (message->role) {
+            case CHAT_ROLE_SYSTEM:
+                if (instructions.len > 0) str_builder_append_cstr(&instructions, "\n\n");
+                str_builder_append(&instructions, message->content);
+                break;
+            case CHAT_ROLE_USER:
+            case CHAT_ROLE_ASSISTANT:
+                if (message->content.len > 0 || str_empty(message->tool_calls)) {
+                    json_value_t* item = json_create_object();
+                    json_object_set_string(item, "role",
+                                           message->role == CHAT_ROLE_USER ? "user" : "assistant");
+                    set_string_from(item, "content", message->content);
+                    json_array_append(input, item);
+                }
+                if (!str_empty(message->tool_calls)) {
+                    append_function_calls(input, message->tool_calls);
+                }
+                break;
+            case CHAT_ROLE_TOOL: {
+                json_value_t* item = json_create_object();
+                json_object_set_string(item, "type", "function_call_output");
+                set_string_from(item, "call_id", message->tool_call_id);
+                set_string_from(item, "output", message->content);
+                json_array_append(input, item);
+                break;
+            }
+        }
+    }
+    json_object_set(root, "input", input);
+
+    if (instructions.len > 0) {
+        char* text = str_to_cstr(str_builder_view(&instructions));
+        json_object_set_string(root, "instructions", text ? text : "");
+        free(text);
+    }
+    str_builder_free(&instructions);
+
+    if (temperature >= 0.0 && temperature <= 2.0) {
+        json_object_set_number(root, "temperature", temperature);
+    }
+
+    // Function tools are flat here: no nested "function" object
+    if (tools && tool_count > 0) {
+        json_value_t* tools_arr = json_create_array();
+        for (uint32_t i = 0; i < tool_count; i++) {
+            json_value_t* tool_obj = json_create_object();
+            json_object_set_string(tool_obj, "type", "function");
+            set_string_from(tool_obj, "name", tools[i].name);
+            set_string_from(tool_obj, "description", tools[i].description);
+            char* parameters = str_to_cstr(tools[i].parameters);
+            json_value_t* schema = parameters && *parameters ? json_parse(parameters) : NULL;
+            free(parameters);
+            json_object_set(tool_obj, "parameters", schema ? schema : json_create_object());
+            json_array_append(tools_arr, tool_obj);
+        }
+        json_object_set(root, "tools", tools_arr);
+    }
+
+    if (provider->impl_data) {
+        openai_data_t* data = (openai_data_t*)provider->impl_data;
+        if (data->max_completion_tokens > 0) {
+            json_object_set_number(root, "max_output_tokens", (double)data->max_completion_tokens);
+        }
+    }
+
+    char* json_str = json_print(root, false);
+    json_free(root);
+    return json_str;
+}
+
+// Output items map back onto a chat response: message text becomes content,
+// function_call items a chat-style tool_calls array
+static err_t parse_responses_response(const char* json_str, chat_response_t* response) {
+    json_value_t* root = json_parse(json_str);
+    json_object_t* obj = root ? json_as_object(root) : NULL;
+    if (!obj) {
+        json_free(root);
+        return ERR_CONFIG_PARSE;
+    }
+
+    str_builder_t content;
+    str_builder_init(&content, NULL);
+    json_value_t* tool_calls = json_create_array();
+    uint32_t call_count = 0;
+
+    json_array_t* output = json_object_get_array(obj, "output");
+    for (json_array_t* item = output; item; item = item->next) {
+        json_object_t* entry = json_as_object(&item->value);
+        const char* type = entry ? json_object_get_string(entry, "type", "") : "";
+
+        if (strcmp(type, "message") == 0) {
+            for (json_array_t* part = json_object_get_array(entry, "content"); part; part = part->next) {
+                json_object_t* part_obj = json_as_object(&part->value);
+                if (part_obj && strcmp(json_object_get_string(part_obj, "type", ""), "output_text") == 0) {
+                    str_builder_append_cstr(&content, json_object_get_string(part_obj, "text", ""));
+                }
+            }
+        } else if (strcmp(type, "function_call") == 0) {
+            json_value_t* function = json_create_object();
+            json_object_set_string(function, "name", json_object_get_string(entry, "name", ""));
+            json_object_set_string(function, "arguments", json_object_get_string(entry, "arguments", "{}"));
+
+            json_value_t* call = json_create_object();
+            json_object_set_string(call, "id", json_object_get_string(entry, "call_id", ""));
+            json_object_set_string(call, "type", "function");
+            json_object_set(call, "function", function);
+            json_array_append(tool_calls, call);
+            call_count++;
+        }
+    }
+
+    response->content = alloc_str(PROVIDER_ALLOC, str_builder_view(&content));
+    str_builder_free(&content);
+    if (call_count > 0) {
+        char* text = json_print(tool_calls, false);
+        if (text) {
+            response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC, text);
+            json_free_string(text);
+        }
+    }
+    json_free(tool_calls);
+
+    const char* status = json_object_get_string(obj, "status", "completed");
+    const char* finish = call_count > 0 ? "tool_calls"
+                       : strcmp(status, "incomplete") == 0 ? "length" : "stop";
+    response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, finish);
+    response->model = alloc_str_cstr(PROVIDER_ALLOC, json_object_get_string(obj, "model", DEFAULT_OPENAI_MODEL));
+
+    const char* id = json_object_get_string(obj, "id", NULL);
+    if (id) response->response_id = alloc_str_cstr(PROVIDER_ALLOC, id);
+
+    json_object_t* usage = json_object_get_object(obj, "usage");
+    if (usage) {
+        response->prompt_tokens = (uint32_t)json_object_get_number(usage, "input_tokens", 0);
+        response->completion_tokens = (uint32_t)json_object_get_number(usage, "output_tokens", 0);
+        response->total_tokens = (uint32_t)json_object_get_number(usage, "total_tokens", 0);
+    }
+
+    json_free(root);
+    return ERR_OK;
+}
+
+// Whether a failed request was about previous_response_id
+static bool previous_response_missing(const http_response_t* http_resp) {
+    if (http_resp->status_code == 404) return true;
+
+    json_value_t* root = http_resp->body.data ? json_parse(http_resp->body.data) : NULL;
+    json_object_t* obj = root ? json_as_object(root) : NULL;
+    json_object_t* error = obj ? json_object_get_object(obj, "error") : NULL;
+    bool missing = error &&
+        (strcmp(json_object_get_string(error, "code", ""), "previous_response_not_found") == 0 ||
+         strcmp(json_object_get_string(error, "param", ""), "previous_response_id") == 0);
+    json_free(root);
+    return missing;
+}
+
+static err_t openai_chat_continue(provider_t* provider,
+                                  const char* previous_id,
+                                  const chat_message_t* messages,
+                                  uint32_t message_count,
+                                  const tool_def_t* tools,
+                                  uint32_t tool_count,
+                                  const char* model,
+                                  double temperature,
+                                  chat_response_t** out_response) {
+    if (!provider || !provider->http || !out_response) return ERR_INVALID_ARGUMENT;
+
+    char* request_body = build_responses_request(provider, previous_id, messages, message_count,
+                                                 tools, tool_count, model, temperature);
+    if (!request_body) return ERR_OUT_OF_MEMORY;
+
+    char url[512];
+    snprintf(url, sizeof(url), "%.*s/responses",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
+
+    http_response_t* http_resp = NULL;
+    err_t err = http_post_json(provider->http, url, request_body, &http_resp);
+    json_free_string(request_body);
+
+    if (err != ERR_OK) return err;
+    if (!http_response_is_success(http_resp)) {
+        bool missing = previous_id && previous_response_missing(http_resp);
+        http_response_free(http_resp);
+        if (missing) {
+            return ERROR_SET(ERR_NOT_FOUND, "stored response %s is gone", previous_id);
+        }
+        return ERR_PROVIDER;
+    }
+
+    chat_response_t* response = chat_response_create();
+    if (!response) {
+        http_response_free(http_resp);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    err = parse_responses_response(http_resp->body.data, response);
+    http_response_free(http_resp);
+
+    if (err != ERR_OK) {
+        chat_response_free(response);
+        return err;
+    }
+
+    *out_response = response;
+    return ERR_OK;
+}
+
 static err_t openai_list_models(provider_t* provider, str_t** out_models, uint32_t* out_count) {
     (void)provider;
     if (!out_models || !out_count) return ERR_INVALID_ARGUMENT;
@@ -371,7 +684,8 @@ static err_t openai_health_check(provider_t* provider, bool* out_healthy) {
 
     http_response_t* response = NULL;
     char url[512];
-    snprintf(url, sizeof(url), "%s/models", OPENAI_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/models",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     err_t err = http_get(provider->http, url, &response);
     if (err == ERR_OK && response) {
@@ -442,6 +756,13 @@ err_t openai_set_include_reasoning(provider_t* provider, bool include) {
 typedef struct {
     void (*on_chunk)(const char* chunk, void* user_data);
     void* user_data;
+
+    // Set by chat_stream_tools to assemble the full response
+    const chat_stream_handler_t* handler;
+    stream_tool_calls_t* tool_calls;
+    chat_response_t* response;
+    str_builder_t content;
+
     char* buffer;
     size_t buffer_size;
     size_t buffer_capacity;
@@ -449,6 +770,25 @@ typedef struct {
     char partial_line[8192];
 } openai_sse_parser_t;
 
+// delta.tool_calls: [{index, id?, function: {name?, arguments?}}]
+static void openai_sse_tool_call_deltas(openai_sse_parser_t* parser, json_object_t* delta) {
+    json_array_t* calls = json_object_get_array(delta, "tool_calls");
+    size_t count = calls ? json_array_length(calls) : 0;
+
+    for (size_t i = 0; i < count; i++) {
+        json_object_t* call = json_as_object(json_array_get(calls, i));
+        if (!call) continue;
+
+        double index = json_object_get_number(call, "index", (double)i);
+        json_object_t* function = json_object_get_object(call, "function");
+        stream_tool_calls_add(parser->tool_calls, index >= 0 ? (uint32_t)index : 0,
+                              json_object_get_string(call, "id", NULL),
+                              function ? json_object_get_string(function, "name", NULL) : NULL,
+                              function ? json_object_get_string(function, "arguments", NULL) : NULL,
+                              parser->handler);
+    }
+}
+
 static size_t openai_sse_parser_write(const char* data, size_t len, void* userp) {
     openai_sse_parser_t* parser = (openai_sse_parser_t*)userp;
     size_t consumed = 0;
@@ -495,9 +835,32 @@ static size_t openai_sse_parser_write(const char* data, size_t len, void* userp)
                                     if (content && parser->on_chunk) {
                                         parser->on_chunk(content, parser->user_data);
                                     }
+                                    if (content && parser->response) {
+                                        str_builder_append_cstr(&parser->content, content);
+                                    }
+                                    if (parser->tool_calls) {
+                                        openai_sse_tool_call_deltas(parser, delta);
+                                    }
+                                }
+                                const char* finish = json_object_get_string(choice_obj, "finish_reason", NULL);
+                                if (finish && parser->response) {
+                                    free_str(PROVIDER_ALLOC, parser->response->finish_reason);
+                                    parser->response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, finish);
                                 }
                             }
                         }
+
+                        // Usage arrives in a final chunk with no choices
+                        json_object_t* usage = json_object_get_object(obj, "usage");
+                        if (usage && parser->response) {
+                            parser->response->prompt_tokens = (uint32_t)json_object_get_number(usage, "prompt_tokens", 0);
+                            parser->response->completion_tokens = (uint32_t)json_object_get_number(usage, "completion_tokens", 0);
+                            parser->response->total_tokens = (uint32_t)json_object_get_number(usage, "total_tokens", 0);
+                        }
+                        const char* model = json_object_get_string(obj, "model", NULL);
+                        if (model && parser->response && str_empty(parser->response->model)) {
+                            parser->response->model = alloc_str_cstr(PROVIDER_ALLOC, model);
+                        }
                     }
                     json_free(root);
                 }
@@ -526,7 +889,8 @@ static err_t openai_chat_stream(provider_t* provider,
 
     // Build URL
     char url[512];
-    snprintf(url, sizeof(url), "%s/chat/completions", OPENAI_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     // Initialize SSE parser
     openai_sse_parser_t parser = {
@@ -540,7 +904,71 @@ static err_t openai_chat_stream(provider_t* provider,
 
     // Make streaming request
     err_t err = http_post_json_stream(provider->http, url, request_body, openai_sse_parser_write, &parser);
-    free(request_body);
+    json_free_string(request_body);
 
     return err;
-}
\ No newline at end of file
+}
+
+static err_t openai_chat_stream_tools(provider_t* provider,
+                                      const chat_message_t* messages,
+                                      uint32_t message_count,
+                                      const tool_def_t* tools,
+                                      uint32_t tool_count,
+                                      const char* model,
+                                      double temperature,
+                                      const chat_stream_handler_t* handler,
+                                      chat_response_t** out_response) {
+    if (!provider || !provider->http || !out_response) return ERR_INVALID_ARGUMENT;
+
+    char* request_body = build_openai_request(provider, messages, message_count, tools, tool_count,
+                                              model, temperature, true);
+    if (!request_body) return ERR_OUT_OF_MEMORY;
+
+    char url[512];
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
+
+    chat_response_t* response = chat_response_create();
+    stream_tool_calls_t* tool_calls = malloc(sizeof(stream_tool_calls_t));
+    if (!response || !tool_calls) {
+        json_free_string(request_body);
+        chat_response_free(response);
+        free(tool_calls);
+        return ERR_OUT_OF_MEMORY;
+    }
+    stream_tool_calls_init(tool_calls);
+
+    openai_sse_parser_t parser = {
+        .on_chunk = handler ? handler->on_content : NULL,
+        .user_data = handler ? handler->user_data : NULL,
+        .handler = handler,
+        .tool_calls = tool_calls,
+        .response = response,
+        .partial_line_len = 0
+    };
+    str_builder_init(&parser.content, NULL);
+
+    err_t err = http_post_json_stream(provider->http, url, request_body, openai_sse_parser_write, &parser);
+    json_free_string(request_body);
+
+    if (err == ERR_OK) {
+        str_t content = str_builder_view(&parser.content);
+        response->content = alloc_str(PROVIDER_ALLOC, content);
+        response->tool_calls = stream_tool_calls_to_json(tool_calls);
+        if (str_empty(response->model)) {
+            response->model = alloc_str_cstr(PROVIDER_ALLOC, model ? model : DEFAULT_OPENAI_MODEL);
+        }
+    }
+
+    str_builder_free(&parser.content);
+    stream_tool_calls_free(tool_calls);
+    free(tool_calls);
+
+    if (err != ERR_OK) {
+        chat_response_free(response);
+        return err;
+    }
+
+    *out_response = response;
+    return ERR_OK;
+}
@@ -144,33 +144,9 @@ static char* build_openrouter_request(const provider_t* provider,
                                       uint32_t message_count,
                                       const char* model,
                                       double temperature) {
-    json_value_t* root = json_create_object();
-    if (!root) return NULL;
-
-    const char* model_name = model ? model : DEFAULT_OPENROUTER_MODEL;
-    json_object_set_string(root, "model", model_name);
-
-    json_value_t* messages_arr = json_create_array();
-    for (uint32_t i = 0; i < message_count; i++) {
-        json_value_t* msg_obj = json_create_object();
-        const char* role_str = "user";
-        switch (messages[i].role) {
-            case CHAT_ROLE_SYSTEM: role_str = "system"; break;
-            case CHAT_ROLE_USER: role_str = "user"; break;
-            case CHAT_ROLE_ASSISTANT: role_str = "assistant"; break;
-            case CHAT_ROLE_TOOL: role_str = "tool"; break;
-        }
-        json_object_set_string(msg_obj, "role", role_str);
-        json_object_set_string(msg_obj, "content", messages[i].content.data);
-        json_array_append(messages_arr, msg_obj);
-    }
-    json_object_set(root, "messages", messages_arr);
-
-    json_object_set_number(root, "temperature", temperature);
-
-    char* json_str = json_print(root, false);
-    json_free(root);
-    return json_str;
+    return provider_build_chat_request(provider, messages, message_count, NULL, 0,
+                                       model ? model : DEFAULT_OPENROUTER_MODEL,
+                                       temperature, false);
 }
 
 static err_t parse_openrouter_response(const char* json_str, chat_response_t* response) {
@@ -191,15 +167,15 @@ static err_t parse_openrouter_response(const char* json_str, chat_response_t* re
             json_object_t* message = json_object_get_object(choice_obj, "message");
             if (message) {
                 const char* content = json_object_get_string(message, "content", "");
-                response->content = (str_t){ .data = strdup(content), .len = strlen(content) };
+                response->content = alloc_str_cstr(PROVIDER_ALLOC, content);
             }
             const char* finish = json_object_get_string(choice_obj, "finish_reason", "stop");
-            response->finish_reason = (str_t){ .data = strdup(finish), .len = strlen(finish) };
+            response->finish_reason = alloc_str_cstr(PROVIDER_ALLOC, finish);
         }
     }
 
     const char* model = json_object_get_string(obj, "model", DEFAULT_OPENROUTER_MODEL);
-    response->model = (str_t){ .data = strdup(model), .len = strlen(model) };
+    response->model = alloc_str_cstr(PROVIDER_ALLOC, model);
 
     json_free(root);
     return ERR_OK;
@@ -221,11 +197,12 @@ static err_t openrouter_chat(provider_t* provider,
     if (!request_body) return ERR_OUT_OF_MEMORY;
 
     char url[512];
-    snprintf(url, sizeof(url), "%s/chat/completions", OPENROUTER_BASE_URL);
+    snprintf(url, sizeof(url), "%.*s/chat/completions",
+             (int)provider->config.base_url.len, provider->config.base_url.data);
 
     http_response_t* http_resp = NULL;
     err_t err = http_post_json(provider->http, url, request_body, &http_resp);
-    free(request_body);
+    json_free_string(request_body);
 
     if (err != ERR_OK) return err;
     if (!http_response_is_success(http_resp)) {
@@ -233,7 +210,7 @@ static err_t openrouter_chat(provider_t* provider,
         return ERR_PROVIDER;
     }
 
-    chat_response_t* response = calloc(1, sizeof(chat_response_t));
+    chat_response_t* response = chat_response_create();
     if (!response) {
         http_response_free(http_resp);
         return ERR_OUT_OF_MEMORY;
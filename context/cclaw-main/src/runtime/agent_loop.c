@@ -3,14 +3,27 @@
 // SPDX-License-Identifier: MIT
 
 #include "core/agent.h"
+#include "core/channel.h"
 #include "core/config.h"
+#include "core/event_bus.h"
+#include "core/intern.h"
+#include "core/mcp.h"
+#include "core/memory.h"
+#include "core/rag.h"
+#include "core/sandbox.h"
+#include "core/tool.h"
 #include "providers/router.h"
 #include "cclaw.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -18,6 +31,12 @@
 static struct {
     agent_t* agent;
     agent_session_t* session;
+    event_bus_t* bus;               // Turn and tool events; the metrics consumer is on it
+    channel_manager_t* relay;       // Webhook channel relaying the bus to /ws; NULL when off
+    memory_t* memory;               // Shared by the agent and every memory tool
+    sandbox_t* sandbox;             // RUNTIME_KIND_SANDBOX only; shell and file tools run in it
+    char memory_dir[PATH_MAX];      // memory->config.data_dir points here
+    tool_context_t tool_context;    // Copied into each tool, so it outlives them
     bool running;
     struct termios original_termios;
 } g_runtime = {0};
@@ -54,6 +73,136 @@ static void print_assistant_response(const char* response) {
     printf("\n\033[32mAgent:\033[0m %s\n", response);
 }
 
+// ============================================================================
+// Streamed replies
+// ============================================================================
+
+// With stream_responses on, the interactive loop prints the reply as the
+// provider streams it: a thread on the event bus writes the session's token
+// chunks to stdout and reports when the turn is over, so the loop prints the
+// reply itself only when nothing was streamed (tool-only turns, providers
+// that cannot stream).
+
+#define REPLY_ECHO_BATCH 64
+#define REPLY_ECHO_WAIT_MS 100
+#define REPLY_ECHO_DRAIN_MS 2000    // Turn end to the printer catching up
+
+static struct {
+    event_subscription_t* subscription;
+    pthread_t thread;
+    bool stopping;
+    str_t session_id;               // Borrowed from g_runtime.session
+    bool in_reply;                  // Printer thread only
+
+    pthread_mutex_t lock;
+    pthread_cond_t turn_done;
+    uint64_t turns_done;
+    bool streamed;                  // Whether the last turn's reply was printed
+} g_reply = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .turn_done = PTHREAD_COND_INITIALIZER,
+};
+
+static void reply_echo_event(const event_t* event) {
+    if (!str_equal(event->session_id, g_reply.session_id)) return;
+
+    if (event->type == EVENT_TOKEN_CHUNK) {
+        if (!g_reply.in_reply) {
+            printf("\033[K\n\033[32mAgent:\033[0m ");
+            g_reply.in_reply = true;
+        }
+        fwrite(event->text.data, 1, event->text.len, stdout);
+        fflush(stdout);
+        return;
+    }
+
+    if (event->type == EVENT_TURN_COMPLETED) {
+        if (g_reply.in_reply) {
+            printf("\n");
+            fflush(stdout);
+        }
+        pthread_mutex_lock(&g_reply.lock);
+        g_reply.streamed = g_reply.in_reply;
+        g_reply.turns_done++;
+        pthread_cond_broadcast(&g_reply.turn_done);
+        pthread_mutex_unlock(&g_reply.lock);
+        g_reply.in_reply = false;
+    }
+}
+
+static void* reply_echo_thread(void* arg) {
+    event_subscription_t* sub = arg;
+    event_t* events[REPLY_ECHO_BATCH];
+
+    while (!__atomic_load_n(&g_reply.stopping, __ATOMIC_ACQUIRE)) {
+        uint32_t count = event_bus_wait(sub, events, REPLY_ECHO_BATCH, REPLY_ECHO_WAIT_MS);
+        for (uint32_t i = 0; i < count; i++) {
+            reply_echo_event(events[i]);
+            event_release(events[i]);
+        }
+    }
+    return NULL;
+}
+
+// Without a bus, or with streaming off, replies are printed whole
+static void reply_echo_start(void) {
+    if (!g_runtime.bus || !g_runtime.agent->ctx->config.stream_responses) return;
+
+    // Blocking: a chunk dropped from the middle of a reply garbles it
+    uint32_t topics = EVENT_TOPIC(EVENT_TOKEN_CHUNK) | EVENT_TOPIC(EVENT_TURN_COMPLETED);
+    event_subscription_t* sub = NULL;
+    if (event_bus_subscribe(g_runtime.bus, topics, 0, EVENT_OVERFLOW_BLOCK, &sub) != ERR_OK) return;
+
+    g_reply.session_id = g_runtime.session->id;
+    g_reply.in_reply = false;
+    __atomic_store_n(&g_reply.stopping, false, __ATOMIC_RELEASE);
+    if (pthread_create(&g_reply.thread, NULL, reply_echo_thread, sub) != 0) {
+        event_bus_unsubscribe(g_runtime.bus, sub);
+        return;
+    }
+    g_reply.subscription = sub;
+}
+
+static void reply_echo_stop(void) {
+    if (!g_reply.subscription) return;
+
+    __atomic_store_n(&g_reply.stopping, true, __ATOMIC_RELEASE);
+    event_bus_wake(g_reply.subscription);
+    pthread_join(g_reply.thread, NULL);
+    event_bus_unsubscribe(g_runtime.bus, g_reply.subscription);
+    g_reply.subscription = NULL;
+}
+
+static uint64_t reply_echo_turns(void) {
+    pthread_mutex_lock(&g_reply.lock);
+    uint64_t turns = g_reply.turns_done;
+    pthread_mutex_unlock(&g_reply.lock);
+    return turns;
+}
+
+// Waits for the printer to finish the turn after `turns`; true when it
+// printed the reply
+static bool reply_echo_wait(uint64_t turns) {
+    if (!g_reply.subscription) return false;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += REPLY_ECHO_DRAIN_MS / 1000;
+    deadline.tv_nsec += (long)(REPLY_ECHO_DRAIN_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&g_reply.lock);
+    while (g_reply.turns_done == turns) {
+        if (pthread_cond_timedwait(&g_reply.turn_done, &g_reply.lock, &deadline) != 0) break;
+    }
+    bool streamed = g_reply.turns_done != turns && g_reply.streamed;
+    pthread_mutex_unlock(&g_reply.lock);
+    return streamed;
+}
+
 static void print_tool_call(const char* tool_name, const char* args) {
     printf("\033[33m[Tool: %s]\033[0m ", tool_name);
     if (args && strlen(args) < 80) {
@@ -110,6 +259,7 @@ static bool handle_builtin_command(const char* input, agent_t* agent, agent_sess
         printf("  /tools          List available tools\n");
         printf("  /model <name>   Switch model\n");
         printf("  /temp <0-2>     Set temperature\n");
+        printf("  /metrics        Show turn, tool and channel counters\n");
         printf("\n");
         return true;
     }
@@ -154,10 +304,16 @@ static bool handle_builtin_command(const char* input, agent_t* agent, agent_sess
         return true;
     }
 
+    if (strcmp(input, "/metrics") == 0) {
+        char metrics[2048];
+        event_metrics_format(metrics, sizeof(metrics));
+        printf("\n%s\n", metrics);
+        return true;
+    }
+
     if (strncmp(input, "/model ", 7) == 0) {
         const char* model = input + 7;
-        free((void*)session->model.data);
-        session->model = str_dup_cstr(model, NULL);
+        session->model = str_intern_cstr(model);
         printf("\033[32m[Model set to: %s]\033[0m\n", model);
         return true;
     }
@@ -176,19 +332,194 @@ static bool handle_builtin_command(const char* input, agent_t* agent, agent_sess
     return false; // Not a builtin command
 }
 
+// ============================================================================
+// Memory and Tools
+// ============================================================================
+
+// One memory for the agent and all memory tools. A tool left without one
+// opens a private database with its own recall cache, so what
+// memory_store wrote, memory_recall would never see.
+static memory_t* runtime_memory_open(const config_t* config) {
+    const char* backend = str_empty(config->memory.backend) ? "sqlite" : config->memory.backend.data;
+    if (strcmp(backend, "none") == 0) return NULL;
+
+    const char* home = getenv("HOME");
+    snprintf(g_runtime.memory_dir, sizeof(g_runtime.memory_dir), "%s/.cclaw", home ? home : "/tmp");
+    mkdir(g_runtime.memory_dir, 0700);
+    size_t len = strlen(g_runtime.memory_dir);
+    snprintf(g_runtime.memory_dir + len, sizeof(g_runtime.memory_dir) - len, "/memory");
+    if (mkdir(g_runtime.memory_dir, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: cannot create %s: %s\n", g_runtime.memory_dir, strerror(errno));
+        return NULL;
+    }
+
+    memory_config_t memory_config = memory_config_default();
+    memory_config.backend = STR_VIEW(backend);
+    memory_config.data_dir = STR_VIEW(g_runtime.memory_dir);
+
+    memory_t* memory = NULL;
+    err_t err = memory_create(backend, &memory_config, &memory);
+    if (err == ERR_OK) {
+        err = memory->vtable->init(memory);
+        if (err != ERR_OK) {
+            memory_free(memory);
+            memory = NULL;
+        }
+    }
+    if (err != ERR_OK) {
+        fprintf(stderr, "Warning: Failed to open memory backend '%s': %d\n", backend, err);
+        return NULL;
+    }
+    return memory;
+}
+
+static bool runtime_tool_enabled(const agent_config_t* config, const char* name) {
+    if (strcmp(name, "shell") == 0) return config->enable_shell_tool;
+    if (strcmp(name, "file_read") == 0 || strcmp(name, "file_write") == 0) {
+        return config->enable_file_tools;
+    }
+    if (strncmp(name, "memory_", 7) == 0) return config->enable_memory_tools;
+    return true;
+}
+
+static void runtime_add_tool(agent_context_t* ctx, const char* name) {
+    if (!runtime_tool_enabled(&ctx->config, name)) return;
+
+    tool_t* tool = NULL;
+    if (tool_create(name, &tool) != ERR_OK) return;
+
+    const tool_vtable_t* vtable = tool->vtable;
+    bool allowed = !vtable->allowed_in_autonomous ||
+                   vtable->allowed_in_autonomous(ctx->config.autonomy_level);
+    bool has_memory = !vtable->requires_memory || !vtable->requires_memory() ||
+                      g_runtime.tool_context.memory;
+    if (!allowed || !has_memory || !vtable->init ||
+        vtable->init(tool, &g_runtime.tool_context) != ERR_OK) {
+        tool_free(tool);
+        return;
+    }
+    ctx->tools[ctx->tool_count++] = tool;
+}
+
+// Every registered tool (built-in and MCP) the configuration and autonomy
+// level allow, initialized with the runtime's tool context. delegate goes
+// last: its children get the tools loaded before it.
+static void runtime_load_tools(agent_t* agent) {
+    agent_context_t* ctx = agent->ctx;
+
+    const char** names = NULL;
+    uint32_t count = 0;
+    if (tool_registry_list(&names, &count) != ERR_OK || count == 0) return;
+
+    ctx->tools = calloc(count, sizeof(tool_t*));
+    if (!ctx->tools) return;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(names[i], "delegate") != 0) runtime_add_tool(ctx, names[i]);
+    }
+    runtime_add_tool(ctx, "delegate");
+}
+
+// Between turns: when an MCP server changed its tool list, rebuild every
+// instance (delegate lends the others to its children) from the registry.
+static void runtime_refresh_tools(agent_t* agent) {
+    if (!mcp_refresh_tools()) return;
+
+    agent_context_t* ctx = agent->ctx;
+    tool_prefetch_reset(ctx->prefetch, NULL);
+    for (uint32_t i = 0; i < ctx->tool_count; i++) {
+        tool_free(ctx->tools[i]);
+    }
+    free(ctx->tools);
+    ctx->tools = NULL;
+    ctx->tool_count = 0;
+    runtime_load_tools(agent);
+}
+
+// ============================================================================
+// Event relay
+// ============================================================================
+
+// With channels.webhook.stream_events on, the webhook channel listens while
+// the runtime runs and pushes this agent's events to WebSocket clients.
+// Messages it receives go to the bus as EVENT_MESSAGE_RECEIVED; nothing in
+// the runtime answers them.
+static void runtime_start_relay(const config_t* config) {
+    if (!g_runtime.bus || !config->channels.webhook || !config->channels.webhook->stream_events) return;
+
+    channel_config_t channel_config = channel_config_default();
+    channel_config.name = str_dup_cstr("webhook", NULL);
+    channel_config.host = STR_NULL;
+    channel_config.port = config->channels.webhook->port;
+    channel_config.auth_token = str_dup(config->channels.webhook->secret, NULL);
+
+    channel_t* webhook = NULL;
+    err_t err = channel_create("webhook", &channel_config, &webhook);
+    if (err != ERR_OK) {
+        // Not taken over by a channel, so still ours
+        free((void*)channel_config.name.data);
+        free((void*)channel_config.auth_token.data);
+    } else if ((err = webhook->vtable->init(webhook)) == ERR_OK) {
+        // Has to be set before it listens
+        err = channel_webhook_stream_events(webhook, g_runtime.bus);
+    }
+
+    if (err == ERR_OK) {
+        g_runtime.relay = channel_manager_create();
+        err = g_runtime.relay ? channel_manager_add_channel(g_runtime.relay, webhook) : ERR_OUT_OF_MEMORY;
+        if (err != ERR_OK) {
+            channel_free(webhook);
+        } else {
+            err = channel_manager_start_publishing(g_runtime.relay, g_runtime.bus);
+        }
+    } else {
+        channel_free(webhook);
+    }
+
+    if (err != ERR_OK) {
+        fprintf(stderr, "Warning: Failed to start the webhook event relay: %s\n", error_to_string(err));
+        channel_manager_destroy(g_runtime.relay);
+        g_runtime.relay = NULL;
+        return;
+    }
+    printf("[Webhook] Live events for this session: ws://localhost:%u/ws?session=%.*s\n",
+           (unsigned)webhook->config.port, (int)g_runtime.session->id.len, g_runtime.session->id.data);
+}
+
+// ============================================================================
+// Runtime
+// ============================================================================
+
 // Initialize agent runtime
 err_t agent_runtime_init(config_t* config) {
     if (!config) return ERR_INVALID_ARGUMENT;
 
+    // The zygote is a fork of this process, so it comes before MCP and the
+    // tools start threads. Asked for isolation, never run without it.
+    if (config->runtime.kind == RUNTIME_KIND_SANDBOX) {
+        sandbox_config_t sandbox_config = sandbox_config_from(config, config->workspace_dir);
+        err_t sandbox_err = sandbox_create(&sandbox_config, &g_runtime.sandbox);
+        if (sandbox_err != ERR_OK) {
+            const error_ctx_t* last = error_last();
+            str_t reason = last && !str_empty(last->message) ? last->message
+                                                             : STR_VIEW(error_to_string(sandbox_err));
+            fprintf(stderr, "Error: Failed to create sandbox: %.*s\n", (int)reason.len, reason.data);
+            return sandbox_err;
+        }
+    }
+
     // Create agent configuration
     agent_config_t agent_config = agent_config_default();
     agent_config.autonomy_level = config->autonomy.level;
     agent_config.enable_shell_tool = true;  // Default enable
     agent_config.workspace_root = str_dup(config->workspace_dir, NULL);
+    agent_config.differential_history = config->differential_history;
 
     // Create agent
     err_t err = agent_create(&agent_config, &g_runtime.agent);
     if (err != ERR_OK) {
+        sandbox_destroy(g_runtime.sandbox);
+        g_runtime.sandbox = NULL;
         return err;
     }
 
@@ -197,14 +528,37 @@ err_t agent_runtime_init(config_t* config) {
     err = agent_session_create(g_runtime.agent, &session_name, &g_runtime.session);
     if (err != ERR_OK) {
         agent_destroy(g_runtime.agent);
+        g_runtime.agent = NULL;
+        sandbox_destroy(g_runtime.sandbox);
+        g_runtime.sandbox = NULL;
         return err;
     }
 
     // Set default model for session
     if (!str_empty(config->default_model)) {
-        g_runtime.session->model = str_dup(config->default_model, NULL);
+        g_runtime.session->model = str_intern(config->default_model);
+    }
+
+    // Without a bus the agent still works, only unobserved
+    if (event_bus_create(&g_runtime.bus) == ERR_OK) {
+        agent_set_event_bus(g_runtime.agent, g_runtime.bus);
+        err_t metrics_err = event_metrics_start(g_runtime.bus);
+        if (metrics_err != ERR_OK) {
+            fprintf(stderr, "Warning: Failed to start metrics: %s\n", error_to_string(metrics_err));
+        }
+    } else {
+        fprintf(stderr, "Warning: Failed to create the event bus; no metrics\n");
     }
 
+    // Shared memory, and the context every tool is initialized with
+    g_runtime.memory = runtime_memory_open(config);
+    g_runtime.agent->ctx->memory = g_runtime.memory;
+    g_runtime.tool_context = tool_context_default();
+    g_runtime.tool_context.user_data = g_runtime.agent;     // For delegate
+    tool_context_set_memory(&g_runtime.tool_context, g_runtime.memory);
+    tool_context_set_workspace(&g_runtime.tool_context, &config->workspace_dir);
+    tool_context_set_sandbox(&g_runtime.tool_context, g_runtime.sandbox);
+
     // Set up signal handler
     signal(SIGINT, signal_handler);
 
@@ -217,7 +571,8 @@ err_t agent_runtime_init(config_t* config) {
         provider_config_t provider_config = {
             .name = config->default_provider,
             .api_key = config->api_key,
-            .base_url = STR_NULL,
+            .base_url = config->api_url,
+            .response_chaining = config->response_chaining,
             .default_model = config->default_model,
             .default_temperature = config->default_temperature,
             .max_tokens = 4096,
@@ -240,6 +595,16 @@ err_t agent_runtime_init(config_t* config) {
         }
     }
 
+    // Launch configured MCP servers and expose their tools
+    mcp_start_configured(config);
+    runtime_start_relay(config);
+
+    // Workspace and embedding settings for workspace_search
+    rag_configure(config);
+
+    // After MCP, whose servers' tools are in the registry by now
+    runtime_load_tools(g_runtime.agent);
+
     g_runtime.running = true;
 
     return ERR_OK;
@@ -247,11 +612,30 @@ err_t agent_runtime_init(config_t* config) {
 
 // Shutdown agent runtime
 void agent_runtime_shutdown(void) {
+    // Stops listening and drops its subscription before the bus goes
+    channel_manager_destroy(g_runtime.relay);
+    g_runtime.relay = NULL;
+    mcp_stop_all();
+    rag_shutdown();
+
     if (g_runtime.agent) {
         agent_destroy(g_runtime.agent);
         g_runtime.agent = NULL;
     }
     g_runtime.session = NULL;
+
+    // After the agent, so its last events are counted
+    event_metrics_stop();
+    event_bus_destroy(g_runtime.bus);
+    g_runtime.bus = NULL;
+
+    // The tools borrowed these, so they go after the agent
+    memory_free(g_runtime.memory);
+    g_runtime.memory = NULL;
+    sandbox_destroy(g_runtime.sandbox);
+    g_runtime.sandbox = NULL;
+    free((void*)g_runtime.tool_context.workspace_dir.data);
+    g_runtime.tool_context = tool_context_default();
     g_runtime.running = false;
 }
 
@@ -273,6 +657,7 @@ err_t agent_runtime_run_interactive(void) {
 
     char* workspace = strndup(g_runtime.session->working_directory.data,
                               g_runtime.session->working_directory.len);
+    reply_echo_start();
 
     while (g_runtime.running) {
         print_user_prompt(workspace);
@@ -305,12 +690,15 @@ err_t agent_runtime_run_interactive(void) {
         printf("\033[90m[thinking...]\033[0m\r");
         fflush(stdout);
 
+        runtime_refresh_tools(g_runtime.agent);
+        uint64_t turns = reply_echo_turns();
         err_t err = agent_process_message(g_runtime.agent, g_runtime.session, &user_msg, &response);
+        bool streamed = reply_echo_wait(turns);
 
-        printf("\033[K"); // Clear line
+        if (!streamed) printf("\033[K"); // Clear line
 
         if (err == ERR_OK) {
-            print_assistant_response(response.data);
+            if (!streamed) print_assistant_response(response.data);
             free((void*)response.data);
         } else {
             print_error("Failed to process message");
@@ -319,6 +707,7 @@ err_t agent_runtime_run_interactive(void) {
         free(input);
     }
 
+    reply_echo_stop();
     free(workspace);
 
     printf("\n\033[32m[Session saved. Goodbye!]\033[0m\n");
@@ -334,6 +723,7 @@ err_t agent_runtime_run_single(const char* message, char** out_response) {
     str_t user_msg = STR_VIEW(message);
     str_t response = STR_NULL;
 
+    runtime_refresh_tools(g_runtime.agent);
     err_t err = agent_process_message(g_runtime.agent, g_runtime.session, &user_msg, &response);
 
     if (err == ERR_OK) {
@@ -4,6 +4,7 @@
 #include "runtime/daemon.h"
 #include "runtime/agent_loop.h"
 #include "core/alloc.h"
+#include "core/event_bus.h"
 #include "cclaw.h"
 
 #include <stdio.h>
@@ -19,6 +20,7 @@
 #include <time.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/time.h>
 #include <pthread.h>
 
 // Global daemon instance for signal handling
@@ -458,6 +460,16 @@ err_t daemon_start(daemon_t* daemon) {
     daemon_health_init(daemon);
     daemon_health_server_start(daemon);
 
+    alloc_sampler_init(&daemon->alloc_sampler, DAEMON_ALLOC_SAMPLE_INTERVAL_MS, daemon->start_time);
+
+    // A bus of its own, since the daemon never runs agent_runtime_init.
+    // Without one the event counters on /metrics stay at zero.
+    if (event_bus_create(&daemon->bus) == ERR_OK && event_metrics_start(daemon->bus) != ERR_OK) {
+        event_bus_destroy(daemon->bus);
+        daemon->bus = NULL;
+    }
+    if (daemon->bus) agent_set_event_bus(daemon->agent, daemon->bus);
+
     return ERR_OK;
 }
 
@@ -470,6 +482,13 @@ err_t daemon_stop(daemon_t* daemon) {
     daemon_health_server_stop(daemon);
     daemon_health_shutdown(daemon);
 
+    if (daemon->bus) {
+        agent_set_event_bus(daemon->agent, NULL);
+        event_metrics_stop();
+        event_bus_destroy(daemon->bus);
+        daemon->bus = NULL;
+    }
+
     // Remove PID file
     char* pid_path = strndup(daemon->config.pid_file.data, daemon->config.pid_file.len);
     pidfile_remove(pid_path);
@@ -514,11 +533,18 @@ err_t daemon_run_once(daemon_t* daemon) {
     // Run pending cron jobs
     daemon_cron_run_pending(daemon);
 
+    // Serve health and metrics requests
+    daemon_health_server_poll(daemon);
+
     // Update uptime
+    uint64_t now_ms = (uint64_t)time(NULL) * 1000;
     if (daemon->start_time > 0) {
-        daemon->health.uptime_ms = ((uint64_t)time(NULL) * 1000) - daemon->start_time;
+        daemon->health.uptime_ms = now_ms - daemon->start_time;
     }
 
+    // Log allocation growth (stdout is the daemon log)
+    alloc_sampler_tick(&daemon->alloc_sampler, now_ms, stdout);
+
     return ERR_OK;
 }
 
@@ -700,10 +726,86 @@ err_t daemon_health_server_start(daemon_t* daemon) {
         return ERR_FAILED;
     }
 
+    // Polled from the main loop, so accept() must never block
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
     daemon->health_fd = fd;
     return ERR_OK;
 }
 
+static size_t health_format_metrics(daemon_t* daemon, char* buffer, size_t size) {
+    const health_status_t* h = &daemon->health;
+
+    int n = snprintf(buffer, size,
+        "# TYPE cclaw_healthy gauge\n"
+        "cclaw_healthy %d\n"
+        "# TYPE cclaw_uptime_ms gauge\n"
+        "cclaw_uptime_ms %llu\n"
+        "# TYPE cclaw_messages_processed_total counter\n"
+        "cclaw_messages_processed_total %u\n"
+        "# TYPE cclaw_api_calls_total counter\n"
+        "cclaw_api_calls_total %u\n"
+        "# TYPE cclaw_errors_total counter\n"
+        "cclaw_errors_total %u\n"
+        "# TYPE cclaw_response_time_ms gauge\n"
+        "cclaw_response_time_ms %.3f\n",
+        h->healthy ? 1 : 0, (unsigned long long)h->uptime_ms,
+        h->messages_processed, h->api_calls_made, h->errors_count,
+        h->avg_response_time_ms);
+    if (n < 0 || (size_t)n >= size) return 0;
+
+    size_t pos = (size_t)n;
+    pos += memory_cache_metrics(buffer + pos, size - pos);
+    pos += event_metrics_format(buffer + pos, size - pos);
+    return pos + alloc_subsystem_metrics(buffer + pos, size - pos);
+}
+
+static void health_serve_client(daemon_t* daemon, int client) {
+    // Clients get a short window to send the request line
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 200000 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    char request[512];
+    ssize_t n = read(client, request, sizeof(request) - 1);
+    request[n > 0 ? n : 0] = '\0';
+
+    char body[8192];
+    size_t body_len;
+    const char* content_type = "text/plain; version=0.0.4";
+
+    if (strncmp(request, "GET /metrics", 12) == 0) {
+        body_len = health_format_metrics(daemon, body, sizeof(body));
+    } else {
+        int len = snprintf(body, sizeof(body), "%s\n", daemon_status_string(daemon));
+        body_len = len > 0 ? (size_t)len : 0;
+        content_type = "text/plain";
+    }
+
+    char header[128];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\n\r\n",
+                              content_type, body_len);
+
+    if (write(client, header, (size_t)header_len) == header_len) {
+        ssize_t written = write(client, body, body_len);
+        (void)written;
+    }
+}
+
+void daemon_health_server_poll(daemon_t* daemon) {
+    if (!daemon || daemon->health_fd < 0) return;
+
+    for (;;) {
+        int client = accept(daemon->health_fd, NULL, NULL);
+        if (client < 0) break;  // EAGAIN: nothing pending
+
+        // Accepted sockets may inherit O_NONBLOCK on some platforms
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+        health_serve_client(daemon, client);
+        close(client);
+    }
+}
+
 void daemon_health_server_stop(daemon_t* daemon) {
     if (!daemon) return;
 
@@ -18,6 +18,16 @@
 // Global TUI instance for signal handling
 static tui_t* g_tui = NULL;
 
+// Chat messages and input history are accounted to the TUI subsystem
+#define TUI_ALLOC allocator_subsystem(ALLOC_SUBSYS_TUI)
+
+static char* tui_strdup(const char* s) {
+    size_t len = strlen(s);
+    char* copy = alloc(TUI_ALLOC, len + 1);
+    if (copy) memcpy(copy, s, len + 1);
+    return copy;
+}
+
 // ============================================================================
 // Terminal Control
 // ============================================================================
@@ -268,7 +278,7 @@ void tui_destroy(tui_t* tui) {
     free(tui->input_buffer);
 
     for (uint32_t i = 0; i < tui->history_count; i++) {
-        free(tui->history[i]);
+        free_ptr(TUI_ALLOC, tui->history[i], 0);
     }
     free(tui->history);
 
@@ -276,9 +286,9 @@ void tui_destroy(tui_t* tui) {
     tui_message_t* msg = tui->messages;
     while (msg) {
         tui_message_t* next = msg->next;
-        free(msg->text);
-        free(msg->sender);
-        free(msg);
+        free_ptr(TUI_ALLOC, msg->text, 0);
+        free_ptr(TUI_ALLOC, msg->sender, 0);
+        free_ptr(TUI_ALLOC, msg, sizeof(tui_message_t));
         msg = next;
     }
 
@@ -714,7 +724,7 @@ err_t tui_process_input(tui_t* tui) {
             if (err == ERR_OK && new_session) {
                 // Copy model from active session or use default
                 if (tui->agent->ctx->active_session && !str_empty(tui->agent->ctx->active_session->model)) {
-                    new_session->model = str_dup(tui->agent->ctx->active_session->model, NULL);
+                    new_session->model = tui->agent->ctx->active_session->model;
                 }
                 tui->agent->ctx->active_session = new_session;
                 tui_chat_add_system_message(tui, "Created new session");
@@ -738,7 +748,7 @@ err_t tui_process_input(tui_t* tui) {
             err_t err = agent_session_create(tui->agent, &branch_name, &new_branch);
             if (err == ERR_OK && new_branch) {
                 if (!str_empty(tui->agent->ctx->active_session->model)) {
-                    new_branch->model = str_dup(tui->agent->ctx->active_session->model, NULL);
+                    new_branch->model = tui->agent->ctx->active_session->model;
                 }
                 tui->agent->ctx->active_session = new_branch;
                 tui_chat_add_system_message(tui, "Created new branch");
@@ -1018,7 +1028,7 @@ void tui_history_add(tui_t* tui, const char* entry) {
 
     // Shift history
     if (tui->history_count >= tui->history_capacity) {
-        free(tui->history[tui->history_capacity - 1]);
+        free_ptr(TUI_ALLOC, tui->history[tui->history_capacity - 1], 0);
         tui->history_count--;
     }
 
@@ -1026,7 +1036,7 @@ void tui_history_add(tui_t* tui, const char* entry) {
         tui->history[i] = tui->history[i - 1];
     }
 
-    tui->history[0] = strdup(entry);
+    tui->history[0] = tui_strdup(entry);
     tui->history_count++;
     tui->history_pos = (uint32_t)-1;
 }
@@ -1061,11 +1071,11 @@ const char* tui_history_next(tui_t* tui) {
 static void tui_chat_add_message_internal(tui_t* tui, const char* sender, const char* text) {
     if (!tui || !text) return;
 
-    tui_message_t* msg = calloc(1, sizeof(tui_message_t));
+    tui_message_t* msg = alloc_zeroed(TUI_ALLOC, sizeof(tui_message_t));
     if (!msg) return;
 
-    msg->sender = strdup(sender);
-    msg->text = strdup(text);
+    msg->sender = tui_strdup(sender);
+    msg->text = tui_strdup(text);
     msg->timestamp = 0; // TODO: get actual timestamp
     msg->next = NULL;
 
@@ -1082,9 +1092,9 @@ static void tui_chat_add_message_internal(tui_t* tui, const char* sender, const
     if (tui->message_count > 1000) {
         tui_message_t* old = tui->messages;
         tui->messages = old->next;
-        free(old->text);
-        free(old->sender);
-        free(old);
+        free_ptr(TUI_ALLOC, old->text, 0);
+        free_ptr(TUI_ALLOC, old->sender, 0);
+        free_ptr(TUI_ALLOC, old, sizeof(tui_message_t));
         tui->message_count--;
     }
 }
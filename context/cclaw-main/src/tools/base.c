@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "core/tool.h"
+#include "core/alloc.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,7 +12,7 @@ typedef struct {
     const tool_vtable_t* vtable;
 } tool_backend_entry_t;
 
-#define MAX_TOOL_BACKENDS 32
+#define MAX_TOOL_BACKENDS 64
 static tool_backend_entry_t g_registry[MAX_TOOL_BACKENDS];
 static uint32_t g_backend_count = 0;
 static bool g_registry_initialized = false;
@@ -31,6 +32,9 @@ err_t tool_registry_init(void) {
     tool_register("memory_store", memory_store_tool_get_vtable());
     tool_register("memory_recall", memory_recall_tool_get_vtable());
     tool_register("memory_forget", memory_forget_tool_get_vtable());
+    tool_register("delegate", delegate_tool_get_vtable());
+    tool_register("workspace_search", workspace_search_tool_get_vtable());
+    tool_register("tool_output_read", tool_output_read_tool_get_vtable());
 
     return ERR_OK;
 }
@@ -60,6 +64,21 @@ err_t tool_register(const char* name, const tool_vtable_t* vtable) {
     return ERR_OK;
 }
 
+err_t tool_unregister(const char* name) {
+    if (!name) return ERR_INVALID_ARGUMENT;
+
+    for (uint32_t i = 0; i < g_backend_count; i++) {
+        if (strcmp(g_registry[i].name, name) == 0) {
+            memmove(&g_registry[i], &g_registry[i + 1],
+                    sizeof(g_registry[0]) * (g_backend_count - i - 1));
+            g_backend_count--;
+            return ERR_OK;
+        }
+    }
+
+    return ERR_NOT_FOUND;
+}
+
 err_t tool_create(const char* name, tool_t** out_tool) {
     if (!name || !out_tool) return ERR_INVALID_ARGUMENT;
     if (!g_registry_initialized) tool_registry_init();
@@ -106,7 +125,16 @@ void tool_free(tool_t* tool) {
     }
 }
 
-// Result helpers
+bool tool_is_read_only(const tool_t* tool) {
+    if (!tool || !tool->vtable) return false;
+    if (tool->vtable->is_read_only) return tool->vtable->is_read_only();
+    return tool->vtable->allowed_in_autonomous &&
+           tool->vtable->allowed_in_autonomous(AUTONOMY_LEVEL_READONLY);
+}
+
+// Result helpers. Result strings are accounted to the tools subsystem.
+#define TOOL_ALLOC allocator_subsystem(ALLOC_SUBSYS_TOOLS)
+
 tool_result_t tool_result_create(void) {
     return (tool_result_t){
         .content = STR_NULL,
@@ -118,8 +146,8 @@ tool_result_t tool_result_create(void) {
 void tool_result_free(tool_result_t* result) {
     if (!result) return;
 
-    free((void*)result->content.data);
-    free((void*)result->error_message.data);
+    free_str(TOOL_ALLOC, result->content);
+    free_str(TOOL_ALLOC, result->error_message);
 
     result->content = STR_NULL;
     result->error_message = STR_NULL;
@@ -133,8 +161,7 @@ void tool_result_set_success(tool_result_t* result, const str_t* content) {
 
     result->success = true;
     if (content && !str_empty(*content)) {
-        result->content.data = strdup(content->data);
-        result->content.len = content->len;
+        result->content = alloc_str(TOOL_ALLOC, *content);
     }
 }
 
@@ -145,8 +172,7 @@ void tool_result_set_error(tool_result_t* result, const str_t* error_message) {
 
     result->success = false;
     if (error_message && !str_empty(*error_message)) {
-        result->error_message.data = strdup(error_message->data);
-        result->error_message.len = error_message->len;
+        result->error_message = alloc_str(TOOL_ALLOC, *error_message);
     }
 }
 
@@ -155,7 +181,8 @@ tool_context_t tool_context_default(void) {
     return (tool_context_t){
         .user_data = NULL,
         .memory = NULL,
-        .workspace_dir = STR_NULL
+        .workspace_dir = STR_NULL,
+        .sandbox = NULL
     };
 }
 
@@ -172,4 +199,11 @@ err_t tool_context_set_workspace(tool_context_t* context, const str_t* workspace
     free((void*)context->workspace_dir.data);
     context->workspace_dir = str_dup(*workspace_dir, NULL);
     return ERR_OK;
-}
\ No newline at end of file
+}
+
+err_t tool_context_set_sandbox(tool_context_t* context, sandbox_t* sandbox) {
+    if (!context) return ERR_INVALID_ARGUMENT;
+
+    context->sandbox = sandbox;
+    return ERR_OK;
+}
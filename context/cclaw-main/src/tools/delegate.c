@@ -0,0 +1,440 @@
+// delegate.c - Sub-agent delegation and the "delegate" tool for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/delegate.h"
+#include "core/intern.h"
+#include "core/str_builder.h"
+#include "utils/clock.h"
+#include "json_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+struct delegator_t {
+    agent_t* parent;
+    worker_pool_t* pool;
+
+    // One provider per worker, cloned from the parent's on first use
+    provider_t** providers;
+    uint32_t provider_count;
+
+    // Parent tools lent to every child, minus "delegate"
+    tool_t** tools;
+    uint32_t tool_count;
+};
+
+typedef struct delegate_job_t {
+    delegator_t* delegator;
+    const delegate_task_t* task;
+    delegate_result_t* result;
+    str_t model;                // Parent session's model override, borrowed
+    double temperature;
+} delegate_job_t;
+
+// Copy at most max bytes without splitting a UTF-8 sequence
+static str_t dup_truncated(str_t s, uint32_t max, bool* out_truncated) {
+    *out_truncated = s.len > max;
+    if (!*out_truncated) return str_dup(s, NULL);
+
+    uint32_t len = max;
+    while (len > 0 && ((unsigned char)s.data[len] & 0xC0) == 0x80) {
+        len--;
+    }
+    return str_dup((str_t){ .data = s.data, .len = len }, NULL);
+}
+
+// ============================================================================
+// Delegator
+// ============================================================================
+
+err_t delegator_create(agent_t* parent, uint32_t concurrency, delegator_t** out_delegator) {
+    if (!parent || !parent->ctx || !out_delegator) return ERR_INVALID_ARGUMENT;
+    if (!parent->ctx->provider) return ERR_NOT_INITIALIZED;
+
+    if (concurrency == 0) concurrency = DELEGATE_DEFAULT_CONCURRENCY;
+
+    delegator_t* delegator = calloc(1, sizeof(delegator_t));
+    if (!delegator) return ERR_OUT_OF_MEMORY;
+    delegator->parent = parent;
+
+    delegator->providers = calloc(concurrency, sizeof(provider_t*));
+    agent_context_t* ctx = parent->ctx;
+    if (ctx->tool_count > 0) {
+        delegator->tools = calloc(ctx->tool_count, sizeof(tool_t*));
+    }
+    if (!delegator->providers || (ctx->tool_count > 0 && !delegator->tools)) {
+        delegator_destroy(delegator);
+        return ERR_OUT_OF_MEMORY;
+    }
+    delegator->provider_count = concurrency;
+
+    for (uint32_t i = 0; i < ctx->tool_count; i++) {
+        if (!str_equal_cstr(ctx->tools[i]->vtable->get_name(), "delegate")) {
+            delegator->tools[delegator->tool_count++] = ctx->tools[i];
+        }
+    }
+
+    err_t err = worker_pool_create(concurrency, DELEGATE_MAX_TASKS, &delegator->pool);
+    if (err != ERR_OK) {
+        delegator_destroy(delegator);
+        return err;
+    }
+
+    *out_delegator = delegator;
+    return ERR_OK;
+}
+
+void delegator_destroy(delegator_t* delegator) {
+    if (!delegator) return;
+
+    worker_pool_destroy(delegator->pool);
+    for (uint32_t i = 0; i < delegator->provider_count; i++) {
+        provider_free(delegator->providers[i]);
+    }
+    free(delegator->providers);
+    free(delegator->tools);
+    free(delegator);
+}
+
+static err_t worker_provider(delegator_t* delegator, uint32_t worker_index, provider_t** out_provider) {
+    provider_t** slot = &delegator->providers[worker_index];
+    if (!*slot) {
+        provider_t* parent = delegator->parent->ctx->provider;
+        err_t err = parent->vtable->create(&parent->config, slot);
+        if (err != ERR_OK) return err;
+    }
+    *out_provider = *slot;
+    return ERR_OK;
+}
+
+static err_t run_child(delegate_job_t* job, uint32_t worker_index, str_t* out_answer) {
+    delegator_t* delegator = job->delegator;
+    const delegate_task_t* task = job->task;
+    const agent_config_t* parent_config = &delegator->parent->ctx->config;
+
+    provider_t* provider = NULL;
+    err_t err = worker_provider(delegator, worker_index, &provider);
+    if (err != ERR_OK) return err;
+
+    // Only scalar settings are inherited; the string members belong to the
+    // parent's config and would be freed twice.
+    agent_config_t config = agent_config_default();
+    config.max_iterations = task->max_iterations ? task->max_iterations : DELEGATE_DEFAULT_MAX_ITERATIONS;
+    config.max_tokens_per_request = parent_config->max_tokens_per_request;
+    config.auto_confirm = parent_config->auto_confirm;
+    config.autonomy_level = parent_config->autonomy_level;
+    config.tool_output_spill_bytes = parent_config->tool_output_spill_bytes;
+
+    agent_t* child = NULL;
+    err = agent_create(&config, &child);
+    if (err != ERR_OK) return err;
+
+    child->ctx->provider = provider;
+    child->ctx->memory = delegator->parent->ctx->memory;
+    child->ctx->tools = delegator->tools;
+    child->ctx->tool_count = delegator->tool_count;
+
+    agent_session_t* session = NULL;
+    str_t name = str_empty(task->name) ? STR_LIT("delegate") : task->name;
+    err = agent_session_create(child, &name, &session);
+    if (err == ERR_OK) {
+        uint32_t timeout = task->timeout_ms ? task->timeout_ms : DELEGATE_DEFAULT_TIMEOUT_MS;
+        session->deadline_ms = clock_monotonic_ms() + timeout;
+        session->token_budget = task->token_budget;
+        session->temperature = job->temperature;
+        if (!str_empty(job->model)) {
+            session->model = str_intern(job->model);
+        }
+
+        err = agent_process_message(child, session, &task->prompt, out_answer);
+        if (err == ERR_OK && str_empty(*out_answer)) {
+            err = ERROR_SET(ERR_CANCELLED, "no answer within %u iterations", config.max_iterations);
+        }
+        job->result->tokens = session->total_tokens;
+    }
+
+    // Borrowed, not owned by the child
+    child->ctx->provider = NULL;
+    child->ctx->memory = NULL;
+    child->ctx->tools = NULL;
+    child->ctx->tool_count = 0;
+    agent_destroy(child);
+    return err;
+}
+
+static void delegate_job_run(void* arg, uint32_t worker_index) {
+    delegate_job_t* job = arg;
+    delegate_result_t* result = job->result;
+    uint64_t started = clock_monotonic_ms();
+
+    str_t answer = STR_NULL;
+    err_t err = run_child(job, worker_index, &answer);
+
+    result->status = err;
+    if (err == ERR_OK) {
+        result->output = dup_truncated(answer, DELEGATE_RESULT_MAX_CHARS, &result->truncated);
+    } else {
+        const error_ctx_t* last = error_last();
+        result->output = last && last->code == err
+            ? str_dup(error_message(last), NULL)
+            : str_dup_cstr(error_to_string(err), NULL);
+    }
+    free((void*)answer.data);
+    result->elapsed_ms = clock_monotonic_ms() - started;
+}
+
+err_t delegator_run(delegator_t* delegator, const delegate_task_t* tasks, uint32_t count,
+                    delegate_result_t* out_results) {
+    if (!delegator || !tasks || !out_results) return ERR_INVALID_ARGUMENT;
+    if (count == 0 || count > DELEGATE_MAX_TASKS) {
+        return ERROR_SET(ERR_INVALID_ARGUMENT, "between 1 and %d tasks allowed", DELEGATE_MAX_TASKS);
+    }
+
+    memset(out_results, 0, sizeof(delegate_result_t) * count);
+
+    // Children inherit the parent session's model choice
+    agent_session_t* parent_session = agent_session_get_active(delegator->parent);
+    delegate_job_t jobs[DELEGATE_MAX_TASKS];
+
+    worker_group_t group;
+    worker_group_init(&group, delegator->pool);
+
+    err_t err = ERR_OK;
+    uint32_t submitted = 0;
+    for (; submitted < count; submitted++) {
+        jobs[submitted] = (delegate_job_t){
+            .delegator = delegator,
+            .task = &tasks[submitted],
+            .result = &out_results[submitted],
+            .model = parent_session ? parent_session->model : STR_NULL,
+            .temperature = parent_session ? parent_session->temperature : 0.7,
+        };
+        err = worker_group_submit(&group, delegate_job_run, &jobs[submitted]);
+        if (err != ERR_OK) break;
+    }
+
+    worker_group_wait(&group);
+    worker_group_destroy(&group);
+
+    if (err != ERR_OK) {
+        delegate_results_free(out_results, submitted);
+        return err;
+    }
+    return ERR_OK;
+}
+
+void delegate_results_free(delegate_result_t* results, uint32_t count) {
+    if (!results) return;
+
+    for (uint32_t i = 0; i < count; i++) {
+        free((void*)results[i].output.data);
+        results[i].output = STR_NULL;
+    }
+}
+
+static const char* status_label(err_t status) {
+    switch (status) {
+        case ERR_OK: return "ok";
+        case ERR_TIMEOUT: return "timeout";
+        case ERR_CANCELLED: return "budget";
+        default: return "error";
+    }
+}
+
+str_t delegate_results_format(const delegate_task_t* tasks, const delegate_result_t* results,
+                              uint32_t count) {
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) str_builder_append_char(&sb, '\n');
+
+        str_builder_appendf(&sb, "### %u", i + 1);
+        if (!str_empty(tasks[i].name)) {
+            str_builder_appendf(&sb, " %.*s", (int)tasks[i].name.len, tasks[i].name.data);
+        }
+        str_builder_appendf(&sb, " [%s, %u tokens, %llu ms]\n", status_label(results[i].status),
+                            results[i].tokens, (unsigned long long)results[i].elapsed_ms);
+        str_builder_append(&sb, results[i].output);
+        if (results[i].truncated) {
+            str_builder_append_cstr(&sb, " [...]");
+        }
+        str_builder_append_char(&sb, '\n');
+    }
+
+    return str_builder_finish(&sb, NULL);
+}
+
+// ============================================================================
+// Tool
+// ============================================================================
+
+static str_t delegate_get_name(void) {
+    return STR_LIT("delegate");
+}
+
+static str_t delegate_get_description(void) {
+    return STR_LIT("Hand independent subtasks to sub-agents that run concurrently, each in a "
+                   "fresh conversation, and return their condensed answers");
+}
+
+static str_t delegate_get_version(void) {
+    return STR_LIT("1.0.0");
+}
+
+static str_t delegate_get_parameters_schema(void) {
+    return STR_LIT("{"
+        "\"type\":\"object\","
+        "\"properties\":{"
+            "\"tasks\":{\"type\":\"array\",\"maxItems\":16,\"items\":{"
+                "\"type\":\"object\","
+                "\"properties\":{"
+                    "\"name\":{\"type\":\"string\"},"
+                    "\"prompt\":{\"type\":\"string\",\"description\":\"Self-contained instructions\"},"
+                    "\"max_iterations\":{\"type\":\"integer\"},"
+                    "\"token_budget\":{\"type\":\"integer\"},"
+                    "\"timeout_ms\":{\"type\":\"integer\"}"
+                "},"
+                "\"required\":[\"prompt\"]"
+            "}}"
+        "},"
+        "\"required\":[\"tasks\"]"
+    "}");
+}
+
+static err_t delegate_create(tool_t** out_tool);
+static void delegate_destroy(tool_t* tool);
+static err_t delegate_init(tool_t* tool, const tool_context_t* context);
+static void delegate_cleanup(tool_t* tool);
+static err_t delegate_execute(tool_t* tool, const str_t* args, tool_result_t* out_result);
+
+static bool delegate_requires_memory(void) {
+    return false;
+}
+
+static bool delegate_allowed_in_autonomous(autonomy_level_t level) {
+    // Children are bound by the same autonomy rules as the parent
+    return level != AUTONOMY_LEVEL_READONLY;
+}
+
+static const tool_vtable_t delegate_vtable = {
+    .get_name = delegate_get_name,
+    .get_description = delegate_get_description,
+    .get_version = delegate_get_version,
+    .create = delegate_create,
+    .destroy = delegate_destroy,
+    .init = delegate_init,
+    .cleanup = delegate_cleanup,
+    .execute = delegate_execute,
+    .get_parameters_schema = delegate_get_parameters_schema,
+    .requires_memory = delegate_requires_memory,
+    .allowed_in_autonomous = delegate_allowed_in_autonomous
+};
+
+const tool_vtable_t* delegate_tool_get_vtable(void) {
+    return &delegate_vtable;
+}
+
+static err_t delegate_create(tool_t** out_tool) {
+    if (!out_tool) return ERR_INVALID_ARGUMENT;
+
+    tool_t* tool = tool_alloc(&delegate_vtable);
+    if (!tool) return ERR_OUT_OF_MEMORY;
+
+    *out_tool = tool;
+    return ERR_OK;
+}
+
+static void delegate_destroy(tool_t* tool) {
+    if (!tool) return;
+    delegate_cleanup(tool);
+    free(tool);
+}
+
+static err_t delegate_init(tool_t* tool, const tool_context_t* context) {
+    if (!tool || !context) return ERR_INVALID_ARGUMENT;
+    if (tool->initialized) return ERR_OK;
+
+    if (!context->user_data) {
+        return ERROR_SET(ERR_INVALID_ARGUMENT, "delegate tool needs the parent agent as user_data");
+    }
+
+    delegator_t* delegator = NULL;
+    err_t err = delegator_create(context->user_data, DELEGATE_DEFAULT_CONCURRENCY, &delegator);
+    if (err != ERR_OK) return err;
+
+    tool->context = *context;
+    tool->impl_data = delegator;
+    tool->initialized = true;
+    return ERR_OK;
+}
+
+static void delegate_cleanup(tool_t* tool) {
+    if (!tool) return;
+
+    delegator_destroy(tool->impl_data);
+    tool->impl_data = NULL;
+    tool->initialized = false;
+}
+
+static uint32_t task_number(json_object_t* obj, const char* key) {
+    double value = json_object_get_number(obj, key, 0);
+    return value > 0 && value < UINT32_MAX ? (uint32_t)value : 0;
+}
+
+static err_t delegate_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    if (!tool || !args || !out_result) return ERR_INVALID_ARGUMENT;
+    if (!tool->initialized) return ERR_NOT_INITIALIZED;
+
+    char* text = strndup(args->data ? args->data : "", args->len);
+    json_value_t* root = text ? json_parse(text) : NULL;
+    free(text);
+
+    json_array_t* list = root && json_is_object(root)
+        ? json_object_get_array(json_as_object(root), "tasks") : NULL;
+    size_t count = list ? json_array_length(list) : 0;
+    if (count == 0 || count > DELEGATE_MAX_TASKS) {
+        json_free(root);
+        str_t error = STR_LIT("Expected 1-16 objects in \"tasks\"");
+        tool_result_set_error(out_result, &error);
+        return ERR_OK;
+    }
+
+    delegate_task_t tasks[DELEGATE_MAX_TASKS];
+    for (size_t i = 0; i < count; i++) {
+        json_object_t* item = json_as_object(json_array_get(list, i));
+        const char* prompt = item ? json_object_get_string(item, "prompt", NULL) : NULL;
+        if (!prompt || !*prompt) {
+            json_free(root);
+            str_t error = STR_LIT("Every task needs a \"prompt\"");
+            tool_result_set_error(out_result, &error);
+            return ERR_OK;
+        }
+
+        // Strings stay owned by the JSON tree until the run is over
+        const char* name = json_object_get_string(item, "name", NULL);
+        tasks[i] = (delegate_task_t){
+            .name = name ? STR_VIEW(name) : STR_NULL,
+            .prompt = STR_VIEW(prompt),
+            .max_iterations = task_number(item, "max_iterations"),
+            .token_budget = task_number(item, "token_budget"),
+            .timeout_ms = task_number(item, "timeout_ms"),
+        };
+    }
+
+    delegate_result_t results[DELEGATE_MAX_TASKS];
+    err_t err = delegator_run(tool->impl_data, tasks, (uint32_t)count, results);
+    if (err != ERR_OK) {
+        json_free(root);
+        return err;
+    }
+
+    str_t summary = delegate_results_format(tasks, results, (uint32_t)count);
+    tool_result_set_success(out_result, &summary);
+    free((void*)summary.data);
+
+    delegate_results_free(results, (uint32_t)count);
+    json_free(root);
+    return ERR_OK;
+}
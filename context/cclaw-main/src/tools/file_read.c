@@ -3,6 +3,7 @@
 
 #include "core/tool.h"
 #include "core/config.h"
+#include "core/sandbox.h"
 #include "json_config.h"
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +13,14 @@
 #include <limits.h>
 #include <sys/stat.h>
 
+#if defined(__APPLE__)
+#define stat_mtime_spec(st) ((st)->st_mtimespec)
+#define stat_ctime_spec(st) ((st)->st_ctimespec)
+#else
+#define stat_mtime_spec(st) ((st)->st_mtim)
+#define stat_ctime_spec(st) ((st)->st_ctim)
+#endif
+
 // File read tool instance data
 typedef struct file_read_tool_t {
     config_t* config;           // Configuration for path restrictions
@@ -31,6 +40,8 @@ static err_t file_read_execute(tool_t* tool, const str_t* args, tool_result_t* o
 static str_t file_read_get_parameters_schema(void);
 static bool file_read_requires_memory(void);
 static bool file_read_allowed_in_autonomous(autonomy_level_t level);
+static bool file_read_is_read_only(void);
+static bool file_read_cache_validator(tool_t* tool, const str_t* args, uint64_t* out_validator);
 
 // VTable definition
 static const tool_vtable_t file_read_vtable = {
@@ -44,7 +55,9 @@ static const tool_vtable_t file_read_vtable = {
     .execute = file_read_execute,
     .get_parameters_schema = file_read_get_parameters_schema,
     .requires_memory = file_read_requires_memory,
-    .allowed_in_autonomous = file_read_allowed_in_autonomous
+    .allowed_in_autonomous = file_read_allowed_in_autonomous,
+    .is_read_only = file_read_is_read_only,
+    .cache_validator = file_read_cache_validator
 };
 
 // Get vtable
@@ -103,7 +116,8 @@ static void file_read_destroy(tool_t* tool) {
     free(file_read_data);
     tool->impl_data = NULL;
 
-    tool_free(tool);
+    // tool_free() would call back into this function
+    free(tool);
 }
 
 static err_t file_read_init(tool_t* tool, const tool_context_t* context) {
@@ -234,6 +248,45 @@ static err_t read_file_contents(const char* path, size_t max_size, tool_result_t
     return ERR_OK;
 }
 
+// The sandboxed read reports the same errors as read_file_contents()
+static err_t read_in_sandbox(sandbox_t* sandbox, const char* path, size_t max_size,
+                             tool_result_t* out_result) {
+    char* data = NULL;
+    size_t len = 0;
+    err_t err = sandbox_read_file(sandbox, path, max_size, &data, &len);
+
+    if (err == ERR_OK) {
+        str_t content = { .data = data, .len = (uint32_t)len };
+        tool_result_set_success(out_result, &content);
+        free(data);
+        return ERR_OK;
+    }
+
+    str_t error = err == ERR_FILE_NOT_FOUND ? STR_LIT("Failed to stat file")
+                : err == ERR_INVALID_ARGUMENT ? STR_LIT("Not a regular file")
+                : err == ERR_FILE_TOO_LARGE ? STR_LIT("File too large")
+                : err == ERR_PERMISSION_DENIED ? STR_LIT("Failed to open file")
+                : STR_LIT("Failed to read file in sandbox");
+    tool_result_set_error(out_result, &error);
+    return err;
+}
+
+// Args are JSON with a "path" field; a bare path is accepted too
+static char* path_from_args(const str_t* args) {
+    char* text = strndup(args->data ? args->data : "", args->len);
+    if (!text || text[0] != '{') return text;
+
+    json_value_t* root = json_parse(text);
+    json_object_t* obj = root ? json_as_object(root) : NULL;
+    const char* path = obj ? json_object_get_string(obj, "path", NULL) : NULL;
+    if (path) {
+        free(text);
+        text = strdup(path);
+    }
+    json_free(root);
+    return text;
+}
+
 static err_t file_read_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
     if (!tool || !tool->impl_data || !tool->initialized || !args || !out_result) {
         return ERR_INVALID_ARGUMENT;
@@ -241,15 +294,9 @@ static err_t file_read_execute(tool_t* tool, const str_t* args, tool_result_t* o
 
     file_read_tool_t* file_read_data = (file_read_tool_t*)tool->impl_data;
 
-    // Parse args (expecting JSON with "path" field)
-    // For simplicity, treat args as plain file path for now
-    // TODO: Parse JSON args properly
-    char* path = malloc(args->len + 1);
+    char* path = path_from_args(args);
     if (!path) return ERR_OUT_OF_MEMORY;
 
-    memcpy(path, args->data, args->len);
-    path[args->len] = '\0';
-
     // Check if path is safe
     if (!is_path_safe(file_read_data, path)) {
         free(path);
@@ -259,12 +306,40 @@ static err_t file_read_execute(tool_t* tool, const str_t* args, tool_result_t* o
     }
 
     // Read file
-    err_t result = read_file_contents(path, file_read_data->max_file_size, out_result);
+    err_t result = tool->context.sandbox
+        ? read_in_sandbox(tool->context.sandbox, path, file_read_data->max_file_size, out_result)
+        : read_file_contents(path, file_read_data->max_file_size, out_result);
 
     free(path);
     return result;
 }
 
+// Identity and change times of the file; a write that keeps the size and
+// lands within the same mtime tick still moves ctime
+static bool file_read_cache_validator(tool_t* tool, const str_t* args, uint64_t* out_validator) {
+    if (!tool || !args || !out_validator) return false;
+
+    char* path = path_from_args(args);
+    if (!path) return false;
+
+    struct stat st;
+    bool ok = stat(path, &st) == 0 && S_ISREG(st.st_mode);
+    free(path);
+    if (!ok) return false;
+
+    uint64_t fields[] = {
+        (uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size,
+        (uint64_t)stat_mtime_spec(&st).tv_sec, (uint64_t)stat_mtime_spec(&st).tv_nsec,
+        (uint64_t)stat_ctime_spec(&st).tv_sec, (uint64_t)stat_ctime_spec(&st).tv_nsec,
+    };
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        hash = (hash ^ fields[i]) * 1099511628211ULL;
+    }
+    *out_validator = hash;
+    return true;
+}
+
 static str_t file_read_get_parameters_schema(void) {
     // JSON schema for file_read tool parameters
     const char* schema = "{"
@@ -288,4 +363,8 @@ static bool file_read_requires_memory(void) {
 static bool file_read_allowed_in_autonomous(autonomy_level_t level) {
     // Allow in supervised or full autonomy modes
     return level >= AUTONOMY_LEVEL_SUPERVISED;
+}
+
+static bool file_read_is_read_only(void) {
+    return true;
 }
\ No newline at end of file
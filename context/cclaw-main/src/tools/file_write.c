@@ -3,6 +3,7 @@
 
 #include "core/tool.h"
 #include "core/config.h"
+#include "core/sandbox.h"
 #include "json_config.h"
 #include <stdlib.h>
 #include <string.h>
@@ -106,7 +107,8 @@ static void file_write_destroy(tool_t* tool) {
     free(file_write_data);
     tool->impl_data = NULL;
 
-    tool_free(tool);
+    // tool_free() would call back into this function
+    free(tool);
 }
 
 static err_t file_write_init(tool_t* tool, const tool_context_t* context) {
@@ -254,6 +256,25 @@ static err_t write_file_atomically(const char* path, const char* content, size_t
     return ERR_OK;
 }
 
+// The sandboxed write reports the same errors as write_file_atomically()
+static err_t write_in_sandbox(sandbox_t* sandbox, const char* path, const char* content,
+                              size_t content_len, bool allow_overwrite, tool_result_t* out_result) {
+    err_t err = sandbox_write_file(sandbox, path, content, content_len, allow_overwrite);
+
+    if (err == ERR_OK) {
+        str_t success_msg = STR_LIT("File written successfully");
+        tool_result_set_success(out_result, &success_msg);
+        return ERR_OK;
+    }
+
+    str_t error = err == ERR_FILE_EXISTS ? STR_LIT("File already exists and overwrite not allowed")
+                : err == ERR_WRITE_FAILED ? STR_LIT("Failed to write entire content")
+                : err == ERR_READ_ONLY ? STR_LIT("Path is read-only in the sandbox")
+                : STR_LIT("Failed to write file in sandbox");
+    tool_result_set_error(out_result, &error);
+    return err;
+}
+
 static err_t file_write_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
     if (!tool || !tool->impl_data || !tool->initialized || !args || !out_result) {
         return ERR_INVALID_ARGUMENT;
@@ -354,8 +375,11 @@ static err_t file_write_execute(tool_t* tool, const str_t* args, tool_result_t*
     }
 
     // Write file
-    err_t result = write_file_atomically(path, content, content_len,
-                                         file_write_data->allow_overwrite, out_result);
+    err_t result = tool->context.sandbox
+        ? write_in_sandbox(tool->context.sandbox, path, content, content_len,
+                           file_write_data->allow_overwrite, out_result)
+        : write_file_atomically(path, content, content_len,
+                                file_write_data->allow_overwrite, out_result);
 
     free(path);
     free(content);
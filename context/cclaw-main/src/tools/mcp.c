@@ -0,0 +1,1381 @@
+// mcp.c - Model Context Protocol client and tool bridge for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/mcp.h"
+#include "core/str_builder.h"
+#include "utils/clock.h"
+#include "json_config.h"
+#include "cclaw.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define MCP_READ_CHUNK 4096
+#define MCP_MAX_ARGV 64
+#define MCP_MAX_ENV 64
+#define MCP_STOP_GRACE_MS 500
+#define MCP_TOOL_NAME_MAX 64
+
+extern char** environ;
+
+// Environment passed through to servers; anything else must be configured
+static const char* const g_inherited_env[] = {
+    "PATH", "HOME", "TERM", "LANG", "LC_ALL", "LC_CTYPE",
+    "USER", "SHELL", "TMPDIR", "NODE_PATH", "NPM_CONFIG_PREFIX",
+};
+
+// A caller blocked on one response. Lives on the caller's stack and is
+// linked into the client's pending list while the request is in flight.
+typedef struct mcp_pending_t {
+    uint64_t id;
+    json_value_t* response;         // Whole response message, handed over by the reader
+    bool done;
+    pthread_cond_t cond;
+    struct mcp_pending_t* next;
+} mcp_pending_t;
+
+struct mcp_client_t {
+    char* name;
+    uint32_t refs;                  // The owner's, plus one per tool call in flight
+    pid_t pid;
+    int to_server;                  // Server stdin
+    int from_server;                // Server stdout
+    int stop_fds[2];                // Wakes the reader on shutdown
+    uint32_t timeout_ms;
+
+    pthread_t reader;
+    bool reader_started;
+
+    pthread_mutex_t lock;           // Guards everything below
+    pthread_mutex_t write_lock;     // One message on the pipe at a time
+    uint64_t next_id;
+    mcp_pending_t* pending;
+    bool dead;
+
+    // tools/list cache; stale once generation moves past cached_generation
+    mcp_tool_def_t* tools;
+    uint32_t tool_count;
+    bool tools_cached;
+    uint64_t generation;
+    uint64_t cached_generation;
+
+    // Bridged tools were registered from the list at registered_generation
+    bool bridged;
+    uint64_t registered_generation;
+};
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static char* mcp_strndup(const char* s, size_t len) {
+    char* copy = malloc(len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+static str_t mcp_str_dup(const char* s) {
+    if (!s) s = "";
+    size_t len = strlen(s);
+    char* copy = mcp_strndup(s, len);
+    return copy ? (str_t){ .data = copy, .len = (uint32_t)len } : STR_NULL;
+}
+
+// Close-on-exec from the start, so a fork() elsewhere in the process
+// cannot inherit the ends. macOS has no pipe2().
+static int pipe_cloexec(int fds[2]) {
+#if defined(__APPLE__)
+    if (pipe(fds) != 0) return -1;
+    for (int i = 0; i < 2; i++) {
+        int flags = fcntl(fds[i], F_GETFD);
+        if (flags >= 0) fcntl(fds[i], F_SETFD, flags | FD_CLOEXEC);
+    }
+    return 0;
+#else
+    return pipe2(fds, O_CLOEXEC);
+#endif
+}
+
+// A server that dies mid-write must not take the process with it, but the
+// host's SIGPIPE disposition is not ours to change. macOS can turn SIGPIPE
+// off per descriptor; elsewhere it is blocked around the write and, when
+// the write raised it, consumed before the mask is restored.
+static void set_nosigpipe(int fd) {
+#if defined(F_SETNOSIGPIPE)
+    fcntl(fd, F_SETNOSIGPIPE, 1);
+#else
+    (void)fd;
+#endif
+}
+
+static bool write_all(int fd, const char* data, size_t len) {
+#if !defined(F_SETNOSIGPIPE)
+    sigset_t pipe_set, old_set, pending;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+    // One already pending for the thread is not ours to consume
+    sigpending(&pending);
+    bool was_pending = sigismember(&pending, SIGPIPE);
+#endif
+
+    bool ok = true;
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+
+#if !defined(F_SETNOSIGPIPE)
+    if (!ok && errno == EPIPE && !was_pending) {
+        struct timespec zero = { 0, 0 };
+        while (sigtimedwait(&pipe_set, NULL, &zero) < 0 && errno == EINTR) {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+#endif
+    return ok;
+}
+
+static void close_fd(int* fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+// Append a JSON-RPC id exactly as the server sent it. json_print() would
+// render large numeric ids with %g.
+static void append_id(str_builder_t* sb, json_value_t* id) {
+    if (id && id->type == JSON_STRING) {
+        str_builder_append_char(sb, '"');
+        str_builder_append_json_escaped(sb, STR_VIEW(id->string));
+        str_builder_append_char(sb, '"');
+    } else if (id && id->type == JSON_NUMBER) {
+        str_builder_append_int(sb, (int64_t)id->number);
+    } else {
+        str_builder_append_cstr(sb, "null");
+    }
+}
+
+static bool send_message(mcp_client_t* client, str_builder_t* sb) {
+    str_builder_append_char(sb, '\n');
+    if (sb->failed) return false;
+
+    pthread_mutex_lock(&client->write_lock);
+    bool ok = write_all(client->to_server, sb->data, sb->len);
+    pthread_mutex_unlock(&client->write_lock);
+    return ok;
+}
+
+// ============================================================================
+// Reader thread
+// ============================================================================
+
+// Answer a request initiated by the server. Only ping is supported.
+static void reply_to_server(mcp_client_t* client, json_value_t* id, const char* method) {
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    str_builder_append_cstr(&sb, "{\"jsonrpc\":\"2.0\",\"id\":");
+    append_id(&sb, id);
+    if (strcmp(method, "ping") == 0) {
+        str_builder_append_cstr(&sb, ",\"result\":{}}");
+    } else {
+        str_builder_append_cstr(&sb, ",\"error\":{\"code\":-32601,\"message\":\"Method not found\"}}");
+    }
+    send_message(client, &sb);
+    str_builder_free(&sb);
+}
+
+static void dispatch_line(mcp_client_t* client, char* line) {
+    json_value_t* msg = json_parse(line);
+    json_object_t* obj = json_as_object(msg);
+    if (!obj) {
+        json_free(msg);
+        return;
+    }
+
+    json_value_t* id = json_object_get(obj, "id");
+    const char* method = json_object_get_string(obj, "method", NULL);
+
+    if (method) {
+        if (id) {
+            reply_to_server(client, id, method);
+        } else if (strcmp(method, "notifications/tools/list_changed") == 0) {
+            pthread_mutex_lock(&client->lock);
+            client->generation++;
+            pthread_mutex_unlock(&client->lock);
+        }
+        json_free(msg);
+        return;
+    }
+
+    if (!json_is_number(id)) {
+        json_free(msg);
+        return;
+    }
+
+    uint64_t response_id = (uint64_t)id->number;
+    pthread_mutex_lock(&client->lock);
+    for (mcp_pending_t* p = client->pending; p; p = p->next) {
+        if (p->id == response_id && !p->done) {
+            p->response = msg;
+            p->done = true;
+            pthread_cond_signal(&p->cond);
+            msg = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    // Late response to a request that already timed out
+    json_free(msg);
+}
+
+static void* reader_thread(void* arg) {
+    mcp_client_t* client = (mcp_client_t*)arg;
+
+    char* buf = NULL;
+    size_t len = 0;
+    size_t cap = 0;
+
+    for (;;) {
+        struct pollfd fds[2] = {
+            { .fd = client->stop_fds[0], .events = POLLIN },
+            { .fd = client->from_server, .events = POLLIN },
+        };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        if (cap - len < MCP_READ_CHUNK) {
+            size_t new_cap = cap ? cap * 2 : MCP_READ_CHUNK * 2;
+            while (new_cap - len < MCP_READ_CHUNK) new_cap *= 2;
+            char* grown = realloc(buf, new_cap);
+            if (!grown) break;
+            buf = grown;
+            cap = new_cap;
+        }
+
+        ssize_t n = read(client->from_server, buf + len, cap - len - 1);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            break;
+        }
+        if (n == 0) break;
+        len += (size_t)n;
+
+        // Dispatch every complete line, keep the tail
+        size_t start = 0;
+        for (size_t i = len - (size_t)n; i < len; i++) {
+            if (buf[i] != '\n') continue;
+            buf[i] = '\0';
+            if (i > start && buf[i - 1] == '\r') buf[i - 1] = '\0';
+            if (i > start) dispatch_line(client, buf + start);
+            start = i + 1;
+        }
+        if (start > 0) {
+            memmove(buf, buf + start, len - start);
+            len -= start;
+        }
+    }
+
+    free(buf);
+
+    // The server is gone (or we are stopping): fail everything in flight
+    pthread_mutex_lock(&client->lock);
+    client->dead = true;
+    for (mcp_pending_t* p = client->pending; p; p = p->next) {
+        pthread_cond_signal(&p->cond);
+    }
+    pthread_mutex_unlock(&client->lock);
+    return NULL;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+// Response waits are timed on the monotonic clock. macOS has no
+// pthread_condattr_setclock(), so it waits with a relative timeout instead.
+static void pending_cond_init(pthread_cond_t* cond) {
+#if defined(__APPLE__)
+    pthread_cond_init(cond, NULL);
+#else
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
+}
+
+// Wait on cond until clock_monotonic_ms() reaches deadline_ms
+static int wait_until(pthread_cond_t* cond, pthread_mutex_t* lock, uint64_t deadline_ms) {
+    uint64_t now = clock_monotonic_ms();
+    if (now >= deadline_ms) return ETIMEDOUT;
+    uint64_t left = deadline_ms - now;
+
+#if defined(__APPLE__)
+    struct timespec rel = { .tv_sec = (time_t)(left / 1000), .tv_nsec = (long)(left % 1000) * 1000000L };
+    return pthread_cond_timedwait_relative_np(cond, lock, &rel);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += (time_t)(left / 1000);
+    ts.tv_nsec += (long)(left % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(cond, lock, &ts);
+#endif
+}
+
+static void unlink_pending(mcp_client_t* client, mcp_pending_t* pending) {
+    for (mcp_pending_t** p = &client->pending; *p; p = &(*p)->next) {
+        if (*p == pending) {
+            *p = pending->next;
+            return;
+        }
+    }
+}
+
+// Send one request and wait for its response message. Other threads may
+// have requests outstanding on the same pipe at the same time.
+static err_t mcp_call(mcp_client_t* client, const char* method, str_t params, json_value_t** out_response) {
+    mcp_pending_t pending = { .response = NULL, .done = false, .next = NULL };
+    pending_cond_init(&pending.cond);
+
+    pthread_mutex_lock(&client->lock);
+    if (client->dead) {
+        pthread_mutex_unlock(&client->lock);
+        pthread_cond_destroy(&pending.cond);
+        return ERROR_SET(ERR_CONNECTION_FAILED, "mcp %s: server is not running", client->name);
+    }
+    pending.id = client->next_id++;
+    pending.next = client->pending;
+    client->pending = &pending;
+    pthread_mutex_unlock(&client->lock);
+
+    char stack[512];
+    str_builder_t sb;
+    str_builder_init_buffer(&sb, NULL, stack, sizeof(stack));
+    str_builder_append_cstr(&sb, "{\"jsonrpc\":\"2.0\",\"id\":");
+    str_builder_append_uint(&sb, pending.id);
+    str_builder_append_cstr(&sb, ",\"method\":\"");
+    str_builder_append_json_escaped(&sb, STR_VIEW(method));
+    str_builder_append_char(&sb, '"');
+    if (!str_empty(params)) {
+        str_builder_append_cstr(&sb, ",\"params\":");
+        str_builder_append(&sb, params);
+    }
+    str_builder_append_char(&sb, '}');
+    bool sent = send_message(client, &sb);
+    str_builder_free(&sb);
+
+    uint64_t deadline_ms = clock_monotonic_ms() + client->timeout_ms;
+
+    pthread_mutex_lock(&client->lock);
+    int wait_err = 0;
+    while (sent && !pending.done && !client->dead && wait_err != ETIMEDOUT) {
+        wait_err = wait_until(&pending.cond, &client->lock, deadline_ms);
+    }
+    unlink_pending(client, &pending);
+    bool done = pending.done;
+    pthread_mutex_unlock(&client->lock);
+    pthread_cond_destroy(&pending.cond);
+
+    if (done) {
+        *out_response = pending.response;
+        return ERR_OK;
+    }
+    if (!sent) return ERROR_SET(ERR_CONNECTION_FAILED, "mcp %s: cannot send %s", client->name, method);
+    if (wait_err == ETIMEDOUT) {
+        return ERROR_SET(ERR_TIMEOUT, "mcp %s: %s timed out after %u ms", client->name, method,
+                         client->timeout_ms);
+    }
+    return ERROR_SET(ERR_CONNECTION_FAILED, "mcp %s: server exited during %s", client->name, method);
+}
+
+// The "result" member of a response, or the JSON-RPC error as an err_t
+static err_t response_result(mcp_client_t* client, const char* method, json_value_t* response,
+                             json_value_t** out_result) {
+    json_object_t* obj = json_as_object(response);
+    json_object_t* error = obj ? json_object_get_object(obj, "error") : NULL;
+    if (error) {
+        return ERROR_SET(ERR_TOOL_EXECUTION_FAILED, "mcp %s: %s failed: %s (%d)", client->name, method,
+                         json_object_get_string(error, "message", "unknown error"),
+                         (int)json_object_get_number(error, "code", 0));
+    }
+
+    json_value_t* result = obj ? json_object_get(obj, "result") : NULL;
+    if (!result) {
+        return ERROR_SET(ERR_TOOL_EXECUTION_FAILED, "mcp %s: %s returned no result", client->name, method);
+    }
+
+    *out_result = result;
+    return ERR_OK;
+}
+
+static err_t send_notification(mcp_client_t* client, const char* method) {
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    str_builder_append_cstr(&sb, "{\"jsonrpc\":\"2.0\",\"method\":\"");
+    str_builder_append_json_escaped(&sb, STR_VIEW(method));
+    str_builder_append_cstr(&sb, "\"}");
+    bool sent = send_message(client, &sb);
+    str_builder_free(&sb);
+    return sent ? ERR_OK : ERR_WRITE_FAILED;
+}
+
+err_t mcp_client_request(mcp_client_t* client, const char* method, str_t params, str_t* out_result) {
+    if (!client || !method || !out_result) return ERR_INVALID_ARGUMENT;
+
+    json_value_t* response = NULL;
+    err_t err = mcp_call(client, method, params, &response);
+    if (err != ERR_OK) return err;
+
+    json_value_t* result = NULL;
+    err = response_result(client, method, response, &result);
+    if (err == ERR_OK) {
+        char* json = json_print(result, false);
+        if (json) {
+            *out_result = (str_t){ .data = json, .len = (uint32_t)strlen(json) };
+        } else {
+            err = ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    json_free(response);
+    return err;
+}
+
+// ============================================================================
+// Process lifecycle
+// ============================================================================
+
+static err_t spawn_server(mcp_client_t* client, const mcp_server_config_t* config) {
+    // Everything the child needs is built before fork()
+    char* argv[MCP_MAX_ARGV + 2];
+    char* envp[MCP_MAX_ENV + sizeof(g_inherited_env) / sizeof(g_inherited_env[0]) + 1];
+    uint32_t argc = 0;
+    uint32_t envc = 0;
+    err_t err = ERR_OK;
+
+    if (config->args_count > MCP_MAX_ARGV || config->env_count > MCP_MAX_ENV) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    argv[argc++] = mcp_strndup(config->command.data, config->command.len);
+    for (uint32_t i = 0; i < config->args_count; i++) {
+        argv[argc++] = mcp_strndup(config->args[i].data, config->args[i].len);
+    }
+    argv[argc] = NULL;
+
+    for (size_t i = 0; i < sizeof(g_inherited_env) / sizeof(g_inherited_env[0]); i++) {
+        const char* value = getenv(g_inherited_env[i]);
+        if (!value) continue;
+        size_t key_len = strlen(g_inherited_env[i]);
+        size_t value_len = strlen(value);
+        char* pair = malloc(key_len + value_len + 2);
+        if (!pair) continue;
+        memcpy(pair, g_inherited_env[i], key_len);
+        pair[key_len] = '=';
+        memcpy(pair + key_len + 1, value, value_len + 1);
+        envp[envc++] = pair;
+    }
+    for (uint32_t i = 0; i < config->env_count; i++) {
+        envp[envc++] = mcp_strndup(config->env[i].data, config->env[i].len);
+    }
+    envp[envc] = NULL;
+
+    for (uint32_t i = 0; i < argc; i++) {
+        if (!argv[i]) err = ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; i < envc; i++) {
+        if (!envp[i]) err = ERR_OUT_OF_MEMORY;
+    }
+
+    int in_pipe[2] = { -1, -1 };
+    int out_pipe[2] = { -1, -1 };
+    if (err == ERR_OK && (pipe_cloexec(in_pipe) != 0 || pipe_cloexec(out_pipe) != 0)) {
+        err = ERR_IO;
+    }
+
+    if (err == ERR_OK) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            // dup2() clears close-on-exec on the copies
+            dup2(in_pipe[0], STDIN_FILENO);
+            dup2(out_pipe[1], STDOUT_FILENO);
+            // Server diagnostics would interleave with the CLI
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull >= 0) dup2(devnull, STDERR_FILENO);
+            for (int fd = 3; fd < 256; fd++) close(fd);
+
+            environ = envp;
+            execvp(argv[0], argv);
+            _exit(127);
+        }
+
+        if (pid < 0) {
+            err = ERR_FAILED;
+        } else {
+            client->pid = pid;
+            client->to_server = in_pipe[1];
+            client->from_server = out_pipe[0];
+            in_pipe[1] = -1;
+            out_pipe[0] = -1;
+            set_nosigpipe(client->to_server);
+        }
+    }
+
+    close_fd(&in_pipe[0]);
+    close_fd(&in_pipe[1]);
+    close_fd(&out_pipe[0]);
+    close_fd(&out_pipe[1]);
+    for (uint32_t i = 0; i < argc; i++) free(argv[i]);
+    for (uint32_t i = 0; i < envc; i++) free(envp[i]);
+    return err;
+}
+
+// Wait up to timeout_ms for the server to exit by itself
+static bool reap_within(pid_t pid, uint32_t timeout_ms) {
+    for (uint32_t waited = 0;; waited += 10) {
+        pid_t r = waitpid(pid, NULL, WNOHANG);
+        if (r == pid || (r < 0 && errno != EINTR)) return true;
+        if (waited >= timeout_ms) return false;
+        usleep(10 * 1000);
+    }
+}
+
+static err_t handshake(mcp_client_t* client) {
+    char params[256];
+    snprintf(params, sizeof(params),
+             "{\"protocolVersion\":\"%s\",\"capabilities\":{},"
+             "\"clientInfo\":{\"name\":\"cclaw\",\"version\":\"%s\"}}",
+             MCP_PROTOCOL_VERSION, CCLAW_VERSION_STRING);
+
+    json_value_t* response = NULL;
+    err_t err = mcp_call(client, "initialize", STR_VIEW(params), &response);
+    if (err != ERR_OK) return err;
+
+    json_value_t* result = NULL;
+    err = response_result(client, "initialize", response, &result);
+    if (err == ERR_OK && !json_object_get_string(json_as_object(result), "protocolVersion", NULL)) {
+        err = ERROR_SET(ERR_TOOL, "mcp %s: invalid initialize response", client->name);
+    }
+    json_free(response);
+
+    if (err == ERR_OK) err = send_notification(client, "notifications/initialized");
+    return err;
+}
+
+err_t mcp_client_start(const mcp_server_config_t* config, mcp_client_t** out_client) {
+    if (!config || !out_client || str_empty(config->name) || str_empty(config->command)) {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    mcp_client_t* client = calloc(1, sizeof(mcp_client_t));
+    if (!client) return ERR_OUT_OF_MEMORY;
+
+    client->name = mcp_strndup(config->name.data, config->name.len);
+    client->pid = -1;
+    client->to_server = -1;
+    client->from_server = -1;
+    client->stop_fds[0] = client->stop_fds[1] = -1;
+    client->timeout_ms = config->timeout_ms ? config->timeout_ms : MCP_DEFAULT_TIMEOUT_MS;
+    client->next_id = 1;
+    client->refs = 1;
+    pthread_mutex_init(&client->lock, NULL);
+    pthread_mutex_init(&client->write_lock, NULL);
+
+    err_t err = client->name ? ERR_OK : ERR_OUT_OF_MEMORY;
+    if (err == ERR_OK && pipe_cloexec(client->stop_fds) != 0) err = ERR_IO;
+    if (err == ERR_OK) err = spawn_server(client, config);
+    if (err == ERR_OK) {
+        if (pthread_create(&client->reader, NULL, reader_thread, client) == 0) {
+            client->reader_started = true;
+        } else {
+            err = ERR_FAILED;
+        }
+    }
+    if (err == ERR_OK) err = handshake(client);
+
+    if (err != ERR_OK) {
+        mcp_client_stop(client);
+        return err;
+    }
+
+    *out_client = client;
+    return ERR_OK;
+}
+
+static void unregister_client_tools(mcp_client_t* client);
+
+static void client_retain(mcp_client_t* client) {
+    __atomic_add_fetch(&client->refs, 1, __ATOMIC_RELAXED);
+}
+
+// The last release frees the client; stop has already shut it down
+static void client_release(mcp_client_t* client) {
+    if (__atomic_sub_fetch(&client->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+
+    mcp_tool_defs_free(client->tools, client->tool_count);
+    pthread_mutex_destroy(&client->lock);
+    pthread_mutex_destroy(&client->write_lock);
+    free(client->name);
+    free(client);
+}
+
+// Tool calls still in flight keep the client alive: they fail once the
+// server is gone, and the last of them frees it.
+void mcp_client_stop(mcp_client_t* client) {
+    if (!client) return;
+
+    unregister_client_tools(client);
+
+    // Closing stdin is the protocol's shutdown signal; escalate if ignored.
+    // Under write_lock, so a concurrent send cannot write to a reused fd.
+    pthread_mutex_lock(&client->write_lock);
+    close_fd(&client->to_server);
+    pthread_mutex_unlock(&client->write_lock);
+    if (client->pid > 0 && !reap_within(client->pid, MCP_STOP_GRACE_MS)) {
+        kill(client->pid, SIGTERM);
+        if (!reap_within(client->pid, MCP_STOP_GRACE_MS)) {
+            kill(client->pid, SIGKILL);
+            waitpid(client->pid, NULL, 0);
+        }
+    }
+
+    if (client->reader_started) {
+        if (write(client->stop_fds[1], "x", 1) < 0) {
+            // The reader also exits on EOF from the server
+        }
+        pthread_join(client->reader, NULL);
+    }
+
+    close_fd(&client->from_server);
+    close_fd(&client->stop_fds[0]);
+    close_fd(&client->stop_fds[1]);
+
+    // Nothing is left to wake a caller that has not seen the reader exit
+    pthread_mutex_lock(&client->lock);
+    client->dead = true;
+    pthread_mutex_unlock(&client->lock);
+
+    client_release(client);
+}
+
+str_t mcp_client_name(const mcp_client_t* client) {
+    return client ? STR_VIEW(client->name) : STR_NULL;
+}
+
+bool mcp_client_is_alive(mcp_client_t* client) {
+    if (!client) return false;
+    pthread_mutex_lock(&client->lock);
+    bool alive = !client->dead;
+    pthread_mutex_unlock(&client->lock);
+    return alive;
+}
+
+// ============================================================================
+// Tools
+// ============================================================================
+
+void mcp_tool_defs_free(mcp_tool_def_t* tools, uint32_t count) {
+    if (!tools) return;
+    for (uint32_t i = 0; i < count; i++) {
+        free((void*)tools[i].name.data);
+        free((void*)tools[i].description.data);
+        free((void*)tools[i].input_schema.data);
+    }
+    free(tools);
+}
+
+static err_t tool_defs_copy(const mcp_tool_def_t* tools, uint32_t count, mcp_tool_def_t** out_tools) {
+    mcp_tool_def_t* copy = calloc(count ? count : 1, sizeof(mcp_tool_def_t));
+    if (!copy) return ERR_OUT_OF_MEMORY;
+
+    for (uint32_t i = 0; i < count; i++) {
+        copy[i].name = mcp_str_dup(tools[i].name.data);
+        copy[i].description = mcp_str_dup(tools[i].description.data);
+        copy[i].input_schema = mcp_str_dup(tools[i].input_schema.data);
+        if (!copy[i].name.data || !copy[i].description.data || !copy[i].input_schema.data) {
+            mcp_tool_defs_free(copy, i + 1);
+            return ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    *out_tools = copy;
+    return ERR_OK;
+}
+
+// Append the tools of one tools/list page; returns the next cursor, if any
+static err_t parse_tools_page(json_value_t* result, mcp_tool_def_t** tools, uint32_t* count,
+                              char** out_cursor) {
+    json_object_t* obj = json_as_object(result);
+    json_array_t* list = obj ? json_object_get_array(obj, "tools") : NULL;
+
+    size_t page = json_array_length(list);
+    if (page > 0) {
+        mcp_tool_def_t* grown = realloc(*tools, sizeof(mcp_tool_def_t) * (*count + page));
+        if (!grown) return ERR_OUT_OF_MEMORY;
+        *tools = grown;
+    }
+
+    for (size_t i = 0; i < page; i++) {
+        json_object_t* tool = json_as_object(json_array_get(list, i));
+        const char* name = tool ? json_object_get_string(tool, "name", NULL) : NULL;
+        if (!name) continue;
+
+        json_value_t* schema = json_object_get(tool, "inputSchema");
+        char* schema_json = schema ? json_print(schema, false) : NULL;
+
+        mcp_tool_def_t* def = &(*tools)[*count];
+        def->name = mcp_str_dup(name);
+        def->description = mcp_str_dup(json_object_get_string(tool, "description", ""));
+        def->input_schema = schema_json ? (str_t){ .data = schema_json, .len = (uint32_t)strlen(schema_json) }
+                                        : mcp_str_dup("{\"type\":\"object\"}");
+        (*count)++;
+        if (!def->name.data || !def->description.data || !def->input_schema.data) {
+            return ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    const char* cursor = obj ? json_object_get_string(obj, "nextCursor", NULL) : NULL;
+    *out_cursor = cursor && *cursor ? strdup(cursor) : NULL;
+    return ERR_OK;
+}
+
+static err_t fetch_tools(mcp_client_t* client, mcp_tool_def_t** out_tools, uint32_t* out_count) {
+    mcp_tool_def_t* tools = NULL;
+    uint32_t count = 0;
+    char* cursor = NULL;
+    err_t err = ERR_OK;
+
+    do {
+        str_builder_t params;
+        str_builder_init(&params, NULL);
+        str_builder_append_char(&params, '{');
+        if (cursor) {
+            str_builder_append_cstr(&params, "\"cursor\":\"");
+            str_builder_append_json_escaped(&params, STR_VIEW(cursor));
+            str_builder_append_char(&params, '"');
+        }
+        str_builder_append_char(&params, '}');
+        free(cursor);
+        cursor = NULL;
+
+        json_value_t* response = NULL;
+        err = mcp_call(client, "tools/list", str_builder_view(&params), &response);
+        str_builder_free(&params);
+        if (err != ERR_OK) break;
+
+        json_value_t* result = NULL;
+        err = response_result(client, "tools/list", response, &result);
+        if (err == ERR_OK) err = parse_tools_page(result, &tools, &count, &cursor);
+        json_free(response);
+    } while (err == ERR_OK && cursor);
+
+    free(cursor);
+    if (err != ERR_OK) {
+        mcp_tool_defs_free(tools, count);
+        return err;
+    }
+
+    *out_tools = tools;
+    *out_count = count;
+    return ERR_OK;
+}
+
+err_t mcp_client_list_tools(mcp_client_t* client, mcp_tool_def_t** out_tools, uint32_t* out_count) {
+    if (!client || !out_tools || !out_count) return ERR_INVALID_ARGUMENT;
+
+    pthread_mutex_lock(&client->lock);
+    if (client->tools_cached && client->cached_generation == client->generation) {
+        err_t err = tool_defs_copy(client->tools, client->tool_count, out_tools);
+        if (err == ERR_OK) *out_count = client->tool_count;
+        pthread_mutex_unlock(&client->lock);
+        return err;
+    }
+    uint64_t generation = client->generation;
+    pthread_mutex_unlock(&client->lock);
+
+    mcp_tool_def_t* tools = NULL;
+    uint32_t count = 0;
+    err_t err = fetch_tools(client, &tools, &count);
+    if (err != ERR_OK) return err;
+
+    err = tool_defs_copy(tools, count, out_tools);
+    if (err == ERR_OK) *out_count = count;
+
+    // Keep the fresh list unless a change notification overtook it
+    pthread_mutex_lock(&client->lock);
+    if (client->generation == generation) {
+        mcp_tool_defs_free(client->tools, client->tool_count);
+        client->tools = tools;
+        client->tool_count = count;
+        client->tools_cached = true;
+        client->cached_generation = generation;
+        tools = NULL;
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    mcp_tool_defs_free(tools, count);
+    return err;
+}
+
+// Arguments are re-serialized, compact, so they cannot carry a raw newline
+// into the NDJSON stream. Anything but a JSON object is rejected.
+static err_t serialize_arguments(str_t args_json, char** out_json) {
+    if (str_empty(args_json)) {
+        *out_json = strdup("{}");
+        return *out_json ? ERR_OK : ERR_OUT_OF_MEMORY;
+    }
+
+    char* text = mcp_strndup(args_json.data, args_json.len);
+    if (!text) return ERR_OUT_OF_MEMORY;
+    json_value_t* args = json_parse(text);
+    free(text);
+    if (!json_is_object(args)) {
+        json_free(args);
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    *out_json = json_print(args, false);
+    json_free(args);
+    return *out_json ? ERR_OK : ERR_OUT_OF_MEMORY;
+}
+
+err_t mcp_client_call_tool(mcp_client_t* client, str_t name, str_t args_json, tool_result_t* out_result) {
+    if (!client || str_empty(name) || !out_result) return ERR_INVALID_ARGUMENT;
+
+    char* arguments = NULL;
+    err_t err = serialize_arguments(args_json, &arguments);
+    if (err == ERR_INVALID_ARGUMENT) {
+        str_t message = STR_LIT("Tool arguments must be a JSON object");
+        tool_result_set_error(out_result, &message);
+        return ERROR_SET(err, "mcp %s: invalid arguments for %.*s", client->name, (int)name.len, name.data);
+    }
+    if (err != ERR_OK) return err;
+
+    str_builder_t params;
+    str_builder_init(&params, NULL);
+    str_builder_append_cstr(&params, "{\"name\":\"");
+    str_builder_append_json_escaped(&params, name);
+    str_builder_append_cstr(&params, "\",\"arguments\":");
+    str_builder_append_cstr(&params, arguments);
+    str_builder_append_char(&params, '}');
+    free(arguments);
+    if (params.failed) {
+        str_builder_free(&params);
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    json_value_t* response = NULL;
+    err = mcp_call(client, "tools/call", str_builder_view(&params), &response);
+    str_builder_free(&params);
+    if (err != ERR_OK) {
+        str_t message = error_message(error_last());
+        tool_result_set_error(out_result, &message);
+        return err;
+    }
+
+    json_value_t* result = NULL;
+    err = response_result(client, "tools/call", response, &result);
+    if (err != ERR_OK) {
+        str_t message = error_message(error_last());
+        tool_result_set_error(out_result, &message);
+        json_free(response);
+        return err;
+    }
+
+    // Join text content; other content types are noted but not inlined
+    json_object_t* obj = json_as_object(result);
+    json_array_t* content = obj ? json_object_get_array(obj, "content") : NULL;
+    str_builder_t text;
+    str_builder_init(&text, NULL);
+    size_t items = json_array_length(content);
+    for (size_t i = 0; i < items; i++) {
+        json_object_t* item = json_as_object(json_array_get(content, i));
+        if (!item) continue;
+        if (text.len > 0) str_builder_append_char(&text, '\n');
+
+        const char* type = json_object_get_string(item, "type", "text");
+        const char* value = json_object_get_string(item, "text", NULL);
+        if (value) {
+            str_builder_append_cstr(&text, value);
+        } else {
+            str_builder_appendf(&text, "[%s content]", type);
+        }
+    }
+
+    bool is_error = obj && json_object_get_bool(obj, "isError", false);
+    str_t output = str_builder_view(&text);
+    if (text.failed) {
+        err = ERR_OUT_OF_MEMORY;
+    } else if (is_error) {
+        tool_result_set_error(out_result, &output);
+    } else {
+        tool_result_set_success(out_result, &output);
+    }
+
+    str_builder_free(&text);
+    json_free(response);
+    return err;
+}
+
+// ============================================================================
+// Tool bridge
+// ============================================================================
+
+// tool_vtable_t callbacks such as get_name() take no arguments, so each
+// bridged tool needs its own functions. They are generated for a fixed
+// pool of slots; a slot is bound to one remote tool while registered.
+
+typedef struct mcp_tool_slot_t {
+    bool used;
+    uint64_t serial;                // Distinguishes successive bindings of the slot
+    mcp_client_t* client;
+    str_t remote_name;
+    str_t name;                     // Registered as mcp_<server>_<tool>
+    str_t description;
+    str_t schema;
+    tool_vtable_t vtable;
+} mcp_tool_slot_t;
+
+// A tool instance remembers which binding of its slot it was created for,
+// so it does not call a different tool after the slot is reused
+typedef struct mcp_tool_instance_t {
+    uint32_t index;
+    uint64_t serial;
+} mcp_tool_instance_t;
+
+static mcp_tool_slot_t g_slots[MCP_MAX_TOOL_SLOTS];
+static uint64_t g_next_serial = 1;
+static pthread_mutex_t g_slots_lock = PTHREAD_MUTEX_INITIALIZER;  // Guards g_slots, g_retired
+
+// Names, descriptions and schemas a slot let go of. Callers of get_name()
+// and friends keep the returned str_t without owning it, possibly across
+// a refresh on another thread, so these are only freed by mcp_stop_all().
+static struct {
+    str_t* strings;
+    uint32_t count;
+    uint32_t capacity;
+} g_retired;
+
+// Leaked rather than freed if the list cannot grow
+static void retire_string_locked(str_t s) {
+    if (!s.data) return;
+    if (g_retired.count == g_retired.capacity) {
+        uint32_t capacity = g_retired.capacity ? g_retired.capacity * 2 : 16;
+        str_t* strings = realloc(g_retired.strings, capacity * sizeof(str_t));
+        if (!strings) return;
+        g_retired.strings = strings;
+        g_retired.capacity = capacity;
+    }
+    g_retired.strings[g_retired.count++] = s;
+}
+
+static void retired_free_all(void) {
+    pthread_mutex_lock(&g_slots_lock);
+    for (uint32_t i = 0; i < g_retired.count; i++) free((void*)g_retired.strings[i].data);
+    free(g_retired.strings);
+    memset(&g_retired, 0, sizeof(g_retired));
+    pthread_mutex_unlock(&g_slots_lock);
+}
+
+// A refresh may be swapping the field on another thread
+static str_t slot_field(uint32_t index, size_t offset) {
+    pthread_mutex_lock(&g_slots_lock);
+    str_t value = *(const str_t*)((const char*)&g_slots[index] + offset);
+    pthread_mutex_unlock(&g_slots_lock);
+    return value;
+}
+
+static err_t slot_create(uint32_t index, tool_t** out_tool) {
+    if (!out_tool) return ERR_INVALID_ARGUMENT;
+
+    mcp_tool_instance_t* instance = malloc(sizeof(*instance));
+    if (!instance) return ERR_OUT_OF_MEMORY;
+
+    pthread_mutex_lock(&g_slots_lock);
+    err_t err = g_slots[index].used ? ERR_OK : ERR_NOT_FOUND;
+    tool_t* tool = err == ERR_OK ? tool_alloc(&g_slots[index].vtable) : NULL;
+    if (err == ERR_OK && !tool) err = ERR_OUT_OF_MEMORY;
+    if (tool) {
+        *instance = (mcp_tool_instance_t){ .index = index, .serial = g_slots[index].serial };
+        tool->impl_data = instance;
+        *out_tool = tool;
+    }
+    pthread_mutex_unlock(&g_slots_lock);
+
+    if (err != ERR_OK) free(instance);
+    return err;
+}
+
+#define MCP_SLOT_FUNCTIONS(n) \
+    static str_t mcp_slot_name_##n(void) { \
+        return slot_field(n, offsetof(mcp_tool_slot_t, name)); \
+    } \
+    static str_t mcp_slot_description_##n(void) { \
+        return slot_field(n, offsetof(mcp_tool_slot_t, description)); \
+    } \
+    static str_t mcp_slot_schema_##n(void) { \
+        return slot_field(n, offsetof(mcp_tool_slot_t, schema)); \
+    } \
+    static err_t mcp_slot_create_##n(tool_t** out_tool) { return slot_create(n, out_tool); }
+
+#define MCP_FOR_EACH_SLOT(X) \
+    X(0)  X(1)  X(2)  X(3)  X(4)  X(5)  X(6)  X(7) \
+    X(8)  X(9)  X(10) X(11) X(12) X(13) X(14) X(15) \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) \
+    X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)
+
+MCP_FOR_EACH_SLOT(MCP_SLOT_FUNCTIONS)
+
+typedef struct {
+    str_t (*get_name)(void);
+    str_t (*get_description)(void);
+    str_t (*get_parameters_schema)(void);
+    err_t (*create)(tool_t** out_tool);
+} mcp_slot_functions_t;
+
+#define MCP_SLOT_ENTRY(n) \
+    { mcp_slot_name_##n, mcp_slot_description_##n, mcp_slot_schema_##n, mcp_slot_create_##n },
+
+static const mcp_slot_functions_t g_slot_functions[MCP_MAX_TOOL_SLOTS] = {
+    MCP_FOR_EACH_SLOT(MCP_SLOT_ENTRY)
+};
+
+// Shared by every bridged tool; per-tool state comes from tool->impl_data
+static str_t mcp_tool_get_version(void) {
+    return STR_LIT("1.0.0");
+}
+
+static void mcp_tool_destroy(tool_t* tool) {
+    if (!tool) return;
+    free(tool->impl_data);
+    free(tool);
+}
+
+static err_t mcp_tool_init(tool_t* tool, const tool_context_t* context) {
+    if (!tool) return ERR_INVALID_ARGUMENT;
+    if (context) tool->context = *context;
+    tool->initialized = true;
+    return ERR_OK;
+}
+
+static void mcp_tool_cleanup(tool_t* tool) {
+    if (tool) tool->initialized = false;
+}
+
+static err_t mcp_tool_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    if (!tool || !tool->impl_data || !out_result) return ERR_INVALID_ARGUMENT;
+
+    // Take what the call needs under the lock; the reference keeps the
+    // client alive if it is stopped while the call is in flight
+    const mcp_tool_instance_t* instance = (const mcp_tool_instance_t*)tool->impl_data;
+    mcp_client_t* client = NULL;
+    str_t remote_name = STR_NULL;
+    pthread_mutex_lock(&g_slots_lock);
+    mcp_tool_slot_t* slot = &g_slots[instance->index];
+    bool bound = slot->used && slot->serial == instance->serial;
+    if (bound) {
+        remote_name = mcp_str_dup(slot->remote_name.data);
+        if (remote_name.data) {
+            client = slot->client;
+            client_retain(client);
+        }
+    }
+    pthread_mutex_unlock(&g_slots_lock);
+
+    if (!bound) {
+        str_t error = STR_LIT("MCP tool is no longer available");
+        tool_result_set_error(out_result, &error);
+        return ERR_NOT_FOUND;
+    }
+    if (!client) return ERR_OUT_OF_MEMORY;
+
+    err_t err = mcp_client_call_tool(client, remote_name, args ? *args : STR_NULL, out_result);
+    free((void*)remote_name.data);
+    client_release(client);
+    return err;
+}
+
+static bool mcp_tool_requires_memory(void) {
+    return false;
+}
+
+static bool mcp_tool_allowed_in_autonomous(autonomy_level_t level) {
+    // Remote tools can do anything the server can
+    return level >= AUTONOMY_LEVEL_SUPERVISED;
+}
+
+// mcp_<server>_<tool>, limited to the characters and length providers
+// accept for function names
+static str_t bridged_name(const char* server, const char* tool) {
+    char name[MCP_TOOL_NAME_MAX + 1];
+    int n = snprintf(name, sizeof(name), "mcp_%s_%s", server, tool);
+    if (n < 0) return STR_NULL;
+
+    for (char* c = name; *c; c++) {
+        bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+                  (*c >= '0' && *c <= '9') || *c == '_' || *c == '-';
+        if (!ok) *c = '_';
+    }
+    return mcp_str_dup(name);
+}
+
+// The vtable stays: instances created from the slot still point at it and
+// must be able to report themselves unavailable and be destroyed. The
+// strings its accessors hand out are retired, not freed.
+static void slot_release(mcp_tool_slot_t* slot) {
+    free((void*)slot->remote_name.data);
+    retire_string_locked(slot->name);
+    retire_string_locked(slot->description);
+    retire_string_locked(slot->schema);
+    tool_vtable_t vtable = slot->vtable;
+    memset(slot, 0, sizeof(*slot));
+    slot->vtable = vtable;
+}
+
+static bool name_registered(str_t name) {
+    const char** names = NULL;
+    uint32_t count = 0;
+    if (tool_registry_list(&names, &count) != ERR_OK) return false;
+    for (uint32_t i = 0; i < count; i++) {
+        if (str_equal_cstr(name, names[i])) return true;
+    }
+    return false;
+}
+
+// Bind each tool whose name is not registered yet to a free slot and
+// register it. Takes over the strings of the tools it binds.
+static err_t register_tools_locked(mcp_client_t* client, mcp_tool_def_t* tools, uint32_t count,
+                                   uint32_t* out_registered) {
+    err_t err = ERR_OK;
+    uint32_t registered = 0;
+    for (uint32_t i = 0; i < count && err == ERR_OK; i++) {
+        str_t name = bridged_name(client->name, tools[i].name.data);
+        if (str_empty(name) || name_registered(name)) {
+            free((void*)name.data);
+            continue;
+        }
+
+        uint32_t index = 0;
+        while (index < MCP_MAX_TOOL_SLOTS && g_slots[index].used) index++;
+        if (index == MCP_MAX_TOOL_SLOTS) {
+            free((void*)name.data);
+            err = ERROR_SET(ERR_OUT_OF_MEMORY, "mcp %s: all %d tool slots in use", client->name,
+                            MCP_MAX_TOOL_SLOTS);
+            break;
+        }
+
+        mcp_tool_slot_t* slot = &g_slots[index];
+        const mcp_slot_functions_t* fns = &g_slot_functions[index];
+        slot->used = true;
+        slot->serial = g_next_serial++;
+        slot->client = client;
+        slot->name = name;
+        slot->remote_name = tools[i].name;
+        slot->description = tools[i].description;
+        slot->schema = tools[i].input_schema;
+        tools[i].name = tools[i].description = tools[i].input_schema = STR_NULL;
+        slot->vtable = (tool_vtable_t){
+            .get_name = fns->get_name,
+            .get_description = fns->get_description,
+            .get_version = mcp_tool_get_version,
+            .create = fns->create,
+            .destroy = mcp_tool_destroy,
+            .init = mcp_tool_init,
+            .cleanup = mcp_tool_cleanup,
+            .execute = mcp_tool_execute,
+            .get_parameters_schema = fns->get_parameters_schema,
+            .requires_memory = mcp_tool_requires_memory,
+            .allowed_in_autonomous = mcp_tool_allowed_in_autonomous
+        };
+
+        err = tool_register(slot->name.data, &slot->vtable);
+        if (err != ERR_OK) {
+            slot_release(slot);
+        } else {
+            registered++;
+        }
+    }
+
+    *out_registered = registered;
+    return err;
+}
+
+static void unregister_client_tools_locked(mcp_client_t* client) {
+    for (uint32_t i = 0; i < MCP_MAX_TOOL_SLOTS; i++) {
+        if (g_slots[i].used && g_slots[i].client == client) {
+            tool_unregister(g_slots[i].name.data);
+            slot_release(&g_slots[i]);
+        }
+    }
+}
+
+// Drop the client's tools that are not in tools. Those that are keep their
+// slot, and so their instances, with description and schema updated; the
+// replaced strings are retired.
+static void retire_client_tools_locked(mcp_client_t* client, mcp_tool_def_t* tools, uint32_t count) {
+    for (uint32_t i = 0; i < MCP_MAX_TOOL_SLOTS; i++) {
+        mcp_tool_slot_t* slot = &g_slots[i];
+        if (!slot->used || slot->client != client) continue;
+
+        uint32_t j = 0;
+        while (j < count && !str_equal(tools[j].name, slot->remote_name)) j++;
+        if (j == count) {
+            tool_unregister(slot->name.data);
+            slot_release(slot);
+            continue;
+        }
+
+        retire_string_locked(slot->description);
+        retire_string_locked(slot->schema);
+        slot->description = tools[j].description;
+        slot->schema = tools[j].input_schema;
+        tools[j].description = tools[j].input_schema = STR_NULL;
+    }
+}
+
+// Register the client's current list; with replace, tools it no longer
+// lists are dropped first
+static err_t sync_client_tools(mcp_client_t* client, bool replace, uint32_t* out_registered) {
+    pthread_mutex_lock(&client->lock);
+    uint64_t generation = client->generation;
+    pthread_mutex_unlock(&client->lock);
+
+    mcp_tool_def_t* tools = NULL;
+    uint32_t count = 0;
+    err_t err = mcp_client_list_tools(client, &tools, &count);
+    if (err != ERR_OK) return err;
+
+    uint32_t registered = 0;
+    pthread_mutex_lock(&g_slots_lock);
+    if (replace) retire_client_tools_locked(client, tools, count);
+    err = register_tools_locked(client, tools, count, &registered);
+    pthread_mutex_unlock(&g_slots_lock);
+
+    pthread_mutex_lock(&client->lock);
+    client->bridged = true;
+    client->registered_generation = generation;
+    pthread_mutex_unlock(&client->lock);
+
+    mcp_tool_defs_free(tools, count);
+    if (out_registered) *out_registered = registered;
+    return err;
+}
+
+err_t mcp_client_register_tools(mcp_client_t* client, uint32_t* out_registered) {
+    if (!client) return ERR_INVALID_ARGUMENT;
+    if (out_registered) *out_registered = 0;
+    return sync_client_tools(client, false, out_registered);
+}
+
+err_t mcp_client_refresh_tools(mcp_client_t* client, bool* out_changed) {
+    if (!client) return ERR_INVALID_ARGUMENT;
+    if (out_changed) *out_changed = false;
+
+    pthread_mutex_lock(&client->lock);
+    bool stale = client->bridged && !client->dead && client->registered_generation != client->generation;
+    pthread_mutex_unlock(&client->lock);
+    if (!stale) return ERR_OK;
+
+    if (out_changed) *out_changed = true;
+    return sync_client_tools(client, true, NULL);
+}
+
+static void unregister_client_tools(mcp_client_t* client) {
+    pthread_mutex_lock(&g_slots_lock);
+    unregister_client_tools_locked(client);
+    pthread_mutex_unlock(&g_slots_lock);
+}
+
+// ============================================================================
+// Configured servers
+// ============================================================================
+
+static mcp_client_t* g_clients[MCP_MAX_SERVERS];
+static uint32_t g_client_count = 0;
+
+err_t mcp_start_configured(const config_t* config) {
+    if (!config) return ERR_INVALID_ARGUMENT;
+
+    for (uint32_t i = 0; i < config->mcp_servers_count && g_client_count < MCP_MAX_SERVERS; i++) {
+        mcp_server_config_t server = {
+            .name = config->mcp_servers[i].name,
+            .command = config->mcp_servers[i].command,
+            .args = config->mcp_servers[i].args,
+            .args_count = config->mcp_servers[i].args_count,
+            .env = config->mcp_servers[i].env,
+            .env_count = config->mcp_servers[i].env_count,
+            .timeout_ms = config->mcp_servers[i].timeout_ms
+        };
+
+        mcp_client_t* client = NULL;
+        err_t err = mcp_client_start(&server, &client);
+        if (err != ERR_OK) {
+            fprintf(stderr, "Warning: MCP server '%.*s' failed to start: %s\n",
+                    (int)server.name.len, server.name.data, error_to_string(err));
+            continue;
+        }
+
+        uint32_t registered = 0;
+        err = mcp_client_register_tools(client, &registered);
+        if (err != ERR_OK) {
+            fprintf(stderr, "Warning: MCP server '%.*s': %s\n",
+                    (int)server.name.len, server.name.data, error_to_string(err));
+        }
+        g_clients[g_client_count++] = client;
+    }
+
+    return ERR_OK;
+}
+
+bool mcp_refresh_tools(void) {
+    bool changed = false;
+    for (uint32_t i = 0; i < g_client_count; i++) {
+        bool client_changed = false;
+        err_t err = mcp_client_refresh_tools(g_clients[i], &client_changed);
+        if (err != ERR_OK) {
+            str_t name = mcp_client_name(g_clients[i]);
+            fprintf(stderr, "Warning: MCP server '%.*s': %s\n", (int)name.len, name.data, error_to_string(err));
+        }
+        changed |= client_changed;
+    }
+    return changed;
+}
+
+void mcp_stop_all(void) {
+    for (uint32_t i = 0; i < g_client_count; i++) {
+        mcp_client_stop(g_clients[i]);
+        g_clients[i] = NULL;
+    }
+    g_client_count = 0;
+    retired_free_all();
+}
@@ -99,7 +99,8 @@ static void memory_forget_destroy(tool_t* tool) {
     free(forget_data);
     tool->impl_data = NULL;
 
-    tool_free(tool);
+    // tool_free() would call back into this function
+    free(tool);
 }
 
 static err_t memory_forget_init(tool_t* tool, const tool_context_t* context) {
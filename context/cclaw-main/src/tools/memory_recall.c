@@ -3,11 +3,24 @@
 
 #include "core/tool.h"
 #include "core/memory.h"
+#include "core/str_builder.h"
 #include "json_config.h"
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 
+// Result formatting budget. Tokens are estimated at ~4 bytes each; the
+// rendered result stays within the budget except when the first entry
+// alone exceeds it.
+#define RECALL_DEFAULT_MAX_TOKENS 1024
+#define RECALL_MIN_MAX_TOKENS 64
+#define RECALL_BYTES_PER_TOKEN 4
+#define RECALL_ENTRY_MAX_CHARS 480      // per-entry content snippet cap
+#define RECALL_MAX_TERMS 8
+#define RECALL_HIGHLIGHT "**"
+
 // Memory recall tool instance data
 typedef struct memory_recall_tool_t {
     memory_t* memory;          // Memory system instance
@@ -26,6 +39,8 @@ static err_t memory_recall_execute(tool_t* tool, const str_t* args, tool_result_
 static str_t memory_recall_get_parameters_schema(void);
 static bool memory_recall_requires_memory(void);
 static bool memory_recall_allowed_in_autonomous(autonomy_level_t level);
+static bool memory_recall_is_read_only(void);
+static bool memory_recall_cache_validator(tool_t* tool, const str_t* args, uint64_t* out_validator);
 
 // VTable definition
 static const tool_vtable_t memory_recall_vtable = {
@@ -39,7 +54,9 @@ static const tool_vtable_t memory_recall_vtable = {
     .execute = memory_recall_execute,
     .get_parameters_schema = memory_recall_get_parameters_schema,
     .requires_memory = memory_recall_requires_memory,
-    .allowed_in_autonomous = memory_recall_allowed_in_autonomous
+    .allowed_in_autonomous = memory_recall_allowed_in_autonomous,
+    .is_read_only = memory_recall_is_read_only,
+    .cache_validator = memory_recall_cache_validator
 };
 
 // Get vtable
@@ -99,7 +116,8 @@ static void memory_recall_destroy(tool_t* tool) {
     free(recall_data);
     tool->impl_data = NULL;
 
-    tool_free(tool);
+    // tool_free() would call back into this function
+    free(tool);
 }
 
 static err_t memory_recall_init(tool_t* tool, const tool_context_t* context) {
@@ -159,6 +177,7 @@ static err_t parse_memory_recall_args(const char* args_json,
                                       str_t* out_query,
                                       str_t* out_key,
                                       uint32_t* out_limit,
+                                      uint32_t* out_max_tokens,
                                       memory_category_t* out_category) {
     if (!args_json || (!out_query && !out_key)) {
         return ERR_INVALID_ARGUMENT;
@@ -167,7 +186,7 @@ static err_t parse_memory_recall_args(const char* args_json,
     // TODO: Use proper JSON parsing with json_config.h
     // For now, implement simple JSON parsing
 
-    // Expected format: {"query": "...", "key": "...", "limit": 10, "category": "..."}
+    // Expected format: {"query": "...", "key": "...", "limit": 10, "max_tokens": 1024, "category": "..."}
     // Either query or key should be provided
 
     // Extract query (optional)
@@ -223,6 +242,19 @@ static err_t parse_memory_recall_args(const char* args_json,
         *out_limit = 10; // Default limit
     }
 
+    // Extract result token budget (optional)
+    char* max_tokens_start = strstr(args_json, "\"max_tokens\"");
+    if (max_tokens_start && out_max_tokens) {
+        char* max_tokens_val = max_tokens_start + 12;
+        while (*max_tokens_val && (*max_tokens_val == ' ' || *max_tokens_val == ':')) max_tokens_val++;
+        if (*max_tokens_val >= '0' && *max_tokens_val <= '9') {
+            *out_max_tokens = (uint32_t)atoi(max_tokens_val);
+        }
+    }
+    if (out_max_tokens && *out_max_tokens < RECALL_MIN_MAX_TOKENS) {
+        *out_max_tokens = RECALL_MIN_MAX_TOKENS;
+    }
+
     // Extract category (optional)
     char* category_start = strstr(args_json, "\"category\"");
     if (category_start && out_category) {
@@ -253,42 +285,143 @@ static err_t parse_memory_recall_args(const char* args_json,
     return ERR_OK;
 }
 
-// Format memory entries as string
-static char* format_memory_entries(const memory_entry_t* entries, uint32_t count) {
+// Query terms used to place and highlight snippets
+typedef struct {
+    str_t terms[RECALL_MAX_TERMS];
+    uint32_t count;
+} recall_terms_t;
+
+static void split_query_terms(str_t query, recall_terms_t* out) {
+    out->count = 0;
+    uint32_t i = 0;
+    while (i < query.len && out->count < RECALL_MAX_TERMS) {
+        while (i < query.len && !isalnum((unsigned char)query.data[i])) i++;
+        uint32_t start = i;
+        while (i < query.len && isalnum((unsigned char)query.data[i])) i++;
+        if (i - start >= 2) {
+            out->terms[out->count++] = (str_t){ .data = query.data + start, .len = i - start };
+        }
+    }
+}
+
+// Length of the query term matching text[pos..] case-insensitively, or 0
+static uint32_t match_term_at(const char* text, size_t len, size_t pos, const recall_terms_t* terms) {
+    for (uint32_t t = 0; t < terms->count; t++) {
+        const str_t* term = &terms->terms[t];
+        if (pos + term->len > len) continue;
+        if (strncasecmp(text + pos, term->data, term->len) == 0) return term->len;
+    }
+    return 0;
+}
+
+// Append text[start, end) with every query term match wrapped in highlight markers
+static void append_highlighted(str_builder_t* buf, const char* text, size_t start, size_t end,
+                               const recall_terms_t* terms) {
+    size_t run = start;
+    size_t i = start;
+    while (i < end) {
+        uint32_t match = match_term_at(text, end, i, terms);
+        if (match == 0) {
+            i++;
+            continue;
+        }
+        str_builder_append_bytes(buf, text + run, i - run);
+        str_builder_append_bytes(buf, RECALL_HIGHLIGHT, sizeof(RECALL_HIGHLIGHT) - 1);
+        str_builder_append_bytes(buf, text + i, match);
+        str_builder_append_bytes(buf, RECALL_HIGHLIGHT, sizeof(RECALL_HIGHLIGHT) - 1);
+        i += match;
+        run = i;
+    }
+    str_builder_append_bytes(buf, text + run, end - run);
+}
+
+// Move a cut point back to the start of the UTF-8 sequence it falls in
+static size_t utf8_cut_back(const char* text, size_t pos) {
+    while (pos > 0 && ((unsigned char)text[pos] & 0xC0) == 0x80) pos--;
+    return pos;
+}
+
+// Append at most max_chars of content, windowed around the first term match.
+// Both cuts land on code point boundaries, so the window may come up a few
+// bytes short of max_chars.
+static void append_snippet(str_builder_t* buf, str_t content, size_t max_chars, const recall_terms_t* terms) {
+    if (content.len <= max_chars) {
+        append_highlighted(buf, content.data, 0, content.len, terms);
+        return;
+    }
+
+    size_t first = 0;
+    for (size_t i = 0; i < content.len; i++) {
+        if (match_term_at(content.data, content.len, i, terms) > 0) {
+            first = i;
+            break;
+        }
+    }
+
+    // Keep a little leading context before the match
+    size_t start = first > max_chars / 4 ? first - max_chars / 4 : 0;
+    if (start + max_chars > content.len) start = content.len - max_chars;
+    start = utf8_cut_back(content.data, start);
+    size_t end = start + max_chars;
+    if (end < content.len) end = utf8_cut_back(content.data, end);
+
+    if (start > 0) str_builder_append_bytes(buf, "...", 3);
+    append_highlighted(buf, content.data, start, end, terms);
+    str_builder_append_bytes(buf, "...", 3);
+}
+
+// Format ranked memory entries within a token budget. Entries are emitted in
+// rank order with truncated, highlighted content until the next one would
+// overflow the budget; the rest are summarized in a trailing line.
+static char* format_memory_entries(const memory_entry_t* entries, uint32_t count,
+                                   str_t query, uint32_t max_tokens) {
     if (!entries || count == 0) {
         return strdup("No results found");
     }
 
-    // Calculate required buffer size
-    size_t total_size = 0;
-    for (uint32_t i = 0; i < count; i++) {
-        total_size += entries[i].key.len + entries[i].content.len + 128; // Extra for formatting
-    }
+    recall_terms_t terms;
+    split_query_terms(query, &terms);
 
-    char* buffer = malloc(total_size + 1);
-    if (!buffer) return NULL;
+    size_t budget = (size_t)max_tokens * RECALL_BYTES_PER_TOKEN;
+    size_t entry_chars = RECALL_ENTRY_MAX_CHARS;
+    if (entry_chars > budget / 2) entry_chars = budget / 2;
 
-    char* ptr = buffer;
-    ptr[0] = '\0';
+    str_builder_t buf;
+    str_builder_init(&buf, NULL);
+    uint32_t emitted = 0;
 
     for (uint32_t i = 0; i < count; i++) {
         const memory_entry_t* entry = &entries[i];
+        size_t mark = buf.len;
 
         // Format: [ID] Key: content (score: X.XX)
-        ptr += snprintf(ptr, total_size - (ptr - buffer),
-                       "[%d] Key: %.*s\n"
-                       "     Content: %.*s\n"
-                       "     Category: %s, Score: %.2f\n"
-                       "     Timestamp: %.*s\n\n",
-                       i + 1,
-                       (int)entry->key.len, entry->key.data,
-                       (int)entry->content.len, entry->content.data,
-                       memory_category_to_string(entry->category),
-                       entry->score,
-                       (int)entry->timestamp.len, entry->timestamp.data);
+        str_builder_appendf(&buf, "[%u] Key: %.*s\n     Content: ",
+                          i + 1, (int)entry->key.len, entry->key.data);
+        append_snippet(&buf, entry->content, entry_chars, &terms);
+        str_t category = memory_category_to_string(entry->category);
+        str_builder_appendf(&buf, "\n     Category: %.*s, Score: %.2f\n"
+                                "     Timestamp: %.*s\n\n",
+                          (int)category.len, category.data,
+                          entry->score,
+                          (int)entry->timestamp.len, entry->timestamp.data);
+        if (buf.failed) break;
+
+        if (buf.len > budget && emitted > 0) {
+            buf.len = mark;
+            buf.data[buf.len] = '\0';
+            break;
+        }
+        emitted++;
     }
 
-    return buffer;
+    if (!buf.failed && emitted < count) {
+        str_builder_appendf(&buf, "(%u more result%s omitted to stay within %u tokens)\n",
+                          count - emitted, count - emitted == 1 ? "" : "s", max_tokens);
+    }
+
+    // Hands the heap buffer over without copying
+    str_t result = str_builder_finish(&buf, NULL);
+    return (char*)result.data;
 }
 
 static err_t memory_recall_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
@@ -315,9 +448,10 @@ static err_t memory_recall_execute(tool_t* tool, const str_t* args, tool_result_
     str_t query = STR_NULL;
     str_t key = STR_NULL;
     uint32_t limit = 10;
+    uint32_t max_tokens = RECALL_DEFAULT_MAX_TOKENS;
     memory_category_t category = MEMORY_CATEGORY_CORE; // Default to all categories
 
-    err_t parse_err = parse_memory_recall_args(args_str, &query, &key, &limit, &category);
+    err_t parse_err = parse_memory_recall_args(args_str, &query, &key, &limit, &max_tokens, &category);
     free(args_str);
 
     if (parse_err != ERR_OK) {
@@ -359,21 +493,23 @@ static err_t memory_recall_execute(tool_t* tool, const str_t* args, tool_result_
                                                          &entries, &entry_count);
     }
 
-    // Cleanup parsed arguments
-    if (!str_empty(query)) free((void*)query.data);
-    if (!str_empty(key)) free((void*)key.data);
-
     if (recall_err != ERR_OK) {
+        if (!str_empty(query)) free((void*)query.data);
+        if (!str_empty(key)) free((void*)key.data);
         if (entries) memory_entry_array_free(entries, entry_count);
         str_t error = STR_LIT("Failed to recall from memory");
         tool_result_set_error(out_result, &error);
         return recall_err;
     }
 
-    // Format results
-    char* formatted_results = format_memory_entries(entries, entry_count);
+    // Format results within the token budget; the query drives snippet highlighting
+    char* formatted_results = format_memory_entries(entries, entry_count, query, max_tokens);
     memory_entry_array_free(entries, entry_count);
 
+    // Cleanup parsed arguments
+    if (!str_empty(query)) free((void*)query.data);
+    if (!str_empty(key)) free((void*)key.data);
+
     if (!formatted_results) {
         str_t error = STR_LIT("Failed to format results");
         tool_result_set_error(out_result, &error);
@@ -407,6 +543,11 @@ static str_t memory_recall_get_parameters_schema(void) {
                 "\"minimum\": 1,"
                 "\"maximum\": 100"
             "},"
+            "\"max_tokens\": {"
+                "\"type\": \"integer\","
+                "\"description\": \"Approximate token budget for the result; long entries are truncated to snippets (default: 1024)\","
+                "\"minimum\": 64"
+            "},"
             "\"category\": {"
                 "\"type\": \"string\","
                 "\"description\": \"Filter by category (core, daily, conversation, custom)\","
@@ -429,4 +570,18 @@ static bool memory_recall_requires_memory(void) {
 static bool memory_recall_allowed_in_autonomous(autonomy_level_t level) {
     // Allow in supervised or full autonomy modes
     return level >= AUTONOMY_LEVEL_SUPERVISED;
+}
+
+static bool memory_recall_is_read_only(void) {
+    return true;
+}
+
+static bool memory_recall_cache_validator(tool_t* tool, const str_t* args, uint64_t* out_validator) {
+    if (!tool || !tool->impl_data || !out_validator) return false;
+
+    memory_recall_tool_t* recall_data = (memory_recall_tool_t*)tool->impl_data;
+    if (!recall_data->memory) return false;
+
+    *out_validator = memory_generation(recall_data->memory);
+    return true;
 }
\ No newline at end of file
@@ -99,7 +99,8 @@ static void memory_store_destroy(tool_t* tool) {
     free(store_data);
     tool->impl_data = NULL;
 
-    tool_free(tool);
+    // tool_free() would call back into this function
+    free(tool);
 }
 
 static err_t memory_store_init(tool_t* tool, const tool_context_t* context) {
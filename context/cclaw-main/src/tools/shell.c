@@ -3,6 +3,7 @@
 
 #include "core/tool.h"
 #include "core/config.h"
+#include "core/sandbox.h"
 #include "json_config.h"
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +14,8 @@
 #include <errno.h>
 #include <signal.h>
 
+#define SHELL_MAX_SANDBOX_OUTPUT (1024 * 1024)
+
 // Shell tool instance data
 typedef struct shell_tool_t {
     config_t* config;          // Configuration for whitelist and restrictions
@@ -114,7 +117,8 @@ static void shell_destroy(tool_t* tool) {
     free(shell_data);
     tool->impl_data = NULL;
 
-    tool_free(tool);
+    // tool_free() would call back into this function
+    free(tool);
 }
 
 static err_t shell_init(tool_t* tool, const tool_context_t* context) {
@@ -305,6 +309,55 @@ static err_t execute_command(const char* command, uint32_t timeout_seconds,
     }
 }
 
+// Same results as execute_command(), but the command runs in the
+// sandbox's namespaces and the timeout is enforced
+static err_t execute_in_sandbox(sandbox_t* sandbox, const char* command, uint32_t timeout_seconds,
+                                tool_result_t* out_result) {
+    sandbox_result_t result;
+    err_t err = sandbox_exec(sandbox, command, timeout_seconds * 1000, SHELL_MAX_SANDBOX_OUTPUT, &result);
+    if (err != ERR_OK) {
+        str_t error = STR_LIT("Failed to execute command in sandbox");
+        tool_result_set_error(out_result, &error);
+        return err == ERR_TIMEOUT ? ERR_TOOL_TIMEOUT : ERR_TOOL_EXECUTION_FAILED;
+    }
+
+    char header[128];
+    err = ERR_TOOL_EXECUTION_FAILED;
+    if (result.timed_out) {
+        snprintf(header, sizeof(header), "Command timed out after %u seconds", timeout_seconds);
+        err = ERR_TOOL_TIMEOUT;
+    } else if (result.term_signal) {
+        snprintf(header, sizeof(header), "Command killed by signal %d", result.term_signal);
+    } else if (result.exit_code != 0) {
+        snprintf(header, sizeof(header), "Command failed with exit code %d", result.exit_code);
+    } else {
+        err = ERR_OK;
+    }
+
+    if (err == ERR_OK) {
+        str_t content = result.output_len
+            ? (str_t){ .data = result.output, .len = (uint32_t)result.output_len }
+            : STR_LIT("Command executed successfully (no output)");
+        tool_result_set_success(out_result, &content);
+    } else {
+        size_t size = strlen(header) + result.output_len + 16;
+        char* message = malloc(size);
+        if (message) {
+            snprintf(message, size, result.output_len ? "%s\nOutput:\n%s" : "%s", header, result.output);
+            str_t error = STR_VIEW(message);
+            tool_result_set_error(out_result, &error);
+            free(message);
+        } else {
+            // No room for the output, but the failure is still reported
+            str_t error = STR_VIEW(header);
+            tool_result_set_error(out_result, &error);
+        }
+    }
+
+    sandbox_result_free(&result);
+    return err;
+}
+
 static err_t shell_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
     if (!tool || !tool->impl_data || !tool->initialized || !args || !out_result) {
         return ERR_INVALID_ARGUMENT;
@@ -327,6 +380,13 @@ static err_t shell_execute(tool_t* tool, const str_t* args, tool_result_t* out_r
         return ERR_TOOL_NOT_ALLOWED;
     }
 
+    if (tool->context.sandbox) {
+        err_t result = execute_in_sandbox(tool->context.sandbox, command,
+                                          shell_data->timeout_seconds, out_result);
+        free(command);
+        return result;
+    }
+
     // Execute command
     err_t result = execute_command(command, shell_data->timeout_seconds,
                                   shell_data->workspace_dir.data ? shell_data->workspace_dir.data : NULL,
@@ -0,0 +1,175 @@
+// tool_output_read.c - Paging through spilled tool outputs for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/tool.h"
+#include "core/tool_output.h"
+#include "core/str_builder.h"
+#include "json_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static str_t tool_output_read_get_name(void) {
+    return STR_LIT("tool_output_read");
+}
+
+static str_t tool_output_read_get_description(void) {
+    return STR_LIT("Read part of a tool output that was too large for the context. "
+                   "Pass the handle from the output's header and a byte offset; "
+                   "reads up to 16 KB at a time");
+}
+
+static str_t tool_output_read_get_version(void) {
+    return STR_LIT("1.0.0");
+}
+
+static str_t tool_output_read_get_parameters_schema(void) {
+    return STR_LIT("{"
+        "\"type\":\"object\","
+        "\"properties\":{"
+            "\"handle\":{\"type\":\"string\",\"description\":\"Handle named in the truncated output\"},"
+            "\"offset\":{\"type\":\"integer\",\"minimum\":0,\"default\":0},"
+            "\"length\":{\"type\":\"integer\",\"minimum\":1,\"maximum\":16384,\"default\":16384}"
+        "},"
+        "\"required\":[\"handle\"]"
+    "}");
+}
+
+static err_t tool_output_read_create(tool_t** out_tool);
+static void tool_output_read_destroy(tool_t* tool);
+static err_t tool_output_read_init(tool_t* tool, const tool_context_t* context);
+static void tool_output_read_cleanup(tool_t* tool);
+static err_t tool_output_read_execute(tool_t* tool, const str_t* args, tool_result_t* out_result);
+
+static bool tool_output_read_requires_memory(void) {
+    return false;
+}
+
+static bool tool_output_read_allowed_in_autonomous(autonomy_level_t level) {
+    return true;    // Read-only
+}
+
+static bool tool_output_read_is_read_only(void) {
+    return true;
+}
+
+static const tool_vtable_t tool_output_read_vtable = {
+    .get_name = tool_output_read_get_name,
+    .get_description = tool_output_read_get_description,
+    .get_version = tool_output_read_get_version,
+    .create = tool_output_read_create,
+    .destroy = tool_output_read_destroy,
+    .init = tool_output_read_init,
+    .cleanup = tool_output_read_cleanup,
+    .execute = tool_output_read_execute,
+    .get_parameters_schema = tool_output_read_get_parameters_schema,
+    .requires_memory = tool_output_read_requires_memory,
+    .allowed_in_autonomous = tool_output_read_allowed_in_autonomous,
+    .is_read_only = tool_output_read_is_read_only
+};
+
+const tool_vtable_t* tool_output_read_tool_get_vtable(void) {
+    return &tool_output_read_vtable;
+}
+
+static err_t tool_output_read_create(tool_t** out_tool) {
+    if (!out_tool) return ERR_INVALID_ARGUMENT;
+
+    tool_t* tool = tool_alloc(&tool_output_read_vtable);
+    if (!tool) return ERR_OUT_OF_MEMORY;
+
+    *out_tool = tool;
+    return ERR_OK;
+}
+
+static void tool_output_read_destroy(tool_t* tool) {
+    if (!tool) return;
+    // tool_free() would call back into this function
+    free(tool);
+}
+
+static err_t tool_output_read_init(tool_t* tool, const tool_context_t* context) {
+    if (!tool || !context) return ERR_INVALID_ARGUMENT;
+
+    tool->context = *context;
+    tool->initialized = true;
+    return ERR_OK;
+}
+
+static void tool_output_read_cleanup(tool_t* tool) {
+    if (tool) tool->initialized = false;
+}
+
+static err_t tool_output_read_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    if (!tool || !args || !out_result) return ERR_INVALID_ARGUMENT;
+
+    char* text = strndup(args->data ? args->data : "", args->len);
+    json_value_t* root = text ? json_parse(text) : NULL;
+    free(text);
+
+    json_object_t* obj = root && json_is_object(root) ? json_as_object(root) : NULL;
+    const char* handle = obj ? json_object_get_string(obj, "handle", NULL) : NULL;
+    if (!handle || !*handle) {
+        json_free(root);
+        str_t error = STR_LIT("Missing \"handle\"");
+        tool_result_set_error(out_result, &error);
+        return ERR_OK;
+    }
+
+    double offset = json_object_get_number(obj, "offset", 0);
+    double length = json_object_get_number(obj, "length", TOOL_OUTPUT_PAGE_BYTES);
+    if (offset < 0) offset = 0;
+    if (length < 1 || length > TOOL_OUTPUT_PAGE_BYTES) length = TOOL_OUTPUT_PAGE_BYTES;
+
+    str_t page = STR_NULL;
+    uint64_t total = 0;
+    err_t err = tool_output_read(tool_output_bound(), STR_VIEW(handle), (uint64_t)offset,
+                                 (uint32_t)length, &page, &total);
+    json_free(root);
+
+    if (err == ERR_NOT_FOUND) {
+        str_t error = STR_LIT("Unknown tool output handle (outputs are kept for this session only)");
+        tool_result_set_error(out_result, &error);
+        return ERR_OK;
+    }
+    if (err != ERR_OK) {
+        str_t error = STR_VIEW(error_to_string(err));
+        tool_result_set_error(out_result, &error);
+        return ERR_OK;
+    }
+
+    // Whole UTF-8 characters only: skip continuation bytes at the start and
+    // leave an incomplete sequence at the end for the next page
+    uint32_t start = 0;
+    while (start < page.len && ((uint8_t)page.data[start] & 0xC0) == 0x80) start++;
+    uint32_t end = page.len;
+    if ((uint64_t)offset + page.len < total) {
+        uint32_t lead = end;
+        while (lead > start && ((uint8_t)page.data[lead - 1] & 0xC0) == 0x80) lead--;
+        if (lead > start) {
+            uint8_t c = (uint8_t)page.data[lead - 1];
+            uint32_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+            if (end - (lead - 1) < need) end = lead - 1;
+        }
+    }
+
+    uint64_t first = (uint64_t)offset + start;
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    if (end > start) {
+        str_builder_appendf(&sb, "[bytes %llu-%llu of %llu]\n", (unsigned long long)first,
+                            (unsigned long long)(first + (end - start) - 1),
+                            (unsigned long long)total);
+        str_builder_append(&sb, (str_t){ .data = page.data + start, .len = end - start });
+    } else {
+        str_builder_appendf(&sb, "[no bytes at offset %llu; the output is %llu bytes]",
+                            (unsigned long long)offset, (unsigned long long)total);
+    }
+    free((void*)page.data);
+
+    str_t output = str_builder_finish(&sb, NULL);
+    tool_result_set_success(out_result, &output);
+    free((void*)output.data);
+    return ERR_OK;
+}
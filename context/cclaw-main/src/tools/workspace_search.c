@@ -0,0 +1,173 @@
+// workspace_search.c - Semantic search over the workspace for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/tool.h"
+#include "core/rag.h"
+#include "core/str_builder.h"
+#include "json_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static str_t workspace_search_get_name(void) {
+    return STR_LIT("workspace_search");
+}
+
+static str_t workspace_search_get_description(void) {
+    return STR_LIT("Find the code and text in the workspace most relevant to a query. "
+                   "Returns file paths, line ranges and the matching lines; use it "
+                   "before reading or grepping files one by one");
+}
+
+static str_t workspace_search_get_version(void) {
+    return STR_LIT("1.0.0");
+}
+
+static str_t workspace_search_get_parameters_schema(void) {
+    return STR_LIT("{"
+        "\"type\":\"object\","
+        "\"properties\":{"
+            "\"query\":{\"type\":\"string\",\"description\":\"What to look for, in words or identifiers\"},"
+            "\"limit\":{\"type\":\"integer\",\"minimum\":1,\"maximum\":20,\"default\":5},"
+            "\"path\":{\"type\":\"string\",\"description\":\"Only search under this relative path\"}"
+        "},"
+        "\"required\":[\"query\"]"
+    "}");
+}
+
+static err_t workspace_search_create(tool_t** out_tool);
+static void workspace_search_destroy(tool_t* tool);
+static err_t workspace_search_init(tool_t* tool, const tool_context_t* context);
+static void workspace_search_cleanup(tool_t* tool);
+static err_t workspace_search_execute(tool_t* tool, const str_t* args, tool_result_t* out_result);
+
+static bool workspace_search_requires_memory(void) {
+    return false;
+}
+
+static bool workspace_search_allowed_in_autonomous(autonomy_level_t level) {
+    return true;    // Read-only
+}
+
+static bool workspace_search_is_read_only(void) {
+    return true;
+}
+
+static const tool_vtable_t workspace_search_vtable = {
+    .get_name = workspace_search_get_name,
+    .get_description = workspace_search_get_description,
+    .get_version = workspace_search_get_version,
+    .create = workspace_search_create,
+    .destroy = workspace_search_destroy,
+    .init = workspace_search_init,
+    .cleanup = workspace_search_cleanup,
+    .execute = workspace_search_execute,
+    .get_parameters_schema = workspace_search_get_parameters_schema,
+    .requires_memory = workspace_search_requires_memory,
+    .allowed_in_autonomous = workspace_search_allowed_in_autonomous,
+    .is_read_only = workspace_search_is_read_only
+};
+
+const tool_vtable_t* workspace_search_tool_get_vtable(void) {
+    return &workspace_search_vtable;
+}
+
+static err_t workspace_search_create(tool_t** out_tool) {
+    if (!out_tool) return ERR_INVALID_ARGUMENT;
+
+    tool_t* tool = tool_alloc(&workspace_search_vtable);
+    if (!tool) return ERR_OUT_OF_MEMORY;
+
+    *out_tool = tool;
+    return ERR_OK;
+}
+
+static void workspace_search_destroy(tool_t* tool) {
+    if (!tool) return;
+    workspace_search_cleanup(tool);
+    free(tool);
+}
+
+static err_t workspace_search_init(tool_t* tool, const tool_context_t* context) {
+    if (!tool || !context) return ERR_INVALID_ARGUMENT;
+    if (tool->initialized) return ERR_OK;
+
+    // The index is built on the first search, not here
+    rag_index_t* index = NULL;
+    err_t err = rag_index_open_configured(context->workspace_dir, &index);
+    if (err != ERR_OK) return err;
+
+    tool->context = *context;
+    tool->impl_data = index;
+    tool->initialized = true;
+    return ERR_OK;
+}
+
+static void workspace_search_cleanup(tool_t* tool) {
+    if (!tool) return;
+
+    rag_index_close(tool->impl_data);
+    tool->impl_data = NULL;
+    tool->initialized = false;
+}
+
+static err_t workspace_search_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    if (!tool || !args || !out_result) return ERR_INVALID_ARGUMENT;
+    if (!tool->initialized) return ERR_NOT_INITIALIZED;
+
+    char* text = strndup(args->data ? args->data : "", args->len);
+    json_value_t* root = text ? json_parse(text) : NULL;
+    free(text);
+
+    json_object_t* obj = root && json_is_object(root) ? json_as_object(root) : NULL;
+    const char* query = obj ? json_object_get_string(obj, "query", NULL) : NULL;
+    if (!query || !*query) {
+        json_free(root);
+        str_t error = STR_LIT("Missing \"query\"");
+        tool_result_set_error(out_result, &error);
+        return ERR_OK;
+    }
+
+    double limit = json_object_get_number(obj, "limit", 5);
+    const char* path = json_object_get_string(obj, "path", NULL);
+
+    rag_hit_t* hits = NULL;
+    uint32_t count = 0;
+    err_t err = rag_index_search(tool->impl_data, STR_VIEW(query),
+                                 limit >= 1 ? (uint32_t)limit : 5,
+                                 path ? STR_VIEW(path) : STR_NULL, &hits, &count);
+    json_free(root);
+
+    if (err != ERR_OK) {
+        const error_ctx_t* last = error_last();
+        str_t error = last && last->code == err ? error_message(last)
+                                                : STR_VIEW(error_to_string(err));
+        tool_result_set_error(out_result, &error);
+        return ERR_OK;
+    }
+
+    str_builder_t sb;
+    str_builder_init(&sb, NULL);
+    if (count == 0) {
+        str_builder_append_cstr(&sb, "No matches.");
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) str_builder_append_char(&sb, '\n');
+        str_builder_appendf(&sb, "%.*s:%u-%u (score %.2f%s)\n```\n",
+                            (int)hits[i].path.len, hits[i].path.data,
+                            hits[i].start_line, hits[i].end_line, hits[i].score,
+                            hits[i].stale ? ", changed since indexed" : "");
+        str_builder_append(&sb, hits[i].snippet);
+        if (hits[i].snippet.len > 0 && hits[i].snippet.data[hits[i].snippet.len - 1] != '\n') {
+            str_builder_append_char(&sb, '\n');
+        }
+        str_builder_append_cstr(&sb, "```\n");
+    }
+    rag_hits_free(hits, count);
+
+    str_t output = str_builder_finish(&sb, NULL);
+    tool_result_set_success(out_result, &output);
+    free((void*)output.data);
+    return ERR_OK;
+}
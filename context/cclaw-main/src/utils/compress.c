@@ -0,0 +1,318 @@
+// compress.c - Content compression codecs for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "utils/compress.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifdef CCLAW_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define DEFLATE_LEVEL 6
+#define DEFLATE_MIN_WINDOW_BITS 9
+#define DEFLATE_MAX_WINDOW_BITS 15
+
+#ifdef CCLAW_HAVE_ZSTD
+#define ZSTD_LEVEL 3
+#endif
+
+// Preset dictionary for COMPRESS_DICT_MEMORY_V1. Deflate references the
+// tail of the dictionary most cheaply, so the most common fragments come
+// last. The contents are part of the on-disk format: never edit this
+// string, add a new dictionary id instead.
+static const char g_dict_memory_v1[] =
+    "Tool output truncated. Exit code: 0 stdout: stderr: No such file or directory "
+    "Permission denied error: warning: note: failed to Traceback (most recent call last): "
+    "#include <stdio.h> #include <stdlib.h> #include <string.h> static const char* "
+    "return ERR_OK; if (!ptr) return NULL; function def class import from self. "
+    "https://github.com/ http://localhost: /home/ /usr/local/ /tmp/ .json .md .txt .c .h .py "
+    "{\"type\":\"text\",\"text\":\"} {\"role\":\"tool\",\"tool_call_id\":\" "
+    "{\"name\":\"\",\"arguments\":\"{\\\"path\\\":\\\"\\\"}\"} \"content\":\" "
+    "The user prefers The user wants The user asked The assistant should remember that "
+    "Conversation summary: Session started at Decision: TODO: Note: Preference: "
+    "User: Assistant: user said assistant replied because which should would could "
+    "the project the file the function the repository the configuration the memory "
+    " in the of the to the and the for the with the that is on the is not ";
+
+static const void* dict_data(uint8_t dict_id, size_t* out_len) {
+    switch (dict_id) {
+        case COMPRESS_DICT_MEMORY_V1:
+            *out_len = sizeof(g_dict_memory_v1) - 1;
+            return g_dict_memory_v1;
+        default:
+            *out_len = 0;
+            return NULL;
+    }
+}
+
+// ============================================================================
+// Deflate (zlib) codec
+// ============================================================================
+
+static size_t deflate_codec_bound(size_t src_len) {
+    return (size_t)compressBound((uLong)src_len);
+}
+
+// Smallest window that still covers the dictionary plus the whole input
+// keeps zlib's per-stream allocations small for short entries.
+static int deflate_window_bits(size_t span) {
+    int bits = DEFLATE_MIN_WINDOW_BITS;
+    while (bits < DEFLATE_MAX_WINDOW_BITS && ((size_t)1 << bits) < span) {
+        bits++;
+    }
+    return bits;
+}
+
+static err_t deflate_codec_compress(const void* src, size_t src_len,
+                                    const void* dict, size_t dict_len,
+                                    void* dst, size_t dst_cap, size_t* out_len) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    int bits = deflate_window_bits(src_len + dict_len);
+    if (deflateInit2(&zs, DEFLATE_LEVEL, Z_DEFLATED, -bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    if (dict && deflateSetDictionary(&zs, dict, (uInt)dict_len) != Z_OK) {
+        deflateEnd(&zs);
+        return ERR_FAILED;
+    }
+
+    zs.next_in = (Bytef*)src;
+    zs.avail_in = (uInt)src_len;
+    zs.next_out = dst;
+    zs.avail_out = (uInt)dst_cap;
+
+    int rc = deflate(&zs, Z_FINISH);
+    size_t produced = zs.total_out;
+    deflateEnd(&zs);
+
+    if (rc != Z_STREAM_END) return ERR_FAILED;
+
+    *out_len = produced;
+    return ERR_OK;
+}
+
+static err_t deflate_codec_decompress(const void* src, size_t src_len,
+                                      const void* dict, size_t dict_len,
+                                      void* dst, size_t dst_len) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (inflateInit2(&zs, -DEFLATE_MAX_WINDOW_BITS) != Z_OK) {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    // Raw streams take the dictionary up front rather than on Z_NEED_DICT
+    if (dict && inflateSetDictionary(&zs, dict, (uInt)dict_len) != Z_OK) {
+        inflateEnd(&zs);
+        return ERR_MEMORY_CORRUPT;
+    }
+
+    zs.next_in = (Bytef*)src;
+    zs.avail_in = (uInt)src_len;
+    zs.next_out = dst;
+    zs.avail_out = (uInt)dst_len;
+
+    int rc = inflate(&zs, Z_FINISH);
+    size_t produced = zs.total_out;
+    inflateEnd(&zs);
+
+    if (rc != Z_STREAM_END || produced != dst_len) return ERR_MEMORY_CORRUPT;
+    return ERR_OK;
+}
+
+static const compress_codec_t g_deflate_codec = {
+    .id = COMPRESS_CODEC_DEFLATE,
+    .name = "deflate",
+    .bound = deflate_codec_bound,
+    .compress = deflate_codec_compress,
+    .decompress = deflate_codec_decompress,
+};
+
+// ============================================================================
+// Zstandard codec (optional)
+// ============================================================================
+
+#ifdef CCLAW_HAVE_ZSTD
+static size_t zstd_codec_bound(size_t src_len) {
+    return ZSTD_compressBound(src_len);
+}
+
+static err_t zstd_codec_compress(const void* src, size_t src_len,
+                                 const void* dict, size_t dict_len,
+                                 void* dst, size_t dst_cap, size_t* out_len) {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    if (!cctx) return ERR_OUT_OF_MEMORY;
+
+    size_t rc = ZSTD_compress_usingDict(cctx, dst, dst_cap, src, src_len,
+                                        dict, dict ? dict_len : 0, ZSTD_LEVEL);
+    ZSTD_freeCCtx(cctx);
+
+    if (ZSTD_isError(rc)) return ERR_FAILED;
+
+    *out_len = rc;
+    return ERR_OK;
+}
+
+static err_t zstd_codec_decompress(const void* src, size_t src_len,
+                                   const void* dict, size_t dict_len,
+                                   void* dst, size_t dst_len) {
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    if (!dctx) return ERR_OUT_OF_MEMORY;
+
+    size_t rc = ZSTD_decompress_usingDict(dctx, dst, dst_len, src, src_len,
+                                          dict, dict ? dict_len : 0);
+    ZSTD_freeDCtx(dctx);
+
+    if (ZSTD_isError(rc) || rc != dst_len) return ERR_MEMORY_CORRUPT;
+    return ERR_OK;
+}
+
+static const compress_codec_t g_zstd_codec = {
+    .id = COMPRESS_CODEC_ZSTD,
+    .name = "zstd",
+    .bound = zstd_codec_bound,
+    .compress = zstd_codec_compress,
+    .decompress = zstd_codec_decompress,
+};
+#endif
+
+// ============================================================================
+// Codec registry
+// ============================================================================
+
+static const compress_codec_t* const g_codecs[] = {
+#ifdef CCLAW_HAVE_ZSTD
+    &g_zstd_codec,
+#endif
+    &g_deflate_codec,
+};
+
+#define CODEC_COUNT (sizeof(g_codecs) / sizeof(g_codecs[0]))
+
+const compress_codec_t* compress_codec_get(compress_codec_id_t id) {
+    for (size_t i = 0; i < CODEC_COUNT; i++) {
+        if (g_codecs[i]->id == id) return g_codecs[i];
+    }
+    return NULL;
+}
+
+const compress_codec_t* compress_codec_by_name(const char* name) {
+    if (!name) return NULL;
+    for (size_t i = 0; i < CODEC_COUNT; i++) {
+        if (strcmp(g_codecs[i]->name, name) == 0) return g_codecs[i];
+    }
+    return NULL;
+}
+
+const compress_codec_t* compress_codec_default(void) {
+    return &g_deflate_codec;
+}
+
+const compress_codec_t* compress_codec_select(str_t name) {
+    if (str_empty(name)) return compress_codec_default();
+    for (size_t i = 0; i < CODEC_COUNT; i++) {
+        const char* codec_name = g_codecs[i]->name;
+        if (strlen(codec_name) == name.len && memcmp(codec_name, name.data, name.len) == 0) {
+            return g_codecs[i];
+        }
+    }
+    return NULL;
+}
+
+// ============================================================================
+// Framing
+// ============================================================================
+
+bool compress_is_frame(const void* data, size_t len) {
+    const uint8_t* p = data;
+    return data && len >= COMPRESS_FRAME_HEADER && p[0] == 0 && p[1] == COMPRESS_FRAME_MAGIC;
+}
+
+err_t compress_frame_length(const void* data, size_t len, size_t* out_len) {
+    if (!compress_is_frame(data, len) || !out_len) return ERR_INVALID_ARGUMENT;
+
+    const uint8_t* p = data;
+    *out_len = (size_t)p[4] | (size_t)p[5] << 8 | (size_t)p[6] << 16 | (size_t)p[7] << 24;
+    return ERR_OK;
+}
+
+err_t compress_frame(const compress_codec_t* codec, const void* src, size_t src_len,
+                     void** out_frame, size_t* out_frame_len) {
+    if (!codec || (!src && src_len) || !out_frame || !out_frame_len) return ERR_INVALID_ARGUMENT;
+
+    *out_frame = NULL;
+    *out_frame_len = 0;
+    if (src_len < COMPRESS_MIN_INPUT || src_len > COMPRESS_MAX_INPUT) return ERR_OK;
+
+    size_t cap = COMPRESS_FRAME_HEADER + codec->bound(src_len);
+    uint8_t* frame = malloc(cap);
+    if (!frame) return ERR_OUT_OF_MEMORY;
+
+    size_t dict_len = 0;
+    const void* dict = dict_data(COMPRESS_DICT_MEMORY_V1, &dict_len);
+
+    size_t stream_len = 0;
+    err_t err = codec->compress(src, src_len, dict, dict_len,
+                                frame + COMPRESS_FRAME_HEADER, cap - COMPRESS_FRAME_HEADER,
+                                &stream_len);
+    if (err != ERR_OK) {
+        free(frame);
+        return err;
+    }
+
+    size_t frame_len = COMPRESS_FRAME_HEADER + stream_len;
+    if (frame_len >= src_len) {
+        free(frame);
+        return ERR_OK;
+    }
+
+    frame[0] = 0;
+    frame[1] = COMPRESS_FRAME_MAGIC;
+    frame[2] = (uint8_t)codec->id;
+    frame[3] = COMPRESS_DICT_MEMORY_V1;
+    frame[4] = (uint8_t)src_len;
+    frame[5] = (uint8_t)(src_len >> 8);
+    frame[6] = (uint8_t)(src_len >> 16);
+    frame[7] = (uint8_t)(src_len >> 24);
+
+    *out_frame = frame;
+    *out_frame_len = frame_len;
+    return ERR_OK;
+}
+
+err_t decompress_frame(const void* frame, size_t frame_len,
+                       char** out_data, size_t* out_len) {
+    if (!out_data || !out_len) return ERR_INVALID_ARGUMENT;
+
+    size_t raw_len = 0;
+    if (compress_frame_length(frame, frame_len, &raw_len) != ERR_OK) return ERR_MEMORY_CORRUPT;
+
+    const uint8_t* p = frame;
+    const compress_codec_t* codec = compress_codec_get((compress_codec_id_t)p[2]);
+    if (!codec) return ERR_NOT_IMPLEMENTED;
+
+    size_t dict_len = 0;
+    const void* dict = dict_data(p[3], &dict_len);
+    if (p[3] != COMPRESS_DICT_NONE && !dict) return ERR_NOT_IMPLEMENTED;
+
+    char* data = malloc(raw_len + 1);
+    if (!data) return ERR_OUT_OF_MEMORY;
+
+    err_t err = codec->decompress(p + COMPRESS_FRAME_HEADER, frame_len - COMPRESS_FRAME_HEADER,
+                                  dict, dict_len, data, raw_len);
+    if (err != ERR_OK) {
+        free(data);
+        return err;
+    }
+
+    data[raw_len] = '\0';
+    *out_data = data;
+    *out_len = raw_len;
+    return ERR_OK;
+}
@@ -3,6 +3,8 @@
 
 #include "utils/http.h"
 #include "core/error.h"
+#include "core/trace.h"
+#include "core/alloc.h"
 
 #include <curl/curl.h>
 #include <stdlib.h>
@@ -11,34 +13,100 @@
 #include <time.h>
 #include <ctype.h>
 
-// Memory buffer for response
+// Response body received as a chain of segments. Segments are never moved
+// or resized while data arrives; the body is linearized exactly once when
+// the final size is known, so large responses cost O(n) copying.
+typedef struct response_segment_t {
+    struct response_segment_t* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} response_segment_t;
+
 typedef struct {
-    char* data;
+    response_segment_t* head;
+    response_segment_t* tail;
     size_t size;
-    size_t capacity;
-} memory_buffer_t;
+    bool failed;
+} segmented_buffer_t;
+
+#define RESPONSE_SEGMENT_MIN 4096
+#define RESPONSE_SEGMENT_MAX (1024 * 1024)
+
+// Response buffers and objects are accounted to the HTTP subsystem
+#define HTTP_ALLOC allocator_subsystem(ALLOC_SUBSYS_HTTP)
+
+static response_segment_t* segment_append(segmented_buffer_t* buf) {
+    // Each segment doubles the previous one (bounded), keeping the chain short
+    size_t capacity = buf->tail ? buf->tail->capacity * 2 : RESPONSE_SEGMENT_MIN;
+    if (capacity > RESPONSE_SEGMENT_MAX) capacity = RESPONSE_SEGMENT_MAX;
+
+    response_segment_t* seg = alloc(HTTP_ALLOC, sizeof(response_segment_t) + capacity);
+    if (!seg) return NULL;
+    seg->next = NULL;
+    seg->used = 0;
+    seg->capacity = capacity;
+
+    if (buf->tail) buf->tail->next = seg;
+    else buf->head = seg;
+    buf->tail = seg;
+    return seg;
+}
+
+static void segmented_buffer_free(segmented_buffer_t* buf) {
+    response_segment_t* seg = buf->head;
+    while (seg) {
+        response_segment_t* next = seg->next;
+        free_ptr(HTTP_ALLOC, seg, sizeof(response_segment_t) + seg->capacity);
+        seg = next;
+    }
+    buf->head = buf->tail = NULL;
+    buf->size = 0;
+}
+
+// Copy the chain into one NUL-terminated allocation of size + 1 bytes and
+// release the segments
+static char* segmented_buffer_linearize(segmented_buffer_t* buf) {
+    char* out = alloc(HTTP_ALLOC, buf->size + 1);
+    if (!out) return NULL;
+
+    size_t offset = 0;
+    for (response_segment_t* seg = buf->head; seg; seg = seg->next) {
+        memcpy(out + offset, seg->data, seg->used);
+        offset += seg->used;
+    }
+    out[offset] = '\0';
+
+    segmented_buffer_free(buf);
+    return out;
+}
 
 // Callback for libcurl to write response data
 static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t total_size = size * nmemb;
-    memory_buffer_t* mem = (memory_buffer_t*)userp;
-
-    // Reallocate if needed
-    if (mem->size + total_size + 1 > mem->capacity) {
-        size_t new_capacity = mem->capacity * 2;
-        if (new_capacity < mem->size + total_size + 1) {
-            new_capacity = mem->size + total_size + 1;
+    segmented_buffer_t* buf = (segmented_buffer_t*)userp;
+    const char* src = contents;
+    size_t remaining = total_size;
+
+    while (remaining > 0) {
+        response_segment_t* seg = buf->tail;
+        if (!seg || seg->used == seg->capacity) {
+            seg = segment_append(buf);
+            if (!seg) {
+                buf->failed = true;
+                return 0;  // Signal error to curl
+            }
         }
-        char* new_data = realloc(mem->data, new_capacity);
-        if (!new_data) return 0;  // Signal error to curl
-        mem->data = new_data;
-        mem->capacity = new_capacity;
-    }
 
-    memcpy(mem->data + mem->size, contents, total_size);
-    mem->size += total_size;
-    mem->data[mem->size] = '\0';
+        size_t n = seg->capacity - seg->used;
+        if (n > remaining) n = remaining;
+        memcpy(seg->data + seg->used, src, n);
+        seg->used += n;
+        src += n;
+        remaining -= n;
+    }
 
+    buf->size += total_size;
     return total_size;
 }
 
@@ -49,6 +117,35 @@ static size_t header_callback(char* buffer, size_t size, size_t nitems, void* us
     return size * nitems;  // Just discard for now, we'll parse later
 }
 
+// Record curl's per-phase timing breakdown as child spans of the open request span
+static void trace_curl_phases(CURL* curl, uint64_t start_ns) {
+    curl_off_t dns = 0, connect = 0, tls = 0, pretransfer = 0, first_byte = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &first_byte);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+    // Values are cumulative microseconds from the start of the transfer
+    uint64_t us = 1000;
+    uint64_t connected = tls > 0 ? (uint64_t)tls : (uint64_t)connect;
+
+    trace_span_record_impl("http.dns", "http", start_ns, start_ns + (uint64_t)dns * us);
+    trace_span_record_impl("http.connect", "http", start_ns + (uint64_t)dns * us,
+                           start_ns + (uint64_t)connect * us);
+    if (tls > 0) {
+        trace_span_record_impl("http.tls", "http", start_ns + (uint64_t)connect * us,
+                               start_ns + (uint64_t)tls * us);
+    }
+    trace_span_record_impl("http.send", "http", start_ns + connected * us,
+                           start_ns + (uint64_t)pretransfer * us);
+    trace_span_record_impl("http.first_byte", "http", start_ns + (uint64_t)pretransfer * us,
+                           start_ns + (uint64_t)first_byte * us);
+    trace_span_record_impl("http.transfer", "http", start_ns + (uint64_t)first_byte * us,
+                           start_ns + (uint64_t)total * us);
+}
+
 // Initialize global HTTP subsystem
 err_t http_init(void) {
     CURLcode res = curl_global_init(CURL_GLOBAL_DEFAULT);
@@ -161,7 +258,7 @@ void http_response_free(http_response_t* response) {
     if (!response) return;
 
     free((void*)response->status_text.data);
-    free((void*)response->body.data);
+    free_ptr(HTTP_ALLOC, (void*)response->body.data, response->body.len + 1);
 
     if (response->headers) {
         for (uint32_t i = 0; i < response->headers_count; i++) {
@@ -171,7 +268,7 @@ void http_response_free(http_response_t* response) {
         free(response->headers);
     }
 
-    free(response);
+    free_ptr(HTTP_ALLOC, response, sizeof(http_response_t));
 }
 
 // Get header from response
@@ -249,9 +346,7 @@ static err_t perform_request(http_client_t* client, const char* method, const ch
     }
 
     // Prepare response buffer
-    memory_buffer_t response_buffer = { .data = malloc(4096), .size = 0, .capacity = 4096 };
-    if (!response_buffer.data) return ERR_OUT_OF_MEMORY;
-    response_buffer.data[0] = '\0';
+    segmented_buffer_t response_buffer = {0};
 
     // Set write callback
     curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_callback);
@@ -283,20 +378,29 @@ static err_t perform_request(http_client_t* client, const char* method, const ch
     }
 
     // Perform request
+    TRACE_BEGIN("http.request", "http");
+    uint64_t trace_start = trace_enabled() ? trace_now_ns() : 0;
     CURLcode res = curl_easy_perform(client->curl);
+    if (trace_enabled()) {
+        trace_curl_phases(client->curl, trace_start);
+        TRACE_ARG("bytes", response_buffer.size);
+        TRACE_ARG("curl_code", res);
+    }
+    TRACE_END();
 
     // Cleanup headers
     if (headers) curl_slist_free_all(headers);
 
     if (res != CURLE_OK) {
-        free(response_buffer.data);
-        return ERR_NETWORK;
+        bool oom = response_buffer.failed;
+        segmented_buffer_free(&response_buffer);
+        return oom ? ERR_OUT_OF_MEMORY : ERR_NETWORK;
     }
 
     // Create response object
-    http_response_t* response = calloc(1, sizeof(http_response_t));
+    http_response_t* response = alloc_zeroed(HTTP_ALLOC, sizeof(http_response_t));
     if (!response) {
-        free(response_buffer.data);
+        segmented_buffer_free(&response_buffer);
         return ERR_OUT_OF_MEMORY;
     }
 
@@ -305,9 +409,16 @@ static err_t perform_request(http_client_t* client, const char* method, const ch
     curl_easy_getinfo(client->curl, CURLINFO_RESPONSE_CODE, &http_code);
     response->status_code = (uint32_t)http_code;
 
-    // Move buffer to response
-    response->body.data = response_buffer.data;
-    response->body.len = (uint32_t)response_buffer.size;
+    // Linearize the body once, now that its final size is known
+    size_t body_size = response_buffer.size;
+    char* body_data = segmented_buffer_linearize(&response_buffer);
+    if (!body_data) {
+        segmented_buffer_free(&response_buffer);
+        free_ptr(HTTP_ALLOC, response, sizeof(http_response_t));
+        return ERR_OUT_OF_MEMORY;
+    }
+    response->body.data = body_data;
+    response->body.len = (uint32_t)body_size;
 
     *out_response = response;
     return ERR_OK;
@@ -555,7 +666,14 @@ static err_t perform_stream_request(http_client_t* client, const char* method, c
     }
 
     // Perform request
+    TRACE_BEGIN("http.stream", "http");
+    uint64_t trace_start = trace_enabled() ? trace_now_ns() : 0;
     CURLcode res = curl_easy_perform(client->curl);
+    if (trace_enabled()) {
+        trace_curl_phases(client->curl, trace_start);
+        TRACE_ARG("curl_code", res);
+    }
+    TRACE_END();
 
     // Cleanup headers
     if (headers) curl_slist_free_all(headers);
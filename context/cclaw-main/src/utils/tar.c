@@ -0,0 +1,330 @@
+// tar.c - Streaming tar archives for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "utils/tar.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define TAR_COPY_CHUNK (64 * 1024)
+
+// ustar header layout (POSIX.1-1988 with the ustar extensions)
+typedef struct tar_header_t {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char padding[12];
+} tar_header_t;
+
+_Static_assert(sizeof(tar_header_t) == TAR_BLOCK_SIZE, "tar header must fill one block");
+
+static const char g_zero_block[TAR_BLOCK_SIZE];
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static void put_octal(char* field, size_t width, uint64_t value) {
+    // width - 1 digits and a terminating NUL
+    field[width - 1] = '\0';
+    for (size_t i = width - 1; i > 0; i--) {
+        field[i - 1] = (char)('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+static bool get_octal(const char* field, size_t width, uint64_t* out) {
+    uint64_t value = 0;
+    size_t i = 0;
+    while (i < width && field[i] == ' ') i++;
+    for (; i < width && field[i] >= '0' && field[i] <= '7'; i++) {
+        if (value >> 61) return false;
+        value = value << 3 | (uint64_t)(field[i] - '0');
+    }
+    if (i < width && field[i] != '\0' && field[i] != ' ') return false;
+    *out = value;
+    return true;
+}
+
+static uint32_t header_checksum(const tar_header_t* header) {
+    const unsigned char* bytes = (const unsigned char*)header;
+    uint32_t sum = 0;
+    for (size_t i = 0; i < sizeof(*header); i++) {
+        bool in_field = i >= offsetof(tar_header_t, checksum) &&
+                        i < offsetof(tar_header_t, checksum) + sizeof(header->checksum);
+        sum += in_field ? ' ' : bytes[i];
+    }
+    return sum;
+}
+
+static uint64_t padding_for(uint64_t size) {
+    return (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+}
+
+static err_t write_bytes(FILE* out, const void* data, size_t len) {
+    return fwrite(data, 1, len, out) == len ? ERR_OK : ERR_WRITE_FAILED;
+}
+
+static err_t write_padding(FILE* out, uint64_t size) {
+    uint64_t padding = padding_for(size);
+    return padding ? write_bytes(out, g_zero_block, (size_t)padding) : ERR_OK;
+}
+
+static err_t write_header(FILE* out, const char* name, char typeflag, uint64_t size,
+                          uint32_t mode, uint64_t mtime) {
+    tar_header_t header;
+    memset(&header, 0, sizeof(header));
+
+    size_t name_len = strlen(name);
+    memcpy(header.name, name, name_len < sizeof(header.name) ? name_len : sizeof(header.name));
+    put_octal(header.mode, sizeof(header.mode), mode & 07777);
+    put_octal(header.uid, sizeof(header.uid), 0);
+    put_octal(header.gid, sizeof(header.gid), 0);
+    put_octal(header.size, sizeof(header.size), size);
+    put_octal(header.mtime, sizeof(header.mtime), mtime);
+    header.typeflag = typeflag;
+    memcpy(header.magic, "ustar", 6);
+    memcpy(header.version, "00", 2);
+
+    put_octal(header.checksum, 7, header_checksum(&header));
+    header.checksum[7] = ' ';
+    return write_bytes(out, &header, sizeof(header));
+}
+
+// Names that do not fit the header go first in a pax "path" record; the
+// header itself then carries a truncated copy for old readers
+static err_t write_entry_header(FILE* out, const char* name, char typeflag, uint64_t size,
+                                uint32_t mode, uint64_t mtime) {
+    size_t name_len = strlen(name);
+    if (name_len == 0 || name_len > TAR_MAX_NAME) return ERR_INVALID_ARGUMENT;
+
+    if (name_len > sizeof(((tar_header_t*)0)->name)) {
+        // "<len> path=<name>\n", where len counts its own digits
+        char record[TAR_MAX_NAME + 32];
+        size_t body = strlen(" path=") + name_len + 1;
+        size_t total = body + 1;
+        while ((size_t)snprintf(NULL, 0, "%zu", total) + body != total) total++;
+        int n = snprintf(record, sizeof(record), "%zu path=%s\n", total, name);
+        if (n < 0 || (size_t)n != total) return ERR_INVALID_ARGUMENT;
+
+        err_t err = write_header(out, "././@PaxHeader", 'x', total, 0644, mtime);
+        if (err == ERR_OK) err = write_bytes(out, record, total);
+        if (err == ERR_OK) err = write_padding(out, total);
+        if (err != ERR_OK) return err;
+    }
+    return write_header(out, name, typeflag, size, mode, mtime);
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+err_t tar_write_directory(FILE* out, const char* name, uint32_t mode, uint64_t mtime) {
+    if (!out || !name) return ERR_INVALID_ARGUMENT;
+
+    char with_slash[TAR_MAX_NAME + 2];
+    size_t len = strlen(name);
+    if (len == 0 || len >= TAR_MAX_NAME) return ERR_INVALID_ARGUMENT;
+    snprintf(with_slash, sizeof(with_slash), name[len - 1] == '/' ? "%s" : "%s/", name);
+    return write_entry_header(out, with_slash, '5', 0, mode, mtime);
+}
+
+err_t tar_write_file(FILE* out, const char* name, int fd, uint64_t size, uint32_t mode,
+                     uint64_t mtime) {
+    if (!out || !name || fd < 0) return ERR_INVALID_ARGUMENT;
+
+    err_t err = write_entry_header(out, name, '0', size, mode, mtime);
+    if (err != ERR_OK) return err;
+
+    char* buffer = malloc(TAR_COPY_CHUNK);
+    if (!buffer) return ERR_OUT_OF_MEMORY;
+
+    uint64_t left = size;
+    while (err == ERR_OK && left > 0) {
+        size_t want = left < TAR_COPY_CHUNK ? (size_t)left : TAR_COPY_CHUNK;
+        ssize_t n = read(fd, buffer, want);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            err = ERR_IO;
+            break;
+        }
+        err = write_bytes(out, buffer, (size_t)n);
+        left -= (uint64_t)n;
+    }
+    free(buffer);
+
+    if (err == ERR_OK) err = write_padding(out, size);
+    return err;
+}
+
+err_t tar_write_end(FILE* out) {
+    if (!out) return ERR_INVALID_ARGUMENT;
+
+    err_t err = write_bytes(out, g_zero_block, TAR_BLOCK_SIZE);
+    if (err == ERR_OK) err = write_bytes(out, g_zero_block, TAR_BLOCK_SIZE);
+    return err;
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+static err_t read_block(FILE* in, void* block) {
+    return fread(block, 1, TAR_BLOCK_SIZE, in) == TAR_BLOCK_SIZE ? ERR_OK : ERR_IO;
+}
+
+// Picks the "path" record out of a pax extended header
+static err_t read_pax_path(FILE* in, uint64_t size, char* out_path, bool* out_found) {
+    if (size > 64 * 1024) return ERR_FILE_TOO_LARGE;
+
+    char* data = malloc((size_t)size + 1);
+    if (!data) return ERR_OUT_OF_MEMORY;
+    err_t err = fread(data, 1, (size_t)size, in) == size ? ERR_OK : ERR_IO;
+    data[size] = '\0';
+
+    for (size_t pos = 0; err == ERR_OK && pos < size;) {
+        char* end = NULL;
+        unsigned long long len = strtoull(data + pos, &end, 10);
+        if (len == 0 || len > size - pos || *end != ' ' || data[pos + len - 1] != '\n') {
+            err = ERR_INVALID_ARGUMENT;
+            break;
+        }
+        const char* key = end + 1;
+        const char* value_end = data + pos + len - 1;
+        if (strncmp(key, "path=", 5) == 0) {
+            size_t value_len = (size_t)(value_end - (key + 5));
+            if (value_len > TAR_MAX_NAME) {
+                err = ERR_INVALID_ARGUMENT;
+                break;
+            }
+            memcpy(out_path, key + 5, value_len);
+            out_path[value_len] = '\0';
+            *out_found = true;
+        }
+        pos += (size_t)len;
+    }
+    free(data);
+
+    if (err == ERR_OK && fseeko(in, (off_t)padding_for(size), SEEK_CUR) != 0) {
+        // Not seekable: read the padding instead
+        char pad[TAR_BLOCK_SIZE];
+        size_t padding = (size_t)padding_for(size);
+        if (fread(pad, 1, padding, in) != padding) err = ERR_IO;
+    }
+    return err;
+}
+
+err_t tar_read_header(FILE* in, tar_entry_t* out_entry, bool* out_end) {
+    if (!in || !out_entry || !out_end) return ERR_INVALID_ARGUMENT;
+    *out_end = false;
+
+    char pax_path[TAR_MAX_NAME + 1];
+    bool have_pax_path = false;
+
+    for (;;) {
+        tar_header_t header;
+        err_t err = read_block(in, &header);
+        if (err != ERR_OK) return err;
+
+        if (memcmp(&header, g_zero_block, TAR_BLOCK_SIZE) == 0) {
+            *out_end = true;
+            return ERR_OK;
+        }
+
+        uint64_t checksum = 0;
+        if (!get_octal(header.checksum, sizeof(header.checksum), &checksum) ||
+            checksum != header_checksum(&header)) {
+            return ERR_INVALID_ARGUMENT;
+        }
+
+        uint64_t size = 0;
+        uint64_t mode = 0;
+        uint64_t mtime = 0;
+        if (!get_octal(header.size, sizeof(header.size), &size) ||
+            !get_octal(header.mode, sizeof(header.mode), &mode) ||
+            !get_octal(header.mtime, sizeof(header.mtime), &mtime)) {
+            return ERR_INVALID_ARGUMENT;
+        }
+
+        if (header.typeflag == 'x') {
+            err = read_pax_path(in, size, pax_path, &have_pax_path);
+            if (err != ERR_OK) return err;
+            continue;
+        }
+        if (header.typeflag == 'g') {
+            tar_entry_t global = { .size = size };
+            err = tar_read_data(in, &global, NULL);
+            if (err != ERR_OK) return err;
+            continue;
+        }
+
+        memset(out_entry, 0, sizeof(*out_entry));
+        if (have_pax_path) {
+            memcpy(out_entry->name, pax_path, strlen(pax_path) + 1);
+        } else {
+            char name[sizeof(header.name) + 1];
+            char prefix[sizeof(header.prefix) + 1];
+            memcpy(name, header.name, sizeof(header.name));
+            name[sizeof(header.name)] = '\0';
+            memcpy(prefix, header.prefix, sizeof(header.prefix));
+            prefix[sizeof(header.prefix)] = '\0';
+            if (prefix[0] && memcmp(header.magic, "ustar", 5) == 0) {
+                snprintf(out_entry->name, sizeof(out_entry->name), "%s/%s", prefix, name);
+            } else {
+                snprintf(out_entry->name, sizeof(out_entry->name), "%s", name);
+            }
+        }
+
+        out_entry->type = header.typeflag == '0' || header.typeflag == '\0' ? TAR_TYPE_FILE
+                        : header.typeflag == '5' ? TAR_TYPE_DIRECTORY
+                        : TAR_TYPE_OTHER;
+        out_entry->size = size;
+        out_entry->mode = (uint32_t)mode;
+        out_entry->mtime = mtime;
+        return ERR_OK;
+    }
+}
+
+err_t tar_read_data(FILE* in, const tar_entry_t* entry, FILE* out) {
+    if (!in || !entry) return ERR_INVALID_ARGUMENT;
+
+    char* buffer = malloc(TAR_COPY_CHUNK);
+    if (!buffer) return ERR_OUT_OF_MEMORY;
+
+    // The padding is read along with the data and not copied
+    uint64_t total = entry->size + padding_for(entry->size);
+    uint64_t done = 0;
+    err_t err = ERR_OK;
+    while (done < total) {
+        size_t want = total - done < TAR_COPY_CHUNK ? (size_t)(total - done) : TAR_COPY_CHUNK;
+        if (fread(buffer, 1, want, in) != want) {
+            err = ERR_IO;
+            break;
+        }
+        if (out && done < entry->size) {
+            size_t data = entry->size - done < want ? (size_t)(entry->size - done) : want;
+            if (fwrite(buffer, 1, data, out) != data) {
+                err = ERR_WRITE_FAILED;
+                break;
+            }
+        }
+        done += want;
+    }
+    free(buffer);
+    return err;
+}
@@ -0,0 +1,210 @@
+// websocket.c - WebSocket framing for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "utils/websocket.h"
+
+#include <string.h>
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+// ============================================================================
+// Handshake: base64(SHA-1(key + GUID)). SHA-1 is only needed here, so it
+// stays private to this file.
+// ============================================================================
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_block(uint32_t state[5], const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = ROTL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = ROTL(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROTL(b, 30);
+        b = a;
+        a = t;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+// Messages here are short (a key and the GUID), so one buffer will do
+static void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    size_t full = len / 64 * 64;
+    for (size_t i = 0; i < full; i += 64) sha1_block(state, data + i);
+
+    uint8_t tail[128] = {0};
+    size_t rest = len - full;
+    memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    size_t tail_len = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) tail[tail_len - 1 - (size_t)i] = (uint8_t)(bits >> (i * 8));
+    for (size_t i = 0; i < tail_len; i += 64) sha1_block(state, tail + i);
+
+    for (int i = 0; i < 5; i++) {
+        out[i * 4] = (uint8_t)(state[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)state[i];
+    }
+}
+
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void base64_encode(const uint8_t* data, size_t len, char* out) {
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t n = (uint32_t)data[i] << 16;
+        if (i + 1 < len) n |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) n |= data[i + 2];
+        out[o++] = BASE64[(n >> 18) & 63];
+        out[o++] = BASE64[(n >> 12) & 63];
+        out[o++] = i + 1 < len ? BASE64[(n >> 6) & 63] : '=';
+        out[o++] = i + 2 < len ? BASE64[n & 63] : '=';
+    }
+    out[o] = '\0';
+}
+
+// 16 bytes encode to 22 characters and "=="
+static bool is_base64_nonce(str_t key) {
+    if (key.len != 24 || key.data[22] != '=' || key.data[23] != '=') return false;
+    for (uint32_t i = 0; i < 22; i++) {
+        if (!strchr(BASE64, key.data[i]) || key.data[i] == '\0') return false;
+    }
+    return true;
+}
+
+err_t ws_accept_key(str_t client_key, char out[WS_ACCEPT_KEY_LEN + 1]) {
+    if (!out || !is_base64_nonce(client_key)) return ERR_INVALID_ARGUMENT;
+
+    uint8_t input[24 + sizeof(WS_GUID) - 1];
+    memcpy(input, client_key.data, 24);
+    memcpy(input + 24, WS_GUID, sizeof(WS_GUID) - 1);
+
+    uint8_t digest[20];
+    sha1(input, sizeof(input), digest);
+    base64_encode(digest, sizeof(digest), out);
+    return ERR_OK;
+}
+
+// ============================================================================
+// Frames
+// ============================================================================
+
+size_t ws_frame_header(uint8_t out[WS_MAX_HEADER_LEN], ws_opcode_t opcode, bool fin,
+                       uint64_t length, const uint8_t mask[4]) {
+    size_t n = 0;
+    out[n++] = (uint8_t)((fin ? 0x80 : 0) | (opcode & 0x0F));
+
+    uint8_t mask_bit = mask ? 0x80 : 0;
+    if (length < 126) {
+        out[n++] = mask_bit | (uint8_t)length;
+    } else if (length <= 0xFFFF) {
+        out[n++] = mask_bit | 126;
+        out[n++] = (uint8_t)(length >> 8);
+        out[n++] = (uint8_t)length;
+    } else {
+        out[n++] = mask_bit | 127;
+        for (int i = 7; i >= 0; i--) out[n++] = (uint8_t)(length >> (i * 8));
+    }
+
+    if (mask) {
+        memcpy(out + n, mask, 4);
+        n += 4;
+    }
+    return n;
+}
+
+void ws_mask(uint8_t* data, size_t len, const uint8_t mask[4], size_t offset) {
+    for (size_t i = 0; i < len; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
+
+err_t ws_frame_parse(uint8_t* data, size_t len, bool require_mask, uint64_t max_payload,
+                     ws_frame_t* out_frame, size_t* out_consumed) {
+    if (!data || !out_frame || !out_consumed) return ERR_INVALID_ARGUMENT;
+    *out_consumed = 0;
+    if (len < 2) return ERR_OK;
+
+    bool fin = (data[0] & 0x80) != 0;
+    ws_opcode_t opcode = (ws_opcode_t)(data[0] & 0x0F);
+    bool masked = (data[1] & 0x80) != 0;
+    uint64_t length = data[1] & 0x7F;
+
+    // No extensions are negotiated, so reserved bits must be clear
+    if (data[0] & 0x70) return ERR_INVALID_ARGUMENT;
+    switch (opcode) {
+        case WS_OP_CONTINUATION: case WS_OP_TEXT: case WS_OP_BINARY:
+        case WS_OP_CLOSE: case WS_OP_PING: case WS_OP_PONG:
+            break;
+        default:
+            return ERR_INVALID_ARGUMENT;
+    }
+    if (require_mask && !masked) return ERR_INVALID_ARGUMENT;
+
+    size_t header = 2;
+    if (length == 126) {
+        if (len < 4) return ERR_OK;
+        length = (uint64_t)data[2] << 8 | data[3];
+        header = 4;
+    } else if (length == 127) {
+        if (len < 10) return ERR_OK;
+        length = 0;
+        for (int i = 0; i < 8; i++) length = length << 8 | data[2 + i];
+        if (length >> 63) return ERR_INVALID_ARGUMENT;
+        header = 10;
+    }
+
+    // Control frames are short and never fragmented
+    if (ws_opcode_is_control(opcode) && (length > 125 || !fin)) return ERR_INVALID_ARGUMENT;
+    if (length > max_payload) return ERR_FILE_TOO_LARGE;
+
+    const uint8_t* mask = NULL;
+    if (masked) {
+        if (len < header + 4) return ERR_OK;
+        mask = data + header;
+        header += 4;
+    }
+    if (len - header < length) return ERR_OK;
+
+    uint8_t* payload = data + header;
+    if (mask) ws_mask(payload, (size_t)length, mask, 0);
+
+    out_frame->opcode = opcode;
+    out_frame->fin = fin;
+    out_frame->payload = payload;
+    out_frame->length = length;
+    *out_consumed = header + (size_t)length;
+    return ERR_OK;
+}
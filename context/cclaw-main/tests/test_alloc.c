@@ -0,0 +1,162 @@
+// test_alloc.c - Allocator accounting tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/alloc.h"
+#include "core/error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+static bool test_tracking_allocator(void) {
+    printf("Testing tracking allocator...\n");
+
+    tracking_allocator_t* tracker = tracking_create(NULL);
+    TEST(tracker != NULL);
+
+    allocator_t* a = &tracker->base;
+    char* p = alloc(a, 100);
+    TEST(p != NULL);
+
+    alloc_stats_t stats;
+    tracking_get_stats(tracker, &stats);
+    TEST(stats.allocation_count == 1);
+    TEST(stats.live_count == 1);
+    TEST(stats.live_bytes >= 100);
+
+    p = realloc_ptr(a, p, 100, 5000);
+    TEST(p != NULL);
+    tracking_get_stats(tracker, &stats);
+    TEST(stats.live_bytes >= 5000);
+    TEST(stats.peak_bytes >= 5000);
+    TEST(stats.allocation_count == 1);
+
+    free_ptr(a, p, 5000);
+    tracking_get_stats(tracker, &stats);
+    TEST(stats.live_bytes == 0);
+    TEST(stats.live_count == 0);
+    TEST(stats.peak_bytes >= 5000);
+
+    str_t s = alloc_str_cstr(a, "hello");
+    TEST(str_equal_cstr(s, "hello"));
+    free_str(a, s);
+
+    int* zeros = alloc_array(a, sizeof(int), 64);
+    TEST(zeros != NULL);
+    for (int i = 0; i < 64; i++) TEST(zeros[i] == 0);
+    free_ptr(a, zeros, sizeof(int) * 64);
+
+    tracking_get_stats(tracker, &stats);
+    TEST(stats.live_count == 0);
+
+    allocator_destroy(a);
+    return true;
+}
+
+static bool test_subsystem_accounting(void) {
+    printf("Testing subsystem accounting...\n");
+
+    allocator_t* http = allocator_subsystem(ALLOC_SUBSYS_HTTP);
+    allocator_t* tools = allocator_subsystem(ALLOC_SUBSYS_TOOLS);
+    TEST(http != tools);
+    TEST(strcmp(alloc_subsystem_name(ALLOC_SUBSYS_HTTP), "http") == 0);
+
+    alloc_stats_t before;
+    alloc_subsystem_stats(ALLOC_SUBSYS_HTTP, &before);
+
+    void* p = alloc_zeroed(http, 1 << 16);
+    TEST(p != NULL);
+
+    alloc_stats_t during;
+    alloc_subsystem_stats(ALLOC_SUBSYS_HTTP, &during);
+    TEST(during.live_bytes >= before.live_bytes + (1 << 16));
+
+    alloc_stats_t other;
+    alloc_subsystem_stats(ALLOC_SUBSYS_TOOLS, &other);
+    TEST(other.live_bytes == 0);
+
+    // Destroying a subsystem allocator must not free the static tracker
+    allocator_destroy(http);
+
+    char metrics[8192];
+    size_t len = alloc_subsystem_metrics(metrics, sizeof(metrics));
+    TEST(len > 0 && len < sizeof(metrics));
+    TEST(strstr(metrics, "cclaw_alloc_live_bytes{subsystem=\"http\"}") != NULL);
+    TEST(strstr(metrics, "# TYPE cclaw_alloc_bytes_total counter") != NULL);
+
+    free_ptr(http, p, 1 << 16);
+
+    alloc_stats_t after;
+    alloc_subsystem_stats(ALLOC_SUBSYS_HTTP, &after);
+    TEST(after.live_bytes == before.live_bytes);
+    return true;
+}
+
+static bool test_sampler(void) {
+    printf("Testing growth sampler...\n");
+
+    alloc_sampler_t sampler;
+    alloc_sampler_init(&sampler, 1000, 0);
+
+    char* grown = alloc(allocator_subsystem(ALLOC_SUBSYS_JSON), 4096);
+    TEST(grown != NULL);
+
+    char log[1024] = {0};
+    FILE* out = fmemopen(log, sizeof(log), "w");
+    TEST(out != NULL);
+
+    TEST(!alloc_sampler_tick(&sampler, 500, out));
+    TEST(alloc_sampler_tick(&sampler, 1000, out));
+    fclose(out);
+
+    TEST(strstr(log, "[alloc] json grew by") != NULL);
+    TEST(strstr(log, "tools") == NULL);
+
+    free_ptr(allocator_subsystem(ALLOC_SUBSYS_JSON), grown, 4096);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Allocator Tests\n");
+    printf("=====================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_tracking_allocator()) {
+        printf("✓ test_tracking_allocator passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_tracking_allocator failed\n\n");
+        failed++;
+    }
+
+    if (test_subsystem_accounting()) {
+        printf("✓ test_subsystem_accounting passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_subsystem_accounting failed\n\n");
+        failed++;
+    }
+
+    if (test_sampler()) {
+        printf("✓ test_sampler passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_sampler failed\n\n");
+        failed++;
+    }
+
+    printf("=====================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -2,13 +2,16 @@
 // SPDX-License-Identifier: MIT
 
 #include "cclaw.h"
+#include "core/alloc.h"
 #include "core/channel.h"
 #include "core/types.h"
 #include "core/error.h"
+#include "core/intern.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 // Test utilities (copied from basic.c)
@@ -301,6 +304,123 @@ static bool test_health_check(void) {
     return true;
 }
 
+// Counters for the CLI framing test (written by the listener thread)
+static uint32_t g_cli_messages = 0;
+static uint32_t g_cli_last_len = 0;
+static char g_cli_last_head[16];
+
+static void cli_message_callback(channel_message_t* msg, void* user_data) {
+    (void)user_data;
+    size_t head = msg->content.len < sizeof(g_cli_last_head) - 1 ? msg->content.len
+                                                                  : sizeof(g_cli_last_head) - 1;
+    memcpy(g_cli_last_head, msg->content.data, head);
+    g_cli_last_head[head] = '\0';
+    __atomic_store_n(&g_cli_last_len, msg->content.len, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_cli_messages, 1, __ATOMIC_RELEASE);
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// Test CLI line framing: a large multi-line paste is one message, a typed
+// line is another, and an unterminated line is delivered on EOF
+static bool test_cli_framing(void) {
+    err_t err = channel_registry_init();
+    TEST_ASSERT(err == ERR_OK, "Failed to initialize channel registry");
+
+    // Feed the channel's stdin from a pipe
+    int input[2];
+    TEST_ASSERT(pipe(input) == 0, "Failed to create input pipe");
+    int saved_stdin = dup(STDIN_FILENO);
+    TEST_ASSERT(dup2(input[0], STDIN_FILENO) >= 0, "Failed to redirect stdin");
+    close(input[0]);
+
+    channel_config_t config = channel_config_default();
+    config.name = str_dup_cstr("cli-test", NULL);
+    config.type = str_dup_cstr("cli", NULL);
+    config.host = str_dup_cstr("localhost", NULL);
+
+    channel_t* channel = NULL;
+    err = channel_create("cli", &config, &channel);
+    TEST_ASSERT(err == ERR_OK, "Failed to create CLI channel");
+    TEST_ASSERT(channel->vtable->init(channel) == ERR_OK, "Failed to initialize CLI channel");
+    err = channel->vtable->start_listening(channel, cli_message_callback, NULL);
+    TEST_ASSERT(err == ERR_OK, "Failed to start CLI listener");
+
+    // 2000 lines, ~120 KB: larger than both the old 4 KB buffer and a pipe
+    size_t paste_cap = 2000 * 64;
+    char* paste = malloc(paste_cap);
+    TEST_ASSERT(paste != NULL, "Failed to allocate paste");
+    size_t paste_len = 0;
+    for (int i = 0; i < 2000; i++) {
+        paste_len += (size_t)snprintf(paste + paste_len, paste_cap - paste_len,
+                                      "line %04d of a pasted file with some padding text\n", i);
+    }
+    size_t off = 0;
+    while (off < paste_len) {
+        ssize_t n = write(input[1], paste + off, paste_len - off);
+        TEST_ASSERT(n > 0, "Failed to write paste");
+        off += (size_t)n;
+    }
+    free(paste);
+
+    for (int i = 0; i < 200 && __atomic_load_n(&g_cli_messages, __ATOMIC_ACQUIRE) < 1; i++) sleep_ms(5);
+    sleep_ms(100);
+    TEST_ASSERT(__atomic_load_n(&g_cli_messages, __ATOMIC_ACQUIRE) == 1, "Paste should be one message");
+    TEST_ASSERT(g_cli_last_len == paste_len - 1, "Paste should keep all but the final newline");
+
+    TEST_ASSERT(write(input[1], "hello\r\n", 7) == 7, "Failed to write line");
+    for (int i = 0; i < 200 && __atomic_load_n(&g_cli_messages, __ATOMIC_ACQUIRE) < 2; i++) sleep_ms(5);
+    TEST_ASSERT(g_cli_messages == 2, "Typed line should be its own message");
+    TEST_ASSERT(strcmp(g_cli_last_head, "hello") == 0, "Line terminator should be trimmed");
+
+    // Unterminated input is flushed when stdin closes
+    TEST_ASSERT(write(input[1], "bye", 3) == 3, "Failed to write tail");
+    close(input[1]);
+    for (int i = 0; i < 200 && __atomic_load_n(&g_cli_messages, __ATOMIC_ACQUIRE) < 3; i++) sleep_ms(5);
+    TEST_ASSERT(g_cli_messages == 3, "Tail should be delivered on EOF");
+    TEST_ASSERT(strcmp(g_cli_last_head, "bye") == 0, "Tail content mismatch");
+
+    channel->vtable->stop_listening(channel);
+    channel->vtable->destroy(channel);
+    channel_registry_shutdown();
+
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+    return true;
+}
+
+// Test message arrays are released through the channels allocator, with
+// their interned channel names left alone
+static bool test_message_array_free(void) {
+    alloc_stats_t before;
+    alloc_subsystem_stats(ALLOC_SUBSYS_CHANNELS, &before);
+
+    allocator_t* alloc = allocator_subsystem(ALLOC_SUBSYS_CHANNELS);
+    channel_message_t* messages = alloc_array(alloc, sizeof(channel_message_t), 2);
+    TEST_ASSERT(messages != NULL, "Failed to allocate messages");
+    str_t channel_name = str_intern(STR_LIT("array-test"));
+    for (uint32_t i = 0; i < 2; i++) {
+        messages[i].id = alloc_str(alloc, STR_LIT("msg-1"));
+        messages[i].sender = alloc_str(alloc, STR_LIT("alice"));
+        messages[i].content = alloc_str(alloc, STR_LIT("hello"));
+        messages[i].channel = channel_name;
+    }
+    channel_message_array_free(messages, 2);
+
+    alloc_stats_t after;
+    alloc_subsystem_stats(ALLOC_SUBSYS_CHANNELS, &after);
+    TEST_ASSERT(after.live_count == before.live_count, "Message array should be fully released");
+    TEST_ASSERT(after.live_bytes == before.live_bytes, "Message array bytes should be released");
+
+    str_t again = str_intern(STR_LIT("array-test"));
+    TEST_ASSERT(again.data == channel_name.data && strcmp(again.data, "array-test") == 0,
+                "Interned channel name should survive");
+    return true;
+}
+
 // Main test runner
 int main(void) {
     printf("CClaw Channel System Test Suite\n");
@@ -319,6 +439,8 @@ int main(void) {
     TEST_RUN("channel_manager", test_channel_manager);
     TEST_RUN("message_sending", test_message_sending);
     TEST_RUN("health_check", test_health_check);
+    TEST_RUN("cli_framing", test_cli_framing);
+    TEST_RUN("message_array_free", test_message_array_free);
 
     // Summary
     printf("\n");
@@ -0,0 +1,329 @@
+// test_delegate.c - Worker pool and sub-agent delegation tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/delegate.h"
+#include "core/alloc.h"
+#include "utils/clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+// ============================================================================
+// Fake provider: answers after CALL_MS, or keeps asking for tools when the
+// prompt starts with "loop"
+// ============================================================================
+
+#define CALL_MS 100
+
+static uint32_t g_creates = 0;
+static uint32_t g_in_flight = 0;
+static uint32_t g_max_in_flight = 0;
+
+static const provider_vtable_t fake_vtable;
+
+static err_t fake_create(const provider_config_t* config, provider_t** out_provider) {
+    provider_t* provider = calloc(1, sizeof(provider_t));
+    if (!provider) return ERR_OUT_OF_MEMORY;
+    provider->vtable = &fake_vtable;
+    provider->config = *config;
+    __atomic_add_fetch(&g_creates, 1, __ATOMIC_RELAXED);
+    *out_provider = provider;
+    return ERR_OK;
+}
+
+static void fake_destroy(provider_t* provider) {
+    free(provider);
+}
+
+static err_t fake_chat(provider_t* provider, const chat_message_t* messages, uint32_t message_count,
+                       const tool_def_t* tools, uint32_t tool_count, const char* model,
+                       double temperature, chat_response_t** out_response) {
+    uint32_t now = __atomic_add_fetch(&g_in_flight, 1, __ATOMIC_SEQ_CST);
+    uint32_t seen = __atomic_load_n(&g_max_in_flight, __ATOMIC_SEQ_CST);
+    while (now > seen &&
+           !__atomic_compare_exchange_n(&g_max_in_flight, &seen, now, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+    }
+    usleep(CALL_MS * 1000);
+    __atomic_sub_fetch(&g_in_flight, 1, __ATOMIC_SEQ_CST);
+
+    // The first user message is the task prompt
+    str_t prompt = STR_NULL;
+    for (uint32_t i = 0; i < message_count; i++) {
+        if (messages[i].role == CHAT_ROLE_USER) {
+            prompt = messages[i].content;
+            break;
+        }
+    }
+
+    chat_response_t* response = chat_response_create();
+    response->prompt_tokens = 10;
+    response->completion_tokens = 5;
+
+    if (prompt.len >= 4 && memcmp(prompt.data, "loop", 4) == 0) {
+        response->tool_calls = alloc_str(PROVIDER_ALLOC, STR_LIT("[]"));
+    } else if (prompt.len >= 4 && memcmp(prompt.data, "long", 4) == 0) {
+        char* text = malloc(5000);
+        memset(text, 'x', 5000);
+        response->content = alloc_str(PROVIDER_ALLOC, (str_t){ .data = text, .len = 5000 });
+        free(text);
+    } else {
+        response->content = str_format(PROVIDER_ALLOC, "done: %.*s", (int)prompt.len, prompt.data);
+    }
+
+    *out_response = response;
+    return ERR_OK;
+}
+
+static const provider_vtable_t fake_vtable = {
+    .create = fake_create,
+    .destroy = fake_destroy,
+    .chat = fake_chat,
+};
+
+static agent_t* parent_create(void) {
+    agent_t* parent = NULL;
+    if (agent_create(NULL, &parent) != ERR_OK) return NULL;
+
+    provider_config_t config = { .name = STR_LIT("fake") };
+    if (fake_create(&config, &parent->ctx->provider) != ERR_OK) {
+        agent_destroy(parent);
+        return NULL;
+    }
+    return parent;
+}
+
+static void parent_destroy(agent_t* parent) {
+    provider_free(parent->ctx->provider);
+    parent->ctx->provider = NULL;
+    agent_destroy(parent);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+#define POOL_JOBS 200
+
+static uint32_t g_job_runs = 0;
+static uint32_t g_bad_index = 0;
+
+static void count_job(void* arg, uint32_t worker_index) {
+    if (worker_index >= 4) __atomic_add_fetch(&g_bad_index, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_job_runs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch((uint32_t*)arg, 1, __ATOMIC_RELAXED);
+}
+
+static bool test_worker_pool(void) {
+    printf("Testing worker pool...\n");
+
+    worker_pool_t* pool = NULL;
+    TEST_OK(worker_pool_create(4, POOL_JOBS, &pool));
+    TEST(worker_pool_size(pool) == 4);
+
+    uint32_t counter = 0;
+    worker_group_t group;
+    worker_group_init(&group, pool);
+    for (int i = 0; i < POOL_JOBS; i++) {
+        TEST_OK(worker_group_submit(&group, count_job, &counter));
+    }
+    worker_group_wait(&group);
+    worker_group_destroy(&group);
+
+    TEST(counter == POOL_JOBS);
+    TEST(g_bad_index == 0);
+
+    // Plain submissions still run before destroy returns
+    uint32_t loose = 0;
+    for (int i = 0; i < 10; i++) {
+        TEST_OK(worker_pool_submit(pool, count_job, &loose));
+    }
+    worker_pool_destroy(pool);
+    TEST(loose == 10);
+    TEST(g_job_runs == POOL_JOBS + 10);
+    return true;
+}
+
+static bool test_delegate_concurrent(void) {
+    printf("Testing concurrent delegation...\n");
+
+    agent_t* parent = parent_create();
+    TEST(parent != NULL);
+    g_creates = 0;
+
+    delegator_t* delegator = NULL;
+    TEST_OK(delegator_create(parent, 4, &delegator));
+
+    delegate_task_t tasks[4] = {
+        { .name = STR_LIT("a"), .prompt = STR_LIT("alpha") },
+        { .name = STR_LIT("b"), .prompt = STR_LIT("beta") },
+        { .name = STR_LIT("c"), .prompt = STR_LIT("gamma") },
+        { .name = STR_LIT("d"), .prompt = STR_LIT("delta") },
+    };
+    delegate_result_t results[4];
+
+    uint64_t started = clock_monotonic_ms();
+    TEST_OK(delegator_run(delegator, tasks, 4, results));
+    uint64_t elapsed = clock_monotonic_ms() - started;
+
+    // All four ran side by side on their own provider clones
+    TEST(elapsed < 3 * CALL_MS);
+    TEST(g_max_in_flight == 4);
+    TEST(g_creates == 4);
+
+    TEST(results[2].status == ERR_OK);
+    TEST(str_equal_cstr(results[2].output, "done: gamma"));
+    TEST(results[2].tokens == 15);
+    TEST(!results[2].truncated);
+
+    str_t summary = delegate_results_format(tasks, results, 4);
+    TEST(strstr(summary.data, "### 1 a [ok, 15 tokens, ") != NULL);
+    TEST(strstr(summary.data, "done: delta") != NULL);
+    free((void*)summary.data);
+    delegate_results_free(results, 4);
+
+    // Providers are kept for the next run; the parent saw nothing
+    TEST_OK(delegator_run(delegator, tasks, 2, results));
+    delegate_results_free(results, 2);
+    TEST(g_creates == 4);
+    TEST(parent->ctx->session_count == 0);
+
+    delegator_destroy(delegator);
+    parent_destroy(parent);
+    return true;
+}
+
+static bool test_delegate_budgets(void) {
+    printf("Testing delegation budgets...\n");
+
+    agent_t* parent = parent_create();
+    TEST(parent != NULL);
+
+    delegator_t* delegator = NULL;
+    TEST_OK(delegator_create(parent, 4, &delegator));
+
+    delegate_task_t tasks[4] = {
+        { .prompt = STR_LIT("loop tokens"), .max_iterations = 50, .token_budget = 40 },
+        { .prompt = STR_LIT("loop deadline"), .max_iterations = 50, .timeout_ms = CALL_MS * 2 + 50 },
+        { .prompt = STR_LIT("loop iterations"), .max_iterations = 2 },
+        { .prompt = STR_LIT("long answer") },
+    };
+    delegate_result_t results[4];
+    TEST_OK(delegator_run(delegator, tasks, 4, results));
+
+    TEST(results[0].status == ERR_CANCELLED);
+    TEST(results[0].tokens == 45);     // Third call crosses 40
+    TEST(strstr(results[0].output.data, "token budget") != NULL);
+
+    TEST(results[1].status == ERR_TIMEOUT);
+    TEST(results[1].tokens == 45);
+
+    TEST(results[2].status == ERR_CANCELLED);
+    TEST(strstr(results[2].output.data, "no answer") != NULL);
+
+    TEST(results[3].status == ERR_OK);
+    TEST(results[3].truncated);
+    TEST(results[3].output.len == DELEGATE_RESULT_MAX_CHARS);
+
+    delegate_results_free(results, 4);
+    delegator_destroy(delegator);
+    parent_destroy(parent);
+    return true;
+}
+
+static bool test_delegate_tool(void) {
+    printf("Testing delegate tool...\n");
+
+    agent_t* parent = parent_create();
+    TEST(parent != NULL);
+
+    tool_t* tool = NULL;
+    TEST_OK(delegate_tool_get_vtable()->create(&tool));
+
+    tool_context_t context = tool_context_default();
+    TEST(tool->vtable->init(tool, &context) != ERR_OK);     // No parent agent
+    context.user_data = parent;
+    TEST_OK(tool->vtable->init(tool, &context));
+
+    str_t args = STR_LIT("{\"tasks\":[{\"name\":\"docs\",\"prompt\":\"summarize README\"},"
+                         "{\"prompt\":\"list TODOs\",\"max_iterations\":3}]}");
+    tool_result_t result = tool_result_create();
+    TEST_OK(tool->vtable->execute(tool, &args, &result));
+    TEST(result.success);
+    TEST(strstr(result.content.data, "### 1 docs [ok") != NULL);
+    TEST(strstr(result.content.data, "done: summarize README") != NULL);
+    TEST(strstr(result.content.data, "### 2 [ok") != NULL);
+    tool_result_free(&result);
+
+    args = STR_LIT("{\"tasks\":[{\"name\":\"missing prompt\"}]}");
+    TEST_OK(tool->vtable->execute(tool, &args, &result));
+    TEST(!result.success);
+    tool_result_free(&result);
+
+    args = STR_LIT("{\"tasks\":[]}");
+    TEST_OK(tool->vtable->execute(tool, &args, &result));
+    TEST(!result.success);
+    tool_result_free(&result);
+
+    tool_free(tool);
+    parent_destroy(parent);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Delegation Tests\n");
+    printf("======================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_worker_pool()) {
+        printf("✓ test_worker_pool passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_worker_pool failed\n\n");
+        failed++;
+    }
+
+    if (test_delegate_concurrent()) {
+        printf("✓ test_delegate_concurrent passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_delegate_concurrent failed\n\n");
+        failed++;
+    }
+
+    if (test_delegate_budgets()) {
+        printf("✓ test_delegate_budgets passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_delegate_budgets failed\n\n");
+        failed++;
+    }
+
+    if (test_delegate_tool()) {
+        printf("✓ test_delegate_tool passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_delegate_tool failed\n\n");
+        failed++;
+    }
+
+    printf("======================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
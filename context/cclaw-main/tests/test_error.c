@@ -0,0 +1,225 @@
+// test_error.c - Error context ring tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/error.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+static err_t open_config(const char* path) {
+    return ERROR_SET(ERR_FILE_NOT_FOUND, "cannot open %s", path);
+}
+
+static err_t load_config(void) {
+    TRY_MSG(open_config("/etc/cclaw.json"), "loading configuration");
+    return ERR_OK;
+}
+
+static bool test_error_lazy_format(void) {
+    printf("Testing lazy error formatting...\n");
+    error_stack_clear();
+
+    char name[16];
+    snprintf(name, sizeof(name), "sqlite");
+    str_t key = STR_LIT("user_pref_theme");
+
+    err_t err = ERROR_SET(ERR_MEMORY, "%s: key '%.*s' row %d of %zu (%.2f%%) at %p",
+                          name, (int)key.len, key.data, -7, (size_t)42, 99.5, (void*)0);
+    TEST(err == ERR_MEMORY);
+
+    // Nothing formatted yet, and the string argument was copied
+    const error_ctx_t* last = error_last();
+    TEST(last != NULL);
+    TEST(last->code == ERR_MEMORY);
+    TEST(str_empty(last->message));
+    memset(name, 'x', sizeof(name) - 1);
+
+    char expected[128];
+    snprintf(expected, sizeof(expected), "sqlite: key 'user_pref_theme' row -7 of 42 (99.50%%) at %p",
+             (void*)0);
+    str_t message = error_message(last);
+    TEST(str_equal_cstr(message, expected));
+
+    // Formatting happens once; later reads return the same view
+    TEST(error_message(last).data == message.data);
+
+    // Wider integer and width/precision forms
+    ERROR_SET(ERR_FAILED, "[%*d|%-4s|%llx|%hhu|%5.1Lf|%c]", 4, 12, "ab",
+              0x1234567890ULL, 300, (long double)2.25, 'z');
+    TEST(str_equal_cstr(error_message(error_last()), "[  12|ab  |1234567890|44|  2.2|z]"));
+
+    return true;
+}
+
+static bool test_error_chain(void) {
+    printf("Testing error cause chaining...\n");
+    error_stack_clear();
+
+    TEST(load_config() == ERR_FILE_NOT_FOUND);
+
+    const error_ctx_t* outer = error_last();
+    TEST(outer != NULL);
+    TEST(str_equal_cstr(error_message(outer), "loading configuration"));
+    TEST(outer->cause != NULL);
+    TEST(str_equal_cstr(error_message(outer->cause), "cannot open /etc/cclaw.json"));
+    TEST(outer->line > outer->cause->line);
+
+    ERROR_WRAP(ERR_CONFIG_INVALID, "startup aborted");
+    char buf[512];
+    size_t len = error_describe(error_last(), buf, sizeof(buf));
+    TEST(len == strlen(buf));
+    TEST(strstr(buf, "startup aborted") == buf + strlen(error_to_string(ERR_CONFIG_INVALID)) + 2);
+    TEST(strstr(buf, "; caused by: ") != NULL);
+    TEST(strstr(buf, "cannot open /etc/cclaw.json (") != NULL);
+
+    // Truncation reports the full length
+    char small[8];
+    TEST(error_describe(error_last(), small, sizeof(small)) == len);
+    TEST(strlen(small) == sizeof(small) - 1);
+
+    // An unrelated earlier error is not adopted as a cause
+    error_stack_clear();
+    ERROR_SET(ERR_TIMEOUT, "handled elsewhere");
+    error_propagate(ERR_IO, STR_LIT("fresh failure"), __FILE__, __LINE__);
+    TEST(error_last()->cause == NULL);
+
+    // Causes built with ERR() on the stack are copied into the ring
+    error_ctx_t root = ERR(ERR_NETWORK, "connection reset");
+    error_set_with_cause(ERR_PROVIDER, STR_LIT("request failed"), __FILE__, __LINE__, &root);
+    TEST(error_last()->cause != &root);
+    TEST(str_equal_cstr(error_message(error_last()->cause), "connection reset"));
+
+    return true;
+}
+
+static bool test_error_ring(void) {
+    printf("Testing error ring overflow...\n");
+    error_stack_clear();
+
+    ERROR_SET(ERR_IO, "root");
+    ERROR_WRAP(ERR_MEMORY, "wrapped");
+    for (int i = 0; i < ERROR_RING_CAPACITY - 1; i++) {
+        ERROR_SET(ERR_FAILED, "filler %d", i);
+    }
+
+    // "root" has been overwritten; the link to it must be cut, not dangling
+    error_stack_t* stack = error_stack_get();
+    TEST(stack->count == ERROR_RING_CAPACITY);
+    bool found = false;
+    for (uint32_t i = 0; i < ERROR_RING_CAPACITY; i++) {
+        error_ctx_t* ctx = &stack->records[i].ctx;
+        if (ctx->code == ERR_MEMORY) {
+            found = true;
+            TEST(ctx->cause == NULL);
+        }
+    }
+    TEST(found);
+
+    // Pop returns newest first
+    error_ctx_t* top = error_stack_pop();
+    TEST(top != NULL);
+    TEST(str_equal_cstr(top->message, "filler 14"));
+    TEST(stack->count == ERROR_RING_CAPACITY - 1);
+
+    // More arguments than the record holds are formatted eagerly
+    ERROR_SET(ERR_FAILED, "%d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+    TEST(str_equal_cstr(error_last()->message, "1 2 3 4 5 6 7 8 9 10"));
+
+    error_stack_clear();
+    TEST(error_last() == NULL);
+    TEST(error_stack_pop() == NULL);
+
+    return true;
+}
+
+static void* thread_worker(void* arg) {
+    int id = *(int*)arg;
+    for (int i = 0; i < 1000; i++) {
+        ERROR_SET(ERR_CHANNEL, "worker %d iteration %d", id, i);
+    }
+
+    char expected[64];
+    snprintf(expected, sizeof(expected), "worker %d iteration 999", id);
+    bool ok = str_equal_cstr(error_message(error_last()), expected) &&
+              error_stack_get()->count == ERROR_RING_CAPACITY;
+    return ok ? arg : NULL;
+}
+
+static bool test_error_threads(void) {
+    printf("Testing per-thread error rings...\n");
+    error_stack_clear();
+
+    pthread_t threads[4];
+    int ids[4];
+    for (int i = 0; i < 4; i++) {
+        ids[i] = i;
+        TEST(pthread_create(&threads[i], NULL, thread_worker, &ids[i]) == 0);
+    }
+    for (int i = 0; i < 4; i++) {
+        void* result = NULL;
+        pthread_join(threads[i], &result);
+        TEST(result == &ids[i]);
+    }
+
+    // Workers never touched this thread's ring
+    TEST(error_last() == NULL);
+
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Error Tests\n");
+    printf("=================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_error_lazy_format()) {
+        printf("✓ test_error_lazy_format passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_error_lazy_format failed\n\n");
+        failed++;
+    }
+
+    if (test_error_chain()) {
+        printf("✓ test_error_chain passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_error_chain failed\n\n");
+        failed++;
+    }
+
+    if (test_error_ring()) {
+        printf("✓ test_error_ring passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_error_ring failed\n\n");
+        failed++;
+    }
+
+    if (test_error_threads()) {
+        printf("✓ test_error_threads passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_error_threads failed\n\n");
+        failed++;
+    }
+
+    printf("=================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,515 @@
+// test_event_bus.c - Event bus tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/event_bus.h"
+#include "core/agent.h"
+#include "core/intern.h"
+#include "providers/base.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+static err_t publish_text(event_bus_t* bus, event_type_t type, const char* text) {
+    event_t event = { .type = type, .text = STR_VIEW(text) };
+    return event_bus_publish(bus, &event);
+}
+
+static void release_all(event_t** events, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) event_release(events[i]);
+}
+
+// ============================================================================
+// Fan-out and topics
+// ============================================================================
+
+static bool test_fan_out_by_topic(void) {
+    printf("Testing events fan out to matching subscriptions...\n");
+
+    event_bus_t* bus = NULL;
+    TEST_OK(event_bus_create(&bus));
+
+    event_subscription_t* everything = NULL;
+    event_subscription_t* turns = NULL;
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC_ALL, 8, EVENT_OVERFLOW_DROP_NEWEST, &everything));
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC(EVENT_TURN_COMPLETED), 8,
+                                EVENT_OVERFLOW_DROP_NEWEST, &turns));
+    TEST(event_bus_wants(bus, EVENT_TOKEN_CHUNK));
+    TEST(event_bus_subscribe(bus, 0, 8, EVENT_OVERFLOW_DROP_NEWEST, &turns) == ERR_INVALID_ARGUMENT);
+
+    TEST_OK(publish_text(bus, EVENT_TOKEN_CHUNK, "tok"));
+    TEST_OK(publish_text(bus, EVENT_TURN_COMPLETED, "reply"));
+
+    event_t* events[8];
+    TEST(event_bus_poll(everything, events, 8) == 2);
+    TEST(events[0]->type == EVENT_TOKEN_CHUNK && events[1]->type == EVENT_TURN_COMPLETED);
+    TEST(events[1]->sequence > events[0]->sequence);
+    TEST(events[0]->timestamp_ms > 0);
+    event_t* first_reply = events[1];
+    release_all(events, 2);
+
+    // One copy is shared, and outlives the publisher's strings
+    TEST(event_bus_poll(turns, events, 8) == 1);
+    TEST(events[0] == first_reply);
+    TEST(str_equal_cstr(events[0]->text, "reply"));
+    release_all(events, 1);
+
+    event_bus_unsubscribe(bus, everything);
+    TEST(!event_bus_wants(bus, EVENT_TOKEN_CHUNK));
+    TEST(event_bus_wants(bus, EVENT_TURN_COMPLETED));
+
+    // Topics can change while subscribed
+    event_bus_set_topics(bus, turns, EVENT_TOPIC(EVENT_TURN_COMPLETED) | EVENT_TOPIC(EVENT_TOKEN_CHUNK));
+    TEST(event_bus_wants(bus, EVENT_TOKEN_CHUNK));
+    TEST_OK(publish_text(bus, EVENT_TOKEN_CHUNK, "tok"));
+    TEST(event_bus_poll(turns, events, 8) == 1);
+    TEST(events[0]->type == EVENT_TOKEN_CHUNK);
+    release_all(events, 1);
+    event_bus_set_topics(bus, turns, EVENT_TOPIC(EVENT_TURN_COMPLETED));
+    TEST(!event_bus_wants(bus, EVENT_TOKEN_CHUNK));
+    TEST(event_bus_wants(bus, EVENT_TURN_COMPLETED));
+    TEST_OK(publish_text(bus, EVENT_TOKEN_CHUNK, "unheard"));
+    TEST(event_bus_poll(turns, events, 8) == 0);
+
+    event_bus_unsubscribe(bus, turns);
+    TEST(!event_bus_wants(bus, EVENT_TURN_COMPLETED));
+
+    // Nobody listening: nothing to do
+    TEST_OK(publish_text(bus, EVENT_TURN_COMPLETED, "unheard"));
+
+    event_bus_destroy(bus);
+    return true;
+}
+
+// ============================================================================
+// Overflow policies
+// ============================================================================
+
+static bool test_overflow_policies(void) {
+    printf("Testing full subscriptions drop or block as configured...\n");
+
+    event_bus_t* bus = NULL;
+    TEST_OK(event_bus_create(&bus));
+
+    event_subscription_t* newest = NULL;
+    event_subscription_t* oldest = NULL;
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC(EVENT_TOKEN_CHUNK), 4,
+                                EVENT_OVERFLOW_DROP_NEWEST, &newest));
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC(EVENT_TOKEN_CHUNK), 4,
+                                EVENT_OVERFLOW_DROP_OLDEST, &oldest));
+
+    char text[8];
+    for (int i = 0; i < 6; i++) {
+        snprintf(text, sizeof(text), "%d", i);
+        err_t err = publish_text(bus, EVENT_TOKEN_CHUNK, text);
+        TEST(err == (i < 4 ? ERR_OK : ERR_RATE_LIMITED));
+    }
+
+    event_subscription_stats_t stats;
+    event_bus_stats(newest, &stats);
+    TEST(stats.delivered == 4 && stats.dropped == 2 && stats.queued == 4);
+    event_bus_stats(oldest, &stats);
+    TEST(stats.delivered == 6 && stats.dropped == 2 && stats.queued == 4);
+
+    event_t* events[8];
+    TEST(event_bus_poll(newest, events, 8) == 4);
+    TEST(str_equal_cstr(events[0]->text, "0") && str_equal_cstr(events[3]->text, "3"));
+    release_all(events, 4);
+    TEST(event_bus_poll(oldest, events, 8) == 4);
+    TEST(str_equal_cstr(events[0]->text, "2") && str_equal_cstr(events[3]->text, "5"));
+    release_all(events, 4);
+
+    event_bus_unsubscribe(bus, newest);
+    event_bus_unsubscribe(bus, oldest);
+
+    // A blocking subscription nobody drains gives up after the timeout
+    event_subscription_t* blocking = NULL;
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC(EVENT_TOKEN_CHUNK), 2,
+                                EVENT_OVERFLOW_BLOCK, &blocking));
+    TEST_OK(publish_text(bus, EVENT_TOKEN_CHUNK, "a"));
+    TEST_OK(publish_text(bus, EVENT_TOKEN_CHUNK, "b"));
+    TEST(publish_text(bus, EVENT_TOKEN_CHUNK, "c") == ERR_RATE_LIMITED);
+    event_bus_stats(blocking, &stats);
+    TEST(stats.dropped == 1 && stats.queued == 2);
+
+    // Unsubscribing releases what is still queued
+    event_bus_unsubscribe(bus, blocking);
+    event_bus_destroy(bus);
+    return true;
+}
+
+// ============================================================================
+// Many publishers, many consumers
+// ============================================================================
+
+#define PUBLISHERS 4
+#define CONSUMERS 3
+#define PER_PUBLISHER 20000
+
+typedef struct mpmc_state_t {
+    event_bus_t* bus;
+    event_subscription_t* sub;
+    uint64_t consumed;
+    uint64_t value_sum;
+    bool done;
+} mpmc_state_t;
+
+static void* publisher_thread(void* arg) {
+    mpmc_state_t* state = arg;
+    for (uint64_t i = 1; i <= PER_PUBLISHER; i++) {
+        event_t event = { .type = EVENT_TOOL_FINISHED, .source = STR_LIT("tool"), .value = i };
+        event_bus_publish(state->bus, &event);
+    }
+    return NULL;
+}
+
+static void* consumer_thread(void* arg) {
+    mpmc_state_t* state = arg;
+    event_t* events[16];
+    for (;;) {
+        uint32_t count = event_bus_wait(state->sub, events, 16, 1000);
+        for (uint32_t i = 0; i < count; i++) {
+            __atomic_add_fetch(&state->value_sum, events[i]->value, __ATOMIC_RELAXED);
+            event_release(events[i]);
+        }
+        __atomic_add_fetch(&state->consumed, count, __ATOMIC_RELAXED);
+        if (count == 0 && __atomic_load_n(&state->done, __ATOMIC_ACQUIRE)) break;
+    }
+    return NULL;
+}
+
+static bool test_many_publishers_and_consumers(void) {
+    printf("Testing concurrent publishers and consumers lose nothing...\n");
+
+    mpmc_state_t state = {0};
+    TEST_OK(event_bus_create(&state.bus));
+    TEST_OK(event_bus_subscribe(state.bus, EVENT_TOPIC(EVENT_TOOL_FINISHED), 256,
+                                EVENT_OVERFLOW_BLOCK, &state.sub));
+
+    pthread_t consumers[CONSUMERS];
+    pthread_t publishers[PUBLISHERS];
+    for (int i = 0; i < CONSUMERS; i++) pthread_create(&consumers[i], NULL, consumer_thread, &state);
+    for (int i = 0; i < PUBLISHERS; i++) pthread_create(&publishers[i], NULL, publisher_thread, &state);
+    for (int i = 0; i < PUBLISHERS; i++) pthread_join(publishers[i], NULL);
+
+    __atomic_store_n(&state.done, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < CONSUMERS; i++) event_bus_wake(state.sub);
+    for (int i = 0; i < CONSUMERS; i++) pthread_join(consumers[i], NULL);
+
+    // Blocking publishers only drop after a consumer stalls for the
+    // whole timeout; every event is either consumed or counted as dropped
+    event_subscription_stats_t stats;
+    event_bus_stats(state.sub, &stats);
+    uint64_t total = (uint64_t)PUBLISHERS * PER_PUBLISHER;
+    TEST(stats.queued == 0);
+    TEST(stats.delivered == state.consumed);
+    TEST(stats.delivered + stats.dropped == total);
+    if (stats.dropped == 0) {
+        TEST(state.value_sum == (uint64_t)PUBLISHERS * PER_PUBLISHER * (PER_PUBLISHER + 1) / 2);
+    }
+
+    event_bus_unsubscribe(state.bus, state.sub);
+    event_bus_destroy(state.bus);
+    return true;
+}
+
+// ============================================================================
+// Waiting
+// ============================================================================
+
+typedef struct waiter_t {
+    event_subscription_t* sub;
+    uint32_t received;
+} waiter_t;
+
+static void* waiter_thread(void* arg) {
+    waiter_t* waiter = arg;
+    event_t* events[4];
+    waiter->received = event_bus_wait(waiter->sub, events, 4, -1);
+    release_all(events, waiter->received);
+    return NULL;
+}
+
+static bool test_wait_and_wake(void) {
+    printf("Testing consumers sleep until an event or a wake...\n");
+
+    event_bus_t* bus = NULL;
+    TEST_OK(event_bus_create(&bus));
+    event_subscription_t* sub = NULL;
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC_ALL, 0, EVENT_OVERFLOW_DROP_NEWEST, &sub));
+
+    event_t* events[4];
+    TEST(event_bus_wait(sub, events, 4, 20) == 0);
+
+    // Woken by an event
+    waiter_t waiter = { .sub = sub };
+    pthread_t thread;
+    pthread_create(&thread, NULL, waiter_thread, &waiter);
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 20 * 1000 * 1000 };
+    nanosleep(&pause, NULL);
+    TEST_OK(publish_text(bus, EVENT_MESSAGE_RECEIVED, "hi"));
+    pthread_join(thread, NULL);
+    TEST(waiter.received == 1);
+
+    // Woken with nothing to hand over
+    waiter.received = 99;
+    pthread_create(&thread, NULL, waiter_thread, &waiter);
+    nanosleep(&pause, NULL);
+    event_bus_wake(sub);
+    pthread_join(thread, NULL);
+    TEST(waiter.received == 0);
+
+    event_bus_unsubscribe(bus, sub);
+    event_bus_destroy(bus);
+    return true;
+}
+
+// ============================================================================
+// Agent events
+// ============================================================================
+
+static str_t echo_get_name(void) { return STR_LIT("echo"); }
+static bool tool_yes(void) { return true; }
+
+static void fake_tool_destroy(tool_t* tool) {
+    free(tool);
+}
+
+static err_t echo_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    tool_result_set_success(out_result, args);
+    return ERR_OK;
+}
+
+static const tool_vtable_t echo_vtable = {
+    .get_name = echo_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = echo_execute,
+    .is_read_only = tool_yes,
+};
+
+static bool g_call_tool = true;
+
+static err_t fake_chat(provider_t* provider, const chat_message_t* messages, uint32_t message_count,
+                       const tool_def_t* tools, uint32_t tool_count, const char* model,
+                       double temperature, chat_response_t** out_response) {
+    chat_response_t* response = chat_response_create();
+    if (g_call_tool) {
+        response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC,
+            "[{\"id\":\"call_1\",\"type\":\"function\",\"function\":"
+            "{\"name\":\"echo\",\"arguments\":\"{\\\"x\\\":1}\"}}]");
+        g_call_tool = false;
+    } else {
+        response->content = alloc_str(PROVIDER_ALLOC, STR_LIT("done"));
+    }
+    response->prompt_tokens = 10;
+    response->completion_tokens = 5;
+    *out_response = response;
+    return ERR_OK;
+}
+
+static const provider_vtable_t fake_vtable = {
+    .chat = fake_chat,
+};
+
+static agent_message_t* find_message(agent_message_t* message, agent_message_type_t type) {
+    if (!message || message->type == type) return message;
+    for (uint32_t i = 0; i < message->child_count; i++) {
+        agent_message_t* found = find_message(message->children[i], type);
+        if (found) return found;
+    }
+    return NULL;
+}
+
+static bool test_agent_publishes_turn_events(void) {
+    printf("Testing the agent publishes turn and tool events...\n");
+
+    event_bus_t* bus = NULL;
+    TEST_OK(event_bus_create(&bus));
+    event_subscription_t* sub = NULL;
+    TEST_OK(event_bus_subscribe(bus, EVENT_TOPIC_ALL, 0, EVENT_OVERFLOW_DROP_NEWEST, &sub));
+
+    agent_config_t config = agent_config_default();
+    agent_t* agent = NULL;
+    TEST_OK(agent_create(&config, &agent));
+    provider_t* provider = calloc(1, sizeof(provider_t));
+    provider->vtable = &fake_vtable;
+    agent->ctx->provider = provider;
+    agent->ctx->tools = calloc(1, sizeof(tool_t*));
+    agent->ctx->tools[0] = tool_alloc(&echo_vtable);
+    agent->ctx->tools[0]->initialized = true;
+    agent->ctx->tool_count = 1;
+    agent_set_event_bus(agent, bus);
+
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("events");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    str_t input = STR_LIT("hello");
+    str_t output = STR_NULL;
+    TEST_OK(agent_process_message(agent, session, &input, &output));
+    free((void*)output.data);
+
+    event_t* events[8];
+    uint32_t count = event_bus_poll(sub, events, 8);
+    TEST(count == 3);
+    TEST(events[0]->type == EVENT_TURN_STARTED);
+    TEST(str_equal_cstr(events[0]->text, "hello"));
+    TEST(str_equal(events[0]->session_id, session->id));
+
+    TEST(events[1]->type == EVENT_TOOL_FINISHED);
+    TEST(str_equal_cstr(events[1]->source, "echo"));
+    TEST(events[1]->status == ERR_OK);
+    TEST(events[1]->value == strlen("{\"x\":1}"));
+
+    TEST(events[2]->type == EVENT_TURN_COMPLETED);
+    TEST(str_equal_cstr(events[2]->text, "done"));
+    TEST(events[2]->status == ERR_OK);
+    TEST(events[2]->value == 30);
+    release_all(events, count);
+
+    // Tool and model names on the messages are interned; the session id,
+    // unique per session, is not
+    TEST(!str_interned_equal(session->id, str_intern(session->id)));
+    agent_message_t* message = find_message(session->root, AGENT_MSG_TOOL_RESULT);
+    TEST(message && str_interned_equal(message->tool_name, str_intern_cstr("echo")));
+    message = find_message(session->root, AGENT_MSG_ASSISTANT);
+    TEST(message && str_interned_equal(message->model, str_intern_cstr("unknown")));
+
+    agent_set_event_bus(agent, NULL);
+    free(agent->ctx->provider);
+    agent->ctx->provider = NULL;
+    agent_destroy(agent);
+
+    event_bus_unsubscribe(bus, sub);
+    event_bus_destroy(bus);
+    return true;
+}
+
+// ============================================================================
+// Metrics consumer
+// ============================================================================
+
+static bool test_metrics_consumer(void) {
+    printf("Testing the metrics consumer counts turns and tools...\n");
+
+    event_bus_t* bus = NULL;
+    TEST_OK(event_bus_create(&bus));
+
+    event_metrics_t before;
+    event_metrics_get(&before);
+    TEST_OK(event_metrics_start(bus));
+    TEST(event_metrics_start(bus) == ERR_ALREADY_EXISTS);
+
+    // Token chunks stay unbuilt with only the metrics listening
+    TEST(!event_bus_wants(bus, EVENT_TOKEN_CHUNK));
+    TEST(event_bus_wants(bus, EVENT_TURN_COMPLETED));
+
+    TEST_OK(publish_text(bus, EVENT_MESSAGE_RECEIVED, "hi"));
+    TEST_OK(publish_text(bus, EVENT_TURN_STARTED, "hi"));
+    event_t tool = { .type = EVENT_TOOL_FINISHED, .status = ERR_TOOL_EXECUTION_FAILED, .duration_ms = 5 };
+    TEST_OK(event_bus_publish(bus, &tool));
+    tool.status = ERR_OK;
+    TEST_OK(event_bus_publish(bus, &tool));
+    event_t turn = { .type = EVENT_TURN_COMPLETED, .status = ERR_OK, .duration_ms = 7, .value = 30 };
+    TEST_OK(event_bus_publish(bus, &turn));
+
+    // Whatever was published before the stop is counted
+    event_metrics_stop();
+    event_metrics_stop();
+
+    event_metrics_t after;
+    event_metrics_get(&after);
+    TEST(after.messages_received - before.messages_received == 1);
+    TEST(after.turns_started - before.turns_started == 1);
+    TEST(after.turns_completed - before.turns_completed == 1);
+    TEST(after.turns_failed == before.turns_failed);
+    TEST(after.turn_duration_ms - before.turn_duration_ms == 7);
+    TEST(after.tokens - before.tokens == 30);
+    TEST(after.tool_calls - before.tool_calls == 2);
+    TEST(after.tool_failures - before.tool_failures == 1);
+    TEST(after.tool_duration_ms - before.tool_duration_ms == 10);
+    TEST(after.dropped == before.dropped);
+
+    char text[2048];
+    size_t len = event_metrics_format(text, sizeof(text));
+    TEST(len > 0 && len == strlen(text));
+    TEST(strstr(text, "cclaw_agent_turns_total{result=\"completed\"}"));
+    TEST(strstr(text, "cclaw_tool_calls_total{result=\"failed\"}"));
+
+    // Nothing subscribed any more
+    TEST(!event_bus_wants(bus, EVENT_TURN_COMPLETED));
+    event_bus_destroy(bus);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Event Bus Tests\n");
+    printf("=====================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_fan_out_by_topic()) {
+        printf("✓ test_fan_out_by_topic passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_fan_out_by_topic failed\n\n");
+        failed++;
+    }
+
+    if (test_overflow_policies()) {
+        printf("✓ test_overflow_policies passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_overflow_policies failed\n\n");
+        failed++;
+    }
+
+    if (test_many_publishers_and_consumers()) {
+        printf("✓ test_many_publishers_and_consumers passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_many_publishers_and_consumers failed\n\n");
+        failed++;
+    }
+
+    if (test_wait_and_wake()) {
+        printf("✓ test_wait_and_wake passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_wait_and_wake failed\n\n");
+        failed++;
+    }
+
+    if (test_agent_publishes_turn_events()) {
+        printf("✓ test_agent_publishes_turn_events passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_agent_publishes_turn_events failed\n\n");
+        failed++;
+    }
+
+    if (test_metrics_consumer()) {
+        printf("✓ test_metrics_consumer passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_metrics_consumer failed\n\n");
+        failed++;
+    }
+
+    printf("=====================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
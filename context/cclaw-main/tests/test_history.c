@@ -0,0 +1,337 @@
+// test_history.c - Conversation history upload tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/agent.h"
+#include "providers/base.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+// ============================================================================
+// Fake tool
+// ============================================================================
+
+static str_t echo_get_name(void) { return STR_LIT("echo"); }
+static bool tool_yes(void) { return true; }
+
+static void fake_tool_destroy(tool_t* tool) {
+    free(tool);
+}
+
+static err_t echo_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    tool_result_set_success(out_result, args);
+    return ERR_OK;
+}
+
+static const tool_vtable_t echo_vtable = {
+    .get_name = echo_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = echo_execute,
+    .is_read_only = tool_yes,
+};
+
+// ============================================================================
+// Fake provider with server-side state. Each request is recorded; the
+// first one of a turn answers with g_calls when set.
+// ============================================================================
+
+#define MAX_REQUESTS 16
+
+typedef struct recorded_request_t {
+    char previous[32];          // "" for a full upload
+    uint32_t message_count;
+    chat_role_t roles[16];
+    char last_content[64];
+    char last_tool_call_id[32];
+} recorded_request_t;
+
+static recorded_request_t g_requests[MAX_REQUESTS];
+static uint32_t g_request_count = 0;
+static uint32_t g_response_count = 0;
+static const char* g_calls = NULL;
+static bool g_forget = false;   // The next chained request finds nothing stored
+
+static void record(const char* previous, const chat_message_t* messages, uint32_t count) {
+    recorded_request_t* r = &g_requests[g_request_count++ % MAX_REQUESTS];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->previous, sizeof(r->previous), "%s", previous ? previous : "");
+    r->message_count = count;
+    for (uint32_t i = 0; i < count && i < 16; i++) r->roles[i] = messages[i].role;
+    const chat_message_t* last = &messages[count - 1];
+    snprintf(r->last_content, sizeof(r->last_content), "%.*s", (int)last->content.len,
+             last->content.data ? last->content.data : "");
+    snprintf(r->last_tool_call_id, sizeof(r->last_tool_call_id), "%.*s",
+             (int)last->tool_call_id.len, last->tool_call_id.data ? last->tool_call_id.data : "");
+}
+
+static chat_response_t* next_response(void) {
+    chat_response_t* response = chat_response_create();
+    if (g_calls) {
+        response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC, g_calls);
+        g_calls = NULL;
+    } else {
+        response->content = alloc_str(PROVIDER_ALLOC, STR_LIT("done"));
+    }
+    return response;
+}
+
+static err_t fake_chat(provider_t* provider, const chat_message_t* messages, uint32_t message_count,
+                       const tool_def_t* tools, uint32_t tool_count, const char* model,
+                       double temperature, chat_response_t** out_response) {
+    record(NULL, messages, message_count);
+    *out_response = next_response();
+    return ERR_OK;
+}
+
+static err_t fake_chat_continue(provider_t* provider, const char* previous_id,
+                                const chat_message_t* messages, uint32_t message_count,
+                                const tool_def_t* tools, uint32_t tool_count, const char* model,
+                                double temperature, chat_response_t** out_response) {
+    record(previous_id, messages, message_count);
+    if (previous_id && g_forget) {
+        g_forget = false;
+        return ERR_NOT_FOUND;
+    }
+
+    chat_response_t* response = next_response();
+    char id[32];
+    snprintf(id, sizeof(id), "resp_%u", ++g_response_count);
+    response->response_id = alloc_str_cstr(PROVIDER_ALLOC, id);
+    *out_response = response;
+    return ERR_OK;
+}
+
+static const provider_vtable_t fake_vtable = {
+    .chat = fake_chat,
+    .chat_continue = fake_chat_continue,
+};
+
+static agent_t* agent_with_provider(bool chaining) {
+    agent_config_t config = agent_config_default();
+    config.differential_history = true;
+
+    agent_t* agent = NULL;
+    if (agent_create(&config, &agent) != ERR_OK) return NULL;
+
+    provider_t* provider = calloc(1, sizeof(provider_t));
+    provider->vtable = &fake_vtable;
+    provider->config.response_chaining = chaining;
+    agent->ctx->provider = provider;
+
+    agent->ctx->tools = calloc(1, sizeof(tool_t*));
+    agent->ctx->tools[0] = tool_alloc(&echo_vtable);
+    agent->ctx->tools[0]->initialized = true;
+    agent->ctx->tool_count = 1;
+
+    g_request_count = 0;
+    g_response_count = 0;
+    return agent;
+}
+
+static void agent_free(agent_t* agent) {
+    free(agent->ctx->provider);
+    agent->ctx->provider = NULL;
+    agent_destroy(agent);
+}
+
+static bool say(agent_t* agent, agent_session_t* session, const char* text) {
+    str_t input = STR_VIEW(text);
+    str_t output = STR_NULL;
+    if (agent_process_message(agent, session, &input, &output) != ERR_OK) return false;
+    free((void*)output.data);
+    return true;
+}
+
+static const char* ECHO_CALL =
+    "[{\"id\":\"call_1\",\"type\":\"function\",\"function\":{\"name\":\"echo\",\"arguments\":\"{\\\"x\\\":1}\"}}]";
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static bool test_full_history_has_tool_results(void) {
+    printf("Testing full history carries tool calls and results...\n");
+
+    agent_t* agent = agent_with_provider(false);
+    TEST(agent != NULL);
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("full");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    g_calls = ECHO_CALL;
+    TEST(say(agent, session, "hello"));
+
+    // system, user, assistant with the call, the call's result
+    TEST(g_request_count == 2);
+    recorded_request_t* second = &g_requests[1];
+    TEST(second->previous[0] == '\0');
+    TEST(second->message_count == 4);
+    TEST(second->roles[1] == CHAT_ROLE_USER);
+    TEST(second->roles[2] == CHAT_ROLE_ASSISTANT);
+    TEST(second->roles[3] == CHAT_ROLE_TOOL);
+    TEST(strcmp(second->last_tool_call_id, "call_1") == 0);
+    TEST(strcmp(second->last_content, "{\"x\":1}") == 0);
+
+    chat_message_t* messages = NULL;
+    uint32_t count = 0;
+    TEST_OK(agent_session_to_chat_messages(session, &messages, &count));
+    TEST(count == 5);
+    TEST(str_equal_cstr(messages[2].tool_calls, ECHO_CALL));
+    TEST(messages[4].role == CHAT_ROLE_ASSISTANT && str_equal_cstr(messages[4].content, "done"));
+
+    // The OpenAI-style request keeps the pairing
+    char* request = provider_build_chat_request(NULL, messages, count, NULL, 0, "m", 0.5, false);
+    TEST(request != NULL);
+    TEST(strstr(request, "\"tool_call_id\":\"call_1\"") != NULL);
+    TEST(strstr(request, "\"tool_calls\":[") != NULL);
+    free(request);
+    chat_message_array_free(messages, count);
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_chained_turns_send_only_new_messages(void) {
+    printf("Testing chained turns send only new messages...\n");
+
+    agent_t* agent = agent_with_provider(true);
+    TEST(agent != NULL);
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("chained");
+    TEST_OK(agent_session_create(agent, &name, &session));
+    TEST(session->chain_history);
+
+    g_calls = ECHO_CALL;
+    TEST(say(agent, session, "hello"));
+
+    // First request starts the chain; the second sends only the result
+    TEST(g_request_count == 2);
+    TEST(g_requests[0].previous[0] == '\0' && g_requests[0].message_count == 2);
+    TEST(strcmp(g_requests[1].previous, "resp_1") == 0);
+    TEST(g_requests[1].message_count == 2);
+    TEST(g_requests[1].roles[0] == CHAT_ROLE_SYSTEM && g_requests[1].roles[1] == CHAT_ROLE_TOOL);
+    TEST(strcmp(g_requests[1].last_tool_call_id, "call_1") == 0);
+
+    // Next turn: the system prompt and the new user message
+    TEST(say(agent, session, "again"));
+    TEST(g_request_count == 3);
+    TEST(strcmp(g_requests[2].previous, "resp_2") == 0);
+    TEST(g_requests[2].message_count == 2);
+    TEST(strcmp(g_requests[2].last_content, "again") == 0);
+    TEST(str_equal_cstr(session->chain_response_id, "resp_3"));
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_branch_switch_falls_back(void) {
+    printf("Testing a branch switch falls back to full history...\n");
+
+    agent_t* agent = agent_with_provider(true);
+    TEST(agent != NULL);
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("branch");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    TEST(say(agent, session, "first"));
+    TEST(say(agent, session, "second"));
+    TEST(g_request_count == 2);
+    TEST(strcmp(g_requests[1].previous, "resp_1") == 0);
+
+    // Back to the first reply and off in another direction
+    agent_message_t* first_reply = session->root->children[0];
+    TEST_OK(agent_navigate_to(agent, first_reply));
+    TEST(say(agent, session, "other"));
+    TEST(g_request_count == 3);
+    TEST(g_requests[2].previous[0] == '\0');
+    TEST(g_requests[2].message_count == 4);     // system, first, reply, other
+    TEST(strcmp(g_requests[2].last_content, "other") == 0);
+
+    // And chained again from there
+    TEST(say(agent, session, "more"));
+    TEST(strcmp(g_requests[3].previous, "resp_3") == 0);
+    TEST(g_requests[3].message_count == 2);
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_expired_response_restarts_chain(void) {
+    printf("Testing an expired stored response restarts the chain...\n");
+
+    agent_t* agent = agent_with_provider(true);
+    TEST(agent != NULL);
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("expired");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    TEST(say(agent, session, "first"));
+    g_forget = true;
+    TEST(say(agent, session, "second"));
+
+    // The chained attempt, then the whole history
+    TEST(g_request_count == 3);
+    TEST(strcmp(g_requests[1].previous, "resp_1") == 0);
+    TEST(g_requests[2].previous[0] == '\0');
+    TEST(g_requests[2].message_count == 4);
+    TEST(str_equal_cstr(session->chain_response_id, "resp_2"));
+
+    agent_free(agent);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw History Tests\n");
+    printf("===================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_full_history_has_tool_results()) {
+        printf("✓ test_full_history_has_tool_results passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_full_history_has_tool_results failed\n\n");
+        failed++;
+    }
+
+    if (test_chained_turns_send_only_new_messages()) {
+        printf("✓ test_chained_turns_send_only_new_messages passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_chained_turns_send_only_new_messages failed\n\n");
+        failed++;
+    }
+
+    if (test_branch_switch_falls_back()) {
+        printf("✓ test_branch_switch_falls_back passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_branch_switch_falls_back failed\n\n");
+        failed++;
+    }
+
+    if (test_expired_response_restarts_chain()) {
+        printf("✓ test_expired_response_restarts_chain passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_expired_response_restarts_chain failed\n\n");
+        failed++;
+    }
+
+    printf("===================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
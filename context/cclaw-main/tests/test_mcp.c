@@ -0,0 +1,451 @@
+// test_mcp.c - MCP client and tool bridge tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/mcp.h"
+#include "json_config.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+// ============================================================================
+// Fake server: this binary re-executed with --fake-mcp-server
+// ============================================================================
+
+static pthread_mutex_t g_out_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_list_calls = 0;
+static bool g_touched = false;
+
+static void server_send(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static void server_send(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    pthread_mutex_lock(&g_out_lock);
+    vprintf(fmt, args);
+    putchar('\n');
+    fflush(stdout);
+    pthread_mutex_unlock(&g_out_lock);
+    va_end(args);
+}
+
+static void server_text(int id, const char* text, bool is_error) {
+    server_send("{\"jsonrpc\":\"2.0\",\"id\":%d,\"result\":{\"content\":[{\"type\":\"text\",\"text\":\"%s\"}]%s}}",
+                id, text, is_error ? ",\"isError\":true" : "");
+}
+
+static void* server_slow_call(void* arg) {
+    int id = (int)(intptr_t)arg;
+    usleep(300 * 1000);
+    server_text(id, "slow done", false);
+    return NULL;
+}
+
+#define TOOL_DEF(name) \
+    "{\"name\":\"" name "\",\"description\":\"" name " tool\"," \
+    "\"inputSchema\":{\"type\":\"object\",\"properties\":{\"text\":{\"type\":\"string\"}}}}"
+
+static void server_handle(json_object_t* msg) {
+    const char* method = json_object_get_string(msg, "method", "");
+    int id = (int)json_object_get_number(msg, "id", -1);
+    json_object_t* params = json_object_get_object(msg, "params");
+
+    if (strcmp(method, "initialize") == 0) {
+        server_send("{\"jsonrpc\":\"2.0\",\"id\":%d,\"result\":{\"protocolVersion\":\"2024-11-05\","
+                    "\"capabilities\":{\"tools\":{\"listChanged\":true}},"
+                    "\"serverInfo\":{\"name\":\"fake\",\"version\":\"1\"}}}", id);
+    } else if (strcmp(method, "tools/list") == 0) {
+        const char* cursor = params ? json_object_get_string(params, "cursor", NULL) : NULL;
+        if (!cursor) {
+            g_list_calls++;
+            server_send("{\"jsonrpc\":\"2.0\",\"id\":%d,\"result\":{\"tools\":[" TOOL_DEF("echo") ","
+                        TOOL_DEF("slow") "],\"nextCursor\":\"page2\"}}", id);
+        } else {
+            server_send("{\"jsonrpc\":\"2.0\",\"id\":%d,\"result\":{\"tools\":[" TOOL_DEF("fail") ","
+                        TOOL_DEF("touch") "%s]}}", id, g_touched ? "," TOOL_DEF("late") : "");
+        }
+    } else if (strcmp(method, "tools/call") == 0) {
+        const char* name = json_object_get_string(params, "name", "");
+        json_object_t* arguments = json_object_get_object(params, "arguments");
+        if (strcmp(name, "echo") == 0) {
+            server_text(id, arguments ? json_object_get_string(arguments, "text", "") : "", false);
+        } else if (strcmp(name, "slow") == 0) {
+            pthread_t thread;
+            pthread_create(&thread, NULL, server_slow_call, (void*)(intptr_t)id);
+            pthread_detach(thread);
+        } else if (strcmp(name, "fail") == 0) {
+            server_text(id, "boom", true);
+        } else if (strcmp(name, "touch") == 0) {
+            g_touched = true;
+            server_send("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/tools/list_changed\"}");
+            server_text(id, "touched", false);
+        } else if (strcmp(name, "stats") == 0) {
+            char text[32];
+            snprintf(text, sizeof(text), "%d", g_list_calls);
+            server_text(id, text, false);
+        }
+    } else if (id >= 0) {
+        server_send("{\"jsonrpc\":\"2.0\",\"id\":%d,\"error\":{\"code\":-32601,\"message\":\"Method not found\"}}",
+                    id);
+    }
+}
+
+static int run_fake_server(void) {
+    char* line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, stdin) > 0) {
+        json_value_t* msg = json_parse(line);
+        if (json_is_object(msg)) server_handle(json_as_object(msg));
+        json_free(msg);
+    }
+    free(line);
+    return 0;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static const char* g_self = NULL;
+
+static err_t start_fake(mcp_client_t** out_client) {
+    const str_t args[] = { STR_LIT("--fake-mcp-server") };
+    mcp_server_config_t config = {
+        .name = STR_LIT("fake"),
+        .command = STR_VIEW(g_self),
+        .args = args,
+        .args_count = 1,
+        .timeout_ms = 5000
+    };
+    return mcp_client_start(&config, out_client);
+}
+
+static bool result_is(const tool_result_t* result, bool success, const char* text) {
+    str_t s = success ? result->content : result->error_message;
+    return result->success == success && str_equal_cstr(s, text);
+}
+
+static bool test_mcp_tools(void) {
+    printf("Testing MCP handshake, tools/list and tools/call...\n");
+
+    mcp_client_t* client = NULL;
+    TEST_OK(start_fake(&client));
+    TEST(str_equal_cstr(mcp_client_name(client), "fake"));
+    TEST(mcp_client_is_alive(client));
+
+    // Both pages are collected
+    mcp_tool_def_t* tools = NULL;
+    uint32_t count = 0;
+    TEST_OK(mcp_client_list_tools(client, &tools, &count));
+    TEST(count == 4);
+    TEST(str_equal_cstr(tools[0].name, "echo"));
+    TEST(str_equal_cstr(tools[0].description, "echo tool"));
+    TEST(strstr(tools[0].input_schema.data, "\"text\"") != NULL);
+    TEST(str_equal_cstr(tools[3].name, "touch"));
+    mcp_tool_defs_free(tools, count);
+
+    // Second listing comes from the cache
+    TEST_OK(mcp_client_list_tools(client, &tools, &count));
+    TEST(count == 4);
+    mcp_tool_defs_free(tools, count);
+
+    tool_result_t result = tool_result_create();
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("stats"), STR_NULL, &result));
+    TEST(result_is(&result, true, "1"));
+
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("echo"), STR_LIT("{\"text\":\"hello\"}"), &result));
+    TEST(result_is(&result, true, "hello"));
+
+    // Pretty-printed arguments still go out as one line
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("echo"), STR_LIT("{\n  \"text\": \"pretty\"\n}"), &result));
+    TEST(result_is(&result, true, "pretty"));
+
+    // Arguments that are not a JSON object never reach the server
+    TEST(mcp_client_call_tool(client, STR_LIT("echo"), STR_LIT("{\"text\":"), &result) == ERR_INVALID_ARGUMENT);
+    TEST(!result.success);
+    TEST(mcp_client_call_tool(client, STR_LIT("echo"), STR_LIT("[1]"), &result) == ERR_INVALID_ARGUMENT);
+    TEST(mcp_client_is_alive(client));
+
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("fail"), STR_LIT("{}"), &result));
+    TEST(result_is(&result, false, "boom"));
+    tool_result_free(&result);
+
+    // JSON-RPC errors surface as errors
+    str_t raw = STR_NULL;
+    TEST(mcp_client_request(client, "bogus/method", STR_NULL, &raw) == ERR_TOOL_EXECUTION_FAILED);
+    TEST(strstr(error_message(error_last()).data, "Method not found") != NULL);
+
+    mcp_client_stop(client);
+    return true;
+}
+
+typedef struct {
+    mcp_client_t* client;
+    tool_result_t result;
+    err_t err;
+    bool finished;
+} slow_call_t;
+
+static void* slow_call_thread(void* arg) {
+    slow_call_t* call = (slow_call_t*)arg;
+    call->err = mcp_client_call_tool(call->client, STR_LIT("slow"), STR_NULL, &call->result);
+    __atomic_store_n(&call->finished, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static bool test_mcp_multiplexing(void) {
+    printf("Testing MCP request multiplexing...\n");
+
+    mcp_client_t* client = NULL;
+    TEST_OK(start_fake(&client));
+
+    slow_call_t slow = { .client = client, .result = tool_result_create() };
+    pthread_t thread;
+    TEST(pthread_create(&thread, NULL, slow_call_thread, &slow) == 0);
+    usleep(50 * 1000);
+
+    // A later request completes while the slow one is still outstanding
+    tool_result_t result = tool_result_create();
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("echo"), STR_LIT("{\"text\":\"fast\"}"), &result));
+    TEST(result_is(&result, true, "fast"));
+    TEST(!__atomic_load_n(&slow.finished, __ATOMIC_ACQUIRE));
+    tool_result_free(&result);
+
+    pthread_join(thread, NULL);
+    TEST_OK(slow.err);
+    TEST(result_is(&slow.result, true, "slow done"));
+    tool_result_free(&slow.result);
+
+    mcp_client_stop(client);
+    return true;
+}
+
+static bool test_mcp_list_changed(void) {
+    printf("Testing MCP tools/list_changed invalidation...\n");
+
+    mcp_client_t* client = NULL;
+    TEST_OK(start_fake(&client));
+
+    mcp_tool_def_t* tools = NULL;
+    uint32_t count = 0;
+    TEST_OK(mcp_client_list_tools(client, &tools, &count));
+    TEST(count == 4);
+    mcp_tool_defs_free(tools, count);
+
+    // The notification precedes the response on the pipe
+    tool_result_t result = tool_result_create();
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("touch"), STR_NULL, &result));
+    TEST(result_is(&result, true, "touched"));
+
+    TEST_OK(mcp_client_list_tools(client, &tools, &count));
+    TEST(count == 5);
+    TEST(str_equal_cstr(tools[4].name, "late"));
+    mcp_tool_defs_free(tools, count);
+
+    TEST_OK(mcp_client_call_tool(client, STR_LIT("stats"), STR_NULL, &result));
+    TEST(result_is(&result, true, "2"));
+    tool_result_free(&result);
+
+    mcp_client_stop(client);
+    return true;
+}
+
+typedef struct {
+    tool_t* tool;
+    tool_result_t result;
+    err_t err;
+} bridged_call_t;
+
+static void* bridged_call_thread(void* arg) {
+    bridged_call_t* call = (bridged_call_t*)arg;
+    str_t args = STR_LIT("{}");
+    call->err = call->tool->vtable->execute(call->tool, &args, &call->result);
+    return NULL;
+}
+
+static bool test_mcp_tool_bridge(void) {
+    printf("Testing MCP tool bridge...\n");
+
+    TEST_OK(tool_registry_init());
+
+    mcp_client_t* client = NULL;
+    TEST_OK(start_fake(&client));
+
+    uint32_t registered = 0;
+    TEST_OK(mcp_client_register_tools(client, &registered));
+    TEST(registered == 4);
+
+    // Registering again skips names that already exist
+    TEST_OK(mcp_client_register_tools(client, &registered));
+    TEST(registered == 0);
+
+    tool_t* echo = NULL;
+    tool_t* fail = NULL;
+    TEST_OK(tool_create("mcp_fake_echo", &echo));
+    TEST_OK(tool_create("mcp_fake_fail", &fail));
+
+    // Each bridged tool answers through its own vtable
+    TEST(str_equal_cstr(echo->vtable->get_name(), "mcp_fake_echo"));
+    TEST(str_equal_cstr(fail->vtable->get_name(), "mcp_fake_fail"));
+    TEST(str_equal_cstr(echo->vtable->get_description(), "echo tool"));
+    TEST(strstr(echo->vtable->get_parameters_schema().data, "\"text\"") != NULL);
+
+    tool_context_t context = tool_context_default();
+    TEST_OK(echo->vtable->init(echo, &context));
+
+    str_t args = STR_LIT("{\"text\":\"bridged\"}");
+    tool_result_t result = tool_result_create();
+    TEST_OK(echo->vtable->execute(echo, &args, &result));
+    TEST(result_is(&result, true, "bridged"));
+
+    // After list_changed, a refresh registers the new tool and existing
+    // instances keep working
+    bool changed = true;
+    TEST_OK(mcp_client_refresh_tools(client, &changed));
+    TEST(!changed);
+    tool_t* touch = NULL;
+    TEST_OK(tool_create("mcp_fake_touch", &touch));
+    TEST_OK(touch->vtable->init(touch, &context));
+    args = STR_LIT("{}");
+    TEST_OK(touch->vtable->execute(touch, &args, &result));
+    TEST(result_is(&result, true, "touched"));
+    tool_free(touch);
+
+    // What the accessors handed out before the refresh stays readable
+    str_t description = echo->vtable->get_description();
+    TEST_OK(mcp_client_refresh_tools(client, &changed));
+    TEST(changed);
+    TEST(str_equal_cstr(description, "echo tool"));
+    TEST(str_equal_cstr(echo->vtable->get_description(), "echo tool"));
+    tool_t* late = NULL;
+    TEST_OK(tool_create("mcp_fake_late", &late));
+    tool_free(late);
+    args = STR_LIT("{\"text\":\"still bridged\"}");
+    TEST_OK(echo->vtable->execute(echo, &args, &result));
+    TEST(result_is(&result, true, "still bridged"));
+    TEST_OK(mcp_client_refresh_tools(client, &changed));
+    TEST(!changed);
+    tool_result_free(&result);
+
+    // Stopping the server removes its tools. A call in flight keeps the
+    // client alive until it returns, answered if the server finished it
+    // during its shutdown grace period and failed otherwise.
+    bridged_call_t slow = { .result = tool_result_create() };
+    TEST_OK(tool_create("mcp_fake_slow", &slow.tool));
+    TEST_OK(slow.tool->vtable->init(slow.tool, &context));
+    pthread_t thread;
+    TEST(pthread_create(&thread, NULL, bridged_call_thread, &slow) == 0);
+    usleep(50 * 1000);
+    mcp_client_stop(client);
+    pthread_join(thread, NULL);
+    TEST(slow.err == ERR_OK ? result_is(&slow.result, true, "slow done") : !slow.result.success);
+    tool_result_free(&slow.result);
+
+    TEST(echo->vtable->execute(echo, &args, &result) == ERR_NOT_FOUND);
+    TEST(!result.success);
+    tool_result_free(&result);
+    tool_free(slow.tool);
+    tool_free(echo);
+    tool_free(fail);
+
+    tool_t* gone = NULL;
+    TEST(tool_create("mcp_fake_echo", &gone) == ERR_NOT_FOUND);
+    TEST_OK(tool_create("shell", &gone));
+    tool_free(gone);
+
+    tool_registry_shutdown();
+    return true;
+}
+
+static bool test_mcp_bad_server(void) {
+    printf("Testing MCP server start failures...\n");
+
+    mcp_client_t* client = NULL;
+    mcp_server_config_t config = {
+        .name = STR_LIT("missing"),
+        .command = STR_LIT("/nonexistent/mcp-server"),
+        .timeout_ms = 2000
+    };
+    TEST(mcp_client_start(&config, &client) == ERR_CONNECTION_FAILED);
+
+    // Exits without speaking the protocol. Writing to it must not raise
+    // SIGPIPE, and the process-wide disposition is left alone.
+    config.command = STR_LIT("true");
+    TEST(mcp_client_start(&config, &client) == ERR_CONNECTION_FAILED);
+    struct sigaction action;
+    TEST(sigaction(SIGPIPE, NULL, &action) == 0);
+    TEST(action.sa_handler == SIG_DFL);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--fake-mcp-server") == 0) {
+        return run_fake_server();
+    }
+    g_self = argv[0];
+
+    printf("CClaw MCP Tests\n");
+    printf("===============\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_mcp_tools()) {
+        printf("✓ test_mcp_tools passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_mcp_tools failed\n\n");
+        failed++;
+    }
+
+    if (test_mcp_multiplexing()) {
+        printf("✓ test_mcp_multiplexing passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_mcp_multiplexing failed\n\n");
+        failed++;
+    }
+
+    if (test_mcp_list_changed()) {
+        printf("✓ test_mcp_list_changed passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_mcp_list_changed failed\n\n");
+        failed++;
+    }
+
+    if (test_mcp_tool_bridge()) {
+        printf("✓ test_mcp_tool_bridge passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_mcp_tool_bridge failed\n\n");
+        failed++;
+    }
+
+    if (test_mcp_bad_server()) {
+        printf("✓ test_mcp_bad_server passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_mcp_bad_server failed\n\n");
+        failed++;
+    }
+
+    printf("===============\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -3,9 +3,17 @@
 
 #include "core/memory.h"
 #include "core/error.h"
+#include "core/tool.h"
+#include "utils/compress.h"
+#include "utils/tar.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sqlite3.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #define TEST(expr) \
     do { \
@@ -215,6 +223,743 @@ static bool test_null_backend(void) {
     return true;
 }
 
+// Free the strings of an entry filled in by recall()
+static void entry_fields_free(memory_entry_t* entry) {
+    free((void*)entry->id.data);
+    free((void*)entry->key.data);
+    free((void*)entry->content.data);
+    free((void*)entry->timestamp.data);
+    free((void*)entry->session_id.data);
+}
+
+static bool test_memory_cache(void) {
+    printf("Testing memory read cache...\n");
+
+    memory_config_t config = memory_config_default();
+    config.cache_entries = 16;
+
+    memory_t* memory = NULL;
+    err_t err = memory_create("sqlite", &config, &memory);
+    TEST_OK(err);
+    TEST_OK(memory->vtable->init(memory));
+
+    memory_cache_stats_t before;
+    memory_cache_stats(&before);
+
+    // Miss, then negative hit
+    str_t key = STR_LIT("cache_key");
+    memory_entry_t recalled = {0};
+    TEST(memory->vtable->recall(memory, &key, &recalled) == ERR_NOT_FOUND);
+    TEST(memory->vtable->recall(memory, &key, &recalled) == ERR_NOT_FOUND);
+
+    // Store invalidates the negative entry; the generation moves even
+    // though no memory tool did the write
+    uint64_t generation = memory_generation(memory);
+    str_t content = STR_LIT("first");
+    memory_entry_t* entry = memory_entry_create(&key, &content, MEMORY_CATEGORY_CORE, NULL);
+    TEST(entry != NULL);
+    TEST_OK(memory->vtable->store(memory, entry));
+    memory_entry_free(entry);
+    TEST(memory_generation(memory) != generation);
+
+    // Miss that populates, then a hit returning an independent copy
+    TEST_OK(memory->vtable->recall(memory, &key, &recalled));
+    TEST(str_equal_cstr(recalled.content, "first"));
+    entry_fields_free(&recalled);
+
+    memory_entry_t again = {0};
+    TEST_OK(memory->vtable->recall(memory, &key, &again));
+    TEST(str_equal_cstr(again.content, "first"));
+    entry_fields_free(&again);
+
+    // Forget is visible immediately (write-through invalidation)
+    generation = memory_generation(memory);
+    TEST_OK(memory->vtable->forget(memory, &key));
+    TEST(memory_generation(memory) != generation);
+    memory_entry_t gone = {0};
+    TEST(memory->vtable->recall(memory, &key, &gone) == ERR_NOT_FOUND);
+
+    // A store replaces the cached negative result
+    content = STR_LIT("second");
+    entry = memory_entry_create(&key, &content, MEMORY_CATEGORY_CORE, NULL);
+    TEST(entry != NULL);
+    TEST_OK(memory->vtable->store(memory, entry));
+    memory_entry_free(entry);
+
+    memory_entry_t updated = {0};
+    TEST_OK(memory->vtable->recall(memory, &key, &updated));
+    TEST(str_equal_cstr(updated.content, "second"));
+    entry_fields_free(&updated);
+
+    memory_cache_stats_t after;
+    memory_cache_stats(&after);
+    TEST(after.misses - before.misses == 4);
+    TEST(after.negative_hits - before.negative_hits == 1);
+    TEST(after.hits - before.hits == 1);
+    TEST(memory_cache_hit_rate(&after) > 0.0);
+
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+
+    return true;
+}
+
+// Runs tool with args and checks the outcome; *out_content keeps the result.
+// Failed calls may also return an error code.
+static bool run_tool(tool_t* tool, const char* args, bool expect_success, char** out_content) {
+    str_t args_str = STR_VIEW(args);
+    tool_result_t result = tool_result_create();
+    err_t err = tool->vtable->execute(tool, &args_str, &result);
+    TEST(result.success == expect_success);
+    if (expect_success) TEST_OK(err);
+    if (out_content) {
+        str_t text = result.success ? result.content : result.error_message;
+        *out_content = strndup(text.data ? text.data : "", text.len);
+    }
+    tool_result_free(&result);
+    return true;
+}
+
+static bool test_memory_tools_share_memory(void) {
+    printf("Testing memory tools sharing one memory...\n");
+
+    // With a recall cache, so a stale negative entry would show
+    memory_config_t config = memory_config_default();
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("sqlite", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    tool_context_t context = tool_context_default();
+    TEST_OK(tool_context_set_memory(&context, memory));
+
+    tool_t* store = NULL;
+    tool_t* recall = NULL;
+    tool_t* forget = NULL;
+    TEST_OK(memory_store_tool_get_vtable()->create(&store));
+    TEST_OK(memory_recall_tool_get_vtable()->create(&recall));
+    TEST_OK(memory_forget_tool_get_vtable()->create(&forget));
+    TEST_OK(store->vtable->init(store, &context));
+    TEST_OK(recall->vtable->init(recall, &context));
+    TEST_OK(forget->vtable->init(forget, &context));
+
+    // A miss first, then the key stored through another tool
+    char* text = NULL;
+    TEST(run_tool(recall, "{\"key\": \"editor\"}", false, NULL));
+    TEST(run_tool(store, "{\"key\": \"editor\", \"content\": \"The user edits in vim\"}", true, NULL));
+    TEST(run_tool(recall, "{\"key\": \"editor\"}", true, &text));
+    TEST(strstr(text, "The user edits in vim") != NULL);
+    free(text);
+
+    // Forgetting through a third tool is seen by recall as well
+    TEST(run_tool(forget, "{\"key\": \"editor\"}", true, NULL));
+    TEST(run_tool(recall, "{\"key\": \"editor\"}", false, NULL));
+
+    tool_free(store);
+    tool_free(recall);
+    tool_free(forget);
+    memory_free(memory);
+    return true;
+}
+
+static bool test_memory_compression(void) {
+    printf("Testing memory content compression...\n");
+
+    // Long, repetitive content typical of auto-saved conversations
+    char long_text[4096];
+    size_t used = 0;
+    for (int i = 0; used + 64 < sizeof(long_text); i++) {
+        used += (size_t)snprintf(long_text + used, sizeof(long_text) - used,
+                                 "The user prefers tabs over spaces (note %d). ", i);
+    }
+
+    // Frames round-trip; short inputs are left alone
+    void* frame = NULL;
+    size_t frame_len = 0;
+    TEST_OK(compress_frame(compress_codec_default(), long_text, used, &frame, &frame_len));
+    TEST(frame != NULL);
+    TEST(frame_len < used / 2);
+    TEST(compress_is_frame(frame, frame_len));
+
+    char* plain = NULL;
+    size_t plain_len = 0;
+    TEST_OK(decompress_frame(frame, frame_len, &plain, &plain_len));
+    TEST(plain_len == used && memcmp(plain, long_text, used) == 0 && plain[used] == '\0');
+    free(plain);
+    free(frame);
+
+    TEST_OK(compress_frame(compress_codec_default(), "short", 5, &frame, &frame_len));
+    TEST(frame == NULL);
+
+    // Deflate unless configuration names a codec; unknown names are rejected
+    TEST(compress_codec_default()->id == COMPRESS_CODEC_DEFLATE);
+    TEST(compress_codec_select(STR_NULL) == compress_codec_default());
+    TEST(compress_codec_select(STR_LIT("deflate"))->id == COMPRESS_CODEC_DEFLATE);
+    TEST(compress_codec_select(STR_LIT("lz4")) == NULL);
+
+    memory_config_t bad_config = memory_config_default();
+    bad_config.compression = true;
+    bad_config.compression_codec = STR_LIT("lz4");
+    memory_t* bad = NULL;
+    TEST(memory_create("sqlite", &bad_config, &bad) == ERR_NOT_IMPLEMENTED);
+
+    // SQLite stores frames but indexes and returns the plain text
+    memory_config_t config = memory_config_default();
+    config.compression = true;
+    config.cache_entries = 0;
+
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("sqlite", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    str_t key = STR_LIT("conversation_log");
+    str_t content = { .data = long_text, .len = (uint32_t)used };
+    memory_entry_t* entry = memory_entry_create(&key, &content, MEMORY_CATEGORY_CONVERSATION, NULL);
+    TEST(entry != NULL);
+    TEST_OK(memory->vtable->store(memory, entry));
+    memory_entry_free(entry);
+
+    memory_entry_t recalled = {0};
+    TEST_OK(memory->vtable->recall(memory, &key, &recalled));
+    TEST(recalled.content.len == used && memcmp(recalled.content.data, long_text, used) == 0);
+    entry_fields_free(&recalled);
+
+    str_t query = STR_LIT("spaces");
+    memory_search_opts_t opts = memory_search_opts_default();
+    memory_entry_t* results = NULL;
+    uint32_t count = 0;
+    TEST_OK(memory->vtable->search(memory, &query, &opts, &results, &count));
+    TEST(count == 1);
+    TEST(results[0].content.len == used);
+    memory_entry_array_free(results, count);
+
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+
+    return true;
+}
+
+static err_t store_text(memory_t* memory, const char* key_text, const char* content_text,
+                        memory_category_t category) {
+    str_t key = STR_VIEW(key_text);
+    str_t content = STR_VIEW(content_text);
+    memory_entry_t* entry = memory_entry_create(&key, &content, category, NULL);
+    if (!entry) return ERR_OUT_OF_MEMORY;
+    err_t err = memory->vtable->store(memory, entry);
+    memory_entry_free(entry);
+    return err;
+}
+
+// True when text is well-formed UTF-8
+static bool utf8_valid(const char* text) {
+    const unsigned char* p = (const unsigned char*)text;
+    while (*p) {
+        int extra = *p < 0x80 ? 0 : (*p & 0xE0) == 0xC0 ? 1 : (*p & 0xF0) == 0xE0 ? 2 : (*p & 0xF8) == 0xF0 ? 3 : -1;
+        if (extra < 0) return false;
+        p++;
+        for (int i = 0; i < extra; i++, p++) {
+            if ((*p & 0xC0) != 0x80) return false;
+        }
+    }
+    return true;
+}
+
+static size_t count_substr(const char* text, const char* needle) {
+    size_t count = 0;
+    for (const char* p = strstr(text, needle); p; p = strstr(p + 1, needle)) count++;
+    return count;
+}
+
+static bool test_memory_recall_formatting(void) {
+    printf("Testing memory_recall budgeting, snippets and highlighting...\n");
+
+    memory_config_t config = memory_config_default();
+    config.cache_entries = 0;
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("sqlite", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    tool_context_t context = tool_context_default();
+    TEST_OK(tool_context_set_memory(&context, memory));
+    tool_t* recall = NULL;
+    TEST_OK(memory_recall_tool_get_vtable()->create(&recall));
+    TEST_OK(recall->vtable->init(recall, &context));
+
+    // Every match is highlighted, whatever its case
+    TEST_OK(store_text(memory, "fmt_case", "Quokka facts: a QUOKKA smiles", MEMORY_CATEGORY_CORE));
+    char* text = NULL;
+    TEST(run_tool(recall, "{\"query\": \"quokka\"}", true, &text));
+    TEST(strstr(text, "**Quokka** facts: a **QUOKKA** smiles") != NULL);
+    free(text);
+
+    // Long content is cut to a window around the first match, and both
+    // cuts land on code point boundaries of the two-byte text around it
+    // (the odd-length prefix puts both cuts mid-sequence)
+    char body[4096] = "a";
+    size_t used = 1;
+    for (int i = 0; i < 600; i++) used += (size_t)snprintf(body + used, sizeof(body) - used, "\xc3\xa9");
+    used += (size_t)snprintf(body + used, sizeof(body) - used, " wombat ");
+    for (int i = 0; i < 600 && used + 3 < sizeof(body); i++) {
+        used += (size_t)snprintf(body + used, sizeof(body) - used, "\xc3\xa9");
+    }
+    TEST_OK(store_text(memory, "fmt_window", body, MEMORY_CATEGORY_CORE));
+    TEST(run_tool(recall, "{\"query\": \"wombat\"}", true, &text));
+    TEST(strstr(text, "**wombat**") != NULL);
+    TEST(strstr(text, "Content: ...") != NULL);
+    TEST(strlen(text) < used);
+    TEST(utf8_valid(text));
+    free(text);
+
+    // A small budget keeps the first entries and summarizes the rest
+    char content[400];
+    memset(content, 'x', sizeof(content) - 1);
+    content[sizeof(content) - 1] = '\0';
+    memcpy(content, "numbat ", 7);
+    for (int i = 0; i < 12; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "fmt_budget_%d", i);
+        TEST_OK(store_text(memory, key, content, MEMORY_CATEGORY_CORE));
+    }
+    TEST(run_tool(recall, "{\"query\": \"numbat\", \"limit\": 12, \"max_tokens\": 256}", true, &text));
+    size_t shown = count_substr(text, "Key: fmt_budget_");
+    TEST(shown >= 1 && shown < 12);
+    TEST(strstr(text, "omitted to stay within 256 tokens") != NULL);
+    TEST(strlen(text) <= 256 * 4 + 64);
+    free(text);
+
+    // The full set fits a large budget
+    TEST(run_tool(recall, "{\"query\": \"numbat\", \"limit\": 12, \"max_tokens\": 8192}", true, &text));
+    TEST(count_substr(text, "Key: fmt_budget_") == 12);
+    TEST(strstr(text, "omitted") == NULL);
+    free(text);
+
+    tool_free(recall);
+    memory_free(memory);
+    return true;
+}
+
+static void* store_during_backup(void* arg) {
+    memory_t* memory = arg;
+    for (int i = 0; i < 200; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "live-%d", i);
+        if (store_text(memory, key, "written while the backup runs", MEMORY_CATEGORY_DAILY) != ERR_OK) {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+static bool sqlite_has_table(sqlite3* db, const char* name) {
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE name = ?;", -1, &stmt, NULL) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+static bool test_sqlite_contentless_index(void) {
+    printf("Testing the SQLite full-text index keeps no text...\n");
+
+    char dir[] = "/tmp/cclaw-memory-test-XXXXXX";
+    TEST(mkdtemp(dir) != NULL);
+    char db_path[64];
+    snprintf(db_path, sizeof(db_path), "%s/memories.db", dir);
+
+    // A database from before the contentless index, filled by a trigger
+    // that calls a function only old builds registered
+    sqlite3* raw = NULL;
+    TEST(sqlite3_open(db_path, &raw) == SQLITE_OK);
+    TEST(sqlite3_exec(raw,
+                      "CREATE TABLE memories (id TEXT PRIMARY KEY, key TEXT NOT NULL, content TEXT NOT NULL,"
+                      "  category INTEGER NOT NULL, timestamp TEXT NOT NULL, session_id TEXT,"
+                      "  score REAL DEFAULT 1.0,"
+                      "  created_at INTEGER NOT NULL DEFAULT (strftime('%s', 'now')),"
+                      "  updated_at INTEGER NOT NULL DEFAULT (strftime('%s', 'now')));"
+                      "CREATE VIRTUAL TABLE memories_fts USING fts5(key, content, tokenize='porter');"
+                      "INSERT INTO memories (id, key, content, category, timestamp)"
+                      "  VALUES ('old-1', 'legacy', 'walrus sighting', 0, '2026-01-01T00:00:00Z');"
+                      "INSERT INTO memories_fts(rowid, key, content)"
+                      "  SELECT rowid, key, content FROM memories;"
+                      "CREATE TRIGGER memories_ai AFTER INSERT ON memories BEGIN"
+                      "  INSERT INTO memories_fts(rowid, key, content)"
+                      "  VALUES (new.rowid, new.key, memory_plain(new.content));"
+                      "END;",
+                      NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_close(raw);
+
+    memory_config_t config = memory_config_default();
+    config.data_dir = STR_VIEW(dir);
+    config.compression = true;
+    config.cache_entries = 0;
+
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("sqlite", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    // The old index was replaced and refilled from the rows
+    memory_search_opts_t opts = memory_search_opts_default();
+    memory_entry_t* results = NULL;
+    uint32_t count = 0;
+    str_t query = STR_LIT("walrus");
+    TEST_OK(memory->vtable->search(memory, &query, &opts, &results, &count));
+    TEST(count == 1);
+    memory_entry_array_free(results, count);
+
+    // Compressed rows are indexed by their plain text
+    char long_text[2048];
+    size_t used = 0;
+    for (int i = 0; used + 64 < sizeof(long_text); i++) {
+        used += (size_t)snprintf(long_text + used, sizeof(long_text) - used,
+                                 "The penguin colony moved north (note %d). ", i);
+    }
+    TEST_OK(store_text(memory, "colony", long_text, MEMORY_CATEGORY_CORE));
+    query = STR_LIT("penguin");
+    TEST_OK(memory->vtable->search(memory, &query, &opts, &results, &count));
+    TEST(count == 1);
+    memory_entry_array_free(results, count);
+
+    // Forgetting removes the index entry along with the row
+    str_t key = STR_LIT("colony");
+    TEST_OK(memory->vtable->forget(memory, &key));
+    err_t err = memory->vtable->search(memory, &query, &opts, &results, &count);
+    TEST((err == ERR_OK || err == ERR_NOT_FOUND) && count == 0);
+    memory_entry_array_free(results, count);
+
+    // No second copy of the text, and no trigger other clients would need
+    // a CClaw function for
+    TEST(sqlite3_open(db_path, &raw) == SQLITE_OK);
+    TEST(sqlite_has_table(raw, "memories_fts"));
+    TEST(!sqlite_has_table(raw, "memories_fts_content"));
+    TEST(!sqlite_has_table(raw, "memories_ai"));
+    TEST(sqlite3_exec(raw,
+                      "INSERT INTO memories (id, key, content, category, timestamp)"
+                      "  VALUES ('other-1', 'external', 'plain text', 0, '2026-01-01T00:00:00Z');",
+                      NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_close(raw);
+
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+
+    const char* files[] = {"memories.db", "memories.db-wal", "memories.db-shm"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        char path[96];
+        snprintf(path, sizeof(path), "%s/%s", dir, files[i]);
+        unlink(path);
+    }
+    TEST(rmdir(dir) == 0);
+    return true;
+}
+
+static bool test_sqlite_backup_restore(void) {
+    printf("Testing SQLite online backup and restore...\n");
+
+    char dir[] = "/tmp/cclaw-memory-test-XXXXXX";
+    TEST(mkdtemp(dir) != NULL);
+
+    memory_config_t config = memory_config_default();
+    config.data_dir = STR_VIEW(dir);
+    config.cache_entries = 0;
+
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("sqlite", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    for (int i = 0; i < 500; i++) {
+        char key[32];
+        char content[64];
+        snprintf(key, sizeof(key), "key-%d", i);
+        snprintf(content, sizeof(content), "note %d: the user prefers tabs", i);
+        TEST_OK(store_text(memory, key, content, MEMORY_CATEGORY_CORE));
+    }
+
+    // Writers keep going while the backup copies pages
+    char backup[64];
+    snprintf(backup, sizeof(backup), "%s/backup.db", dir);
+    str_t backup_path = STR_VIEW(backup);
+
+    pthread_t writer;
+    TEST(pthread_create(&writer, NULL, store_during_backup, memory) == 0);
+    err_t backup_err = memory->vtable->backup(memory, &backup_path);
+    void* writer_failed = NULL;
+    pthread_join(writer, &writer_failed);
+    TEST_OK(backup_err);
+    TEST(writer_failed == NULL);
+
+    uint32_t total = 0;
+    TEST_OK(memory->vtable->get_stats(memory, &total, NULL));
+    TEST(total == 700);
+
+    // Changes after the backup are rolled back by the restore
+    TEST_OK(store_text(memory, "after_backup", "zebra crossing", MEMORY_CATEGORY_CORE));
+    uint64_t generation = memory_generation(memory);
+    TEST_OK(memory->vtable->restore(memory, &backup_path));
+    TEST(memory_generation(memory) != generation);
+
+    TEST_OK(memory->vtable->get_stats(memory, &total, NULL));
+    TEST(total >= 500 && total <= 700);
+
+    str_t key = STR_LIT("after_backup");
+    memory_entry_t recalled = {0};
+    TEST(memory->vtable->recall(memory, &key, &recalled) == ERR_NOT_FOUND);
+    key = STR_LIT("key-42");
+    TEST_OK(memory->vtable->recall(memory, &key, &recalled));
+    TEST(str_equal_cstr(recalled.content, "note 42: the user prefers tabs"));
+    entry_fields_free(&recalled);
+
+    // The full-text index was rebuilt from the restored rows
+    memory_search_opts_t opts = memory_search_opts_default();
+    memory_entry_t* results = NULL;
+    uint32_t count = 0;
+    str_t query = STR_LIT("zebra");
+    err_t err = memory->vtable->search(memory, &query, &opts, &results, &count);
+    TEST((err == ERR_OK || err == ERR_NOT_FOUND) && count == 0);
+    memory_entry_array_free(results, count);
+
+    query = STR_LIT("tabs");
+    TEST_OK(memory->vtable->search(memory, &query, &opts, &results, &count));
+    TEST(count > 0);
+    memory_entry_array_free(results, count);
+
+    // New rows are indexed again
+    TEST_OK(store_text(memory, "after_restore", "giraffe", MEMORY_CATEGORY_CORE));
+    query = STR_LIT("giraffe");
+    TEST_OK(memory->vtable->search(memory, &query, &opts, &results, &count));
+    TEST(count == 1);
+    memory_entry_array_free(results, count);
+
+    // A file that is not a backup leaves the database alone
+    char bogus[64];
+    snprintf(bogus, sizeof(bogus), "%s/bogus.db", dir);
+    FILE* file = fopen(bogus, "w");
+    TEST(file != NULL);
+    fputs("not a database", file);
+    fclose(file);
+    str_t bogus_path = STR_VIEW(bogus);
+    TEST(memory->vtable->restore(memory, &bogus_path) != ERR_OK);
+    key = STR_LIT("after_restore");
+    TEST_OK(memory->vtable->recall(memory, &key, &recalled));
+    entry_fields_free(&recalled);
+
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+
+    const char* files[] = {"memories.db", "memories.db-wal", "memories.db-shm", "backup.db", "bogus.db"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        char path[96];
+        snprintf(path, sizeof(path), "%s/%s", dir, files[i]);
+        unlink(path);
+    }
+    TEST(rmdir(dir) == 0);
+    return true;
+}
+
+#define POOL_THREADS 8
+#define POOL_RECALLS 400
+
+typedef struct pool_worker_t {
+    memory_t* memory;
+    int id;
+    bool failed;
+} pool_worker_t;
+
+static void* recall_worker(void* arg) {
+    pool_worker_t* worker = arg;
+    for (int i = 0; i < POOL_RECALLS; i++) {
+        char key_text[32];
+        char expected[64];
+        int n = (worker->id * 31 + i) % 200;
+        snprintf(key_text, sizeof(key_text), "key-%d", n);
+        snprintf(expected, sizeof(expected), "note %d: the user prefers tabs", n);
+
+        str_t key = STR_VIEW(key_text);
+        memory_entry_t recalled = {0};
+        if (worker->memory->vtable->recall(worker->memory, &key, &recalled) != ERR_OK ||
+            !str_equal_cstr(recalled.content, expected)) {
+            worker->failed = true;
+        }
+        entry_fields_free(&recalled);
+
+        if (i % 20 == 0) {
+            str_t query = STR_LIT("tabs");
+            memory_search_opts_t opts = memory_search_opts_default();
+            memory_entry_t* results = NULL;
+            uint32_t count = 0;
+            if (worker->memory->vtable->search(worker->memory, &query, &opts, &results, &count) != ERR_OK ||
+                count == 0) {
+                worker->failed = true;
+            }
+            memory_entry_array_free(results, count);
+        }
+    }
+    return NULL;
+}
+
+static void* store_worker(void* arg) {
+    pool_worker_t* worker = arg;
+    for (int i = 0; i < 200; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "session-%d", i);
+        if (store_text(worker->memory, key, "stored alongside readers", MEMORY_CATEGORY_CONVERSATION) != ERR_OK) {
+            worker->failed = true;
+        }
+    }
+    return NULL;
+}
+
+// Recalls from POOL_THREADS sessions while one more keeps storing
+static bool run_concurrent_sessions(const char* dir, uint32_t readers, double* out_ms) {
+    memory_config_t config = memory_config_default();
+    config.data_dir = STR_VIEW(dir);
+    config.cache_entries = 0;
+    config.reader_connections = readers;
+
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("sqlite", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    uint32_t total = 0;
+    TEST_OK(memory->vtable->get_stats(memory, &total, NULL));
+    for (int i = (int)total; i < 200; i++) {
+        char key[32];
+        char content[64];
+        snprintf(key, sizeof(key), "key-%d", i);
+        snprintf(content, sizeof(content), "note %d: the user prefers tabs", i);
+        TEST_OK(store_text(memory, key, content, MEMORY_CATEGORY_CORE));
+    }
+
+    pthread_t threads[POOL_THREADS + 1];
+    pool_worker_t workers[POOL_THREADS + 1];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i <= POOL_THREADS; i++) {
+        workers[i] = (pool_worker_t){ .memory = memory, .id = i };
+        TEST(pthread_create(&threads[i], NULL, i < POOL_THREADS ? recall_worker : store_worker,
+                            &workers[i]) == 0);
+    }
+    bool failed = false;
+    for (int i = 0; i <= POOL_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        failed |= workers[i].failed;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST(!failed);
+
+    // Readers see everything the writer committed
+    TEST_OK(memory->vtable->get_stats(memory, &total, NULL));
+    TEST(total >= 400);
+
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+
+    *out_ms = (double)(end.tv_sec - start.tv_sec) * 1000.0 + (double)(end.tv_nsec - start.tv_nsec) / 1e6;
+    return true;
+}
+
+static bool test_sqlite_reader_pool(void) {
+    printf("Testing SQLite reader connections under concurrent sessions...\n");
+
+    char dir[] = "/tmp/cclaw-memory-test-XXXXXX";
+    TEST(mkdtemp(dir) != NULL);
+
+    double shared_ms = 0;
+    double pooled_ms = 0;
+    TEST(run_concurrent_sessions(dir, 0, &shared_ms));
+    TEST(run_concurrent_sessions(dir, MEMORY_READER_CONNECTIONS_DEFAULT, &pooled_ms));
+    printf("  %d recalls: %.0f ms on one connection, %.0f ms with %d readers\n",
+           POOL_THREADS * POOL_RECALLS, shared_ms, pooled_ms, MEMORY_READER_CONNECTIONS_DEFAULT);
+
+    const char* files[] = {"memories.db", "memories.db-wal", "memories.db-shm"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        char path[96];
+        snprintf(path, sizeof(path), "%s/%s", dir, files[i]);
+        unlink(path);
+    }
+    TEST(rmdir(dir) == 0);
+    return true;
+}
+
+static bool test_markdown_backup_restore(void) {
+    printf("Testing markdown backup to a tar archive and restore...\n");
+
+    char dir[] = "/tmp/cclaw-memory-test-XXXXXX";
+    TEST(mkdtemp(dir) != NULL);
+    char base[64];
+    snprintf(base, sizeof(base), "%s/md", dir);
+
+    memory_config_t config = memory_config_default();
+    config.data_dir = STR_VIEW(base);
+    config.cache_entries = 0;
+
+    memory_t* memory = NULL;
+    TEST_OK(memory_create("markdown", &config, &memory));
+    TEST_OK(memory->vtable->init(memory));
+
+    // One key long enough to need a pax header in the archive
+    char long_key[160];
+    memset(long_key, 'k', sizeof(long_key) - 1);
+    long_key[sizeof(long_key) - 1] = '\0';
+
+    TEST_OK(store_text(memory, "tabs", "the user prefers tabs", MEMORY_CATEGORY_CORE));
+    TEST_OK(store_text(memory, "standup", "standup moved to 10am", MEMORY_CATEGORY_DAILY));
+    TEST_OK(store_text(memory, long_key, "a long key", MEMORY_CATEGORY_CUSTOM));
+
+    char archive[64];
+    snprintf(archive, sizeof(archive), "%s/memories.tar", dir);
+    str_t archive_path = STR_VIEW(archive);
+    TEST_OK(memory->vtable->backup(memory, &archive_path));
+
+    TEST_OK(store_text(memory, "later", "not in the backup", MEMORY_CATEGORY_CORE));
+    uint32_t counts[4] = {0};
+    uint32_t total = 0;
+    TEST_OK(memory->vtable->get_stats(memory, &total, counts));
+    TEST(total == 4);
+
+    TEST_OK(memory->vtable->restore(memory, &archive_path));
+    TEST_OK(memory->vtable->get_stats(memory, &total, counts));
+    TEST(total == 3 && counts[0] == 1 && counts[1] == 1 && counts[3] == 1);
+
+    memory_search_opts_t opts = memory_search_opts_default();
+    memory_entry_t* results = NULL;
+    uint32_t count = 0;
+    str_t query = STR_LIT("tabs");
+    TEST_OK(memory->vtable->search(memory, &query, &opts, &results, &count));
+    TEST(count == 1 && strstr(results[0].content.data, "the user prefers tabs"));
+    memory_entry_array_free(results, count);
+
+    // Entries that would land outside the category directories are refused
+    char evil[64];
+    snprintf(evil, sizeof(evil), "%s/evil.tar", dir);
+    FILE* out = fopen(evil, "wb");
+    TEST(out != NULL);
+    TEST_OK(tar_write_directory(out, "core/../../escape", 0755, 0));
+    TEST_OK(tar_write_end(out));
+    fclose(out);
+    str_t evil_path = STR_VIEW(evil);
+    TEST(memory->vtable->restore(memory, &evil_path) == ERR_MEMORY_CORRUPT);
+    TEST_OK(memory->vtable->get_stats(memory, &total, NULL));
+    TEST(total == 3);
+
+    // A category that cannot be swapped in puts back the ones before it
+    TEST_OK(store_text(memory, "later", "not in the backup", MEMORY_CATEGORY_CORE));
+    char conversation[96];
+    snprintf(conversation, sizeof(conversation), "%s/conversation", base);
+    TEST(rmdir(conversation) == 0);
+    TEST(memory->vtable->restore(memory, &archive_path) == ERR_IO);
+    TEST_OK(memory->vtable->get_stats(memory, &total, counts));
+    TEST(total == 4 && counts[0] == 2 && counts[1] == 1 && counts[3] == 1);
+
+    memory->vtable->cleanup(memory);
+    memory->vtable->destroy(memory);
+
+    char command[128];
+    snprintf(command, sizeof(command), "rm -rf %s", dir);
+    TEST(system(command) == 0);
+    return true;
+}
+
 int main(void) {
     printf("CClaw Memory System Tests\n");
     printf("========================\n\n");
@@ -255,6 +1000,70 @@ int main(void) {
         failed++;
     }
 
+    if (test_memory_cache()) {
+        printf("✓ test_memory_cache passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_memory_cache failed\n\n");
+        failed++;
+    }
+
+    if (test_memory_tools_share_memory()) {
+        printf("✓ test_memory_tools_share_memory passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_memory_tools_share_memory failed\n\n");
+        failed++;
+    }
+
+    if (test_memory_recall_formatting()) {
+        printf("✓ test_memory_recall_formatting passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_memory_recall_formatting failed\n\n");
+        failed++;
+    }
+
+    if (test_memory_compression()) {
+        printf("✓ test_memory_compression passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_memory_compression failed\n\n");
+        failed++;
+    }
+
+    if (test_sqlite_contentless_index()) {
+        printf("✓ test_sqlite_contentless_index passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_sqlite_contentless_index failed\n\n");
+        failed++;
+    }
+
+    if (test_sqlite_backup_restore()) {
+        printf("✓ test_sqlite_backup_restore passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_sqlite_backup_restore failed\n\n");
+        failed++;
+    }
+
+    if (test_sqlite_reader_pool()) {
+        printf("✓ test_sqlite_reader_pool passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_sqlite_reader_pool failed\n\n");
+        failed++;
+    }
+
+    if (test_markdown_backup_restore()) {
+        printf("✓ test_markdown_backup_restore passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_markdown_backup_restore failed\n\n");
+        failed++;
+    }
+
     if (test_null_backend()) {
         printf("✓ test_null_backend passed\n\n");
         passed++;
@@ -0,0 +1,383 @@
+// test_prefetch.c - Speculative tool execution tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/agent.h"
+#include "core/prefetch.h"
+#include "utils/clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+#define TOOL_MS 150
+#define GEN_MS 150
+
+// ============================================================================
+// Fake tools: a slow read-only lookup and a writer
+// ============================================================================
+
+static uint32_t g_reads = 0;
+static uint32_t g_writes = 0;
+
+static str_t read_get_name(void) { return STR_LIT("slow_read"); }
+static str_t write_get_name(void) { return STR_LIT("write"); }
+static bool tool_yes(void) { return true; }
+static bool tool_no(void) { return false; }
+
+static void fake_tool_destroy(tool_t* tool) {
+    free(tool);
+}
+
+static err_t read_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    usleep(TOOL_MS * 1000);
+    uint32_t run = __atomic_add_fetch(&g_reads, 1, __ATOMIC_SEQ_CST);
+    char text[128];
+    snprintf(text, sizeof(text), "run %u %.*s", run, (int)args->len, args->data);
+    str_t content = STR_VIEW(text);
+    tool_result_set_success(out_result, &content);
+    return ERR_OK;
+}
+
+static err_t write_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    __atomic_add_fetch(&g_writes, 1, __ATOMIC_SEQ_CST);
+    str_t content = STR_LIT("written");
+    tool_result_set_success(out_result, &content);
+    return ERR_OK;
+}
+
+static const tool_vtable_t read_vtable = {
+    .get_name = read_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = read_execute,
+    .is_read_only = tool_yes,
+};
+
+static const tool_vtable_t write_vtable = {
+    .get_name = write_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = write_execute,
+    .is_read_only = tool_no,
+};
+
+// ============================================================================
+// Fake provider: streams the scripted tool calls, keeps "generating" for
+// GEN_MS, then confirms g_final. The next call answers in plain text.
+// ============================================================================
+
+static const char* g_streamed[4];   // Arguments streamed for slow_read
+static const char* g_final = NULL;
+static bool g_tool_turn = true;
+static uint32_t g_stream_calls = 0;
+static uint32_t g_plain_calls = 0;
+
+static const provider_vtable_t fake_vtable;
+
+static err_t fake_chat(provider_t* provider, const chat_message_t* messages, uint32_t message_count,
+                       const tool_def_t* tools, uint32_t tool_count, const char* model,
+                       double temperature, chat_response_t** out_response) {
+    g_plain_calls++;
+    chat_response_t* response = chat_response_create();
+    response->content = alloc_str(PROVIDER_ALLOC, STR_LIT("plain"));
+    *out_response = response;
+    return ERR_OK;
+}
+
+static err_t fake_chat_stream_tools(provider_t* provider, const chat_message_t* messages,
+                                    uint32_t message_count, const tool_def_t* tools,
+                                    uint32_t tool_count, const char* model, double temperature,
+                                    const chat_stream_handler_t* handler,
+                                    chat_response_t** out_response) {
+    g_stream_calls++;
+    chat_response_t* response = chat_response_create();
+
+    if (!g_tool_turn) {
+        response->content = alloc_str(PROVIDER_ALLOC, STR_LIT("done"));
+        *out_response = response;
+        return ERR_OK;
+    }
+    g_tool_turn = false;
+
+    // Arguments arrive in two fragments, split mid-key
+    stream_tool_calls_t* acc = malloc(sizeof(stream_tool_calls_t));
+    stream_tool_calls_init(acc);
+    for (uint32_t i = 0; i < 4 && g_streamed[i]; i++) {
+        size_t half = strlen(g_streamed[i]) / 2;
+        char first[64];
+        snprintf(first, sizeof(first), "%.*s", (int)half, g_streamed[i]);
+        stream_tool_calls_add(acc, i, "call", "slow_read", first, handler);
+        stream_tool_calls_add(acc, i, NULL, NULL, g_streamed[i] + half, handler);
+    }
+    stream_tool_calls_free(acc);
+    free(acc);
+
+    usleep(GEN_MS * 1000);
+    response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC, g_final);
+    *out_response = response;
+    return ERR_OK;
+}
+
+static const provider_vtable_t fake_vtable = {
+    .chat = fake_chat,
+    .chat_stream_tools = fake_chat_stream_tools,
+};
+
+static agent_t* agent_with_tools(void) {
+    agent_t* agent = NULL;
+    if (agent_create(NULL, &agent) != ERR_OK) return NULL;
+
+    provider_t* provider = calloc(1, sizeof(provider_t));
+    provider->vtable = &fake_vtable;
+    agent->ctx->provider = provider;
+
+    agent->ctx->tools = calloc(2, sizeof(tool_t*));
+    agent->ctx->tools[0] = tool_alloc(&read_vtable);
+    agent->ctx->tools[1] = tool_alloc(&write_vtable);
+    agent->ctx->tools[0]->initialized = true;
+    agent->ctx->tools[1]->initialized = true;
+    agent->ctx->tool_count = 2;
+    return agent;
+}
+
+static void agent_free(agent_t* agent) {
+    free(agent->ctx->provider);
+    agent->ctx->provider = NULL;
+    agent_destroy(agent);
+}
+
+static void script(const char* streamed0, const char* streamed1, const char* final) {
+    memset(g_streamed, 0, sizeof(g_streamed));
+    g_streamed[0] = streamed0;
+    g_streamed[1] = streamed1;
+    g_final = final;
+    g_tool_turn = true;
+    g_reads = 0;
+    g_writes = 0;
+}
+
+// Run one user turn; returns the message holding the tool results
+static agent_message_t* run_turn(agent_t* agent, uint64_t* out_elapsed) {
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("test");
+    if (agent_session_create(agent, &name, &session) != ERR_OK) return NULL;
+
+    str_t input = STR_LIT("look it up");
+    str_t output = STR_NULL;
+    uint64_t started = clock_monotonic_ms();
+    err_t err = agent_process_message(agent, session, &input, &output);
+    *out_elapsed = clock_monotonic_ms() - started;
+    free((void*)output.data);
+
+    if (err != ERR_OK || !session->current) return NULL;
+    return session->current->parent;
+}
+
+static bool has_result(agent_message_t* call_msg, const char* text) {
+    for (uint32_t i = 0; i < call_msg->child_count; i++) {
+        agent_message_t* child = call_msg->children[i];
+        if (child->type == AGENT_MSG_TOOL_RESULT && str_equal_cstr(child->content, text)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static uint32_t g_announced = 0;
+static char g_announced_args[64];
+
+static void record_tool_call(uint32_t index, str_t name, str_t arguments, void* user_data) {
+    g_announced++;
+    snprintf(g_announced_args, sizeof(g_announced_args), "%.*s:%.*s",
+             (int)name.len, name.data, (int)arguments.len, arguments.data);
+}
+
+static bool test_stream_assembly(void) {
+    printf("Testing streamed tool call assembly...\n");
+
+    chat_stream_handler_t handler = { .on_tool_call = record_tool_call };
+    stream_tool_calls_t* acc = malloc(sizeof(stream_tool_calls_t));
+    TEST(acc != NULL);
+    stream_tool_calls_init(acc);
+
+    stream_tool_calls_add(acc, 0, "call_1", "file_", NULL, &handler);
+    stream_tool_calls_add(acc, 0, NULL, "read", "{\"path\":", &handler);
+    stream_tool_calls_add(acc, 0, NULL, NULL, "\"a}b\\\"", &handler);   // Brace inside a string
+    TEST(g_announced == 0);
+    stream_tool_calls_add(acc, 0, NULL, NULL, "\"}", &handler);
+    TEST(g_announced == 1);
+    TEST(strcmp(g_announced_args, "file_read:{\"path\":\"a}b\\\"\"}") == 0);
+
+    // Reported once, even if more bytes trail
+    stream_tool_calls_add(acc, 0, NULL, NULL, " ", &handler);
+    stream_tool_calls_add(acc, 1, "call_2", "shell", "{\"command\":\"ls\"}", &handler);
+    TEST(g_announced == 2);
+
+    str_t json = stream_tool_calls_to_json(acc);
+    TEST(strstr(json.data, "\"id\":\"call_1\"") != NULL);
+    TEST(strstr(json.data, "\"name\":\"file_read\"") != NULL);
+    TEST(strstr(json.data, "\"name\":\"shell\"") != NULL);
+    free_str(PROVIDER_ALLOC, json);
+
+    stream_tool_calls_free(acc);
+    free(acc);
+    return true;
+}
+
+static bool test_prefetch_overlaps(void) {
+    printf("Testing prefetch overlaps generation...\n");
+
+    agent_t* agent = agent_with_tools();
+    TEST(agent != NULL);
+
+    script("{\"key\":\"a\"}", NULL,
+           "[{\"id\":\"call\",\"type\":\"function\","
+           "\"function\":{\"name\":\"slow_read\",\"arguments\":\"{\\\"key\\\":\\\"a\\\"}\"}}]");
+    uint64_t elapsed = 0;
+    agent_message_t* call_msg = run_turn(agent, &elapsed);
+    TEST(call_msg != NULL);
+    TEST(call_msg->type == AGENT_MSG_TOOL_CALL);
+
+    // The lookup ran once, during generation
+    TEST(g_reads == 1);
+    TEST(has_result(call_msg, "run 1 {\"key\":\"a\"}"));
+    TEST(elapsed < GEN_MS + TOOL_MS / 2);
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_prefetch_discarded(void) {
+    printf("Testing unconfirmed calls are discarded...\n");
+
+    agent_t* agent = agent_with_tools();
+    TEST(agent != NULL);
+
+    // The stream suggested "x", the final response asked for "y"
+    script("{\"key\":\"x\"}", NULL,
+           "[{\"function\":{\"name\":\"slow_read\",\"arguments\":{\"key\":\"y\"}}}]");
+    uint64_t elapsed = 0;
+    agent_message_t* call_msg = run_turn(agent, &elapsed);
+    TEST(call_msg != NULL);
+    TEST(g_reads == 2);
+    TEST(has_result(call_msg, "run 2 {\"key\":\"y\"}"));
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_prefetch_after_write(void) {
+    printf("Testing side effects invalidate later speculation...\n");
+
+    agent_t* agent = agent_with_tools();
+    TEST(agent != NULL);
+
+    // Both reads were streamed, but the second is confirmed after a write
+    script("{\"key\":\"a\"}", "{\"key\":\"b\"}",
+           "[{\"function\":{\"name\":\"slow_read\",\"arguments\":\"{\\\"key\\\":\\\"a\\\"}\"}},"
+           "{\"function\":{\"name\":\"write\",\"arguments\":\"{}\"}},"
+           "{\"function\":{\"name\":\"slow_read\",\"arguments\":\"{\\\"key\\\":\\\"b\\\"}\"}}]");
+    uint64_t elapsed = 0;
+    agent_message_t* call_msg = run_turn(agent, &elapsed);
+    TEST(call_msg != NULL);
+    TEST(g_writes == 1);
+    TEST(g_reads == 3);
+    TEST(has_result(call_msg, "run 1 {\"key\":\"a\"}"));
+    TEST(has_result(call_msg, "run 3 {\"key\":\"b\"}"));
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_prefetch_disabled(void) {
+    printf("Testing speculation can be turned off...\n");
+
+    agent_config_t config = agent_config_default();
+    config.speculative_tools = false;
+    agent_t* agent = agent_with_tools();
+    TEST(agent != NULL);
+    agent->ctx->config = config;
+
+    g_stream_calls = 0;
+    g_plain_calls = 0;
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("test");
+    TEST_OK(agent_session_create(agent, &name, &session));
+    str_t input = STR_LIT("hello");
+    str_t output = STR_NULL;
+    TEST_OK(agent_process_message(agent, session, &input, &output));
+    TEST(str_equal_cstr(output, "plain"));
+    TEST(g_stream_calls == 0 && g_plain_calls == 1);
+    TEST(agent->ctx->prefetch == NULL);
+    free((void*)output.data);
+
+    agent_free(agent);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Prefetch Tests\n");
+    printf("====================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_stream_assembly()) {
+        printf("✓ test_stream_assembly passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_stream_assembly failed\n\n");
+        failed++;
+    }
+
+    if (test_prefetch_overlaps()) {
+        printf("✓ test_prefetch_overlaps passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_prefetch_overlaps failed\n\n");
+        failed++;
+    }
+
+    if (test_prefetch_discarded()) {
+        printf("✓ test_prefetch_discarded passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_prefetch_discarded failed\n\n");
+        failed++;
+    }
+
+    if (test_prefetch_after_write()) {
+        printf("✓ test_prefetch_after_write passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_prefetch_after_write failed\n\n");
+        failed++;
+    }
+
+    if (test_prefetch_disabled()) {
+        printf("✓ test_prefetch_disabled passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_prefetch_disabled failed\n\n");
+        failed++;
+    }
+
+    printf("====================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+// test_rag.c - Workspace retrieval index tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/rag.h"
+#include "core/tool.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+static char g_root[64];
+
+static void write_file(const char* rel, const char* content, size_t len) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", g_root, rel);
+
+    // Create parent directories
+    for (char* p = path + strlen(g_root) + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(content, 1, len, f);
+    fclose(f);
+}
+
+static void write_text(const char* rel, const char* content) {
+    write_file(rel, content, strlen(content));
+}
+
+static bool make_workspace(void) {
+    snprintf(g_root, sizeof(g_root), "/tmp/cclaw_rag_XXXXXX");
+    if (!mkdtemp(g_root)) return false;
+
+    write_text("src/net/retry.c",
+               "// Exponential backoff with jitter for failed requests\n"
+               "static uint64_t compute_retry_backoff(uint32_t attempt) {\n"
+               "    uint64_t delay = base_delay_ms << attempt;\n"
+               "    return delay + jitter(delay);\n"
+               "}\n");
+    write_text("src/ui/render.c",
+               "void render_frame(canvas_t* canvas) {\n"
+               "    for (int i = 0; i < canvas->widget_count; i++) draw_widget(canvas->widgets[i]);\n"
+               "}\n");
+    write_text("docs/intro.md",
+               "# Getting started\n\nInstall the package and run the setup wizard.\n");
+
+    // Forty short lines with one distinctive word near the end
+    char big[2048] = "";
+    for (int i = 1; i <= 40; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "line %d %s\n", i, i == 37 ? "zebra crossing" : "filler text");
+        strcat(big, line);
+    }
+    write_text("notes/big.txt", big);
+
+    write_file("assets/blob.bin", "\x7f" "ELF\0\0zebra", 11);
+    write_text("node_modules/lib/index.js", "function zebra() {}\n");
+    write_text(".hidden/secret.txt", "zebra\n");
+    return true;
+}
+
+static void remove_workspace(void) {
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_root);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "could not remove %s\n", g_root);
+    }
+}
+
+static bool test_hash_embedder(void) {
+    printf("Testing hashing embedder...\n");
+
+    rag_embedder_t* embedder = rag_hash_embedder_create(0);
+    TEST(embedder != NULL);
+    TEST(embedder->dimensions == RAG_HASH_DIMENSIONS);
+
+    str_t texts[3] = {
+        STR_LIT("computeRetryBackoff"),
+        STR_LIT("how is the backoff for a retry computed"),
+        STR_LIT("render the frame"),
+    };
+    float* vecs = malloc(sizeof(float) * RAG_HASH_DIMENSIONS * 3);
+    TEST(vecs != NULL);
+    TEST_OK(embedder->embed(embedder, texts, 3, vecs));
+
+    float same = 0, other = 0, norm = 0;
+    for (uint32_t d = 0; d < RAG_HASH_DIMENSIONS; d++) {
+        same += vecs[d] * vecs[RAG_HASH_DIMENSIONS + d];
+        other += vecs[d] * vecs[2 * RAG_HASH_DIMENSIONS + d];
+        norm += vecs[d] * vecs[d];
+    }
+    TEST(norm > 0.99f && norm < 1.01f);
+    TEST(same > 0.3f);          // Sub-words of the identifier match the words
+    TEST(other < 0.1f);
+
+    free(vecs);
+    rag_embedder_free(embedder);
+    return true;
+}
+
+static bool test_index_search(void) {
+    printf("Testing index build and search...\n");
+
+    rag_index_t* index = NULL;
+    TEST_OK(rag_index_open(STR_VIEW(g_root), 16, rag_hash_embedder_create(0), &index));
+
+    rag_update_stats_t stats;
+    TEST_OK(rag_index_update(index, &stats));
+    TEST(stats.files == 5);     // Skipped directories are not walked
+    TEST(stats.files_embedded == 5);
+    TEST(stats.files_reused == 0);
+    TEST(stats.chunks > 5);     // big.txt is split at 64 bytes
+
+    rag_hit_t* hits = NULL;
+    uint32_t count = 0;
+    TEST_OK(rag_index_search(index, STR_LIT("retry backoff"), 3, STR_NULL, &hits, &count));
+    TEST(count == 3);
+    TEST(str_equal_cstr(hits[0].path, "src/net/retry.c"));
+    TEST(hits[0].start_line == 1);
+    TEST(!hits[0].stale);
+    TEST(strstr(hits[0].snippet.data, "Exponential backoff") != NULL);
+    TEST(hits[0].score >= hits[1].score && hits[1].score >= hits[2].score);
+    rag_hits_free(hits, count);
+
+    // Line ranges point at the chunk holding the word
+    TEST_OK(rag_index_search(index, STR_LIT("zebra"), 1, STR_NULL, &hits, &count));
+    TEST(count == 1);
+    TEST(str_equal_cstr(hits[0].path, "notes/big.txt"));
+    TEST(hits[0].start_line <= 37 && hits[0].end_line >= 37);
+    TEST(hits[0].end_line - hits[0].start_line < 8);
+    TEST(strstr(hits[0].snippet.data, "line 37 zebra crossing") != NULL);
+    rag_hits_free(hits, count);
+
+    TEST_OK(rag_index_search(index, STR_LIT("retry backoff"), 5, STR_LIT("docs/"), &hits, &count));
+    TEST(count >= 1);
+    for (uint32_t i = 0; i < count; i++) {
+        TEST(str_equal_cstr(hits[i].path, "docs/intro.md"));
+    }
+    rag_hits_free(hits, count);
+
+    rag_index_close(index);
+    return true;
+}
+
+static bool test_incremental_update(void) {
+    printf("Testing incremental re-indexing...\n");
+
+    // Reopening loads the saved index; nothing needs embedding
+    rag_index_t* index = NULL;
+    TEST_OK(rag_index_open(STR_VIEW(g_root), 16, rag_hash_embedder_create(0), &index));
+    rag_update_stats_t stats;
+    TEST_OK(rag_index_update(index, &stats));
+    TEST(stats.files_embedded == 0);
+    TEST(stats.files_reused == 5);
+
+    write_text("src/ui/render.c", "void render_frame(void) { paint_sprites(); }\n");
+    char path[128];
+    snprintf(path, sizeof(path), "%s/docs/intro.md", g_root);
+    TEST(unlink(path) == 0);
+
+    TEST_OK(rag_index_update(index, &stats));
+    TEST(stats.files == 4);
+    TEST(stats.files_embedded == 1);
+    TEST(stats.files_reused == 3);
+    TEST(stats.files_removed == 1);
+
+    // A search notices new files without an explicit update
+    write_text("src/math/quat.c", "quat_t quaternion_slerp(quat_t a, quat_t b, float t);\n");
+    rag_hit_t* hits = NULL;
+    uint32_t count = 0;
+    TEST_OK(rag_index_search(index, STR_LIT("quaternion slerp"), 1, STR_NULL, &hits, &count));
+    TEST(count == 1);
+    TEST(str_equal_cstr(hits[0].path, "src/math/quat.c"));
+    rag_hits_free(hits, count);
+
+    // A different chunk size invalidates the saved index
+    rag_index_close(index);
+    TEST_OK(rag_index_open(STR_VIEW(g_root), 32, rag_hash_embedder_create(0), &index));
+    TEST_OK(rag_index_update(index, &stats));
+    TEST(stats.files_embedded == 5);
+
+    rag_index_close(index);
+    return true;
+}
+
+static bool test_search_tool(void) {
+    printf("Testing workspace_search tool...\n");
+
+    tool_t* tool = NULL;
+    TEST_OK(workspace_search_tool_get_vtable()->create(&tool));
+
+    tool_context_t context = tool_context_default();
+    context.workspace_dir = STR_VIEW(g_root);
+    TEST_OK(tool->vtable->init(tool, &context));
+
+    str_t args = STR_LIT("{\"query\":\"paint sprites\",\"limit\":2}");
+    tool_result_t result = tool_result_create();
+    TEST_OK(tool->vtable->execute(tool, &args, &result));
+    TEST(result.success);
+    TEST(strncmp(result.content.data, "src/ui/render.c:1-1 (score ", 27) == 0);
+    TEST(strstr(result.content.data, "paint_sprites(); }\n```\n") != NULL);
+    tool_result_free(&result);
+
+    args = STR_LIT("{\"limit\":2}");
+    TEST_OK(tool->vtable->execute(tool, &args, &result));
+    TEST(!result.success);
+    tool_result_free(&result);
+
+    tool_free(tool);
+    return true;
+}
+
+static bool test_damaged_index(void) {
+    printf("Testing damaged index and snippet cuts...\n");
+
+    // One line longer than a snippet, cut inside a two-byte character
+    char wide[1700] = "walrus ";
+    for (int i = 0; i < 800; i++) strcat(wide, "\xc3\xa9");
+    strcat(wide, "\n");
+    write_text("notes/wide.txt", wide);
+
+    rag_index_t* index = NULL;
+    TEST_OK(rag_index_open(STR_VIEW(g_root), 32, rag_hash_embedder_create(0), &index));
+    rag_update_stats_t stats;
+    TEST_OK(rag_index_update(index, &stats));
+
+    rag_hit_t* hits = NULL;
+    uint32_t count = 0;
+    TEST_OK(rag_index_search(index, STR_LIT("walrus"), 1, STR_LIT("notes/wide.txt"), &hits, &count));
+    TEST(count == 1);
+    TEST(hits[0].snippet.len == RAG_SNIPPET_MAX_BYTES - 1);
+    TEST((unsigned char)hits[0].snippet.data[hits[0].snippet.len - 1] == 0xa9);
+    rag_hits_free(hits, count);
+    rag_index_close(index);
+
+    // The saved index is reused as long as it is intact
+    TEST_OK(rag_index_open(STR_VIEW(g_root), 32, rag_hash_embedder_create(0), &index));
+    TEST_OK(rag_index_update(index, &stats));
+    TEST(stats.files_embedded == 0);
+    rag_index_close(index);
+
+    // Point the first file record's path past the string table. Its
+    // path_offset sits 24 bytes into the record, after the 40-byte header.
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s/%s", g_root, RAG_INDEX_DIR, RAG_INDEX_FILE);
+    FILE* f = fopen(path, "r+b");
+    TEST(f != NULL);
+    uint32_t bad_offset = 0xfffffff0u;
+    TEST(fseek(f, 40 + 24, SEEK_SET) == 0);
+    TEST(fwrite(&bad_offset, sizeof(bad_offset), 1, f) == 1);
+    fclose(f);
+
+    // Rejected on load and rebuilt
+    TEST_OK(rag_index_open(STR_VIEW(g_root), 32, rag_hash_embedder_create(0), &index));
+    TEST_OK(rag_index_update(index, &stats));
+    TEST(stats.files_embedded == stats.files);
+    TEST(stats.files_reused == 0);
+    rag_index_close(index);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw RAG Tests\n");
+    printf("===============\n\n");
+
+    if (!make_workspace()) {
+        printf("Could not create a temporary workspace\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_hash_embedder()) {
+        printf("✓ test_hash_embedder passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_hash_embedder failed\n\n");
+        failed++;
+    }
+
+    if (test_index_search()) {
+        printf("✓ test_index_search passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_index_search failed\n\n");
+        failed++;
+    }
+
+    if (test_incremental_update()) {
+        printf("✓ test_incremental_update passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_incremental_update failed\n\n");
+        failed++;
+    }
+
+    if (test_search_tool()) {
+        printf("✓ test_search_tool passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_search_tool failed\n\n");
+        failed++;
+    }
+
+    if (test_damaged_index()) {
+        printf("✓ test_damaged_index passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_damaged_index failed\n\n");
+        failed++;
+    }
+
+    remove_workspace();
+
+    printf("===============\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
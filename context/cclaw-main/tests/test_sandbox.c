@@ -0,0 +1,314 @@
+// test_sandbox.c - Namespace sandbox tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/sandbox.h"
+#include "core/config.h"
+#include "core/tool.h"
+#include "utils/clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+#define THREADS 8
+#define CALLS_PER_THREAD 10
+
+static char g_workspace[64];
+static sandbox_t* g_sandbox;
+
+static bool test_isolation(void) {
+    printf("Testing commands run in their own namespaces and root...\n");
+
+    sandbox_result_t result;
+    TEST_OK(sandbox_exec(g_sandbox, "echo hello; hostname; pwd", 5000, 4096, &result));
+    TEST(result.exit_code == 0 && !result.timed_out);
+    char expected[160];
+    snprintf(expected, sizeof(expected), "hello\ncclaw-sandbox\n%s\n", g_workspace);
+    TEST(strcmp(result.output, expected) == 0);
+    sandbox_result_free(&result);
+
+    // A host file outside the workspace is not there
+    char secret[64];
+    snprintf(secret, sizeof(secret), "/tmp/cclaw-sandbox-secret-%d", (int)getpid());
+    FILE* file = fopen(secret, "w");
+    TEST(file != NULL);
+    fputs("secret", file);
+    fclose(file);
+
+    char command[128];
+    snprintf(command, sizeof(command), "cat %s", secret);
+    TEST_OK(sandbox_exec(g_sandbox, command, 5000, 4096, &result));
+    TEST(result.exit_code != 0 && strncmp(result.output, "secret", 6) != 0);
+    sandbox_result_free(&result);
+    unlink(secret);
+
+    // Another pid namespace, locked down
+    char host_ns[64] = {0};
+    TEST(readlink("/proc/self/ns/pid", host_ns, sizeof(host_ns) - 1) > 0);
+    TEST_OK(sandbox_exec(g_sandbox, "readlink /proc/self/ns/pid; grep -E '^(Seccomp|NoNewPrivs|CapEff):' /proc/self/status",
+                         5000, 4096, &result));
+    TEST(result.exit_code == 0);
+    TEST(strncmp(result.output, "pid:[", 5) == 0 && !strstr(result.output, host_ns));
+    TEST(strstr(result.output, "NoNewPrivs:\t1"));
+    TEST(strstr(result.output, "Seccomp:\t2"));
+    TEST(strstr(result.output, "CapEff:\t0000000000000000"));
+    sandbox_result_free(&result);
+
+    // Nothing left to escape with
+    TEST_OK(sandbox_exec(g_sandbox, "touch /usr/cclaw-test || touch /cclaw-test", 5000, 4096, &result));
+    TEST(result.exit_code != 0);
+    sandbox_result_free(&result);
+    return true;
+}
+
+static bool test_workspace_files(void) {
+    printf("Testing file access through the sandbox...\n");
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/notes.txt", g_workspace);
+    TEST_OK(sandbox_write_file(g_sandbox, path, "from the sandbox", 16, false));
+
+    // Written to the real workspace
+    char buffer[32] = {0};
+    FILE* file = fopen(path, "r");
+    TEST(file != NULL);
+    TEST(fread(buffer, 1, sizeof(buffer) - 1, file) == 16);
+    fclose(file);
+    TEST(strcmp(buffer, "from the sandbox") == 0);
+
+    char* data = NULL;
+    size_t len = 0;
+    TEST_OK(sandbox_read_file(g_sandbox, path, 1024, &data, &len));
+    TEST(len == 16 && strcmp(data, "from the sandbox") == 0);
+    free(data);
+
+    TEST(sandbox_read_file(g_sandbox, path, 8, &data, &len) == ERR_FILE_TOO_LARGE);
+    TEST(sandbox_write_file(g_sandbox, path, "again", 5, false) == ERR_FILE_EXISTS);
+    TEST_OK(sandbox_write_file(g_sandbox, path, "again", 5, true));
+
+    // Outside the workspace: read-only system directories, or nothing at all
+    TEST(sandbox_write_file(g_sandbox, "/etc/cclaw-test", "x", 1, true) != ERR_OK);
+    TEST(sandbox_write_file(g_sandbox, "/root/cclaw-test", "x", 1, true) != ERR_OK);
+    TEST(access("/root/cclaw-test", F_OK) != 0);
+    TEST(sandbox_read_file(g_sandbox, "/root/.bashrc", 1 << 20, &data, &len) != ERR_OK);
+    return true;
+}
+
+static bool test_timeouts_and_limits(void) {
+    printf("Testing timeouts, exit codes and output limits...\n");
+
+    sandbox_result_t result;
+    uint64_t start = clock_monotonic_ms();
+    TEST_OK(sandbox_exec(g_sandbox, "sleep 10 & sleep 10", 200, 4096, &result));
+    TEST(result.timed_out);
+    TEST(clock_monotonic_ms() - start < 3000);
+    sandbox_result_free(&result);
+
+    TEST_OK(sandbox_exec(g_sandbox, "echo partial; exit 3", 5000, 4096, &result));
+    TEST(result.exit_code == 3 && strcmp(result.output, "partial\n") == 0);
+    sandbox_result_free(&result);
+
+    TEST_OK(sandbox_exec(g_sandbox, "head -c 100000 /dev/zero", 5000, 1000, &result));
+    TEST(result.exit_code == 0 && result.truncated && result.output_len == 1000);
+    sandbox_result_free(&result);
+    return true;
+}
+
+static void* run_calls(void* arg) {
+    intptr_t id = (intptr_t)arg;
+    for (int i = 0; i < CALLS_PER_THREAD; i++) {
+        char command[32];
+        char expected[32];
+        snprintf(command, sizeof(command), "echo %d-%d", (int)id, i);
+        snprintf(expected, sizeof(expected), "%d-%d\n", (int)id, i);
+
+        sandbox_result_t result;
+        if (sandbox_exec(g_sandbox, command, 5000, 4096, &result) != ERR_OK) return (void*)1;
+        bool ok = result.exit_code == 0 && strcmp(result.output, expected) == 0;
+        sandbox_result_free(&result);
+        if (!ok) return (void*)1;
+    }
+    return NULL;
+}
+
+static bool test_concurrent_calls(void) {
+    printf("Testing concurrent calls share one zygote...\n");
+
+    pthread_t threads[THREADS];
+    uint64_t start = clock_monotonic_ms();
+    for (intptr_t i = 0; i < THREADS; i++) {
+        TEST(pthread_create(&threads[i], NULL, run_calls, (void*)i) == 0);
+    }
+    bool ok = true;
+    for (int i = 0; i < THREADS; i++) {
+        void* failed = NULL;
+        pthread_join(threads[i], &failed);
+        if (failed) ok = false;
+    }
+    TEST(ok);
+    printf("  %d calls in %llu ms\n", THREADS * CALLS_PER_THREAD,
+           (unsigned long long)(clock_monotonic_ms() - start));
+    return true;
+}
+
+static bool test_shell_tool(void) {
+    printf("Testing the shell tool runs in the sandbox when given one...\n");
+
+    tool_t* shell = NULL;
+    TEST_OK(shell_tool_get_vtable()->create(&shell));
+    tool_context_t context = tool_context_default();
+    context.workspace_dir = STR_VIEW(g_workspace);
+    TEST_OK(tool_context_set_sandbox(&context, g_sandbox));
+    TEST_OK(shell->vtable->init(shell, &context));
+
+    tool_result_t result = tool_result_create();
+    str_t args = STR_LIT("echo sandboxed");
+    TEST_OK(shell->vtable->execute(shell, &args, &result));
+    TEST(result.success && str_equal_cstr(result.content, "sandboxed\n"));
+    tool_result_free(&result);
+
+    args = STR_LIT("cat /nonexistent");
+    TEST(shell->vtable->execute(shell, &args, &result) == ERR_TOOL_EXECUTION_FAILED);
+    TEST(!result.success && strstr(result.error_message.data, "exit code 1"));
+    tool_result_free(&result);
+
+    shell->vtable->destroy(shell);
+    return true;
+}
+
+static bool test_config_from(void) {
+    printf("Testing the sandbox config follows autonomy.workspace_only...\n");
+
+    config_t config = {0};
+    config.autonomy.workspace_only = true;
+    sandbox_config_t sandbox_config = sandbox_config_from(&config, STR_VIEW(g_workspace));
+    TEST(!sandbox_config.home_writable);
+    TEST(str_equal_cstr(sandbox_config.workspace_dir, g_workspace));
+
+    config.autonomy.workspace_only = false;
+    sandbox_config = sandbox_config_from(&config, STR_VIEW(g_workspace));
+    TEST(sandbox_config.home_writable);
+
+    // $HOME is bound next to the workspace when it is writable
+    char home[64];
+    snprintf(home, sizeof(home), "/tmp/cclaw-sandbox-home-XXXXXX");
+    TEST(mkdtemp(home) != NULL);
+    const char* saved = getenv("HOME");
+    char* saved_home = saved ? strdup(saved) : NULL;
+    setenv("HOME", home, 1);
+
+    sandbox_t* sandbox = NULL;
+    err_t err = sandbox_create(&sandbox_config, &sandbox);
+    if (saved_home) setenv("HOME", saved_home, 1);
+    else unsetenv("HOME");
+    free(saved_home);
+    TEST_OK(err);
+
+    char path[96];
+    snprintf(path, sizeof(path), "%s/profile", home);
+    TEST_OK(sandbox_write_file(sandbox, path, "home", 4, false));
+    TEST(access(path, F_OK) == 0);
+    sandbox_destroy(sandbox);
+
+    unlink(path);
+    rmdir(home);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Sandbox Tests\n");
+    printf("===================\n\n");
+
+    snprintf(g_workspace, sizeof(g_workspace), "/tmp/cclaw-sandbox-test-XXXXXX");
+    if (!mkdtemp(g_workspace)) return 1;
+
+    sandbox_config_t config = {
+        .workspace_dir = STR_VIEW(g_workspace),
+        .read_only_rootfs = true,
+        .memory_limit_mb = 512,
+    };
+    err_t err = sandbox_create(&config, &g_sandbox);
+    if (err == ERR_SANDBOX_FAILED || err == ERR_NOT_IMPLEMENTED) {
+        // Not Linux, or unprivileged user namespaces are disabled here
+        printf("Sandbox unavailable, skipping: %.*s\n", (int)error_last()->message.len, error_last()->message.data);
+        rmdir(g_workspace);
+        return 0;
+    }
+    if (err != ERR_OK) return 1;
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_isolation()) {
+        printf("✓ test_isolation passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_isolation failed\n\n");
+        failed++;
+    }
+
+    if (test_workspace_files()) {
+        printf("✓ test_workspace_files passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_workspace_files failed\n\n");
+        failed++;
+    }
+
+    if (test_timeouts_and_limits()) {
+        printf("✓ test_timeouts_and_limits passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_timeouts_and_limits failed\n\n");
+        failed++;
+    }
+
+    if (test_concurrent_calls()) {
+        printf("✓ test_concurrent_calls passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_concurrent_calls failed\n\n");
+        failed++;
+    }
+
+    if (test_shell_tool()) {
+        printf("✓ test_shell_tool passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_shell_tool failed\n\n");
+        failed++;
+    }
+
+    if (test_config_from()) {
+        printf("✓ test_config_from passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_config_from failed\n\n");
+        failed++;
+    }
+
+    sandbox_destroy(g_sandbox);
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/notes.txt", g_workspace);
+    unlink(path);
+    rmdir(g_workspace);
+
+    printf("===================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+// test_string.c - String builder and interning tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/alloc.h"
+#include "core/intern.h"
+#include "core/str_builder.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+static bool test_builder_append(void) {
+    printf("Testing string builder appends...\n");
+
+    char stack[16];
+    str_builder_t sb;
+    str_builder_init_buffer(&sb, NULL, stack, sizeof(stack));
+
+    str_builder_append_cstr(&sb, "id=");
+    str_builder_append_int(&sb, INT64_MIN);
+    TEST(sb.owns_data);     // Outgrew the stack buffer
+    str_builder_append_char(&sb, ' ');
+    str_builder_append_uint(&sb, 0);
+    str_builder_append_char(&sb, ' ');
+    str_builder_append_float(&sb, 0.1);
+    str_builder_append_char(&sb, ' ');
+    str_builder_append_float(&sb, 1.0 / 3.0);
+    TEST(str_equal_cstr(str_builder_view(&sb),
+                        "id=-9223372036854775808 0 0.1 0.33333333333333331"));
+
+    str_builder_reset(&sb);
+    str_builder_append(&sb, STR_LIT("say \"hi\"\n\t\\"));
+    str_builder_append_json_escaped(&sb, STR_LIT("say \"hi\"\n\t\\\x01"));
+    TEST(str_equal_cstr(str_builder_view(&sb),
+                        "say \"hi\"\n\t\\say \\\"hi\\\"\\n\\t\\\\\\u0001"));
+
+    // Formatting past the reserved space takes the second pass
+    str_builder_reset(&sb);
+    char big[1000];
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    str_builder_appendf(&sb, "<%s|%d>", big, 7);
+    TEST(sb.len == sizeof(big) - 1 + 4);
+    TEST(sb.data[0] == '<' && sb.data[sb.len - 1] == '>');
+
+    str_t s = str_builder_finish(&sb, NULL);
+    TEST(s.len == sizeof(big) - 1 + 4);
+    TEST(s.data[s.len] == '\0');
+    TEST(sb.data == NULL);
+    free((void*)s.data);
+    return true;
+}
+
+static bool test_builder_allocators(void) {
+    printf("Testing string builder allocators...\n");
+
+    tracking_allocator_t* tracker = tracking_create(NULL);
+    TEST(tracker != NULL);
+    allocator_t* a = &tracker->base;
+    alloc_stats_t stats;
+
+    // Fits the stack buffer: exactly one allocation, for the result
+    str_t s = str_format(a, "%s-%d", "model", 42);
+    TEST(str_equal_cstr(s, "model-42"));
+    tracking_get_stats(tracker, &stats);
+    TEST(stats.allocation_count == 1);
+    TEST(stats.live_count == 1);
+    free_str(a, s);
+
+    s = str_dup_cstr("tool_name", a);
+    TEST(str_equal_cstr(s, "tool_name"));
+    str_t copy = str_dup(s, a);
+    TEST(str_equal(copy, s) && copy.data != s.data);
+    free_str(a, s);
+    free_str(a, copy);
+
+    tracking_get_stats(tracker, &stats);
+    TEST(stats.live_count == 0);
+    TEST(stats.live_bytes == 0);
+    tracking_destroy(tracker);
+
+    // Building into an arena and finishing there costs no copy
+    arena_allocator_t* arena = arena_create(4096);
+    TEST(arena != NULL);
+
+    str_builder_t sb;
+    str_builder_init(&sb, &arena->base);
+    for (int i = 0; i < 100; i++) {
+        str_builder_appendf(&sb, "%d,", i);
+    }
+    const char* built = sb.data;
+    str_t joined = str_builder_finish(&sb, &arena->base);
+    TEST(joined.data == built);
+    TEST(joined.len == 10 * 2 + 90 * 3);
+    TEST(strncmp(joined.data, "0,1,2,", 6) == 0);
+
+    // Exhausting the arena fails the builder instead of truncating
+    static char filler[8192];
+    str_builder_init(&sb, &arena->base);
+    str_builder_append_bytes(&sb, filler, sizeof(filler));
+    str_builder_append_cstr(&sb, "ignored");
+    TEST(sb.failed);
+    TEST(str_empty(str_builder_finish(&sb, &arena->base)));
+
+    arena_reset(arena);
+    TEST(arena->used == 0);
+    arena_destroy(arena);
+    return true;
+}
+
+static bool test_intern_basic(void) {
+    printf("Testing string interning...\n");
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "gpt-%d", 4);
+
+    str_t a = str_intern_cstr("gpt-4");
+    str_t b = str_intern(STR_VIEW(buf));
+    TEST(str_equal_cstr(a, "gpt-4"));
+    TEST(a.data != buf);
+    TEST(str_interned_equal(a, b));
+    TEST(!str_interned_equal(a, str_intern_cstr("gpt-5")));
+    TEST(str_intern(STR_LIT("")).len == 0);
+
+    // Large strings get their own storage
+    char* large = malloc(100000);
+    TEST(large != NULL);
+    memset(large, 'x', 99999);
+    large[99999] = '\0';
+    str_t big = str_intern_cstr(large);
+    TEST(big.len == 99999 && big.data[big.len] == '\0');
+    TEST(str_interned_equal(big, str_intern_cstr(large)));
+    free(large);
+
+    intern_stats_t stats;
+    str_intern_stats(&stats);
+    TEST(stats.strings == 3);
+    TEST(stats.inserts == 3);
+    TEST(stats.lookups == 5);
+
+    str_intern_shutdown();
+    str_intern_stats(&stats);
+    TEST(stats.strings == 0 && stats.bytes == 0);
+    return true;
+}
+
+#define INTERN_THREADS 8
+#define INTERN_NAMES 2000
+
+static void* intern_worker(void* arg) {
+    str_t* out = arg;
+    char name[32];
+    for (int i = 0; i < INTERN_NAMES; i++) {
+        snprintf(name, sizeof(name), "session-%d", i);
+        out[i] = str_intern_cstr(name);
+    }
+    return NULL;
+}
+
+static bool test_intern_threads(void) {
+    printf("Testing concurrent interning...\n");
+
+    static str_t results[INTERN_THREADS][INTERN_NAMES];
+    pthread_t threads[INTERN_THREADS];
+    for (int t = 0; t < INTERN_THREADS; t++) {
+        TEST(pthread_create(&threads[t], NULL, intern_worker, results[t]) == 0);
+    }
+    for (int t = 0; t < INTERN_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // Every thread got the same canonical pointer for each name
+    for (int i = 0; i < INTERN_NAMES; i++) {
+        TEST(results[0][i].data != NULL);
+        for (int t = 1; t < INTERN_THREADS; t++) {
+            TEST(str_interned_equal(results[0][i], results[t][i]));
+        }
+    }
+
+    intern_stats_t stats;
+    str_intern_stats(&stats);
+    TEST(stats.strings == INTERN_NAMES);
+
+    str_intern_shutdown();
+    return true;
+}
+
+int main(void) {
+    printf("CClaw String Tests\n");
+    printf("==================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_builder_append()) {
+        printf("✓ test_builder_append passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_builder_append failed\n\n");
+        failed++;
+    }
+
+    if (test_builder_allocators()) {
+        printf("✓ test_builder_allocators passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_builder_allocators failed\n\n");
+        failed++;
+    }
+
+    if (test_intern_basic()) {
+        printf("✓ test_intern_basic passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_intern_basic failed\n\n");
+        failed++;
+    }
+
+    if (test_intern_threads()) {
+        printf("✓ test_intern_threads passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_intern_threads failed\n\n");
+        failed++;
+    }
+
+    printf("==================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,365 @@
+// test_tool_cache.c - Tool result cache tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/agent.h"
+#include "core/tool_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+// ============================================================================
+// Fake tools: a lookup validated by g_generation, a memory writer and a
+// general writer
+// ============================================================================
+
+static uint64_t g_generation = 0;
+static uint32_t g_lookups = 0;
+
+static str_t lookup_get_name(void) { return STR_LIT("lookup"); }
+static str_t remember_get_name(void) { return STR_LIT("remember"); }
+static str_t run_get_name(void) { return STR_LIT("run"); }
+static bool tool_yes(void) { return true; }
+static bool tool_no(void) { return false; }
+
+static void fake_tool_destroy(tool_t* tool) {
+    free(tool);
+}
+
+static err_t lookup_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    g_lookups++;
+    char text[64];
+    snprintf(text, sizeof(text), "lookup %u", g_lookups);
+    str_t content = STR_VIEW(text);
+    tool_result_set_success(out_result, &content);
+    return ERR_OK;
+}
+
+static bool lookup_validator(tool_t* tool, const str_t* args, uint64_t* out_validator) {
+    *out_validator = g_generation;
+    return true;
+}
+
+static err_t writer_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    str_t content = STR_LIT("ok");
+    tool_result_set_success(out_result, &content);
+    return ERR_OK;
+}
+
+static const tool_vtable_t lookup_vtable = {
+    .get_name = lookup_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = lookup_execute,
+    .requires_memory = tool_yes,
+    .is_read_only = tool_yes,
+    .cache_validator = lookup_validator,
+};
+
+static const tool_vtable_t remember_vtable = {
+    .get_name = remember_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = writer_execute,
+    .requires_memory = tool_yes,
+    .is_read_only = tool_no,
+};
+
+static const tool_vtable_t run_vtable = {
+    .get_name = run_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = writer_execute,
+    .requires_memory = tool_no,
+    .is_read_only = tool_no,
+};
+
+// ============================================================================
+// Fake provider: answers the first call of a turn with g_calls, then text
+// ============================================================================
+
+static const char* g_calls = NULL;
+
+static err_t fake_chat(provider_t* provider, const chat_message_t* messages, uint32_t message_count,
+                       const tool_def_t* tools, uint32_t tool_count, const char* model,
+                       double temperature, chat_response_t** out_response) {
+    chat_response_t* response = chat_response_create();
+    if (g_calls) {
+        response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC, g_calls);
+        g_calls = NULL;
+    } else {
+        response->content = alloc_str(PROVIDER_ALLOC, STR_LIT("done"));
+    }
+    *out_response = response;
+    return ERR_OK;
+}
+
+static const provider_vtable_t fake_vtable = {
+    .chat = fake_chat,
+};
+
+static char g_dir[64];
+static char g_file[96];
+
+static agent_t* agent_with_tools(void) {
+    agent_t* agent = NULL;
+    if (agent_create(NULL, &agent) != ERR_OK) return NULL;
+
+    provider_t* provider = calloc(1, sizeof(provider_t));
+    provider->vtable = &fake_vtable;
+    agent->ctx->provider = provider;
+
+    tool_t* file_read = NULL;
+    if (file_read_tool_get_vtable()->create(&file_read) != ERR_OK) return NULL;
+    tool_context_t context = tool_context_default();
+    context.workspace_dir = STR_VIEW(g_dir);
+    if (file_read->vtable->init(file_read, &context) != ERR_OK) return NULL;
+
+    agent->ctx->tools = calloc(4, sizeof(tool_t*));
+    agent->ctx->tools[0] = file_read;
+    agent->ctx->tools[1] = tool_alloc(&lookup_vtable);
+    agent->ctx->tools[2] = tool_alloc(&remember_vtable);
+    agent->ctx->tools[3] = tool_alloc(&run_vtable);
+    for (uint32_t i = 1; i < 4; i++) agent->ctx->tools[i]->initialized = true;
+    agent->ctx->tool_count = 4;
+    return agent;
+}
+
+static void agent_free(agent_t* agent) {
+    free(agent->ctx->provider);
+    agent->ctx->provider = NULL;
+    agent_destroy(agent);
+}
+
+// One user turn with the given tool calls; returns the message holding
+// their results
+static agent_message_t* run_turn(agent_t* agent, agent_session_t* session, const char* calls) {
+    g_calls = calls;
+    str_t input = STR_LIT("go");
+    str_t output = STR_NULL;
+    if (agent_process_message(agent, session, &input, &output) != ERR_OK) return NULL;
+    free((void*)output.data);
+    return session->current ? session->current->parent : NULL;
+}
+
+static void write_file(const char* content) {
+    FILE* f = fopen(g_file, "w");
+    if (!f) return;
+    fputs(content, f);
+    fclose(f);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static bool test_canonical_args(void) {
+    printf("Testing canonical arguments...\n");
+
+    str_t canonical = tool_cache_canonical_args(STR_LIT(" {\"b\": 1.0, \"a\": [true, null, \"x\\\"y\"]} "));
+    TEST(str_equal_cstr(canonical, "{\"a\":[true,null,\"x\\\"y\"],\"b\":1}"));
+    free((void*)canonical.data);
+
+    canonical = tool_cache_canonical_args(STR_LIT("{\"z\":{\"d\":0.5,\"c\":-2}}"));
+    TEST(str_equal_cstr(canonical, "{\"z\":{\"c\":-2,\"d\":0.5}}"));
+    free((void*)canonical.data);
+
+    canonical = tool_cache_canonical_args(STR_LIT("/etc/hosts"));
+    TEST(str_equal_cstr(canonical, "/etc/hosts"));
+    free((void*)canonical.data);
+    return true;
+}
+
+static bool test_shared_outputs(void) {
+    printf("Testing shared outputs...\n");
+
+    tool_cache_t* cache = NULL;
+    TEST_OK(tool_cache_create(&cache));
+
+    tool_t* lookup = tool_alloc(&lookup_vtable);
+    tool_cache_key_t key;
+    TEST(tool_cache_key_init(&key, lookup, STR_LIT("{\"q\":1}")));
+
+    str_t out = STR_NULL;
+    TEST(!tool_cache_get(cache, &key, &out));
+    str_t shared = tool_output_share(STR_LIT("result"));
+    tool_cache_put(cache, &key, shared);
+    tool_output_release(shared);            // The cache keeps its own reference
+
+    TEST(tool_cache_get(cache, &key, &out));
+    TEST(out.data == shared.data);
+    TEST(str_equal_cstr(out, "result"));
+
+    // A moved validator turns the entry stale
+    tool_cache_key_free(&key);
+    g_generation++;
+    TEST(tool_cache_key_init(&key, lookup, STR_LIT("{ \"q\" : 1 }")));
+    str_t again = STR_NULL;
+    TEST(!tool_cache_get(cache, &key, &again));
+
+    tool_cache_stats_t stats;
+    tool_cache_stats(cache, &stats);
+    TEST(stats.hits == 1 && stats.stale == 1 && stats.entries == 0);
+
+    // The reference handed out earlier outlives the entry
+    TEST(str_equal_cstr(out, "result"));
+    tool_output_release(out);
+
+    tool_cache_key_free(&key);
+    tool_cache_destroy(cache);
+    tool_free(lookup);
+    return true;
+}
+
+static bool test_file_read_cached(void) {
+    printf("Testing file_read results across turns...\n");
+
+    write_file("first version\n");
+    agent_t* agent = agent_with_tools();
+    TEST(agent != NULL);
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("cache");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    // Twice in one response: the second is served from the first
+    char calls[512];
+    snprintf(calls, sizeof(calls),
+             "[{\"function\":{\"name\":\"file_read\",\"arguments\":{\"path\":\"%s\"}}},"
+             "{\"function\":{\"name\":\"file_read\",\"arguments\":{\"path\": \"%s\"}}}]",
+             g_file, g_file);
+    agent_message_t* call_msg = run_turn(agent, session, calls);
+    TEST(call_msg != NULL);
+    agent_message_t* first = call_msg->children[0];
+    agent_message_t* second = call_msg->children[1];
+    TEST(str_equal_cstr(first->content, "first version\n"));
+    TEST(first->content_shared && second->content_shared);
+    TEST(first->content.data == second->content.data);
+
+    tool_cache_stats_t stats;
+    tool_cache_stats(session->tool_cache, &stats);
+    TEST(stats.hits == 1 && stats.misses == 1);
+
+    // Next turn, same file unchanged
+    snprintf(calls, sizeof(calls),
+             "[{\"function\":{\"name\":\"file_read\",\"arguments\":\"{\\\"path\\\":\\\"%s\\\"}\"}}]", g_file);
+    call_msg = run_turn(agent, session, calls);
+    TEST(call_msg != NULL);
+    TEST(call_msg->children[0]->content.data == first->content.data);
+
+    // Rewritten with the same size: still noticed
+    write_file("other version\n");
+    call_msg = run_turn(agent, session, calls);
+    TEST(call_msg != NULL);
+    TEST(str_equal_cstr(call_msg->children[0]->content, "other version\n"));
+    tool_cache_stats(session->tool_cache, &stats);
+    TEST(stats.hits == 2 && stats.stale == 1);
+
+    agent_free(agent);
+    return true;
+}
+
+static bool test_side_effects_invalidate(void) {
+    printf("Testing side effects invalidate entries...\n");
+
+    write_file("stable\n");
+    agent_t* agent = agent_with_tools();
+    TEST(agent != NULL);
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("writes");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    char file_call[256];
+    snprintf(file_call, sizeof(file_call),
+             "{\"function\":{\"name\":\"file_read\",\"arguments\":{\"path\":\"%s\"}}}", g_file);
+    const char* lookup_call = "{\"function\":{\"name\":\"lookup\",\"arguments\":{\"q\":\"x\"}}}";
+
+    char calls[1024];
+    snprintf(calls, sizeof(calls), "[%s,%s]", file_call, lookup_call);
+    TEST(run_turn(agent, session, calls) != NULL);
+    uint32_t lookups = g_lookups;
+
+    // A memory write drops the lookup but keeps the file
+    snprintf(calls, sizeof(calls),
+             "[{\"function\":{\"name\":\"remember\",\"arguments\":{}}},%s,%s]", file_call, lookup_call);
+    TEST(run_turn(agent, session, calls) != NULL);
+    TEST(g_lookups == lookups + 1);
+    tool_cache_stats_t stats;
+    tool_cache_stats(session->tool_cache, &stats);
+    TEST(stats.invalidations == 1);
+    TEST(stats.hits == 1);
+
+    // Anything else drops both
+    snprintf(calls, sizeof(calls),
+             "[{\"function\":{\"name\":\"run\",\"arguments\":{}}},%s,%s]", file_call, lookup_call);
+    TEST(run_turn(agent, session, calls) != NULL);
+    TEST(g_lookups == lookups + 2);
+    tool_cache_stats(session->tool_cache, &stats);
+    TEST(stats.invalidations == 3);
+    TEST(stats.hits == 1);
+
+    agent_free(agent);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Tool Cache Tests\n");
+    printf("======================\n\n");
+
+    snprintf(g_dir, sizeof(g_dir), "/tmp/cclaw_tool_cache_XXXXXX");
+    if (!mkdtemp(g_dir)) {
+        printf("Could not create a temporary directory\n");
+        return 1;
+    }
+    snprintf(g_file, sizeof(g_file), "%s/notes.txt", g_dir);
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_canonical_args()) {
+        printf("✓ test_canonical_args passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_canonical_args failed\n\n");
+        failed++;
+    }
+
+    if (test_shared_outputs()) {
+        printf("✓ test_shared_outputs passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_shared_outputs failed\n\n");
+        failed++;
+    }
+
+    if (test_file_read_cached()) {
+        printf("✓ test_file_read_cached passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_file_read_cached failed\n\n");
+        failed++;
+    }
+
+    if (test_side_effects_invalidate()) {
+        printf("✓ test_side_effects_invalidate passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_side_effects_invalidate failed\n\n");
+        failed++;
+    }
+
+    unlink(g_file);
+    rmdir(g_dir);
+
+    printf("======================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,396 @@
+// test_tool_output.c - Tool output spill tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/agent.h"
+#include "core/tool_output.h"
+#include "utils/sha256.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+static char g_dir[64];
+
+// n numbered lines of 20 bytes each
+static char* numbered_lines(uint32_t n) {
+    char* text = malloc((size_t)n * 20 + 1);
+    for (uint32_t i = 0; i < n; i++) {
+        snprintf(text + (size_t)i * 20, 21, "line %014u\n", i);
+    }
+    return text;
+}
+
+static bool blob_exists(const char* dir, const tool_output_handle_t* handle) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, handle->hex);
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// ============================================================================
+// Fake tool and provider: "dump" prints g_lines numbered lines
+// ============================================================================
+
+static uint32_t g_lines = 0;
+static const char* g_calls = NULL;
+
+static str_t dump_get_name(void) { return STR_LIT("dump"); }
+static bool tool_yes(void) { return true; }
+
+static void fake_tool_destroy(tool_t* tool) {
+    free(tool);
+}
+
+static err_t dump_execute(tool_t* tool, const str_t* args, tool_result_t* out_result) {
+    char* text = numbered_lines(g_lines);
+    str_t content = { .data = text, .len = g_lines * 20 };
+    tool_result_set_success(out_result, &content);
+    free(text);
+    return ERR_OK;
+}
+
+static const tool_vtable_t dump_vtable = {
+    .get_name = dump_get_name,
+    .destroy = fake_tool_destroy,
+    .execute = dump_execute,
+    .is_read_only = tool_yes,
+};
+
+static err_t fake_chat(provider_t* provider, const chat_message_t* messages, uint32_t message_count,
+                       const tool_def_t* tools, uint32_t tool_count, const char* model,
+                       double temperature, chat_response_t** out_response) {
+    chat_response_t* response = chat_response_create();
+    if (g_calls) {
+        response->tool_calls = alloc_str_cstr(PROVIDER_ALLOC, g_calls);
+        g_calls = NULL;
+    } else {
+        response->content = alloc_str(PROVIDER_ALLOC, STR_LIT("done"));
+    }
+    *out_response = response;
+    return ERR_OK;
+}
+
+static const provider_vtable_t fake_vtable = {
+    .chat = fake_chat,
+};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static bool test_sha256(void) {
+    printf("Testing SHA-256...\n");
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256("abc", 3, digest);
+    TEST(digest[0] == 0xba && digest[1] == 0x78 && digest[31] == 0xad);
+
+    // Fed in pieces that straddle blocks
+    const char* text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, text, 5);
+    sha256_update(&ctx, text + 5, strlen(text) - 5);
+    sha256_final(&ctx, digest);
+    TEST(digest[0] == 0x24 && digest[1] == 0x8d && digest[31] == 0xc1);
+    return true;
+}
+
+static bool test_store_put_and_read(void) {
+    printf("Testing store put and paged reads...\n");
+
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s/store/session", g_dir);
+    tool_output_store_t* store = NULL;
+    TEST_OK(tool_output_store_open(dir, &store));
+
+    char* text = numbered_lines(100);
+    str_t content = { .data = text, .len = 2000 };
+    tool_output_handle_t handle;
+    TEST_OK(tool_output_store_put(store, content, &handle));
+    TEST(strlen(handle.hex) == TOOL_OUTPUT_HANDLE_LEN);
+    TEST(blob_exists(dir, &handle));
+
+    // Same bytes, same handle
+    tool_output_handle_t again;
+    TEST_OK(tool_output_store_put(store, content, &again));
+    TEST(strcmp(handle.hex, again.hex) == 0);
+
+    str_t page = STR_NULL;
+    uint64_t total = 0;
+    TEST_OK(tool_output_read(store, STR_VIEW(handle.hex), 20, 40, &page, &total));
+    TEST(total == 2000);
+    TEST(str_equal_cstr(page, "line 00000000000001\nline 00000000000002\n"));
+    free((void*)page.data);
+
+    // Reads stop at the end
+    TEST_OK(tool_output_read(store, STR_VIEW(handle.hex), 1990, 100, &page, &total));
+    TEST(page.len == 10);
+    free((void*)page.data);
+
+    TEST(tool_output_read(store, STR_LIT("../../etc/passwd"), 0, 10, &page, &total) == ERR_NOT_FOUND);
+    TEST(tool_output_read(store, STR_LIT("0123456789abcdef"), 0, 10, &page, &total) == ERR_NOT_FOUND);
+    TEST(tool_output_read(NULL, STR_VIEW(handle.hex), 0, 10, &page, &total) == ERR_NOT_FOUND);
+
+    // Handles are looked up only in the store they were read through
+    char other_dir[128];
+    snprintf(other_dir, sizeof(other_dir), "%s/store/other", g_dir);
+    tool_output_store_t* other = NULL;
+    TEST_OK(tool_output_store_open(other_dir, &other));
+    TEST(tool_output_read(other, STR_VIEW(handle.hex), 0, 10, &page, &total) == ERR_NOT_FOUND);
+    tool_output_store_close(other, true);
+
+    // Closing with remove takes the blobs along
+    tool_output_store_close(store, true);
+    TEST(!blob_exists(dir, &handle));
+
+    free(text);
+    return true;
+}
+
+static bool test_excerpt(void) {
+    printf("Testing excerpts...\n");
+
+    char* text = numbered_lines(2000);
+    str_t content = { .data = text, .len = 40000 };
+    tool_output_handle_t handle = { .hex = "00112233aabbccdd" };
+    str_t excerpt = tool_output_excerpt(content, &handle);
+
+    TEST(excerpt.len < TOOL_OUTPUT_HEAD_BYTES + TOOL_OUTPUT_TAIL_BYTES + 256);
+    TEST(strstr(excerpt.data, "40000 bytes, 2000 lines") != NULL);
+    TEST(strstr(excerpt.data, "00112233aabbccdd") != NULL);
+    TEST(strstr(excerpt.data, "\nline 00000000000000\n") != NULL);
+    TEST(strstr(excerpt.data, "line 00000000001999\n") != NULL);
+
+    // Cut at line breaks: every numbered line shown is whole
+    const char* omitted = strstr(excerpt.data, "...[");
+    TEST(omitted != NULL && omitted[-1] == '\n');
+    const char* after = strchr(omitted, '\n') + 1;
+    TEST(strncmp(after, "line ", 5) == 0);
+    TEST(excerpt.data[excerpt.len - 1] == '\n');
+    free((void*)excerpt.data);
+
+    // Without a handle the content is still cut
+    excerpt = tool_output_excerpt(content, NULL);
+    TEST(strstr(excerpt.data, "tool_output_read") == NULL);
+    TEST(excerpt.len < 8 * 1024);
+    free((void*)excerpt.data);
+
+    free(text);
+    return true;
+}
+
+static bool test_agent_spills(void) {
+    printf("Testing the agent spills large results...\n");
+
+    agent_config_t config = agent_config_default();
+    char out_dir[128];
+    snprintf(out_dir, sizeof(out_dir), "%s/outputs", g_dir);
+    config.tool_output_dir = str_dup_cstr(out_dir, NULL);
+
+    agent_t* agent = NULL;
+    TEST_OK(agent_create(&config, &agent));
+    provider_t* provider = calloc(1, sizeof(provider_t));
+    provider->vtable = &fake_vtable;
+    agent->ctx->provider = provider;
+
+    tool_t* reader = NULL;
+    TEST_OK(tool_output_read_tool_get_vtable()->create(&reader));
+    tool_context_t context = tool_context_default();
+    TEST_OK(reader->vtable->init(reader, &context));
+    agent->ctx->tools = calloc(2, sizeof(tool_t*));
+    agent->ctx->tools[0] = tool_alloc(&dump_vtable);
+    agent->ctx->tools[0]->initialized = true;
+    agent->ctx->tools[1] = reader;
+    agent->ctx->tool_count = 2;
+
+    agent_session_t* session = NULL;
+    str_t name = STR_LIT("spill");
+    TEST_OK(agent_session_create(agent, &name, &session));
+
+    // A small result stays in the context
+    g_lines = 10;
+    g_calls = "[{\"function\":{\"name\":\"dump\",\"arguments\":{\"n\":1}}}]";
+    str_t input = STR_LIT("go");
+    str_t output = STR_NULL;
+    TEST_OK(agent_process_message(agent, session, &input, &output));
+    free((void*)output.data);
+    agent_message_t* small = session->current->parent->children[0];
+    TEST(small->content.len == 200);
+    TEST(session->tool_outputs == NULL);
+
+    g_lines = 5000;
+    g_calls = "[{\"function\":{\"name\":\"dump\",\"arguments\":{\"n\":2}}}]";
+    TEST_OK(agent_process_message(agent, session, &input, &output));
+    free((void*)output.data);
+    agent_message_t* large = session->current->parent->children[0];
+    TEST(large->content.len < 8 * 1024);
+    TEST(!large->content_shared);
+    TEST(session->tool_outputs != NULL);
+
+    const char* stored = strstr(large->content.data, "Stored as tool output ");
+    TEST(stored != NULL);
+    char hex[TOOL_OUTPUT_HANDLE_LEN + 1];
+    memcpy(hex, stored + strlen("Stored as tool output "), TOOL_OUTPUT_HANDLE_LEN);
+    hex[TOOL_OUTPUT_HANDLE_LEN] = '\0';
+
+    // The model pages through the rest
+    char calls[256];
+    snprintf(calls, sizeof(calls),
+             "[{\"function\":{\"name\":\"tool_output_read\","
+             "\"arguments\":{\"handle\":\"%s\",\"offset\":50000,\"length\":40}}}]", hex);
+    g_calls = calls;
+    TEST_OK(agent_process_message(agent, session, &input, &output));
+    free((void*)output.data);
+    agent_message_t* page = session->current->parent->children[0];
+    TEST(str_equal_cstr(page->content,
+                        "[bytes 50000-50039 of 100000]\nline 00000000002500\nline 00000000002501\n"));
+
+    g_calls = "[{\"function\":{\"name\":\"tool_output_read\","
+              "\"arguments\":{\"handle\":\"ffffffffffffffff\"}}}]";
+    TEST_OK(agent_process_message(agent, session, &input, &output));
+    free((void*)output.data);
+    agent_message_t* unknown = session->current->parent->children[0];
+    TEST(strstr(unknown->content.data, "Unknown tool output handle") != NULL);
+
+    // Another session of the same agent cannot read this session's outputs
+    agent_session_t* other = NULL;
+    str_t other_name = STR_LIT("other");
+    TEST_OK(agent_session_create(agent, &other_name, &other));
+    g_calls = calls;
+    TEST_OK(agent_process_message(agent, other, &input, &output));
+    free((void*)output.data);
+    agent_message_t* foreign = other->current->parent->children[0];
+    TEST(strstr(foreign->content.data, "Unknown tool output handle") != NULL);
+    TEST(tool_output_bound() == NULL);
+
+    // The session's directory goes with the agent
+    char session_dir[256];
+    snprintf(session_dir, sizeof(session_dir), "%s/%.*s", out_dir,
+             (int)session->id.len, session->id.data);
+    struct stat st;
+    TEST(stat(session_dir, &st) == 0 && (st.st_mode & 0777) == 0700);
+
+    free(agent->ctx->provider);
+    agent->ctx->provider = NULL;
+    agent_destroy(agent);
+    TEST(stat(session_dir, &st) != 0);
+    rmdir(out_dir);
+    return true;
+}
+
+static bool test_read_utf8_boundaries(void) {
+    printf("Testing pages keep whole characters...\n");
+
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s/utf8", g_dir);
+    tool_output_store_t* store = NULL;
+    TEST_OK(tool_output_store_open(dir, &store));
+
+    // "aé€b": a, C3 A9, E2 82 AC, b
+    str_t content = STR_LIT("a\xC3\xA9\xE2\x82\xAC" "b");
+    tool_output_handle_t handle;
+    TEST_OK(tool_output_store_put(store, content, &handle));
+
+    tool_t* reader = NULL;
+    TEST_OK(tool_output_read_tool_get_vtable()->create(&reader));
+    tool_output_store_t* outer = tool_output_bind(store);
+
+    // Ends inside the euro sign: it is left for the next page
+    char args[128];
+    snprintf(args, sizeof(args), "{\"handle\":\"%s\",\"offset\":0,\"length\":5}", handle.hex);
+    str_t args_str = STR_VIEW(args);
+    tool_result_t result = tool_result_create();
+    TEST_OK(reader->vtable->execute(reader, &args_str, &result));
+    TEST(str_equal_cstr(result.content, "[bytes 0-2 of 7]\na\xC3\xA9"));
+    tool_result_free(&result);
+
+    // Starts inside the e acute: skipped
+    snprintf(args, sizeof(args), "{\"handle\":\"%s\",\"offset\":2}", handle.hex);
+    args_str = STR_VIEW(args);
+    result = tool_result_create();
+    TEST_OK(reader->vtable->execute(reader, &args_str, &result));
+    TEST(str_equal_cstr(result.content, "[bytes 3-6 of 7]\n\xE2\x82\xAC" "b"));
+    tool_result_free(&result);
+
+    tool_output_bind(outer);
+    reader->vtable->destroy(reader);
+    tool_output_store_close(store, true);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Tool Output Tests\n");
+    printf("=======================\n\n");
+
+    snprintf(g_dir, sizeof(g_dir), "/tmp/cclaw_tool_output_XXXXXX");
+    if (!mkdtemp(g_dir)) {
+        printf("Could not create a temporary directory\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_sha256()) {
+        printf("✓ test_sha256 passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_sha256 failed\n\n");
+        failed++;
+    }
+
+    if (test_store_put_and_read()) {
+        printf("✓ test_store_put_and_read passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_store_put_and_read failed\n\n");
+        failed++;
+    }
+
+    if (test_excerpt()) {
+        printf("✓ test_excerpt passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_excerpt failed\n\n");
+        failed++;
+    }
+
+    if (test_agent_spills()) {
+        printf("✓ test_agent_spills passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_agent_spills failed\n\n");
+        failed++;
+    }
+
+    if (test_read_utf8_boundaries()) {
+        printf("✓ test_read_utf8_boundaries passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_read_utf8_boundaries failed\n\n");
+        failed++;
+    }
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/store", g_dir);
+    rmdir(path);
+    rmdir(g_dir);
+
+    printf("=======================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
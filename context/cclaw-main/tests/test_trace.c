@@ -0,0 +1,254 @@
+// test_trace.c - Tracing span tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "core/trace.h"
+#include "core/error.h"
+#include "json_config.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = malloc((size_t)size + 1);
+    if (data) {
+        size_t n = fread(data, 1, (size_t)size, f);
+        data[n] = '\0';
+    }
+    fclose(f);
+    return data;
+}
+
+static void* worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < 100; i++) {
+        TRACE_BEGIN("worker.span", "test");
+        TRACE_ARG("i", i);
+        TRACE_END();
+    }
+    return NULL;
+}
+
+static bool test_trace_disabled(void) {
+    printf("Testing disabled tracing...\n");
+
+    TEST(!trace_enabled());
+
+    // Must be harmless when tracing is off
+    TRACE_BEGIN("ignored", "test");
+    TRACE_ARG("x", 1);
+    TRACE_END();
+    TRACE_END();
+
+    return true;
+}
+
+static bool test_trace_chrome(void) {
+    printf("Testing Chrome trace export...\n");
+
+    char path[] = "/tmp/cclaw-trace-XXXXXX";
+    int fd = mkstemp(path);
+    TEST(fd >= 0);
+    close(fd);
+
+    trace_config_t config = trace_config_default();
+    config.path = path;
+    config.flush_interval_ms = 10;
+    TEST_OK(trace_init(&config));
+    TEST(trace_enabled());
+    TEST(trace_init(&config) == ERR_ALREADY_EXISTS);
+
+    TRACE_BEGIN("outer", "test");
+    TRACE_BEGIN_STR(STR_LIT("inner \"quoted\""), "test");
+    uint64_t start = trace_now_ns();
+    trace_span_record_impl("recorded", "test", start, start + 1000);
+    TRACE_END();
+    TRACE_ARG("answer", 42);
+    TRACE_END();
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, worker, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+    trace_shutdown();
+    TEST(!trace_enabled());
+
+    char* text = read_file(path);
+    TEST(text != NULL);
+
+    json_value_t* root = json_parse(text);
+    TEST(root != NULL);
+    TEST(json_is_object(root));
+
+    json_array_t* events = json_object_get_array(json_as_object(root), "traceEvents");
+    TEST(events != NULL);
+    TEST(json_array_length(events) == 3 + 4 * 100 - trace_dropped_events());
+
+    TEST(strstr(text, "\"name\":\"outer\"") != NULL);
+    TEST(strstr(text, "\"answer\":42") != NULL);
+    TEST(strstr(text, "inner \\\"quoted\\\"") != NULL);
+    TEST(strstr(text, "\"name\":\"recorded\"") != NULL);
+
+    json_free(root);
+    free(text);
+    unlink(path);
+    return true;
+}
+
+static bool test_trace_otlp(void) {
+    printf("Testing OTLP-JSON export...\n");
+
+    char path[] = "/tmp/cclaw-trace-XXXXXX";
+    int fd = mkstemp(path);
+    TEST(fd >= 0);
+    close(fd);
+
+    trace_config_t config = trace_config_default();
+    config.path = path;
+    config.format = TRACE_FORMAT_OTLP;
+    TEST_OK(trace_init(&config));
+
+    TRACE_BEGIN("parent", "test");
+    TRACE_BEGIN("child", "test");
+    TRACE_END();
+    TRACE_END();
+
+    trace_shutdown();
+
+    char* text = read_file(path);
+    TEST(text != NULL);
+
+    // One ExportTraceServiceRequest per line
+    char* line = strtok(text, "\n");
+    TEST(line != NULL);
+    json_value_t* root = json_parse(line);
+    TEST(root != NULL);
+    TEST(json_object_get_array(json_as_object(root), "resourceSpans") != NULL);
+    TEST(strstr(line, "\"parentSpanId\"") != NULL);
+    TEST(strstr(line, "\"service.name\"") != NULL);
+
+    json_free(root);
+    free(text);
+    unlink(path);
+    return true;
+}
+
+static atomic_bool g_spin = false;
+
+static void* spinner(void* arg) {
+    (void)arg;
+    while (atomic_load(&g_spin)) {
+        TRACE_BEGIN("spin", "test");
+        TRACE_END();
+    }
+    return NULL;
+}
+
+static bool test_trace_shutdown_with_writers(void) {
+    printf("Testing shutdown while threads are tracing...\n");
+
+    char path[] = "/tmp/cclaw-trace-XXXXXX";
+    int fd = mkstemp(path);
+    TEST(fd >= 0);
+    close(fd);
+
+    trace_config_t config = trace_config_default();
+    config.path = path;
+    config.flush_interval_ms = 10;
+
+    atomic_store(&g_spin, true);
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, spinner, NULL);
+
+    // Writers keep running across several sessions
+    for (int round = 0; round < 3; round++) {
+        TEST_OK(trace_init(&config));
+        usleep(5000);
+        trace_shutdown();
+    }
+
+    atomic_store(&g_spin, false);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+    // States of the exited threads are reused by the next session
+    TEST_OK(trace_init(&config));
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, worker, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+    trace_shutdown();
+
+    char* text = read_file(path);
+    TEST(text != NULL);
+    json_value_t* root = json_parse(text);
+    TEST(root != NULL);
+    json_array_t* events = json_object_get_array(json_as_object(root), "traceEvents");
+    TEST(events != NULL);
+    TEST(json_array_length(events) == 4 * 100 - trace_dropped_events());
+
+    json_free(root);
+    free(text);
+    unlink(path);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw Trace Tests\n");
+    printf("=================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_trace_disabled()) {
+        printf("✓ test_trace_disabled passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_trace_disabled failed\n\n");
+        failed++;
+    }
+
+    if (test_trace_chrome()) {
+        printf("✓ test_trace_chrome passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_trace_chrome failed\n\n");
+        failed++;
+    }
+
+    if (test_trace_otlp()) {
+        printf("✓ test_trace_otlp passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_trace_otlp failed\n\n");
+        failed++;
+    }
+
+    if (test_trace_shutdown_with_writers()) {
+        printf("✓ test_trace_shutdown_with_writers passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_trace_shutdown_with_writers failed\n\n");
+        failed++;
+    }
+
+    printf("=================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
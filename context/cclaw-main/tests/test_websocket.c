@@ -0,0 +1,167 @@
+// test_websocket.c - WebSocket framing tests for CClaw
+// SPDX-License-Identifier: MIT
+
+#include "utils/websocket.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("FAIL: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (0)
+
+#define TEST_OK(err) TEST((err) == ERR_OK)
+
+static bool test_accept_key(void) {
+    printf("Testing the handshake accept key...\n");
+
+    // RFC 6455 section 1.3
+    char accept[WS_ACCEPT_KEY_LEN + 1];
+    TEST_OK(ws_accept_key(STR_LIT("dGhlIHNhbXBsZSBub25jZQ=="), accept));
+    TEST(strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+
+    TEST(ws_accept_key(STR_LIT("short"), accept) == ERR_INVALID_ARGUMENT);
+    TEST(ws_accept_key(STR_LIT("dGhlIHNhbXBsZSBub25jZQ!!"), accept) == ERR_INVALID_ARGUMENT);
+    TEST(ws_accept_key(STR_LIT("dGhlIHNhbXBsZSBub25j*Q=="), accept) == ERR_INVALID_ARGUMENT);
+    return true;
+}
+
+static bool test_parse_masked_frame(void) {
+    printf("Testing masked client frames parse incrementally...\n");
+
+    // RFC 6455 section 5.7: masked "Hello"
+    uint8_t frame[] = { 0x81, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f, 0x9f, 0x4d, 0x51, 0x58 };
+    ws_frame_t parsed;
+    size_t consumed = 99;
+
+    for (size_t len = 0; len < sizeof(frame); len++) {
+        TEST_OK(ws_frame_parse(frame, len, true, 1024, &parsed, &consumed));
+        TEST(consumed == 0);
+    }
+    TEST_OK(ws_frame_parse(frame, sizeof(frame), true, 1024, &parsed, &consumed));
+    TEST(consumed == sizeof(frame));
+    TEST(parsed.opcode == WS_OP_TEXT && parsed.fin);
+    TEST(parsed.length == 5 && memcmp(parsed.payload, "Hello", 5) == 0);
+
+    // Servers refuse unmasked client frames
+    uint8_t unmasked[] = { 0x81, 0x05, 'H', 'e', 'l', 'l', 'o' };
+    TEST(ws_frame_parse(unmasked, sizeof(unmasked), true, 1024, &parsed, &consumed) ==
+         ERR_INVALID_ARGUMENT);
+    TEST_OK(ws_frame_parse(unmasked, sizeof(unmasked), false, 1024, &parsed, &consumed));
+    TEST(consumed == sizeof(unmasked));
+    return true;
+}
+
+static bool test_header_lengths_round_trip(void) {
+    printf("Testing 7, 16 and 64 bit payload lengths round trip...\n");
+
+    static uint8_t buffer[70000 + WS_MAX_HEADER_LEN];
+    const uint8_t mask[4] = { 1, 2, 3, 4 };
+    const uint64_t lengths[] = { 0, 125, 126, 65535, 65536, 70000 };
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        uint64_t length = lengths[i];
+        size_t header = ws_frame_header(buffer, WS_OP_BINARY, true, length, mask);
+        TEST(header == (length < 126 ? 6 : length <= 0xFFFF ? 8 : 14));
+
+        for (uint64_t j = 0; j < length; j++) buffer[header + j] = (uint8_t)j;
+        ws_mask(buffer + header, (size_t)length, mask, 0);
+
+        ws_frame_t parsed;
+        size_t consumed = 0;
+        TEST_OK(ws_frame_parse(buffer, header + (size_t)length, true, 1 << 20, &parsed, &consumed));
+        TEST(consumed == header + length);
+        TEST(parsed.length == length);
+        for (uint64_t j = 0; j < length; j++) TEST(parsed.payload[j] == (uint8_t)j);
+    }
+
+    // Masking in pieces matches masking in one go
+    uint8_t whole[10] = "abcdefghij";
+    uint8_t pieces[10] = "abcdefghij";
+    ws_mask(whole, 10, mask, 0);
+    ws_mask(pieces, 3, mask, 0);
+    ws_mask(pieces + 3, 7, mask, 3);
+    TEST(memcmp(whole, pieces, 10) == 0);
+    return true;
+}
+
+static bool test_protocol_violations(void) {
+    printf("Testing malformed frames are rejected...\n");
+
+    ws_frame_t parsed;
+    size_t consumed;
+    uint8_t mask[4] = { 0, 0, 0, 0 };
+
+    // Reserved bits without an extension
+    uint8_t reserved[] = { 0xC1, 0x80, 0, 0, 0, 0 };
+    TEST(ws_frame_parse(reserved, sizeof(reserved), true, 1024, &parsed, &consumed) ==
+         ERR_INVALID_ARGUMENT);
+
+    // Unknown opcode
+    uint8_t opcode[] = { 0x83, 0x80, 0, 0, 0, 0 };
+    TEST(ws_frame_parse(opcode, sizeof(opcode), true, 1024, &parsed, &consumed) ==
+         ERR_INVALID_ARGUMENT);
+
+    // Fragmented or long control frames
+    uint8_t fragmented_ping[] = { 0x09, 0x80, 0, 0, 0, 0 };
+    TEST(ws_frame_parse(fragmented_ping, sizeof(fragmented_ping), true, 1024, &parsed, &consumed) ==
+         ERR_INVALID_ARGUMENT);
+    uint8_t long_ping[WS_MAX_HEADER_LEN];
+    size_t header = ws_frame_header(long_ping, WS_OP_PING, true, 126, mask);
+    TEST(ws_frame_parse(long_ping, header, true, 1024, &parsed, &consumed) == ERR_INVALID_ARGUMENT);
+
+    // Over the caller's limit, known from the header alone
+    uint8_t big[WS_MAX_HEADER_LEN];
+    header = ws_frame_header(big, WS_OP_TEXT, true, 4096, mask);
+    TEST(ws_frame_parse(big, header, true, 1024, &parsed, &consumed) == ERR_FILE_TOO_LARGE);
+    return true;
+}
+
+int main(void) {
+    printf("CClaw WebSocket Tests\n");
+    printf("=====================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    if (test_accept_key()) {
+        printf("✓ test_accept_key passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_accept_key failed\n\n");
+        failed++;
+    }
+
+    if (test_parse_masked_frame()) {
+        printf("✓ test_parse_masked_frame passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_parse_masked_frame failed\n\n");
+        failed++;
+    }
+
+    if (test_header_lengths_round_trip()) {
+        printf("✓ test_header_lengths_round_trip passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_header_lengths_round_trip failed\n\n");
+        failed++;
+    }
+
+    if (test_protocol_violations()) {
+        printf("✓ test_protocol_violations passed\n\n");
+        passed++;
+    } else {
+        printf("✗ test_protocol_violations failed\n\n");
+        failed++;
+    }
+
+    printf("=====================\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -8,6 +8,30 @@
 #include <ctype.h>
 #include <assert.h>
 
+// Allocation hooks (see json_set_allocator)
+static void* (*json_malloc_fn)(size_t size) = malloc;
+static void* (*json_realloc_fn)(void* ptr, size_t size) = realloc;
+static void (*json_free_fn)(void* ptr) = free;
+
+void json_set_allocator(void* (*malloc_fn)(size_t size),
+                        void* (*realloc_fn)(void* ptr, size_t size),
+                        void (*free_fn)(void* ptr)) {
+    json_malloc_fn = malloc_fn ? malloc_fn : malloc;
+    json_realloc_fn = realloc_fn ? realloc_fn : realloc;
+    json_free_fn = free_fn ? free_fn : free;
+}
+
+void json_free_string(char* str) {
+    json_free_fn(str);
+}
+
+static char* json_strdup(const char* s) {
+    size_t len = strlen(s);
+    char* copy = json_malloc_fn(len + 1);
+    if (copy) memcpy(copy, s, len + 1);
+    return copy;
+}
+
 // Parser state
 typedef struct {
     const char* text;
@@ -61,7 +85,7 @@ static char* parse_string_raw(json_parser_t* p) {
     if (is_at_end(p)) return NULL; // Unterminated string
 
     // Allocate and copy
-    char* str = malloc(len + 1);
+    char* str = json_malloc_fn(len + 1);
     if (!str) return NULL;
 
     p->pos = start;
@@ -127,19 +151,19 @@ static json_value_t* parse_number(json_parser_t* p) {
 
     if (!has_digits) return NULL;
 
-    char* num_str = malloc(p->pos - start + 1);
+    char* num_str = json_malloc_fn(p->pos - start + 1);
     if (!num_str) return NULL;
 
     strncpy(num_str, p->text + start, p->pos - start);
     num_str[p->pos - start] = '\0';
 
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (val) {
         val->type = JSON_NUMBER;
         val->number = strtod(num_str, NULL);
     }
 
-    free(num_str);
+    json_free_fn(num_str);
     return val;
 }
 
@@ -148,16 +172,11 @@ static json_value_t* parse_array(json_parser_t* p) {
     if (peek(p) != '[') return NULL;
     advance(p); // consume '['
 
-    json_value_t* arr_val = malloc(sizeof(json_value_t));
+    json_value_t* arr_val = json_malloc_fn(sizeof(json_value_t));
     if (!arr_val) return NULL;
 
     arr_val->type = JSON_ARRAY;
-    arr_val->array = malloc(sizeof(json_array_t));
-    if (!arr_val->array) {
-        free(arr_val);
-        return NULL;
-    }
-    arr_val->array->next = NULL;
+    arr_val->array = NULL;  // Empty array, no head node
 
     json_array_t* current = NULL;
 
@@ -177,7 +196,7 @@ static json_value_t* parse_array(json_parser_t* p) {
             return NULL;
         }
 
-        json_array_t* new_item = malloc(sizeof(json_array_t));
+        json_array_t* new_item = json_malloc_fn(sizeof(json_array_t));
         if (!new_item) {
             json_free(item);
             json_free(arr_val);
@@ -185,7 +204,7 @@ static json_value_t* parse_array(json_parser_t* p) {
         }
 
         new_item->value = *item;
-        free(item); // We copied the value
+        json_free_fn(item); // We copied the value
         new_item->next = NULL;
 
         if (current) {
@@ -217,13 +236,13 @@ static json_value_t* parse_object(json_parser_t* p) {
     if (peek(p) != '{') return NULL;
     advance(p); // consume '{'
 
-    json_value_t* obj_val = malloc(sizeof(json_value_t));
+    json_value_t* obj_val = json_malloc_fn(sizeof(json_value_t));
     if (!obj_val) return NULL;
 
     obj_val->type = JSON_OBJECT;
-    obj_val->object = malloc(sizeof(json_object_t));
+    obj_val->object = json_malloc_fn(sizeof(json_object_t));
     if (!obj_val->object) {
-        free(obj_val);
+        json_free_fn(obj_val);
         return NULL;
     }
     obj_val->object->entries = NULL;
@@ -250,7 +269,7 @@ static json_value_t* parse_object(json_parser_t* p) {
         skip_whitespace(p);
 
         if (peek(p) != ':') {
-            free(key);
+            json_free_fn(key);
             json_free(obj_val);
             return NULL;
         }
@@ -261,15 +280,15 @@ static json_value_t* parse_object(json_parser_t* p) {
         // Parse value
         json_value_t* value = parse_value(p);
         if (!value) {
-            free(key);
+            json_free_fn(key);
             json_free(obj_val);
             return NULL;
         }
 
         // Create entry
-        json_entry_t* entry = malloc(sizeof(json_entry_t));
+        json_entry_t* entry = json_malloc_fn(sizeof(json_entry_t));
         if (!entry) {
-            free(key);
+            json_free_fn(key);
             json_free(value);
             json_free(obj_val);
             return NULL;
@@ -277,7 +296,7 @@ static json_value_t* parse_object(json_parser_t* p) {
 
         entry->key = key;
         entry->value = *value;
-        free(value); // We copied the value
+        json_free_fn(value); // We copied the value
         entry->next = NULL;
 
         if (current) {
@@ -317,12 +336,12 @@ static json_value_t* parse_value(json_parser_t* p) {
         char* str = parse_string_raw(p);
         if (!str) return NULL;
 
-        json_value_t* val = malloc(sizeof(json_value_t));
+        json_value_t* val = json_malloc_fn(sizeof(json_value_t));
         if (val) {
             val->type = JSON_STRING;
             val->string = str;
         } else {
-            free(str);
+            json_free_fn(str);
         }
         return val;
     }
@@ -348,7 +367,7 @@ static json_value_t* parse_value(json_parser_t* p) {
 
     if (remaining >= 4 && strncmp(text, "true", 4) == 0) {
         p->pos += 4;
-        json_value_t* val = malloc(sizeof(json_value_t));
+        json_value_t* val = json_malloc_fn(sizeof(json_value_t));
         if (val) {
             val->type = JSON_BOOL;
             val->boolean = true;
@@ -358,7 +377,7 @@ static json_value_t* parse_value(json_parser_t* p) {
 
     if (remaining >= 5 && strncmp(text, "false", 5) == 0) {
         p->pos += 5;
-        json_value_t* val = malloc(sizeof(json_value_t));
+        json_value_t* val = json_malloc_fn(sizeof(json_value_t));
         if (val) {
             val->type = JSON_BOOL;
             val->boolean = false;
@@ -368,7 +387,7 @@ static json_value_t* parse_value(json_parser_t* p) {
 
     if (remaining >= 4 && strncmp(text, "null", 4) == 0) {
         p->pos += 4;
-        json_value_t* val = malloc(sizeof(json_value_t));
+        json_value_t* val = json_malloc_fn(sizeof(json_value_t));
         if (val) {
             val->type = JSON_NULL;
         }
@@ -415,7 +434,7 @@ json_value_t* json_parse_file(const char* filename) {
         return NULL;
     }
 
-    char* content = malloc((size_t)size + 1);
+    char* content = json_malloc_fn((size_t)size + 1);
     if (!content) {
         fclose(file);
         return NULL;
@@ -427,7 +446,7 @@ json_value_t* json_parse_file(const char* filename) {
     content[read] = '\0';
 
     json_value_t* value = json_parse(content);
-    free(content);
+    json_free_fn(content);
 
     return value;
 }
@@ -438,7 +457,7 @@ static void json_free_contents(json_value_t* value) {
 
     switch (value->type) {
         case JSON_STRING:
-            free(value->string);
+            json_free_fn(value->string);
             value->string = NULL;
             break;
 
@@ -447,7 +466,7 @@ static void json_free_contents(json_value_t* value) {
             while (item) {
                 json_array_t* next = item->next;
                 json_free_contents(&item->value);
-                free(item);
+                json_free_fn(item);
                 item = next;
             }
             value->array = NULL;
@@ -458,12 +477,12 @@ static void json_free_contents(json_value_t* value) {
             json_entry_t* entry = value->object->entries;
             while (entry) {
                 json_entry_t* next = entry->next;
-                free(entry->key);
+                json_free_fn(entry->key);
                 json_free_contents(&entry->value);
-                free(entry);
+                json_free_fn(entry);
                 entry = next;
             }
-            free(value->object);
+            json_free_fn(value->object);
             value->object = NULL;
             break;
         }
@@ -478,7 +497,7 @@ void json_free(json_value_t* value) {
     if (!value) return;
 
     json_free_contents(value);
-    free(value);
+    json_free_fn(value);
 }
 
 // Get value from object by key
@@ -606,7 +625,7 @@ static void print_indent(char** out, size_t* cap, size_t* len, int indent) {
 static void append_char(char** out, size_t* cap, size_t* len, char c) {
     if (*len + 1 >= *cap) {
         *cap *= 2;
-        char* new_out = realloc(*out, *cap);
+        char* new_out = json_realloc_fn(*out, *cap);
         if (!new_out) return;
         *out = new_out;
     }
@@ -617,7 +636,7 @@ static void append_string(char** out, size_t* cap, size_t* len, const char* str)
     size_t slen = strlen(str);
     while (*len + slen + 1 >= *cap) {
         *cap *= 2;
-        char* new_out = realloc(*out, *cap);
+        char* new_out = json_realloc_fn(*out, *cap);
         if (!new_out) return;
         *out = new_out;
     }
@@ -748,7 +767,7 @@ char* json_print(json_value_t* value, bool pretty) {
     if (!value) return NULL;
 
     size_t cap = 1024;
-    char* out = malloc(cap);
+    char* out = json_malloc_fn(cap);
     if (!out) return NULL;
 
     size_t len = 0;
@@ -765,14 +784,14 @@ char* json_print(json_value_t* value, bool pretty) {
 
 // Create JSON null
 json_value_t* json_create_null(void) {
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (val) val->type = JSON_NULL;
     return val;
 }
 
 // Create JSON bool
 json_value_t* json_create_bool(bool value) {
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (val) {
         val->type = JSON_BOOL;
         val->boolean = value;
@@ -782,7 +801,7 @@ json_value_t* json_create_bool(bool value) {
 
 // Create JSON number
 json_value_t* json_create_number(double value) {
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (val) {
         val->type = JSON_NUMBER;
         val->number = value;
@@ -794,18 +813,18 @@ json_value_t* json_create_number(double value) {
 json_value_t* json_create_string(const char* value) {
     if (!value) return NULL;
 
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (!val) return NULL;
 
     val->type = JSON_STRING;
-    val->string = strdup(value);
+    val->string = json_strdup(value);
 
     return val;
 }
 
 // Create JSON array
 json_value_t* json_create_array(void) {
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (!val) return NULL;
 
     val->type = JSON_ARRAY;
@@ -816,13 +835,13 @@ json_value_t* json_create_array(void) {
 
 // Create JSON object
 json_value_t* json_create_object(void) {
-    json_value_t* val = malloc(sizeof(json_value_t));
+    json_value_t* val = json_malloc_fn(sizeof(json_value_t));
     if (!val) return NULL;
 
     val->type = JSON_OBJECT;
-    val->object = malloc(sizeof(json_object_t));
+    val->object = json_malloc_fn(sizeof(json_object_t));
     if (!val->object) {
-        free(val);
+        json_free_fn(val);
         return NULL;
     }
     val->object->entries = NULL;
@@ -834,7 +853,7 @@ json_value_t* json_create_object(void) {
 void json_array_append(json_value_t* arr, json_value_t* item) {
     if (!arr || arr->type != JSON_ARRAY || !item) return;
 
-    json_array_t* new_item = malloc(sizeof(json_array_t));
+    json_array_t* new_item = json_malloc_fn(sizeof(json_array_t));
     if (!new_item) return;
 
     new_item->value = *item;
@@ -857,7 +876,7 @@ void json_array_append(json_value_t* arr, json_value_t* item) {
         last->next = new_item;
     }
 
-    free(item); // We copied the value
+    json_free_fn(item); // We copied the value
 }
 
 // Set object property
@@ -871,22 +890,22 @@ void json_object_set(json_value_t* obj, const char* key, json_value_t* value) {
             // Replace value
             json_free(&entry->value);
             entry->value = *value;
-            free(value);
+            json_free_fn(value);
             return;
         }
         entry = entry->next;
     }
 
     // Add new entry
-    entry = malloc(sizeof(json_entry_t));
+    entry = json_malloc_fn(sizeof(json_entry_t));
     if (!entry) return;
 
-    entry->key = strdup(key);
+    entry->key = json_strdup(key);
     entry->value = *value;
     entry->next = obj->object->entries;
     obj->object->entries = entry;
 
-    free(value);
+    json_free_fn(value);
 }
 
 void json_object_set_bool(json_value_t* obj, const char* key, bool value) {
@@ -94,8 +94,15 @@ const char* json_as_string(json_value_t* val, const char* default_val);
 json_array_t* json_as_array(json_value_t* val);
 json_object_t* json_as_object(json_value_t* val);
 
-// JSON serialization
+// JSON serialization (release the result with json_free_string)
 char* json_print(json_value_t* value, bool pretty);
+void json_free_string(char* str);
+
+// Route all allocations through custom functions. Must be called before any
+// value is created; NULL arguments restore the libc defaults.
+void json_set_allocator(void* (*malloc_fn)(size_t size),
+                        void* (*realloc_fn)(void* ptr, size_t size),
+                        void (*free_fn)(void* ptr));
 
 // Create JSON values
 json_value_t* json_create_null(void);
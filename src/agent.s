@@ -5,7 +5,7 @@
 //   - Single message mode: agent -m "hello"
 //   - Interactive mode: agent
 //   - Status display: status
-//   - Basic conversation history capture in arena memory
+//   - Unbounded conversation history in mmap-backed pages
 
 .include "include/constants.inc"
 
@@ -17,7 +17,17 @@
 .set HIST_PTR,   8
 .set HIST_LEN,   16
 .set HIST_SIZE,  24
-.set HIST_MAX,   64
+.set HIST_INDEX_INIT, 256               // first index capacity (entries)
+
+// History store state (_g_hist).  The index is a flat entry array that
+// doubles on growth; message text lives in pages that never move, so
+// pointers handed out by _agent_history_get stay valid.  Neither uses
+// the global arena, whose base relocates when it grows.
+.set HSTATE_COUNT, 0
+.set HSTATE_INDEX, 8
+.set HSTATE_CAP,   16
+.set HSTATE_TEXT,  24
+.set HSTATE_LEFT,  32
 .set TOOL_MAX_ITERS, 8
 
 // ──────────────────────────────────────────────────────────────────
@@ -266,9 +276,9 @@ _agent_signal_handler:
 // ──────────────────────────────────────────────────────────────────
 .global _agent_history_count
 _agent_history_count:
-    adrp    x0, _g_hist_count@PAGE
-    add     x0, x0, _g_hist_count@PAGEOFF
-    ldr     x0, [x0]
+    adrp    x0, _g_hist@PAGE
+    add     x0, x0, _g_hist@PAGEOFF
+    ldr     x0, [x0, #HSTATE_COUNT]
     ret
 
 // ──────────────────────────────────────────────────────────────────
@@ -279,17 +289,15 @@ _agent_history_count:
 // ──────────────────────────────────────────────────────────────────
 .global _agent_history_get
 _agent_history_get:
-    adrp    x3, _g_hist_count@PAGE
-    add     x3, x3, _g_hist_count@PAGEOFF
-    ldr     x4, [x3]
+    adrp    x3, _g_hist@PAGE
+    add     x3, x3, _g_hist@PAGEOFF
+    ldr     x4, [x3, #HSTATE_COUNT]
     cmp     x0, x4
     b.hs    .Lhist_get_invalid
 
-    adrp    x5, _g_hist_entries@PAGE
-    add     x5, x5, _g_hist_entries@PAGEOFF
+    ldr     x5, [x3, #HSTATE_INDEX]
     mov     x6, #HIST_SIZE
-    mul     x7, x0, x6
-    add     x5, x5, x7
+    madd    x5, x0, x6, x5
 
     ldr     x0, [x5, #HIST_ROLE]
     ldr     x1, [x5, #HIST_PTR]
@@ -734,9 +742,9 @@ _agent_history_append:
     bl      _strlen_simd
     mov     x21, x0
 
-    // Duplicate into arena: len + 1
+    // Duplicate into a history text page: len + 1
     add     x0, x21, #1
-    bl      _arena_alloc
+    bl      .Lhist_text_alloc
     cbz     x0, .Lhist_done
     mov     x22, x0                     // copied message
 
@@ -752,24 +760,18 @@ _agent_history_append:
     mov     x2, x21
     bl      .Lhist_persist_file
 
-    adrp    x8, _g_hist_count@PAGE
-    add     x8, x8, _g_hist_count@PAGEOFF
-    ldr     x9, [x8]
-    cmp     x9, #HIST_MAX
-    b.ge    .Lhist_done
-
-    adrp    x10, _g_hist_entries@PAGE
-    add     x10, x10, _g_hist_entries@PAGEOFF
-    mov     x11, #HIST_SIZE
-    mul     x12, x9, x11
-    add     x10, x10, x12
+    bl      .Lhist_index_reserve        // x0 = slot for entry [count]
+    cbz     x0, .Lhist_done
 
-    str     x19, [x10, #HIST_ROLE]
-    str     x22, [x10, #HIST_PTR]
-    str     x21, [x10, #HIST_LEN]
+    str     x19, [x0, #HIST_ROLE]
+    str     x22, [x0, #HIST_PTR]
+    str     x21, [x0, #HIST_LEN]
 
+    adrp    x8, _g_hist@PAGE
+    add     x8, x8, _g_hist@PAGEOFF
+    ldr     x9, [x8, #HSTATE_COUNT]
     add     x9, x9, #1
-    str     x9, [x8]
+    str     x9, [x8, #HSTATE_COUNT]
 
 .Lhist_done:
     ldp     x21, x22, [sp, #32]
@@ -777,6 +779,121 @@ _agent_history_append:
     ldp     x29, x30, [sp], #48
     ret
 
+// x0 = bytes; Returns: x0 = stable pointer, or NULL if mmap fails.
+// Bump-allocates from the current text page and maps a fresh one
+// (ARENA_PAGE_SIZE, or larger for oversized messages) when it runs out.
+.Lhist_text_alloc:
+    stp     x29, x30, [sp, #-48]!
+    mov     x29, sp
+    stp     x19, x20, [sp, #16]
+    str     x21, [sp, #32]
+
+    mov     x19, x0                     // bytes
+    adrp    x20, _g_hist@PAGE
+    add     x20, x20, _g_hist@PAGEOFF
+    ldr     x1, [x20, #HSTATE_LEFT]
+    cmp     x19, x1
+    b.ls    .Lhist_text_fit
+
+    mov     x2, #(ARENA_PAGE_SIZE - 1)
+    add     x21, x19, x2
+    bic     x21, x21, x2                // page bytes, rounded up
+
+    mov     x0, #0
+    mov     x1, x21
+    mov     x2, #(PROT_READ | PROT_WRITE)
+    mov     x3, #(MAP_ANON | MAP_PRIVATE)
+    mov     x4, #-1
+    mov     x5, #0
+    bl      _mmap
+    cmn     x0, #1
+    b.eq    .Lhist_text_fail
+    str     x0, [x20, #HSTATE_TEXT]
+    str     x21, [x20, #HSTATE_LEFT]
+
+.Lhist_text_fit:
+    ldr     x0, [x20, #HSTATE_TEXT]
+    ldr     x1, [x20, #HSTATE_LEFT]
+    add     x2, x0, x19
+    sub     x1, x1, x19
+    str     x2, [x20, #HSTATE_TEXT]
+    str     x1, [x20, #HSTATE_LEFT]
+    b       .Lhist_text_ret
+
+.Lhist_text_fail:
+    mov     x0, #0
+
+.Lhist_text_ret:
+    ldr     x21, [sp, #32]
+    ldp     x19, x20, [sp, #16]
+    ldp     x29, x30, [sp], #48
+    ret
+
+// Returns: x0 = pointer to index slot [count], or NULL if mmap fails.
+// Doubles the index (mmap + copy + munmap) when it is full.
+.Lhist_index_reserve:
+    stp     x29, x30, [sp, #-64]!
+    mov     x29, sp
+    stp     x19, x20, [sp, #16]
+    stp     x21, x22, [sp, #32]
+    stp     x23, x24, [sp, #48]
+
+    adrp    x19, _g_hist@PAGE
+    add     x19, x19, _g_hist@PAGEOFF
+    ldr     x20, [x19, #HSTATE_COUNT]
+    ldr     x21, [x19, #HSTATE_CAP]
+    cmp     x20, x21
+    b.lo    .Lhist_index_slot
+
+    lsl     x22, x21, #1                // new capacity (entries)
+    cbnz    x22, .Lhist_index_map
+    mov     x22, #HIST_INDEX_INIT
+
+.Lhist_index_map:
+    mov     x0, #0
+    mov     x8, #HIST_SIZE
+    mul     x1, x22, x8
+    mov     x2, #(PROT_READ | PROT_WRITE)
+    mov     x3, #(MAP_ANON | MAP_PRIVATE)
+    mov     x4, #-1
+    mov     x5, #0
+    bl      _mmap
+    cmn     x0, #1
+    b.eq    .Lhist_index_fail
+    mov     x23, x0                     // new index
+
+    ldr     x24, [x19, #HSTATE_INDEX]   // old index
+    cbz     x24, .Lhist_index_publish
+    mov     x0, x23
+    mov     x1, x24
+    mov     x8, #HIST_SIZE
+    mul     x2, x20, x8
+    bl      _memcpy_simd
+    mov     x0, x24
+    mov     x8, #HIST_SIZE
+    mul     x1, x21, x8
+    bl      _munmap
+
+.Lhist_index_publish:
+    str     x23, [x19, #HSTATE_INDEX]
+    str     x22, [x19, #HSTATE_CAP]
+
+.Lhist_index_slot:
+    ldr     x0, [x19, #HSTATE_INDEX]
+    mov     x8, #HIST_SIZE
+    madd    x0, x20, x8, x0
+    b       .Lhist_index_ret
+
+.Lhist_index_fail:
+    mov     x0, #0
+
+.Lhist_index_ret:
+    ldp     x23, x24, [sp, #48]
+    ldp     x21, x22, [sp, #32]
+    ldp     x19, x20, [sp, #16]
+    ldp     x29, x30, [sp], #64
+    ret
+
 // x0=role, x1=msg ptr, x2=msg len
 .Lhist_persist_file:
     stp     x29, x30, [sp, #-80]!
@@ -906,10 +1023,12 @@ _status_run:
 // ── BSS ──
 .section __DATA,__bss
 .p2align 4
-_g_hist_count:
-    .quad   0
-_g_hist_entries:
-    .space  1536                          // HIST_MAX * HIST_SIZE
+_g_hist:
+    .quad   0                             // HSTATE_COUNT
+    .quad   0                             // HSTATE_INDEX
+    .quad   0                             // HSTATE_CAP
+    .quad   0                             // HSTATE_TEXT
+    .quad   0                             // HSTATE_LEFT
 _g_agent_signal_exit:
     .quad   0
 
@@ -2,7 +2,8 @@
 // ARM64 macOS — Apple Silicon optimized
 //
 // Wraps libcurl for HTTPS POST requests to LLM APIs.
-// Uses arena allocator for response buffers.
+// Receives responses into a chain of mmap'd segments that is reused
+// across requests, then linearizes once when the final size is known.
 // libcurl ships with macOS — zero install needed.
 
 .include "include/constants.inc"
@@ -11,20 +12,37 @@
 .p2align 4
 
 // Response buffer structure (in .bss):
-//   +0:  data pointer (arena-allocated)
-//   +8:  length (current)
-//   +16: capacity
-.set RESP_DATA,     0
-.set RESP_LEN,      8
-.set RESP_CAP,      16
-.set RESP_SIZE,     24
+//   +0:  first segment
+//   +8:  segment currently being filled
+//   +16: length (total bytes received)
+//   +24: linear output buffer (only used for multi-segment bodies)
+//   +32: linear output capacity
+.set RESP_HEAD,     0
+.set RESP_TAIL,     8
+.set RESP_LEN,      16
+.set RESP_OUT,      24
+.set RESP_OUT_CAP,  32
+.set RESP_SIZE,     40
+
+// Receive segment layout (mmap'd, never moved or unmapped):
+//   +0:  next segment
+//   +8:  bytes used
+//   +16: data (RESP_SEG_CAP bytes, plus one spare byte for a NUL)
+// Segments live outside the arena: arena growth relocates the whole
+// region, and every outgrown response block would be dead arena space.
+.set SEG_NEXT,      0
+.set SEG_USED,      8
+.set SEG_DATA,      16
+.set RESP_SEG_BYTES, ARENA_PAGE_SIZE
+.set RESP_SEG_CAP,  RESP_SEG_BYTES - SEG_DATA - 1
 
 // ──────────────────────────────────────────────────────────────────
 // _http_post: POST JSON to URL with auth header
 //   x0 = URL (NUL-terminated)
 //   x1 = JSON body (NUL-terminated)
 //   x2 = auth header value (e.g., "Bearer sk-...")  (NUL-terminated)
-//   Returns: x0 = response body pointer (NUL-terminated)
+//   Returns: x0 = response body pointer (NUL-terminated, writable,
+//                 valid until the next _http_post)
 //            x1 = response body length
 //            x0 = NULL on error
 // ──────────────────────────────────────────────────────────────────
@@ -45,19 +63,9 @@ _http_post:
     bl      .Lhttp_curl_ensure
     cbz     x0, .Lhttp_error
 
-    // Allocate response buffer from arena (8KB initial)
-    mov     x0, #BUF_LARGE
-    bl      _arena_alloc
+    // Rewind the response segment chain (maps the first segment once).
+    bl      .Lhttp_resp_reset
     cbz     x0, .Lhttp_error
-    mov     x22, x0                     // response buffer
-
-    // Initialize response state
-    adrp    x1, _g_http_resp@PAGE
-    add     x1, x1, _g_http_resp@PAGEOFF
-    str     x22, [x1, #RESP_DATA]
-    str     xzr, [x1, #RESP_LEN]
-    mov     x2, #BUF_LARGE
-    str     x2, [x1, #RESP_CAP]
 
     // curl_easy_init()
     bl      _curl_easy_init
@@ -185,16 +193,9 @@ _http_post:
     cmp     x25, #CURLE_OK
     b.ne    .Lhttp_error
 
-    // NUL-terminate response
-    adrp    x1, _g_http_resp@PAGE
-    add     x1, x1, _g_http_resp@PAGEOFF
-    ldr     x0, [x1, #RESP_DATA]
-    ldr     x2, [x1, #RESP_LEN]
-    strb    wzr, [x0, x2]              // NUL terminate
-
-    // Return response
-    mov     x1, x2                      // length
-    // x0 already has data pointer
+    // Contiguous, NUL-terminated response body
+    bl      .Lhttp_resp_finish
+    cbz     x0, .Lhttp_error
 
     ldp     x25, x26, [sp, #64]
     ldp     x23, x24, [sp, #48]
@@ -219,67 +220,217 @@ _http_post:
 //   x1 = size (always 1)
 //   x2 = nmemb
 //   x3 = userdata (pointer to response struct)
-//   Returns: x0 = bytes consumed
+//   Returns: x0 = bytes consumed (0 aborts the transfer on OOM)
+//
+// Fills the tail segment and moves on to the next one (reusing chain
+// segments left from earlier responses, mapping new ones at the end).
+// Received bytes are copied exactly once.
 // ──────────────────────────────────────────────────────────────────
 .global _http_write_callback
 _http_write_callback:
-    stp     x29, x30, [sp, #-32]!
+    stp     x29, x30, [sp, #-64]!
     mov     x29, sp
     stp     x19, x20, [sp, #16]
+    stp     x21, x22, [sp, #32]
+    stp     x23, x24, [sp, #48]
 
-    mul     x4, x1, x2                 // total bytes = size * nmemb
-    mov     x19, x4                     // save total
-
-    // Get response state
-    ldr     x5, [x3, #RESP_DATA]       // data ptr
-    ldr     x6, [x3, #RESP_LEN]        // current length
-    ldr     x7, [x3, #RESP_CAP]        // capacity
-
-    // Check if fits
-    add     x8, x6, x4
-    cmp     x8, x7
-    b.ge    .Lcb_overflow               // doesn't fit, truncate
-
-    // Copy data: memcpy(data + len, src, total)
-    add     x9, x5, x6                 // dest = data + current len
-    // Use our NEON memcpy
-    mov     x10, x0                     // save src
-    mov     x0, x9                      // dest
-    mov     x1, x10                     // src
-    mov     x2, x4                      // count
+    mov     x19, x0                     // src cursor
+    mul     x22, x1, x2                 // total bytes = size * nmemb
+    mov     x20, x22                    // bytes remaining
+    mov     x21, x3                     // response state
+
+.Lcb_loop:
+    cbz     x20, .Lcb_done
+    ldr     x23, [x21, #RESP_TAIL]
+    ldr     x8, [x23, #SEG_USED]
+    mov     x9, #RESP_SEG_CAP
+    subs    x24, x9, x8                 // room left in tail
+    b.ne    .Lcb_copy
+
+    // Tail is full: advance to the next segment, mapping one if needed.
+    ldr     x0, [x23, #SEG_NEXT]
+    cbnz    x0, .Lcb_advance
+    bl      .Lhttp_seg_map
+    cbz     x0, .Lcb_fail
+    str     x0, [x23, #SEG_NEXT]
+
+.Lcb_advance:
+    str     xzr, [x0, #SEG_USED]
+    str     x0, [x21, #RESP_TAIL]
+    b       .Lcb_loop
+
+.Lcb_copy:
+    cmp     x24, x20
+    csel    x24, x24, x20, lo           // n = min(room, remaining)
+    add     x0, x23, #SEG_DATA
+    add     x0, x0, x8                  // dest = data + used
+    mov     x1, x19
+    mov     x2, x24
     bl      _memcpy_simd
+    ldr     x8, [x23, #SEG_USED]
+    add     x8, x8, x24
+    str     x8, [x23, #SEG_USED]
+    add     x19, x19, x24
+    sub     x20, x20, x24
+    b       .Lcb_loop
+
+.Lcb_done:
+    ldr     x8, [x21, #RESP_LEN]
+    add     x8, x8, x22
+    str     x8, [x21, #RESP_LEN]
+    mov     x0, x22                     // return bytes consumed
+    b       .Lcb_ret
+
+.Lcb_fail:
+    mov     x0, #0
 
-    // Update length
-    adrp    x3, _g_http_resp@PAGE
-    add     x3, x3, _g_http_resp@PAGEOFF
-    ldr     x6, [x3, #RESP_LEN]
-    add     x6, x6, x19
-    str     x6, [x3, #RESP_LEN]
+.Lcb_ret:
+    ldp     x23, x24, [sp, #48]
+    ldp     x21, x22, [sp, #32]
+    ldp     x19, x20, [sp, #16]
+    ldp     x29, x30, [sp], #64
+    ret
 
-    mov     x0, x19                     // return bytes consumed
+// ──────────────────────────────────────────────────────────────────
+// Response segment helpers
+// ──────────────────────────────────────────────────────────────────
 
-    ldp     x19, x20, [sp, #16]
+// Returns: x0 = fresh empty segment, or NULL if mmap fails
+.Lhttp_seg_map:
+    stp     x29, x30, [sp, #-16]!
+    mov     x29, sp
+    mov     x0, #0
+    mov     x1, #RESP_SEG_BYTES
+    mov     x2, #(PROT_READ | PROT_WRITE)
+    mov     x3, #(MAP_ANON | MAP_PRIVATE)
+    mov     x4, #-1
+    mov     x5, #0
+    bl      _mmap
+    cmn     x0, #1
+    b.eq    .Lhttp_seg_map_fail
+    str     xzr, [x0, #SEG_NEXT]
+    str     xzr, [x0, #SEG_USED]
+    b       .Lhttp_seg_map_ret
+
+.Lhttp_seg_map_fail:
+    mov     x0, #0
+
+.Lhttp_seg_map_ret:
+    ldp     x29, x30, [sp], #16
+    ret
+
+// Rewind the chain to its first segment (mapping it on first use).
+// Returns: x0 = 1 on success, 0 on OOM
+.Lhttp_resp_reset:
+    stp     x29, x30, [sp, #-32]!
+    mov     x29, sp
+    str     x19, [sp, #16]
+
+    adrp    x19, _g_http_resp@PAGE
+    add     x19, x19, _g_http_resp@PAGEOFF
+    ldr     x0, [x19, #RESP_HEAD]
+    cbnz    x0, .Lhttp_resp_reset_head
+    bl      .Lhttp_seg_map
+    cbz     x0, .Lhttp_resp_reset_ret
+    str     x0, [x19, #RESP_HEAD]
+
+.Lhttp_resp_reset_head:
+    str     xzr, [x0, #SEG_USED]
+    str     x0, [x19, #RESP_TAIL]
+    str     xzr, [x19, #RESP_LEN]
+    mov     x0, #1
+
+.Lhttp_resp_reset_ret:
+    ldr     x19, [sp, #16]
     ldp     x29, x30, [sp], #32
     ret
 
-.Lcb_overflow:
-    // Copy what fits
-    sub     x4, x7, x6                 // remaining capacity
-    add     x9, x5, x6
-    mov     x10, x0
-    mov     x0, x9
-    mov     x1, x10
-    mov     x2, x4
+// Produce the contiguous body. A single-segment body is returned in
+// place; longer ones are copied once into the reusable output buffer,
+// which is remapped only when a larger response arrives.
+// Returns: x0 = NUL-terminated body (NULL on OOM), x1 = length
+.Lhttp_resp_finish:
+    stp     x29, x30, [sp, #-64]!
+    mov     x29, sp
+    stp     x19, x20, [sp, #16]
+    stp     x21, x22, [sp, #32]
+    stp     x23, x24, [sp, #48]
+
+    adrp    x19, _g_http_resp@PAGE
+    add     x19, x19, _g_http_resp@PAGEOFF
+    ldr     x20, [x19, #RESP_LEN]
+    ldr     x21, [x19, #RESP_HEAD]
+    ldr     x22, [x19, #RESP_TAIL]
+    cmp     x21, x22
+    b.ne    .Lhttp_finish_linear
+
+    add     x0, x21, #SEG_DATA
+    strb    wzr, [x0, x20]
+    mov     x1, x20
+    b       .Lhttp_finish_ret
+
+.Lhttp_finish_linear:
+    ldr     x23, [x19, #RESP_OUT]
+    ldr     x24, [x19, #RESP_OUT_CAP]
+    add     x9, x20, #1
+    cmp     x9, x24
+    b.ls    .Lhttp_finish_copy
+
+    // Grow the output buffer to the body size rounded up to whole pages.
+    cbz     x23, .Lhttp_finish_map
+    mov     x0, x23
+    mov     x1, x24
+    bl      _munmap
+    str     xzr, [x19, #RESP_OUT]
+    str     xzr, [x19, #RESP_OUT_CAP]
+
+.Lhttp_finish_map:
+    mov     x8, #(ARENA_PAGE_SIZE - 1)
+    add     x24, x20, #1
+    add     x24, x24, x8
+    bic     x24, x24, x8
+    mov     x0, #0
+    mov     x1, x24
+    mov     x2, #(PROT_READ | PROT_WRITE)
+    mov     x3, #(MAP_ANON | MAP_PRIVATE)
+    mov     x4, #-1
+    mov     x5, #0
+    bl      _mmap
+    cmn     x0, #1
+    b.eq    .Lhttp_finish_fail
+    mov     x23, x0
+    str     x23, [x19, #RESP_OUT]
+    str     x24, [x19, #RESP_OUT_CAP]
+
+.Lhttp_finish_copy:
+    mov     x24, x23                    // out cursor
+
+.Lhttp_finish_seg:
+    mov     x0, x24
+    add     x1, x21, #SEG_DATA
+    ldr     x2, [x21, #SEG_USED]
+    add     x24, x24, x2
     bl      _memcpy_simd
+    cmp     x21, x22
+    b.eq    .Lhttp_finish_done
+    ldr     x21, [x21, #SEG_NEXT]
+    b       .Lhttp_finish_seg
 
-    adrp    x3, _g_http_resp@PAGE
-    add     x3, x3, _g_http_resp@PAGEOFF
-    ldr     x7, [x3, #RESP_CAP]
-    str     x7, [x3, #RESP_LEN]        // len = cap
+.Lhttp_finish_done:
+    strb    wzr, [x24]
+    mov     x0, x23
+    mov     x1, x20
+    b       .Lhttp_finish_ret
 
-    mov     x0, x19                     // still return total (curl expects this)
+.Lhttp_finish_fail:
+    mov     x0, #0
+    mov     x1, #0
+
+.Lhttp_finish_ret:
+    ldp     x23, x24, [sp, #48]
+    ldp     x21, x22, [sp, #32]
     ldp     x19, x20, [sp, #16]
-    ldp     x29, x30, [sp], #32
+    ldp     x29, x30, [sp], #64
     ret
 
 // ──────────────────────────────────────────────────────────────────
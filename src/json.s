@@ -94,6 +94,8 @@ _json_find_key:
     b       .Ljson_skip_string
 
 .Ljson_skip_escape:
+    ldrb    w0, [x22, #1]
+    cbz     w0, .Ljson_not_found        // '\' as the last byte of input
     add     x22, x22, #2               // skip \ and next char
     b       .Ljson_skip_string
 
@@ -126,7 +128,10 @@ _json_find_key:
     b       .Ljson_measure_string
 
 .Ljson_measure_escape:
-    add     x1, x1, #2                 // skip escape sequence
+    add     x1, x1, #1
+    ldrb    w2, [x22, x1]
+    cbz     w2, .Ljson_not_found        // '\' as the last byte of input
+    add     x1, x1, #1                 // skip escaped char
     b       .Ljson_measure_string
 
 .Ljson_string_done:
@@ -1,12 +1,16 @@
 // provider.s — LLM Provider (OpenAI-compatible + Anthropic API)
 // ARM64 macOS
 //
-// - Sends chat requests using in-memory history.
+// - Sends chat requests with the full in-memory history.
 // - Supports OpenAI-compatible endpoints and native Anthropic messages API.
 // - Extracts tool calls and exposes them to the agent runtime.
+// - Builds request bodies in a growable mmap-backed writer, so history
+//   length and tool output size are not capped by a fixed buffer.
 
 .include "include/constants.inc"
 
+.set PROV_REQ_INIT,    ARENA_PAGE_SIZE  // first request buffer capacity
+
 .section __TEXT,__text,regular,pure_instructions
 .p2align 4
 
@@ -39,19 +43,18 @@ _provider_chat:
     bl      .Lprov_is_anthropic
     mov     x28, x0                     // 1 if anthropic
 
-    mov     x0, #BUF_LARGE
-    bl      _arena_alloc
+    bl      .Lprov_req_begin            // x24 = cursor, x25 = bytes remaining
     cbz     x0, .Lprov_error
-    mov     x21, x0                     // request buffer
-    mov     x24, x21                    // cursor
-    mov     x25, #BUF_LARGE             // bytes remaining
-    strb    wzr, [x24]
 
     cbz     x28, .Lprov_build_openai
     b       .Lprov_build_anthropic
 
 .Lprov_build_openai:
     // {"model":"...","messages":[
+    ldr     x0, [x20, #40]              // model len
+    add     x0, x0, #BUF_SMALL
+    bl      .Lprov_req_reserve
+    cbz     x0, .Lprov_error
     mov     x0, x24
     mov     x1, x25
     adrp    x2, _str_openai_prefix_fmt@PAGE
@@ -71,10 +74,7 @@ _provider_chat:
     mov     x27, x0                     // history count
     cbz     x27, .Lprov_openai_fallback_single
 
-    mov     x22, #0
-    cmp     x27, #12
-    b.le    .Lprov_openai_hist_loop
-    sub     x22, x27, #12
+    mov     x22, #0                     // whole history; the writer grows
 
 .Lprov_openai_hist_loop:
     cmp     x22, x27
@@ -108,6 +108,9 @@ _provider_chat:
     bl      .Lprov_append_cstr
     cbz     x0, .Lprov_error
 
+    mov     x0, #BUF_SMALL
+    bl      .Lprov_req_reserve
+    cbz     x0, .Lprov_error
     mov     x0, x24
     mov     x1, x25
     adrp    x2, _str_openai_suffix_fmt@PAGE
@@ -125,6 +128,10 @@ _provider_chat:
 
 .Lprov_build_anthropic:
     // {"model":"...","max_tokens":1024,"messages":[
+    ldr     x0, [x20, #40]              // model len
+    add     x0, x0, #BUF_SMALL
+    bl      .Lprov_req_reserve
+    cbz     x0, .Lprov_error
     mov     x0, x24
     mov     x1, x25
     adrp    x2, _str_anthropic_prefix_fmt@PAGE
@@ -144,10 +151,7 @@ _provider_chat:
     mov     x27, x0                     // history count
     cbz     x27, .Lprov_anthropic_fallback_single
 
-    mov     x22, #0
-    cmp     x27, #12
-    b.le    .Lprov_anthropic_hist_loop
-    sub     x22, x27, #12
+    mov     x22, #0                     // whole history; the writer grows
 
 .Lprov_anthropic_hist_loop:
     cmp     x22, x27
@@ -181,6 +185,9 @@ _provider_chat:
     bl      .Lprov_append_cstr
     cbz     x0, .Lprov_error
 
+    mov     x0, #BUF_SMALL
+    bl      .Lprov_req_reserve
+    cbz     x0, .Lprov_error
     mov     x0, x24
     mov     x1, x25
     adrp    x2, _str_anthropic_suffix_fmt@PAGE
@@ -216,7 +223,9 @@ _provider_chat:
 
     // POST request.
     ldr     x0, [x20, #48]              // base_url
-    mov     x1, x21                     // request body
+    adrp    x1, _g_provider_req@PAGE
+    add     x1, x1, _g_provider_req@PAGEOFF
+    ldr     x1, [x1]                    // request body
     mov     x2, sp                      // auth value/header
     bl      _http_post
     add     sp, sp, #512
@@ -816,7 +825,118 @@ _provider_tool_peek:
 
 // ──────────────────────────────────────────────────────────────────
 // Buffer utilities
+//
+// Request writer: the body is built at x24 (cursor) with x25 bytes
+// remaining; base and capacity live in _g_provider_req.  The buffer is
+// mmap'd outside the arena (arena growth relocates every allocation)
+// and is kept across calls, doubling whenever a write does not fit.
 // ──────────────────────────────────────────────────────────────────
+
+// Returns: x0 = 1 on success (x24/x25 reset to an empty body), 0 on OOM
+.Lprov_req_begin:
+    stp     x29, x30, [sp, #-32]!
+    mov     x29, sp
+    str     x19, [sp, #16]
+
+    adrp    x19, _g_provider_req@PAGE
+    add     x19, x19, _g_provider_req@PAGEOFF
+    ldr     x0, [x19]
+    cbnz    x0, .Lprov_req_begin_ready
+
+    mov     x0, #0
+    mov     x1, #PROV_REQ_INIT
+    mov     x2, #(PROT_READ | PROT_WRITE)
+    mov     x3, #(MAP_ANON | MAP_PRIVATE)
+    mov     x4, #-1
+    mov     x5, #0
+    bl      _mmap
+    cmn     x0, #1
+    b.eq    .Lprov_req_begin_fail
+    str     x0, [x19]
+    mov     x1, #PROV_REQ_INIT
+    str     x1, [x19, #8]
+
+.Lprov_req_begin_ready:
+    ldr     x24, [x19]
+    ldr     x25, [x19, #8]
+    strb    wzr, [x24]
+    mov     x0, #1
+    b       .Lprov_req_begin_ret
+
+.Lprov_req_begin_fail:
+    mov     x0, #0
+
+.Lprov_req_begin_ret:
+    ldr     x19, [sp, #16]
+    ldp     x29, x30, [sp], #32
+    ret
+
+// x0 = bytes about to be written (excluding the NUL terminator)
+// Returns: x0 = 1 when x25 > x0 (growing the buffer if needed), 0 on OOM
+.Lprov_req_reserve:
+    cmp     x0, x25
+    b.lo    .Lprov_req_reserve_fast
+
+    stp     x29, x30, [sp, #-64]!
+    mov     x29, sp
+    stp     x19, x20, [sp, #16]
+    stp     x21, x22, [sp, #32]
+    str     x23, [sp, #48]
+
+    adrp    x20, _g_provider_req@PAGE
+    add     x20, x20, _g_provider_req@PAGEOFF
+    ldr     x21, [x20]                  // old base
+    ldr     x22, [x20, #8]              // old capacity
+    sub     x23, x24, x21               // bytes used
+    add     x9, x23, x0
+    add     x9, x9, #1                  // bytes required
+    mov     x19, x22
+
+.Lprov_req_grow_loop:
+    lsl     x19, x19, #1
+    cmp     x19, x9
+    b.lo    .Lprov_req_grow_loop
+
+    mov     x0, #0
+    mov     x1, x19
+    mov     x2, #(PROT_READ | PROT_WRITE)
+    mov     x3, #(MAP_ANON | MAP_PRIVATE)
+    mov     x4, #-1
+    mov     x5, #0
+    bl      _mmap
+    cmn     x0, #1
+    b.eq    .Lprov_req_reserve_fail
+    str     x0, [x20]
+    str     x19, [x20, #8]
+
+    // Copy the body so far, including its NUL, then drop the old buffer.
+    mov     x1, x21
+    add     x2, x23, #1
+    bl      _memcpy_simd
+    mov     x0, x21
+    mov     x1, x22
+    bl      _munmap
+
+    ldr     x0, [x20]
+    add     x24, x0, x23
+    sub     x25, x19, x23
+    mov     x0, #1
+    b       .Lprov_req_reserve_ret
+
+.Lprov_req_reserve_fail:
+    mov     x0, #0
+
+.Lprov_req_reserve_ret:
+    ldr     x23, [sp, #48]
+    ldp     x21, x22, [sp, #32]
+    ldp     x19, x20, [sp, #16]
+    ldp     x29, x30, [sp], #64
+    ret
+
+.Lprov_req_reserve_fast:
+    mov     x0, #1
+    ret
+
 .Lprov_append_cstr:
     stp     x29, x30, [sp, #-32]!
     mov     x29, sp
@@ -825,8 +945,8 @@ _provider_tool_peek:
     mov     x0, x19
     bl      _strlen_simd
     mov     x20, x0
-    cmp     x20, x25
-    b.hs    .Lprov_append_cstr_fail
+    bl      .Lprov_req_reserve
+    cbz     x0, .Lprov_append_cstr_fail
     mov     x0, x24
     mov     x1, x19
     mov     x2, x20
@@ -854,6 +974,12 @@ _provider_tool_peek:
     mov     x20, x1                     // len
     mov     x21, #0
 
+    // Worst case every byte becomes a two-byte escape; reserve once so
+    // the loop below needs no bounds checks.
+    lsl     x0, x20, #1
+    bl      .Lprov_req_reserve
+    cbz     x0, .Lprov_esc_fail
+
 .Lprov_esc_loop:
     cmp     x21, x20
     b.ge    .Lprov_esc_done
@@ -871,8 +997,6 @@ _provider_tool_peek:
     cmp     w22, #0x20
     b.lt    .Lprov_esc_control
 
-    cmp     x25, #1
-    b.ls    .Lprov_esc_fail
     strb    w22, [x24], #1
     sub     x25, x25, #1
     add     x21, x21, #1
@@ -894,8 +1018,6 @@ _provider_tool_peek:
     mov     w22, #'t'
 
 .Lprov_esc_two:
-    cmp     x25, #2
-    b.ls    .Lprov_esc_fail
     mov     w8, #'\\'
     strb    w8, [x24], #1
     strb    w22, [x24], #1
@@ -904,8 +1026,6 @@ _provider_tool_peek:
     b       .Lprov_esc_loop
 
 .Lprov_esc_control:
-    cmp     x25, #1
-    b.ls    .Lprov_esc_fail
     mov     w8, #' '
     strb    w8, [x24], #1
     sub     x25, x25, #1
@@ -1185,6 +1305,9 @@ _g_provider_tool_pending:
     .quad   0
     .quad   0
     .quad   0
+_g_provider_req:
+    .quad   0                           // request buffer base
+    .quad   0                           // request buffer capacity
 
 // ── Data ──
 .section __DATA,__const
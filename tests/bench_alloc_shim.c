@@ -0,0 +1,110 @@
+// Allocation counter for bench_load.ts.
+//
+// Preloaded into the benchmarked process (DYLD_INSERT_LIBRARIES on macOS,
+// LD_PRELOAD on Linux). Counts malloc/calloc/realloc/free calls and bytes
+// requested, then writes one line to the file named by BENCH_ALLOC_OUT at
+// exit:
+//
+//   allocs=<n> frees=<n> reallocs=<n> bytes=<n>
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static _Atomic uint64_t g_allocs = 0;
+static _Atomic uint64_t g_frees = 0;
+static _Atomic uint64_t g_reallocs = 0;
+static _Atomic uint64_t g_bytes = 0;
+
+static void count_alloc(size_t size) {
+  atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&g_bytes, size, memory_order_relaxed);
+}
+
+#if defined(__APPLE__)
+
+static void *shim_malloc(size_t size) {
+  count_alloc(size);
+  return malloc(size);
+}
+
+static void *shim_calloc(size_t n, size_t size) {
+  count_alloc(n * size);
+  return calloc(n, size);
+}
+
+static void *shim_realloc(void *ptr, size_t size) {
+  atomic_fetch_add_explicit(&g_reallocs, 1, memory_order_relaxed);
+  if (!ptr) count_alloc(size);
+  else atomic_fetch_add_explicit(&g_bytes, size, memory_order_relaxed);
+  return realloc(ptr, size);
+}
+
+static void shim_free(void *ptr) {
+  if (ptr) atomic_fetch_add_explicit(&g_frees, 1, memory_order_relaxed);
+  free(ptr);
+}
+
+typedef struct {
+  const void *replacement;
+  const void *original;
+} interpose_t;
+
+__attribute__((used, section("__DATA,__interpose")))
+static const interpose_t g_interpose[] = {
+  { (const void *)shim_malloc, (const void *)malloc },
+  { (const void *)shim_calloc, (const void *)calloc },
+  { (const void *)shim_realloc, (const void *)realloc },
+  { (const void *)shim_free, (const void *)free },
+};
+
+#else
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+  count_alloc(size);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+  count_alloc(n * size);
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  atomic_fetch_add_explicit(&g_reallocs, 1, memory_order_relaxed);
+  if (!ptr) count_alloc(size);
+  else atomic_fetch_add_explicit(&g_bytes, size, memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+  if (ptr) atomic_fetch_add_explicit(&g_frees, 1, memory_order_relaxed);
+  __libc_free(ptr);
+}
+
+#endif
+
+__attribute__((destructor))
+static void report(void) {
+  const char *path = getenv("BENCH_ALLOC_OUT");
+  if (!path || !*path) return;
+
+  // Snapshot before fopen so the report does not count itself.
+  uint64_t allocs = atomic_load(&g_allocs);
+  uint64_t frees = atomic_load(&g_frees);
+  uint64_t reallocs = atomic_load(&g_reallocs);
+  uint64_t bytes = atomic_load(&g_bytes);
+
+  FILE *f = fopen(path, "w");
+  if (!f) return;
+  fprintf(f, "allocs=%llu frees=%llu reallocs=%llu bytes=%llu\n",
+          (unsigned long long)allocs, (unsigned long long)frees,
+          (unsigned long long)reallocs, (unsigned long long)bytes);
+  fclose(f);
+}
@@ -9,12 +9,39 @@ typedef struct {
 } slice_t;
 
 extern uint64_t strlen_simd(const char *s);
+extern int64_t strcmp_simd(const char *a, const char *b);
+extern void *memcpy_simd(void *dst, const void *src, uint64_t n);
 extern slice_t json_find_key(char *json, const char *key);
 
+#if defined(__x86_64__)
+// Explicit instruction-set variants from src/x86_64/*.S; the unsuffixed
+// entry points above dispatch to one of these on first call.
+extern uint64_t strlen_simd_sse2(const char *s);
+extern uint64_t strlen_simd_avx2(const char *s);
+extern int64_t strcmp_simd_sse2(const char *a, const char *b);
+extern int64_t strcmp_simd_avx2(const char *a, const char *b);
+extern void *memcpy_simd_sse2(void *dst, const void *src, uint64_t n);
+extern void *memcpy_simd_avx2(void *dst, const void *src, uint64_t n);
+extern slice_t json_find_key_sse2(char *json, const char *key);
+extern slice_t json_find_key_avx2(char *json, const char *key);
+#endif
+
+typedef uint64_t (*strlen_fn)(const char *);
+typedef int64_t (*strcmp_fn)(const char *, const char *);
+typedef void *(*memcpy_fn)(void *, const void *, uint64_t);
+typedef slice_t (*json_fn)(char *, const char *);
+
+// Exit status when the CPU lacks the requested instruction set
+#define EXIT_UNSUPPORTED 77
+
 static volatile uint64_t g_sink = 0;
 
+// Scalar baselines are compiled without optimization so the compiler
+// cannot turn them back into vectorized loops or libc calls.
 #if defined(__clang__)
 #define OPTNONE __attribute__((optnone))
+#elif defined(__GNUC__)
+#define OPTNONE __attribute__((optimize("O0")))
 #else
 #define OPTNONE
 #endif
@@ -31,6 +58,23 @@ static uint64_t strlen_scalar(const char *s) {
   return (uint64_t)(p - s);
 }
 
+__attribute__((noinline)) OPTNONE
+static int64_t strcmp_scalar(const char *a, const char *b) {
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return (int64_t)(unsigned char)*a - (int64_t)(unsigned char)*b;
+}
+
+__attribute__((noinline)) OPTNONE
+static void *memcpy_scalar(void *dst, const void *src, uint64_t n) {
+  char *d = dst;
+  const char *s = src;
+  while (n--) *d++ = *s++;
+  return dst;
+}
+
 __attribute__((noinline)) OPTNONE
 static slice_t json_find_key_scalar(char *json, const char *key) {
   const uint64_t key_len = strlen_scalar(key);
@@ -67,7 +111,7 @@ static slice_t json_find_key_scalar(char *json, const char *key) {
 }
 
 __attribute__((noinline))
-static int run_strlen_simd(void) {
+static int run_strlen_simd(strlen_fn fn) {
   enum { STR_LEN = 32768, ITERS = 5000 };
   static char s[STR_LEN];
   memset(s, 'a', STR_LEN - 1);
@@ -75,7 +119,7 @@ static int run_strlen_simd(void) {
 
   uint64_t acc = 0;
   for (uint64_t i = 0; i < ITERS; i++) {
-    acc += strlen_simd(s);
+    acc += fn(s);
   }
   g_sink = acc;
 
@@ -101,7 +145,81 @@ static int run_strlen_scalar(void) {
 }
 
 __attribute__((noinline))
-static int run_json_simd(void) {
+static int run_strcmp_simd(strcmp_fn fn) {
+  enum { STR_LEN = 32768, ITERS = 5000 };
+  static char a[STR_LEN];
+  static char b[STR_LEN];
+  memset(a, 'a', STR_LEN - 1);
+  memset(b, 'a', STR_LEN - 1);
+  a[STR_LEN - 1] = '\0';
+  b[STR_LEN - 1] = '\0';
+  b[STR_LEN - 2] = 'b';
+
+  int64_t acc = 0;
+  for (uint64_t i = 0; i < ITERS; i++) {
+    acc += fn(a, b) < 0 ? 1 : 0;
+  }
+  g_sink = (uint64_t)acc;
+
+  return acc == ITERS ? 0 : 4;
+}
+
+__attribute__((noinline)) OPTNONE
+static int run_strcmp_scalar(void) {
+  enum { STR_LEN = 32768, ITERS = 5000 };
+  static char a[STR_LEN];
+  static char b[STR_LEN];
+  memset(a, 'a', STR_LEN - 1);
+  memset(b, 'a', STR_LEN - 1);
+  a[STR_LEN - 1] = '\0';
+  b[STR_LEN - 1] = '\0';
+  b[STR_LEN - 2] = 'b';
+
+  int64_t acc = 0;
+  for (uint64_t i = 0; i < ITERS; i++) {
+    acc += strcmp_scalar(a, b) < 0 ? 1 : 0;
+  }
+  g_sink = (uint64_t)acc;
+
+  return acc == ITERS ? 0 : 4;
+}
+
+__attribute__((noinline))
+static int run_memcpy_simd(memcpy_fn fn) {
+  enum { BUF_LEN = 32768, ITERS = 5000 };
+  static char src[BUF_LEN];
+  static char dst[BUF_LEN];
+  for (uint64_t i = 0; i < BUF_LEN; i++) src[i] = (char)(i & 0x7f);
+
+  uint64_t acc = 0;
+  for (uint64_t i = 0; i < ITERS; i++) {
+    fn(dst, src, BUF_LEN - (i & 15));
+    acc += (unsigned char)dst[i & 0xfff];
+  }
+  g_sink = acc;
+
+  return memcmp(dst, src, BUF_LEN) == 0 ? 0 : 5;
+}
+
+__attribute__((noinline)) OPTNONE
+static int run_memcpy_scalar(void) {
+  enum { BUF_LEN = 32768, ITERS = 5000 };
+  static char src[BUF_LEN];
+  static char dst[BUF_LEN];
+  for (uint64_t i = 0; i < BUF_LEN; i++) src[i] = (char)(i & 0x7f);
+
+  uint64_t acc = 0;
+  for (uint64_t i = 0; i < ITERS; i++) {
+    memcpy_scalar(dst, src, BUF_LEN - (i & 15));
+    acc += (unsigned char)dst[i & 0xfff];
+  }
+  g_sink = acc;
+
+  return memcmp(dst, src, BUF_LEN) == 0 ? 0 : 5;
+}
+
+__attribute__((noinline))
+static int run_json_simd(json_fn fn) {
   enum { PAD_LEN = 4096, ITERS = 25000 };
   static char json[PAD_LEN + 128];
   static char pad[PAD_LEN + 1];
@@ -112,7 +230,7 @@ static int run_json_simd(void) {
 
   uint64_t acc = 0;
   for (uint64_t i = 0; i < ITERS; i++) {
-    slice_t s = json_find_key(json, "needle");
+    slice_t s = fn(json, "needle");
     if (!s.ptr || s.len != 2) return 3;
     acc += s.len;
   }
@@ -144,7 +262,12 @@ static int run_json_scalar(void) {
 
 static void usage(const char *argv0) {
   fprintf(stderr,
-          "usage: %s <strlen-simd|strlen-scalar|json-simd|json-scalar>\n",
+          "usage: %s <kernel>-<simd|scalar"
+#if defined(__x86_64__)
+          "|sse2|avx2"
+#endif
+          ">\n"
+          "  kernels: strlen, strcmp, memcpy, json\n",
           argv0);
 }
 
@@ -154,11 +277,28 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  if (strcmp(argv[1], "strlen-simd") == 0) return run_strlen_simd();
+  if (strcmp(argv[1], "strlen-simd") == 0) return run_strlen_simd(strlen_simd);
   if (strcmp(argv[1], "strlen-scalar") == 0) return run_strlen_scalar();
-  if (strcmp(argv[1], "json-simd") == 0) return run_json_simd();
+  if (strcmp(argv[1], "strcmp-simd") == 0) return run_strcmp_simd(strcmp_simd);
+  if (strcmp(argv[1], "strcmp-scalar") == 0) return run_strcmp_scalar();
+  if (strcmp(argv[1], "memcpy-simd") == 0) return run_memcpy_simd(memcpy_simd);
+  if (strcmp(argv[1], "memcpy-scalar") == 0) return run_memcpy_scalar();
+  if (strcmp(argv[1], "json-simd") == 0) return run_json_simd(json_find_key);
   if (strcmp(argv[1], "json-scalar") == 0) return run_json_scalar();
 
+#if defined(__x86_64__)
+  if (strcmp(argv[1], "strlen-sse2") == 0) return run_strlen_simd(strlen_simd_sse2);
+  if (strcmp(argv[1], "strcmp-sse2") == 0) return run_strcmp_simd(strcmp_simd_sse2);
+  if (strcmp(argv[1], "memcpy-sse2") == 0) return run_memcpy_simd(memcpy_simd_sse2);
+  if (strcmp(argv[1], "json-sse2") == 0) return run_json_simd(json_find_key_sse2);
+
+  const int avx2 = __builtin_cpu_supports("avx2");
+  if (strcmp(argv[1], "strlen-avx2") == 0) return avx2 ? run_strlen_simd(strlen_simd_avx2) : EXIT_UNSUPPORTED;
+  if (strcmp(argv[1], "strcmp-avx2") == 0) return avx2 ? run_strcmp_simd(strcmp_simd_avx2) : EXIT_UNSUPPORTED;
+  if (strcmp(argv[1], "memcpy-avx2") == 0) return avx2 ? run_memcpy_simd(memcpy_simd_avx2) : EXIT_UNSUPPORTED;
+  if (strcmp(argv[1], "json-avx2") == 0) return avx2 ? run_json_simd(json_find_key_avx2) : EXIT_UNSUPPORTED;
+#endif
+
   usage(argv[0]);
   return 1;
 }
@@ -1,6 +1,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 typedef struct {
   char *ptr;
@@ -82,6 +84,24 @@ int main(void) {
   s = json_find_key(j_large, "needle");
   check(slice_eq(s, "ok"), "large json parse");
 
+  // A trailing '\\' must not skip over the terminator: place the input at
+  // the end of a page followed by an inaccessible one.
+  long page = sysconf(_SC_PAGESIZE);
+  char *map = mmap(NULL, (size_t)page * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  check(map != MAP_FAILED, "guard page mmap");
+  if (map != MAP_FAILED) {
+    mprotect(map + page, (size_t)page, PROT_NONE);
+    static const char *tails[] = {"{\"a\":\"x\\", "{\"b\":\"x\\"};
+    for (size_t i = 0; i < sizeof(tails) / sizeof(tails[0]); i++) {
+      size_t n = strlen(tails[i]) + 1;
+      char *p = map + page - n;
+      memcpy(p, tails[i], n);
+      s = json_find_key(p, "a");
+      check(s.ptr == NULL, "trailing backslash at end of input");
+    }
+    munmap(map, (size_t)page * 2);
+  }
+
   if (fail_count == 0) {
     puts("PASS");
     return 0;
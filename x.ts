@@ -10,6 +10,7 @@
 //   clean              Remove all build outputs
 //   test               Run full test suite (51 tests)
 //   bench [opts]       Benchmark suite (--quick, --no-comparators, --no-export)
+//   bench load [opts]  CClaw end-to-end load benchmark against a mock LLM server
 //   run [args...]      Run the binary (pass args through)
 //   debug              Launch lldb with debug binary
 //   size               Show binary size breakdown
@@ -75,7 +76,11 @@ const commands: Record<string, () => Promise<void>> = {
   },
 
   async bench() {
-    await $`bun bench.ts ${rest}`.cwd(ROOT);
+    if (sub === "load") {
+      await $`bun bench_load.ts ${rest.slice(1)}`.cwd(ROOT);
+    } else {
+      await $`bun bench.ts ${rest}`.cwd(ROOT);
+    }
   },
 
   async run() {
@@ -159,6 +164,7 @@ if (!cmd || cmd === "help" || cmd === "--help" || cmd === "-h") {
     bun x clean              Remove build outputs
     bun x test               Run test suite
     bun x bench              Full benchmark suite
+    bun x bench load         CClaw load benchmark (mock LLM)
 
   ${bold("Run")}
     bun x run                Run binary (default: --help)